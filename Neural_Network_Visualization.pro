@@ -6,43 +6,120 @@ greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 CONFIG += c++17
 
+# 原生推理内核：开启优化；AVX2/FMA 只用于标注了 NNV_AVX2 的内核函数，运行时按 CPU 选择（见 simdutils.h），
+# 不要在这里加 -march=native 或 /arch:AVX2，否则整个程序在不支持的 CPU 上会因非法指令崩溃
+gcc|clang {
+    QMAKE_CXXFLAGS_RELEASE += -O3
+}
+msvc {
+    QMAKE_CXXFLAGS_RELEASE += /O2
+}
+
 
 # You can make your code fail to compile if it uses deprecated APIs.
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# --benchmark layerjson 的分配计数：在程序中覆盖 glibc 的 malloc，只在专门测量的构建中打开
+#DEFINES += NNV_COUNT_ALLOCATIONS
+
 SOURCES += \
+    activationcapture.cpp \
+    activations.cpp \
     backend.cpp \
+    benchmarks.cpp \
+    bulkimport.cpp \
     codegenerator.cpp \
     codegeneratorwindow.cpp \
+    codevalidator.cpp \
     colorthememanager.cpp \
     connectionitem.cpp \
+    convautotuner.cpp \
+    convkernels.cpp \
+    dataset.cpp \
+    edgeselection.cpp \
+    gemm.cpp \
+    historyloader.cpp \
+    inferenceengine.cpp \
     json_utils.cpp \
+    jsonstream.cpp \
+    latencypredictor.cpp \
     layeritem.cpp \
     main.cpp \
     mainwindow.cpp \
     matrial.cpp\
+    modelwatcher.cpp \
+    modulerepr.cpp \
     movablelayergroup.cpp \
     networkvisualizer.cpp \
     neuronitem.cpp \
+    onnxmodel.cpp \
     programfragmentprocessor.cpp \
-    propertypanel.cpp
+    projection.cpp \
+    projectiondialog.cpp \
+    propertypanel.cpp \
+    pruning.cpp \
+    pruningdialog.cpp \
+    pytorchparser.cpp \
+    quantization.cpp \
+    quantizationdialog.cpp \
+    recurrentkernels.cpp \
+    threadpool.cpp \
+    traceprofile.cpp \
+    trainingdialog.cpp \
+    trainingengine.cpp \
+    weightcheckpoint.cpp \
+    weightheatmap.cpp \
+    weightstats.cpp
 
 HEADERS += \
+    activationcapture.h \
+    activations.h \
     backend.h \
+    benchmarks.h \
+    bulkimport.h \
     codegenerator.h \
     codegeneratorwindow.h \
+    codevalidator.h \
     colorthememanager.h \
     connectionitem.h \
+    convautotuner.h \
+    convkernels.h \
+    dataset.h \
+    edgeselection.h \
+    gemm.h \
+    historyloader.h \
+    inferenceengine.h \
     json_utils.h \
+    jsonstream.h \
+    latencypredictor.h \
     layeritem.h \
     mainwindow.h \
     matrial.h\
+    modelwatcher.h \
+    modulerepr.h \
     movablelayergroup.h \
     networkvisualizer.h \
     neuronitem.h \
+    onnxmodel.h \
     programfragmentprocessor.h \
-    propertypanel.h
+    projection.h \
+    projectiondialog.h \
+    propertypanel.h \
+    pruning.h \
+    pruningdialog.h \
+    pytorchparser.h \
+    quantization.h \
+    quantizationdialog.h \
+    recurrentkernels.h \
+    simdutils.h \
+    threadpool.h \
+    traceprofile.h \
+    trainingdialog.h \
+    trainingengine.h \
+    weightcheckpoint.h \
+    weightheatmap.h \
+    weightstats.h
 
 FORMS += \
     mainwindow.ui \
@@ -0,0 +1,262 @@
+#include "activationcapture.h"
+#include "dataset.h"
+#include "simdutils.h"
+#include "threadpool.h"
+#include "weightcheckpoint.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace {
+
+// CSV 与 IDX 经 Dataset 读取（CSV 按块并行解析，IDX 从映射中转换），整体追加为样本
+bool loadDataset(const QString& path, bool csv, SampleInputs& samples, QString* error) {
+    Dataset dataset;
+    const int n = samples.shape.size();
+    if (!(csv ? dataset.openCsv(path, n, error) : dataset.open(path, error))) return false;
+    if (dataset.sampleSize() != n) {
+        if (error) *error = QString("%1 的样本为 %2 维，网络输入为 %3 维").arg(QFileInfo(path).fileName()).arg(dataset.sampleSize()).arg(n);
+        return false;
+    }
+    const int count = static_cast<int>(dataset.count());
+    std::vector<qint64> indices(static_cast<std::size_t>(count));
+    std::iota(indices.begin(), indices.end(), qint64(0));
+    const std::size_t offset = samples.data.size();
+    samples.data.resize(offset + static_cast<std::size_t>(count) * n);
+    dataset.gather(indices.data(), count, samples.data.data() + offset);
+    const QString fileName = QFileInfo(path).fileName();
+    for (int i = 0; i < count; ++i) {
+        const int label = dataset.label(i);
+        samples.names.append(label >= 0 ? QString("%1 #%2（标签 %3）").arg(fileName).arg(i).arg(label)
+                                        : QString("%1 #%2").arg(fileName).arg(i));
+    }
+    samples.count += count;
+    return true;
+}
+
+bool loadRawFloats(const QString& path, SampleInputs& samples, QString* error) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = QString("无法打开 %1：%2").arg(path, file.errorString());
+        return false;
+    }
+    const qint64 sampleBytes = qint64(samples.shape.size()) * qint64(sizeof(float));
+    if (file.size() == 0 || file.size() % sampleBytes != 0) {
+        if (error) *error = QString("%1 的大小（%2 字节）不是单个样本 %3 字节的整数倍").arg(path).arg(file.size()).arg(sampleBytes);
+        return false;
+    }
+    const int count = static_cast<int>(file.size() / sampleBytes);
+    const std::size_t offset = samples.data.size();
+    samples.data.resize(offset + static_cast<std::size_t>(file.size() / qint64(sizeof(float))));
+    if (file.read(reinterpret_cast<char*>(samples.data.data() + offset), file.size()) != file.size()) {
+        samples.data.resize(offset);
+        if (error) *error = QString("读取 %1 失败：%2").arg(path, file.errorString());
+        return false;
+    }
+    const QString fileName = QFileInfo(path).fileName();
+    for (int i = 0; i < count; ++i) samples.names.append(QString("%1 #%2").arg(fileName).arg(i));
+    samples.count += count;
+    return true;
+}
+
+bool loadImage(const QString& path, SampleInputs& samples, QString* error) {
+    int channels = samples.shape.channels, height = samples.shape.height, width = samples.shape.width;
+    if (!samples.shape.spatial) {
+        const int n = samples.shape.size();
+        const int gray = qRound(std::sqrt(double(n)));
+        const int rgb = qRound(std::sqrt(n / 3.0));
+        if (gray * gray == n) {
+            channels = 1;
+            height = width = gray;
+        } else if (3 * rgb * rgb == n) {
+            channels = 3;
+            height = width = rgb;
+        } else {
+            if (error) *error = QString("网络输入为 %1 维向量，无法按正方形图像展开").arg(n);
+            return false;
+        }
+    }
+    if (channels != 1 && channels != 3) {
+        if (error) *error = QString("网络输入有 %1 个通道，图像只支持 1（灰度）或 3（RGB）").arg(channels);
+        return false;
+    }
+    const QImage source(path);
+    if (source.isNull()) {
+        if (error) *error = QString("无法读取图像 %1").arg(path);
+        return false;
+    }
+    const QImage image = source.scaled(width, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+                             .convertToFormat(QImage::Format_RGB32);
+    const std::size_t plane = static_cast<std::size_t>(width) * height;
+    const std::size_t offset = samples.data.size();
+    samples.data.resize(offset + plane * channels);
+    float* dst = samples.data.data() + offset;
+    for (int y = 0; y < height; ++y) {
+        const QRgb* line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        for (int x = 0; x < width; ++x) {
+            const std::size_t i = std::size_t(y) * width + x;
+            if (channels == 1) {
+                dst[i] = qGray(line[x]) / 255.0f;
+            } else {
+                dst[i] = qRed(line[x]) / 255.0f;
+                dst[plane + i] = qGreen(line[x]) / 255.0f;
+                dst[2 * plane + i] = qBlue(line[x]) / 255.0f;
+            }
+        }
+    }
+    samples.names.append(QFileInfo(path).fileName());
+    ++samples.count;
+    return true;
+}
+
+#if NNV_HAVE_AVX2
+// 向量部分：前 16 的倍数个元素的 Σ|x| 写入 sum，返回已处理的元素数
+NNV_AVX2 int absSumAvx2(const float* x, int n, float* sum) {
+    int i = 0;
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_add_ps(acc0, _mm256_and_ps(_mm256_loadu_ps(x + i), absMask));
+        acc1 = _mm256_add_ps(acc1, _mm256_and_ps(_mm256_loadu_ps(x + i + 8), absMask));
+    }
+    const __m256 acc = _mm256_add_ps(acc0, acc1);
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_movehdup_ps(s));
+    *sum = _mm_cvtss_f32(s);
+    return i;
+}
+
+NNV_AVX2 int accumulateAbsAvx2(float* acc, const float* x, int n) {
+    int i = 0;
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(acc + i, _mm256_add_ps(_mm256_loadu_ps(acc + i), _mm256_and_ps(_mm256_loadu_ps(x + i), absMask)));
+    }
+    return i;
+}
+#endif
+
+// Σ|x|
+float absSum(const float* x, int n) {
+    int i = 0;
+    float sum = 0.0f;
+#if NNV_HAVE_AVX2
+    if (simd::hasAvx2()) i = absSumAvx2(x, n, &sum);
+#endif
+    for (; i < n; ++i) sum += std::fabs(x[i]);
+    return sum;
+}
+
+// acc[u] += |x[u]|
+void accumulateAbs(float* acc, const float* x, int n) {
+    int i = 0;
+#if NNV_HAVE_AVX2
+    if (simd::hasAvx2()) i = accumulateAbsAvx2(acc, x, n);
+#endif
+    for (; i < n; ++i) acc[i] += std::fabs(x[i]);
+}
+
+} // namespace
+
+bool loadSampleInputs(const QStringList& paths, SampleInputs& samples, QString* error) {
+    if (samples.shape.size() <= 0) {
+        if (error) *error = "未设置网络输入形状";
+        return false;
+    }
+    for (const QString& path : paths) {
+        const QString suffix = QFileInfo(path).suffix().toLower();
+        bool ok;
+        if (suffix == "csv" || suffix == "txt") ok = loadDataset(path, true, samples, error);
+        else if (suffix == "idx" || suffix.endsWith("ubyte")) ok = loadDataset(path, false, samples, error);
+        else if (suffix == "bin" || suffix == "raw" || suffix == "f32") ok = loadRawFloats(path, samples, error);
+        else ok = loadImage(path, samples, error);
+        if (!ok) return false;
+    }
+    if (samples.count == 0) {
+        if (error) *error = "没有读到样本";
+        return false;
+    }
+    return true;
+}
+
+ActivationRecorder::ActivationRecorder(ThreadPool* pool) : m_engine(pool) {}
+
+bool ActivationRecorder::build(const QList<NeuralLayer>& layers, const std::shared_ptr<WeightCheckpoint>& checkpoint,
+                               int capacity, int batch, QString* error) {
+    m_sources.clear();
+    if (!m_engine.build(layers, std::max(1, batch), error)) return false;
+    m_engine.initializeWeights();
+    if (checkpoint && checkpoint->isOpen()) {
+        loadCheckpointWeights(*checkpoint, bindCheckpoint(*checkpoint, layers), m_engine, &m_sources);
+    }
+
+    m_units.clear();
+    m_offsets.clear();
+    m_stride = 0;
+    for (int i = 0; i < m_engine.layerCount(); ++i) {
+        const LayerShape& out = m_engine.layerInfo(i).out;
+        m_units.append(out.spatial ? out.channels : out.width);
+        m_offsets.append(m_stride);
+        m_stride += m_units.last();
+    }
+    capacity = std::max(capacity, m_engine.maxBatch());
+    m_ring.assign(static_cast<std::size_t>(capacity) * m_stride, 0.0f);
+    m_slotIds.assign(static_cast<std::size_t>(capacity), -1);
+    m_batchSlots.assign(static_cast<std::size_t>(m_engine.maxBatch()), nullptr);
+    return true;
+}
+
+void ActivationRecorder::capture(const float* inputs, qint64 first, int count) {
+    if (!isReady() || !inputs || count <= 0) return;
+    const auto start = std::chrono::steady_clock::now();
+    const int inputSize = m_engine.inputShape().size();
+    const int batch = m_engine.maxBatch();
+    for (int done = 0; done < count; done += batch) {
+        const int b = std::min(batch, count - done);
+        m_engine.forward(inputs + qint64(done) * inputSize, b);
+        for (int s = 0; s < b; ++s) {
+            const qint64 id = first + done + s;
+            const std::size_t slot = static_cast<std::size_t>(id % capacity());
+            m_slotIds[slot] = id;
+            m_batchSlots[s] = m_ring.data() + slot * m_stride;
+        }
+        for (int i = 0; i < layerCount(); ++i) reduceLayer(i, m_engine.layerOutput(i), b, m_batchSlots.data());
+    }
+    m_lastSampleMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / count;
+}
+
+const float* ActivationRecorder::activations(qint64 id) const {
+    if (id < 0 || m_slotIds.empty()) return nullptr;
+    const std::size_t slot = static_cast<std::size_t>(id % capacity());
+    return m_slotIds[slot] == id ? m_ring.data() + slot * m_stride : nullptr;
+}
+
+void ActivationRecorder::reduceLayer(int layer, const float* y, int batch, float* const* slots) const {
+    if (!y) return;
+    const LayerShape& out = m_engine.layerInfo(layer).out;
+    const int size = out.size();
+    const int units = m_units[layer];
+    for (int s = 0; s < batch; ++s) {
+        const float* ys = y + qint64(s) * size;
+        float* dst = slots[s] + m_offsets[layer];
+        if (out.spatial) {
+            // 每个通道取特征图的平均 |激活|
+            const int plane = out.height * out.width;
+            for (int c = 0; c < units; ++c) dst[c] = absSum(ys + qint64(c) * plane, plane) / plane;
+        } else {
+            // 序列输出（循环层 [T][U]）按时间步取平均
+            const int rows = size / units;
+            std::fill(dst, dst + units, 0.0f);
+            for (int r = 0; r < rows; ++r) accumulateAbs(dst, ys + qint64(r) * units, units);
+            const float scale = 1.0f / rows;
+            for (int u = 0; u < units; ++u) dst[u] *= scale;
+        }
+    }
+}
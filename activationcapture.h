@@ -0,0 +1,78 @@
+#ifndef ACTIVATIONCAPTURE_H
+#define ACTIVATIONCAPTURE_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QtGlobal>
+#include <memory>
+#include <vector>
+#include "backend.h"
+#include "inferenceengine.h"
+
+class ThreadPool;
+class WeightCheckpoint;
+
+// 一组样本输入：count 个连续排放的 shape.size() 维向量（图像为 CHW，取值 0~1）
+struct SampleInputs
+{
+    LayerShape shape;
+    int count = 0;
+    std::vector<float> data;
+    QStringList names;  // 每个样本的来源，如“digits.csv 第 12 行”“cat.png”
+
+    const float* sample(int index) const { return data.data() + qint64(index) * shape.size(); }
+};
+
+// 按扩展名读取样本并追加到 samples（samples.shape 须先设为网络输入形状）：
+// .csv/.txt 每行一个样本，逗号/分号/空白分隔，首行无法解析时视为表头，比输入维数多一列时视首列为标签；
+// IDX（*-idx3-ubyte、.idx）按 Dataset 打开，像素归一化到 0~1，同目录下有标签文件时写进样本名；
+// .bin/.raw/.f32 为小端 float32 连续排放；其余按图像读取，缩放到输入宽高并按通道数转为灰度或 RGB，
+// 输入为向量时按 √n×√n 灰度（或 √(n/3)×√(n/3) RGB）展开
+bool loadSampleInputs(const QStringList& paths, SampleInputs& samples, QString* error = nullptr);
+
+// 在原生推理引擎上前向样本，把每层每个单元（全连接/循环层的神经元、卷积/池化层的通道）的平均 |激活|
+// 写入环形缓冲区：样本 id 固定落在第 id % capacity 个槽，槽位与引擎的激活缓冲区都在 build 时一次分配，
+// capture 不再分配内存，来回拖动时已算过的样本直接取用
+class ActivationRecorder
+{
+public:
+    explicit ActivationRecorder(ThreadPool* pool = nullptr);
+
+    // 权重取检查点中匹配到的张量，其余层按 PyTorch 默认方式随机初始化（固定种子）；batch 为每次前向的样本数
+    bool build(const QList<NeuralLayer>& layers, const std::shared_ptr<WeightCheckpoint>& checkpoint = nullptr,
+               int capacity = 512, int batch = 32, QString* error = nullptr);
+
+    bool isReady() const { return m_engine.isReady(); }
+    LayerShape inputShape() const { return m_engine.inputShape(); }
+    int layerCount() const { return m_engine.layerCount(); }
+    const InferenceEngine::LayerInfo& layerInfo(int layer) const { return m_engine.layerInfo(layer); }
+    int unitCount(int layer) const { return m_units[layer]; }
+    int layerOffset(int layer) const { return m_offsets[layer]; }
+    int capacity() const { return static_cast<int>(m_slotIds.size()); }
+    int batch() const { return m_engine.maxBatch(); }
+    QStringList sources() const { return m_sources; }  // 每层权重来源，随机初始化的层为空
+
+    // 前向 count 个连续样本（内部按 batch 分批），编号为 first 起，覆盖各自槽位中的旧样本
+    void capture(const float* inputs, qint64 first, int count);
+    // 样本 id 各层的激活（第 layer 层从 layerOffset(layer) 开始，共 unitCount(layer) 个），不在缓冲区中时返回 nullptr
+    const float* activations(qint64 id) const;
+    // 最近一次 capture 平均每个样本的耗时
+    double lastSampleMs() const { return m_lastSampleMs; }
+
+private:
+    void reduceLayer(int layer, const float* y, int batch, float* const* slots) const;
+
+    InferenceEngine m_engine;
+    QVector<int> m_units;
+    QVector<int> m_offsets;
+    int m_stride = 0;
+    std::vector<float> m_ring;     // capacity × m_stride
+    std::vector<qint64> m_slotIds;  // 每个槽当前存放的样本编号，-1 为空
+    std::vector<float*> m_batchSlots;
+    QStringList m_sources;
+    double m_lastSampleMs = 0.0;
+};
+
+#endif // ACTIVATIONCAPTURE_H
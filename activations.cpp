@@ -0,0 +1,116 @@
+#include "activations.h"
+#include "simdutils.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <cmath>
+
+Activation activationFromName(const QString& name) {
+    const QString n = name.trimmed().toLower();
+    if (n == "relu") return Activation::ReLU;
+    if (n == "leaky_relu" || n == "leakyrelu") return Activation::LeakyReLU;
+    if (n == "sigmoid") return Activation::Sigmoid;
+    if (n == "tanh") return Activation::Tanh;
+    if (n == "softmax") return Activation::Softmax;
+    return Activation::None;
+}
+
+QString activationName(Activation act) {
+    switch (act) {
+    case Activation::ReLU: return "relu";
+    case Activation::LeakyReLU: return "leaky_relu";
+    case Activation::Sigmoid: return "sigmoid";
+    case Activation::Tanh: return "tanh";
+    case Activation::Softmax: return "softmax";
+    case Activation::None: break;
+    }
+    return QString();
+}
+
+namespace {
+
+#if NNV_HAVE_AVX2
+// 8 个一组的向量部分，偏置与激活同 applyRange；返回处理到的位置
+NNV_AVX2 int applyRangeAvx2(float* x, int n, const float* bias, float scalarBias, Activation act) {
+    int i = 0;
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 slope = _mm256_set1_ps(0.01f);
+    const __m256 sb = _mm256_set1_ps(scalarBias);
+    if (act != Activation::Softmax) {
+        for (; i + 8 <= n; i += 8) {
+            __m256 v = _mm256_add_ps(_mm256_loadu_ps(x + i), bias ? _mm256_loadu_ps(bias + i) : sb);
+            if (act == Activation::ReLU) v = _mm256_max_ps(v, zero);
+            else if (act == Activation::LeakyReLU) v = _mm256_max_ps(v, _mm256_mul_ps(v, slope));
+            else if (act == Activation::Sigmoid) v = simd::sigmoid256(v);
+            else if (act == Activation::Tanh) v = simd::tanh256(v);
+            _mm256_storeu_ps(x + i, v);
+        }
+    }
+    return i;
+}
+#endif
+
+// 一段连续数据：可选的标量偏置 + 逐元素激活
+void applyRange(float* x, int n, const float* bias, float scalarBias, Activation act) {
+    int i = 0;
+#if NNV_HAVE_AVX2
+    if (simd::hasAvx2()) i = applyRangeAvx2(x, n, bias, scalarBias, act);
+#endif
+    for (; i < n; ++i) {
+        float v = x[i] + (bias ? bias[i] : scalarBias);
+        switch (act) {
+        case Activation::ReLU: v = std::max(v, 0.0f); break;
+        case Activation::LeakyReLU: v = v > 0.0f ? v : 0.01f * v; break;
+        case Activation::Sigmoid: v = 1.0f / (1.0f + std::exp(-v)); break;
+        case Activation::Tanh: v = std::tanh(v); break;
+        default: break;
+        }
+        x[i] = v;
+    }
+}
+
+void softmaxRow(float* x, int n) {
+    float m = x[0];
+    for (int i = 1; i < n; ++i) m = std::max(m, x[i]);
+    float sum = 0.0f;
+    for (int i = 0; i < n; ++i) {
+        x[i] = std::exp(x[i] - m);
+        sum += x[i];
+    }
+    const float inv = 1.0f / sum;
+    for (int i = 0; i < n; ++i) x[i] *= inv;
+}
+
+int rowGrain(int cols) {
+    // 每块大约处理 16K 个元素
+    return std::max(1, 16384 / std::max(1, cols));
+}
+
+} // namespace
+
+void biasActivation(float* data, int rows, int cols, const float* bias, Activation act, ThreadPool* pool) {
+    if (!bias && act == Activation::None) return;
+    if (!pool) pool = &ThreadPool::global();
+    pool->parallelFor(0, rows, rowGrain(cols), [&](int first, int last) {
+        for (int r = first; r < last; ++r) {
+            float* row = data + static_cast<std::size_t>(r) * cols;
+            if (act == Activation::Softmax) {
+                if (bias) applyRange(row, cols, bias, 0.0f, Activation::None);
+                softmaxRow(row, cols);
+            } else {
+                applyRange(row, cols, bias, 0.0f, act);
+            }
+        }
+    });
+}
+
+void channelBiasActivation(float* data, int channels, int spatial, const float* bias, Activation act, ThreadPool* pool) {
+    if (!bias && act == Activation::None) return;
+    if (!pool) pool = &ThreadPool::global();
+    const Activation elementwise = act == Activation::Softmax ? Activation::None : act;
+    pool->parallelFor(0, channels, rowGrain(spatial), [&](int first, int last) {
+        for (int c = first; c < last; ++c) {
+            applyRange(data + static_cast<std::size_t>(c) * spatial, spatial, nullptr, bias ? bias[c] : 0.0f, elementwise);
+        }
+    });
+    if (act == Activation::Softmax) softmaxRow(data, channels * spatial);
+}
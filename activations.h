@@ -0,0 +1,29 @@
+#ifndef ACTIVATIONS_H
+#define ACTIVATIONS_H
+
+#include <QString>
+
+class ThreadPool;
+
+// 代码生成器支持的激活函数
+enum class Activation
+{
+    None,
+    ReLU,
+    LeakyReLU,
+    Sigmoid,
+    Tanh,
+    Softmax
+};
+
+// "relu" / "ReLU" / "leaky_relu" ... -> Activation，无法识别时返回 None
+Activation activationFromName(const QString& name);
+QString activationName(Activation act);
+
+// 对 rows×cols 的行主序数据原地加偏置（bias 可为空，按列广播）并执行激活；softmax 按行归一化
+void biasActivation(float* data, int rows, int cols, const float* bias, Activation act, ThreadPool* pool = nullptr);
+
+// 按通道加偏置（卷积输出 channels×spatial）并执行逐元素激活
+void channelBiasActivation(float* data, int channels, int spatial, const float* bias, Activation act, ThreadPool* pool = nullptr);
+
+#endif // ACTIVATIONS_H
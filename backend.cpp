@@ -39,3 +39,96 @@ NeuralLayer NeuralLayer::fromJsonObject(const QJsonObject& obj) {//将QJsonObjec
     return layer;
 }
 
+
+bool NeuralLayer::isDense() const {
+    return layerType == "Dense" || layerType == "Input" ||
+           layerType == "Output" || layerType == "Hidden";
+}
+
+bool NeuralLayer::isConvolutional() const {
+    return layerType == "Convolutional" || layerType == "Conv2d";
+}
+
+bool NeuralLayer::isPooling() const {
+    return layerType == "MaxPooling" || layerType == "AvgPooling" ||
+           layerType == "AveragePooling";
+}
+
+bool NeuralLayer::isRecurrent() const {
+    return layerType == "LSTM" || layerType == "GRU" || layerType == "RNN";
+}
+
+LayerShape defaultInputShape(const QList<const NeuralLayer*>& layers) {
+    LayerShape shape;
+    if (layers.isEmpty()) return shape;
+    const NeuralLayer* first = layers.first();
+    if (first->isConvolutional() || first->isPooling()) {
+        shape.channels = 3;
+        shape.height = 32;
+        shape.width = 32;
+        shape.spatial = true;
+    } else {
+        shape.width = first->inputSize > 0 ? first->inputSize : 1;
+    }
+    return shape;
+}
+
+bool inferLayerShapes(const QList<const NeuralLayer*>& layers, const LayerShape& input,
+                      QVector<LayerShape>& shapes, QString* error) {
+    shapes.clear();
+    LayerShape cur = input;
+    for (int i = 0; i < layers.size(); ++i) {
+        const NeuralLayer* layer = layers[i];
+        LayerShape out = cur;
+        QString message;
+
+        if (layer->isDense()) {
+            // 卷积/池化后的全连接层先展平，否则作用在最后一维上
+            int rows = cur.spatial ? 1 : cur.channels * cur.height;
+            out = LayerShape();
+            out.height = rows;
+            out.width = layer->neurons;
+            if (layer->neurons <= 0) message = "神经元数必须为正";
+        } else if (layer->isConvolutional()) {
+            if (!cur.spatial) message = "卷积层需要图像输入";
+            else if (layer->filters <= 0 || layer->kernelSize <= 0) message = "filters/kernelSize 必须为正";
+            else {
+                // padding = kernel_size / 2，步长 1（与生成的 PyTorch 代码一致）
+                int pad = layer->kernelSize / 2;
+                out.channels = layer->filters;
+                out.height = cur.height + 2 * pad - layer->kernelSize + 1;
+                out.width = cur.width + 2 * pad - layer->kernelSize + 1;
+            }
+        } else if (layer->isPooling()) {
+            if (!cur.spatial) message = "池化层需要图像输入";
+            else if (layer->poolingSize <= 0 || cur.height < layer->poolingSize || cur.width < layer->poolingSize)
+                message = "池化窗口大于特征图";
+            else {
+                // 步长 2
+                out.height = (cur.height - layer->poolingSize) / 2 + 1;
+                out.width = (cur.width - layer->poolingSize) / 2 + 1;
+            }
+        } else if (layer->isRecurrent()) {
+            if (cur.spatial) message = "循环层需要序列输入";
+            else if (layer->units <= 0) message = "units 必须为正";
+            else {
+                out = LayerShape();
+                out.height = cur.channels * cur.height;
+                out.width = layer->units;
+            }
+        } else if (layer->layerType == "Flatten") {
+            out = LayerShape();
+            out.width = cur.size();
+        }
+        // Dropout 等其余层不改变形状
+
+        if (message.isEmpty() && out.size() <= 0) message = "输出形状为空";
+        if (!message.isEmpty()) {
+            if (error) *error = QString("第 %1 层 (%2)：%3").arg(i + 1).arg(layer->layerType, message);
+            return false;
+        }
+        shapes.append(out);
+        cur = out;
+    }
+    return true;
+}
@@ -5,6 +5,7 @@
 #include <QJsonArray>
 #include <QString>
 #include <QGraphicsItem>
+#include <QVector>
 
 class NeuralLayer
 {
@@ -34,8 +35,33 @@ public:
 
     // Dropout 层特有参数
     float dropoutRate = 0.5f;
+
+    // 层类型判断（兼容界面与代码解析中出现的不同命名）
+    bool isDense() const;      // Input / Hidden / Output / Dense
+    bool isConvolutional() const;
+    bool isPooling() const;
+    bool isRecurrent() const;  // LSTM / GRU / RNN
 };
 
+// 单个样本的张量形状 channels × height × width
+// 全连接/循环层的输出记为 1 × T × features（T 为序列长度，默认 1）
+struct LayerShape
+{
+    int channels = 1;
+    int height = 1;
+    int width = 1;
+    bool spatial = false;  // 是否为卷积/池化产生的特征图，全连接层遇到时需要先展平
+
+    int size() const { return channels * height * width; }
+};
+
+// 网络默认输入形状：首层为卷积/池化时取 3×32×32 图像，否则取首层 inputSize 维向量
+LayerShape defaultInputShape(const QList<const NeuralLayer*>& layers);
+
+// 按层顺序推断每一层的输出形状，形状不合法时返回 false 并写入 error
+bool inferLayerShapes(const QList<const NeuralLayer*>& layers, const LayerShape& input,
+                      QVector<LayerShape>& shapes, QString* error = nullptr);
+
 
 
 #endif // BACKEND_H
@@ -0,0 +1,3262 @@
+#include "benchmarks.h"
+#include "activationcapture.h"
+#include "backend.h"
+#include "bulkimport.h"
+#include "codevalidator.h"
+#include "convautotuner.h"
+#include "dataset.h"
+#include "edgeselection.h"
+#include "gemm.h"
+#include "historyloader.h"
+#include "inferenceengine.h"
+#include "jsonstream.h"
+#include "json_utils.h"
+#include "latencypredictor.h"
+#include "modelwatcher.h"
+#include "modulerepr.h"
+#include "onnxmodel.h"
+#include "programfragmentprocessor.h"
+#include "projection.h"
+#include "pruning.h"
+#include "pytorchparser.h"
+#include "quantization.h"
+#include "recurrentkernels.h"
+#include "simdutils.h"
+#include "threadpool.h"
+#include "traceprofile.h"
+#include "trainingengine.h"
+#include "weightcheckpoint.h"
+#include "weightheatmap.h"
+#include "weightstats.h"
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+
+// 分配计数（layerjson 基准）：glibc 下在可执行文件中定义 malloc / calloc / realloc，覆盖 libc 的版本（Qt 容器与
+// operator new 最终都经过这里），计数后转给 glibc 的实现。这会让整个程序的每次分配都多两次原子操作，
+// 所以只在 qmake 时加 DEFINES+=NNV_COUNT_ALLOCATIONS 的测量构建中打开；其他平台及 AddressSanitizer 构建中不计数
+#if defined(NNV_COUNT_ALLOCATIONS) && defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+#define NNV_ALLOCATION_HOOKS 1
+namespace {
+std::atomic<qint64> g_allocations{0};
+std::atomic<qint64> g_allocatedBytes{0};
+} // namespace
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+
+void* malloc(size_t size) noexcept
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_allocatedBytes.fetch_add(qint64(size), std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_allocatedBytes.fetch_add(qint64(count * size), std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size) noexcept
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_allocatedBytes.fetch_add(qint64(size), std::memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+}
+}
+#endif
+
+namespace {
+
+struct Benchmark {
+    const char* name;
+    const char* description;
+    void (*run)(QTextStream& out);
+};
+
+// 重复执行 fn 直到累计至少 minMs 毫秒，返回单次平均耗时（毫秒）
+template <typename Fn>
+double timeMs(Fn&& fn, double minMs = 200.0) {
+    fn();  // 预热
+    QElapsedTimer timer;
+    timer.start();
+    int runs = 0;
+    do {
+        fn();
+        ++runs;
+    } while (timer.nsecsElapsed() < minMs * 1.0e6);
+    return timer.nsecsElapsed() / 1.0e6 / runs;
+}
+
+std::vector<float> randomVector(std::size_t n, unsigned int seed = 7, float scale = 1.0f) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(-scale, scale);
+    std::vector<float> v(n);
+    for (float& x : v) x = dist(rng);
+    return v;
+}
+
+void benchGemm(QTextStream& out) {
+    out << "size            naive GFLOPS   blocked GFLOPS   speedup\n";
+    const int sizes[][3] = {{1, 1024, 1024}, {64, 512, 784}, {256, 256, 256}, {512, 512, 512}, {1024, 1024, 1024}};
+    for (const auto& s : sizes) {
+        const int M = s[0], N = s[1], K = s[2];
+        std::vector<float> A = randomVector(std::size_t(M) * K, 1);
+        std::vector<float> B = randomVector(std::size_t(K) * N, 2);
+        std::vector<float> C(std::size_t(M) * N);
+        const double flops = 2.0 * M * N * K;
+        const double naive = timeMs([&] { sgemmReference(M, N, K, A.data(), K, B.data(), N, false, C.data(), N); });
+        const double blocked = timeMs([&] { sgemm(M, N, K, A.data(), K, B.data(), N, false, C.data(), N); });
+        out << QString("%1x%2x%3").arg(M).arg(N).arg(K).leftJustified(16)
+            << QString::number(flops / naive / 1.0e6, 'f', 2).rightJustified(12)
+            << QString::number(flops / blocked / 1.0e6, 'f', 2).rightJustified(17)
+            << QString::number(naive / blocked, 'f', 1).rightJustified(9) << "x\n";
+    }
+}
+
+NeuralLayer makeLayer(const QString& type, int neurons, const QString& activation = QString()) {
+    NeuralLayer layer;
+    layer.layerType = type;
+    layer.neurons = neurons;
+    layer.activationFunction = activation;
+    return layer;
+}
+
+void benchEngine(QTextStream& out) {
+    // 多层感知机 784-512-256-10
+    QList<NeuralLayer> mlp;
+    NeuralLayer input = makeLayer("Input", 512, "relu");
+    input.inputSize = 784;
+    mlp << input << makeLayer("Hidden", 256, "relu") << makeLayer("Dropout", 0) << makeLayer("Output", 10, "softmax");
+
+    // 小型卷积网络 3x32x32 -> conv32 -> pool -> conv64 -> pool -> dense10
+    QList<NeuralLayer> cnn;
+    NeuralLayer conv1 = makeLayer("Convolutional", 1, "relu");
+    conv1.filters = 32;
+    conv1.kernelSize = 3;
+    NeuralLayer pool = makeLayer("MaxPooling", 1);
+    pool.poolingSize = 2;
+    NeuralLayer conv2 = conv1;
+    conv2.filters = 64;
+    cnn << conv1 << pool << conv2 << pool << makeLayer("Dense", 10, "softmax");
+
+    const struct { const char* name; const QList<NeuralLayer>* layers; } nets[] = {{"MLP 784-512-256-10", &mlp},
+                                                                                 {"CNN 3x32x32", &cnn}};
+    out << "threads: " << ThreadPool::global().threadCount() << "\n";
+    for (const auto& net : nets) {
+        for (int batch : {1, 32, 128}) {
+            InferenceEngine engine;
+            QString error;
+            if (!engine.build(*net.layers, batch, &error)) {
+                out << net.name << ": " << error << "\n";
+                continue;
+            }
+            std::vector<float> x = randomVector(std::size_t(engine.inputShape().size()) * batch);
+            const double ms = timeMs([&] { engine.forward(x.data(), batch); });
+            double flops = 0.0;
+            for (int i = 0; i < engine.layerCount(); ++i) flops += engine.layerInfo(i).flops;
+            out << QString("%1 batch %2").arg(net.name).arg(batch).leftJustified(30)
+                << QString::number(ms, 'f', 3).rightJustified(10) << " ms  "
+                << QString::number(batch / ms * 1000.0, 'f', 0).rightJustified(9) << " samples/s  "
+                << QString::number(flops * batch / ms / 1.0e6, 'f', 2).rightJustified(8) << " GFLOPS\n";
+        }
+    }
+}
+
+void benchLatency(QTextStream& out) {
+    // 界面线程在校准期间只调用 tryProfile：测量在另一线程进行时它不能被锁挡住
+    LatencyPredictor& predictor = LatencyPredictor::instance();
+    MachineProfile p;
+    std::atomic<bool> done{false};
+    std::thread calibration([&] {
+        p = predictor.recalibrate();
+        done = true;
+    });
+    double maxPollUs = 0.0;
+    int polls = 0;
+    while (!done) {
+        MachineProfile ignored;
+        QElapsedTimer timer;
+        timer.start();
+        predictor.tryProfile(&ignored);
+        maxPollUs = std::max(maxPollUs, timer.nsecsElapsed() / 1000.0);
+        ++polls;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    calibration.join();
+    out << "tryProfile during calibration: " << polls << " calls, max " << QString::number(maxPollUs, 'f', 1)
+        << " us " << (maxPollUs < 1000.0 ? "ok" : "BLOCKED") << "\n";
+    out << "cpu: " << p.cpuModel << ", threads: " << p.threads << "\n"
+        << "gemm " << QString::number(p.gemmGflops, 'f', 1) << " GFLOPS (weight stream "
+        << QString::number(p.weightStreamGBs, 'f', 1) << " GB/s), conv " << QString::number(p.convGflops, 'f', 1)
+        << " GFLOPS, recurrent " << QString::number(p.recurrentGflops, 'f', 1) << " GFLOPS\n"
+        << "bandwidth " << QString::number(p.bandwidthGBs, 'f', 1) << " GB/s (cache "
+        << QString::number(p.cacheBandwidthGBs, 'f', 1) << " GB/s), overhead "
+        << QString::number(p.overheadUs, 'f', 2) << " us\n\n";
+
+    // 与原生推理引擎的实测耗时对比
+    QList<NeuralLayer> mlp;
+    NeuralLayer input = makeLayer("Input", 512, "relu");
+    input.inputSize = 784;
+    mlp << input << makeLayer("Hidden", 256, "relu") << makeLayer("Output", 10, "softmax");
+
+    QList<NeuralLayer> cnn;
+    NeuralLayer conv1 = makeLayer("Convolutional", 1, "relu");
+    conv1.filters = 32;
+    conv1.kernelSize = 3;
+    NeuralLayer pool = makeLayer("MaxPooling", 1);
+    pool.poolingSize = 2;
+    NeuralLayer conv2 = conv1;
+    conv2.filters = 64;
+    cnn << conv1 << pool << conv2 << pool << makeLayer("Dense", 10, "softmax");
+
+    QList<NeuralLayer> rnn;
+    NeuralLayer embed = makeLayer("Input", 128, "relu");
+    embed.inputSize = 64;
+    NeuralLayer lstm = makeLayer("LSTM", 1, "tanh");
+    lstm.units = 256;
+    rnn << embed << lstm << makeLayer("Output", 10, "softmax");
+
+    const struct { const char* name; const QList<NeuralLayer>* layers; } nets[] = {
+        {"MLP 784-512-256-10", &mlp}, {"CNN 3x32x32", &cnn}, {"LSTM 256", &rnn}};
+    out << "network                  batch   predicted ms   measured ms   ratio\n";
+    for (const auto& net : nets) {
+        for (int batch : {1, 32}) {
+            InferenceEngine engine;
+            QString error;
+            if (!engine.build(*net.layers, batch, &error)) {
+                out << net.name << ": " << error << "\n";
+                continue;
+            }
+            std::vector<float> x = randomVector(std::size_t(engine.inputShape().size()) * batch);
+            const double measured = timeMs([&] { engine.forward(x.data(), batch); });
+            const LatencyReport report = LatencyPredictor::instance().predict(*net.layers, batch);
+            out << QString(net.name).leftJustified(25) << QString::number(batch).rightJustified(5)
+                << QString::number(report.totalMs, 'f', 3).rightJustified(15)
+                << QString::number(measured, 'f', 3).rightJustified(14)
+                << QString::number(report.totalMs / measured, 'f', 2).rightJustified(8) << "\n";
+        }
+    }
+}
+
+void benchRecurrent(QTextStream& out) {
+    const struct { RecurrentCell cell; const char* name; } cells[] = {
+        {RecurrentCell::RNN, "RNN"}, {RecurrentCell::LSTM, "LSTM"}, {RecurrentCell::GRU, "GRU"}};
+
+    // 先与逐门朴素实现比对（仓库没有单元测试，误差直接打印出来）
+    out << "cell   batch x steps x features -> units   max |err|\n";
+    const int checks[][4] = {{1, 1, 1, 1}, {3, 7, 5, 9}, {4, 16, 33, 17}, {8, 24, 64, 48}};
+    for (const auto& cell : cells) {
+        for (const auto& c : checks) {
+            RecurrentShape shape{cell.cell, c[0], c[1], c[2], c[3]};
+            const std::size_t gw = shape.gateWidth();
+            std::vector<float> x = randomVector(std::size_t(shape.batch) * shape.steps * shape.features, 1);
+            // 与 PyTorch 相同按 1/sqrt(units) 缩放权重，否则隐状态饱和、舍入误差随时间步放大
+            std::vector<float> wIH = randomVector(gw * shape.features, 2, 1.0f / std::sqrt(float(shape.units)));
+            std::vector<float> wHH = randomVector(gw * shape.units, 3, 1.0f / std::sqrt(float(shape.units)));
+            std::vector<float> bIH = randomVector(gw, 4, 1.0f / std::sqrt(float(shape.units)));
+            std::vector<float> bHH = randomVector(gw, 5, 1.0f / std::sqrt(float(shape.units)));
+            std::vector<float> ref(std::size_t(shape.batch) * shape.steps * shape.units);
+            std::vector<float> y(ref.size());
+            simd::AlignedBuffer workspace;
+            workspace.resize(static_cast<std::size_t>(RecurrentKernel::workspaceSize(shape)));
+            RecurrentKernel kernel;
+            kernel.pack(shape, wIH.data(), wHH.data(), bIH.data(), bHH.data());
+            kernel.forward(x.data(), y.data(), shape.batch, workspace.data());
+            recurrentForwardReference(shape, x.data(), wIH.data(), wHH.data(), bIH.data(), bHH.data(), ref.data());
+            float err = 0.0f;
+            for (std::size_t i = 0; i < y.size(); ++i) err = std::max(err, std::fabs(y[i] - ref[i]));
+            out << QString(cell.name).leftJustified(7)
+                << QString("%1 x %2 x %3 -> %4").arg(c[0]).arg(c[1]).arg(c[2]).arg(c[3]).leftJustified(30)
+                << QString::number(err, 'e', 2) << (err < 1.0e-4f ? "" : "  FAIL") << "\n";
+        }
+    }
+
+    out << "\ncell   batch  steps  units   naive ms   fused ms    speedup   GFLOPS\n";
+    const int batch = 32;
+    for (const auto& cell : cells) {
+        for (int steps : {16, 64, 256}) {
+            for (int units : {64, 256}) {
+                RecurrentShape shape{cell.cell, batch, steps, units, units};
+                const std::size_t gw = shape.gateWidth();
+                std::vector<float> x = randomVector(std::size_t(batch) * steps * units, 1);
+                const float scale = 1.0f / std::sqrt(float(units));
+                std::vector<float> wIH = randomVector(gw * units, 2, scale);
+                std::vector<float> wHH = randomVector(gw * units, 3, scale);
+                std::vector<float> bias = randomVector(gw, 4, scale);
+                std::vector<float> y(std::size_t(batch) * steps * units);
+                simd::AlignedBuffer workspace;
+                workspace.resize(static_cast<std::size_t>(RecurrentKernel::workspaceSize(shape)));
+                RecurrentKernel kernel;
+                kernel.pack(shape, wIH.data(), wHH.data(), bias.data(), bias.data());
+                const double flops = 2.0 * batch * steps * gw * (2.0 * units);
+                const double fused = timeMs([&] { kernel.forward(x.data(), y.data(), batch, workspace.data()); });
+                // 朴素实现在长序列上要跑数秒，只对较短的序列计时
+                const double naive = steps > 64 ? 0.0 : timeMs([&] {
+                    recurrentForwardReference(shape, x.data(), wIH.data(), wHH.data(), bias.data(), bias.data(), y.data());
+                }, 0.0);
+                out << QString(cell.name).leftJustified(7) << QString::number(batch).rightJustified(5)
+                    << QString::number(steps).rightJustified(7) << QString::number(units).rightJustified(7)
+                    << (naive > 0.0 ? QString::number(naive, 'f', 3) : QString("-")).rightJustified(11)
+                    << QString::number(fused, 'f', 3).rightJustified(11)
+                    << (naive > 0.0 ? QString::number(naive / fused, 'f', 1) + "x" : QString("-")).rightJustified(10)
+                    << QString::number(flops / fused / 1.0e6, 'f', 2).rightJustified(9) << "\n";
+            }
+        }
+    }
+}
+
+void benchConv(QTextStream& out) {
+    // 常见的 VGG/ResNet 风格形状，输出单样本耗时与等效 GFLOPS（按直接卷积的乘加数计）
+    const int shapes[][6] = {{3, 32, 32, 32, 3, 1},   {32, 32, 32, 64, 3, 1},  {64, 16, 16, 128, 3, 1},
+                             {128, 8, 8, 256, 3, 1},  {64, 56, 56, 64, 3, 1},  {3, 224, 224, 64, 3, 1},
+                             {16, 32, 32, 32, 5, 2},  {64, 28, 28, 64, 1, 0},  {256, 14, 14, 256, 1, 0}};
+    const ConvAlgorithm algorithms[] = {ConvAlgorithm::Im2colGemm, ConvAlgorithm::Direct, ConvAlgorithm::Winograd};
+    out << "threads: " << ThreadPool::global().threadCount() << "\n";
+    out << "shape                        im2col ms  direct ms  winograd ms   best GFLOPS  autotune   max |err|\n";
+    for (const auto& sh : shapes) {
+        const ConvShape shape{sh[0], sh[1], sh[2], sh[3], sh[4], sh[5]};
+        std::vector<float> x = randomVector(std::size_t(shape.channels) * shape.height * shape.width, 1);
+        std::vector<float> w = randomVector(std::size_t(shape.filters) * shape.patchSize(), 2,
+                                            1.0f / std::sqrt(float(shape.patchSize())));
+        std::vector<float> ref(std::size_t(shape.filters) * shape.outHeight() * shape.outWidth());
+        std::vector<float> y(ref.size());
+        conv2dReference(shape, x.data(), w.data(), ref.data());
+        const double flops = 2.0 * shape.filters * shape.patchSize() * shape.outHeight() * shape.outWidth();
+
+        QString row = QString("%1x%2x%3 -> %4 k%5").arg(shape.channels).arg(shape.height).arg(shape.width)
+                          .arg(shape.filters).arg(shape.kernel).leftJustified(27);
+        double best = 0.0;
+        float err = 0.0f;
+        for (ConvAlgorithm algorithm : algorithms) {
+            const int width = algorithm == ConvAlgorithm::Winograd ? 13 : 11;
+            if (!convAlgorithmSupported(shape, algorithm)) {
+                row += QString("-").rightJustified(width);
+                continue;
+            }
+            simd::AlignedBuffer scratch;
+            simd::AlignedBuffer transformed;
+            scratch.resize(static_cast<std::size_t>(convScratchSize(shape, algorithm)));
+            transformed.resize(static_cast<std::size_t>(convTransformedWeightSize(shape, algorithm)));
+            convTransformWeights(shape, algorithm, w.data(), transformed.data());
+            const double ms = timeMs([&] {
+                conv2d(shape, algorithm, x.data(), w.data(), transformed.data(), y.data(), scratch.data());
+            });
+            for (std::size_t i = 0; i < y.size(); ++i) err = std::max(err, std::fabs(y[i] - ref[i]));
+            best = best == 0.0 ? ms : std::min(best, ms);
+            row += QString::number(ms, 'f', 3).rightJustified(width);
+        }
+        const ConvAutotuner::Result tuned = ConvAutotuner::instance().result(shape);
+        out << row << QString::number(flops / best / 1.0e6, 'f', 2).rightJustified(14) << "  "
+            << QString(convAlgorithmName(tuned.algorithm)).leftJustified(9)
+            << QString::number(err, 'e', 2).rightJustified(11) << (err < 1.0e-3f ? "" : "  FAIL") << "\n";
+    }
+    out << "autotune cache: " << ConvAutotuner::instance().cachePath() << "\n";
+
+    // select 不阻塞：没计时过的形状先返回 im2col 并交给后台线程，计时完成后返回实测结果
+    {
+        const QString path = QDir::temp().filePath("nnv_bench_conv_autotune.json");
+        ConvAutotuner tuner(path);
+        tuner.clear();
+        const ConvShape shape{64, 56, 56, 64, 3, 1};
+        QElapsedTimer timer;
+        timer.start();
+        const ConvAlgorithm first = tuner.select(shape);
+        const double selectMs = timer.nsecsElapsed() / 1.0e6;
+        timer.restart();
+        const ConvAutotuner::Result tuned = tuner.result(shape);  // 等后台计时完成，不重复计时
+        const double waitMs = timer.nsecsElapsed() / 1.0e6;
+        const bool ok = first == ConvAlgorithm::Im2colGemm && !tuned.fromCache && tuner.select(shape) == tuned.algorithm
+                        && QFile::exists(path);
+        out << "non-blocking select: first call " << QString::number(selectMs, 'f', 3) << " ms -> "
+            << convAlgorithmName(first) << ", background tuning " << QString::number(waitMs, 'f', 1) << " ms -> "
+            << convAlgorithmName(tuned.algorithm) << (ok ? "  ok" : "  FAIL") << "\n";
+        QFile::remove(path);
+    }
+
+    out << "\npooling (2x2, stride 2)       max ms     avg ms   GB/s (max)\n";
+    const int pools[][3] = {{64, 112, 112}, {128, 56, 56}, {256, 28, 28}};
+    for (const auto& p : pools) {
+        const int channels = p[0], height = p[1], width = p[2];
+        std::vector<float> x = randomVector(std::size_t(channels) * height * width, 3);
+        std::vector<float> y(std::size_t(channels) * (height / 2) * (width / 2));
+        const double maxMs = timeMs([&] { maxPool2d(x.data(), y.data(), channels, height, width, 2, 2); });
+        const double avgMs = timeMs([&] { avgPool2d(x.data(), y.data(), channels, height, width, 2, 2); });
+        const double bytes = sizeof(float) * double(x.size() + y.size());
+        out << QString("%1x%2x%3").arg(channels).arg(height).arg(width).leftJustified(28)
+            << QString::number(maxMs, 'f', 3).rightJustified(9)
+            << QString::number(avgMs, 'f', 3).rightJustified(11)
+            << QString::number(bytes / maxMs / 1.0e6, 'f', 2).rightJustified(13) << "\n";
+    }
+}
+
+void benchTraining(QTextStream& out) {
+    // 反向传播与中心差分比对；损失用双精度累加，分母加下限以免梯度接近 0 时放大单精度舍入
+    out << "gradient check                      loss       max rel err\n";
+    QList<NeuralLayer> classifier;
+    NeuralLayer first = makeLayer("Input", 16, "tanh");
+    first.inputSize = 8;
+    classifier << first << makeLayer("Hidden", 12, "sigmoid") << makeLayer("Hidden", 10, "leaky_relu")
+               << makeLayer("Output", 5, "softmax");
+    QList<NeuralLayer> regressor;
+    regressor << first << makeLayer("Hidden", 12, "relu") << makeLayer("Output", 3, "linear");
+    const struct { const char* name; const QList<NeuralLayer>* layers; bool classification; } checks[] = {
+        {"tanh/sigmoid/leaky -> softmax+CE", &classifier, true}, {"tanh/relu -> linear+MSE", &regressor, false}};
+    for (const auto& check : checks) {
+        TrainingEngine engine;
+        QString error;
+        if (!engine.build(*check.layers, TrainingConfig(), &error)) {
+            out << check.name << ": " << error << "\n";
+            continue;
+        }
+        const int batch = 48;  // 大于分片阈值，覆盖多分片归约
+        TrainingData data = makeSyntheticData(engine.inputSize(), engine.outputSize(), batch, check.classification, 3);
+        std::vector<float> grads;
+        const double loss = engine.computeGradients(data.x.data(), data.y.data(), batch, grads);
+        double worst = 0.0;
+        std::mt19937 rng(11);
+        for (int l = 0; l < engine.layerCount(); ++l) {
+            const TrainingEngine::LayerInfo& info = engine.layerInfo(l);
+            if (!info.dense) continue;
+            float* params[] = {engine.weightData(l), engine.biasData(l)};
+            const int counts[] = {info.inputs * info.outputs, info.outputs};
+            for (int part = 0; part < 2; ++part) {
+                std::uniform_int_distribution<int> pick(0, counts[part] - 1);
+                for (int k = 0; k < 8; ++k) {
+                    float* p = params[part] + pick(rng);
+                    const float saved = *p;
+                    const float h = 1.0e-3f;
+                    *p = saved + h;
+                    const double up = engine.evaluate(data.x.data(), data.y.data(), batch);
+                    *p = saved - h;
+                    const double down = engine.evaluate(data.x.data(), data.y.data(), batch);
+                    *p = saved;
+                    const double numeric = (up - down) / (2.0 * h);
+                    const double analytic = grads[std::size_t(p - engine.weightData(0))];
+                    worst = std::max(worst, std::fabs(numeric - analytic) / std::max(1.0e-2, std::fabs(numeric) + std::fabs(analytic)));
+                }
+            }
+        }
+        out << QString(check.name).leftJustified(34) << QString::number(loss, 'f', 4).rightJustified(8)
+            << QString::number(worst, 'e', 2).rightJustified(16) << (worst < 2.0e-2 ? "" : "  FAIL") << "\n";
+    }
+
+    // 784-512-256-10 分类网络在合成数据上训练 2 个 epoch
+    QList<NeuralLayer> mlp;
+    NeuralLayer input = makeLayer("Input", 512, "relu");
+    input.inputSize = 784;
+    mlp << input << makeLayer("Hidden", 256, "relu") << makeLayer("Dropout", 0) << makeLayer("Output", 10, "softmax");
+    const int samples = 4096;
+    const TrainingData data = makeSyntheticData(784, 10, samples, true, 5);
+    out << "\nthreads: " << ThreadPool::global().threadCount() << "\n";
+    out << "optimizer  batch   initial loss   final loss   accuracy   samples/s\n";
+    const struct { OptimizerType type; float lr; } optimizers[] = {{OptimizerType::SGD, 0.05f}, {OptimizerType::Adam, 1.0e-3f}};
+    for (const auto& opt : optimizers) {
+        for (int batch : {32, 128}) {
+            TrainingConfig config;
+            config.optimizer = opt.type;
+            config.learningRate = opt.lr;
+            config.batchSize = batch;
+            TrainingEngine engine;
+            QString error;
+            if (!engine.build(mlp, config, &error)) {
+                out << error << "\n";
+                return;
+            }
+            const double initial = engine.evaluate(data.x.data(), data.y.data(), samples);
+            QElapsedTimer timer;
+            timer.start();
+            for (int epoch = 0; epoch < 2; ++epoch) {
+                for (int s = 0; s + batch <= samples; s += batch) {
+                    engine.trainStep(data.x.data() + std::size_t(s) * 784, data.y.data() + std::size_t(s) * 10, batch);
+                }
+            }
+            const double seconds = timer.nsecsElapsed() / 1.0e9;
+            double accuracy = 0.0;
+            const double final = engine.evaluate(data.x.data(), data.y.data(), samples, &accuracy);
+            out << optimizerName(opt.type).leftJustified(9) << QString::number(batch).rightJustified(7)
+                << QString::number(initial, 'f', 4).rightJustified(15) << QString::number(final, 'f', 4).rightJustified(13)
+                << QString::number(accuracy * 100.0, 'f', 1).rightJustified(10) << "%"
+                << QString::number(2.0 * (samples / batch * batch) / seconds, 'f', 0).rightJustified(12)
+                << (final < initial ? "" : "  FAIL") << "\n";
+        }
+    }
+}
+
+void benchCheckpoint(QTextStream& out) {
+    // 在临时目录写一个约 112 MB 的 safetensors：两个 F32 权重 + 一个 BF16 权重
+    const int wide = 4096, classes = 1000;
+    const QString path = QDir::temp().filePath("nnv_bench_checkpoint.safetensors");
+    const qint64 fc1 = qint64(wide) * wide * 4, fc2 = qint64(wide) * wide * 2, fc3 = qint64(classes) * wide * 4;
+    QString header = QString("{\"model.fc1.weight\":{\"dtype\":\"F32\",\"shape\":[%1,%1],\"data_offsets\":[0,%2]},"
+                             "\"model.fc2.weight\":{\"dtype\":\"BF16\",\"shape\":[%1,%1],\"data_offsets\":[%2,%3]},"
+                             "\"model.fc3.weight\":{\"dtype\":\"F32\",\"shape\":[%4,%1],\"data_offsets\":[%3,%5]}}")
+                         .arg(wide).arg(fc1).arg(fc1 + fc2).arg(classes).arg(fc1 + fc2 + fc3);
+    while ((header.size() + 8) % 8 != 0) header += ' ';
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly)) {
+            out << "无法写入临时文件 " << path << "\n";
+            return;
+        }
+        const QByteArray json = header.toUtf8();
+        const quint64 length = static_cast<quint64>(json.size());
+        file.write(reinterpret_cast<const char*>(&length), 8);
+        file.write(json);
+        // 权重值取 (i % 251 - 125) / 128，可精确表示为 BF16，便于逐元素校验
+        std::vector<char> block(1 << 22);
+        auto writeTensor = [&](qint64 count, bool bf16) {
+            const int width = bf16 ? 2 : 4;
+            qint64 i = 0;
+            while (i < count) {
+                const qint64 n = std::min<qint64>(count - i, qint64(block.size()) / width);
+                for (qint64 k = 0; k < n; ++k) {
+                    const float v = float((i + k) % 251 - 125) / 128.0f;
+                    quint32 bits;
+                    std::memcpy(&bits, &v, 4);
+                    if (bf16) {
+                        const quint16 half = static_cast<quint16>(bits >> 16);
+                        std::memcpy(block.data() + k * 2, &half, 2);
+                    } else {
+                        std::memcpy(block.data() + k * 4, &bits, 4);
+                    }
+                }
+                file.write(block.data(), n * width);
+                i += n;
+            }
+        };
+        writeTensor(qint64(wide) * wide, false);
+        writeTensor(qint64(wide) * wide, true);
+        writeTensor(qint64(classes) * wide, false);
+    }
+
+    out << "file: " << QString::number(QFile(path).size() / (1024.0 * 1024.0), 'f', 1) << " MB\n";
+    const double openMs = timeMs([&] {
+        WeightCheckpoint checkpoint;
+        checkpoint.open(path);
+    }, 50.0);
+    WeightCheckpoint checkpoint;
+    QString error;
+    if (!checkpoint.open(path, &error)) {
+        out << error << "\n";
+        QFile::remove(path);
+        return;
+    }
+    out << "open (map + header)        " << QString::number(openMs, 'f', 3).rightJustified(10) << " ms\n";
+
+    QList<NeuralLayer> layers;
+    NeuralLayer input = makeLayer("Input", wide, "relu");
+    input.inputSize = wide;
+    layers << input << makeLayer("Hidden", wide, "relu") << makeLayer("Output", classes, "softmax");
+    QStringList report;
+    QVector<LayerWeightBinding> bindings;
+    const double bindMs = timeMs([&] { bindings = bindCheckpoint(checkpoint, layers); }, 50.0);
+    bindCheckpoint(checkpoint, layers, &report);
+    out << "bind to layers             " << QString::number(bindMs, 'f', 3).rightJustified(10) << " ms\n";
+    for (const QString& line : report) out << "  " << line << "\n";
+
+    out << "tensor              dtype   zero-copy   read ms    GB/s   check\n";
+    for (int i = 0; i < bindings.size(); ++i) {
+        const int index = bindings[i].weight;
+        if (index < 0) continue;
+        const CheckpointTensor& tensor = checkpoint.tensors()[index];
+        std::vector<float> values(static_cast<std::size_t>(tensor.elementCount()));
+        const double readMs = timeMs([&] { checkpoint.read(index, values.data()); }, 100.0);
+        bool ok = true;
+        for (std::size_t k = 0; k < values.size(); k += 9973) {
+            if (values[k] != float(qint64(k) % 251 - 125) / 128.0f) ok = false;
+        }
+        out << tensor.name.leftJustified(20) << tensor.dtypeName.leftJustified(8)
+            << QString(checkpoint.mappedData(index) ? "yes" : "no").rightJustified(9)
+            << QString::number(readMs, 'f', 2).rightJustified(10)
+            << QString::number(tensor.elementCount() * 4.0 / (readMs * 1.0e6), 'f', 2).rightJustified(8)
+            << (ok ? "   ok" : "   FAIL") << "\n";
+    }
+    checkpoint.close();
+    QFile::remove(path);
+
+    // 恶意头部：维度乘积回绕、超长维度、超出 qint64 的 JSON 数值、比声明短的 zip64 扩展字段都应在 open 时拒绝
+    {
+        auto u16 = [](int v) { return QByteArray(1, char(v & 0xff)) + QByteArray(1, char((v >> 8) & 0xff)); };
+        auto u32 = [&](quint32 v) { return u16(int(v & 0xffff)) + u16(int(v >> 16)); };
+        auto npy = [&](const QByteArray& shape) {
+            QByteArray header = "{'descr': '<f4', 'fortran_order': False, 'shape': " + shape + ", }";
+            while ((10 + header.size() + 1) % 64 != 0) header += " ";
+            header += "\n";
+            return QByteArray("\x93NUMPY\x01\x00", 8) + u16(header.size()) + header + QByteArray(64, '\0');
+        };
+        // 单个未压缩成员的 npz；sizes 为中央目录里的 压缩/未压缩 大小，extra 为中央目录扩展字段
+        auto npz = [&](const QByteArray& member, quint32 sizes, const QByteArray& extra) {
+            const QByteArray name = "w.npy";
+            QByteArray zip = u32(0x04034b50u) + u16(20) + u16(0) + u16(0) + u16(0) + u16(0) + u32(0) + u32(member.size())
+                             + u32(member.size()) + u16(name.size()) + u16(0) + name + member;
+            const int directory = zip.size();
+            zip += u32(0x02014b50u) + u16(20) + u16(20) + u16(0) + u16(0) + u16(0) + u16(0) + u32(0) + u32(sizes)
+                   + u32(sizes) + u16(name.size()) + u16(extra.size()) + u16(0) + u16(0) + u16(0) + u32(0) + u32(0)
+                   + name + extra;
+            zip += u32(0x06054b50u) + u16(0) + u16(0) + u16(1) + u16(1) + u32(zip.size() - directory) + u32(directory) + u16(0);
+            return zip;
+        };
+        auto safetensors = [&](const QByteArray& json) {
+            QByteArray header = json;
+            while (header.size() % 8 != 0) header += " ";
+            return u32(header.size()) + u32(0) + header + QByteArray(16, '\0');
+        };
+        const QByteArray member = npy("(4, 4)");
+        const struct { const char* label; QByteArray bytes; bool valid; } cases[] = {
+            {"npy 4x4 (control)", member, true},
+            {"npz 4x4 (control)", npz(member, quint32(member.size()), QByteArray()), true},
+            {"npy 2^32 x 2^32 x 16", npy("(4294967296, 4294967296, 16)"), false},
+            {"npy dimension 10^20", npy("(100000000000000000000,)"), false},
+            {"safetensors shape 1e30", safetensors("{\"w\":{\"dtype\":\"F32\",\"shape\":[1e30],\"data_offsets\":[0,16]}}"), false},
+            {"safetensors offsets 1e300", safetensors("{\"w\":{\"dtype\":\"F32\",\"shape\":[4],\"data_offsets\":[1e300,16]}}"), false},
+            {"npz zip64 field too short", npz(member, 0xffffffffu, u16(1) + u16(8) + QByteArray(8, '\0')), false},
+            {"npz extra longer than entry", npz(member, quint32(member.size()), u16(1) + u16(40) + QByteArray(4, '\0')), false},
+        };
+        const QString hostilePath = QDir::temp().filePath("nnv_bench_hostile_checkpoint");
+        for (const auto& c : cases) {
+            QFile file(hostilePath);
+            file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+            file.write(c.bytes);
+            file.close();
+            WeightCheckpoint hostile;
+            QString hostileError;
+            const bool opened = hostile.open(hostilePath, &hostileError);
+            bool ok = opened == c.valid;
+            if (opened) {
+                std::vector<float> values(16);
+                ok = ok && hostile.tensors().size() == 1 && hostile.tensors()[0].elementCount() == 16
+                     && hostile.read(0, values.data());
+            }
+            out << "  " << QString(c.label).leftJustified(30) << (opened ? "opened" : "rejected") << (ok ? "  ok" : "  FAIL")
+                << (opened ? QString() : "  (" + hostileError + ")") << "\n";
+        }
+        QFile::remove(hostilePath);
+    }
+}
+
+void benchWeightStats(QTextStream& out) {
+    // 正确性：与双精度两遍扫描的标量参考比较（含 NaN/Inf、精确零值与非 8 对齐的尾部）
+    {
+        const qint64 n = (1 << 22) + 5;
+        std::vector<float> w = randomVector(static_cast<std::size_t>(n), 21, 0.2f);
+        for (qint64 i = 0; i < n; i += 7) w[i] = 0.0f;
+        w[123] = std::numeric_limits<float>::quiet_NaN();
+        w[n - 1] = std::numeric_limits<float>::infinity();
+        const WeightStats stats = computeWeightStats(w.data(), n);
+
+        qint64 count = 0, zeros = 0;
+        double sum = 0.0;
+        float lo = std::numeric_limits<float>::infinity(), hi = -lo;
+        for (float v : w) {
+            if (!std::isfinite(v)) continue;
+            ++count;
+            zeros += v == 0.0f;
+            sum += v;
+            lo = std::min(lo, v);
+            hi = std::max(hi, v);
+        }
+        const double mean = sum / count;
+        double m2 = 0.0;
+        std::array<qint64, WeightStats::kBins> bins{};
+        const float scale = static_cast<float>(WeightStats::kBins / (double(hi) - double(lo)));
+        for (float v : w) {
+            if (!std::isfinite(v)) continue;
+            m2 += (v - mean) * (v - mean);
+            ++bins[std::clamp(static_cast<int>((v - lo) * scale), 0, WeightStats::kBins - 1)];
+        }
+        const double stddev = std::sqrt(m2 / count);
+        const bool ok = stats.count == count && stats.nonFinite == 2 && stats.zeros == zeros && stats.min == lo
+                        && stats.max == hi && std::fabs(stats.mean - mean) < 1.0e-9
+                        && std::fabs(stats.stddev - stddev) < 1.0e-9 * stddev && stats.histogram == bins;
+        out << "reference check (" << n << " elements, " << (simd::hasAvx2() ? "avx2" : "scalar") << "): "
+            << (ok ? "ok" : "FAIL") << "\n"
+            << "  mean " << QString::number(stats.mean, 'e', 6) << " vs " << QString::number(mean, 'e', 6)
+            << ", std " << QString::number(stats.stddev, 'e', 6) << " vs " << QString::number(stddev, 'e', 6)
+            << ", sparsity " << QString::number(stats.sparsity() * 100.0, 'f', 2) << "%\n";
+    }
+
+    // 吞吐：单线程与全局线程池，最大一档 1 亿参数（400 MB）
+    ThreadPool single(1);
+    out << "\nthreads: " << ThreadPool::global().threadCount() << "\n";
+    out << "params        1 thread ms      GB/s     pool ms      GB/s\n";
+    for (qint64 n : {qint64(1) << 20, qint64(16) << 20, qint64(100000000)}) {
+        std::vector<float> w(static_cast<std::size_t>(n));
+        const int blocks = static_cast<int>((n + 65535) / 65536);
+        ThreadPool::global().parallelFor(0, blocks, 1, [&](int first, int last) {
+            for (qint64 i = qint64(first) * 65536; i < std::min(n, qint64(last) * 65536); ++i) {
+                const quint32 h = static_cast<quint32>(i) * 2654435761u;
+                w[static_cast<std::size_t>(i)] = i % 10 == 0 ? 0.0f : (float((h >> 8) & 0xffff) / 32768.0f - 1.0f) * 0.05f;
+            }
+        });
+        const double singleMs = timeMs([&] { computeWeightStats(w.data(), n, &single); }, 100.0);
+        const double poolMs = timeMs([&] { computeWeightStats(w.data(), n); }, 100.0);
+        const double gigabytes = n * 4.0 / 1.0e9;
+        out << QString::number(n).leftJustified(12) << QString::number(singleMs, 'f', 2).rightJustified(13)
+            << QString::number(gigabytes / (singleMs / 1000.0), 'f', 2).rightJustified(10)
+            << QString::number(poolMs, 'f', 2).rightJustified(12)
+            << QString::number(gigabytes / (poolMs / 1000.0), 'f', 2).rightJustified(10) << "\n";
+    }
+
+    // 缓存命中：同一版本直接返回，版本变化后失效
+    WeightStatsCache& cache = WeightStatsCache::instance();
+    std::vector<float> w = randomVector(1 << 20, 5);
+    cache.insert("bench#fc1.weight", 1, computeWeightStats(w.data(), qint64(w.size())));
+    WeightStats cached;
+    const double hitUs = timeMs([&] { cache.find("bench#fc1.weight", 1, &cached); }, 20.0) * 1000.0;
+    const bool stale = cache.find("bench#fc1.weight", 2, &cached);
+    out << "\ncache hit " << QString::number(hitUs, 'f', 2) << " us, newer version "
+        << (stale ? "served stale result  FAIL" : "misses as expected") << "\n";
+    cache.clear();
+}
+
+void benchQuantization(QTextStream& out) {
+    // 正确性：向量路径与逐元素（n = 1 走标量尾部）结果逐位一致，覆盖舍入边界、溢出、非规格化数与 NaN
+    {
+        const qint64 n = (1 << 20) + 3;
+        std::vector<float> x = randomVector(static_cast<std::size_t>(n), 31, 4.0f);
+        const float specials[] = {0.5f, 1.5f, -2.5f, 126.5f, -127.5f, 300.0f, -1.0e9f, 65504.0f, 65520.0f, 1.0e-7f,
+                                  -3.0e-5f, 6.1e-5f, std::numeric_limits<float>::infinity(),
+                                  std::numeric_limits<float>::quiet_NaN(), 1.00390625f, 1.01171875f};
+        for (std::size_t i = 0; i < sizeof(specials) / sizeof(specials[0]); ++i) x[i * 37] = specials[i];
+        std::vector<float> a(x.size()), b(x.size());
+        const auto sameBits = [&] { return std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0; };
+        const auto perElement = [&](void (*fn)(const float*, qint64, float*)) {
+            for (qint64 i = 0; i < n; ++i) fn(&x[i], 1, &b[i]);
+        };
+
+        roundToFloat16(x.data(), n, a.data());
+        perElement(roundToFloat16);
+        const bool fp16 = sameBits();
+        roundToBFloat16(x.data(), n, a.data());
+        perElement(roundToBFloat16);
+        const bool bf16 = sameBits();
+
+        std::vector<float> finite = randomVector(static_cast<std::size_t>(n), 32, 4.0f);
+        for (qint64 i = 0; i < n; i += 101) finite[i] = 0.05f * float(i % 255) - 6.375f;  // 恰好落在 .5 的点
+        std::vector<qint8> qa(x.size()), qb(x.size());
+        quantizeInt8(finite.data(), n, 0.05f, 3, -128, 127, qa.data());
+        for (qint64 i = 0; i < n; ++i) quantizeInt8(&finite[i], 1, 0.05f, 3, -128, 127, &qb[i]);
+        dequantizeInt8(qa.data(), n, 0.05f, 3, a.data());
+        for (qint64 i = 0; i < n; ++i) dequantizeInt8(&qa[i], 1, 0.05f, 3, &b[i]);
+        const bool int8 = qa == qb && sameBits();
+        out << "vector vs scalar (" << (simd::hasAvx2() ? "avx2" : "scalar") << "): int8 " << (int8 ? "ok" : "FAIL")
+            << ", fp16 " << (fp16 ? "ok" : "FAIL") << ", bf16 " << (bf16 ? "ok" : "FAIL") << "\n";
+    }
+
+    // 内核吞吐：16M 元素（64 MB），按读入的 fp32 字节计
+    {
+        const qint64 n = qint64(16) << 20;
+        std::vector<float> x = randomVector(static_cast<std::size_t>(n), 33, 0.1f);
+        std::vector<float> y(x.size());
+        std::vector<qint8> q(x.size());
+        const auto rate = [&](double ms) { return QString::number(n * 4.0 / 1.0e6 / ms, 'f', 2).rightJustified(8); };
+        double ms = timeMs([&] { quantizeInt8(x.data(), n, 0.1f / 127.0f, 0, -127, 127, q.data()); }, 100.0);
+        out << "\nquantize int8        " << QString::number(ms, 'f', 2).rightJustified(8) << " ms " << rate(ms) << " GB/s\n";
+        ms = timeMs([&] { dequantizeInt8(q.data(), n, 0.1f / 127.0f, 0, y.data()); }, 100.0);
+        out << "dequantize int8      " << QString::number(ms, 'f', 2).rightJustified(8) << " ms " << rate(ms) << " GB/s\n";
+        ms = timeMs([&] { roundToFloat16(x.data(), n, y.data()); }, 100.0);
+        out << "round fp16           " << QString::number(ms, 'f', 2).rightJustified(8) << " ms " << rate(ms) << " GB/s\n";
+        ms = timeMs([&] { roundToBFloat16(x.data(), n, y.data()); }, 100.0);
+        out << "round bf16           " << QString::number(ms, 'f', 2).rightJustified(8) << " ms " << rate(ms) << " GB/s\n";
+        QuantConfig config;
+        ms = timeMs([&] { fakeQuantize(x.data(), 4096, n / 4096, config, y.data()); }, 100.0);
+        out << "fake quant 4096 rows " << QString::number(ms, 'f', 2).rightJustified(8) << " ms " << rate(ms)
+            << " GB/s (量化+反量化+误差)\n";
+    }
+
+    // 整网模拟：各方案的存储、预测加速比与输出误差
+    QList<NeuralLayer> mlp;
+    NeuralLayer input = makeLayer("Input", 512, "relu");
+    input.inputSize = 784;
+    mlp << input << makeLayer("Hidden", 256, "relu") << makeLayer("Output", 10, "softmax");
+    QList<NeuralLayer> cnn;
+    NeuralLayer conv1 = makeLayer("Convolutional", 1, "relu");
+    conv1.filters = 32;
+    conv1.kernelSize = 3;
+    NeuralLayer pool = makeLayer("MaxPooling", 1);
+    pool.poolingSize = 2;
+    NeuralLayer conv2 = conv1;
+    conv2.filters = 64;
+    cnn << conv1 << pool << conv2 << pool << makeLayer("Dense", 10, "softmax");
+    const struct { const char* name; const QList<NeuralLayer>* layers; } nets[] = {{"MLP 784-512-256-10", &mlp},
+                                                                                 {"CNN 3x32x32", &cnn}};
+    const QuantConfig configs[] = {{QuantScheme::Int8Symmetric, QuantGranularity::PerTensor},
+                                   {QuantScheme::Int8Symmetric, QuantGranularity::PerChannel},
+                                   {QuantScheme::Int8Asymmetric, QuantGranularity::PerChannel},
+                                   {QuantScheme::Float16, QuantGranularity::PerTensor},
+                                   {QuantScheme::BFloat16, QuantGranularity::PerTensor}};
+    for (const auto& net : nets) {
+        out << "\n" << net.name << "\n";
+        for (const QuantConfig& config : configs) {
+            QElapsedTimer timer;
+            timer.start();
+            const QuantReport report = simulateQuantization(*net.layers, config);
+            const double ms = timer.nsecsElapsed() / 1.0e6;
+            out << "  " << report.summary() << "（模拟 " << QString::number(ms, 'f', 1) << " ms）\n";
+            double worst = 0.0;
+            for (const QuantLayerReport& layer : report.layers) worst = std::max(worst, layer.error.relativeRms());
+            out << "    最差层相对 RMS 误差 " << QString::number(worst * 100.0, 'f', 3) << "%\n";
+        }
+    }
+}
+
+#if NNV_HAVE_AVX2
+NNV_AVX2 float rowDotAvx2(const float* row, const float* x, int cols) {
+    int c = 0;
+    float sum = 0.0f;
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    for (; c + 16 <= cols; c += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(row + c), _mm256_loadu_ps(x + c), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(row + c + 8), _mm256_loadu_ps(x + c + 8), acc1);
+    }
+    alignas(32) float lanes[8];
+    _mm256_store_ps(lanes, _mm256_add_ps(acc0, acc1));
+    for (float v : lanes) sum += v;
+    for (; c < cols; ++c) sum += row[c] * x[c];
+    return sum;
+}
+#endif
+
+float rowDot(const float* row, const float* x, int cols) {
+#if NNV_HAVE_AVX2
+    if (simd::hasAvx2()) return rowDotAvx2(row, x, cols);
+#endif
+    float sum = 0.0f;
+    for (int c = 0; c < cols; ++c) sum += row[c] * x[c];
+    return sum;
+}
+
+// 不打包、逐行点积的稠密矩阵-向量乘，作为 CSR 乘法的稠密对照（sgemm 在 M = 1 时主要耗在打包 B 上）
+void denseMatVec(const float* w, int rows, int cols, const float* x, float* y) {
+    ThreadPool::global().parallelFor(0, rows, 16, [&](int first, int last) {
+        for (int r = first; r < last; ++r) y[r] = rowDot(w + std::size_t(r) * cols, x, cols);
+    });
+}
+
+void benchPruning(QTextStream& out) {
+    // 正确性：CSR 前向与剪枝后稠密矩阵的朴素乘法一致；N:M 每组最多保留 N 个
+    {
+        const int rows = 1024, cols = 1000, batch = 3;
+        std::vector<float> w = randomVector(std::size_t(rows) * cols, 41);
+        const float threshold = magnitudeThreshold(w.data(), qint64(w.size()), 0.9);
+        pruneBelow(w.data(), qint64(w.size()), threshold);
+        const CsrMatrix csr = toCsr(w.data(), rows, cols);
+        std::vector<float> x = randomVector(std::size_t(batch) * cols, 42);
+        std::vector<float> expected(std::size_t(batch) * rows), actual(expected.size());
+        sgemmReference(batch, rows, cols, x.data(), cols, w.data(), cols, true, expected.data(), rows);
+        csrMatMul(csr, x.data(), batch, actual.data());
+        double maxError = 0.0;
+        for (std::size_t i = 0; i < expected.size(); ++i) maxError = std::max(maxError, double(std::fabs(expected[i] - actual[i])));
+        std::vector<float> roundTrip(w.size());
+        csr.toDense(roundTrip.data());
+
+        std::vector<float> nm = randomVector(std::size_t(rows) * cols, 43);
+        const qint64 prunedNM = pruneNM(nm.data(), rows, cols, 2, 4);
+        bool groupsOk = true;
+        for (int r = 0; r < rows && groupsOk; ++r) {
+            for (int g = 0; g < cols; g += 4) {
+                int kept = 0;
+                for (int k = g; k < std::min(cols, g + 4); ++k) kept += nm[std::size_t(r) * cols + k] != 0.0f;
+                groupsOk = groupsOk && kept <= 2;
+            }
+        }
+        const bool ok = maxError < 1.0e-5 && roundTrip == w && std::fabs(csr.sparsity() - 0.9) < 1.0e-3 && groupsOk
+                        && prunedNM == qint64(rows) * cols / 2;
+        out << "reference check (" << (simd::hasAvx2() ? "avx2 gather" : "scalar") << "): " << (ok ? "ok" : "FAIL")
+            << "  max |Δ| " << QString::number(maxError, 'e', 2) << ", sparsity " << QString::number(csr.sparsity() * 100.0, 'f', 2)
+            << "%, 2:4 pruned " << prunedNM << "\n";
+    }
+
+    // 阈值：16M 个权重上 nth_element 的耗时
+    {
+        std::vector<float> w = randomVector(std::size_t(16) << 20, 44);
+        float threshold = 0.0f;
+        const double ms = timeMs([&] { threshold = magnitudeThreshold(w.data(), qint64(w.size()), 0.9); }, 100.0);
+        out << "threshold (16M weights, 90%): " << QString::number(ms, 'f', 1) << " ms, |w| < "
+            << QString::number(threshold, 'f', 4) << "\n";
+    }
+
+    // 稀疏与稠密矩阵-向量乘：4096×4096，batch 1
+    {
+        const int n = 4096;
+        const std::vector<float> original = randomVector(std::size_t(n) * n, 45);
+        std::vector<float> x = randomVector(std::size_t(n), 46);
+        std::vector<float> y(static_cast<std::size_t>(n));
+        const double gemmMs = timeMs([&] { sgemm(1, n, n, x.data(), n, original.data(), n, true, y.data(), n); }, 100.0);
+        const double denseMs = timeMs([&] { denseMatVec(original.data(), n, n, x.data(), y.data()); }, 100.0);
+        out << "\nmatvec 4096x4096     ms     GB/s  speedup       MB\n";
+        out << QString("dense sgemm").leftJustified(17) << QString::number(gemmMs, 'f', 3).rightJustified(9)
+            << QString::number(n * double(n) * 4.0 / 1.0e6 / gemmMs, 'f', 2).rightJustified(9)
+            << QString::number(denseMs / gemmMs, 'f', 2).rightJustified(9)
+            << QString::number(n * double(n) * 4.0 / 1.0e6, 'f', 1).rightJustified(9) << "\n";
+        out << QString("dense row dot").leftJustified(17) << QString::number(denseMs, 'f', 3).rightJustified(9)
+            << QString::number(n * double(n) * 4.0 / 1.0e6 / denseMs, 'f', 2).rightJustified(9) << "     1.00"
+            << QString::number(n * double(n) * 4.0 / 1.0e6, 'f', 1).rightJustified(9) << "\n";
+        const struct { const char* name; double sparsity; bool nm; } cases[] = {
+            {"CSR 50%", 0.5, false}, {"CSR 2:4", 0.5, true}, {"CSR 90%", 0.9, false}, {"CSR 99%", 0.99, false}};
+        for (const auto& c : cases) {
+            std::vector<float> w = original;
+            if (c.nm) {
+                pruneNM(w.data(), n, n, 2, 4);
+            } else {
+                pruneBelow(w.data(), qint64(w.size()), magnitudeThreshold(w.data(), qint64(w.size()), c.sparsity));
+            }
+            const CsrMatrix csr = toCsr(w.data(), n, n);
+            const double ms = timeMs([&] { csrMatMul(csr, x.data(), 1, y.data()); }, 100.0);
+            out << QString(c.name).leftJustified(17) << QString::number(ms, 'f', 3).rightJustified(9)
+                << QString::number(csr.bytes() / 1.0e6 / ms, 'f', 2).rightJustified(9)
+                << QString::number(denseMs / ms, 'f', 2).rightJustified(9)
+                << QString::number(csr.bytes() / 1.0e6, 'f', 1).rightJustified(9) << "\n";
+        }
+    }
+
+    // 整网：MLP 的 Dense 层改用 CSR 前向
+    QList<NeuralLayer> mlp;
+    NeuralLayer input = makeLayer("Input", 2048, "relu");
+    input.inputSize = 784;
+    mlp << input << makeLayer("Hidden", 2048, "relu") << makeLayer("Output", 10, "softmax");
+    out << "\nMLP 784-2048-2048-10\n";
+    PruneConfig configs[4];
+    configs[0].sparsity = 0.5;
+    configs[1].sparsity = 0.9;
+    configs[2].method = PruneMethod::Global;
+    configs[2].sparsity = 0.9;
+    configs[3].method = PruneMethod::NM;
+    for (const PruneConfig& config : configs) out << "  " << simulatePruning(mlp, config).summary() << "\n";
+}
+
+void benchEdgeSelection(QTextStream& out) {
+    // 1000×1000 的连线组，模拟滑块从 100% 拖到 0.1% 再拖回来（每个事件 0.5%）
+    const int edges = 1000 * 1000;
+    std::vector<float> magnitude = randomVector(std::size_t(edges), 51);
+    for (float& v : magnitude) v = std::fabs(v);
+    std::vector<int> steps;
+    for (int permille = 1000; permille >= 1; permille -= 5) steps.push_back(permille);
+    for (int permille = 1; permille <= 1000; permille += 5) steps.push_back(permille);
+
+    // 正确性：每一步显示的连线都不小于任何隐藏的连线，数目与 k 一致；剪掉的（幅值 -1）永不显示
+    {
+        std::vector<float> pruned = magnitude;
+        for (int i = 0; i < edges; i += 3) pruned[i] = -1.0f;
+        TopKEdgeSelection selection;
+        selection.reset(pruned);
+        std::vector<char> visible(pruned.size());
+        for (std::size_t i = 0; i < pruned.size(); ++i) visible[i] = pruned[i] >= 0.0f;
+        bool ok = true;
+        for (int step = 0; step < int(steps.size()) && ok; step += 7) {
+            const qint64 k = std::llround(steps[step] / 1000.0 * edges);
+            std::vector<int> hidden, shown;
+            selection.select(k, &hidden, &shown);
+            for (int i : hidden) {
+                ok = ok && visible[i];
+                visible[i] = 0;
+            }
+            for (int i : shown) {
+                ok = ok && !visible[i];
+                visible[i] = 1;
+            }
+            float minShown = std::numeric_limits<float>::infinity(), maxHidden = -1.0f;
+            qint64 count = 0;
+            for (int i = 0; i < edges; ++i) {
+                ok = ok && bool(visible[i]) == selection.isVisible(i);
+                if (visible[i]) {
+                    ++count;
+                    minShown = std::min(minShown, pruned[i]);
+                } else if (pruned[i] >= 0.0f) {
+                    maxHidden = std::max(maxHidden, pruned[i]);
+                } else {
+                    ok = ok && !visible[i];
+                }
+            }
+            ok = ok && count == std::min(k, selection.candidates()) && (count == 0 || minShown >= maxHidden);
+        }
+        out << "top-k check (1M edges, 1/3 pruned): " << (ok ? "ok" : "FAIL") << "\n";
+    }
+
+    // 增量：每个滑块事件只在上次的选择或剩余部分里做部分选择，只切换变化的连线
+    TopKEdgeSelection selection;
+    selection.reset(magnitude);
+    double incrementalTotal = 0.0, incrementalMax = 0.0;
+    qint64 toggled = 0;
+    for (int permille : steps) {
+        std::vector<int> hidden, shown;
+        QElapsedTimer timer;
+        timer.start();
+        selection.select(std::llround(permille / 1000.0 * edges), &hidden, &shown);
+        const double ms = timer.nsecsElapsed() / 1.0e6;
+        incrementalTotal += ms;
+        incrementalMax = std::max(incrementalMax, ms);
+        toggled += qint64(hidden.size() + shown.size());
+    }
+
+    // 对照：每个事件都从头做一次 nth_element，并逐条同步可见性
+    double scratchTotal = 0.0, scratchMax = 0.0;
+    for (int permille : steps) {
+        QElapsedTimer timer;
+        timer.start();
+        TopKEdgeSelection fresh;
+        fresh.reset(magnitude);
+        fresh.select(std::llround(permille / 1000.0 * edges), nullptr, nullptr);
+        const double ms = timer.nsecsElapsed() / 1.0e6;
+        scratchTotal += ms;
+        scratchMax = std::max(scratchMax, ms);
+    }
+    out << int(steps.size()) << " slider events over 1M edges\n"
+        << "  incremental   avg " << QString::number(incrementalTotal / steps.size(), 'f', 3) << " ms, max "
+        << QString::number(incrementalMax, 'f', 3) << " ms, "
+        << QString::number(double(toggled) / steps.size(), 'f', 0) << " visibility toggles per event\n"
+        << "  from scratch  avg " << QString::number(scratchTotal / steps.size(), 'f', 3) << " ms, max "
+        << QString::number(scratchMax, 'f', 3) << " ms, " << edges << " visibility updates per event\n";
+}
+
+void benchHeatmap(QTextStream& out) {
+    const HeatmapColormap colormap = HeatmapColormap::fromTheme(ColorThemeManager::currentTheme());
+    auto referenceColor = [&](float w, float maxAbs) {
+        const float half = (HeatmapColormap::kSize - 1) * 0.5f;
+        const float position = w * (half / maxAbs) + half + 0.5f;
+        if (std::isnan(position)) return colormap.colors[0];
+        return colormap.colors[std::clamp(int(std::min(std::max(position, 0.0f), 255.0f)), 0, 255)];
+    };
+
+    // 正确性：与逐元素标量查表一致（含 NaN、±Inf、超出 maxAbs 的值，列数不是 8 的倍数），mipmap 每级保留 |w| 最大的有符号值
+    {
+        const int rows = 37, cols = 53;
+        std::vector<float> w = randomVector(std::size_t(rows) * cols, 61, 1.5f);
+        w[5] = std::numeric_limits<float>::quiet_NaN();
+        w[17] = std::numeric_limits<float>::infinity();
+        w[18] = -std::numeric_limits<float>::infinity();
+        QImage image;
+        renderWeightImage(w.data(), rows, cols, 1.0f, colormap, image);
+        bool ok = image.width() == cols && image.height() == rows;
+        for (int r = 0; r < rows && ok; ++r) {
+            const QRgb* line = reinterpret_cast<const QRgb*>(image.constScanLine(r));
+            for (int c = 0; c < cols; ++c) ok = ok && line[c] == referenceColor(w[std::size_t(r) * cols + c], 1.0f);
+        }
+        std::vector<float> half;
+        downsampleMaxAbs(w.data(), rows, cols, half);
+        for (int r = 0; r < (rows + 1) / 2 && ok; ++r) {
+            for (int c = 0; c < (cols + 1) / 2; ++c) {
+                float expected = 0.0f;
+                for (int dr = 0; dr < 2; ++dr) {
+                    for (int dc = 0; dc < 2; ++dc) {
+                        const float v = w[std::size_t(std::min(2 * r + dr, rows - 1)) * cols + std::min(2 * c + dc, cols - 1)];
+                        if (std::isnan(v) || (!std::isnan(expected) && std::fabs(v) > std::fabs(expected))) expected = v;
+                    }
+                }
+                const float got = half[std::size_t(r) * ((cols + 1) / 2) + c];
+                ok = ok && (std::isnan(expected) ? std::isnan(got) : got == expected);
+            }
+        }
+        const QVector<QImage> levels = buildWeightMipmaps(w.data(), rows, cols, 1.0f, colormap);
+        ok = ok && levels.size() == 7 && levels.last().width() == 1 && levels.last().height() == 1;
+        out << "colormap/mipmap check: " << (ok ? "ok" : "FAIL") << "\n";
+    }
+
+    // 4096×4096 的 Dense 层：一次着色与完整 mipmap 链，对照为逐元素标量查表
+    const int n = 4096;
+    std::vector<float> w = randomVector(std::size_t(n) * n, 67, 0.05f);
+    QImage image;
+    const double renderMs = timeMs([&] { renderWeightImage(w.data(), n, n, 0.05f, colormap, image); });
+    const double scalarMs = timeMs([&] {
+        for (int r = 0; r < n; ++r) {
+            QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(r));
+            for (int c = 0; c < n; ++c) line[c] = referenceColor(w[std::size_t(r) * n + c], 0.05f);
+        }
+    });
+    QVector<QImage> levels;
+    const double mipmapMs = timeMs([&] { levels = buildWeightMipmaps(w.data(), n, n, 0.05f, colormap); });
+    out << n << "x" << n << " weights (" << ThreadPool::global().threadCount() << " threads)\n"
+        << "  render        " << QString::number(renderMs, 'f', 2) << " ms ("
+        << QString::number(double(n) * n / renderMs / 1.0e6, 'f', 2) << " Gpx/s), scalar "
+        << QString::number(scalarMs, 'f', 2) << " ms\n"
+        << "  mipmap chain  " << QString::number(mipmapMs, 'f', 2) << " ms, " << int(levels.size()) << " levels\n";
+}
+
+void benchActivations(QTextStream& out) {
+    // 多层感知机 784-512-256-10，样本为 1000 行 MNIST 式 CSV（首列标签）
+    QList<NeuralLayer> mlp;
+    NeuralLayer input = makeLayer("Input", 512, "relu");
+    input.inputSize = 784;
+    mlp << input << makeLayer("Hidden", 256, "relu") << makeLayer("Output", 10, "softmax");
+    const int rows = 1000;
+    const QString path = QDir::temp().filePath("nnv_bench_samples.csv");
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly)) {
+            out << "无法写入临时文件 " << path << "\n";
+            return;
+        }
+        std::mt19937 rng(71);
+        QByteArray text = "label";
+        for (int i = 0; i < 784; ++i) text += ",p" + QByteArray::number(i);
+        text += "\n";
+        for (int r = 0; r < rows; ++r) {
+            text += QByteArray::number(r % 10);
+            for (int i = 0; i < 784; ++i) text += "," + QByteArray::number((rng() % 256) / 255.0, 'g', 4);
+            text += "\n";
+        }
+        file.write(text);
+    }
+
+    ActivationRecorder recorder;
+    QString error;
+    if (!recorder.build(mlp, nullptr, 512, 32, &error)) {
+        out << "build: " << error << "\n";
+        return;
+    }
+    SampleInputs samples;
+    samples.shape = recorder.inputShape();
+    QElapsedTimer timer;
+    timer.start();
+    const bool loaded = loadSampleInputs({path}, samples, &error);
+    const double loadMs = timer.nsecsElapsed() / 1.0e6;
+    QFile::remove(path);
+    if (!loaded) {
+        out << "load: " << error << "\n";
+        return;
+    }
+    out << "CSV " << samples.count << " samples x " << samples.shape.size() << " loaded in "
+        << QString::number(loadMs, 'f', 1) << " ms\n";
+
+    // 正确性：与单样本前向后逐层手算的平均 |激活| 一致
+    {
+        recorder.capture(samples.sample(0), 0, 32);
+        InferenceEngine engine;
+        engine.build(mlp, 1);
+        engine.initializeWeights();
+        engine.forward(samples.sample(5), 1);
+        const float* a = recorder.activations(5);
+        double maxRel = 0.0;
+        for (int i = 0; i < engine.layerCount() && a; ++i) {
+            const int units = recorder.unitCount(i);
+            const float* y = engine.layerOutput(i);
+            for (int u = 0; u < units; ++u) {
+                const double expected = std::fabs(y[u]);
+                maxRel = std::max(maxRel, std::fabs(a[recorder.layerOffset(i) + u] - expected) / std::max(expected, 1e-3));
+            }
+        }
+        out << "per-unit |a| vs single-sample forward: max rel err " << QString::number(maxRel, 'g', 3) << " "
+            << (a && maxRel < 1e-4 ? "ok" : "FAIL") << "\n";
+    }
+
+    // 拖动：逐个样本前向（每次 batch 1）与按批预取（每次 32 个，之后命中环形缓冲区）
+    auto scrub = [&](int step) {
+        recorder.build(mlp, nullptr, 512, step);
+        QElapsedTimer t;
+        t.start();
+        for (int i = 0; i < samples.count; ++i) {
+            if (!recorder.activations(i)) recorder.capture(samples.sample(i), i, std::min(step, samples.count - i));
+        }
+        return samples.count / (t.nsecsElapsed() / 1.0e9);
+    };
+    const double single = scrub(1);
+    const double batched = scrub(32);
+    out << "scrub " << samples.count << " samples: one at a time " << QString::number(single, 'f', 0)
+        << " samples/s, batch-32 prefetch " << QString::number(batched, 'f', 0) << " samples/s\n";
+
+    // 小型卷积网络：每个通道的平均 |激活|
+    QList<NeuralLayer> cnn;
+    NeuralLayer conv1 = makeLayer("Convolutional", 1, "relu");
+    conv1.filters = 32;
+    conv1.kernelSize = 3;
+    NeuralLayer pool = makeLayer("MaxPooling", 1);
+    pool.poolingSize = 2;
+    NeuralLayer conv2 = conv1;
+    conv2.filters = 64;
+    cnn << conv1 << pool << conv2 << pool << makeLayer("Dense", 10, "softmax");
+    ActivationRecorder cnnRecorder;
+    if (!cnnRecorder.build(cnn, nullptr, 512, 32, &error)) {
+        out << "cnn build: " << error << "\n";
+        return;
+    }
+    const int images = 256;
+    std::vector<float> x = randomVector(std::size_t(cnnRecorder.inputShape().size()) * images, 73);
+    timer.restart();
+    cnnRecorder.capture(x.data(), 0, images);
+    out << "CNN 3x32x32: " << images << " samples in " << QString::number(timer.nsecsElapsed() / 1.0e6, 'f', 1)
+        << " ms (" << QString::number(images / (timer.nsecsElapsed() / 1.0e9), 'f', 0) << " samples/s), "
+        << cnnRecorder.unitCount(0) << "/" << cnnRecorder.unitCount(2) << " channels per conv layer\n";
+}
+
+void benchDataset(QTextStream& out) {
+    // MNIST 式 CSV：首列标签 + 784 个 4 位小数的像素，与逐行 QFile::readLine + split + toFloat 对照
+    const int rows = 10000, features = 784;
+    const QString csvPath = QDir::temp().filePath("nnv_bench_dataset.csv");
+    {
+        QFile file(csvPath);
+        if (!file.open(QIODevice::WriteOnly)) {
+            out << "无法写入临时文件 " << csvPath << "\n";
+            return;
+        }
+        std::mt19937 rng(79);
+        QByteArray text = "label";
+        for (int i = 0; i < features; ++i) text += ",p" + QByteArray::number(i);
+        text += "\n";
+        for (int r = 0; r < rows; ++r) {
+            text += QByteArray::number(r % 10);
+            for (int i = 0; i < features; ++i) text += "," + QByteArray::number((rng() % 10000) / 9999.0, 'f', 4);
+            text += "\n";
+            if (text.size() > (1 << 22)) {
+                file.write(text);
+                text = QByteArray();
+            }
+        }
+        file.write(text);
+    }
+    const double megabytes = QFile(csvPath).size() / (1024.0 * 1024.0);
+
+    Dataset csv;
+    QString error;
+    QElapsedTimer timer;
+    timer.start();
+    if (!csv.openCsv(csvPath, features, &error)) {
+        out << "csv: " << error << "\n";
+        QFile::remove(csvPath);
+        return;
+    }
+    const double parallelMs = timer.nsecsElapsed() / 1.0e6;
+
+    timer.restart();
+    std::vector<float> naive;
+    std::vector<int> naiveLabels;
+    {
+        QFile file(csvPath);
+        file.open(QIODevice::ReadOnly);
+        file.readLine();  // 表头
+        while (!file.atEnd()) {
+            const auto fields = file.readLine().trimmed().split(',');
+            if (int(fields.size()) != features + 1) continue;
+            naiveLabels.push_back(fields[0].toInt());
+            for (int i = 1; i <= features; ++i) naive.push_back(fields[i].toFloat());
+        }
+    }
+    const double naiveMs = timer.nsecsElapsed() / 1.0e6;
+    QFile::remove(csvPath);
+
+    qint64 mismatches = 0;
+    const float* parsed = csv.contiguous(0, rows);
+    for (std::size_t i = 0; parsed && i < naive.size(); ++i) mismatches += parsed[i] != naive[i];
+    for (int r = 0; r < rows && r < int(naiveLabels.size()); ++r) mismatches += csv.label(r) != naiveLabels[r];
+    const bool csvOk = parsed && csv.count() == rows && naive.size() == std::size_t(rows) * features && mismatches == 0;
+    out << "CSV " << rows << " x " << features << " + label (" << QString::number(megabytes, 'f', 1) << " MB, "
+        << ThreadPool::global().threadCount() << " threads): " << (csvOk ? "ok" : "FAIL") << "\n"
+        << "  chunked parallel parse  " << QString::number(parallelMs, 'f', 1) << " ms  "
+        << QString::number(rows / parallelMs * 1000.0, 'f', 0) << " samples/s  "
+        << QString::number(megabytes / parallelMs * 1000.0, 'f', 0) << " MB/s\n"
+        << "  QFile::readLine + split " << QString::number(naiveMs, 'f', 1) << " ms  "
+        << QString::number(rows / naiveMs * 1000.0, 'f', 0) << " samples/s\n";
+
+    // IDX：60000 张 28×28 uint8 图像与标签，打开只映射，按批打乱 + 归一化
+    const int images = 60000, side = 28;
+    const QString imagePath = QDir::temp().filePath("nnv-bench-images-idx3-ubyte");
+    const QString labelPath = QDir::temp().filePath("nnv-bench-labels-idx1-ubyte");
+    {
+        auto bigEndian = [](quint32 v) {
+            const char bytes[4] = {char(v >> 24), char(v >> 16), char(v >> 8), char(v)};
+            return QByteArray(bytes, 4);
+        };
+        QFile imageFile(imagePath), labelFile(labelPath);
+        if (!imageFile.open(QIODevice::WriteOnly) || !labelFile.open(QIODevice::WriteOnly)) {
+            out << "无法写入临时文件 " << imagePath << "\n";
+            return;
+        }
+        imageFile.write(bigEndian(0x00000803) + bigEndian(images) + bigEndian(side) + bigEndian(side));
+        labelFile.write(bigEndian(0x00000801) + bigEndian(images));
+        std::vector<char> pixels(std::size_t(side) * side);
+        std::vector<char> labels(images);
+        for (int i = 0; i < images; ++i) {
+            for (std::size_t p = 0; p < pixels.size(); ++p) pixels[p] = char((i * 7 + p * 13) % 256);
+            imageFile.write(pixels.data(), qint64(pixels.size()));
+            labels[i] = char(i % 10);
+        }
+        labelFile.write(labels.data(), images);
+    }
+    Dataset idx;
+    timer.restart();
+    const bool opened = idx.open(imagePath, &error);
+    const double openMs = timer.nsecsElapsed() / 1.0e6;
+    if (!opened) {
+        out << "idx: " << error << "\n";
+    } else {
+        idx.setNormalization(0.1307f, 0.3081f);
+        DatasetIterator iterator(idx, 64, true, 3);
+        DatasetIterator::Batch batch;
+        double checksum = 0.0;
+        bool idxOk = idx.hasLabels() && idx.count() == images && idx.shape().height == side;
+        timer.restart();
+        qint64 seen = 0;
+        while (iterator.next(batch)) {
+            checksum += batch.inputs[0] + batch.inputs[batch.size * side * side - 1];
+            seen += batch.size;
+        }
+        const double epochMs = timer.nsecsElapsed() / 1.0e6;
+        // 抽查：第一个批次的样本与标签按公式逐元素核对
+        iterator.reset(5);
+        iterator.next(batch);
+        std::vector<qint64> order(images);
+        std::iota(order.begin(), order.end(), qint64(0));
+        std::shuffle(order.begin(), order.end(), std::mt19937(5));
+        for (int s = 0; s < batch.size && idxOk; ++s) {
+            const qint64 i = order[s];
+            idxOk = batch.labels[s] == i % 10;
+            for (int p = 0; p < side * side && idxOk; ++p) {
+                const float expected = (float((i * 7 + p * 13) % 256) / 255.0f - 0.1307f) / 0.3081f;
+                idxOk = std::fabs(batch.inputs[s * side * side + p] - expected) < 1e-5f;
+            }
+        }
+        out << "IDX " << images << " x " << side << "x" << side << ": " << (idxOk && seen == images ? "ok" : "FAIL")
+            << ", open (mmap) " << QString::number(openMs, 'f', 2) << " ms\n"
+            << "  shuffled batch-64 epoch " << QString::number(epochMs, 'f', 1) << " ms  "
+            << QString::number(images / epochMs * 1000.0, 'f', 0) << " samples/s (checksum "
+            << QString::number(checksum, 'f', 1) << ")\n";
+    }
+    idx.close();
+    QFile::remove(imagePath);
+    QFile::remove(labelPath);
+
+    // CSV 顺序遍历不打乱时直接返回矩阵内的指针
+    DatasetIterator sequential(csv, 64, false);
+    DatasetIterator::Batch batch;
+    bool zeroCopy = true;
+    qint64 position = 0;
+    while (sequential.next(batch)) {
+        zeroCopy = zeroCopy && batch.inputs == csv.contiguous(position, batch.size) && batch.labels;
+        position += batch.size;
+    }
+    out << "CSV sequential iteration zero-copy: " << (zeroCopy ? "ok" : "FAIL") << "\n";
+}
+
+// 平面上 n 个点按类别着色的朴素逐点光栅化（不分行带、单线程），用于校验与计时对照
+void scatterNaive(const float* points, const int* labels, qint64 n, const QRectF& bounds, int radius, QRgb background,
+                  QImage& image) {
+    const int width = image.width(), height = image.height();
+    const int stride = image.bytesPerLine() / 4;
+    QRgb* bits = reinterpret_cast<QRgb*>(image.bits());
+    for (int y = 0; y < height; ++y) std::fill(bits + qint64(y) * stride, bits + qint64(y) * stride + width, background);
+    const double sx = (width - 1) / bounds.width(), sy = (height - 1) / bounds.height();
+    for (qint64 i = 0; i < n; ++i) {
+        const double x = (points[i * 2] - bounds.left()) * sx;
+        const double y = (bounds.bottom() - points[i * 2 + 1]) * sy;
+        if (!(x > -radius - 1.0 && x < width + radius && y > -radius - 1.0 && y < height + radius)) continue;
+        const int px = static_cast<int>(std::lround(x)), py = static_cast<int>(std::lround(y));
+        for (int yy = std::max(0, py - radius); yy <= std::min(height - 1, py + radius); ++yy) {
+            for (int xx = std::max(0, px - radius); xx <= std::min(width - 1, px + radius); ++xx) {
+                bits[qint64(yy) * stride + xx] = scatterColor(labels[i]);
+            }
+        }
+    }
+}
+
+void benchProjection(QTextStream& out) {
+    // 1) 精度：n×d 的合成数据，均值远离 0（检验平移累加），前两个方向的方差为 25、9，其余为 1；
+    //    与双精度逐元素累加的完整协方差上幂迭代 + 收缩得到的主轴对照
+    {
+        const int n = 20000, d = 128;
+        std::mt19937 rng(83);
+        std::normal_distribution<float> normal(0.0f, 1.0f);
+        std::vector<float> u1(d), u2(d);
+        for (int j = 0; j < d; ++j) u1[j] = normal(rng), u2[j] = normal(rng);
+        auto normalize = [&](std::vector<float>& v) {
+            double s = 0.0;
+            for (float x : v) s += double(x) * x;
+            for (float& x : v) x = static_cast<float>(x / std::sqrt(s));
+        };
+        normalize(u1);
+        double c = 0.0;
+        for (int j = 0; j < d; ++j) c += double(u1[j]) * u2[j];
+        for (int j = 0; j < d; ++j) u2[j] -= static_cast<float>(c) * u1[j];
+        normalize(u2);
+        std::vector<float> data(std::size_t(n) * d);
+        for (int r = 0; r < n; ++r) {
+            const float a = 5.0f * normal(rng), b = 3.0f * normal(rng);
+            for (int j = 0; j < d; ++j) data[std::size_t(r) * d + j] = 40.0f + 0.1f * j + a * u1[j] + b * u2[j] + normal(rng);
+        }
+
+        std::vector<double> mean(d, 0.0), cov(std::size_t(d) * d, 0.0);
+        for (int r = 0; r < n; ++r)
+            for (int j = 0; j < d; ++j) mean[j] += data[std::size_t(r) * d + j];
+        for (double& m : mean) m /= n;
+        std::vector<double> centered(d);
+        for (int r = 0; r < n; ++r) {
+            for (int j = 0; j < d; ++j) centered[j] = data[std::size_t(r) * d + j] - mean[j];
+            for (int i = 0; i < d; ++i)
+                for (int j = i; j < d; ++j) cov[std::size_t(i) * d + j] += centered[i] * centered[j];
+        }
+        double trace = 0.0;
+        for (int i = 0; i < d; ++i) {
+            for (int j = i; j < d; ++j) cov[std::size_t(j) * d + i] = cov[std::size_t(i) * d + j] /= (n - 1);
+            trace += cov[std::size_t(i) * d + i];
+        }
+        // 参考主轴：双精度幂迭代 + 收缩
+        std::vector<std::vector<double>> refAxes;
+        std::vector<double> refValues;
+        for (int k = 0; k < 2; ++k) {
+            std::vector<double> v(d, 1.0), w(d);
+            double lambda = 0.0;
+            for (int it = 0; it < 2000; ++it) {
+                for (int i = 0; i < d; ++i) {
+                    double s = 0.0;
+                    for (int j = 0; j < d; ++j) s += cov[std::size_t(i) * d + j] * v[j];
+                    w[i] = s;
+                }
+                for (const auto& a : refAxes) {
+                    double p = 0.0;
+                    for (int j = 0; j < d; ++j) p += a[j] * w[j];
+                    for (int j = 0; j < d; ++j) w[j] -= p * a[j];
+                }
+                double norm = 0.0;
+                for (double x : w) norm += x * x;
+                norm = std::sqrt(norm);
+                lambda = norm;
+                for (int j = 0; j < d; ++j) v[j] = w[j] / norm;
+            }
+            refAxes.push_back(v);
+            refValues.push_back(lambda);
+        }
+
+        PcaSource source;
+        source.count = n;
+        source.dim = d;
+        source.chunk = 512;
+        source.fetch = [&](qint64 first, int) { return data.data() + first * d; };
+        for (PcaMethod method : {PcaMethod::Covariance, PcaMethod::Randomized}) {
+            PcaConfig config;
+            config.method = method;
+            QElapsedTimer timer;
+            timer.start();
+            const PcaResult pca = computePca(source, config);
+            const double ms = timer.nsecsElapsed() / 1.0e6;
+            double valueError = 0.0, angle = 1.0;
+            for (int k = 0; k < 2 && pca.valid; ++k) {
+                valueError = std::max(valueError, std::fabs(pca.variance[k] - refValues[k]) / refValues[k]);
+                double p = 0.0;
+                for (int j = 0; j < d; ++j) p += pca.axes[std::size_t(k) * d + j] * refAxes[k][j];
+                angle = std::min(angle, std::fabs(p));
+            }
+            const double traceError = std::fabs(pca.totalVariance - trace) / trace;
+            const bool ok = pca.valid && valueError < 1e-4 && angle > 0.99999 && traceError < 1e-5;
+            out << (method == PcaMethod::Covariance ? "covariance" : "randomized") << " PCA " << n << " x " << d << ": "
+                << (ok ? "ok" : "FAIL") << "  " << QString::number(ms, 'f', 1) << " ms  passes " << pca.passes
+                << "  iterations " << pca.iterations << "  λ " << QString::number(pca.variance.value(0), 'f', 4) << " / "
+                << QString::number(pca.variance.value(1), 'f', 4) << " (ref " << QString::number(refValues[0], 'f', 4)
+                << " / " << QString::number(refValues[1], 'f', 4) << ")  max rel err "
+                << QString::number(valueError, 'e', 2) << "  min |cos| " << QString::number(angle, 'f', 7) << "\n";
+        }
+    }
+
+    // 2) 高维：d = 8192 时走随机化 SVD，只保存 chunk×d 与 (k+p)×d，矩阵本身按块即时生成
+    {
+        const int n = 20000, d = 8192, chunk = 256;
+        std::vector<float> block(std::size_t(chunk) * d);
+        // 噪声取自 509 行的固定表，每行样本只需抽两个系数，生成数据不至于掩盖 PCA 本身的耗时
+        const int noiseRows = 509;
+        std::vector<float> noise(std::size_t(noiseRows) * d);
+        {
+            std::mt19937 rng(97);
+            std::normal_distribution<float> normal(0.0f, 0.05f);
+            for (float& v : noise) v = normal(rng);
+        }
+        std::vector<float> u1(d), u2(d);
+        for (int j = 0; j < d; ++j) {
+            u1[j] = std::sin(0.01f * j) / std::sqrt(d / 2.0f);
+            u2[j] = std::cos(0.01f * j) / std::sqrt(d / 2.0f);
+        }
+        PcaSource source;
+        source.count = n;
+        source.dim = d;
+        source.chunk = chunk;
+        double fetchMs = 0.0;
+        source.fetch = [&](qint64 first, int rows) {
+            QElapsedTimer fetchTimer;
+            fetchTimer.start();
+            for (int r = 0; r < rows; ++r) {
+                std::mt19937 rng(static_cast<quint32>(first + r));
+                std::normal_distribution<float> normal(0.0f, 1.0f);
+                const float a = 20.0f * normal(rng), b = 10.0f * normal(rng);
+                const float* e = noise.data() + std::size_t((first + r) % noiseRows) * d;
+                float* y = block.data() + std::size_t(r) * d;
+                for (int j = 0; j < d; ++j) y[j] = 1.0f + a * u1[j] + b * u2[j] + e[j];
+            }
+            fetchMs += fetchTimer.nsecsElapsed() / 1.0e6;
+            return block.data();
+        };
+        PcaConfig config;
+        QElapsedTimer timer;
+        timer.start();
+        const PcaResult pca = computePca(source, config);
+        const double ms = timer.nsecsElapsed() / 1.0e6 - fetchMs;
+        double c1 = 0.0, c2 = 0.0, n1 = 0.0, n2 = 0.0;
+        for (int j = 0; j < d && pca.valid; ++j) {
+            c1 += pca.axes[j] * u1[j];
+            c2 += pca.axes[std::size_t(d) + j] * u2[j];
+            n1 += double(u1[j]) * u1[j];
+            n2 += double(u2[j]) * u2[j];
+        }
+        const double cos1 = std::fabs(c1) / std::sqrt(n1), cos2 = std::fabs(c2) / std::sqrt(n2);
+        const double workingMb = (double(chunk) * d * 2 + double(config.components + config.oversample) * d * 2) * 4 / 1048576.0;
+        out << "randomized PCA " << n << " x " << d << " (streamed, chunk " << chunk << "): "
+            << (pca.valid && pca.method == PcaMethod::Randomized && cos1 > 0.9999 && cos2 > 0.9999 ? "ok" : "FAIL") << "  "
+            << QString::number(ms, 'f', 0) << " ms (excluding " << QString::number(fetchMs, 'f', 0)
+            << " ms generating chunks)  passes " << pca.passes << "  |cos| " << QString::number(cos1, 'f', 6)
+            << " / " << QString::number(cos2, 'f', 6) << "  explained " << QString::number(pca.explainedRatio(0) * 100.0, 'f', 1)
+            << "% + " << QString::number(pca.explainedRatio(1) * 100.0, 'f', 1) << "%\n"
+            << "  working set ≈ " << QString::number(workingMb, 'f', 1) << " MB vs full matrix "
+            << QString::number(double(n) * d * 4 / 1048576.0, 'f', 0) << " MB\n";
+    }
+
+    // 3) 端到端：100000 个 28×28 的 IDX 样本（每类一个模板 + 噪声），在 784-512-256-10 上取第 2 层 256 维激活
+    const int images = 100000, side = 28;
+    const QString imagePath = QDir::temp().filePath("nnv-proj-images-idx3-ubyte");
+    const QString labelPath = QDir::temp().filePath("nnv-proj-labels-idx1-ubyte");
+    {
+        auto bigEndian = [](quint32 v) {
+            const char bytes[4] = {char(v >> 24), char(v >> 16), char(v >> 8), char(v)};
+            return QByteArray(bytes, 4);
+        };
+        QFile imageFile(imagePath), labelFile(labelPath);
+        if (!imageFile.open(QIODevice::WriteOnly) || !labelFile.open(QIODevice::WriteOnly)) {
+            out << "无法写入临时文件 " << imagePath << "\n";
+            return;
+        }
+        std::mt19937 rng(89);
+        std::vector<uchar> templates(10 * side * side);
+        for (uchar& t : templates) t = static_cast<uchar>(rng() % 200);
+        imageFile.write(bigEndian(0x803) + bigEndian(images) + bigEndian(side) + bigEndian(side));
+        labelFile.write(bigEndian(0x801) + bigEndian(images));
+        QByteArray pixels(side * side * 1000, 0), labels(1000, 0);
+        for (int i = 0; i < images; ++i) {
+            const int label = static_cast<int>(rng() % 10);
+            labels[i % 1000] = char(label);
+            for (int p = 0; p < side * side; ++p) {
+                pixels[(i % 1000) * side * side + p] = char(std::min(255, templates[label * side * side + p] + int(rng() % 56)));
+            }
+            if (i % 1000 == 999) {
+                imageFile.write(pixels);
+                labelFile.write(labels);
+            }
+        }
+    }
+    Dataset dataset;
+    QString error;
+    if (!dataset.open(imagePath, &error)) {
+        out << "idx: " << error << "\n";
+        QFile::remove(imagePath);
+        QFile::remove(labelPath);
+        return;
+    }
+    QList<NeuralLayer> mlp;
+    NeuralLayer input = makeLayer("Input", 512, "relu");
+    input.inputSize = 784;
+    mlp << input << makeLayer("Hidden", 256, "relu") << makeLayer("Output", 10, "softmax");
+    const ProjectionResult projection = projectLayerActivations(mlp, 1, dataset, images, PcaConfig());
+    QFile::remove(imagePath);
+    QFile::remove(labelPath);
+    if (!projection.valid) {
+        out << "projection: " << projection.error << "\n";
+        return;
+    }
+    // 类间 / 类内方差比，衡量散点图上的类别分离程度
+    std::array<double, 20> centroid{};
+    std::array<qint64, 10> members{};
+    for (qint64 i = 0; i < projection.count(); ++i) {
+        const int label = projection.labels[i];
+        centroid[label * 2] += projection.points[i * 2];
+        centroid[label * 2 + 1] += projection.points[i * 2 + 1];
+        ++members[label];
+    }
+    for (int c = 0; c < 10; ++c) centroid[c * 2] /= std::max<qint64>(1, members[c]), centroid[c * 2 + 1] /= std::max<qint64>(1, members[c]);
+    double within = 0.0, total = 0.0;
+    double cx = 0.0, cy = 0.0;
+    for (qint64 i = 0; i < projection.count(); ++i) cx += projection.points[i * 2], cy += projection.points[i * 2 + 1];
+    cx /= projection.count();
+    cy /= projection.count();
+    for (qint64 i = 0; i < projection.count(); ++i) {
+        const int label = projection.labels[i];
+        const double x = projection.points[i * 2], y = projection.points[i * 2 + 1];
+        within += (x - centroid[label * 2]) * (x - centroid[label * 2]) + (y - centroid[label * 2 + 1]) * (y - centroid[label * 2 + 1]);
+        total += (x - cx) * (x - cx) + (y - cy) * (y - cy);
+    }
+    out << "end-to-end " << images << " samples, layer 2 (256-d): " << QString::number(projection.totalMs, 'f', 0)
+        << " ms (forward " << QString::number(projection.forwardMs, 'f', 0) << " ms, passes " << projection.pca.passes + 1
+        << ")  between/within variance " << QString::number((total - within) / std::max(1e-12, within), 'f', 2) << "\n  "
+        << projection.summary().replace("\n", "\n  ") << "\n";
+
+    // 4) 光栅化 100000 个点：行带计数排序 + 并行，与逐点朴素实现逐像素对照
+    ScatterPlotItem item(QRectF(0, 0, 800, 800));
+    item.setPoints(projection.points, projection.labels);
+    QImage banded(800, 800, QImage::Format_ARGB32), naive(800, 800, QImage::Format_ARGB32);
+    const QRgb background = qRgb(255, 255, 255);
+    const double bandedMs = timeMs([&] {
+        renderScatterImage(projection.points.data(), projection.labels.data(), projection.count(), item.dataBounds(), 1,
+                           background, banded);
+    });
+    const double naiveMs = timeMs([&] {
+        scatterNaive(projection.points.data(), projection.labels.data(), projection.count(), item.dataBounds(), 1,
+                     background, naive);
+    });
+    qint64 differing = 0;
+    for (int y = 0; y < 800; ++y) {
+        const QRgb* a = reinterpret_cast<const QRgb*>(banded.constScanLine(y));
+        const QRgb* b = reinterpret_cast<const QRgb*>(naive.constScanLine(y));
+        for (int x = 0; x < 800; ++x) differing += a[x] != b[x];
+    }
+    out << "scatter raster " << projection.count() << " points @ 800x800: " << (differing == 0 ? "ok" : "FAIL")
+        << "  banded " << QString::number(bandedMs, 'f', 2) << " ms  naive " << QString::number(naiveMs, 'f', 2)
+        << " ms  (" << ThreadPool::global().threadCount() << " threads)\n";
+}
+
+// 改写前的导入方式：每次调用新建正则，nn.Linear 与 nn.Conv2d 各扫一遍全文，
+// 激活函数取匹配位置之后 200 个字符内出现的第一个；用作计时对照
+QString legacyActivation(const QString& code, int startPos) {
+    QString snippet = code.mid(startPos, 200);
+    if (snippet.contains("nn.ReLU") || snippet.contains("F.relu")) return "relu";
+    if (snippet.contains("nn.Sigmoid") || snippet.contains("F.sigmoid")) return "sigmoid";
+    if (snippet.contains("nn.Softmax") || snippet.contains("F.softmax")) return "softmax";
+    if (snippet.contains("nn.Tanh") || snippet.contains("F.tanh")) return "tanh";
+    return "";
+}
+
+QJsonArray legacyPyTorchStructure(const QString& code) {
+    QJsonArray layersArray;
+    QRegularExpression linearPattern("nn\\.Linear\\s*\\(\\s*(\\d+)\\s*,\\s*(\\d+)\\s*\\)");
+    QRegularExpressionMatchIterator linearMatches = linearPattern.globalMatch(code);
+    while (linearMatches.hasNext()) {
+        QRegularExpressionMatch match = linearMatches.next();
+        QJsonObject layerObj;
+        layerObj["layerType"] = "Dense";
+        layerObj["inputSize"] = match.captured(1).toInt();
+        layerObj["neurons"] = match.captured(2).toInt();
+        layerObj["activationFunction"] = legacyActivation(code, match.capturedStart());
+        layersArray.append(layerObj);
+    }
+    QRegularExpression convPattern("nn\\.Conv2d\\s*\\(\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*kernel_size\\s*=\\s*(\\d+)");
+    QRegularExpressionMatchIterator convMatches = convPattern.globalMatch(code);
+    while (convMatches.hasNext()) {
+        QRegularExpressionMatch match = convMatches.next();
+        QJsonObject layerObj;
+        layerObj["layerType"] = "Conv2d";
+        layerObj["inputSize"] = match.captured(1).toInt();
+        layerObj["neurons"] = match.captured(2).toInt();
+        layerObj["kernelSize"] = match.captured(3).toInt();
+        layerObj["activationFunction"] = legacyActivation(code, match.capturedStart());
+        layersArray.append(layerObj);
+    }
+    return layersArray;
+}
+
+// "类型 输入>输出 激活" 的紧凑写法，便于与期望序列逐项比较
+QString layerSignature(const QJsonObject& layer) {
+    return QString("%1 %2>%3 %4")
+        .arg(layer["layerType"].toString())
+        .arg(layer["inputSize"].toInt())
+        .arg(layer["neurons"].toInt())
+        .arg(layer["activationFunction"].toString());
+}
+
+// 生成的模型源码：每个类 25 行，含 Conv2d/MaxPool/LSTM/Sequential/ModuleList 与 forward；
+// expected 收到按注册顺序排列的层签名
+QString generatedModelSource(int classes, QStringList* expected = nullptr) {
+    QString source = "import torch\nimport torch.nn as nn\n\n";
+    for (int i = 0; i < classes; ++i) {
+        const int c = 3 + i % 5, h = 16 + i % 7, o = 32 + i % 11;
+        source += QString("class Block%1(nn.Module):\n"
+                          "    \"\"\"Block %1: conv -> pool -> lstm -> head.\"\"\"\n"
+                          "\n"
+                          "    def __init__(self, channels=%2, hidden=%3):\n"
+                          "        super().__init__()\n"
+                          "        # feature extractor\n"
+                          "        self.conv = nn.Conv2d(channels, channels * 2, kernel_size=3, padding=1)\n"
+                          "        self.act = nn.ReLU()\n"
+                          "        self.pool = nn.MaxPool2d(kernel_size=2)\n"
+                          "        self.rnn = nn.LSTM(input_size=channels * 2, hidden_size=hidden, batch_first=True)\n"
+                          "        self.head = nn.Sequential(\n"
+                          "            nn.Linear(hidden, %4),\n"
+                          "            nn.Tanh(),\n"
+                          "            nn.Dropout(0.1),\n"
+                          "            nn.Linear(%4, 10),\n"
+                          "        )\n"
+                          "        self.extra = nn.ModuleList([nn.Linear(10, 10) for _ in range(2)])\n"
+                          "\n"
+                          "    def forward(self, x):\n"
+                          "        x = self.pool(self.act(self.conv(x)))\n"
+                          "        x, _ = self.rnn(x.flatten(2).transpose(1, 2))\n"
+                          "        for layer in self.extra:\n"
+                          "            x = layer(x)\n"
+                          "        return self.head(x)\n"
+                          "\n")
+                      .arg(i)
+                      .arg(c)
+                      .arg(h)
+                      .arg(o);
+        if (expected) {
+            *expected << QString("Conv2d %1>%2 relu").arg(c).arg(c * 2) << "MaxPooling 0>0 "
+                      << QString("LSTM %1>%2 ").arg(c * 2).arg(h) << QString("Dense %1>%2 tanh").arg(h).arg(o)
+                      << "Dropout 0>0 " << QString("Dense %1>10 ").arg(o) << "Dense 10>10 " << "Dense 10>10 ";
+        }
+    }
+    return source;
+}
+
+void benchPyImport(QTextStream& out) {
+    // 1) 手写的小模型：自定义子模块 + 循环构造 + OrderedDict 命名的 Sequential + ModuleList 推导 + 条件分支，
+    //    与 PyTorch named_modules() 的注册顺序对照
+    const QString small =
+        "import torch.nn as nn\n"
+        "from collections import OrderedDict\n"
+        "\n"
+        "class Block(nn.Module):\n"
+        "    def __init__(self, cin, cout, k=3):\n"
+        "        super().__init__()\n"
+        "        self.conv = nn.Conv2d(cin, cout, kernel_size=k, padding=1)\n"
+        "        self.act = nn.ReLU(inplace=True)\n"
+        "        self.pool = nn.MaxPool2d(2)\n"
+        "\n"
+        "class Net(nn.Module):\n"
+        "    def __init__(self, num_classes=10, widths=(16, 32)):\n"
+        "        super(Net, self).__init__()\n"
+        "        layers, cin = [], 1\n"
+        "        for w in widths:\n"
+        "            layers.append(Block(cin, w))\n"
+        "            cin = w\n"
+        "        self.features = nn.Sequential(*layers)\n"
+        "        self.flatten = nn.Flatten()\n"
+        "        self.head = nn.Sequential(OrderedDict([\n"
+        "            ('fc1', nn.Linear(cin * 7 * 7, 128)),\n"
+        "            ('act', nn.Tanh()),\n"
+        "            ('drop', nn.Dropout(p=0.25)),\n"
+        "        ]))\n"
+        "        self.rnn = nn.GRU(input_size=128, hidden_size=64)\n"
+        "        self.extra = nn.ModuleList([nn.Linear(64, 64) for _ in range(2)])\n"
+        "        if num_classes > 100:\n"
+        "            self.out = nn.Linear(64, 1000)\n"
+        "        else:\n"
+        "            self.out = nn.Linear(in_features=64, out_features=num_classes)\n"
+        "        self.softmax = nn.Softmax(dim=1)\n"
+        "\n"
+        "model = Net(num_classes=5)\n";
+    const QStringList expectedSmall = {
+        "Conv2d 1>16 relu", "MaxPooling 0>0 ", "Conv2d 16>32 relu", "MaxPooling 0>0 ", "Flatten 0>0 ",
+        "Dense 1568>128 tanh", "Dropout 0>0 ", "GRU 128>64 ", "Dense 64>64 ", "Dense 64>64 ", "Dense 64>5 softmax"};
+    QStringList warnings;
+    const QJsonArray smallLayers = ProgramFragmentProcessor::extractPyTorchStructure(small, &warnings);
+    QStringList gotSmall;
+    for (const QJsonValue& layer : smallLayers) gotSmall << layerSignature(layer.toObject());
+    out << "hand-written model: " << (gotSmall == expectedSmall && warnings.isEmpty() ? "ok" : "FAIL") << " ("
+        << smallLayers.size() << " layers, legacy regex finds " << legacyPyTorchStructure(small).size() << ")\n";
+    if (gotSmall != expectedSmall) out << "  got: " << gotSmall.join(" | ") << "\n";
+
+    // 2) forward() 数据流：残差块（+= 跳连、F.relu）、ModuleList 循环、torch.cat 分支、函数式池化，
+    //    比较每条边两端的节点名与并入层的激活函数
+    const QString residual =
+        "import torch\n"
+        "import torch.nn as nn\n"
+        "import torch.nn.functional as F\n"
+        "\n"
+        "class Residual(nn.Module):\n"
+        "    def __init__(self, c):\n"
+        "        super().__init__()\n"
+        "        self.conv1 = nn.Conv2d(c, c, 3, padding=1)\n"
+        "        self.bn1 = nn.BatchNorm2d(c)\n"
+        "        self.conv2 = nn.Conv2d(c, c, 3, padding=1)\n"
+        "\n"
+        "    def forward(self, x):\n"
+        "        identity = x\n"
+        "        out = F.relu(self.bn1(self.conv1(x)))\n"
+        "        out = self.conv2(out)\n"
+        "        out += identity\n"
+        "        return F.relu(out)\n"
+        "\n"
+        "class Net(nn.Module):\n"
+        "    def __init__(self):\n"
+        "        super().__init__()\n"
+        "        self.stem = nn.Conv2d(3, 16, 3)\n"
+        "        self.blocks = nn.ModuleList([Residual(16) for _ in range(2)])\n"
+        "        self.branch_a = nn.Conv2d(16, 8, 1)\n"
+        "        self.branch_b = nn.Conv2d(16, 8, 3, padding=1)\n"
+        "        self.fc = nn.Linear(16 * 4 * 4, 10)\n"
+        "\n"
+        "    def forward(self, x):\n"
+        "        x = F.relu(self.stem(x))\n"
+        "        for block in self.blocks:\n"
+        "            x = block(x)\n"
+        "        x = torch.cat([self.branch_a(x), torch.sigmoid(self.branch_b(x))], dim=1)\n"
+        "        x = F.max_pool2d(x, 2)\n"
+        "        x = x.view(x.size(0), -1)\n"
+        "        return F.log_softmax(self.fc(x), dim=1)\n";
+    const QStringList expectedEdges = {
+        "x>stem:relu", "stem:relu>blocks.0.conv1:relu", "blocks.0.conv1:relu>blocks.0.conv2", "blocks.0.conv2>add",
+        "stem:relu>add", "add>relu:relu", "relu:relu>blocks.1.conv1:relu", "blocks.1.conv1:relu>blocks.1.conv2",
+        "blocks.1.conv2>add", "relu:relu>add", "add>relu:relu", "relu:relu>branch_a", "relu:relu>branch_b:sigmoid",
+        "branch_a>cat", "branch_b:sigmoid>cat", "cat>max_pool2d", "max_pool2d>fc:softmax"};
+    QJsonObject graph;
+    const QJsonArray residualLayers = ProgramFragmentProcessor::extractPyTorchStructure(residual, nullptr, &graph);
+    const QJsonArray graphNodes = graph["nodes"].toArray();
+    auto nodeLabel = [&](int id) {
+        const QJsonObject node = graphNodes[id].toObject();
+        const QString activation = node["activationFunction"].toString();
+        return node["name"].toString() + (activation.isEmpty() ? QString() : ":" + activation);
+    };
+    QStringList gotEdges;
+    for (const QJsonValue& edge : graph["edges"].toArray()) {
+        gotEdges << nodeLabel(edge.toObject()["from"].toInt()) + ">" + nodeLabel(edge.toObject()["to"].toInt());
+    }
+    out << "residual/branching forward(): " << (gotEdges == expectedEdges ? "ok" : "FAIL") << " ("
+        << graphNodes.size() << " nodes, " << gotEdges.size() << " edges)\n";
+    if (gotEdges != expectedEdges) out << "  got: " << gotEdges.join(" | ") << "\n";
+
+    // 折叠为层间连线，块视图据此画跳连与合并：每个残差块的跳连只从上一块连出，不连回前面所有的块
+    const QStringList expectedLayerEdges = {
+        "stem>blocks.0.conv1", "blocks.0.conv1>blocks.0.conv2", "stem>blocks.1.conv1 add",
+        "blocks.0.conv2>blocks.1.conv1 add", "blocks.1.conv1>blocks.1.conv2", "blocks.0.conv2>branch_a add",
+        "blocks.1.conv2>branch_a add", "blocks.0.conv2>branch_b add", "blocks.1.conv2>branch_b add",
+        "branch_a>fc concat", "branch_b>fc concat"};
+    QVector<LayerEdge> layerLinks;
+    const bool kept = !nonChainGraph(residualLayers, graph, &layerLinks).isEmpty();
+    QStringList gotLayerEdges;
+    for (const LayerEdge& edge : layerLinks) {
+        gotLayerEdges << residualLayers[edge.from].toObject()["name"].toString() + ">" +
+                             residualLayers[edge.to].toObject()["name"].toString() + (edge.via.isEmpty() ? QString() : " " + edge.via);
+    }
+    // 纯顺序的模型没有层列表之外的信息，不保留数据流图
+    QJsonObject chainGraph;
+    const QJsonArray chainLayers = ProgramFragmentProcessor::extractPyTorchStructure(
+        "import torch\n"
+        "import torch.nn as nn\n"
+        "class Net(nn.Module):\n"
+        "    def __init__(self):\n"
+        "        super().__init__()\n"
+        "        self.fc1 = nn.Linear(4, 8)\n"
+        "        self.fc2 = nn.Linear(8, 2)\n"
+        "    def forward(self, x):\n"
+        "        return self.fc2(torch.relu(self.fc1(x)))\n",
+        nullptr, &chainGraph);
+    const bool chainDropped = !chainGraph.isEmpty() && nonChainGraph(chainLayers, chainGraph).isEmpty();
+    out << "layer-level dataflow: " << (kept && gotLayerEdges == expectedLayerEdges && chainDropped ? "ok" : "FAIL") << " ("
+        << gotLayerEdges.size() << " edges, plain chain " << (chainDropped ? "dropped" : "KEPT") << ")\n";
+    if (gotLayerEdges != expectedLayerEdges) out << "  got: " << gotLayerEdges.join(" | ") << "\n";
+
+    // 3) 约 5 万行的生成文件：2000 个模块类，每个含 Conv2d/MaxPool/LSTM/Sequential/ModuleList 与 forward
+    const int classes = 2000;
+    QStringList expected;
+    const QString source = generatedModelSource(classes, &expected);
+    const int lines = static_cast<int>(std::count(source.constData(), source.constData() + source.size(), QChar('\n')));
+
+    // 导入只解析层列表；forward() 数据流图的 JSON 另外计时
+    QJsonArray parsed, legacy;
+    const double parseMs = timeMs([&] { parsed = ProgramFragmentProcessor::extractPyTorchStructure(source); }, 1000.0);
+    const double legacyMs = timeMs([&] { legacy = legacyPyTorchStructure(source); }, 1000.0);
+    PyNameTable names;
+    std::vector<PyToken> tokens;
+    const double tokenizeMs = timeMs([&] { tokenizePython(source, names, tokens); });
+    const PyTorchModel bigModel = parsePyTorchModel(source);
+    QJsonObject bigGraph;
+    const double graphMs = timeMs([&] { bigGraph = bigModel.graph(); });
+    bool ordered = parsed.size() == expected.size();
+    for (int i = 0; ordered && i < parsed.size(); ++i) ordered = layerSignature(parsed[i].toObject()) == expected[i];
+    // 旧的正则只认字面的 nn.Linear / nn.Conv2d，只找到四分之一的层，按每找到一层的耗时比较才公平
+    const double parsePerLayer = parseMs * 1000.0 / std::max(1, static_cast<int>(parsed.size()));
+    const double legacyPerLayer = legacyMs * 1000.0 / std::max(1, static_cast<int>(legacy.size()));
+    out << lines << "-line model file (" << source.size() / 1024 << " KiB, " << static_cast<qint64>(tokens.size()) << " tokens):\n"
+        << "  parser   " << QString::number(parseMs, 'f', 1) << " ms  (tokenize " << QString::number(tokenizeMs, 'f', 1)
+        << " ms)  " << parsed.size() << "/" << expected.size() << " layers, source order "
+        << (ordered ? "ok" : "FAIL") << ", " << QString::number(parsePerLayer, 'f', 2) << " us/layer\n"
+        << "  legacy   " << QString::number(legacyMs, 'f', 1) << " ms  " << legacy.size() << "/" << expected.size()
+        << " layers (only literal nn.Linear / nn.Conv2d, grouped by type), " << QString::number(legacyPerLayer, 'f', 2)
+        << " us/layer\n"
+        << "  legacy/parser  " << QString::number(legacyMs / parseMs, 'f', 2) << "x total, "
+        << QString::number(legacyPerLayer / parsePerLayer, 'f', 2) << "x per layer found\n";
+
+    // 每个类的 forward()：输入、conv（并入 relu）、pool、lstm、2 个 extra、head 的 Linear/Dropout/Linear，8 条边
+    const int graphNodeCount = bigGraph["nodes"].toArray().size();
+    const int graphEdgeCount = bigGraph["edges"].toArray().size();
+    out << "  forward() graph " << graphNodeCount << " nodes / " << graphEdgeCount << " edges, JSON "
+        << QString::number(graphMs, 'f', 1) << " ms: "
+        << (graphNodeCount == classes * 9 && graphEdgeCount == classes * 8 ? "ok" : "FAIL") << "\n";
+
+    // 导入时间与文件大小成线性：前一半类单独导入，耗时应约为全文的一半
+    const QString half = source.left(source.indexOf(QString("class Block%1(").arg(classes / 2)));
+    const double halfMs = timeMs([&] { ProgramFragmentProcessor::extractPyTorchStructure(half); }, 1000.0);
+    out << "  scaling  half file " << QString::number(halfMs, 'f', 1) << " ms, full/half "
+        << QString::number(parseMs / halfMs, 'f', 2) << " (linear = 2.00)\n";
+
+    // 恶意输入：倍增的序列 / 字符串应耗尽执行预算，深层嵌套应按语法错误跳过该语句（后面的层照常解析），
+    // 都不能耗尽内存或栈
+    const int deep = 100000;
+    QString indented;
+    for (int i = 0; i < 5000; ++i) indented += QString(i, QChar(' ')) + "if 1:\n";
+    indented += QString(5000, QChar(' ')) + "y = 1\n";
+    struct HostileSource
+    {
+        const char* name;
+        QString source;
+        bool nested;  // 嵌套类：该语句跳过，后面的层仍要解析出来；预算类只要求有警告并及时结束
+    };
+    const QVector<HostileSource> hostile = {
+        {"[0]*65536*65536", "a = [0] * 65536\nb = a * 65536\n", false},
+        {"x = x + x", "x = [0]\nfor i in range(64):\n    x = x + x\n", false},
+        {"x += x", "x = [0]\nfor i in range(64):\n    x += x\n", false},
+        {"x.extend(x)", "x = [0]\nfor i in range(64):\n    x.extend(x)\n", false},
+        {"s = s + s", "s = 'ab'\nfor i in range(64):\n    s = s + s\n", false},
+        {"((((x))))", "y = " + QString(deep, QChar('(')) + "1" + QString(deep, QChar(')')) + "\n", true},
+        {"[[[[x]]]]", "y = " + QString(deep, QChar('[')) + "1" + QString(deep, QChar(']')) + "\n", true},
+        {"- - - x", "y = " + QString(deep, QChar('-')) + "1\n", true},
+        {"not not x", "y = " + QString("not ").repeated(deep) + "1\n", true},
+        {"2**2**2", "y = 2" + QString("**2").repeated(deep) + "\n", true},
+        {"a if c else", "y = " + QString("1 if 1 else ").repeated(deep) + "1\n", true},
+        {"nested blocks", indented, true},
+    };
+    out << "hostile inputs:\n";
+    for (const HostileSource& test : hostile) {
+        const QString source = "import torch.nn as nn\n" + test.source + "model = nn.Linear(4, 2)\n";
+        QElapsedTimer timer;
+        timer.start();
+        const PyTorchModel model = parsePyTorchModel(source);
+        const double ms = timer.nsecsElapsed() / 1.0e6;
+        const int layers = model.layers().size();
+        const bool ok = !model.warnings.isEmpty() && ms < 2000.0 && (!test.nested || layers == 1);
+        out << "  " << QString(test.name).leftJustified(18) << QString::number(ms, 'f', 1).rightJustified(8) << " ms  "
+            << layers << " layer(s)  " << (ok ? "ok" : "FAIL") << "  " << (model.warnings.isEmpty() ? QString() : model.warnings.first())
+            << "\n";
+    }
+}
+
+void benchBulkImport(QTextStream& out) {
+    // 约 300 个模型文件（大小相差 40 倍，部分在子目录）加若干不含模型的 .py，依次：
+    // 单线程与并行无缓存、并行冷缓存（解析并写入）、热缓存、改动 10% 文件后再导入
+    const QString directory = QDir::temp().filePath("nnv-bulkimport");
+    ParseResultCache cache(QDir::temp().filePath("nnv-bulkimport-cache"));
+    QDir(directory).removeRecursively();
+    cache.clear();
+    QDir().mkpath(directory + "/nested/deeper");
+    const int modelFiles = 300, helperFiles = 12;
+    auto fileName = [&](int i) {
+        const QString sub = i % 3 == 0 ? "/nested" : i % 7 == 0 ? "/nested/deeper" : "";
+        return QString("%1%2/model_%3.py").arg(directory, sub).arg(i, 3, 10, QChar('0'));
+    };
+    auto writeFile = [](const QString& path, const QString& text) {
+        QFile file(path);
+        if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) file.write(text.toUtf8());
+    };
+    // 每个文件内容不同（缓存按内容寻址，相同内容的文件本来就会互相命中）
+    auto modelSource = [](int i) { return QString("# model %1\n").arg(i) + generatedModelSource(1 + (i * 7) % 40); };
+    for (int i = 0; i < modelFiles; ++i) writeFile(fileName(i), modelSource(i));
+    for (int i = 0; i < helperFiles; ++i)
+        writeFile(QString("%1/util_%2.py").arg(directory).arg(i), QString("def helper(x):\n    return x * %1\n").arg(i));
+
+    ThreadPool single(1);
+    const BulkImportReport serial = importModelDirectory(directory, nullptr, &single);
+    const BulkImportReport parallel = importModelDirectory(directory);
+    const BulkImportReport cold = importModelDirectory(directory, &cache);
+    const BulkImportReport warm = importModelDirectory(directory, &cache);
+
+    // 结果与逐个调用 extractPyTorchStructure 一致，缓存读出的与解析出的逐字节相同
+    bool same = cold.files.size() == modelFiles + helperFiles && warm.files.size() == cold.files.size() &&
+                serial.files.size() == cold.files.size();
+    for (int i = 0; same && i < cold.files.size(); ++i) {
+        const ImportedFile& file = cold.files[i];
+        QFile source(QDir(directory).filePath(file.path));
+        source.open(QIODevice::ReadOnly);
+        const QString code = QString::fromUtf8(source.readAll());
+        const QJsonArray expected = code.contains("torch") ? ProgramFragmentProcessor::extractPyTorchStructure(code) : QJsonArray();
+        auto bytes = [](const QJsonObject& o) { return QJsonDocument(o).toJson(QJsonDocument::Compact); };
+        same = QJsonDocument(file.layers()).toJson() == QJsonDocument(expected).toJson() &&
+               bytes(warm.files[i].result) == bytes(file.result) && bytes(serial.files[i].result) == bytes(file.result) &&
+               warm.files[i].path == file.path;
+    }
+
+    for (int i = 0; i < modelFiles; i += 10) writeFile(fileName(i), modelSource(i) + "# edited\n");
+    const BulkImportReport edited = importModelDirectory(directory, &cache);
+
+    auto line = [&](const char* label, const BulkImportReport& r) {
+        out << "  " << label << QString::number(r.totalMs, 'f', 1) << " ms  " << QString::number(r.filesPerSecond(), 'f', 0)
+            << " files/s  cache hits " << r.cacheHits << "/" << r.files.size() << " ("
+            << QString::number(r.hitRate() * 100.0, 'f', 1) << "%)  " << r.threads << " threads\n";
+    };
+    out << cold.files.size() << " files (" << cold.bytes / 1024 << " KiB), " << cold.models() << " models: "
+        << (same && cold.models() == modelFiles && warm.hitRate() == 1.0 && edited.cacheHits == modelFiles + helperFiles - modelFiles / 10
+                ? "ok" : "FAIL") << "\n";
+    line("serial, no cache   ", serial);
+    line("parallel, no cache ", parallel);
+    line("parallel, cold     ", cold);
+    line("parallel, warm     ", warm);
+    line("10% files edited   ", edited);
+    out << "  parallel speedup " << QString::number(serial.totalMs / parallel.totalMs, 'f', 2) << "x, warm re-import "
+        << QString::number(cold.totalMs / warm.totalMs, 'f', 1) << "x faster than cold\n";
+
+    QDir(directory).removeRecursively();
+    cache.clear();
+}
+
+// 最小的 protobuf 编码器，用来生成 ONNX 测试模型
+void putVarint(QByteArray& out, quint64 value) {
+    while (value >= 0x80) {
+        out.append(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.append(static_cast<char>(value));
+}
+
+void putInt(QByteArray& out, int field, quint64 value) {
+    putVarint(out, quint64(field) << 3);
+    putVarint(out, value);
+}
+
+void putBytes(QByteArray& out, int field, const QByteArray& bytes) {
+    putVarint(out, (quint64(field) << 3) | 2);
+    putVarint(out, bytes.size());
+    out.append(bytes);
+}
+
+QByteArray onnxIntAttribute(const char* name, qint64 value) {
+    QByteArray attribute;
+    putBytes(attribute, 1, name);
+    putInt(attribute, 3, value);
+    putInt(attribute, 20, 2);  // INT
+    return attribute;
+}
+
+QByteArray onnxIntsAttribute(const char* name, const QVector<qint64>& values) {
+    QByteArray attribute, packed;
+    putBytes(attribute, 1, name);
+    for (qint64 v : values) putVarint(packed, v);
+    putBytes(attribute, 8, packed);
+    putInt(attribute, 20, 7);  // INTS
+    return attribute;
+}
+
+QByteArray onnxNode(const char* op, const QStringList& inputs, const QString& output, const QList<QByteArray>& attributes = {}) {
+    QByteArray node;
+    for (const QString& input : inputs) putBytes(node, 1, input.toUtf8());
+    putBytes(node, 2, output.toUtf8());
+    putBytes(node, 3, (output + "_node").toUtf8());
+    putBytes(node, 4, op);
+    for (const QByteArray& attribute : attributes) putBytes(node, 5, attribute);
+    return node;
+}
+
+// 残差网络结构的 ONNX 模型：每块 Conv→Relu→Conv→Add(跳连)→Relu，最后 Flatten→Dropout→Gemm→Softmax。
+// 权重按 float 声明，raw_data 不实际写出，而是 seek 过去留下文件空洞，2 GB 的模型几乎不占磁盘也不用生成数据
+bool writeOnnxModel(const QString& path, int blocks, int channels, int classes) {
+    struct Tensor { QByteArray header; qint64 payload; };
+    QByteArray nodes;
+    QVector<Tensor> tensors;
+    auto weight = [&](const QString& name, const QVector<qint64>& dims) {
+        Tensor tensor;
+        qint64 elements = 1;
+        for (qint64 d : dims) {
+            putInt(tensor.header, 1, d);  // proto2 的 repeated int64 默认不打包
+            elements *= d;
+        }
+        putInt(tensor.header, 2, 1);  // FLOAT
+        putBytes(tensor.header, 8, name.toUtf8());
+        tensor.payload = elements * 4;
+        putVarint(tensor.header, (9 << 3) | 2);
+        putVarint(tensor.header, tensor.payload);
+        tensors.append(tensor);
+    };
+    QString x = "input";
+    for (int b = 0; b < blocks; ++b) {
+        const QString p = QString("b%1_").arg(b);
+        for (int k = 1; k <= 2; ++k) weight(p + "w" + QString::number(k), {channels, channels, 3, 3});
+        putBytes(nodes, 1, onnxNode("Conv", {x, p + "w1"}, p + "conv1", {onnxIntsAttribute("kernel_shape", {3, 3}), onnxIntsAttribute("pads", {1, 1, 1, 1})}));
+        putBytes(nodes, 1, onnxNode("Relu", {p + "conv1"}, p + "relu1"));
+        putBytes(nodes, 1, onnxNode("Conv", {p + "relu1", p + "w2"}, p + "conv2", {onnxIntsAttribute("kernel_shape", {3, 3})}));
+        putBytes(nodes, 1, onnxNode("Add", {p + "conv2", x}, p + "add"));
+        putBytes(nodes, 1, onnxNode("Relu", {p + "add"}, p + "out"));
+        x = p + "out";
+    }
+    weight("fc_w", {classes, channels});
+    putBytes(nodes, 1, onnxNode("Flatten", {x}, "flat", {onnxIntAttribute("axis", 1)}));
+    putBytes(nodes, 1, onnxNode("Dropout", {"flat", ""}, "drop"));
+    putBytes(nodes, 1, onnxNode("Gemm", {"drop", "fc_w"}, "logits", {onnxIntAttribute("transB", 1)}));
+    putBytes(nodes, 1, onnxNode("Softmax", {"logits"}, "probs"));
+
+    // 旧版导出器把权重也列为图输入，导入时应剔除
+    QByteArray io;
+    for (const char* name : {"input", "fc_w"}) {
+        QByteArray value;
+        putBytes(value, 1, name);
+        putBytes(io, 11, value);
+    }
+    QByteArray output;
+    putBytes(output, 1, "probs");
+    putBytes(io, 12, output);
+
+    QByteArray graphName;
+    putBytes(graphName, 2, "resnet");
+    qint64 graphLength = nodes.size() + graphName.size() + io.size();
+    QVector<QByteArray> prefixes;
+    for (const Tensor& tensor : tensors) {
+        QByteArray prefix;
+        putVarint(prefix, (5 << 3) | 2);
+        putVarint(prefix, tensor.header.size() + tensor.payload);
+        prefixes.append(prefix);
+        graphLength += prefix.size() + tensor.header.size() + tensor.payload;
+    }
+    QByteArray head, opset;
+    putInt(head, 1, 8);
+    putBytes(head, 2, "nnv-benchmark");
+    putInt(opset, 2, 17);
+    putBytes(head, 8, opset);
+    putVarint(head, (7 << 3) | 2);
+    putVarint(head, graphLength);
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+    file.write(head);
+    file.write(nodes);
+    file.write(graphName);
+    qint64 position = head.size() + nodes.size() + graphName.size();
+    for (int i = 0; i < tensors.size(); ++i) {
+        file.write(prefixes[i]);
+        file.write(tensors[i].header);
+        position += prefixes[i].size() + tensors[i].header.size() + tensors[i].payload;
+        file.seek(position);
+    }
+    file.write(io);
+    return file.resize(position + io.size());
+}
+
+void benchOnnx(QTextStream& out) {
+    // 800 个卷积共约 1.9 GB 权重、2000 多个节点的模型，与节点相同、权重小 64 倍的模型对比打开时间：
+    // 打开只扫描字段头，耗时应与权重大小无关
+    const QString bigPath = QDir::temp().filePath("nnv-bench-large.onnx");
+    const QString smallPath = QDir::temp().filePath("nnv-bench-small.onnx");
+    const int blocks = 400, classes = 1000;
+    if (!writeOnnxModel(bigPath, blocks, 256, classes) || !writeOnnxModel(smallPath, blocks, 32, classes)) {
+        out << "cannot write test models\n";
+        return;
+    }
+
+    auto openTimed = [](OnnxModel& model, const QString& path, double* ms, QString* error) {
+        QElapsedTimer timer;
+        timer.start();
+        const bool ok = model.open(path, error);
+        *ms = timer.nsecsElapsed() / 1.0e6;
+        return ok;
+    };
+    OnnxModel big, small;
+    QString error;
+    double bigMs = 0.0, smallMs = 0.0;
+    if (!openTimed(big, bigPath, &bigMs, &error) || !openTimed(small, smallPath, &smallMs, &error)) {
+        out << "open failed: " << error << "\n";
+        return;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    const QJsonArray layers = big.layers();
+    const QJsonObject graph = big.graph();
+    const double mapMs = timer.nsecsElapsed() / 1.0e6;
+
+    // 层：每块两个 Conv2d（第一个并入 relu），加 Flatten、Dropout、Dense（并入 softmax）；
+    // 图：输入 + 每块 conv1、conv2、add、relu + 3 个层，边每块 5 条，共享的 fc_w 不算图输入
+    const QJsonArray nodes = graph["nodes"].toArray();
+    const QJsonArray edges = graph["edges"].toArray();
+    const QJsonObject firstConv = layers[0].toObject();
+    const QJsonObject dense = layers[layers.size() - 1].toObject();
+    bool initializersOk = big.initializers().size() == 2 * blocks + 1;
+    for (const OnnxInitializer& tensor : big.initializers()) {
+        initializersOk = initializersOk && tensor.byteSize == tensor.elementCount() * 4 && tensor.offset > 0 &&
+                         tensor.offset + tensor.byteSize <= big.fileSize();
+    }
+    const bool ok = initializersOk && big.nodes().size() == 5 * blocks + 4 && big.graphInputs().size() == 1 &&
+                    big.opsetVersion() == 17 && big.graphName() == "resnet" && layers.size() == 2 * blocks + 3 &&
+                    firstConv["layerType"].toString() == "Conv2d" && firstConv["filters"].toInt() == 256 &&
+                    firstConv["kernelSize"].toInt() == 3 && firstConv["activationFunction"].toString() == "relu" &&
+                    layers[1].toObject()["activationFunction"].toString().isEmpty() &&
+                    layers[layers.size() - 2].toObject()["layerType"].toString() == "Dropout" &&
+                    dense["layerType"].toString() == "Dense" && dense["neurons"].toInt() == classes &&
+                    dense["inputSize"].toInt() == 256 && dense["activationFunction"].toString() == "softmax" &&
+                    nodes.size() == 1 + 4 * blocks + 3 && edges.size() == 5 * blocks + 3 &&
+                    nodes[4].toObject()["op"].toString() == "activation" && nodes[3].toObject()["op"].toString() == "add" &&
+                    graph["outputs"].toArray().size() == 1 && graph["outputs"].toArray()[0].toInt() == nodes.size() - 1;
+
+    // 截断或非 ONNX 的文件应报错而不是越界
+    QFile source(smallPath);
+    source.open(QIODevice::ReadOnly);
+    const QByteArray head = source.readAll().left(4096);
+    source.close();
+    const QString brokenPath = QDir::temp().filePath("nnv-bench-broken.onnx");
+    QFile broken(brokenPath);
+    broken.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    broken.write(head);
+    broken.close();
+    OnnxModel rejected;
+    QString truncatedError;
+    const bool truncatedRejected = !rejected.open(brokenPath, &truncatedError) && !rejected.isOpen();
+
+    out << big.nodes().size() << " nodes, " << big.initializers().size() << " initializers, "
+        << QString::number(big.initializerBytes() / 1073741824.0, 'f', 2) << " GiB weights in a "
+        << QString::number(big.fileSize() / 1073741824.0, 'f', 2) << " GiB file: " << (ok ? "ok" : "FAIL") << "\n";
+    out << "  open " << QString::number(bigMs, 'f', 1) << " ms (same graph with "
+        << QString::number(small.initializerBytes() / 1048576.0, 'f', 0) << " MiB weights: "
+        << QString::number(smallMs, 'f', 1) << " ms), layers + graph " << QString::number(mapMs, 'f', 1) << " ms, "
+        << layers.size() << " layers, " << nodes.size() << " graph nodes\n";
+    out << "  truncated file rejected: " << (truncatedRejected ? "ok" : "FAIL") << " (" << truncatedError << ")\n";
+
+    big.close();
+    small.close();
+    QFile::remove(bigPath);
+    QFile::remove(smallPath);
+    QFile::remove(brokenPath);
+}
+
+// torchvision resnet152() 的 print(model) 输出
+QString resnet152Repr() {
+    QString text = "ResNet(\n"
+                   "  (conv1): Conv2d(3, 64, kernel_size=(7, 7), stride=(2, 2), padding=(3, 3), bias=False)\n"
+                   "  (bn1): BatchNorm2d(64, eps=1e-05, momentum=0.1, affine=True, track_running_stats=True)\n"
+                   "  (relu): ReLU(inplace=True)\n"
+                   "  (maxpool): MaxPool2d(kernel_size=3, stride=2, padding=1, dilation=1, ceil_mode=False)\n";
+    const int blocks[] = {3, 8, 36, 3};
+    int inplanes = 64;
+    for (int stage = 0; stage < 4; ++stage) {
+        const int planes = 64 << stage;
+        text += QString("  (layer%1): Sequential(\n").arg(stage + 1);
+        for (int b = 0; b < blocks[stage]; ++b) {
+            const int stride = stage > 0 && b == 0 ? 2 : 1;
+            auto bn = [](int c) {
+                return QString("BatchNorm2d(%1, eps=1e-05, momentum=0.1, affine=True, track_running_stats=True)").arg(c);
+            };
+            text += QString("    (%1): Bottleneck(\n").arg(b);
+            text += QString("      (conv1): Conv2d(%1, %2, kernel_size=(1, 1), stride=(1, 1), bias=False)\n").arg(inplanes).arg(planes);
+            text += QString("      (bn1): %1\n").arg(bn(planes));
+            text += QString("      (conv2): Conv2d(%1, %1, kernel_size=(3, 3), stride=(%2, %2), padding=(1, 1), bias=False)\n")
+                        .arg(planes)
+                        .arg(stride);
+            text += QString("      (bn2): %1\n").arg(bn(planes));
+            text += QString("      (conv3): Conv2d(%1, %2, kernel_size=(1, 1), stride=(1, 1), bias=False)\n").arg(planes).arg(planes * 4);
+            text += QString("      (bn3): %1\n").arg(bn(planes * 4));
+            text += "      (relu): ReLU(inplace=True)\n";
+            if (b == 0) {
+                text += "      (downsample): Sequential(\n";
+                text += QString("        (0): Conv2d(%1, %2, kernel_size=(1, 1), stride=(%3, %3), bias=False)\n")
+                            .arg(inplanes)
+                            .arg(planes * 4)
+                            .arg(stride);
+                text += QString("        (1): %1\n").arg(bn(planes * 4));
+                text += "      )\n";
+            }
+            text += "    )\n";
+            inplanes = planes * 4;
+        }
+        text += "  )\n";
+    }
+    text += "  (avgpool): AdaptiveAvgPool2d(output_size=(1, 1))\n"
+            "  (fc): Linear(in_features=2048, out_features=1000, bias=True)\n"
+            ")";
+    return text;
+}
+
+// 48 层 GPT 风格 Transformer 的 print(model) 输出；folded 时用 PyTorch 2 的 "(0-47): 48 x Block(" 折叠重复块
+QString transformerRepr(int depth, bool folded) {
+    const QString norm = "LayerNorm((768,), eps=1e-05, elementwise_affine=True)";
+    auto block = [&](const QString& key, const QString& indent) {
+        return indent + key + "Block(\n" +
+               indent + "  (ln1): " + norm + "\n" +
+               indent + "  (attn): CausalSelfAttention(\n" +
+               indent + "    (qkv): Linear(in_features=768, out_features=2304, bias=True)\n" +
+               indent + "    (proj): Linear(in_features=768, out_features=768, bias=True)\n" +
+               indent + "    (attn_drop): Dropout(p=0.1, inplace=False)\n" +
+               indent + "  )\n" +
+               indent + "  (ln2): " + norm + "\n" +
+               indent + "  (mlp): Sequential(\n" +
+               indent + "    (0): Linear(in_features=768, out_features=3072, bias=True)\n" +
+               indent + "    (1): GELU(approximate='none')\n" +
+               indent + "    (2): Linear(in_features=3072, out_features=768, bias=True)\n" +
+               indent + "    (3): Dropout(p=0.1, inplace=False)\n" +
+               indent + "  )\n" +
+               indent + ")\n";
+    };
+    QString text = "GPT(\n"
+                   "  (tok_emb): Embedding(50257, 768)\n"
+                   "  (pos_emb): Embedding(1024, 768)\n"
+                   "  (drop): Dropout(p=0.1, inplace=False)\n"
+                   "  (blocks): ModuleList(\n";
+    if (folded) {
+        text += block(QString("(0-%1): %2 x ").arg(depth - 1).arg(depth), "    ");
+    } else {
+        for (int i = 0; i < depth; ++i) text += block(QString("(%1): ").arg(i), "    ");
+    }
+    text += "  )\n"
+            "  (ln_f): " + norm + "\n"
+            "  (head): Linear(in_features=768, out_features=50257, bias=False)\n"
+            ")\n";
+    return text;
+}
+
+void benchModuleRepr(QTextStream& out) {
+    // 1) ResNet-152：155 个卷积 + maxpool + fc，relu 按注册顺序并入前一个卷积；
+    //    分组 = 4 个 stage + 50 个 Bottleneck + 4 个 downsample
+    const QString resnet = resnet152Repr();
+    const ModuleRepr resnetModel = parseModuleRepr(resnet);
+    int convs = 0;
+    for (const QJsonValue& v : resnetModel.layers) convs += v.toObject()["layerType"].toString() == "Conv2d";
+    const QJsonObject stem = resnetModel.layers[0].toObject();
+    const QJsonObject fc = resnetModel.layers[resnetModel.layers.size() - 1].toObject();
+    const ModuleGroup* deepest = nullptr;
+    for (const ModuleGroup& g : resnetModel.groups) {
+        if (g.path == "layer3.35") deepest = &g;
+    }
+    const QJsonObject lastConv3 = deepest ? resnetModel.layers[deepest->first + 2].toObject() : QJsonObject();
+    const bool resnetOk = resnetModel.error.isEmpty() && resnetModel.rootType == "ResNet" && convs == 155 &&
+                          resnetModel.layers.size() == 157 && resnetModel.groups.size() == 58 &&
+                          stem["kernelSize"].toInt() == 7 && stem["filters"].toInt() == 64 &&
+                          stem["activationFunction"].toString() == "relu" && fc["layerType"].toString() == "Dense" &&
+                          fc["neurons"].toInt() == 1000 && fc["inputSize"].toInt() == 2048 && deepest &&
+                          deepest->count == 3 && deepest->depth == 2 && lastConv3["name"].toString() == "layer3.35.conv3" &&
+                          lastConv3["activationFunction"].toString() == "relu" && looksLikeModuleRepr(resnet);
+
+    // 2) 48 层 Transformer：折叠与逐块展开的两种打印得到相同的层与分组
+    const int depth = 48;
+    const QString expanded = transformerRepr(depth, false);
+    const QString folded = transformerRepr(depth, true);
+    const ModuleRepr expandedModel = parseModuleRepr(expanded);
+    const ModuleRepr foldedModel = parseModuleRepr(folded);
+    const bool transformerOk =
+        expandedModel.error.isEmpty() && foldedModel.error.isEmpty() && expandedModel.layers.size() == 2 + 6 * depth &&
+        QJsonDocument(expandedModel.layers).toJson() == QJsonDocument(foldedModel.layers).toJson() &&
+        QJsonDocument(expandedModel.groupsJson()).toJson() == QJsonDocument(foldedModel.groupsJson()).toJson() &&
+        expandedModel.modules == foldedModel.modules && expandedModel.groups.size() == 1 + 3 * depth &&
+        foldedModel.layers[foldedModel.layers.size() - 2].toObject()["name"].toString() == "blocks.47.mlp.3" &&
+        foldedModel.warnings.join('|').contains("GELU");
+
+    // 3) 截断的文本：报出未闭合模块所在的行，已解析的层保留；普通 Python 代码不会被当成 repr
+    const QString truncated = resnet.left(resnet.indexOf("(layer3)"));
+    const ModuleRepr partial = parseModuleRepr(truncated);
+    QJsonObject fragment;
+    fragment["language"] = "python";
+    fragment["action"] = "extract-structure";
+    fragment["code"] = resnet;
+    const QJsonObject processed = ProgramFragmentProcessor::processFragment(fragment);
+    const bool edgeOk = !partial.error.isEmpty() && partial.error.startsWith("第 1 行") && partial.layers.size() > 10 &&
+                        processed["format"].toString() == "module-repr" &&
+                        processed["networkStructure"].toArray().size() == 157 &&
+                        !looksLikeModuleRepr(generatedModelSource(3)) && !looksLikeModuleRepr("print(model)\n") &&
+                        looksLikeModuleRepr("Linear(in_features=3, out_features=4, bias=True)");
+    out << "ResNet-152: " << (resnetOk ? "ok" : "FAIL") << " (" << resnetModel.modules << " modules, "
+        << resnetModel.layers.size() << " layers, " << resnetModel.groups.size() << " groups)\n";
+    out << "transformer x" << depth << " folded == expanded: " << (transformerOk ? "ok" : "FAIL") << " ("
+        << foldedModel.modules << " modules, " << foldedModel.layers.size() << " layers)\n";
+    out << "truncated / detection / processFragment: " << (edgeOk ? "ok" : "FAIL") << " (" << partial.error << ")\n";
+
+    // 4) 恶意的重复次数：超长的数字、超出 int 的区间、嵌套相乘、没有层的重复模块，都应及时报错，不溢出也不耗尽内存
+    const QString linear = "Linear(in_features=4, out_features=4, bias=True)";
+    auto repeated = [](const QString& count, const QString& inner) {
+        return "(0-" + count + "): " + count + " x " + inner;
+    };
+    auto nested = [&](const QString& name, const QString& count, const QString& leaf) {
+        return "  (" + name + "): ModuleList(\n    " +
+               repeated(count, "Block(\n      (layers): ModuleList(\n        " + repeated(count, leaf) + "\n      )\n    )") +
+               "\n  )\n";
+    };
+    struct HostileRepr
+    {
+        const char* name;
+        QString text;
+    };
+    const QVector<HostileRepr> hostileRepr = {
+        {"20-digit count", "Net(\n  (blocks): ModuleList(\n    (0): 99999999999999999999 x " + linear + "\n  )\n)\n"},
+        {"(0-2147483647)", "Net(\n  (blocks): ModuleList(\n    (0-2147483647): " + linear + "\n  )\n)\n"},
+        {"1100 x 1100 Linear", "Net(\n" + nested("blocks", "1100", linear) + ")\n"},
+        {"2000 x 2000 Identity", "Net(\n" + nested("blocks", "2000", "Identity()") + ")\n"},
+        {"4 x (520 x 520)", "Net(\n" + nested("a", "520", linear) + nested("b", "520", linear) + nested("c", "520", linear) +
+                                nested("d", "520", linear) + ")\n"},
+    };
+    out << "hostile repeat counts:\n";
+    for (const HostileRepr& test : hostileRepr) {
+        QElapsedTimer timer;
+        timer.start();
+        const ModuleRepr model = parseModuleRepr(test.text);
+        const double ms = timer.nsecsElapsed() / 1.0e6;
+        const bool ok = !model.error.isEmpty() && model.layers.size() <= (1 << 20) && ms < 2000.0;
+        out << "  " << QString(test.name).leftJustified(22) << QString::number(ms, 'f', 1).rightJustified(8) << " ms  "
+            << model.layers.size() << " layers  " << (ok ? "ok" : "FAIL") << "  " << model.error << "\n";
+    }
+
+    auto timeParse = [&](const char* label, const QString& text) {
+        const int runs = 200;
+        QElapsedTimer timer;
+        timer.start();
+        int layers = 0;
+        for (int r = 0; r < runs; ++r) layers += parseModuleRepr(text).layers.size();
+        const double ms = timer.nsecsElapsed() / 1.0e6 / runs;
+        out << "  " << label << QString::number(text.size() / 1024.0, 'f', 1) << " KiB: " << QString::number(ms, 'f', 3)
+            << " ms  (" << QString::number(text.size() / ms / 1000.0, 'f', 1) << " MB/s, " << layers / runs << " layers)\n";
+    };
+    timeParse("ResNet-152            ", resnet);
+    timeParse("transformer, expanded ", expanded);
+    timeParse("transformer, folded   ", folded);
+}
+
+// torch.profiler 风格的一个事件（Kineto 导出格式：每个事件一行，键的顺序 ph/cat/name/pid/tid/ts/dur/args）
+void appendTraceEvent(QByteArray& out, const char* phase, const char* category, const QByteArray& name, int tid, double ts,
+                      double dur, const QByteArray& args) {
+    out += "  {\"ph\": \"";
+    out += phase;
+    out += "\", \"cat\": \"";
+    out += category;
+    out += "\", \"name\": \"";
+    out += name;
+    out += "\", \"pid\": 4242, \"tid\": ";
+    out += QByteArray::number(tid);
+    out += ", \"ts\": ";
+    out += QByteArray::number(ts, 'f', 3);
+    if (dur >= 0.0) {
+        out += ", \"dur\": ";
+        out += QByteArray::number(dur, 'f', 3);
+    }
+    if (!args.isEmpty()) {
+        out += ", \"args\": ";
+        out += args;
+    }
+    out += "},\n";
+}
+
+QByteArray memoryArgs(qint64 bytes) {
+    return "{\"Total Reserved\": 2097152, \"Total Allocated\": 1048576, \"Bytes\": " + QByteArray::number(double(bytes), 'f', 0) +
+           ", \"Addr\": 94371840, \"Device Id\": -1, \"Device Type\": 0}";
+}
+
+QByteArray opArgs(int externalId) {
+    return "{\"External id\": " + QByteArray::number(externalId) +
+           ", \"Record function id\": 0, \"Concrete Inputs\": [\"\", \"\", \"\", \"[1, 1]\", \"[1, 1]\", \"[1, 1]\", \"False\", \"[0, 0]\", \"1\"], "
+           "\"Input type\": [\"float\", \"float\", \"float\", \"ScalarList\", \"ScalarList\", \"ScalarList\", \"Scalar\", \"ScalarList\", \"Scalar\"], "
+           "\"Input Strides\": [[200704, 3136, 56, 1], [576, 9, 3, 1], [1], [], [], [], [], [], []], "
+           "\"Input Dims\": [[32, 64, 56, 56], [64, 64, 3, 3], [64], [], [], [], [], [], []], \"Ev Idx\": " +
+           QByteArray::number(externalId) + "}";
+}
+
+// 合成的追踪：每步 Net_0 里依次执行 blocks 个 Conv2d_k（内含三层 aten 调用与一次 +/- 内存事件）和 ReLU_k，
+// 写到约 targetBytes 为止。返回步数，各作用域的期望值可由常量算出
+int writeSyntheticTrace(const QString& path, int blocks, qint64 targetBytes) {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return 0;
+    QByteArray chunk = "{\"schemaVersion\": 1, \"deviceProperties\": [{\"id\": 0, \"name\": \"cpu\", \"totalGlobalMem\": 0}],\n"
+                       "\"traceEvents\": [\n";
+    const double blockUs = 112.0;
+    const double stepUs = blocks * blockUs + 50.0;
+    qint64 written = 0;
+    int steps = 0;
+    int externalId = 0;
+    while (written + chunk.size() < targetBytes) {
+        const double t0 = 1700000000000.0 + steps * stepUs;
+        const int tid = 100 + steps % 2;  // 前向在两个线程间交替，两者互不嵌套
+        appendTraceEvent(chunk, "X", "user_annotation", "ProfilerStep#" + QByteArray::number(steps), tid, t0, stepUs - 1.0, "{}");
+        appendTraceEvent(chunk, "X", "python_function", "nn.Module: Net_0", tid, t0 + 0.5, blocks * blockUs + 2.0,
+                         "{\"Python id\": 7, \"Python module id\": 0}");
+        for (int k = 0; k < blocks; ++k) {
+            const double cs = t0 + 1.5 + k * blockUs;
+            const QByteArray conv = "nn.Module: Conv2d_" + QByteArray::number(k);
+            appendTraceEvent(chunk, "X", "python_function", conv, tid, cs, 100.5, "{\"Python id\": 9}");
+            appendTraceEvent(chunk, "X", "cpu_op", "aten::conv2d", tid, cs + 0.5, 99.0, opArgs(++externalId));
+            appendTraceEvent(chunk, "X", "cpu_op", "aten::convolution", tid, cs + 1.0, 97.0, opArgs(externalId));
+            appendTraceEvent(chunk, "i", "cpu_instant_event", "[memory]", tid, cs + 2.0, -1.0, memoryArgs(4096 * (k + 1)));
+            appendTraceEvent(chunk, "X", "cpu_op", "aten::_convolution", tid, cs + 1.5, 95.0, opArgs(externalId));
+            appendTraceEvent(chunk, "i", "cpu_instant_event", "[memory]", tid, cs + 90.0, -1.0, memoryArgs(-2048));
+            appendTraceEvent(chunk, "X", "python_function", "nn.Module: ReLU_" + QByteArray::number(k), tid, cs + 101.0, 10.25, "{}");
+            appendTraceEvent(chunk, "X", "cpu_op", "aten::relu", tid, cs + 101.5, 9.0, opArgs(++externalId));
+        }
+        ++steps;
+        if (chunk.size() > (8 << 20)) {
+            written += file.write(chunk);
+            chunk.resize(0);
+        }
+    }
+    // 最后一个事件之后不能有逗号
+    chunk += "  {\"ph\": \"M\", \"name\": \"process_name\", \"pid\": 4242, \"tid\": 0, \"args\": {\"name\": \"python \\\"train\\\" \\u00e9\\ud83d\\ude00\"}}\n"
+             "], \"traceName\": \"bench\"}\n";
+    file.write(chunk);
+    return steps;
+}
+
+void benchTrace(QTextStream& out) {
+    // 1) 读取器本身：转义与代理对、数字格式、各种结构错误
+    {
+        JsonStreamReader reader(QByteArray("{\"a\\\"b\": [\"\\u00e9\\ud83d\\ude00\\n\", -1.5e3, 0, true, null, {}], \"c\": {\"d\": [1, [2]]}, \"e\": 7}"));
+        bool ok = reader.next() == JsonStreamReader::BeginObject && reader.next() == JsonStreamReader::Key &&
+                  reader.textEquals("a\"b") && reader.next() == JsonStreamReader::BeginArray &&
+                  reader.next() == JsonStreamReader::String && reader.utf8() == QByteArray("\xc3\xa9\xf0\x9f\x98\x80\n") &&
+                  reader.next() == JsonStreamReader::Number && reader.number() == -1500.0 &&
+                  reader.next() == JsonStreamReader::Number && reader.number() == 0.0 &&
+                  reader.next() == JsonStreamReader::Bool && reader.boolean() && reader.next() == JsonStreamReader::Null &&
+                  reader.next() == JsonStreamReader::BeginObject && reader.next() == JsonStreamReader::EndObject &&
+                  reader.next() == JsonStreamReader::EndArray && reader.next() == JsonStreamReader::Key && reader.skipValue() &&
+                  reader.next() == JsonStreamReader::Key && reader.textEquals("e") &&
+                  reader.next() == JsonStreamReader::Number && reader.number() == 7.0 &&
+                  reader.next() == JsonStreamReader::EndObject && reader.next() == JsonStreamReader::EndOfDocument;
+        const char* invalid[] = {"[1,]", "{\"a\" 1}", "[01]", "[1 2]", "{\"a\": 1", "[\"x]", "[1.]", "[-]", "{} {}",
+                                 "[\"\\ud83d\"]", "[tru]", "{\"a\": [}]", "[\"\t\"]", "", "{1: 2}"};
+        int rejected = 0;
+        for (const char* text : invalid) {
+            JsonStreamReader bad{QByteArray(text)};
+            JsonStreamReader::Token token;
+            while ((token = bad.next()) != JsonStreamReader::Invalid && token != JsonStreamReader::EndOfDocument) {}
+            rejected += token == JsonStreamReader::Invalid && bad.hasError();
+        }
+        const int total = int(sizeof invalid / sizeof invalid[0]);
+        out << "reader tokens / escapes: " << (ok ? "ok" : "FAIL") << "  malformed rejected: "
+            << (rejected == total ? "ok" : "FAIL") << " (" << rejected << "/" << total << ")\n";
+    }
+
+    // 2) 小追踪：事件乱序、作用域嵌套、record_function 标注、字符串 tid 的 GPU 事件
+    const QString smallPath = QDir::temp().filePath("nnv_bench_trace_small.json");
+    {
+        QFile file(smallPath);
+        file.open(QIODevice::WriteOnly);
+        QByteArray text = "{\"deviceProperties\": [], \"traceEvents\": [\n";
+        appendTraceEvent(text, "X", "python_function", "nn.Module: Linear_1", 1, 300, 400, "{}");
+        appendTraceEvent(text, "X", "user_annotation", "ProfilerStep#0", 1, 0, 1000, "{}");
+        appendTraceEvent(text, "X", "python_function", "nn.Module: Net_0", 1, 10, 890, "{}");
+        appendTraceEvent(text, "X", "python_function", "nn.Module: Linear_0", 1, 20, 200, "{}");
+        appendTraceEvent(text, "X", "cpu_op", "aten::linear \\\"x\\\" \\u2192 y", 1, 21, 190, opArgs(1));
+        appendTraceEvent(text, "i", "cpu_instant_event", "[memory]", 1, 50, -1, memoryArgs(4096));
+        appendTraceEvent(text, "X", "python_function", "nn.Module: ReLU_0", 1, 230, 30, "{}");
+        appendTraceEvent(text, "i", "cpu_instant_event", "[memory]", 1, 400, -1, memoryArgs(1000));
+        appendTraceEvent(text, "i", "cpu_instant_event", "[memory]", 1, 450, -1, memoryArgs(-500));
+        appendTraceEvent(text, "X", "user_annotation", "head.fc", 1, 710, 50, "{}");
+        appendTraceEvent(text, "i", "cpu_instant_event", "[memory]", 1, 800, -1, memoryArgs(64));
+        text += "  {\"ph\": \"X\", \"cat\": \"kernel\", \"name\": \"gemm\", \"pid\": 0, \"tid\": \"stream 7\", \"ts\": 30, \"dur\": 5}\n]}";
+        file.write(text);
+    }
+    TraceProfile small;
+    QString error;
+    const bool smallLoaded = loadChromeTrace(smallPath, &small, &error);
+    auto scope = [&](const TraceProfile& profile, const QString& name) -> const TraceScope* {
+        for (const TraceScope& s : profile.scopes) {
+            if (s.name == name) return &s;
+        }
+        return nullptr;
+    };
+    const TraceScope* net = scope(small, "Net_0");
+    const TraceScope* fc0 = scope(small, "Linear_0");
+    const TraceScope* fc1 = scope(small, "Linear_1");
+    const TraceScope* head = scope(small, "head.fc");
+    QList<NeuralLayer> layers;
+    for (int i = 0; i < 3; ++i) {
+        NeuralLayer layer;
+        layer.layerType = "Dense";
+        layer.neurons = 10;
+        layers.append(layer);
+    }
+    const QVector<int> match = matchTraceScopes(small, layers, {"fc1", "", "head.fc"});
+    const bool smallOk = smallLoaded && small.events == 12 && small.scopes.size() == 5 && small.threads == 1 && net && fc0 &&
+                         fc1 && head && net->totalUs == 890.0 && net->selfUs == 210.0 && fc0->selfUs == 200.0 &&
+                         fc1->selfUs == 400.0 && fc0->selfAllocatedBytes == 4096 && fc1->selfAllocatedBytes == 1000 &&
+                         net->selfAllocatedBytes == 64 && net->totalAllocatedBytes == 5160 && fc0->moduleType == "Linear" &&
+                         fc1->instance == 1 && head->moduleType.isEmpty() && small.scopes[0].name == "Net_0" &&
+                         match.size() == 3 && match[0] >= 0 && small.scopes[match[0]].name == "Linear_0" && match[1] >= 0 &&
+                         small.scopes[match[1]].name == "Linear_1" && match[2] >= 0 && small.scopes[match[2]].name == "head.fc";
+    out << "small trace self/total/memory/matching: " << (smallOk ? "ok" : "FAIL") << (smallLoaded ? "" : " " + error) << "\n";
+
+    // 截断的文件报出字节位置
+    {
+        QFile file(smallPath);
+        file.open(QIODevice::ReadOnly);
+        const QByteArray text = file.readAll();
+        file.close();
+        QFile truncated(smallPath);
+        truncated.open(QIODevice::WriteOnly);
+        truncated.write(text.left(text.size() / 2));
+    }
+    TraceProfile partial;
+    const bool truncatedRejected = !loadChromeTrace(smallPath, &partial, &error) && error.startsWith("第 ");
+    out << "truncated trace: " << (truncatedRejected ? "ok" : "FAIL") << " (" << error << ")\n";
+    QFile::remove(smallPath);
+
+    // 3) 约 512 MB 的追踪：逐块读入，只保留作用域与内存事件；对比各作用域与按构造算出的期望值
+    const QString path = QDir::temp().filePath("nnv_bench_trace.json");
+    const int blocks = 64;
+    const int steps = writeSyntheticTrace(path, blocks, qint64(512) << 20);
+    QElapsedTimer timer;
+    timer.start();
+    TraceProfile profile;
+    const bool loaded = loadChromeTrace(path, &profile, &error);
+    const double loadMs = timer.nsecsElapsed() / 1.0e6;
+    QFile::remove(path);
+
+    const TraceScope* root = scope(profile, "Net_0");
+    const TraceScope* lastConv = scope(profile, QString("Conv2d_%1").arg(blocks - 1));
+    const TraceScope* firstRelu = scope(profile, "ReLU_0");
+    const double rootSelf = steps * (blocks * 112.0 + 2.0 - blocks * (100.5 + 10.25));
+    const bool bigOk = loaded && root && lastConv && firstRelu && root->calls == steps &&
+                       std::abs(root->selfUs - rootSelf) < 1e-3 * rootSelf && lastConv->calls == steps &&
+                       std::abs(lastConv->selfUs - steps * 100.5) < 1e-6 * steps * 100.5 &&
+                       lastConv->selfAllocatedBytes == qint64(steps) * 4096 * blocks &&
+                       root->totalAllocatedBytes == qint64(steps) * 4096 * blocks * (blocks + 1) / 2 &&
+                       root->selfAllocatedBytes == 0 && std::abs(firstRelu->totalUs - steps * 10.25) < 1e-6 * steps * 10.25 &&
+                       profile.scopes.size() == 1 + 2 * blocks && profile.threads == 2 &&
+                       profile.events == qint64(steps) * (2 + 8 * blocks) + 1;
+    const double mb = profile.fileBytes / (1024.0 * 1024.0);
+    out << "synthetic trace " << QString::number(mb, 'f', 0) << " MB, " << profile.events << " events, " << steps
+        << " steps: " << (bigOk ? "ok" : "FAIL") << (loaded ? "" : " " + error) << "\n";
+    out << "  load " << QString::number(loadMs, 'f', 0) << " ms (" << QString::number(mb / (loadMs / 1000.0), 'f', 0)
+        << " MB/s)  read buffer 1 MiB, retained event records " << QString::number(profile.retainedBytes / (1024.0 * 1024.0), 'f', 1)
+        << " MiB (" << profile.scopeEvents << " scope + " << profile.memoryEvents << " memory events)\n";
+}
+
+// 改写前的 validateCode：逐行用正则取缩进，冒号行只与下一物理行比较，最后对全文跑层定义正则；用作计时对照
+QJsonObject legacyValidateCode(const QString& code) {
+    QJsonObject validationResult;
+    validationResult["valid"] = true;
+    QJsonArray errors;
+    QStringList lines = code.split('\n');
+    QRegularExpression indentRegex("^(\\s*)");
+    for (int i = 0; i < lines.size(); i++) {
+        QString line = lines[i].trimmed();
+        if (line.isEmpty() || line.startsWith("#")) continue;
+        QRegularExpressionMatch match = indentRegex.match(lines[i]);
+        int indent = match.captured(1).length();
+        if (indent % 4 != 0) {
+            errors.append(QString("第 %1 行：缩进必须是4个空格的倍数").arg(i + 1));
+            validationResult["valid"] = false;
+        }
+        if (line.endsWith(":") && i + 1 < lines.size()) {
+            QRegularExpressionMatch nextMatch = indentRegex.match(lines[i + 1]);
+            if (nextMatch.captured(1).length() <= indent) {
+                errors.append(QString("第 %1 行：冒号后需要增加缩进").arg(i + 1));
+                validationResult["valid"] = false;
+            }
+        }
+    }
+    if (code.contains("nn.") || code.contains("torch.")) {
+        if (!code.contains("import torch") && !code.contains("import torch.nn")) {
+            errors.append("使用PyTorch模块但未导入torch或torch.nn");
+            validationResult["valid"] = false;
+        }
+        QRegularExpression layerRegex("self\\.(conv|fc|pool|lstm|gru|rnn)\\d+\\s*=\\s*nn\\.");
+        QRegularExpressionMatchIterator it = layerRegex.globalMatch(code);
+        while (it.hasNext()) {
+            const QString layerDef = it.next().captured(0);
+            if (!layerDef.contains("(") || !layerDef.contains(")")) {
+                errors.append("层定义语法错误：缺少括号");
+                validationResult["valid"] = false;
+            }
+        }
+    }
+    validationResult["errors"] = errors;
+    return validationResult;
+}
+
+QStringList diagnosticTexts(const QVector<CodeDiagnostic>& diagnostics) {
+    QStringList texts;
+    for (const CodeDiagnostic& diagnostic : diagnostics) texts << diagnostic.text();
+    return texts;
+}
+
+QJsonObject watchLayer(const QString& name, const QString& type, int neurons) {
+    QJsonObject layer;
+    if (!name.isEmpty()) layer["name"] = name;
+    layer["layerType"] = type;
+    layer["neurons"] = neurons;
+    return layer;
+}
+
+bool writeWatchFile(const QString& path, const QByteArray& content) {
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(content) == content.size();
+}
+
+void benchWatch(QTextStream& out) {
+    // 1) 结构比较：插入、删除、修改、换序，有名称的层按名称对应，无名称的按类型依次对应
+    {
+        QJsonArray before, after;
+        for (const char* name : {"conv1", "bn1", "fc1", "fc2", "head"}) before.append(watchLayer(name, "Dense", 10));
+        after = before;
+        after.insert(2, watchLayer("drop", "Dropout", 0));           // conv1 bn1 drop fc1 fc2 head
+        after.removeAt(1);                                           // conv1 drop fc1 fc2 head
+        after.replace(3, watchLayer("fc2", "Dense", 20));            // fc2 参数改变
+        const QJsonValue fc1 = after.at(2);
+        after.removeAt(2);
+        after.insert(3, fc1);                                        // conv1 drop fc2 fc1 head
+        const LayerDiff named = diffLayers(before, after);
+        const bool namedOk = named.source == QVector<int>({0, -1, 3, 2, 4}) &&
+                             named.changed == QVector<bool>({false, false, true, false, false}) && named.inserted == 1 &&
+                             named.removed == 1 && named.updated == 1 && named.moved == 2;
+
+        QJsonArray plainBefore, plainAfter;
+        for (const char* type : {"Conv2d", "Dense", "Dense", "Dense"}) plainBefore.append(watchLayer(QString(), type, 8));
+        plainAfter = plainBefore;
+        plainAfter.insert(1, watchLayer(QString(), "Conv2d", 8));
+        plainAfter.removeAt(4);
+        const LayerDiff plain = diffLayers(plainBefore, plainAfter);
+        // 首尾对齐后只有中间一层不同：两种对齐代价相同，取不移动其余层的一种
+        const bool plainOk = plain.source == QVector<int>({0, -1, 2, 3}) && plain.inserted == 1 && plain.removed == 1 &&
+                             plain.moved == 0 && plain.updated == 0;
+        const bool sameOk = diffLayers(before, before).isEmpty() && diffLayers(QJsonArray(), before).inserted == 5 &&
+                            diffLayers(before, QJsonArray()).removed == 5;
+        out << "diff: named " << (namedOk ? "ok" : "FAIL") << " (" << named.summary() << ")  unnamed "
+            << (plainOk ? "ok" : "FAIL") << " (" << plain.summary() << ")  identity/empty " << (sameOk ? "ok" : "FAIL")
+            << "\n";
+    }
+
+    // 2) 保存一次：改动一个类中 nn.Linear 的输出维度，重新解析并比较。记录解析、比较耗时，
+    //    以及只 touch 不改内容时（哈希相同，跳过解析）的耗时；界面线程改图的部分在此无法计时
+    auto report = [&out](const QString& label, const QString& path, const QByteArray& original, const QByteArray& edited,
+                         int expectUpdated) {
+        if (!writeWatchFile(path, original)) {
+            out << label << ": cannot write\n";
+            return;
+        }
+        ParsedModelFile first = parseModelFile(path);
+        double parseMs = 0.0, diffMs = 0.0, touchMs = 0.0;
+        LayerDiff diff;
+        ParsedModelFile second;
+        for (int run = 0; run < 3; ++run) {
+            writeWatchFile(path, edited);
+            QElapsedTimer timer;
+            timer.start();
+            second = parseModelFile(path, first.hash);
+            const double p = timer.nsecsElapsed() / 1.0e6;
+            timer.restart();
+            diff = diffLayers(first.layers, second.layers);
+            const double d = timer.nsecsElapsed() / 1.0e6;
+            timer.restart();
+            const ParsedModelFile touched = parseModelFile(path, second.hash);
+            const double t = timer.nsecsElapsed() / 1.0e6;
+            const bool skipped = touched.layers.isEmpty() && touched.error.isEmpty() && touched.hash == second.hash;
+            if (run == 0 || p + d < parseMs + diffMs) {
+                parseMs = p;
+                diffMs = d;
+            }
+            touchMs = run == 0 || t < touchMs ? t : touchMs;
+            if (!skipped) touchMs = -1.0;
+        }
+        const bool ok = first.error.isEmpty() && second.error.isEmpty() && diff.updated == expectUpdated &&
+                        diff.inserted == 0 && diff.removed == 0 && diff.moved == 0;
+        out << label << ", " << QString::number(original.size() / 1024.0, 'f', 0) << " KiB, " << first.layers.size()
+            << " layers: " << (ok ? "ok" : "FAIL") << " (" << diff.summary() << ")  parse "
+            << QString::number(parseMs, 'f', 1) << " ms + diff " << QString::number(diffMs, 'f', 2) << " ms = "
+            << QString::number(parseMs + diffMs, 'f', 1) << " ms" << (parseMs + diffMs < 100.0 ? "" : " (over 100 ms)")
+            << "  unchanged save " << (touchMs < 0 ? QString("FAIL") : QString::number(touchMs, 'f', 2) + " ms") << "\n";
+        QFile::remove(path);
+    };
+
+    const QString pyPath = QDir::temp().filePath("nnv_bench_watch.py");
+    for (int classes : {40, 200, 800, 2000}) {
+        const QByteArray source = generatedModelSource(classes).toUtf8();
+        QByteArray edited = source;
+        const QByteArray from = QByteArray("class Block") + QByteArray::number(classes / 2) + "(nn.Module)";
+        const int at = edited.indexOf(from);
+        edited.replace(edited.indexOf(", 10),", at), 6, ", 12),");
+        report(QString("%1-line .py").arg(source.count('\n')), pyPath, source, edited, 1);
+    }
+
+    const QString jsonPath = QDir::temp().filePath("nnv_bench_watch.json");
+    for (int count : {1000, 20000}) {
+        QJsonArray layers;
+        for (int i = 0; i < count; ++i) {
+            QJsonObject layer = watchLayer(QString("blocks.%1.fc").arg(i), "Dense", 64 + i % 7);
+            layer["activationFunction"] = "relu";
+            layers.append(layer);
+        }
+        const QByteArray original = generateNetworkStructureJson(layers).toUtf8();
+        QJsonObject changed = layers[count / 2].toObject();
+        changed["neurons"] = 999;
+        layers.replace(count / 2, changed);
+        report(QString(".json"), jsonPath, original, generateNetworkStructureJson(layers).toUtf8(), 1);
+    }
+
+    // ONNX 不算哈希：映射、扫描节点本身就比读入整个文件快
+    const QString onnxPath = QDir::temp().filePath("nnv_bench_watch.onnx");
+    const QString onnxEdited = QDir::temp().filePath("nnv_bench_watch_edited.onnx");
+    if (writeOnnxModel(onnxPath, 400, 32, 1000) && writeOnnxModel(onnxEdited, 400, 32, 100)) {
+        const ParsedModelFile first = parseModelFile(onnxPath);
+        QElapsedTimer timer;
+        timer.start();
+        const ParsedModelFile second = parseModelFile(onnxEdited);
+        const double parseMs = timer.nsecsElapsed() / 1.0e6;
+        timer.restart();
+        const LayerDiff diff = diffLayers(first.layers, second.layers);
+        const double diffMs = timer.nsecsElapsed() / 1.0e6;
+        const bool ok = first.error.isEmpty() && second.error.isEmpty() && diff.updated == 1 && diff.inserted == 0 &&
+                        diff.removed == 0;
+        out << ".onnx, " << first.layers.size() << " layers: " << (ok ? "ok" : "FAIL") << " (" << diff.summary()
+            << ")  parse " << QString::number(parseMs, 'f', 1) << " ms + diff " << QString::number(diffMs, 'f', 2)
+            << " ms\n";
+    }
+    QFile::remove(onnxPath);
+    QFile::remove(onnxEdited);
+}
+
+struct AllocationCount {
+    qint64 calls = -1;  // -1：未打开 NNV_COUNT_ALLOCATIONS 或本平台不计数
+    qint64 bytes = 0;
+};
+
+template <typename Fn>
+AllocationCount countAllocations(Fn&& fn) {
+    AllocationCount count;
+#ifdef NNV_ALLOCATION_HOOKS
+    const qint64 calls = g_allocations.load();
+    const qint64 bytes = g_allocatedBytes.load();
+    fn();
+    count.calls = g_allocations.load() - calls;
+    count.bytes = g_allocatedBytes.load() - bytes;
+#else
+    fn();
+#endif
+    return count;
+}
+
+QString allocationText(const AllocationCount& count) {
+    if (count.calls < 0) return "allocations n/a";  // 需要 DEFINES+=NNV_COUNT_ALLOCATIONS 的构建
+    return QString("%1 allocations, %2 MB").arg(count.calls).arg(count.bytes / 1048576.0, 0, 'f', 1);
+}
+
+// 原路径：整个文档先建 QJsonDocument，再取 QJsonArray，再逐个 fromJsonObject
+QList<NeuralLayer> layersViaDom(const QByteArray& json) {
+    QList<NeuralLayer> layers;
+    for (const QJsonValue& val : parseNetworkStructure(QString::fromUtf8(json))) layers.append(NeuralLayer::fromJsonObject(val.toObject()));
+    return layers;
+}
+
+QByteArray jsonViaDom(const QList<NeuralLayer>& layers) {
+    QJsonArray array;
+    for (const NeuralLayer& layer : layers) array.append(layer.toJsonObject());
+    return generateNetworkStructureJson(array).toUtf8();
+}
+
+bool sameLayers(const QList<NeuralLayer>& a, const QList<NeuralLayer>& b) {
+    if (a.size() != b.size()) return false;
+    for (int i = 0; i < a.size(); ++i) {
+        if (a[i].layerType != b[i].layerType || a[i].neurons != b[i].neurons ||
+            a[i].activationFunction != b[i].activationFunction)
+            return false;
+    }
+    return true;
+}
+
+void benchLayerJson(QTextStream& out) {
+    // 1) 与原路径逐项对照：重复字段、缺字段、类型不符、非对象元素、重复的 layers、转义与非 ASCII 字符
+    const char* documents[] = {
+        "{\"layers\": [{\"layerType\": \"Dense\", \"neurons\": 10, \"activationFunction\": \"relu\"}]}",
+        "{\"layers\": [{\"layerType\": \"Dense\", \"neurons\": 10}, {\"neurons\": 3, \"activationFunction\": \"tanh\", \"layerType\": \"LSTM\", \"extra\": {\"a\": [1, {}]}}]}",
+        "{\"layers\": [{\"layerType\": \"A\", \"layerType\": \"B\", \"neurons\": 1, \"neurons\": 2, \"activationFunction\": \"x\"}]}",
+        "{\"layers\": [{\"layerType\": 5, \"neurons\": \"10\", \"activationFunction\": null}, {\"layerType\": [\"x\"], \"neurons\": 2.5, \"activationFunction\": {}}]}",
+        "{\"layers\": [1, \"x\", null, [], {\"layerType\": \"Conv2d\", \"neurons\": -7, \"activationFunction\": \"\"}]}",
+        "{\"layers\": [{\"layerType\": \"Dense\", \"neurons\": 1, \"activationFunction\": \"a\"}], \"layers\": [{\"layerType\": \"GRU\", \"neurons\": 2, \"activationFunction\": \"b\"}]}",
+        "{\"layers\": {\"layerType\": \"Dense\"}}",
+        "{\"name\": \"net\", \"version\": 2}",
+        "{\"meta\": {\"layers\": [1]}, \"layers\": [{\"layerType\": \"D\\u00e9nse \\\"q\\\"\\n\", \"neurons\": 1e3, \"activationFunction\": \"\\u6fc0\\u6d3b\"}]}",
+        "{\"layers\": []}",
+    };
+    int matched = 0;
+    for (const char* text : documents) {
+        QList<NeuralLayer> streamed;
+        const bool ok = readNetworkStructure(QByteArray(text), &streamed);
+        matched += ok && sameLayers(streamed, layersViaDom(QByteArray(text)));
+    }
+    // 原路径对这些文档得到空数组，流式读取报错
+    const char* invalid[] = {"[{\"layerType\": \"Dense\"}]", "{\"layers\": [{\"layerType\": \"Dense\",}]}", "{\"layers\": []} x",
+                             "{\"layers\": [", "", "{\"layers\": [1 2]}"};
+    int rejected = 0;
+    for (const char* text : invalid) {
+        QList<NeuralLayer> streamed;
+        QString error;
+        rejected += !readNetworkStructure(QByteArray(text), &streamed, &error) && streamed.isEmpty() && !error.isEmpty() &&
+                    layersViaDom(QByteArray(text)).isEmpty();
+    }
+    const int documentCount = int(sizeof documents / sizeof documents[0]);
+    const int invalidCount = int(sizeof invalid / sizeof invalid[0]);
+    out << "schema vs QJsonDocument path: " << (matched == documentCount ? "ok" : "FAIL") << " (" << matched << "/"
+        << documentCount << ")  malformed rejected: " << (rejected == invalidCount ? "ok" : "FAIL") << " (" << rejected
+        << "/" << invalidCount << ")\n";
+
+    // 2) 10 万层：读、写各与原路径对比耗时与分配次数，并互相读取对方的输出
+    const int count = 100000;
+    const char* types[] = {"Dense", "Conv2d", "MaxPooling", "LSTM", "Dropout", "GRU"};
+    const char* activations[] = {"relu", "tanh", "sigmoid", "", "softmax"};
+    QList<NeuralLayer> layers;
+    for (int i = 0; i < count; ++i) {
+        NeuralLayer layer;
+        layer.layerType = types[i % 6];
+        layer.neurons = 16 + (i * 37) % 2048;
+        layer.activationFunction = activations[i % 5];
+        layer.dropoutRate = float(i % 10) / 10.0f;
+        layer.poolingSize = 2 + i % 3;
+        layers.append(layer);
+    }
+
+    QByteArray streamedJson, domJson;
+    QList<NeuralLayer> streamedLayers, domLayers;
+    const AllocationCount writeNew = countAllocations([&] { streamedJson = networkStructureJson(layers); });
+    const AllocationCount writeOld = countAllocations([&] { domJson = jsonViaDom(layers); });
+    const AllocationCount readNew = countAllocations([&] { readNetworkStructure(streamedJson, &streamedLayers); });
+    const AllocationCount readOld = countAllocations([&] { domLayers = layersViaDom(streamedJson); });
+    QList<NeuralLayer> crossLayers;
+    const bool roundTrip = readNetworkStructure(domJson, &crossLayers) && sameLayers(crossLayers, layers) &&
+                           sameLayers(streamedLayers, layers) && sameLayers(domLayers, layers) &&
+                           sameLayers(layersViaDom(streamedJson), layers);
+
+    const double writeNewMs = timeMs([&] { streamedJson = networkStructureJson(layers); });
+    const double writeOldMs = timeMs([&] { domJson = jsonViaDom(layers); });
+    const double readNewMs = timeMs([&] { readNetworkStructure(streamedJson, &streamedLayers); });
+    const double readOldMs = timeMs([&] { domLayers = layersViaDom(streamedJson); });
+
+    // 文件：按 1 MB 分块读写，内存与文件大小无关
+    const QString path = QDir::temp().filePath("nnv_bench_layers.json");
+    double fileWriteMs = 0.0, fileReadMs = 0.0;
+    AllocationCount fileRead;
+    bool fileOk = false;
+    {
+        QFile file(path);
+        file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+        fileWriteMs = timeMs([&] {
+            file.seek(0);
+            writeNetworkStructure(&file, layers);
+        });
+        file.close();
+        QList<NeuralLayer> fromFile;
+        fileReadMs = timeMs([&] {
+            QFile input(path);
+            input.open(QIODevice::ReadOnly);
+            readNetworkStructure(&input, &fromFile);
+        });
+        QFile input(path);
+        input.open(QIODevice::ReadOnly);
+        fileRead = countAllocations([&] { fileOk = readNetworkStructure(&input, &fromFile); });
+        fileOk = fileOk && sameLayers(fromFile, layers);
+    }
+    QFile::remove(path);
+
+    const double mb = streamedJson.size() / 1048576.0;
+    out << count << " layers, " << QString::number(mb, 'f', 1) << " MB JSON, round trip both ways: "
+        << (roundTrip && fileOk ? "ok" : "FAIL") << "\n";
+    out << "  read   stream " << QString::number(readNewMs, 'f', 1) << " ms (" << QString::number(mb / readNewMs * 1000.0, 'f', 0)
+        << " MB/s, " << allocationText(readNew) << ")  QJsonDocument " << QString::number(readOldMs, 'f', 1) << " ms ("
+        << allocationText(readOld) << ")  " << QString::number(readOldMs / readNewMs, 'f', 1) << "x\n";
+    out << "  write  stream " << QString::number(writeNewMs, 'f', 1) << " ms (" << QString::number(mb / writeNewMs * 1000.0, 'f', 0)
+        << " MB/s, " << allocationText(writeNew) << ")  QJsonDocument " << QString::number(writeOldMs, 'f', 1) << " ms ("
+        << allocationText(writeOld) << ")  " << QString::number(writeOldMs / writeNewMs, 'f', 1) << "x\n";
+    out << "  file   write " << QString::number(fileWriteMs, 'f', 1) << " ms, read " << QString::number(fileReadMs, 'f', 1)
+        << " ms (" << allocationText(fileRead) << ")\n";
+}
+
+// history.json 中的一条记录，缩进与 QJsonDocument::toJson 相同；来源字段含引号、括号、逗号与反斜杠
+QByteArray historyEntryText(int index, int layers) {
+    QByteArray text = "    {\n        \"mode\": \"BlockGenerate\",\n        \"network\": {\n            \"layers\": [\n";
+    for (int l = 0; l < layers; ++l) {
+        text += "                {\n                    \"activationFunction\": \"relu\",\n"
+                "                    \"dropoutRate\": 0.5,\n                    \"layerType\": \"Dense\",\n"
+                "                    \"name\": \"blocks." + QByteArray::number(l) + ".fc\",\n"
+                "                    \"neurons\": " + QByteArray::number(16 + (index + l) % 512) + ",\n"
+                "                    \"poolingSize\": 4\n                }";
+        text += l + 1 < layers ? ",\n" : "\n";
+    }
+    text += "            ]\n        },\n        \"source\": \"runs/" + QByteArray::number(index) +
+            "/model \\\"v2\\\" [a], {b}, c\\\\\\\\.py\",\n        \"timestamp\": \"2026-01-01 12:00\"\n    }";
+    return text;
+}
+
+QByteArray historyText(int entries, int layers) {
+    QByteArray text = "[\n";
+    for (int i = 0; i < entries; ++i) {
+        text += historyEntryText(i, layers + i % 7);
+        text += i + 1 < entries ? ",\n" : "\n";
+    }
+    text += "]\n";
+    return text;
+}
+
+QJsonArray historyViaDocument(const QByteArray& json) {
+    return QJsonDocument::fromJson(json).array();
+}
+
+void benchHistory(QTextStream& out) {
+    // 1) 切块边界落在各种位置时结果都与整体解析相同：字符串中的括号、逗号、转义引号与连续反斜杠，
+    //    嵌套数组、紧凑格式的记录、标量记录
+    QByteArray tricky = "[\n";
+    for (int i = 0; i < 60; ++i) {
+        tricky += historyEntryText(i, 1 + i % 3) + ",\n";
+        tricky += "    [1, [2, [3, {\"a\": \"]],}{[\\\"\\\\\"}]], \"\\u00e9\\\\\\\"\"],\n";
+        tricky += "    {\"compact\":[{\"x\":[],\"y\":{}},\"\\\\\\\\\"],\"z\":-1.5e3}, " + QByteArray::number(i) + ", null, \"s,]\",\n";
+    }
+    tricky += "    true\n]\n";
+    const QJsonArray trickyExpected = historyViaDocument(tricky);
+    ThreadPool pool4(4);
+    int trickyOk = 0, trickyRuns = 0;
+    for (qint64 blockBytes : {64, 97, 256, 1000, 4096}) {
+        QJsonArray entries;
+        HistoryLoadStats stats;
+        ++trickyRuns;
+        trickyOk += parseHistoryJson(tricky, &entries, nullptr, &pool4, &stats, blockBytes) && entries == trickyExpected &&
+                    stats.chunks > 1;
+    }
+
+    // 格式错误都应报告，而不是切出错误的记录
+    const QByteArray body = historyText(40, 2);
+    const QByteArray open = body.left(body.size() - 3);  // 去掉结尾的 "\n]\n"
+    const QByteArray invalid[] = {
+        open + ",\n    1,\n    ,\n    2\n]\n",           // 空记录
+        open + ",\n]\n",                                  // 结尾多余的逗号
+        open,                                             // 截断
+        open + "\n]\n]\n",                                // 多余的右括号
+        open + "\n] x\n",                                 // 数组之后还有内容
+        open + ",\n    {\"a\": [1, 2}\n]\n",              // 括号类型不配对
+        open + ",\n    \"line\nbreak\"\n]\n",             // 字符串中未转义的换行
+        open + ",\n    {\"a\": \"unterminated}\n]\n",     // 字符串没有结束
+        open + ",\n    {\"a\": 1\n]\n",                   // 对象没有结束
+        "{\"history\": " + body + "}",                    // 顶层不是数组
+    };
+    int rejected = 0;
+    QString firstError;
+    for (const QByteArray& text : invalid) {
+        QJsonArray entries;
+        QString error;
+        const bool ok = parseHistoryJson(text, &entries, &error, &pool4, nullptr, 256);
+        rejected += !ok && entries.isEmpty() && !error.isEmpty();
+        if (firstError.isEmpty()) firstError = error;
+    }
+    const int invalidCount = int(sizeof invalid / sizeof invalid[0]);
+    out << "block boundaries vs whole-document parse: " << (trickyOk == trickyRuns ? "ok" : "FAIL") << " (" << trickyOk
+        << "/" << trickyRuns << ")  malformed rejected: " << (rejected == invalidCount ? "ok" : "FAIL") << " (" << rejected
+        << "/" << invalidCount << ", e.g. " << firstError << ")\n";
+
+    // 2) 大文件：与整体 QJsonDocument::fromJson 对比，不同线程数下各阶段耗时。
+    //    串行部分（串联扫描结果、合并）占比决定多核下的加速上限
+    const QString path = QDir::temp().filePath("nnv_bench_history.json");
+    {
+        QFile file(path);
+        file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+        file.write("[\n");
+        const int entries = 6000;
+        for (int i = 0; i < entries; ++i) {
+            file.write(historyEntryText(i, 40 + i % 25));
+            file.write(i + 1 < entries ? ",\n" : "\n");
+        }
+        file.write("]\n");
+    }
+    QFile file(path);
+    file.open(QIODevice::ReadOnly);
+    const qint64 size = file.size();
+    const uchar* mapped = file.map(0, size);
+    const QByteArray json = QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), int(size));
+
+    QElapsedTimer timer;
+    timer.start();
+    const QJsonArray expected = historyViaDocument(json);
+    const double wholeMs = timer.nsecsElapsed() / 1.0e6;
+    out << QString::number(size / 1048576.0, 'f', 0) << " MB, " << expected.size() << " entries, whole-document parse "
+        << QString::number(wholeMs, 'f', 0) << " ms (" << QString::number(size / 1048576.0 / wholeMs * 1000.0, 'f', 0)
+        << " MB/s)\n";
+    const int hardware = int(std::thread::hardware_concurrency());
+    for (int threads : {1, 2, 4}) {
+        ThreadPool pool(threads);
+        QJsonArray entries;
+        HistoryLoadStats stats;
+        timer.restart();
+        const bool ok = parseHistoryJson(json, &entries, nullptr, &pool, &stats) && entries == expected;
+        const double ms = timer.nsecsElapsed() / 1.0e6;
+        // 阿姆达尔定律：并行部分按核数缩短，串行部分不变
+        const double parallel = stats.scanMs + stats.parseMs, serial = stats.splitMs + stats.mergeMs;
+        auto predicted = [&](int cores) { return QString::number((parallel + serial) / (parallel / cores + serial), 'f', 1); };
+        out << "  " << threads << " thread(s): " << (ok ? "ok" : "FAIL") << "  " << QString::number(ms, 'f', 0) << " ms ("
+            << QString::number(wholeMs / ms, 'f', 2) << "x)  scan " << QString::number(stats.scanMs, 'f', 0) << " ms / "
+            << stats.blocks << " blocks, split " << QString::number(stats.splitMs, 'f', 1) << " ms, parse "
+            << QString::number(stats.parseMs, 'f', 0) << " ms / " << stats.chunks << " chunks, merge "
+            << QString::number(stats.mergeMs, 'f', 0) << " ms";
+        if (threads == 1)
+            out << "  -> serial fraction " << QString::number(serial / (parallel + serial) * 100.0, 'f', 1)
+                << "%, predicted speedup 4/8/16 cores " << predicted(4) << "/" << predicted(8) << "/" << predicted(16);
+        out << "\n";
+    }
+    QJsonArray loaded;
+    HistoryLoadStats loadStats;
+    timer.restart();
+    const bool loadOk = loadHistoryFile(path, &loaded, nullptr, &loadStats) && loaded == expected;
+    out << "  loadHistoryFile (mapped, global pool of " << loadStats.threads << "): " << (loadOk ? "ok" : "FAIL") << "  "
+        << QString::number(timer.nsecsElapsed() / 1.0e6, 'f', 0) << " ms\n";
+    out << "  (" << hardware << " hardware thread(s) here; wall-clock scaling needs that many cores)\n";
+    file.unmap(const_cast<uchar*>(mapped));
+    file.close();
+    QFile::remove(path);
+}
+
+QVector<CodeDiagnostic> freshDiagnostics(const QString& code) {
+    IncrementalValidator validator;
+    validator.setText(code);
+    validator.revalidate();
+    return validator.diagnostics();
+}
+
+void benchValidator(QTextStream& out) {
+    // 1) 各条规则：续行、三引号字符串内的内容不参与缩进检查，未闭合的括号在文件末尾报告到起始行
+    const QString broken =
+        "import torch.nn as nn\n"
+        "\n"
+        "class Net(nn.Module):\n"
+        "    def __init__(self):\n"
+        "        super().__init__()\n"
+        "        self.fc = nn.Linear(\n"
+        "             10, 20)\n"
+        "      x = 1\n"
+        "    def forward(self, x):\n"
+        "    return x\n"
+        "        y = 2\n"
+        "s = 'abc\n"
+        "t = (1, 2))\n"
+        "doc = \"\"\"\n"
+        "  free text: not code\n"
+        "\"\"\"\n"
+        "if True:\n"
+        "    z = [1,\n";
+    const QStringList expectedBroken = {
+        "第 8 行：缩进必须是4个空格的倍数", "第 8 行：缩进与外层代码块不一致", "第 9 行：冒号后需要增加缩进",
+        "第 11 行：意外的缩进", "第 12 行：字符串没有结束", "第 13 行：括号不匹配", "第 18 行：括号没有闭合"};
+    const QStringList gotBroken = diagnosticTexts(freshDiagnostics(broken));
+    const QStringList gotImport = diagnosticTexts(freshDiagnostics("x = nn.Linear(1, 2)\ndef f():\n"));
+    const QStringList expectedImport = {"第 2 行：冒号后需要增加缩进", "使用PyTorch模块但未导入torch或torch.nn"};
+    out << "rules: " << (gotBroken == expectedBroken && gotImport == expectedImport ? "ok" : "FAIL") << "\n";
+    if (gotBroken != expectedBroken) out << "  got: " << gotBroken.join(" | ") << "\n";
+    if (gotImport != expectedImport) out << "  got: " << gotImport.join(" | ") << "\n";
+
+    // 2) 约 2 万行的文件一次检查全文，与原正则实现对比
+    const QString source = generatedModelSource(800);
+    const int lines = static_cast<int>(std::count(source.constData(), source.constData() + source.size(), QChar('\n')));
+    QJsonObject fullResult, legacyResult;
+    const double fullMs = timeMs([&] { fullResult = ProgramFragmentProcessor::validateCode(source); });
+    const double legacyMs = timeMs([&] { legacyResult = legacyValidateCode(source); });
+    out << lines << "-line file, full check: " << QString::number(fullMs, 'f', 2) << " ms (valid "
+        << (fullResult["valid"].toBool() ? "yes" : "no") << ")  legacy regex " << QString::number(legacyMs, 'f', 2)
+        << " ms (valid " << (legacyResult["valid"].toBool() ? "yes" : "no") << ")\n";
+
+    // 3) 模拟输入 2000 次：大多是行内输入，也有回车、删行，以及每 100 次打开/关闭一个括号或三引号字符串
+    //    （之后的全部行都要重新扫描）。计时包括应用编辑、增量检查与取出全部结果，即后台线程每次按键的工作量；
+    //    每 250 次与从头检查的结果比对
+    QStringList document = source.split('\n');
+    IncrementalValidator validator;
+    validator.setText(source);
+    validator.revalidate();
+    std::mt19937 rng(131);
+    const QString typed = "abcxyz_ 0123.";
+    std::vector<double> editUs;
+    int mismatches = 0, checkpoints = 0, pendingLine = -1;
+    QString pendingText;
+    QElapsedTimer timer;
+    for (int edit = 0; edit < 2000; ++edit) {
+        const int kind = static_cast<int>(rng() % 100);
+        int first = static_cast<int>(rng() % document.size());
+        QStringList replacement;
+        int removed = 1;
+        if (edit % 100 == 50 && pendingLine < 0) {
+            // 在某行末尾打开括号或三引号字符串，50 次之后再删掉
+            pendingLine = first;
+            pendingText = document[first];
+            replacement << document[first] + ((edit / 100) % 2 ? " (" : " \"\"\"");
+        } else if (edit % 100 == 0 && pendingLine >= 0 && pendingLine < document.size()) {
+            first = pendingLine;
+            replacement << pendingText;
+            pendingLine = -1;
+        } else if (kind < 80) {
+            QString line = document[first];
+            line.insert(static_cast<int>(rng() % (line.size() + 1)), typed[static_cast<int>(rng() % typed.size())]);
+            replacement << line;
+        } else if (kind < 90) {
+            replacement << document[first] << QString(document[first].size() - document[first].trimmed().size(), QChar(' ')) + "y = 1";
+        } else if (document.size() > 1 && first != pendingLine) {
+            if (pendingLine > first) --pendingLine;
+        } else {
+            replacement << document[first];
+        }
+        timer.start();
+        validator.replaceLines(first, removed, replacement);
+        validator.revalidate();
+        const QVector<CodeDiagnostic> diagnostics = validator.diagnostics();
+        editUs.push_back(timer.nsecsElapsed() / 1000.0);
+        for (int i = 0; i < removed; ++i) document.removeAt(first);
+        for (int i = 0; i < replacement.size(); ++i) document.insert(first + i, replacement[i]);
+        if (replacement.size() > 1 && pendingLine > first) ++pendingLine;
+        if (edit % 250 == 249 || edit == 75) {
+            ++checkpoints;
+            if (diagnostics != freshDiagnostics(document.join('\n'))) ++mismatches;
+        }
+    }
+    std::vector<double> sorted = editUs;
+    std::sort(sorted.begin(), sorted.end());
+    const double mean = std::accumulate(editUs.begin(), editUs.end(), 0.0) / editUs.size();
+    const double p99 = sorted[sorted.size() * 99 / 100];
+    out << "typing " << static_cast<int>(editUs.size()) << " edits: " << (mismatches == 0 ? "ok" : "FAIL") << " (" << checkpoints
+        << " checkpoints vs fresh check)  per edit mean " << QString::number(mean, 'f', 1) << " us  p99 "
+        << QString::number(p99, 'f', 1) << " us  max " << QString::number(sorted.back() / 1000.0, 'f', 2)
+        << " ms  (frame 16.7 ms)\n";
+
+    // 4) 取消：每检查一个顶层代码块就取消一次，多次续做后的结果应与一次做完相同
+    IncrementalValidator resumed;
+    resumed.setText(document.join('\n'));
+    int passes = 1, polls = 0;
+    while (!resumed.revalidate([&] { return ++polls % 2 == 0; })) ++passes;
+    out << "cancel/resume: " << (resumed.diagnostics() == freshDiagnostics(document.join('\n')) ? "ok" : "FAIL") << " ("
+        << passes << " passes)\n";
+}
+
+const Benchmark kBenchmarks[] = {
+    {"gemm", "分块 SIMD GEMM 与朴素实现对比", benchGemm},
+    {"engine", "原生推理引擎前向延迟与吞吐", benchEngine},
+    {"conv", "Conv2d 各算法（im2col/direct/winograd）、自动选择与池化", benchConv},
+    {"latency", "本机校准的逐层延迟预测与实测对比", benchLatency},
+    {"recurrent", "LSTM/GRU/RNN 融合门内核的正确性与吞吐", benchRecurrent},
+    {"training", "全连接网络训练：梯度检验、SGD/Adam 收敛与吞吐", benchTraining},
+    {"checkpoint", "内存映射检查点的打开、层匹配与按需读取", benchCheckpoint},
+    {"weightstats", "逐层权重统计与 256 箱直方图：正确性、吞吐与缓存", benchWeightStats},
+    {"quantization", "int8/fp16/bf16 量化内核与整网量化模拟", benchQuantization},
+    {"pruning", "幅值/N:M 剪枝、CSR 稀疏矩阵-向量乘与稠密实现对比", benchPruning},
+    {"edgefilter", "按 |w| 取前 k% 连线：增量部分选择与每次从头选择对比", benchEdgeSelection},
+    {"heatmap", "权重矩阵热力图：向量化色表着色与 |w| 最大值 mipmap", benchHeatmap},
+    {"activations", "样本输入逐层激活捕获：CSV 读取、正确性与拖动吞吐", benchActivations},
+    {"dataset", "内存映射 IDX/CSV 样本集：并行解析、打乱批次与 readLine 对照", benchDataset},
+    {"projection", "激活 PCA 投影：协方差/随机化 SVD 精度、流式高维与 10 万点散点光栅化", benchProjection},
+    {"pyimport", "PyTorch 源码导入：单遍词法/语法分析与原正则提取对比（5 万行）", benchPyImport},
+    {"validator", "增量代码校验：规则、2 万行文件逐次按键的检查耗时与取消续做", benchValidator},
+    {"bulkimport", "批量导入模型目录：并行解析吞吐与按内容哈希的磁盘缓存命中率", benchBulkImport},
+    {"onnx", "ONNX 导入：内存映射逐字段扫描 2 GB 模型，权重只记偏移", benchOnnx},
+    {"modulerepr", "print(model) 输出导入：ResNet-152 与 48 层 Transformer 的解析正确性与耗时、恶意的重复次数", benchModuleRepr},
+    {"trace", "torch.profiler 追踪：流式读取 512 MB Chrome 追踪，按模块作用域汇总时间与内存", benchTrace},
+    {"watch", "监视模式：保存后重新解析并与上次结构比较的耗时与比较正确性", benchWatch},
+    {"layerjson", "网络结构 JSON 流式读写：与 QJsonDocument 路径的格式对照、10 万层耗时与分配次数", benchLayerJson},
+    {"history", "history.json 分块并行加载：切块边界正确性、与整体解析对比及各阶段耗时", benchHistory},
+};
+
+} // namespace
+
+QStringList benchmarkNames() {
+    QStringList names;
+    for (const Benchmark& b : kBenchmarks) names << b.name;
+    return names;
+}
+
+int runBenchmarks(const QStringList& names) {
+    QTextStream out(stdout);
+    int ran = 0;
+    for (const Benchmark& b : kBenchmarks) {
+        if (!names.isEmpty() && !names.contains(b.name)) continue;
+        out << "== " << b.name << ": " << QString::fromUtf8(b.description) << " ==\n";
+        b.run(out);
+        out << "\n";
+        out.flush();
+        ++ran;
+    }
+    if (ran == 0) {
+        out << "未知的基准名称，可选：" << benchmarkNames().join(", ") << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,13 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <QStringList>
+
+// 命令行基准测试入口：Neural_Network_Visualization --benchmark [名称...]
+// names 为空时运行全部基准，结果输出到标准输出，返回进程退出码
+int runBenchmarks(const QStringList& names);
+
+// 已注册的基准名称
+QStringList benchmarkNames();
+
+#endif // BENCHMARKS_H
@@ -0,0 +1,140 @@
+#include "bulkimport.h"
+#include "programfragmentprocessor.h"
+#include "threadpool.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace {
+
+// 解析规则（pytorchparser / processFragment 的输出格式）改变时加一，旧的缓存结果随之失效
+constexpr int kParserVersion = 2;
+
+} // namespace
+
+ParseResultCache::ParseResultCache(const QString& directory) : m_directory(directory) {}
+
+QString ParseResultCache::contentHash(const QByteArray& content) {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray::number(kParserVersion) + '\n');
+    hash.addData(content);
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+bool ParseResultCache::lookup(const QString& hash, QJsonObject* result) const {
+    QFile file(QDir(m_directory).filePath(hash + ".json"));
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+    if (!doc.isObject()) return false;  // 写了一半或被破坏的条目当作未命中，重新解析后覆盖
+    *result = doc.object();
+    return true;
+}
+
+void ParseResultCache::store(const QString& hash, const QJsonObject& result) const {
+    QDir().mkpath(m_directory);
+    // 先写临时文件再改名，并行导入或中途退出都不会留下不完整的条目
+    QSaveFile file(QDir(m_directory).filePath(hash + ".json"));
+    if (!file.open(QIODevice::WriteOnly)) return;
+    file.write(QJsonDocument(result).toJson(QJsonDocument::Compact));
+    file.commit();
+}
+
+void ParseResultCache::clear() {
+    QDir(m_directory).removeRecursively();
+}
+
+int BulkImportReport::models() const {
+    int count = 0;
+    for (const ImportedFile& file : files) {
+        if (!file.layers().isEmpty()) ++count;
+    }
+    return count;
+}
+
+QString BulkImportReport::summary() const {
+    return QString("%1 个文件（%2 KB），提取到 %3 个模型，%4 ms（遍历目录 %5 ms），%6 文件/秒，"
+                   "缓存命中 %7/%1（%8%），%9 线程")
+        .arg(files.size())
+        .arg(bytes / 1024)
+        .arg(models())
+        .arg(totalMs, 0, 'f', 1)
+        .arg(scanMs, 0, 'f', 1)
+        .arg(filesPerSecond(), 0, 'f', 0)
+        .arg(cacheHits)
+        .arg(hitRate() * 100.0, 0, 'f', 1)
+        .arg(threads);
+}
+
+BulkImportReport importModelDirectory(const QString& directory, const ParseResultCache* cache, ThreadPool* pool) {
+    if (!pool) pool = &ThreadPool::global();
+    BulkImportReport report;
+    report.threads = pool->threadCount();
+    QElapsedTimer timer;
+    timer.start();
+
+    const QDir root(directory);
+    QStringList paths;
+    std::vector<qint64> sizes;
+    QDirIterator it(directory, QStringList{"*.py"}, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        paths << it.filePath();
+        sizes.push_back(it.fileInfo().size());
+    }
+    report.scanMs = timer.nsecsElapsed() / 1.0e6;
+
+    std::vector<int> order(paths.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return sizes[a] > sizes[b]; });
+
+    QVector<ImportedFile> files(paths.size());
+    QVector<QString> errors(paths.size());
+    pool->parallelFor(0, static_cast<int>(order.size()), 1, [&](int first, int last) {
+        for (int k = first; k < last; ++k) {
+            const int index = order[k];
+            ImportedFile& imported = files[index];
+            imported.path = root.relativeFilePath(paths[index]);
+            QFile file(paths[index]);
+            if (!file.open(QIODevice::ReadOnly)) {
+                errors[index] = QString("%1：%2").arg(imported.path, file.errorString());
+                continue;
+            }
+            const QByteArray content = file.readAll();
+            imported.hash = ParseResultCache::contentHash(content);
+            if (cache && cache->lookup(imported.hash, &imported.result)) {
+                imported.fromCache = true;
+                continue;
+            }
+
+            QJsonObject fragment;
+            fragment["language"] = "python";
+            fragment["action"] = "extract-structure";
+            fragment["code"] = QString::fromUtf8(content);
+            imported.result = ProgramFragmentProcessor::processFragment(fragment);
+            imported.result.remove("timestamp");
+            if (cache) cache->store(imported.hash, imported.result);
+        }
+    });
+
+    for (int i = 0; i < files.size(); ++i) {
+        if (!errors[i].isEmpty()) {
+            report.errors << errors[i];
+            continue;
+        }
+        report.bytes += sizes[i];
+        if (files[i].fromCache) ++report.cacheHits;
+        report.files.append(files[i]);
+    }
+    std::sort(report.files.begin(), report.files.end(),
+              [](const ImportedFile& a, const ImportedFile& b) { return a.path < b.path; });
+    report.totalMs = timer.nsecsElapsed() / 1.0e6;
+    return report;
+}
@@ -0,0 +1,63 @@
+#ifndef BULKIMPORT_H
+#define BULKIMPORT_H
+
+#include <QByteArray>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class ThreadPool;
+
+// 按内容哈希保存 PyTorch 源码解析结果的磁盘缓存：每个结果一个 JSON 文件，文件名即哈希。
+// 哈希同时覆盖解析器版本，解析规则改变后旧结果自然不再命中；各文件独立写入，可在多个线程中同时使用
+class ParseResultCache
+{
+public:
+    explicit ParseResultCache(const QString& directory = "pyimport_cache");
+
+    QString directory() const { return m_directory; }
+
+    static QString contentHash(const QByteArray& content);
+    bool lookup(const QString& hash, QJsonObject* result) const;
+    void store(const QString& hash, const QJsonObject& result) const;
+    void clear();
+
+private:
+    QString m_directory;
+};
+
+// 导入的一个源文件
+struct ImportedFile
+{
+    QString path;         // 相对于导入目录
+    QString hash;
+    QJsonObject result;   // ProgramFragmentProcessor::processFragment 的 extract-structure 结果（不含时间戳）
+    bool fromCache = false;
+
+    QJsonArray layers() const { return result["networkStructure"].toArray(); }
+};
+
+struct BulkImportReport
+{
+    QVector<ImportedFile> files;  // 按路径排序
+    QStringList errors;           // 无法读取的文件
+    qint64 bytes = 0;
+    int cacheHits = 0;
+    double scanMs = 0.0;          // 遍历目录
+    double totalMs = 0.0;
+    int threads = 1;
+
+    int models() const;           // 提取到层的文件数
+    double filesPerSecond() const { return totalMs > 0.0 ? files.size() * 1000.0 / totalMs : 0.0; }
+    double hitRate() const { return files.isEmpty() ? 0.0 : double(cacheHits) / files.size(); }
+    QString summary() const;
+};
+
+// 递归遍历 directory 下的 .py 文件，在线程池中并行解析；cache 为空时不读写缓存。
+// 文件按大小从大到小逐个领取，避免大文件最后才开始而拖长总时间
+BulkImportReport importModelDirectory(const QString& directory, const ParseResultCache* cache = nullptr,
+                                      ThreadPool* pool = nullptr);
+
+#endif // BULKIMPORT_H
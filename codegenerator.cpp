@@ -2,6 +2,7 @@
 #include <QList>
 #include <QJsonDocument>
 #include <algorithm>
+#include <cmath>
 
 // 比较函数 根据层在场景中的位置排序
 struct LayerSorter {
@@ -371,3 +372,403 @@ QString CodeGenerator::generatePyTorchCode(const QList<NeuralLayer*>& layers) {
 
     return code;
 }
+
+// C++ 导出代码的运行时部分：固定维度的模板内核，-O3 下内层循环可被编译器自动向量化
+static const char* kCppRuntime = R"CPP(#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace nn {
+
+// y[r][o] = b[o] + sum_i x[r][i] * wt[i][o]，权重按 [IN][OUT] 转置存储，内层循环连续访存
+template <int ROWS, int IN, int OUT>
+inline void dense(const float* __restrict x, const float* __restrict wt,
+                  const float* __restrict b, float* __restrict y) {
+    for (int r = 0; r < ROWS; ++r) {
+        const float* __restrict xr = x + r * IN;
+        float* __restrict yr = y + r * OUT;
+        for (int o = 0; o < OUT; ++o) yr[o] = b[o];
+        for (int i = 0; i < IN; ++i) {
+            const float xi = xr[i];
+            const float* __restrict wi = wt + i * OUT;
+            for (int o = 0; o < OUT; ++o) yr[o] += xi * wi[o];
+        }
+    }
+}
+
+// 直接卷积，步长 1，padding = K / 2，权重布局 [F][C][K][K]
+template <int C, int H, int W, int F, int K>
+inline void conv2d(const float* __restrict x, const float* __restrict w,
+                   const float* __restrict b, float* __restrict y) {
+    constexpr int P = K / 2;
+    constexpr int OH = H + 2 * P - K + 1;
+    constexpr int OW = W + 2 * P - K + 1;
+    for (int f = 0; f < F; ++f) {
+        float* __restrict yf = y + f * OH * OW;
+        for (int i = 0; i < OH * OW; ++i) yf[i] = b[f];
+        for (int c = 0; c < C; ++c) {
+            const float* __restrict xc = x + c * H * W;
+            for (int ky = 0; ky < K; ++ky) {
+                for (int kx = 0; kx < K; ++kx) {
+                    const float wv = w[((f * C + c) * K + ky) * K + kx];
+                    const int x0 = std::max(0, P - kx);
+                    const int x1 = std::min(OW, W + P - kx);
+                    for (int oy = 0; oy < OH; ++oy) {
+                        const int iy = oy + ky - P;
+                        if (iy < 0 || iy >= H) continue;
+                        const float* __restrict xrow = xc + iy * W + (kx - P);
+                        float* __restrict yrow = yf + oy * OW;
+                        for (int ox = x0; ox < x1; ++ox) yrow[ox] += wv * xrow[ox];
+                    }
+                }
+            }
+        }
+    }
+}
+
+// 池化，步长 2
+template <int C, int H, int W, int K, bool MAX>
+inline void pool2d(const float* __restrict x, float* __restrict y) {
+    constexpr int OH = (H - K) / 2 + 1;
+    constexpr int OW = (W - K) / 2 + 1;
+    for (int c = 0; c < C; ++c) {
+        const float* __restrict xc = x + c * H * W;
+        float* __restrict yc = y + c * OH * OW;
+        for (int oy = 0; oy < OH; ++oy) {
+            for (int ox = 0; ox < OW; ++ox) {
+                float acc = MAX ? -INFINITY : 0.0f;
+                for (int ky = 0; ky < K; ++ky) {
+                    const float* __restrict row = xc + (oy * 2 + ky) * W + ox * 2;
+                    for (int kx = 0; kx < K; ++kx)
+                        acc = MAX ? std::max(acc, row[kx]) : acc + row[kx];
+                }
+                yc[oy * OW + ox] = MAX ? acc : acc * (1.0f / (K * K));
+            }
+        }
+    }
+}
+
+inline float sigmoid(float v) { return 1.0f / (1.0f + std::exp(-v)); }
+
+template <int N> inline void relu(float* x) { for (int i = 0; i < N; ++i) x[i] = std::max(x[i], 0.0f); }
+template <int N> inline void leakyRelu(float* x) { for (int i = 0; i < N; ++i) x[i] = x[i] > 0.0f ? x[i] : 0.01f * x[i]; }
+template <int N> inline void sigmoidAct(float* x) { for (int i = 0; i < N; ++i) x[i] = sigmoid(x[i]); }
+template <int N> inline void tanhAct(float* x) { for (int i = 0; i < N; ++i) x[i] = std::tanh(x[i]); }
+template <int ROWS, int N> inline void softmax(float* x) {
+    for (int r = 0; r < ROWS; ++r) {
+        float* xr = x + r * N;
+        float m = xr[0];
+        for (int i = 1; i < N; ++i) m = std::max(m, xr[i]);
+        float sum = 0.0f;
+        for (int i = 0; i < N; ++i) { xr[i] = std::exp(xr[i] - m); sum += xr[i]; }
+        const float inv = 1.0f / sum;
+        for (int i = 0; i < N; ++i) xr[i] *= inv;
+    }
+}
+
+// 循环层：每个时间步把全部门的输入/隐藏权重合成一次矩阵向量乘
+// 门顺序与 PyTorch 一致：LSTM (i, f, g, o)，GRU (r, z, n)，RNN (h)
+template <int T, int F, int U>
+inline void lstm(const float* x, const float* wx, const float* wh, const float* bx,
+                 const float* bh, float* y, float* gx, float* gh, float* c, const float* h0) {
+    std::fill(c, c + U, 0.0f);
+    for (int t = 0; t < T; ++t) {
+        dense<1, F, 4 * U>(x + t * F, wx, bx, gx);
+        dense<1, U, 4 * U>(t ? y + (t - 1) * U : h0, wh, bh, gh);
+        float* ht = y + t * U;
+        for (int u = 0; u < U; ++u) {
+            const float i = sigmoid(gx[u] + gh[u]);
+            const float f = sigmoid(gx[U + u] + gh[U + u]);
+            const float g = std::tanh(gx[2 * U + u] + gh[2 * U + u]);
+            const float o = sigmoid(gx[3 * U + u] + gh[3 * U + u]);
+            c[u] = f * c[u] + i * g;
+            ht[u] = o * std::tanh(c[u]);
+        }
+    }
+}
+
+template <int T, int F, int U>
+inline void gru(const float* x, const float* wx, const float* wh, const float* bx,
+                const float* bh, float* y, float* gx, float* gh, const float* h0) {
+    for (int t = 0; t < T; ++t) {
+        const float* hp = t ? y + (t - 1) * U : h0;
+        dense<1, F, 3 * U>(x + t * F, wx, bx, gx);
+        dense<1, U, 3 * U>(hp, wh, bh, gh);
+        float* ht = y + t * U;
+        for (int u = 0; u < U; ++u) {
+            const float r = sigmoid(gx[u] + gh[u]);
+            const float z = sigmoid(gx[U + u] + gh[U + u]);
+            const float n = std::tanh(gx[2 * U + u] + r * gh[2 * U + u]);
+            ht[u] = (1.0f - z) * n + z * hp[u];
+        }
+    }
+}
+
+template <int T, int F, int U>
+inline void rnn(const float* x, const float* wx, const float* wh, const float* bx,
+                const float* bh, float* y, float* gx, float* gh, const float* h0) {
+    for (int t = 0; t < T; ++t) {
+        dense<1, F, U>(x + t * F, wx, bx, gx);
+        dense<1, U, U>(t ? y + (t - 1) * U : h0, wh, bh, gh);
+        float* ht = y + t * U;
+        for (int u = 0; u < U; ++u) ht[u] = std::tanh(gx[u] + gh[u]);
+    }
+}
+
+// 参数描述：文件中按 PyTorch 的 [rows][cols] 存放，transpose 时在加载时转置为 [cols][rows]
+struct ParamSpec {
+    float* data;
+    int rows;
+    int cols;
+    bool transpose;
+    float initScale;  // 无权重文件时的均匀初始化范围 1/sqrt(fan_in)
+};
+
+)CPP";
+
+static const char* kCppLoader = R"CPP(
+constexpr int kParamCount = sizeof(kParams) / sizeof(kParams[0]);
+
+inline long long totalParameters() {
+    long long n = 0;
+    for (const ParamSpec& p : kParams) n += static_cast<long long>(p.rows) * p.cols;
+    return n;
+}
+
+inline void unpack(const ParamSpec& p, const float* src) {
+    if (!p.transpose) {
+        std::copy(src, src + p.rows * p.cols, p.data);
+        return;
+    }
+    for (int r = 0; r < p.rows; ++r)
+        for (int c = 0; c < p.cols; ++c)
+            p.data[c * p.rows + r] = src[r * p.cols + c];
+}
+
+// 权重文件：小端 float32 平铺，顺序与 kParams 一致
+inline bool loadWeights(const char* path) {
+    FILE* file = std::fopen(path, "rb");
+    if (!file) {
+        std::fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    std::vector<float> flat(static_cast<size_t>(totalParameters()));
+    const size_t got = std::fread(flat.data(), sizeof(float), flat.size(), file);
+    const bool trailing = std::fgetc(file) != EOF;
+    std::fclose(file);
+    if (got != flat.size() || trailing) {
+        std::fprintf(stderr, "%s: expected %lld floats\n", path, totalParameters());
+        return false;
+    }
+    const float* src = flat.data();
+    for (const ParamSpec& p : kParams) {
+        unpack(p, src);
+        src += p.rows * p.cols;
+    }
+    return true;
+}
+
+// 没有权重文件时使用确定性的伪随机初始化，便于直接跑延迟测试
+inline void initWeights() {
+    unsigned int state = 12345u;
+    std::vector<float> tmp;
+    for (const ParamSpec& p : kParams) {
+        tmp.resize(static_cast<size_t>(p.rows) * p.cols);
+        for (float& v : tmp) {
+            state = state * 1664525u + 1013904223u;
+            v = ((state >> 8) * (1.0f / 16777216.0f) * 2.0f - 1.0f) * p.initScale;
+        }
+        unpack(p, tmp.data());
+    }
+}
+
+} // namespace nn
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        if (!nn::loadWeights(argv[1])) return 1;
+    } else {
+        nn::initWeights();
+    }
+    const int iterations = argc > 2 ? std::max(1, std::atoi(argv[2])) : 1000;
+
+    static float input[nn::kInputSize];
+    for (int i = 0; i < nn::kInputSize; ++i) input[i] = std::sin(0.01f * i);
+
+    for (int i = 0; i < 10; ++i) nn::forward(input);
+
+    std::vector<double> micros(iterations);
+    double checksum = 0.0;
+    for (int it = 0; it < iterations; ++it) {
+        const auto t0 = std::chrono::steady_clock::now();
+        const float* out = nn::forward(input);
+        const auto t1 = std::chrono::steady_clock::now();
+        micros[it] = std::chrono::duration<double, std::micro>(t1 - t0).count();
+        checksum += out[it % nn::kOutputSize];
+    }
+    std::sort(micros.begin(), micros.end());
+    double mean = 0.0;
+    for (double t : micros) mean += t;
+    mean /= iterations;
+
+    const float* out = nn::forward(input);
+    std::printf("parameters: %lld\n", nn::totalParameters());
+    std::printf("latency over %d runs: mean %.2f us, p50 %.2f us, p99 %.2f us, min %.2f us\n",
+                iterations, mean, micros[iterations / 2],
+                micros[std::min(iterations - 1, iterations * 99 / 100)], micros[0]);
+    std::printf("output[0..%d]:", std::min(nn::kOutputSize, 8) - 1);
+    for (int i = 0; i < std::min(nn::kOutputSize, 8); ++i) std::printf(" %.5f", out[i]);
+    std::printf("\nchecksum: %.6f\n", checksum);
+    return 0;
+}
+)CPP";
+
+// 按 activationFunction 追加激活函数调用
+static QString cppActivation(const NeuralLayer* layer, const QString& buffer, int rows, int cols) {
+    const QString act = layer->activationFunction.trimmed().toLower();
+    const int n = rows * cols;
+    if (act == "relu") return QString("    relu<%1>(%2);\n").arg(n).arg(buffer);
+    if (act == "leaky_relu") return QString("    leakyRelu<%1>(%2);\n").arg(n).arg(buffer);
+    if (act == "sigmoid") return QString("    sigmoidAct<%1>(%2);\n").arg(n).arg(buffer);
+    if (act == "tanh") return QString("    tanhAct<%1>(%2);\n").arg(n).arg(buffer);
+    if (act == "softmax") return QString("    softmax<%1, %2>(%3);\n").arg(rows).arg(cols).arg(buffer);
+    return QString();
+}
+
+QString CodeGenerator::generateCppCode(const QList<NeuralLayer*>& layers) {
+    // 与 PyTorch 代码相同的层顺序：每层都有图形项时按纵坐标，否则保持传入顺序
+    QList<NeuralLayer*> sortedLayers = layers;
+    const bool placed = std::all_of(layers.begin(), layers.end(), [](const NeuralLayer* layer) { return layer->graphicsItem != nullptr; });
+    if (placed) std::stable_sort(sortedLayers.begin(), sortedLayers.end(), LayerSorter());
+
+    QList<const NeuralLayer*> ordered;
+    for (const NeuralLayer* layer : sortedLayers) ordered.append(layer);
+
+    const LayerShape inputShape = defaultInputShape(ordered);
+    QVector<LayerShape> shapes;
+    QString error;
+    if (ordered.isEmpty()) error = "网络为空";
+    else inferLayerShapes(ordered, inputShape, shapes, &error);
+    if (!error.isEmpty()) {
+        return QString("// 无法生成 C++ 代码：%1\n").arg(error);
+    }
+
+    QString buffers;   // 静态分配的权重与激活缓冲区
+    QString params;    // kParams 表
+    QString body;      // forward() 函数体
+    QString cur = "x";
+    LayerShape in = inputShape;
+
+    auto addParam = [&params](const QString& name, int rows, int cols, bool transpose, int fanIn) {
+        params += QString("    {%1, %2, %3, %4, %5f},\n")
+                      .arg(name).arg(rows).arg(cols)
+                      .arg(transpose ? "true" : "false")
+                      .arg(1.0 / std::sqrt(double(qMax(1, fanIn))), 0, 'e', 7);
+    };
+
+    for (int i = 0; i < ordered.size(); ++i) {
+        const NeuralLayer* layer = ordered[i];
+        const LayerShape& out = shapes[i];
+        const QString id = QString::number(i + 1);
+        const QString act = "a" + id;
+
+        if (layer->isDense()) {
+            const int rows = out.height;
+            const int inFeatures = in.spatial ? in.size() : in.width;
+            buffers += QString("// %1: Linear(%2, %3)\n").arg(layer->layerType).arg(inFeatures).arg(out.width);
+            buffers += QString("alignas(64) static float w%1[%2 * %3];\n").arg(id).arg(inFeatures).arg(out.width);
+            buffers += QString("alignas(64) static float b%1[%2];\n").arg(id).arg(out.width);
+            buffers += QString("alignas(64) static float %1[%2];\n\n").arg(act).arg(out.size());
+            addParam("w" + id, out.width, inFeatures, true, inFeatures);
+            addParam("b" + id, 1, out.width, false, inFeatures);
+            body += QString("    dense<%1, %2, %3>(%4, w%5, b%5, %6);\n")
+                        .arg(rows).arg(inFeatures).arg(out.width).arg(cur, id, act);
+            body += cppActivation(layer, act, rows, out.width);
+            cur = act;
+        } else if (layer->isConvolutional()) {
+            const int k = layer->kernelSize;
+            const int fanIn = in.channels * k * k;
+            buffers += QString("// %1: Conv2d(%2, %3, kernel_size=%4, padding=%5)\n")
+                           .arg(layer->layerType).arg(in.channels).arg(out.channels).arg(k).arg(k / 2);
+            buffers += QString("alignas(64) static float w%1[%2 * %3 * %4 * %4];\n")
+                           .arg(id).arg(out.channels).arg(in.channels).arg(k);
+            buffers += QString("alignas(64) static float b%1[%2];\n").arg(id).arg(out.channels);
+            buffers += QString("alignas(64) static float %1[%2];\n\n").arg(act).arg(out.size());
+            addParam("w" + id, out.channels, fanIn, false, fanIn);
+            addParam("b" + id, 1, out.channels, false, fanIn);
+            body += QString("    conv2d<%1, %2, %3, %4, %5>(%6, w%7, b%7, %8);\n")
+                        .arg(in.channels).arg(in.height).arg(in.width).arg(out.channels).arg(k)
+                        .arg(cur, id, act);
+            body += cppActivation(layer, act, 1, out.size());
+            cur = act;
+        } else if (layer->isPooling()) {
+            const bool isMax = layer->layerType == "MaxPooling";
+            buffers += QString("// %1: kernel_size=%2, stride=2\n").arg(layer->layerType).arg(layer->poolingSize);
+            buffers += QString("alignas(64) static float %1[%2];\n\n").arg(act).arg(out.size());
+            body += QString("    pool2d<%1, %2, %3, %4, %5>(%6, %7);\n")
+                        .arg(in.channels).arg(in.height).arg(in.width).arg(layer->poolingSize)
+                        .arg(isMax ? "true" : "false").arg(cur, act);
+            cur = act;
+        } else if (layer->isRecurrent()) {
+            const int gates = layer->layerType == "LSTM" ? 4 : (layer->layerType == "GRU" ? 3 : 1);
+            const int steps = out.height;
+            const int features = in.width;
+            const int units = out.width;
+            buffers += QString("// %1(%2, %3, batch_first=True)，序列长度 %4\n")
+                           .arg(layer->layerType).arg(features).arg(units).arg(steps);
+            buffers += QString("alignas(64) static float wx%1[%2 * %3];\n").arg(id).arg(features).arg(gates * units);
+            buffers += QString("alignas(64) static float wh%1[%2 * %3];\n").arg(id).arg(units).arg(gates * units);
+            buffers += QString("alignas(64) static float bx%1[%2];\n").arg(id).arg(gates * units);
+            buffers += QString("alignas(64) static float bh%1[%2];\n").arg(id).arg(gates * units);
+            buffers += QString("alignas(64) static float gx%1[%2];\n").arg(id).arg(gates * units);
+            buffers += QString("alignas(64) static float gh%1[%2];\n").arg(id).arg(gates * units);
+            buffers += QString("alignas(64) static float h0_%1[%2];\n").arg(id).arg(units);
+            if (gates == 4) buffers += QString("alignas(64) static float c%1[%2];\n").arg(id).arg(units);
+            buffers += QString("alignas(64) static float %1[%2];\n\n").arg(act).arg(out.size());
+            addParam("wx" + id, gates * units, features, true, units);
+            addParam("wh" + id, gates * units, units, true, units);
+            addParam("bx" + id, 1, gates * units, false, units);
+            addParam("bh" + id, 1, gates * units, false, units);
+            const QString kernel = gates == 4 ? "lstm" : (gates == 3 ? "gru" : "rnn");
+            body += QString("    %1<%2, %3, %4>(%5, wx%6, wh%6, bx%6, bh%6, %7, gx%6, gh%6, %8h0_%6);\n")
+                        .arg(kernel).arg(steps).arg(features).arg(units)
+                        .arg(cur, id, act, gates == 4 ? QString("c%1, ").arg(id) : QString());
+            const QString a = layer->activationFunction.trimmed().toLower();
+            if (a == "relu" || a == "tanh") body += cppActivation(layer, act, steps, units);
+            cur = act;
+        } else {
+            // Dropout（推理时为恒等）与 Flatten 只改变视图，不产生计算
+            body += QString("    // %1: identity\n").arg(layer->layerType);
+        }
+        in = out;
+    }
+
+    const LayerShape& outShape = shapes.last();
+    QString code;
+    code += "// C++17 神经网络前向推理代码（自动生成，无第三方依赖）\n";
+    code += "// 编译: g++ -O3 -march=native -std=c++17 model.cpp -o model\n";
+    code += "// 运行: ./model [weights.bin] [iterations]\n";
+    code += "// weights.bin 为小端 float32 平铺文件，顺序与 PyTorch model.parameters() 一致，例如\n";
+    code += "//   torch.cat([p.detach().flatten() for p in model.parameters()]).numpy().astype('float32').tofile('weights.bin')\n";
+    code += QString("// 输入形状 %1x%2x%3，输出形状 %4x%5x%6\n")
+                .arg(inputShape.channels).arg(inputShape.height).arg(inputShape.width)
+                .arg(outShape.channels).arg(outShape.height).arg(outShape.width);
+    code += kCppRuntime;
+    code += QString("constexpr int kInputSize = %1;\n").arg(inputShape.size());
+    code += QString("constexpr int kOutputSize = %1;\n\n").arg(outShape.size());
+    code += buffers;
+    if (params.isEmpty()) {
+        // 没有可训练参数时保留一个空占位，保证 kParams 非空
+        code += "alignas(64) static float unused0[1];\n\n";
+        params = "    {unused0, 1, 1, false, 0.0f},\n";
+    }
+    code += "static const ParamSpec kParams[] = {\n" + params + "};\n";
+    code += "\ninline const float* forward(const float* x) {\n";
+    code += body;
+    code += QString("    return %1;\n}\n").arg(cur);
+    code += kCppLoader;
+    return code;
+}
@@ -8,6 +8,7 @@ class CodeGenerator
 public:
     CodeGenerator();
     static QString generatePyTorchCode(const QList<NeuralLayer*>& layers);//生成PyTorch框架下的代码
+    static QString generateCppCode(const QList<NeuralLayer*>& layers);//生成无依赖的C++17前向推理代码（含延迟测试main）
     QString generateCodeFromJson(const QString& jsonStr);
 };
 
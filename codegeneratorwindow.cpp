@@ -3,8 +3,15 @@
 #include "codegeneratorwindow.h"
 #include "ui_codegeneratorwindow.h"
 #include "mainwindow.h"
+#include "projectiondialog.h"
 #include "propertypanel.h"
+#include "pruningdialog.h"
 #include "codegenerator.h"
+#include "inferenceengine.h"
+#include "quantizationdialog.h"
+#include "trainingdialog.h"
+#include "weightcheckpoint.h"
+#include "weightstats.h"
 #include <QGraphicsRectItem>
 #include <QObject>
 #include <QMimeData>
@@ -20,6 +27,8 @@
 #include <QStatusBar>
 #include <QMessageBox>
 #include <QTimer>
+#include <cmath>
+#include <vector>
 
 CodeGeneratorWindow::CodeGeneratorWindow(QWidget *parent)
     : QDialog(parent)
@@ -96,6 +105,7 @@ CodeGeneratorWindow::CodeGeneratorWindow(QWidget *parent)
     // Connect
     connect(layersList, &QListWidget::itemClicked, this, &CodeGeneratorWindow::on_layersList_itemClicked);
     connect(m_propertyPanel, &PropertyPanel::parametersUpdated, this, &CodeGeneratorWindow::on_propertiesPanel_parametersUpdated);
+    connect(m_builderScene, &QGraphicsScene::selectionChanged, this, &CodeGeneratorWindow::onSceneSelectionChanged);
 
     // 代码生成button
     QPushButton* generateCodeButton = new QPushButton("Generate PyTorch Code", this);
@@ -103,6 +113,36 @@ CodeGeneratorWindow::CodeGeneratorWindow(QWidget *parent)
     buttonLayout->addWidget(generateCodeButton);
     buttonLayout->setSpacing(10);
 
+    // C++ 推理代码生成button
+    QPushButton* generateCppButton = new QPushButton("Generate C++ Code", this);
+    connect(generateCppButton, &QPushButton::clicked, this, &CodeGeneratorWindow::on_generateCppButton_clicked);
+    buttonLayout->addWidget(generateCppButton);
+
+    // 原生推理（检查形状与延迟）
+    QPushButton* runInferenceButton = new QPushButton("Run Native Inference", this);
+    connect(runInferenceButton, &QPushButton::clicked, this, &CodeGeneratorWindow::on_runInferenceButton_clicked);
+    buttonLayout->addWidget(runInferenceButton);
+
+    // 原生训练（全连接网络，实时损失曲线）
+    QPushButton* trainButton = new QPushButton("Train Network", this);
+    connect(trainButton, &QPushButton::clicked, this, &CodeGeneratorWindow::on_trainButton_clicked);
+    buttonLayout->addWidget(trainButton);
+
+    // 量化模拟（int8 / fp16 / bf16 的存储、误差与预测加速比）
+    QPushButton* quantizeButton = new QPushButton("Quantize", this);
+    connect(quantizeButton, &QPushButton::clicked, this, &CodeGeneratorWindow::on_quantizeButton_clicked);
+    buttonLayout->addWidget(quantizeButton);
+
+    // 幅值 / N:M 剪枝（CSR 存储与稀疏前向）
+    QPushButton* pruneButton = new QPushButton("Prune", this);
+    connect(pruneButton, &QPushButton::clicked, this, &CodeGeneratorWindow::on_pruneButton_clicked);
+    buttonLayout->addWidget(pruneButton);
+
+    // 激活投影（样本集上某层激活的 PCA 散点图）
+    QPushButton* projectButton = new QPushButton("Project", this);
+    connect(projectButton, &QPushButton::clicked, this, &CodeGeneratorWindow::on_projectButton_clicked);
+    buttonLayout->addWidget(projectButton);
+
     // 删除
     QPushButton* deleteLayerButton = new QPushButton("Delete Selected Layer", this);
     connect(deleteLayerButton, &QPushButton::clicked, this, &CodeGeneratorWindow::deleteSelectedLayer);
@@ -201,6 +241,127 @@ void CodeGeneratorWindow::on_generateCodeButton_clicked() {
     m_codeDisplay->setPlainText(code);
 }
 
+void CodeGeneratorWindow::on_runInferenceButton_clicked() {
+    QList<NeuralLayer> layers;
+    for (const NeuralLayer* layer : m_layers) {
+        if (layer) layers.append(*layer);
+    }
+
+    InferenceEngine engine;
+    QString error;
+    if (!engine.build(layers, 1, &error)) {
+        m_codeDisplay->setPlainText("# 无法构建原生推理引擎：" + error);
+        return;
+    }
+
+    // 随机输入跑若干次，展示最后一次的逐层耗时
+    std::vector<float> input(engine.inputShape().size());
+    for (size_t i = 0; i < input.size(); ++i) input[i] = std::sin(0.01f * i);
+    for (int i = 0; i < 10; ++i) engine.forward(input.data(), 1);
+    m_codeDisplay->setPlainText(engine.summary());
+}
+
+void CodeGeneratorWindow::on_trainButton_clicked() {
+    QList<NeuralLayer> layers;
+    for (const NeuralLayer* layer : m_layers) {
+        if (layer) layers.append(*layer);
+    }
+    if (layers.isEmpty()) {
+        m_codeDisplay->setPlainText("# 请先添加网络层再训练");
+        return;
+    }
+
+    TrainingDialog* dialog = new TrainingDialog(layers, this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->show();
+}
+
+void CodeGeneratorWindow::on_quantizeButton_clicked() {
+    QList<NeuralLayer> layers;
+    for (const NeuralLayer* layer : m_layers) {
+        if (layer) layers.append(*layer);
+    }
+    if (layers.isEmpty()) {
+        m_codeDisplay->setPlainText("# 请先添加网络层再量化");
+        return;
+    }
+
+    QuantizationDialog* dialog = new QuantizationDialog(layers, this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->show();
+}
+
+void CodeGeneratorWindow::on_pruneButton_clicked() {
+    QList<NeuralLayer> layers;
+    for (const NeuralLayer* layer : m_layers) {
+        if (layer) layers.append(*layer);
+    }
+    if (layers.isEmpty()) {
+        m_codeDisplay->setPlainText("# 请先添加网络层再剪枝");
+        return;
+    }
+
+    PruningDialog* dialog = new PruningDialog(layers, this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->show();
+}
+
+void CodeGeneratorWindow::on_projectButton_clicked() {
+    QList<NeuralLayer> layers;
+    for (const NeuralLayer* layer : m_layers) {
+        if (layer) layers.append(*layer);
+    }
+    if (layers.isEmpty()) {
+        m_codeDisplay->setPlainText("# 请先添加网络层再计算激活投影");
+        return;
+    }
+
+    ProjectionDialog* dialog = new ProjectionDialog(layers, this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->show();
+}
+
+void CodeGeneratorWindow::onSceneSelectionChanged() {
+    // 已加载检查点时，在属性面板显示选中层的权重统计（后台计算，不阻塞界面）
+    const QList<QGraphicsItem*> selected = m_builderScene->selectedItems();
+    NeuralLayer* layer = selected.isEmpty() ? nullptr : selected[0]->data(0).value<NeuralLayer*>();
+    const std::shared_ptr<WeightCheckpoint> checkpoint = WeightCheckpoint::active();
+    if (!layer || !checkpoint) {
+        m_propertyPanel->clearWeightStats();
+        return;
+    }
+
+    QList<NeuralLayer> layers;
+    int position = -1;
+    for (const NeuralLayer* l : m_layers) {
+        if (!l) continue;
+        if (l == layer) position = layers.size();
+        layers.append(*l);
+    }
+    const QVector<LayerWeightBinding> bindings = bindCheckpoint(*checkpoint, layers);
+    const int tensor = position >= 0 ? bindings.value(position).weight : -1;
+    if (tensor < 0) {
+        m_propertyPanel->clearWeightStats();
+        return;
+    }
+
+    const CheckpointTensor& info = checkpoint->tensors()[tensor];
+    const QString title = QString("%1 %2 %3").arg(info.name, info.shapeString(), info.dtypeName);
+    requestCheckpointStats(checkpoint, {tensor}, this, [this, layer, title](int, const WeightStats& stats) {
+        // 结果回来时仍选中同一层才显示
+        const QList<QGraphicsItem*> current = m_builderScene->selectedItems();
+        if (!current.isEmpty() && current[0]->data(0).value<NeuralLayer*>() == layer) {
+            m_propertyPanel->setWeightStats(title, stats);
+        }
+    });
+}
+
+void CodeGeneratorWindow::on_generateCppButton_clicked() {
+    // 与 PyTorch 代码使用相同的层列表，生成独立的 C++ 推理代码
+    QString code = CodeGenerator::generateCppCode(m_layers);
+    m_codeDisplay->setPlainText(code);
+}
+
 
 
 void CodeGeneratorWindow::on_layersList_itemClicked(QListWidgetItem* item) {
@@ -72,6 +72,12 @@ public:
 public slots:
     void on_return_mainwindow_clicked();//
     void on_generateCodeButton_clicked();//
+    void on_generateCppButton_clicked();
+    void on_runInferenceButton_clicked();
+    void on_trainButton_clicked();
+    void on_quantizeButton_clicked();
+    void on_pruneButton_clicked();
+    void on_projectButton_clicked();
     void on_layersList_itemClicked(QListWidgetItem* item);//
     void on_propertiesPanel_parametersUpdated(const QMap<QString, QString>& params);//
     void deleteSelectedLayer();//
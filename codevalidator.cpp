@@ -0,0 +1,484 @@
+#include "codevalidator.h"
+#include <QElapsedTimer>
+#include <QMetaObject>
+#include <QTextBlock>
+#include <QTextDocument>
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+bool isSpace(ushort c)
+{
+    return c == ' ' || c == '\t' || c == '\f' || c == '\r';
+}
+
+// 从 i 开始找三引号字符串的结尾，返回结尾之后的位置；找不到返回 -1
+int findTripleQuoteEnd(const QChar* s, int i, int n, ushort quote)
+{
+    while (i < n) {
+        const ushort c = s[i].unicode();
+        if (c == '\\') {
+            i += 2;
+            continue;
+        }
+        if (c == quote && i + 2 < n && s[i + 1].unicode() == quote && s[i + 2].unicode() == quote)
+            return i + 3;
+        ++i;
+    }
+    return -1;
+}
+
+} // namespace
+
+QString CodeDiagnostic::text() const
+{
+    return line >= 0 ? QString("第 %1 行：%2").arg(line + 1).arg(message) : message;
+}
+
+void IncrementalValidator::setText(const QString& text)
+{
+    replaceLines(0, lineCount(), text.split('\n'));
+}
+
+void IncrementalValidator::replaceLines(int first, int removed, const QStringList& lines)
+{
+    first = std::clamp(first, 0, lineCount());
+    removed = std::clamp(removed, 0, lineCount() - first);
+    const int added = lines.size();
+
+    // 替换进来的最后一行记下被替换区域原来的行尾状态，也就是后面一行原来的行首状态；
+    // 重新扫描到这一行时若状态相同，后面的行都不用再扫
+    const LexState nextEntry = removed > 0 ? m_lines[first + removed - 1].exit : entryState(first);
+
+    for (int i = first; i < first + removed; ++i)
+        countTorch(m_lines[i], -1);
+
+    std::vector<Line> inserted(added);
+    for (int i = 0; i < added; ++i) {
+        Line& line = inserted[i];
+        line.text = lines[i];
+        line.importsTorch = line.text.contains("import torch") || line.text.contains("from torch");
+        line.usesTorch = line.text.contains("nn.") || line.text.contains("torch.");
+        countTorch(line, 1);
+    }
+    if (added > 0)
+        inserted.back().exit = nextEntry;
+
+    // 行数不变时（最常见的行内输入）原地替换，避免移动后面的行
+    const int common = std::min(removed, added);
+    std::move(inserted.begin(), inserted.begin() + common, m_lines.begin() + first);
+    if (removed > common)
+        m_lines.erase(m_lines.begin() + first + common, m_lines.begin() + first + removed);
+    else if (added > common)
+        m_lines.insert(m_lines.begin() + first + common,
+                       std::make_move_iterator(inserted.begin() + common), std::make_move_iterator(inserted.end()));
+
+    markDirty(m_lexBegin, m_lexEnd, first, removed, added);
+    markDirty(m_checkBegin, m_checkEnd, first, removed, added);
+    // 只删除行时改动区域为空，仍要从删除处的下一行开始检查
+    m_lexEnd = std::max(m_lexEnd, first + 1);
+    m_checkEnd = std::max(m_checkEnd, first + 1);
+    // 前一行也要检查：改动的行顶格时，前一个代码块末尾的冒号是否跟着缩进取决于它
+    m_checkBegin = std::min(m_checkBegin, std::max(first - 1, 0));
+}
+
+void IncrementalValidator::markDirty(int& begin, int& end, int first, int removed, int added)
+{
+    const int delta = added - removed;
+    auto shift = [&](int line) {
+        if (line < first)
+            return line;
+        return line >= first + removed ? line + delta : first;
+    };
+    if (begin < end) {
+        begin = std::min(shift(begin), first);
+        end = std::max(shift(end), first + added);
+    } else {
+        begin = first;
+        end = first + added;
+    }
+}
+
+void IncrementalValidator::countTorch(const Line& line, int sign)
+{
+    if (line.importsTorch)
+        m_importLines += sign;
+    if (line.usesTorch)
+        m_torchLines += sign;
+}
+
+IncrementalValidator::LexState IncrementalValidator::entryState(int line) const
+{
+    return line > 0 ? m_lines[line - 1].exit : LexState();
+}
+
+bool IncrementalValidator::isTopLevel(int line) const
+{
+    const Line& l = m_lines[line];
+    return l.logicalStart && !l.blank && l.indent == 0;
+}
+
+void IncrementalValidator::lexLine(Line& line, const LexState& entry) const
+{
+    const QChar* s = line.text.constData();
+    const int n = line.text.size();
+    LexState state = entry;
+    state.continued = false;
+    line.lexErrors.clear();
+    line.logicalStart = entry.clean();
+    line.blank = true;
+    line.last = 0;
+    line.indent = 0;
+
+    int i = 0;
+    if (line.logicalStart) {
+        for (; i < n && isSpace(s[i].unicode()); ++i) {
+            if (s[i] == '\t')
+                line.indent = (line.indent / 8 + 1) * 8;
+            else if (s[i] == ' ')
+                ++line.indent;
+        }
+    }
+
+    // 接着上一行未结束的三引号字符串
+    if (state.quote) {
+        line.blank = false;
+        const int end = findTripleQuoteEnd(s, i, n, state.quote);
+        if (end < 0) {
+            line.last = state.quote;
+            line.exit = state;
+            return;
+        }
+        line.last = state.quote;
+        state.quote = 0;
+        i = end;
+    }
+
+    while (i < n) {
+        const ushort c = s[i].unicode();
+        if (isSpace(c)) {
+            ++i;
+            continue;
+        }
+        if (c == '#')
+            break;
+        line.blank = false;
+
+        if (c == '\'' || c == '"') {
+            line.last = c;
+            if (i + 2 < n && s[i + 1].unicode() == c && s[i + 2].unicode() == c) {
+                const int end = findTripleQuoteEnd(s, i + 3, n, c);
+                if (end < 0) {
+                    state.quote = c;
+                    break;
+                }
+                i = end;
+                continue;
+            }
+            bool closed = false;
+            for (++i; i < n; ++i) {
+                const ushort d = s[i].unicode();
+                if (d == '\\') {
+                    ++i;
+                } else if (d == c) {
+                    closed = true;
+                    ++i;
+                    break;
+                }
+            }
+            if (!closed)
+                line.lexErrors << "字符串没有结束";
+            continue;
+        }
+
+        if (c == '\\') {
+            int j = i + 1;
+            while (j < n && isSpace(s[j].unicode()))
+                ++j;
+            if (j == n) {
+                state.continued = true;
+                break;
+            }
+            line.lexErrors << "反斜杠后必须紧跟换行";
+            line.last = c;
+            ++i;
+            continue;
+        }
+
+        if (c == '(' || c == '[' || c == '{') {
+            ++state.depth;
+        } else if (c == ')' || c == ']' || c == '}') {
+            if (state.depth > 0)
+                --state.depth;
+            else
+                line.lexErrors << "括号不匹配";
+        }
+        line.last = c;
+        ++i;
+    }
+    line.exit = state;
+}
+
+bool IncrementalValidator::revalidate(const std::function<bool()>& cancelled, const std::function<void()>& progress)
+{
+    auto stop = [&] { return cancelled && cancelled(); };
+    const int count = lineCount();
+
+    // 词法：从改动的第一行扫到改动区域之后、行尾状态与原来一致的那一行
+    if (m_lexBegin < m_lexEnd) {
+        const int begin = std::min(m_lexBegin, count);
+        const int end = std::min(m_lexEnd, count);
+        int i = begin;
+        LexState state = i < count ? entryState(i) : LexState();
+        for (; i < count; ++i) {
+            if ((i - begin) % 4096 == 4095 && stop()) {
+                // 已扫描的行保留结果，剩下的留到下次；第 i 行原来的行尾状态仍可用于判断收敛
+                m_checkBegin = m_checkBegin < m_checkEnd ? std::min(m_checkBegin, begin) : begin;
+                m_checkEnd = std::max(m_checkEnd, i);
+                m_lexBegin = i;
+                m_lexEnd = std::max(end, i + 1);
+                return false;
+            }
+            Line& line = m_lines[i];
+            const LexState before = line.exit;
+            lexLine(line, state);
+            state = line.exit;
+            if (i + 1 >= end && state == before) {
+                ++i;
+                break;
+            }
+        }
+        m_checkBegin = m_checkBegin < m_checkEnd ? std::min(m_checkBegin, begin) : begin;
+        m_checkEnd = std::max(m_checkEnd, i);
+        m_lexBegin = m_lexEnd = 0;
+
+        m_unclosedLine = -1;
+        if (count > 0 && !m_lines.back().exit.clean()) {
+            const LexState tail = m_lines.back().exit;
+            int open = count - 1;
+            while (open > 0 && !m_lines[open - 1].exit.clean())
+                --open;
+            m_unclosedLine = open;
+            m_unclosedMessage = tail.quote ? QString("字符串没有结束")
+                              : tail.depth > 0 ? QString("括号没有闭合")
+                              : QString("反斜杠续行后没有内容");
+        }
+    }
+
+    // 缩进：扩展到完整的顶层代码块，逐块检查，块与块之间可以取消
+    if (m_checkBegin < m_checkEnd) {
+        if (count == 0) {
+            m_checkBegin = m_checkEnd = 0;
+            return true;
+        }
+        int begin = std::min(m_checkBegin, count - 1);
+        while (begin > 0 && !isTopLevel(begin))
+            --begin;
+        int end = std::min(m_checkEnd, count);
+        while (end < count && !isTopLevel(end))
+            ++end;
+
+        QVector<int> stack{0};
+        bool colon = false;  // 上一个逻辑行以冒号结尾，下一行必须缩进
+        int colonLine = -1;
+        for (int i = begin; i < end; ++i) {
+            if (i > begin && isTopLevel(i)) {
+                if (colon)
+                    m_lines[colonLine].blockErrors << "冒号后需要增加缩进";
+                colon = false;
+                stack = {0};
+                if (progress)
+                    progress();
+                if (stop()) {
+                    m_checkBegin = i;
+                    m_checkEnd = end;
+                    return false;
+                }
+            }
+
+            Line& line = m_lines[i];
+            line.blockErrors.clear();
+            if (line.logicalStart && line.blank)
+                continue;
+
+            if (line.logicalStart) {
+                const int indent = line.indent;
+                if (indent % 4 != 0)
+                    line.blockErrors << "缩进必须是4个空格的倍数";
+                if (colon && indent > stack.last()) {
+                    stack.append(indent);
+                } else {
+                    if (colon)
+                        m_lines[colonLine].blockErrors << "冒号后需要增加缩进";
+                    if (indent > stack.last()) {
+                        line.blockErrors << "意外的缩进";
+                        stack.append(indent);
+                    } else {
+                        while (indent < stack.last())
+                            stack.removeLast();
+                        if (indent != stack.last()) {
+                            line.blockErrors << "缩进与外层代码块不一致";
+                            stack.append(indent);
+                        }
+                    }
+                }
+                colon = false;
+            }
+            // 逻辑行在行尾状态干净的物理行结束
+            if (line.exit.clean()) {
+                colon = line.last == ':';
+                colonLine = i;
+            }
+        }
+        if (colon)
+            m_lines[colonLine].blockErrors << "冒号后需要增加缩进";
+        m_checkBegin = m_checkEnd = 0;
+    }
+    return true;
+}
+
+QVector<CodeDiagnostic> IncrementalValidator::diagnostics() const
+{
+    QVector<CodeDiagnostic> result;
+    for (int i = 0; i < lineCount(); ++i) {
+        const Line& line = m_lines[i];
+        for (const QString& message : line.lexErrors)
+            result.append({i, message});
+        for (const QString& message : line.blockErrors)
+            result.append({i, message});
+        if (i == m_unclosedLine)
+            result.append({i, m_unclosedMessage});
+    }
+    if (m_torchLines > 0 && m_importLines == 0)
+        result.append({-1, QString("使用PyTorch模块但未导入torch或torch.nn")});
+    return result;
+}
+
+AsyncCodeValidator::AsyncCodeValidator(QObject* parent)
+    : QObject(parent)
+{
+    m_debounce.setSingleShot(true);
+    m_debounce.setInterval(120);
+    connect(&m_debounce, &QTimer::timeout, this, &AsyncCodeValidator::flush);
+    m_thread = std::thread(&AsyncCodeValidator::workerLoop, this);
+}
+
+AsyncCodeValidator::~AsyncCodeValidator()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        m_queue.clear();
+    }
+    ++m_generation;  // 让正在进行的检查在下一个代码块边界停下
+    m_wake.notify_one();
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+void AsyncCodeValidator::attach(QTextDocument* document)
+{
+    if (m_document)
+        disconnect(m_document, nullptr, this, nullptr);
+    m_document = document;
+    m_pending.clear();
+    m_debounce.stop();
+    ++m_generation;
+    if (!document)
+        return;
+
+    Edit all;
+    all.removed = -1;
+    for (QTextBlock block = document->begin(); block.isValid(); block = block.next())
+        all.lines << block.text();
+    m_blockCount = document->blockCount();
+    m_pending.append(all);
+    connect(document, &QTextDocument::contentsChange, this, &AsyncCodeValidator::onContentsChange);
+    flush();
+}
+
+void AsyncCodeValidator::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+    if (!m_document)
+        return;
+
+    // 改动后的文本是 [position, position + charsAdded]，覆盖到的块就是替换进来的行；
+    // 被替换掉的旧行数由块数的变化推出
+    QTextBlock block = m_document->findBlock(position);
+    QTextBlock last = m_document->findBlock(position + charsAdded);
+    if (!block.isValid())
+        block = m_document->lastBlock();
+    if (!last.isValid())
+        last = m_document->lastBlock();
+    const int lastNumber = last.blockNumber();
+
+    Edit edit;
+    edit.first = block.blockNumber();
+    for (; block.isValid() && block.blockNumber() <= lastNumber; block = block.next())
+        edit.lines << block.text();
+    const int blockCount = m_document->blockCount();
+    edit.removed = edit.lines.size() - (blockCount - m_blockCount);
+    m_blockCount = blockCount;
+
+    m_pending.append(edit);
+    ++m_generation;
+    m_debounce.start();
+}
+
+void AsyncCodeValidator::flush()
+{
+    if (m_pending.isEmpty())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue += m_pending;
+    }
+    m_pending.clear();
+    m_wake.notify_one();
+}
+
+void AsyncCodeValidator::workerLoop()
+{
+    for (;;) {
+        QVector<Edit> edits;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stop || !m_queue.isEmpty(); });
+            if (m_stop)
+                return;
+            edits.swap(m_queue);
+        }
+        for (const Edit& edit : edits) {
+            if (edit.removed < 0)
+                m_validator.replaceLines(0, m_validator.lineCount(), edit.lines);
+            else
+                m_validator.replaceLines(edit.first, edit.removed, edit.lines);
+        }
+
+        // 检查期间又有输入时放弃，等下一批编辑到达后从剩下的区域继续
+        const quint64 generation = m_generation.load();
+        QElapsedTimer sincePublish;
+        sincePublish.start();
+        const bool finished = m_validator.revalidate(
+            [this, generation] { return m_generation.load() != generation; },
+            [&] {
+                if (sincePublish.elapsed() >= 30) {
+                    publish(generation, false);
+                    sincePublish.restart();
+                }
+            });
+        if (finished)
+            publish(generation, true);
+    }
+}
+
+void AsyncCodeValidator::publish(quint64 generation, bool finished)
+{
+    const QVector<CodeDiagnostic> diagnostics = m_validator.diagnostics();
+    QMetaObject::invokeMethod(this, [this, generation, diagnostics, finished]() {
+        if (generation == m_generation.load())
+            emit diagnosticsReady(diagnostics, finished);
+    }, Qt::QueuedConnection);
+}
@@ -0,0 +1,138 @@
+#ifndef CODEVALIDATOR_H
+#define CODEVALIDATOR_H
+
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+#include <QtGlobal>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class QTextDocument;
+
+// 一条校验结果
+struct CodeDiagnostic
+{
+    int line = -1;     // 从 0 开始；-1 表示与具体行无关（如缺少 import）
+    QString message;
+
+    QString text() const;  // "第 N 行：……"，与行无关时只有 message
+    bool operator==(const CodeDiagnostic& other) const { return line == other.line && message == other.message; }
+};
+
+// 增量校验 Python 源码：每行保存行首/行尾的词法状态（所处的三引号字符串、括号深度、反斜杠续行），
+// 编辑后从改动的第一行重新扫描，直到某行的行尾状态与改动前一致为止；缩进规则只在包含这些行的
+// 顶层代码块（从上一个顶格语句到下一个顶格语句）内重新检查。不依赖 Qt 的界面类，可在任意线程使用
+class IncrementalValidator
+{
+public:
+    IncrementalValidator() = default;
+
+    void setText(const QString& text);
+    // 把 [first, first + removed) 行替换为 lines（lines 中不含换行符）
+    void replaceLines(int first, int removed, const QStringList& lines);
+    int lineCount() const { return static_cast<int>(m_lines.size()); }
+
+    // 检查编辑过的区域。cancelled 返回 true 时在下一个顶层代码块边界（词法扫描时每 4096 行）停下并返回 false，
+    // 未检查的部分留到下次；每检查完一段调用一次 progress。两者都可以为空
+    bool revalidate(const std::function<bool()>& cancelled = {}, const std::function<void()>& progress = {});
+    bool isDirty() const { return m_lexBegin < m_lexEnd || m_checkBegin < m_checkEnd; }
+
+    // 全部结果，按行排序
+    QVector<CodeDiagnostic> diagnostics() const;
+
+private:
+    struct LexState
+    {
+        ushort quote = 0;       // 未结束的三引号字符串的引号字符
+        bool continued = false; // 行尾反斜杠续行
+        int depth = 0;          // 未闭合的括号数
+
+        bool clean() const { return quote == 0 && !continued && depth == 0; }
+        bool operator==(const LexState& o) const { return quote == o.quote && continued == o.continued && depth == o.depth; }
+        bool operator!=(const LexState& o) const { return !(*this == o); }
+    };
+
+    struct Line
+    {
+        QString text;
+        LexState exit;            // 行尾状态
+        int indent = 0;           // 逻辑行首的缩进宽度（制表符补到 8 的倍数）
+        bool logicalStart = false;// 行首不在字符串、括号或续行之中
+        bool blank = true;        // 空行或只有注释
+        ushort last = 0;          // 字符串与注释之外的最后一个非空白字符
+        bool importsTorch = false;
+        bool usesTorch = false;
+        QStringList lexErrors;    // 字符串没有结束、括号不匹配
+        QStringList blockErrors;  // 缩进
+    };
+
+    LexState entryState(int line) const;
+    void lexLine(Line& line, const LexState& entry) const;
+    bool isTopLevel(int line) const;
+    void countTorch(const Line& line, int sign);
+    void markDirty(int& begin, int& end, int first, int removed, int added);
+
+    std::vector<Line> m_lines;
+    int m_lexBegin = 0;    // 需要重新词法扫描的行区间
+    int m_lexEnd = 0;
+    int m_checkBegin = 0;  // 需要重新检查缩进的行区间
+    int m_checkEnd = 0;
+    int m_importLines = 0; // 含 import torch / from torch 的行数
+    int m_torchLines = 0;  // 含 nn. / torch. 的行数
+    int m_unclosedLine = -1;  // 文件结束时仍未闭合的字符串/括号/续行从这一行开始
+    QString m_unclosedMessage;
+};
+
+// 编辑器用的异步校验：跟随 QTextDocument 的 contentsChange，只取出改动的行；停止输入 debounce 毫秒后
+// 交给后台线程增量检查。新的输入会让正在进行的检查在下一个代码块边界放弃，结果带代数，过期的不再发出
+class AsyncCodeValidator : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AsyncCodeValidator(QObject* parent = nullptr);
+    ~AsyncCodeValidator() override;
+
+    void attach(QTextDocument* document);
+    void setDebounceInterval(int ms) { m_debounce.setInterval(ms); }
+
+signals:
+    // 当前全部结果（行号对应发出时的文档）；大文件首次检查时分段发出，finished 为 false 表示仍在检查
+    void diagnosticsReady(const QVector<CodeDiagnostic>& diagnostics, bool finished);
+
+private:
+    struct Edit
+    {
+        int first = 0;
+        int removed = 0;  // -1：替换全文
+        QStringList lines;
+    };
+
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void flush();
+    void workerLoop();
+    void publish(quint64 generation, bool finished);
+
+    QPointer<QTextDocument> m_document;
+    QTimer m_debounce;
+    int m_blockCount = 0;
+    QVector<Edit> m_pending;  // 界面线程：等待 debounce 的编辑
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    QVector<Edit> m_queue;    // 已交给后台线程、尚未应用的编辑
+    bool m_stop = false;
+    std::atomic<quint64> m_generation{0};  // 每次编辑加一
+    IncrementalValidator m_validator;       // 只在后台线程访问
+};
+
+#endif // CODEVALIDATOR_H
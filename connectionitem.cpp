@@ -2,9 +2,11 @@
 #include "connectionitem.h"
 #include "colorthememanager.h"
 #include <QPen>
+#include <QtGlobal>
+#include <cmath>
 
 ConnectionItem::ConnectionItem(const QPointF& from, const QPointF& to, double weight)
-    : m_weight(weight) {
+    : m_weight(weight), m_magnitude(weight) {
     setLine(QLineF(from, to));
     updateColor();  // 初始化颜色
     setZValue(0);
@@ -14,10 +16,21 @@ void ConnectionItem::updateColor() {
     const ColorTheme& theme = ColorThemeManager::currentTheme();
     QPen pen;
     pen.setColor(m_weight > 0.5 ? theme.connectionHighWeight : theme.connectionLowWeight);
-    pen.setWidthF(0.1 + m_weight * 1.9);
+    pen.setWidthF(0.1 + m_magnitude * 1.9);
     setPen(pen);
 }
 
+void ConnectionItem::setSignedWeight(double value, double maxAbs) {
+    const double ratio = maxAbs > 0.0 ? qBound(-1.0, value / maxAbs, 1.0) : 0.0;
+    const double weight = 0.5 + 0.5 * ratio;
+    const double magnitude = std::fabs(ratio);
+    // 训练时每次刷新都会对全部连线调用，变化很小时跳过重绘
+    if (std::fabs(weight - m_weight) < 1e-3 && std::fabs(magnitude - m_magnitude) < 1e-3) return;
+    m_weight = weight;
+    m_magnitude = magnitude;
+    updateColor();
+}
+
 void ConnectionItem::updateLine(const QPointF& from, const QPointF& to) {
     setLine(QLineF(from, to));
 }
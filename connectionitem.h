@@ -11,7 +11,10 @@ public:
 
     void updateColor();  // 根据当前主题更新颜色
     double weight() const { return m_weight; }
+    // 用真实权重着色：正负决定颜色，|value|/maxAbs 决定线宽
+    void setSignedWeight(double value, double maxAbs);
 
 private:
     double m_weight;
+    double m_magnitude;  // 线宽比例 0~1
 };
@@ -0,0 +1,214 @@
+#include "convautotuner.h"
+#include "simdutils.h"
+#include "threadpool.h"
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr int kCacheVersion = 1;
+const ConvAlgorithm kAlgorithms[] = {ConvAlgorithm::Im2colGemm, ConvAlgorithm::Direct, ConvAlgorithm::Winograd};
+// 尚未计时的形状先用 im2col：任何形状都支持，且多数形状下与最优相差不大
+constexpr ConvAlgorithm kHeuristic = ConvAlgorithm::Im2colGemm;
+
+} // namespace
+
+ConvAutotuner::ConvAutotuner(const QString& cachePath) : m_path(cachePath) {
+    // 后台计时用全局线程池，保证它在本对象之后析构
+    ThreadPool::global();
+}
+
+ConvAutotuner::~ConvAutotuner() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_changed.notify_all();
+    if (m_worker.joinable()) m_worker.join();
+}
+
+ConvAutotuner& ConvAutotuner::instance() {
+    static ConvAutotuner tuner;
+    return tuner;
+}
+
+QString ConvAutotuner::key(const ConvShape& s, ThreadPool* pool) const {
+    return QString("%1x%2x%3-f%4-k%5-p%6-t%7-%8")
+        .arg(s.channels).arg(s.height).arg(s.width).arg(s.filters).arg(s.kernel).arg(s.pad)
+        .arg(pool->threadCount())
+        .arg(simd::hasAvx2() ? "avx2" : "scalar");
+}
+
+ConvAlgorithm ConvAutotuner::select(const ConvShape& shape, ThreadPool* pool) {
+    if (!pool) pool = &ThreadPool::global();
+    const QString k = key(shape, pool);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_loaded) load();
+    auto it = m_results.constFind(k);
+    if (it != m_results.constEnd()) return it.value().algorithm;
+    if (!m_inFlight.contains(k)) {
+        m_inFlight.insert(k);
+        m_queue.push_back({k, shape, pool->threadCount()});
+        if (!m_worker.joinable()) m_worker = std::thread([this] { workerLoop(); });
+        m_changed.notify_all();
+    }
+    return kHeuristic;
+}
+
+ConvAutotuner::Result ConvAutotuner::result(const ConvShape& shape, ThreadPool* pool) {
+    if (!pool) pool = &ThreadPool::global();
+    const QString k = key(shape, pool);
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_loaded) load();
+        m_changed.wait(lock, [&] { return !m_inFlight.contains(k); });
+        auto it = m_results.constFind(k);
+        if (it != m_results.constEnd()) return it.value();
+        m_inFlight.insert(k);
+    }
+    const Result r = measure(shape, pool);
+    finish(k, r);
+    return r;
+}
+
+// 结果先对 select 可见，写完缓存文件后才解除等待
+void ConvAutotuner::finish(const QString& key, const Result& r) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_results.insert(key, r);
+    }
+    save();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_inFlight.remove(key);
+    }
+    m_changed.notify_all();
+}
+
+void ConvAutotuner::workerLoop() {
+    std::unique_ptr<ThreadPool> ownPool;
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_changed.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+            if (m_stop) return;
+            job = m_queue.front();
+            m_queue.pop_front();
+        }
+        // 按请求方线程池的线程数计时，结果才与缓存键对应
+        ThreadPool* pool = &ThreadPool::global();
+        if (pool->threadCount() != job.threads) {
+            if (!ownPool || ownPool->threadCount() != job.threads) ownPool = std::make_unique<ThreadPool>(job.threads);
+            pool = ownPool.get();
+        }
+        finish(job.key, measure(job.shape, pool));
+    }
+}
+
+ConvAutotuner::Result ConvAutotuner::measure(const ConvShape& shape, ThreadPool* pool) {
+    if (!pool) pool = &ThreadPool::global();
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<float> x(static_cast<std::size_t>(shape.channels) * shape.height * shape.width);
+    std::vector<float> w(static_cast<std::size_t>(shape.filters) * shape.patchSize());
+    std::vector<float> y(static_cast<std::size_t>(shape.filters) * shape.outHeight() * shape.outWidth());
+    for (float& v : x) v = dist(rng);
+    for (float& v : w) v = dist(rng);
+
+    Result r;
+    double best = -1.0;
+    for (ConvAlgorithm algorithm : kAlgorithms) {
+        if (!convAlgorithmSupported(shape, algorithm)) continue;
+        simd::AlignedBuffer scratch;
+        simd::AlignedBuffer transformed;
+        scratch.resize(static_cast<std::size_t>(convScratchSize(shape, algorithm)));
+        transformed.resize(static_cast<std::size_t>(convTransformedWeightSize(shape, algorithm)));
+        convTransformWeights(shape, algorithm, w.data(), transformed.data());
+
+        // 预热一次后取若干次中的最小值；大形状最多累计约 50 ms
+        auto run = [&] { conv2d(shape, algorithm, x.data(), w.data(), transformed.data(), y.data(), scratch.data(), pool); };
+        run();
+        double minMs = 0.0;
+        double totalMs = 0.0;
+        for (int i = 0; i < 5 && (i < 3 || totalMs < 50.0); ++i) {
+            const auto t0 = std::chrono::steady_clock::now();
+            run();
+            const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            minMs = i == 0 ? ms : std::min(minMs, ms);
+            totalMs += ms;
+        }
+        r.timesMs[static_cast<int>(algorithm)] = minMs;
+        if (best < 0.0 || minMs < best) {
+            best = minMs;
+            r.algorithm = algorithm;
+        }
+    }
+    return r;
+}
+
+void ConvAutotuner::clear() {
+    std::lock_guard<std::mutex> fileLock(m_fileMutex);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_results.clear();
+    m_loaded = true;
+    QFile::remove(m_path);
+}
+
+void ConvAutotuner::load() {
+    m_loaded = true;
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly)) return;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+    file.close();
+    const QJsonObject root = doc.object();
+    if (root["version"].toInt() != kCacheVersion) return;
+
+    const QJsonObject shapes = root["shapes"].toObject();
+    for (auto it = shapes.constBegin(); it != shapes.constEnd(); ++it) {
+        const QJsonObject entry = it.value().toObject();
+        Result r;
+        if (!convAlgorithmFromName(entry["algorithm"].toString().toUtf8().constData(), &r.algorithm)) continue;
+        for (ConvAlgorithm algorithm : kAlgorithms)
+            r.timesMs[static_cast<int>(algorithm)] = entry[convAlgorithmName(algorithm)].toDouble(-1.0);
+        r.fromCache = true;
+        m_results.insert(it.key(), r);
+    }
+}
+
+void ConvAutotuner::save() {
+    // 快照在文件锁内获取，后写入的总是更新的结果
+    std::lock_guard<std::mutex> fileLock(m_fileMutex);
+    QHash<QString, Result> results;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        results = m_results;
+    }
+    QJsonObject shapes;
+    for (auto it = results.constBegin(); it != results.constEnd(); ++it) {
+        QJsonObject entry;
+        entry["algorithm"] = convAlgorithmName(it.value().algorithm);
+        for (ConvAlgorithm algorithm : kAlgorithms) {
+            const double ms = it.value().timesMs[static_cast<int>(algorithm)];
+            if (ms >= 0.0) entry[convAlgorithmName(algorithm)] = ms;
+        }
+        shapes[it.key()] = entry;
+    }
+    QJsonObject root;
+    root["version"] = kCacheVersion;
+    root["shapes"] = shapes;
+
+    // 先写临时文件再替换，中途退出不会留下截断的缓存
+    QSaveFile file(m_path);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(QJsonDocument(root).toJson());
+        file.commit();
+    }
+}
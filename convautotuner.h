@@ -0,0 +1,69 @@
+#ifndef CONVAUTOTUNER_H
+#define CONVAUTOTUNER_H
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "convkernels.h"
+
+class ThreadPool;
+
+// 按卷积形状实测选择最快的算法
+// 每个 (形状, 线程数, SIMD 路径) 只在第一次遇到时计时一次，结果写入 JSON 缓存文件，下次启动直接复用；
+// 计时在锁外进行，同一形状同时只测量一次
+class ConvAutotuner
+{
+public:
+    struct Result {
+        ConvAlgorithm algorithm = ConvAlgorithm::Im2colGemm;
+        double timesMs[3] = {-1.0, -1.0, -1.0};  // 按 ConvAlgorithm 顺序，不适用的算法为 -1
+        bool fromCache = false;
+    };
+
+    explicit ConvAutotuner(const QString& cachePath = "conv_autotune.json");
+    ~ConvAutotuner();
+
+    // 全局实例，缓存文件与 history.json 同放在工作目录
+    static ConvAutotuner& instance();
+
+    // 不阻塞：已有结果时直接返回；否则交给后台线程计时，在结果出来之前返回启发式选择（im2col）
+    ConvAlgorithm select(const ConvShape& shape, ThreadPool* pool = nullptr);
+    // 阻塞：没有结果时在调用线程计时（该形状正在后台计时则等它完成），供基准与校准线程使用
+    Result result(const ConvShape& shape, ThreadPool* pool = nullptr);
+
+    // 不查缓存，直接对各可用算法计时
+    static Result measure(const ConvShape& shape, ThreadPool* pool = nullptr);
+
+    QString cachePath() const { return m_path; }
+    void clear();
+
+private:
+    struct Job {
+        QString key;
+        ConvShape shape;
+        int threads = 1;
+    };
+
+    QString key(const ConvShape& shape, ThreadPool* pool) const;
+    void load();
+    void save();
+    void finish(const QString& key, const Result& r);
+    void workerLoop();
+
+    QString m_path;
+    bool m_loaded = false;
+    std::mutex m_mutex;
+    std::mutex m_fileMutex;  // 串行化缓存文件的写入，先于 m_mutex 加锁
+    std::condition_variable m_changed;  // 有新任务，或某个形状计时完成
+    QHash<QString, Result> m_results;
+    QSet<QString> m_inFlight;  // 正在计时或排队等待计时的键
+    std::deque<Job> m_queue;
+    std::thread m_worker;
+    bool m_stop = false;
+};
+
+#endif // CONVAUTOTUNER_H
@@ -0,0 +1,423 @@
+#include "convkernels.h"
+#include "gemm.h"
+#include "simdutils.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+const char* convAlgorithmName(ConvAlgorithm algorithm) {
+    switch (algorithm) {
+    case ConvAlgorithm::Im2colGemm: return "im2col";
+    case ConvAlgorithm::Direct: return "direct";
+    case ConvAlgorithm::Winograd: return "winograd";
+    }
+    return "im2col";
+}
+
+bool convAlgorithmFromName(const char* name, ConvAlgorithm* algorithm) {
+    for (ConvAlgorithm a : {ConvAlgorithm::Im2colGemm, ConvAlgorithm::Direct, ConvAlgorithm::Winograd}) {
+        if (std::strcmp(name, convAlgorithmName(a)) == 0) {
+            *algorithm = a;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool convAlgorithmSupported(const ConvShape& shape, ConvAlgorithm algorithm) {
+    switch (algorithm) {
+    case ConvAlgorithm::Im2colGemm: return true;
+    case ConvAlgorithm::Direct: return shape.kernel <= 5;
+    case ConvAlgorithm::Winograd: return shape.kernel == 3;
+    }
+    return false;
+}
+
+long long im2colScratchSize(const ConvShape& shape) {
+    return static_cast<long long>(shape.patchSize()) * shape.outHeight() * shape.outWidth();
+}
+
+namespace {
+
+// 直接卷积先把输入复制到补零后的 C×(H+2p)×(W+2p) 缓冲区，窗口计算不再需要边界判断；
+// 末尾多留几个 float，行尾不足一个向量时越界读取的部分只影响不写回的通道
+constexpr int kDirectSlack = 16;
+
+int paddedHeight(const ConvShape& s) { return s.height + 2 * s.pad; }
+int paddedWidth(const ConvShape& s) { return s.width + 2 * s.pad; }
+
+// Winograd 的 2×2 输出块数
+long long winogradTiles(const ConvShape& s) {
+    return static_cast<long long>((s.outHeight() + 1) / 2) * ((s.outWidth() + 1) / 2);
+}
+
+} // namespace
+
+long long convScratchSize(const ConvShape& shape, ConvAlgorithm algorithm) {
+    switch (algorithm) {
+    case ConvAlgorithm::Im2colGemm: return im2colScratchSize(shape);
+    case ConvAlgorithm::Direct:
+        return static_cast<long long>(shape.channels) * paddedHeight(shape) * paddedWidth(shape) + kDirectSlack;
+    case ConvAlgorithm::Winograd: return 16LL * (shape.channels + shape.filters) * winogradTiles(shape);
+    }
+    return 0;
+}
+
+long long convTransformedWeightSize(const ConvShape& shape, ConvAlgorithm algorithm) {
+    return algorithm == ConvAlgorithm::Winograd ? 16LL * shape.filters * shape.channels : 0;
+}
+
+namespace {
+
+// col 的每一行对应 (c, ky, kx)，列为输出像素；越界位置填 0
+void im2col(const ConvShape& s, const float* x, float* col, ThreadPool* pool) {
+    const int oh = s.outHeight();
+    const int ow = s.outWidth();
+    const int kk = s.kernel * s.kernel;
+    pool->parallelFor(0, s.patchSize(), 8, [&](int first, int last) {
+        for (int row = first; row < last; ++row) {
+            const int c = row / kk;
+            const int ky = (row % kk) / s.kernel;
+            const int kx = row % s.kernel;
+            const float* xc = x + static_cast<std::size_t>(c) * s.height * s.width;
+            float* dst = col + static_cast<std::size_t>(row) * oh * ow;
+            const int x0 = std::max(0, s.pad - kx);
+            const int x1 = std::min(ow, s.width + s.pad - kx);
+            for (int oy = 0; oy < oh; ++oy) {
+                float* d = dst + oy * ow;
+                const int iy = oy + ky - s.pad;
+                if (iy < 0 || iy >= s.height || x1 <= x0) {
+                    std::fill(d, d + ow, 0.0f);
+                    continue;
+                }
+                std::fill(d, d + x0, 0.0f);
+                std::memcpy(d + x0, xc + iy * s.width + x0 + kx - s.pad, sizeof(float) * (x1 - x0));
+                std::fill(d + x1, d + ow, 0.0f);
+            }
+        }
+    });
+}
+
+void padInput(const ConvShape& s, const float* x, float* xp, ThreadPool* pool) {
+    const int hp = paddedHeight(s);
+    const int wp = paddedWidth(s);
+    pool->parallelFor(0, s.channels, 1, [&](int first, int last) {
+        for (int c = first; c < last; ++c) {
+            float* dst = xp + static_cast<std::size_t>(c) * hp * wp;
+            const float* src = x + static_cast<std::size_t>(c) * s.height * s.width;
+            std::fill(dst, dst + static_cast<std::size_t>(s.pad) * wp, 0.0f);
+            for (int iy = 0; iy < s.height; ++iy) {
+                float* row = dst + static_cast<std::size_t>(iy + s.pad) * wp;
+                std::fill(row, row + s.pad, 0.0f);
+                std::memcpy(row + s.pad, src + static_cast<std::size_t>(iy) * s.width, sizeof(float) * s.width);
+                std::fill(row + s.pad + s.width, row + wp, 0.0f);
+            }
+            std::fill(dst + static_cast<std::size_t>(s.pad + s.height) * wp, dst + static_cast<std::size_t>(hp) * wp, 0.0f);
+        }
+    });
+    std::fill(xp + static_cast<std::size_t>(s.channels) * hp * wp,
+              xp + static_cast<std::size_t>(s.channels) * hp * wp + kDirectSlack, 0.0f);
+}
+
+constexpr int kDirectFilters = 4;
+
+#if NNV_HAVE_AVX2
+// NF 个卷积核 × (8·V) 个连续像素的寄存器块，累加器全程留在寄存器中；
+// count 为实际输出的像素数，最后一个向量不满时用掩码写回
+template <int NF, int V>
+NNV_AVX2 void directBlock(const ConvShape& s, const float* xp, const float* w, float* y, int f0, int oy, int ox, int count) {
+    const int oh = s.outHeight();
+    const int ow = s.outWidth();
+    const int hp = paddedHeight(s);
+    const int wp = paddedWidth(s);
+    const int kk = s.kernel * s.kernel;
+    const std::size_t patch = s.patchSize();
+    __m256 acc[NF][V];
+    for (int j = 0; j < NF; ++j)
+        for (int v = 0; v < V; ++v) acc[j][v] = _mm256_setzero_ps();
+
+    for (int c = 0; c < s.channels; ++c) {
+        for (int ky = 0; ky < s.kernel; ++ky) {
+            const float* xr = xp + (static_cast<std::size_t>(c) * hp + oy + ky) * wp + ox;
+            const float* wr = w + f0 * patch + c * kk + ky * s.kernel;
+            for (int kx = 0; kx < s.kernel; ++kx) {
+                __m256 in[V];
+                for (int v = 0; v < V; ++v) in[v] = _mm256_loadu_ps(xr + kx + 8 * v);
+                for (int j = 0; j < NF; ++j) {
+                    const __m256 wv = _mm256_broadcast_ss(wr + j * patch + kx);
+                    for (int v = 0; v < V; ++v) acc[j][v] = _mm256_fmadd_ps(wv, in[v], acc[j][v]);
+                }
+            }
+        }
+    }
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    for (int j = 0; j < NF; ++j) {
+        float* yr = y + (static_cast<std::size_t>(f0 + j) * oh + oy) * ow + ox;
+        for (int v = 0; v < V; ++v) {
+            const int n = count - 8 * v;
+            if (n >= 8) _mm256_storeu_ps(yr + 8 * v, acc[j][v]);
+            else if (n > 0) _mm256_maskstore_ps(yr + 8 * v, _mm256_cmpgt_epi32(_mm256_set1_epi32(n), lanes), acc[j][v]);
+        }
+    }
+}
+
+template <int NF>
+NNV_AVX2 void directRow(const ConvShape& s, const float* xp, const float* w, float* y, int f0, int oy) {
+    const int ow = s.outWidth();
+    int ox = 0;
+    for (; ow - ox > 8; ox += 16) directBlock<NF, 2>(s, xp, w, y, f0, oy, ox, std::min(16, ow - ox));
+    if (ox < ow) directBlock<NF, 1>(s, xp, w, y, f0, oy, ox, ow - ox);
+}
+
+NNV_AVX2 void directRowAvx2(const ConvShape& s, const float* xp, const float* w, float* y, int f0, int nf, int oy) {
+    switch (nf) {
+    case 1: directRow<1>(s, xp, w, y, f0, oy); break;
+    case 2: directRow<2>(s, xp, w, y, f0, oy); break;
+    case 3: directRow<3>(s, xp, w, y, f0, oy); break;
+    default: directRow<4>(s, xp, w, y, f0, oy); break;
+    }
+}
+#endif
+
+// 标量路径：nf 个卷积核在第 oy 行 [ox0, ox1) 的输出
+void directScalar(const ConvShape& s, const float* xp, const float* w, float* y,
+                  int f0, int nf, int oy, int ox0, int ox1) {
+    const int oh = s.outHeight();
+    const int ow = s.outWidth();
+    const int hp = paddedHeight(s);
+    const int wp = paddedWidth(s);
+    const int kk = s.kernel * s.kernel;
+    for (int j = 0; j < nf; ++j) {
+        const float* wf = w + static_cast<std::size_t>(f0 + j) * s.patchSize();
+        float* yr = y + (static_cast<std::size_t>(f0 + j) * oh + oy) * ow;
+        for (int ox = ox0; ox < ox1; ++ox) {
+            float acc = 0.0f;
+            for (int c = 0; c < s.channels; ++c) {
+                for (int ky = 0; ky < s.kernel; ++ky) {
+                    const float* xr = xp + (static_cast<std::size_t>(c) * hp + oy + ky) * wp + ox;
+                    const float* wr = wf + c * kk + ky * s.kernel;
+                    for (int kx = 0; kx < s.kernel; ++kx) acc += wr[kx] * xr[kx];
+                }
+            }
+            yr[ox] = acc;
+        }
+    }
+}
+
+// Winograd F(2,3) 的变换矩阵：
+//   G  = [1 0 0; ½ ½ ½; ½ -½ ½; 0 0 1]
+//   Bᵀ = [1 0 -1 0; 0 1 1 0; 0 -1 1 0; 0 1 0 -1]
+//   Aᵀ = [1 1 1 0; 0 1 -1 -1]
+void winogradFilter(const float* g, float* u, std::size_t stride) {
+    float t[4][3];
+    for (int j = 0; j < 3; ++j) {
+        t[0][j] = g[j];
+        t[1][j] = 0.5f * (g[j] + g[3 + j] + g[6 + j]);
+        t[2][j] = 0.5f * (g[j] - g[3 + j] + g[6 + j]);
+        t[3][j] = g[6 + j];
+    }
+    for (int i = 0; i < 4; ++i) {
+        u[(4 * i + 0) * stride] = t[i][0];
+        u[(4 * i + 1) * stride] = 0.5f * (t[i][0] + t[i][1] + t[i][2]);
+        u[(4 * i + 2) * stride] = 0.5f * (t[i][0] - t[i][1] + t[i][2]);
+        u[(4 * i + 3) * stride] = t[i][2];
+    }
+}
+
+void winogradInput(const float (&d)[4][4], float* v, std::size_t stride) {
+    float t[4][4];
+    for (int j = 0; j < 4; ++j) {
+        t[0][j] = d[0][j] - d[2][j];
+        t[1][j] = d[1][j] + d[2][j];
+        t[2][j] = d[2][j] - d[1][j];
+        t[3][j] = d[1][j] - d[3][j];
+    }
+    for (int i = 0; i < 4; ++i) {
+        v[(4 * i + 0) * stride] = t[i][0] - t[i][2];
+        v[(4 * i + 1) * stride] = t[i][1] + t[i][2];
+        v[(4 * i + 2) * stride] = t[i][2] - t[i][1];
+        v[(4 * i + 3) * stride] = t[i][1] - t[i][3];
+    }
+}
+
+template <bool MAX>
+void pool2d(const float* x, float* y, int channels, int height, int width, int kernel, int stride, ThreadPool* pool) {
+    const int oh = (height - kernel) / stride + 1;
+    const int ow = (width - kernel) / stride + 1;
+    const float scale = 1.0f / (kernel * kernel);
+    pool->parallelFor(0, channels, 1, [&](int first, int last) {
+        for (int c = first; c < last; ++c) {
+            const float* xc = x + static_cast<std::size_t>(c) * height * width;
+            float* yc = y + static_cast<std::size_t>(c) * oh * ow;
+            for (int oy = 0; oy < oh; ++oy) {
+                float* yr = yc + oy * ow;
+                // 先把窗口第一行写入，再按行合并，内层沿 ox 连续
+                for (int ky = 0; ky < kernel; ++ky) {
+                    const float* xr = xc + (oy * stride + ky) * width;
+                    for (int ox = 0; ox < ow; ++ox) {
+                        const float* w = xr + ox * stride;
+                        float acc = MAX ? -std::numeric_limits<float>::infinity() : 0.0f;
+                        for (int kx = 0; kx < kernel; ++kx) acc = MAX ? std::max(acc, w[kx]) : acc + w[kx];
+                        if (ky == 0) yr[ox] = acc;
+                        else yr[ox] = MAX ? std::max(yr[ox], acc) : yr[ox] + acc;
+                    }
+                }
+                if (!MAX)
+                    for (int ox = 0; ox < ow; ++ox) yr[ox] *= scale;
+            }
+        }
+    });
+}
+
+} // namespace
+
+void conv2dIm2col(const ConvShape& shape, const float* x, const float* w, float* y, float* scratch, ThreadPool* pool) {
+    if (!pool) pool = &ThreadPool::global();
+    const int spatial = shape.outHeight() * shape.outWidth();
+    const float* col = x;
+    if (shape.kernel != 1 || shape.pad != 0) {
+        im2col(shape, x, scratch, pool);
+        col = scratch;
+    }
+    sgemm(shape.filters, spatial, shape.patchSize(), w, shape.patchSize(), col, spatial, false, y, spatial, false, pool);
+}
+
+void conv2dDirect(const ConvShape& s, const float* x, const float* w, float* y, float* scratch, ThreadPool* pool) {
+    if (!pool) pool = &ThreadPool::global();
+    padInput(s, x, scratch, pool);
+    const float* xp = scratch;
+    const int oh = s.outHeight();
+    const int groups = (s.filters + kDirectFilters - 1) / kDirectFilters;
+    pool->parallelFor(0, groups * oh, 1, [&](int first, int last) {
+        for (int task = first; task < last; ++task) {
+            const int f0 = (task / oh) * kDirectFilters;
+            const int oy = task % oh;
+            const int nf = std::min(kDirectFilters, s.filters - f0);
+#if NNV_HAVE_AVX2
+            if (simd::hasAvx2()) {
+                directRowAvx2(s, xp, w, y, f0, nf, oy);
+                continue;
+            }
+#endif
+            directScalar(s, xp, w, y, f0, nf, oy, 0, s.outWidth());
+        }
+    });
+}
+
+void convTransformWeights(const ConvShape& shape, ConvAlgorithm algorithm, const float* w, float* transformed) {
+    if (algorithm != ConvAlgorithm::Winograd) return;
+    const std::size_t fc = static_cast<std::size_t>(shape.filters) * shape.channels;
+    for (std::size_t i = 0; i < fc; ++i) winogradFilter(w + i * 9, transformed + i, fc);
+}
+
+void conv2dWinograd(const ConvShape& s, const float* x, const float* u, float* y, float* scratch, ThreadPool* pool) {
+    if (!pool) pool = &ThreadPool::global();
+    const int oh = s.outHeight();
+    const int ow = s.outWidth();
+    const int tilesY = (oh + 1) / 2;
+    const int tilesX = (ow + 1) / 2;
+    const std::size_t tiles = static_cast<std::size_t>(tilesY) * tilesX;
+    const std::size_t vStride = static_cast<std::size_t>(s.channels) * tiles;  // V: [16][C][tiles]
+    const std::size_t mStride = static_cast<std::size_t>(s.filters) * tiles;   // M: [16][F][tiles]
+    float* v = scratch;
+    float* m = scratch + 16 * vStride;
+
+    // 输入变换：每个 4×4 输入块（步长 2，越界补 0）变换为 16 个分量
+    pool->parallelFor(0, s.channels, 1, [&](int first, int last) {
+        for (int c = first; c < last; ++c) {
+            const float* xc = x + static_cast<std::size_t>(c) * s.height * s.width;
+            for (int ty = 0; ty < tilesY; ++ty) {
+                for (int tx = 0; tx < tilesX; ++tx) {
+                    float d[4][4];
+                    for (int i = 0; i < 4; ++i) {
+                        const int iy = 2 * ty + i - s.pad;
+                        for (int j = 0; j < 4; ++j) {
+                            const int ix = 2 * tx + j - s.pad;
+                            d[i][j] = (iy >= 0 && iy < s.height && ix >= 0 && ix < s.width) ? xc[iy * s.width + ix] : 0.0f;
+                        }
+                    }
+                    winogradInput(d, v + c * tiles + ty * tilesX + tx, vStride);
+                }
+            }
+        }
+    });
+
+    // 16 个相互独立的 GEMM 分给各线程，每个 GEMM 内部串行
+    pool->parallelFor(0, 16, 1, [&](int first, int last) {
+        for (int e = first; e < last; ++e) {
+            sgemm(s.filters, static_cast<int>(tiles), s.channels, u + e * static_cast<std::size_t>(s.filters) * s.channels,
+                  s.channels, v + e * vStride, static_cast<int>(tiles), false, m + e * mStride, static_cast<int>(tiles),
+                  false, pool);
+        }
+    });
+
+    // 输出变换：Y = Aᵀ·M·A，裁掉超出输出尺寸的部分
+    pool->parallelFor(0, s.filters, 1, [&](int first, int last) {
+        for (int f = first; f < last; ++f) {
+            float* yf = y + static_cast<std::size_t>(f) * oh * ow;
+            const float* mf = m + f * tiles;
+            for (std::size_t t = 0; t < tiles; ++t) {
+                float a[4][4];
+                for (int e = 0; e < 16; ++e) a[e / 4][e % 4] = mf[e * mStride + t];
+                float r[2][4];
+                for (int j = 0; j < 4; ++j) {
+                    r[0][j] = a[0][j] + a[1][j] + a[2][j];
+                    r[1][j] = a[1][j] - a[2][j] - a[3][j];
+                }
+                const int oy = 2 * static_cast<int>(t / tilesX);
+                const int ox = 2 * static_cast<int>(t % tilesX);
+                for (int i = 0; i < 2 && oy + i < oh; ++i) {
+                    float* yr = yf + (oy + i) * ow + ox;
+                    yr[0] = r[i][0] + r[i][1] + r[i][2];
+                    if (ox + 1 < ow) yr[1] = r[i][1] - r[i][2] - r[i][3];
+                }
+            }
+        }
+    });
+}
+
+void conv2d(const ConvShape& shape, ConvAlgorithm algorithm, const float* x, const float* w,
+            const float* transformed, float* y, float* scratch, ThreadPool* pool) {
+    switch (algorithm) {
+    case ConvAlgorithm::Im2colGemm:
+        conv2dIm2col(shape, x, w, y, scratch, pool);
+        break;
+    case ConvAlgorithm::Direct:
+        conv2dDirect(shape, x, w, y, scratch, pool);
+        break;
+    case ConvAlgorithm::Winograd:
+        conv2dWinograd(shape, x, transformed, y, scratch, pool);
+        break;
+    }
+}
+
+void conv2dReference(const ConvShape& s, const float* x, const float* w, float* y) {
+    const int oh = s.outHeight();
+    const int ow = s.outWidth();
+    for (int f = 0; f < s.filters; ++f) {
+        for (int oy = 0; oy < oh; ++oy) {
+            for (int ox = 0; ox < ow; ++ox) {
+                double acc = 0.0;
+                for (int c = 0; c < s.channels; ++c)
+                    for (int ky = 0; ky < s.kernel; ++ky)
+                        for (int kx = 0; kx < s.kernel; ++kx) {
+                            const int iy = oy + ky - s.pad;
+                            const int ix = ox + kx - s.pad;
+                            if (iy < 0 || iy >= s.height || ix < 0 || ix >= s.width) continue;
+                            acc += double(w[((static_cast<std::size_t>(f) * s.channels + c) * s.kernel + ky) * s.kernel + kx]) *
+                                   x[(static_cast<std::size_t>(c) * s.height + iy) * s.width + ix];
+                        }
+                y[(static_cast<std::size_t>(f) * oh + oy) * ow + ox] = static_cast<float>(acc);
+            }
+        }
+    }
+}
+
+void maxPool2d(const float* x, float* y, int channels, int height, int width, int kernel, int stride, ThreadPool* pool) {
+    pool2d<true>(x, y, channels, height, width, kernel, stride, pool ? pool : &ThreadPool::global());
+}
+
+void avgPool2d(const float* x, float* y, int channels, int height, int width, int kernel, int stride, ThreadPool* pool) {
+    pool2d<false>(x, y, channels, height, width, kernel, stride, pool ? pool : &ThreadPool::global());
+}
@@ -0,0 +1,67 @@
+#ifndef CONVKERNELS_H
+#define CONVKERNELS_H
+
+class ThreadPool;
+
+// 单个样本的 2D 卷积参数：输入 C×H×W，F 个 K×K 卷积核，步长 1，四周补 pad
+struct ConvShape
+{
+    int channels = 1;
+    int height = 1;
+    int width = 1;
+    int filters = 1;
+    int kernel = 1;
+    int pad = 0;
+
+    int outHeight() const { return height + 2 * pad - kernel + 1; }
+    int outWidth() const { return width + 2 * pad - kernel + 1; }
+    int patchSize() const { return channels * kernel * kernel; }
+};
+
+// 卷积算法；由 ConvAutotuner 按形状实测选择
+//   Im2colGemm：展开成矩阵后走分块 GEMM，适用于任意形状
+//   Direct：在补零后的输入上滑动窗口直接计算，寄存器分块 4 个卷积核 × 16 个像素，用于 K ≤ 5
+//   Winograd：F(2×2, 3×3)，乘法次数为直接计算的 4/9，只用于 3×3
+enum class ConvAlgorithm { Im2colGemm, Direct, Winograd };
+
+const char* convAlgorithmName(ConvAlgorithm algorithm);
+bool convAlgorithmFromName(const char* name, ConvAlgorithm* algorithm);
+bool convAlgorithmSupported(const ConvShape& shape, ConvAlgorithm algorithm);
+
+// im2col 所需的临时缓冲区大小（float 个数）
+long long im2colScratchSize(const ConvShape& shape);
+
+// 各算法所需的临时区大小与预变换权重大小（float 个数）
+long long convScratchSize(const ConvShape& shape, ConvAlgorithm algorithm);
+long long convTransformedWeightSize(const ConvShape& shape, ConvAlgorithm algorithm);
+
+// 按算法预处理权重（目前只有 Winograd 需要：U = G·g·Gᵀ，布局 [16][F][C]），其余算法为空操作
+void convTransformWeights(const ConvShape& shape, ConvAlgorithm algorithm, const float* w, float* transformed);
+
+// 统一入口：transformed 为 convTransformWeights 的结果（不需要时可为 nullptr）
+void conv2d(const ConvShape& shape, ConvAlgorithm algorithm, const float* x, const float* w,
+            const float* transformed, float* y, float* scratch, ThreadPool* pool = nullptr);
+
+// im2col + 分块 GEMM：y[F][OH*OW] = w[F][C*K*K] · col[C*K*K][OH*OW]
+// 不加偏置，scratch 至少 im2colScratchSize 个 float（1×1 且无 padding 时不使用）
+void conv2dIm2col(const ConvShape& shape, const float* x, const float* w, float* y,
+                  float* scratch, ThreadPool* pool = nullptr);
+
+// 直接卷积，按 (卷积核组, 输出行) 并行；scratch 存放补零后的输入
+void conv2dDirect(const ConvShape& shape, const float* x, const float* w, float* y,
+                  float* scratch, ThreadPool* pool = nullptr);
+
+// Winograd F(2,3)：输入变换 -> 16 个 [F×C]·[C×tiles] GEMM -> 输出变换，u 为预变换权重
+void conv2dWinograd(const ConvShape& shape, const float* x, const float* u, float* y,
+                    float* scratch, ThreadPool* pool = nullptr);
+
+// 逐元素的朴素实现，用于校验
+void conv2dReference(const ConvShape& shape, const float* x, const float* w, float* y);
+
+// 池化，窗口 kernel×kernel，步长 stride，输入 channels×height×width
+void maxPool2d(const float* x, float* y, int channels, int height, int width,
+               int kernel, int stride, ThreadPool* pool = nullptr);
+void avgPool2d(const float* x, float* y, int channels, int height, int width,
+               int kernel, int stride, ThreadPool* pool = nullptr);
+
+#endif // CONVKERNELS_H
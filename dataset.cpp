@@ -0,0 +1,446 @@
+#include "dataset.h"
+#include "simdutils.h"
+#include "threadpool.h"
+#include <QByteArray>
+#include <QDir>
+#include <QFileInfo>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <random>
+
+namespace {
+
+// CSV 每块的大致字节数
+constexpr qint64 kCsvChunkBytes = 1 << 20;
+
+quint32 readBigEndian32(const uchar* p) {
+    return (quint32(p[0]) << 24) | (quint32(p[1]) << 16) | (quint32(p[2]) << 8) | quint32(p[3]);
+}
+
+inline bool isSeparator(char c) {
+    return c == ',' || c == ';' || c == ' ' || c == '\t' || c == '\r';
+}
+
+// 常见的十进制写法走快速路径：尾数不超过 19 位有效数字、10 的幂不超过 22 时双精度结果是正确舍入的；
+// 其余写法（inf、nan、超长尾数、大指数）交给 QByteArray::toDouble，与系统区域设置无关
+bool parseNumber(const char* begin, const char* end, float& value) {
+    static const double kPow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    const char* p = begin;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+    quint64 mantissa = 0;
+    int digits = 0, exponent = 0;
+    bool any = false, exact = true;
+    for (; p < end && unsigned(*p - '0') < 10; ++p) {
+        any = true;
+        if (digits < 19) {
+            mantissa = mantissa * 10 + unsigned(*p - '0');
+            if (mantissa) ++digits;
+        } else {
+            ++exponent;
+            exact = exact && *p == '0';
+        }
+    }
+    if (p < end && *p == '.') {
+        for (++p; p < end && unsigned(*p - '0') < 10; ++p) {
+            any = true;
+            if (digits < 19) {
+                mantissa = mantissa * 10 + unsigned(*p - '0');
+                if (mantissa) ++digits;
+                --exponent;
+            } else {
+                exact = exact && *p == '0';
+            }
+        }
+    }
+    if (any && p < end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool negativeExponent = false;
+        if (p < end && (*p == '-' || *p == '+')) negativeExponent = *p++ == '-';
+        int e = 0;
+        bool exponentDigits = false;
+        for (; p < end && unsigned(*p - '0') < 10; ++p) {
+            exponentDigits = true;
+            if (e < 10000) e = e * 10 + (*p - '0');
+        }
+        any = exponentDigits;
+        exponent += negativeExponent ? -e : e;
+    }
+    if (any && p == end && exact && mantissa < (quint64(1) << 53) && exponent >= -22 && exponent <= 22) {
+        double v = double(mantissa);
+        v = exponent < 0 ? v / kPow10[-exponent] : v * kPow10[exponent];
+        value = static_cast<float>(negative ? -v : v);
+        return true;
+    }
+    bool ok = false;
+    value = static_cast<float>(QByteArray::fromRawData(begin, int(end - begin)).toDouble(&ok));
+    return ok;
+}
+
+// 解析一行 [p, end) 的全部字段到 row（最多 capacity 个），返回字段数；无法解析时返回 -1
+int parseRow(const char* p, const char* end, float* row, int capacity) {
+    int count = 0;
+    while (true) {
+        while (p < end && isSeparator(*p)) ++p;
+        if (p == end) return count;
+        const char* tokenEnd = p;
+        while (tokenEnd < end && !isSeparator(*tokenEnd)) ++tokenEnd;
+        float v;
+        if (!parseNumber(p, tokenEnd, v)) return -1;
+        if (count < capacity) row[count] = v;
+        ++count;
+        p = tokenEnd;
+    }
+}
+
+inline bool blankLine(const char* p, const char* end) {
+    while (p < end && isSeparator(*p)) ++p;
+    return p == end;
+}
+
+const char* lineEnd(const char* p, const char* end) {
+    const char* e = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+    return e ? e : end;
+}
+
+#if NNV_HAVE_AVX2
+// AVX2 部分处理 8 的倍数个元素，返回处理到的位置，余下的由标量循环完成
+NNV_AVX2 int scaleOffsetAvx2(const float* x, int n, float scale, float offset, float* y) {
+    int i = 0;
+    const __m256 vscale = _mm256_set1_ps(scale);
+    const __m256 voffset = _mm256_set1_ps(offset);
+    for (; i + 8 <= n; i += 8) _mm256_storeu_ps(y + i, _mm256_fmadd_ps(_mm256_loadu_ps(x + i), vscale, voffset));
+    return i;
+}
+#endif
+
+// y = x · scale + offset
+void scaleOffset(const float* x, int n, float scale, float offset, float* y) {
+    int i = 0;
+#if NNV_HAVE_AVX2
+    if (simd::hasAvx2()) i = scaleOffsetAvx2(x, n, scale, offset, y);
+#endif
+    for (; i < n; ++i) y[i] = x[i] * scale + offset;
+}
+
+#if NNV_HAVE_AVX2
+NNV_AVX2 int convertBytesAvx2(const uchar* x, int n, float scale, float offset, float* y) {
+    int i = 0;
+    const __m256 vscale = _mm256_set1_ps(scale);
+    const __m256 voffset = _mm256_set1_ps(offset);
+    for (; i + 8 <= n; i += 8) {
+        const __m256i bytes = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(x + i)));
+        _mm256_storeu_ps(y + i, _mm256_fmadd_ps(_mm256_cvtepi32_ps(bytes), vscale, voffset));
+    }
+    return i;
+}
+#endif
+
+// uint8 → float 再乘加，每次 8 个
+void convertBytes(const uchar* x, int n, float scale, float offset, float* y) {
+    int i = 0;
+#if NNV_HAVE_AVX2
+    if (simd::hasAvx2()) i = convertBytesAvx2(x, n, scale, offset, y);
+#endif
+    for (; i < n; ++i) y[i] = float(x[i]) * scale + offset;
+}
+
+} // namespace
+
+Dataset::~Dataset() {
+    close();
+}
+
+void Dataset::close() {
+    if (m_imageMap) m_imageFile.unmap(const_cast<uchar*>(m_imageMap));
+    if (m_labelMap) m_labelFile.unmap(const_cast<uchar*>(m_labelMap));
+    m_imageFile.close();
+    m_labelFile.close();
+    m_imageMap = m_labelMap = m_pixels = m_labelBytes = nullptr;
+    m_features.clear();
+    m_features.shrink_to_fit();
+    m_labels.clear();
+    m_labels.shrink_to_fit();
+    m_format = Format::None;
+    m_path.clear();
+    m_count = 0;
+    m_shape = LayerShape();
+    m_hasLabels = false;
+    m_rawScale = m_scale = 1.0f;
+    m_offset = 0.0f;
+}
+
+const uchar* Dataset::mapFile(QFile& file, const QString& path, qint64* size, QString* error) {
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = QString("无法打开 %1：%2").arg(path, file.errorString());
+        return nullptr;
+    }
+    *size = file.size();
+    const uchar* data = *size > 0 ? file.map(0, *size) : nullptr;
+    if (!data && error) *error = QString("内存映射 %1 失败：%2").arg(path, file.errorString());
+    return data;
+}
+
+bool Dataset::open(const QString& path, QString* error) {
+    const QFileInfo info(path);
+    const QString suffix = info.suffix().toLower();
+    if (suffix == "csv" || suffix == "txt") return openCsv(path, -1, error);
+    QString labels = info.fileName();
+    labels.replace("images", "labels").replace("idx3", "idx1");
+    labels = info.dir().filePath(labels);
+    return openIdx(path, labels != path && QFileInfo(labels).exists() ? labels : QString(), error);
+}
+
+bool Dataset::openIdx(const QString& imagesPath, const QString& labelsPath, QString* error) {
+    close();
+    qint64 size = 0;
+    m_imageMap = mapFile(m_imageFile, imagesPath, &size, error);
+    if (!m_imageMap) {
+        close();
+        return false;
+    }
+    // 魔数：两个 0 字节、数据类型（0x08 为 uint8）、维数；之后是大端的各维长度
+    const uchar* data = m_imageMap;
+    const int dims = size >= 4 ? data[3] : 0;
+    if (size < 4 || data[0] != 0 || data[1] != 0 || (dims != 2 && dims != 3) || size < 4 + 4 * dims) {
+        if (error) *error = QString("%1 不是二维或三维的 IDX 文件").arg(imagesPath);
+        close();
+        return false;
+    }
+    if (data[2] != 0x08) {
+        if (error) *error = QString("%1 的数据类型为 0x%2，只支持 uint8（0x08）").arg(imagesPath).arg(int(data[2]), 2, 16, QChar('0'));
+        close();
+        return false;
+    }
+    m_count = readBigEndian32(data + 4);
+    if (dims == 3) {
+        m_shape.height = int(readBigEndian32(data + 8));
+        m_shape.width = int(readBigEndian32(data + 12));
+        m_shape.spatial = true;
+    } else {
+        m_shape.width = int(readBigEndian32(data + 8));
+    }
+    const qint64 header = 4 + 4 * dims;
+    if (m_shape.size() <= 0 || header + m_count * m_shape.size() > size) {
+        if (error) *error = QString("%1 的长度与头部记录的 %2 个样本不符").arg(imagesPath).arg(m_count);
+        close();
+        return false;
+    }
+    m_pixels = data + header;
+
+    if (!labelsPath.isEmpty()) {
+        qint64 labelSize = 0;
+        m_labelMap = mapFile(m_labelFile, labelsPath, &labelSize, error);
+        const uchar* labels = m_labelMap;
+        if (!labels) {
+            close();
+            return false;
+        }
+        if (labelSize < 8 || labels[0] != 0 || labels[1] != 0 || labels[2] != 0x08 || labels[3] != 1
+            || qint64(readBigEndian32(labels + 4)) != m_count || labelSize < 8 + m_count) {
+            if (error) *error = QString("%1 不是与图像数目一致的 uint8 标签文件").arg(labelsPath);
+            close();
+            return false;
+        }
+        m_labelBytes = labels + 8;
+        m_hasLabels = true;
+    }
+    m_format = Format::Idx;
+    m_path = imagesPath;
+    m_rawScale = m_scale = 1.0f / 255.0f;
+    m_offset = 0.0f;
+    return true;
+}
+
+bool Dataset::openCsv(const QString& path, int features, QString* error, ThreadPool* pool) {
+    close();
+    if (!pool) pool = &ThreadPool::global();
+    qint64 size = 0;
+    m_imageMap = mapFile(m_imageFile, path, &size, error);
+    if (!m_imageMap) {
+        close();
+        return false;
+    }
+    const char* begin = reinterpret_cast<const char*>(m_imageMap);
+    const char* end = begin + size;
+
+    // 第一个非空行：能解析则是数据并决定列数，否则视为表头
+    const char* data = begin;
+    int columns = -1;
+    for (int tries = 0; data < end && tries < 2;) {
+        const char* e = lineEnd(data, end);
+        if (blankLine(data, e)) {
+            data = e + 1;
+            continue;
+        }
+        columns = parseRow(data, e, nullptr, 0);
+        if (columns > 0) break;
+        data = e + 1;  // 表头
+        ++tries;
+    }
+    if (columns <= 0) {
+        if (error) *error = QString("%1 中没有可解析的数据行").arg(path);
+        close();
+        return false;
+    }
+    const bool labelled = features > 0 && columns == features + 1;
+    if (features > 0 && columns != features && !labelled) {
+        if (error) *error = QString("%1 有 %2 列，网络输入为 %3 维").arg(QFileInfo(path).fileName()).arg(columns).arg(features);
+        close();
+        return false;
+    }
+    const int width = labelled ? columns - 1 : columns;
+
+    // 按约 1 MB 切块，块边界挪到下一行开头
+    const qint64 bytes = end - data;
+    const int chunks = static_cast<int>(std::max<qint64>(1, bytes / kCsvChunkBytes));
+    std::vector<const char*> bounds(static_cast<std::size_t>(chunks) + 1);
+    bounds[0] = data;
+    bounds[chunks] = end;
+    for (int k = 1; k < chunks; ++k) {
+        const char* p = data + bytes * k / chunks;
+        p = std::max(p, bounds[k - 1]);
+        const char* e = lineEnd(p, end);
+        bounds[k] = e < end ? e + 1 : end;
+    }
+
+    // 第一遍各块数非空行，前缀和得到每块的起始样本号
+    std::vector<qint64> rowStart(static_cast<std::size_t>(chunks) + 1, 0);
+    pool->parallelFor(0, chunks, 1, [&](int first, int last) {
+        for (int k = first; k < last; ++k) {
+            qint64 n = 0;
+            for (const char* p = bounds[k]; p < bounds[k + 1];) {
+                const char* e = lineEnd(p, bounds[k + 1]);
+                if (!blankLine(p, e)) ++n;
+                p = e + 1;
+            }
+            rowStart[k + 1] = n;
+        }
+    });
+    std::partial_sum(rowStart.begin(), rowStart.end(), rowStart.begin());
+    m_count = rowStart[chunks];
+    m_features.resize(static_cast<std::size_t>(m_count) * width);
+    if (labelled) m_labels.resize(static_cast<std::size_t>(m_count));
+
+    // 第二遍各块把自己的行直接解析进矩阵；出错时记下最小的出错样本号
+    std::atomic<qint64> badRow(m_count);
+    std::vector<int> badColumns(static_cast<std::size_t>(chunks), 0);
+    pool->parallelFor(0, chunks, 1, [&](int first, int last) {
+        std::vector<float> line(static_cast<std::size_t>(columns));
+        for (int k = first; k < last; ++k) {
+            qint64 r = rowStart[k];
+            for (const char* p = bounds[k]; p < bounds[k + 1] && r < badRow.load(std::memory_order_relaxed);) {
+                const char* e = lineEnd(p, bounds[k + 1]);
+                if (!blankLine(p, e)) {
+                    float* dst = labelled ? line.data() : m_features.data() + r * width;
+                    const int n = parseRow(p, e, dst, columns);
+                    if (n != columns) {
+                        badColumns[k] = n;
+                        qint64 current = badRow.load();
+                        while (r < current && !badRow.compare_exchange_weak(current, r)) {}
+                        break;
+                    }
+                    if (labelled) {
+                        m_labels[r] = static_cast<int>(std::lround(line[0]));
+                        std::memcpy(m_features.data() + r * width, line.data() + 1, sizeof(float) * width);
+                    }
+                    ++r;
+                }
+                p = e + 1;
+            }
+        }
+    });
+    // 解析完成后不再需要映射
+    m_imageFile.unmap(const_cast<uchar*>(m_imageMap));
+    m_imageMap = nullptr;
+    m_imageFile.close();
+    if (badRow.load() < m_count) {
+        const qint64 r = badRow.load();
+        const int k = static_cast<int>(std::upper_bound(rowStart.begin(), rowStart.end(), r) - rowStart.begin()) - 1;
+        if (error) {
+            *error = badColumns[k] < 0 ? QString("%1 第 %2 个样本含有无法解析的字段").arg(QFileInfo(path).fileName()).arg(r + 1)
+                                       : QString("%1 第 %2 个样本有 %3 列，应为 %4 列")
+                                             .arg(QFileInfo(path).fileName()).arg(r + 1).arg(badColumns[k]).arg(columns);
+        }
+        close();
+        return false;
+    }
+
+    m_format = Format::Csv;
+    m_path = path;
+    m_shape.width = width;
+    m_hasLabels = labelled;
+    m_rawScale = m_scale = 1.0f;
+    m_offset = 0.0f;
+    return true;
+}
+
+int Dataset::label(qint64 index) const {
+    if (!m_hasLabels || index < 0 || index >= m_count) return -1;
+    return m_format == Format::Idx ? m_labelBytes[index] : m_labels[static_cast<std::size_t>(index)];
+}
+
+void Dataset::setNormalization(float mean, float stddev) {
+    if (!(stddev > 0.0f)) stddev = 1.0f;
+    m_scale = m_rawScale / stddev;
+    m_offset = -mean / stddev;
+}
+
+void Dataset::gather(const qint64* indices, int n, float* out, int* labels) const {
+    const int size = sampleSize();
+    for (int s = 0; s < n; ++s) {
+        const qint64 index = indices[s];
+        float* dst = out + qint64(s) * size;
+        if (m_format == Format::Idx) {
+            convertBytes(m_pixels + index * size, size, m_scale, m_offset, dst);
+        } else if (isIdentity()) {
+            std::memcpy(dst, m_features.data() + index * size, sizeof(float) * size);
+        } else {
+            scaleOffset(m_features.data() + index * size, size, m_scale, m_offset, dst);
+        }
+        if (labels) labels[s] = label(index);
+    }
+}
+
+const float* Dataset::contiguous(qint64 first, int n, const int** labels) const {
+    if (m_format != Format::Csv || !isIdentity() || first < 0 || n < 0 || first + n > m_count) return nullptr;
+    if (labels) *labels = m_hasLabels ? m_labels.data() + first : nullptr;
+    return m_features.data() + first * sampleSize();
+}
+
+DatasetIterator::DatasetIterator(const Dataset& dataset, int batchSize, bool shuffle, quint32 seed)
+    : m_dataset(dataset), m_batchSize(std::max(1, batchSize)), m_shuffle(shuffle) {
+    m_inputs.resize(static_cast<std::size_t>(m_batchSize) * dataset.sampleSize());
+    m_labels.resize(static_cast<std::size_t>(m_batchSize));
+    m_order.resize(static_cast<std::size_t>(dataset.count()));
+    reset(seed);
+}
+
+void DatasetIterator::reset(quint32 seed) {
+    m_position = 0;
+    std::iota(m_order.begin(), m_order.end(), qint64(0));
+    if (m_shuffle) std::shuffle(m_order.begin(), m_order.end(), std::mt19937(seed));
+}
+
+bool DatasetIterator::next(Batch& batch) {
+    const qint64 remaining = m_dataset.count() - m_position;
+    if (remaining <= 0) return false;
+    batch.size = static_cast<int>(std::min<qint64>(m_batchSize, remaining));
+    const int* labels = nullptr;
+    const float* direct = m_shuffle ? nullptr : m_dataset.contiguous(m_position, batch.size, &labels);
+    if (direct) {
+        batch.inputs = direct;
+        batch.labels = labels;
+    } else {
+        m_dataset.gather(m_order.data() + m_position, batch.size, m_inputs.data(), m_labels.data());
+        batch.inputs = m_inputs.data();
+        batch.labels = m_dataset.hasLabels() ? m_labels.data() : nullptr;
+    }
+    m_position += batch.size;
+    return true;
+}
@@ -0,0 +1,107 @@
+#ifndef DATASET_H
+#define DATASET_H
+
+#include <QFile>
+#include <QString>
+#include <QtGlobal>
+#include <vector>
+#include "backend.h"
+
+class ThreadPool;
+
+// 内存映射的样本集：
+// IDX（MNIST / Fashion-MNIST 的 *-idx3-ubyte 与 *-idx1-ubyte）的像素留在映射里，取批次时才转换并归一化；
+// CSV 整体映射后按行块并行解析为连续的 float 矩阵（一行一个样本，可选首列为标签）
+class Dataset
+{
+public:
+    enum class Format { None, Idx, Csv };
+
+    Dataset() = default;
+    ~Dataset();
+    Dataset(const Dataset&) = delete;
+    Dataset& operator=(const Dataset&) = delete;
+
+    // 按扩展名选择格式：.csv/.txt 为 CSV，其余按 IDX 打开并在同目录下找对应的标签文件
+    // （train-images-idx3-ubyte → train-labels-idx1-ubyte，t10k-images.idx3-ubyte → t10k-labels.idx1-ubyte）
+    bool open(const QString& path, QString* error = nullptr);
+    // labelsPath 为空时没有标签
+    bool openIdx(const QString& imagesPath, const QString& labelsPath = QString(), QString* error = nullptr);
+    // features > 0 时列数须为 features（无标签）或 features + 1（首列为标签）；
+    // features <= 0 时全部列都是特征。首行无法解析为数字时视为表头跳过
+    bool openCsv(const QString& path, int features = -1, QString* error = nullptr, ThreadPool* pool = nullptr);
+    void close();
+
+    bool isOpen() const { return m_format != Format::None; }
+    Format format() const { return m_format; }
+    QString path() const { return m_path; }
+    qint64 count() const { return m_count; }
+    LayerShape shape() const { return m_shape; }  // IDX 图像为 1×H×W，CSV 为 features 维向量
+    int sampleSize() const { return m_shape.size(); }
+    bool hasLabels() const { return m_hasLabels; }
+    int label(qint64 index) const;
+
+    // 输出 = (原值 · rawScale − mean) / stddev，IDX 的 uint8 像素 rawScale 为 1/255，CSV 为 1
+    void setNormalization(float mean, float stddev);
+    bool isIdentity() const { return m_scale == 1.0f && m_offset == 0.0f; }
+
+    // 把 indices 指定的 n 个样本归一化写入 out（n × sampleSize），labels 非空时写入标签（无标签为 -1）；
+    // uint8 → float 与乘加用 AVX2 成组转换
+    void gather(const qint64* indices, int n, float* out, int* labels = nullptr) const;
+    // CSV 的 [first, first + n) 在矩阵中连续，未设置归一化时直接返回内部指针（labels 指向对应标签），否则返回 nullptr
+    const float* contiguous(qint64 first, int n, const int** labels = nullptr) const;
+
+private:
+    const uchar* mapFile(QFile& file, const QString& path, qint64* size, QString* error);
+
+    Format m_format = Format::None;
+    QString m_path;
+    qint64 m_count = 0;
+    LayerShape m_shape;
+    bool m_hasLabels = false;
+    float m_rawScale = 1.0f;
+    float m_scale = 1.0f;   // 合并后的乘加系数：输出 = 原值 · m_scale + m_offset
+    float m_offset = 0.0f;
+
+    // IDX：像素与标签都留在映射里
+    QFile m_imageFile;
+    QFile m_labelFile;
+    const uchar* m_imageMap = nullptr;
+    const uchar* m_labelMap = nullptr;
+    const uchar* m_pixels = nullptr;      // 跳过头部后的像素
+    const uchar* m_labelBytes = nullptr;
+
+    // CSV：解析后的特征矩阵与标签
+    std::vector<float> m_features;
+    std::vector<int> m_labels;
+};
+
+// 批次迭代器：每个 epoch 打乱一次样本下标（只打乱 count 个下标，不搬动样本），
+// 按批 gather 到预先分配的缓冲区；CSV 不打乱且无归一化时直接给出矩阵内的指针（零拷贝）
+class DatasetIterator
+{
+public:
+    struct Batch {
+        const float* inputs = nullptr;  // size × sampleSize
+        const int* labels = nullptr;    // 无标签时为 nullptr
+        int size = 0;
+    };
+
+    DatasetIterator(const Dataset& dataset, int batchSize, bool shuffle = true, quint32 seed = 1);
+
+    bool next(Batch& batch);
+    // 开始新的 epoch，shuffle 时用 seed 重新打乱
+    void reset(quint32 seed);
+    qint64 position() const { return m_position; }
+
+private:
+    const Dataset& m_dataset;
+    int m_batchSize;
+    bool m_shuffle;
+    qint64 m_position = 0;
+    std::vector<qint64> m_order;
+    std::vector<float> m_inputs;
+    std::vector<int> m_labels;
+};
+
+#endif // DATASET_H
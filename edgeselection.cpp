@@ -0,0 +1,53 @@
+#include "edgeselection.h"
+#include <algorithm>
+#include <numeric>
+
+void TopKEdgeSelection::reset(std::vector<float> magnitude) {
+    m_magnitude = std::move(magnitude);
+    m_candidates = std::count_if(m_magnitude.begin(), m_magnitude.end(), [](float v) { return v >= 0.0f; });
+    m_order.clear();
+    m_rank.clear();
+    m_selected = -1;
+    m_rankDirty = true;
+}
+
+void TopKEdgeSelection::select(qint64 k, std::vector<int>* hidden, std::vector<int>* shown) {
+    k = std::clamp<qint64>(k, 0, m_candidates);
+    if (m_selected < 0) {
+        if (k == m_candidates) return;
+        // 第一次收紧：全量部分选择一次，之后都是增量
+        m_order.resize(m_magnitude.size());
+        std::iota(m_order.begin(), m_order.end(), 0);
+        m_selected = size();  // 被剪掉的连线本来就隐藏，排在末尾不会被报告
+        if (m_candidates < size()) {
+            std::partition(m_order.begin(), m_order.end(), [this](int i) { return m_magnitude[i] >= 0.0f; });
+            m_selected = m_candidates;
+        }
+    }
+    if (k == m_selected) return;
+
+    const auto larger = [this](int a, int b) { return m_magnitude[a] > m_magnitude[b]; };
+    const auto begin = m_order.begin();
+    if (k < m_selected) {
+        // 新的前 k 条一定在当前已选范围内
+        std::nth_element(begin, begin + k, begin + m_selected, larger);
+        if (hidden) hidden->insert(hidden->end(), begin + k, begin + m_selected);
+    } else {
+        // 新增的 k - m_selected 条是剩余候选中最大的那些
+        std::nth_element(begin + m_selected, begin + k, begin + m_candidates, larger);
+        if (shown) shown->insert(shown->end(), begin + m_selected, begin + k);
+    }
+    m_selected = k;
+    m_rankDirty = true;
+}
+
+bool TopKEdgeSelection::isVisible(int index) const {
+    if (index < 0 || index >= size() || m_magnitude[index] < 0.0f) return false;
+    if (m_selected < 0) return true;
+    if (m_rankDirty) {
+        m_rank.resize(m_order.size());
+        for (std::size_t i = 0; i < m_order.size(); ++i) m_rank[m_order[i]] = static_cast<int>(i);
+        m_rankDirty = false;
+    }
+    return m_rank[index] < m_selected;
+}
@@ -0,0 +1,34 @@
+#ifndef EDGESELECTION_H
+#define EDGESELECTION_H
+
+#include <QtGlobal>
+#include <vector>
+
+// 一组连线中按幅值取前 k 条，k 随滑块变化时增量调整：
+// m_order 的前 m_selected 个始终是当前显示的连线（彼此无序），其余为隐藏的；
+// 收紧时只在已选的前 m_selected 个里做 nth_element，放宽时只在剩余部分里选出新增的那几条，
+// 并且只返回可见性发生变化的连线，界面只需切换这些条目
+class TopKEdgeSelection
+{
+public:
+    // magnitude 为每条连线的 |w|，负值表示已被剪掉、永不显示；重置后视为全部（未剪掉的）连线可见
+    void reset(std::vector<float> magnitude);
+    // 调整为显示前 k 条（超过未剪掉的连线数时取全部），hidden / shown 追加需要切换可见性的下标
+    void select(qint64 k, std::vector<int>* hidden, std::vector<int>* shown);
+
+    const std::vector<float>& magnitude() const { return m_magnitude; }
+    qint64 size() const { return static_cast<qint64>(m_magnitude.size()); }
+    qint64 candidates() const { return m_candidates; }  // 未剪掉的连线数
+    qint64 selected() const { return m_selected < 0 ? m_candidates : m_selected; }
+    bool isVisible(int index) const;
+
+private:
+    std::vector<float> m_magnitude;
+    std::vector<int> m_order;
+    mutable std::vector<int> m_rank;  // m_order 的逆排列，仅在需要判断可见性时按需重建
+    qint64 m_candidates = 0;
+    qint64 m_selected = -1;  // -1：全部候选可见，尚未排序
+    mutable bool m_rankDirty = true;
+};
+
+#endif // EDGESELECTION_H
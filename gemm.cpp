@@ -0,0 +1,266 @@
+#include "gemm.h"
+#include "simdutils.h"
+#include "threadpool.h"
+#include <algorithm>
+
+namespace {
+
+constexpr int MR = 6;     // 微内核行数
+constexpr int NR = 16;    // 微内核列数（两个 AVX 寄存器）
+constexpr int KC = 256;   // K 方向分块，A/B 面板常驻 L1/L2
+constexpr int MC = 72;    // M 方向分块（MR 的倍数）
+constexpr int NC_MAX = 256;
+
+// 线程私有的打包缓冲区，只在容量不足时扩容
+struct PackBuffers {
+    simd::AlignedBuffer a;
+    simd::AlignedBuffer b;
+};
+
+PackBuffers& packBuffers() {
+    thread_local PackBuffers buffers;
+    return buffers;
+}
+
+void ensureCapacity(simd::AlignedBuffer& buffer, std::size_t count) {
+    if (buffer.size() < count) buffer.resize(count);
+}
+
+// A[m0.., k0..] -> MR 行一组的面板，每列 MR 个元素连续，行不足时补零
+void packA(int mc, int kc, const float* A, int lda, float* dst) {
+    for (int i = 0; i < mc; i += MR) {
+        const int rows = std::min(MR, mc - i);
+        for (int p = 0; p < kc; ++p) {
+            for (int r = 0; r < rows; ++r) dst[r] = A[(i + r) * lda + p];
+            for (int r = rows; r < MR; ++r) dst[r] = 0.0f;
+            dst += MR;
+        }
+    }
+}
+
+// op(B)[k0.., n0..] -> NR 列一组的面板，每行 NR 个元素连续，列不足时补零
+void packB(int kc, int nc, const float* B, int ldb, bool transB, float* dst) {
+    for (int j = 0; j < nc; j += NR) {
+        const int cols = std::min(NR, nc - j);
+        if (!transB) {
+            for (int p = 0; p < kc; ++p) {
+                const float* src = B + p * ldb + j;
+                for (int c = 0; c < cols; ++c) dst[c] = src[c];
+                for (int c = cols; c < NR; ++c) dst[c] = 0.0f;
+                dst += NR;
+            }
+        } else {
+            for (int p = 0; p < kc; ++p) {
+                for (int c = 0; c < cols; ++c) dst[c] = B[(j + c) * ldb + p];
+                for (int c = cols; c < NR; ++c) dst[c] = 0.0f;
+                dst += NR;
+            }
+        }
+    }
+}
+
+// MR×NR 微内核：c = (overwrite ? 0 : c) + a·b
+#if NNV_HAVE_AVX2
+NNV_AVX2 void microKernelAvx2(int kc, const float* a, const float* b, float* c, int ldc, bool overwrite) {
+    __m256 acc[MR][2];
+    for (int r = 0; r < MR; ++r) {
+        acc[r][0] = _mm256_setzero_ps();
+        acc[r][1] = _mm256_setzero_ps();
+    }
+    for (int p = 0; p < kc; ++p) {
+        const __m256 b0 = _mm256_load_ps(b);
+        const __m256 b1 = _mm256_load_ps(b + 8);
+        for (int r = 0; r < MR; ++r) {
+            const __m256 ar = _mm256_broadcast_ss(a + r);
+            acc[r][0] = _mm256_fmadd_ps(ar, b0, acc[r][0]);
+            acc[r][1] = _mm256_fmadd_ps(ar, b1, acc[r][1]);
+        }
+        a += MR;
+        b += NR;
+    }
+    for (int r = 0; r < MR; ++r) {
+        float* cr = c + r * ldc;
+        if (overwrite) {
+            _mm256_storeu_ps(cr, acc[r][0]);
+            _mm256_storeu_ps(cr + 8, acc[r][1]);
+        } else {
+            _mm256_storeu_ps(cr, _mm256_add_ps(_mm256_loadu_ps(cr), acc[r][0]));
+            _mm256_storeu_ps(cr + 8, _mm256_add_ps(_mm256_loadu_ps(cr + 8), acc[r][1]));
+        }
+    }
+}
+#endif
+
+void microKernel(int kc, const float* a, const float* b, float* c, int ldc, bool overwrite) {
+    float acc[MR][NR] = {};
+    for (int p = 0; p < kc; ++p) {
+        for (int r = 0; r < MR; ++r) {
+            const float ar = a[r];
+            for (int j = 0; j < NR; ++j) acc[r][j] += ar * b[j];
+        }
+        a += MR;
+        b += NR;
+    }
+    for (int r = 0; r < MR; ++r) {
+        float* cr = c + r * ldc;
+        for (int j = 0; j < NR; ++j) cr[j] = overwrite ? acc[r][j] : cr[j] + acc[r][j];
+    }
+}
+
+// 用打包好的 A、B 面板计算 mc×nc 块的一个 K 分块
+void blockKernel(int mc, int nc, int kc, const float* aPacked, const float* bPacked,
+                 float* C, int ldc, bool overwrite) {
+    const int mPanels = (mc + MR - 1) / MR;
+    const int nPanels = (nc + NR - 1) / NR;
+    alignas(64) float edge[MR * NR];
+#if NNV_HAVE_AVX2
+    const auto kernel = simd::hasAvx2() ? microKernelAvx2 : microKernel;
+#else
+    const auto kernel = microKernel;
+#endif
+    for (int jp = 0; jp < nPanels; ++jp) {
+        const int cols = std::min(NR, nc - jp * NR);
+        const float* bp = bPacked + static_cast<std::size_t>(jp) * NR * kc;
+        for (int ip = 0; ip < mPanels; ++ip) {
+            const int rows = std::min(MR, mc - ip * MR);
+            const float* ap = aPacked + static_cast<std::size_t>(ip) * MR * kc;
+            float* c = C + static_cast<std::size_t>(ip) * MR * ldc + jp * NR;
+            if (rows == MR && cols == NR) {
+                kernel(kc, ap, bp, c, ldc, overwrite);
+            } else {
+                // 边缘块先算到临时区再写回有效部分
+                kernel(kc, ap, bp, edge, NR, true);
+                for (int r = 0; r < rows; ++r)
+                    for (int j = 0; j < cols; ++j)
+                        c[r * ldc + j] = overwrite ? edge[r * NR + j] : c[r * ldc + j] + edge[r * NR + j];
+            }
+        }
+    }
+}
+
+// 对一个 mc×nc 的 C 块执行全部 K 分块
+void gemmBlock(int mc, int nc, int K, const float* A, int lda, const float* B, int ldb, bool transB,
+               float* C, int ldc, bool accumulate) {
+    PackBuffers& buffers = packBuffers();
+    const int mPanels = (mc + MR - 1) / MR;
+    const int nPanels = (nc + NR - 1) / NR;
+    ensureCapacity(buffers.a, static_cast<std::size_t>(mPanels) * MR * KC);
+    ensureCapacity(buffers.b, static_cast<std::size_t>(nPanels) * NR * KC);
+
+    for (int k0 = 0; k0 < K; k0 += KC) {
+        const int kc = std::min(KC, K - k0);
+        const float* bSrc = transB ? B + k0 : B + static_cast<std::size_t>(k0) * ldb;
+        packB(kc, nc, bSrc, ldb, transB, buffers.b.data());
+        packA(mc, kc, A + k0, lda, buffers.a.data());
+        blockKernel(mc, nc, kc, buffers.a.data(), buffers.b.data(), C, ldc, k0 == 0 && !accumulate);
+    }
+}
+
+} // namespace
+
+void sgemm(int M, int N, int K, const float* A, int lda, const float* B, int ldb, bool transB,
+           float* C, int ldc, bool accumulate, ThreadPool* pool) {
+    if (M <= 0 || N <= 0) return;
+    if (K <= 0) {
+        if (!accumulate)
+            for (int i = 0; i < M; ++i) std::fill(C + static_cast<std::size_t>(i) * ldc, C + static_cast<std::size_t>(i) * ldc + N, 0.0f);
+        return;
+    }
+    if (!pool) pool = &ThreadPool::global();
+
+    // 按线程数调整 NC，使小 M（如批大小 1 的全连接层）也能在列方向并行
+    const int mBlocks = (M + MC - 1) / MC;
+    const int threads = pool->threadCount();
+    const int wantN = std::max(1, threads / mBlocks);
+    int nc = (N + wantN - 1) / wantN;
+    nc = std::min(NC_MAX, std::max(NR, (nc + NR - 1) / NR * NR));
+    const int nBlocks = (N + nc - 1) / nc;
+
+    // 计算量很小时不值得调度线程
+    const double flops = 2.0 * M * N * K;
+    const int grain = flops < 1.0e5 ? mBlocks * nBlocks : 1;
+
+    pool->parallelFor(0, mBlocks * nBlocks, grain, [&](int first, int last) {
+        for (int t = first; t < last; ++t) {
+            const int m0 = (t / nBlocks) * MC;
+            const int n0 = (t % nBlocks) * nc;
+            const int mc = std::min(MC, M - m0);
+            const int ncur = std::min(nc, N - n0);
+            const float* bBlock = transB ? B + static_cast<std::size_t>(n0) * ldb : B + n0;
+            gemmBlock(mc, ncur, K, A + static_cast<std::size_t>(m0) * lda, lda, bBlock, ldb, transB,
+                      C + static_cast<std::size_t>(m0) * ldc + n0, ldc, accumulate);
+        }
+    });
+}
+
+void PackedMatrix::pack(int N, int K, const float* B, int ldb, bool transB) {
+    m_n = N;
+    m_k = K;
+    m_paddedN = (N + NR - 1) / NR * NR;
+    m_data.resize(static_cast<std::size_t>(m_paddedN) * K);
+    for (int k0 = 0; k0 < K; k0 += KC) {
+        const int kc = std::min(KC, K - k0);
+        const float* bSrc = transB ? B + k0 : B + static_cast<std::size_t>(k0) * ldb;
+        packB(kc, N, bSrc, ldb, transB, m_data.data() + static_cast<std::size_t>(k0) * m_paddedN);
+    }
+}
+
+const float* PackedMatrix::block(int kBlock) const {
+    return m_data.data() + static_cast<std::size_t>(kBlock) * KC * m_paddedN;
+}
+
+void sgemmPacked(int M, const float* A, int lda, const PackedMatrix& packed,
+                 float* C, int ldc, bool accumulate, ThreadPool* pool) {
+    const int N = packed.cols();
+    const int K = packed.rows();
+    if (M <= 0 || N <= 0) return;
+    if (K <= 0) {
+        if (!accumulate)
+            for (int i = 0; i < M; ++i) std::fill(C + static_cast<std::size_t>(i) * ldc, C + static_cast<std::size_t>(i) * ldc + N, 0.0f);
+        return;
+    }
+    if (!pool) pool = &ThreadPool::global();
+
+    // 任务沿列面板切分，NC 为 NR 的倍数，使每个任务对应 packed 中连续的面板
+    const int mBlocks = (M + MC - 1) / MC;
+    const int wantN = std::max(1, pool->threadCount() / mBlocks);
+    int nc = (N + wantN - 1) / wantN;
+    nc = std::min(NC_MAX, std::max(NR, (nc + NR - 1) / NR * NR));
+    const int nBlocks = (N + nc - 1) / nc;
+    const double flops = 2.0 * M * N * K;
+    const int grain = flops < 1.0e5 ? mBlocks * nBlocks : 1;
+
+    pool->parallelFor(0, mBlocks * nBlocks, grain, [&](int first, int last) {
+        PackBuffers& buffers = packBuffers();
+        ensureCapacity(buffers.a, static_cast<std::size_t>((MC + MR - 1) / MR) * MR * KC);
+        for (int t = first; t < last; ++t) {
+            const int m0 = (t / nBlocks) * MC;
+            const int n0 = (t % nBlocks) * nc;
+            const int mc = std::min(MC, M - m0);
+            const int ncur = std::min(nc, N - n0);
+            for (int k0 = 0, kb = 0; k0 < K; k0 += KC, ++kb) {
+                const int kc = std::min(KC, K - k0);
+                packA(mc, kc, A + static_cast<std::size_t>(m0) * lda + k0, lda, buffers.a.data());
+                // 第 n0 列所在面板在该 K 块中的起始位置
+                const float* bp = packed.block(kb) + static_cast<std::size_t>(n0) * kc;
+                blockKernel(mc, ncur, kc, buffers.a.data(), bp,
+                            C + static_cast<std::size_t>(m0) * ldc + n0, ldc, k0 == 0 && !accumulate);
+            }
+        }
+    });
+}
+
+void sgemmReference(int M, int N, int K, const float* A, int lda, const float* B, int ldb, bool transB,
+                    float* C, int ldc, bool accumulate) {
+    for (int i = 0; i < M; ++i) {
+        for (int j = 0; j < N; ++j) {
+            float sum = 0.0f;
+            for (int p = 0; p < K; ++p) {
+                const float b = transB ? B[static_cast<std::size_t>(j) * ldb + p] : B[static_cast<std::size_t>(p) * ldb + j];
+                sum += A[static_cast<std::size_t>(i) * lda + p] * b;
+            }
+            float& c = C[static_cast<std::size_t>(i) * ldc + j];
+            c = accumulate ? c + sum : sum;
+        }
+    }
+}
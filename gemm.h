@@ -0,0 +1,53 @@
+#ifndef GEMM_H
+#define GEMM_H
+
+#include "simdutils.h"
+
+class ThreadPool;
+
+// 单精度矩阵乘 C[M×N] = A[M×K] · op(B)，accumulate 为 true 时累加到 C 上
+// transB = false：B 为 [K×N] 行主序；transB = true：B 为 [N×K]（即 PyTorch Linear 的权重布局）
+// 按 MC×KC×NC 分块并打包成 MR×NR 微内核所需的连续面板，AVX2 下使用 FMA 微内核
+// pool 为空时使用全局线程池
+void sgemm(int M, int N, int K,
+           const float* A, int lda,
+           const float* B, int ldb, bool transB,
+           float* C, int ldc,
+           bool accumulate = false, ThreadPool* pool = nullptr);
+
+// 预先打包好的 op(B)，用于同一权重反复参与乘法的场景（如循环层每个时间步）
+// 布局：按 KC 分块，每块内按 NR 列一组的面板连续存放
+class PackedMatrix
+{
+public:
+    PackedMatrix() = default;
+    PackedMatrix(const PackedMatrix&) = delete;
+    PackedMatrix& operator=(const PackedMatrix&) = delete;
+    PackedMatrix(PackedMatrix&&) = default;
+    PackedMatrix& operator=(PackedMatrix&&) = default;
+
+    // B 的含义与 sgemm 相同，打包后得到 K×N 的 op(B)
+    void pack(int N, int K, const float* B, int ldb, bool transB);
+
+    int rows() const { return m_k; }
+    int cols() const { return m_n; }
+    const float* block(int kBlock) const;
+
+private:
+    int m_n = 0;
+    int m_k = 0;
+    int m_paddedN = 0;
+    simd::AlignedBuffer m_data;
+};
+
+// C[M×N] = A[M×K] · packed(+ C)，K 与 N 由 packed 决定
+void sgemmPacked(int M, const float* A, int lda, const PackedMatrix& packed,
+                 float* C, int ldc, bool accumulate = false, ThreadPool* pool = nullptr);
+
+// 不分块、不打包的朴素实现，用于校验与基准对比
+void sgemmReference(int M, int N, int K,
+                    const float* A, int lda,
+                    const float* B, int ldb, bool transB,
+                    float* C, int ldc, bool accumulate = false);
+
+#endif // GEMM_H
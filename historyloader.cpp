@@ -0,0 +1,290 @@
+#include "historyloader.h"
+#include "threadpool.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QVector>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// 一个预扫描块。深度都相对块首计算，块首的绝对深度要等前面的块串联之后才知道
+struct BlockScan
+{
+    qint64 begin = 0;
+    qint64 end = 0;
+    int depthChange = 0;
+    int minDepth = 0;
+    bool endsInString = false;
+    qint64 newlineInString = -1;  // 字符串中未转义的换行
+    QVector<qint64> commas;       // 相对深度等于 minDepth 的逗号：块首位于顶层数组内时就是记录之间的分隔
+};
+
+// 字符类：1 为字符串外需要处理的字符，2 为字符串内需要处理的字符。其余字节（缩进、键名、数字……）整段跳过
+struct ByteClasses
+{
+    unsigned char table[256] = {};
+    ByteClasses()
+    {
+        for (const char c : {'"', '{', '}', '[', ']', ','})
+            table[static_cast<unsigned char>(c)] |= 1;
+        for (const char c : {'"', '\\', '\n'})
+            table[static_cast<unsigned char>(c)] |= 2;
+    }
+};
+const ByteClasses kClasses;
+
+void scanBlock(const char* data, BlockScan* block)
+{
+    const unsigned char* const table = kClasses.table;
+    const char* p = data + block->begin;
+    const char* const end = data + block->end;
+    int depth = 0;
+    while (p < end) {
+        if (!(table[static_cast<unsigned char>(*p)] & 1)) {
+            ++p;
+            continue;
+        }
+        switch (*p++) {
+        case '"':
+            // 字符串内只找结束引号；反斜杠连同后面一个字符跳过
+            for (;;) {
+                while (p < end && !(table[static_cast<unsigned char>(*p)] & 2))
+                    ++p;
+                if (p >= end) {
+                    block->endsInString = true;
+                    block->depthChange = depth;
+                    return;
+                }
+                if (*p == '"') {
+                    ++p;
+                    break;
+                }
+                if (*p == '\n') {
+                    block->newlineInString = p - data;
+                    return;
+                }
+                p += 2;
+            }
+            break;
+        case '{':
+        case '[':
+            ++depth;
+            break;
+        case '}':
+        case ']':
+            if (--depth < block->minDepth) {
+                block->minDepth = depth;
+                block->commas.clear();
+            }
+            break;
+        case ',':
+            if (depth == block->minDepth)
+                block->commas.append(p - 1 - data);
+            break;
+        default:
+            break;
+        }
+    }
+    block->depthChange = depth;
+}
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+} // namespace
+
+bool parseHistoryJson(const QByteArray& json, QJsonArray* entries, QString* error, ThreadPool* pool,
+                      HistoryLoadStats* stats, qint64 blockBytes)
+{
+    HistoryLoadStats local;
+    HistoryLoadStats& s = stats ? *stats : local;
+    s = HistoryLoadStats();
+    s.bytes = json.size();
+    *entries = QJsonArray();
+    auto fail = [&](qint64 offset, const QString& message) {
+        if (error)
+            *error = QString("第 %1 字节：%2").arg(offset).arg(message);
+        *entries = QJsonArray();
+        return false;
+    };
+
+    QElapsedTimer timer;
+    timer.start();
+    const char* data = json.constData();
+    const qint64 size = json.size();
+    if (!pool)
+        pool = &ThreadPool::global();
+    s.threads = pool->threadCount();
+
+    // 小文件直接整体解析
+    if (size < 2 * blockBytes) {
+        QJsonParseError result;
+        const QJsonDocument doc = QJsonDocument::fromJson(json, &result);
+        if (result.error != QJsonParseError::NoError)
+            return fail(result.offset, result.errorString());
+        if (!doc.isArray())
+            return fail(0, "顶层不是数组");
+        *entries = doc.array();
+        s.entries = entries->size();
+        s.chunks = 1;
+        s.parseMs = timer.nsecsElapsed() / 1.0e6;
+        return true;
+    }
+
+    qint64 first = 0, last = size - 1;
+    while (first < size && isSpace(data[first]))
+        ++first;
+    while (last > first && isSpace(data[last]))
+        --last;
+    if (first >= size || data[first] != '[')
+        return fail(first, "顶层不是数组");
+    if (last == first || data[last] != ']')
+        return fail(last, "顶层数组没有结束");
+
+    // 1) 在换行处切块，各块并行预扫描
+    const qint64 innerBegin = first + 1, innerEnd = last;
+    const qint64 inner = innerEnd - innerBegin;
+    const int wanted = int(qBound<qint64>(1, inner / blockBytes, qint64(s.threads) * 4));
+    QVector<BlockScan> blocks;
+    qint64 begin = innerBegin;
+    for (int k = 1; k <= wanted && begin < innerEnd; ++k) {
+        qint64 end = innerEnd;
+        if (k < wanted) {
+            const qint64 target = qMax(begin, innerBegin + inner * k / wanted);
+            const void* newline = std::memchr(data + target, '\n', size_t(innerEnd - target));
+            end = newline ? static_cast<const char*>(newline) - data + 1 : innerEnd;
+        }
+        BlockScan block;
+        block.begin = begin;
+        block.end = end;
+        blocks.append(block);
+        begin = end;
+    }
+    pool->parallelFor(0, blocks.size(), 1, [&](int from, int to) {
+        for (int b = from; b < to; ++b)
+            scanBlock(data, &blocks[b]);
+    });
+    s.blocks = blocks.size();
+    s.scanMs = timer.nsecsElapsed() / 1.0e6;
+    timer.restart();
+
+    // 2) 串联各块：块首的绝对深度为 0（位于顶层数组内）时，块内最浅一层的逗号就是记录分隔
+    QVector<qint64> separators;
+    int depth = 0;
+    for (const BlockScan& block : blocks) {
+        if (block.newlineInString >= 0)
+            return fail(block.newlineInString, "字符串中含有未转义的换行");
+        if (block.endsInString)
+            return fail(block.end, "字符串没有结束");
+        if (depth + block.minDepth < 0)
+            return fail(block.begin, QString("到第 %1 字节之间括号不配对").arg(block.end));
+        if (depth + block.minDepth == 0)
+            separators += block.commas;
+        depth += block.depthChange;
+    }
+    if (depth != 0)
+        return fail(innerEnd, "对象或数组没有结束");
+    bool empty = separators.isEmpty();
+    for (qint64 i = innerBegin; empty && i < innerEnd; ++i)
+        empty = isSpace(data[i]);
+    if (empty) {
+        s.splitMs = timer.nsecsElapsed() / 1.0e6;
+        return true;
+    }
+
+    // 按字节数把相邻记录归成解析块，块数为线程数的几倍以平衡负载
+    struct Chunk
+    {
+        qint64 begin;  // 前一个分隔逗号（或开头的 '['）
+        qint64 end;    // 后一个分隔逗号（或结尾的 ']'）
+        int entries;
+    };
+    QVector<Chunk> chunks;
+    const qint64 target = qMax<qint64>(inner / (qint64(s.threads) * 8), blockBytes / 4);
+    qint64 chunkBegin = first;
+    int count = 1;
+    for (const qint64 separator : separators) {
+        if (separator - chunkBegin >= target) {
+            chunks.append({chunkBegin, separator, count});
+            chunkBegin = separator;
+            count = 1;
+        } else {
+            ++count;
+        }
+    }
+    chunks.append({chunkBegin, last, count});
+    s.chunks = chunks.size();
+    s.splitMs = timer.nsecsElapsed() / 1.0e6;
+    timer.restart();
+
+    // 3) 并行解析：每块加上方括号单独作为数组解析
+    QVector<QJsonArray> parsed(chunks.size());
+    QVector<qint64> errorOffsets(chunks.size(), -1);
+    QVector<QString> errorMessages(chunks.size());
+    pool->parallelFor(0, chunks.size(), 1, [&](int from, int to) {
+        for (int c = from; c < to; ++c) {
+            const Chunk& chunk = chunks[c];
+            const int length = int(chunk.end - chunk.begin - 1);
+            QByteArray text;
+            text.reserve(length + 2);
+            text.append('[');
+            text.append(data + chunk.begin + 1, length);
+            text.append(']');
+            QJsonParseError result;
+            const QJsonDocument doc = QJsonDocument::fromJson(text, &result);
+            if (result.error != QJsonParseError::NoError) {
+                errorOffsets[c] = chunk.begin + result.offset;
+                errorMessages[c] = result.errorString();
+            } else if (doc.array().size() != chunk.entries) {
+                errorOffsets[c] = chunk.begin;
+                errorMessages[c] = "有空记录（多余的逗号）";
+            } else {
+                parsed[c] = doc.array();
+            }
+        }
+    });
+    s.parseMs = timer.nsecsElapsed() / 1.0e6;
+    timer.restart();
+    for (int c = 0; c < chunks.size(); ++c) {
+        if (errorOffsets[c] >= 0)
+            return fail(errorOffsets[c], errorMessages[c]);
+    }
+
+    // 4) 按原顺序合并，合并完的块立即释放
+    for (QJsonArray& part : parsed) {
+        for (const QJsonValue& entry : part)
+            entries->append(entry);
+        part = QJsonArray();
+    }
+    s.entries = entries->size();
+    s.mergeMs = timer.nsecsElapsed() / 1.0e6;
+    return true;
+}
+
+bool loadHistoryFile(const QString& path, QJsonArray* entries, QString* error, HistoryLoadStats* stats)
+{
+    *entries = QJsonArray();
+    QFile file(path);
+    if (!file.exists())
+        return true;
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error)
+            *error = QString("无法打开 %1：%2").arg(path, file.errorString());
+        return false;
+    }
+    const qint64 size = file.size();
+    if (size == 0)
+        return true;
+    // 映射失败（例如特殊文件系统）时退回整体读入
+    const uchar* mapped = file.map(0, size);
+    const QByteArray json = mapped ? QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), int(size))
+                                   : file.readAll();
+    return parseHistoryJson(json, entries, error, nullptr, stats);
+}
@@ -0,0 +1,38 @@
+#ifndef HISTORYLOADER_H
+#define HISTORYLOADER_H
+
+#include <QByteArray>
+#include <QJsonArray>
+#include <QString>
+
+class ThreadPool;
+
+struct HistoryLoadStats
+{
+    qint64 bytes = 0;
+    int entries = 0;
+    int blocks = 0;          // 预扫描的块数
+    int chunks = 0;          // 并行解析的块数
+    int threads = 1;
+    double scanMs = 0.0;     // 结构预扫描（并行）
+    double splitMs = 0.0;    // 串联各块的扫描结果、划分解析块（串行）
+    double parseMs = 0.0;    // 各块 QJsonDocument::fromJson（并行）
+    double mergeMs = 0.0;    // 按顺序合并为一个数组（串行）
+
+    double totalMs() const { return scanMs + splitMs + parseMs + mergeMs; }
+};
+
+// history.json 是一个顶层数组，每条记录是其中一个元素。文件较大时先按块并行预扫描，
+// 只跟踪字符串与括号深度，找出顶层数组中分隔记录的逗号；再按记录边界切成若干块，
+// 在线程池中分别用 QJsonDocument 解析，最后按原顺序合并。块从换行之后开始：
+// 合法 JSON 的字符串中不会有未转义的换行，块首因此一定不在字符串内。
+// 没有换行的紧凑格式只能整段串行预扫描，解析仍然并行。
+// 结果与对整个文件调用 QJsonDocument::fromJson 相同；格式错误时返回 false，error 给出字节位置
+bool parseHistoryJson(const QByteArray& json, QJsonArray* entries, QString* error = nullptr,
+                      ThreadPool* pool = nullptr, HistoryLoadStats* stats = nullptr, qint64 blockBytes = 1 << 20);
+
+// 内存映射读取；文件不存在或为空时得到空数组
+bool loadHistoryFile(const QString& path, QJsonArray* entries, QString* error = nullptr,
+                     HistoryLoadStats* stats = nullptr);
+
+#endif // HISTORYLOADER_H
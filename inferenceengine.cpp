@@ -0,0 +1,309 @@
+#include "inferenceengine.h"
+#include "convautotuner.h"
+#include "gemm.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+namespace {
+
+std::size_t alignUp(std::size_t n) {
+    const std::size_t floatsPerLine = simd::kAlignment / sizeof(float);
+    return (n + floatsPerLine - 1) / floatsPerLine * floatsPerLine;
+}
+
+int denseInputFeatures(const LayerShape& in) {
+    return in.spatial ? in.size() : in.width;
+}
+
+} // namespace
+
+InferenceEngine::InferenceEngine(ThreadPool* pool)
+    : m_pool(pool ? pool : &ThreadPool::global()) {}
+
+bool InferenceEngine::build(const QList<NeuralLayer>& layers, int maxBatch, QString* error) {
+    QList<const NeuralLayer*> ordered;
+    for (const NeuralLayer& layer : layers) ordered.append(&layer);
+    return build(layers, defaultInputShape(ordered), maxBatch, error);
+}
+
+bool InferenceEngine::build(const QList<NeuralLayer>& layers, const LayerShape& input, int maxBatch, QString* error) {
+    m_ready = false;
+    m_layers.clear();
+    m_input = input;
+    m_maxBatch = std::max(1, maxBatch);
+
+    QList<const NeuralLayer*> ordered;
+    for (const NeuralLayer& layer : layers) ordered.append(&layer);
+    QVector<LayerShape> shapes;
+    if (ordered.isEmpty()) {
+        if (error) *error = "网络为空";
+        return false;
+    }
+    if (!inferLayerShapes(ordered, input, shapes, error)) return false;
+
+    std::size_t paramCount = 0;
+    std::size_t arenaCount = 0;
+    long long scratchCount = 0;
+    LayerShape in = input;
+
+    for (int i = 0; i < layers.size(); ++i) {
+        const NeuralLayer& spec = layers[i];
+        Layer layer;
+        layer.spec = spec;
+        layer.info.layerType = spec.layerType;
+        layer.info.in = in;
+        layer.info.out = shapes[i];
+        layer.info.activation = activationFromName(spec.activationFunction);
+        const LayerShape& out = shapes[i];
+
+        if (spec.isDense()) {
+            const int inFeatures = denseInputFeatures(in);
+            layer.info.kind = LayerKind::Dense;
+            layer.weightCount = static_cast<std::size_t>(inFeatures) * out.width;
+            layer.biasCount = out.width;
+            layer.info.flops = 2.0 * out.height * inFeatures * out.width;
+            layer.initBound = 1.0f / std::sqrt(float(inFeatures));
+        } else if (spec.isConvolutional()) {
+            ConvShape conv{in.channels, in.height, in.width, out.channels, spec.kernelSize, spec.kernelSize / 2};
+            layer.info.kind = LayerKind::Conv2d;
+            layer.weightCount = static_cast<std::size_t>(conv.filters) * conv.patchSize();
+            layer.biasCount = conv.filters;
+            layer.info.flops = 2.0 * conv.filters * conv.patchSize() * out.height * out.width;
+            layer.initBound = 1.0f / std::sqrt(float(conv.patchSize()));
+            layer.conv = conv;
+            layer.convAlgorithm = ConvAutotuner::instance().select(conv, m_pool);
+            layer.convWeights.resize(static_cast<std::size_t>(convTransformedWeightSize(conv, layer.convAlgorithm)));
+            layer.info.algorithm = convAlgorithmName(layer.convAlgorithm);
+            scratchCount = std::max(scratchCount, convScratchSize(conv, layer.convAlgorithm));
+        } else if (spec.isPooling()) {
+            layer.info.kind = spec.layerType == "MaxPooling" ? LayerKind::MaxPool : LayerKind::AvgPool;
+            layer.info.flops = double(out.size()) * spec.poolingSize * spec.poolingSize;
+        } else if (spec.isRecurrent()) {
+            RecurrentShape rs;
+            rs.cell = spec.layerType == "LSTM" ? RecurrentCell::LSTM
+                      : (spec.layerType == "GRU" ? RecurrentCell::GRU : RecurrentCell::RNN);
+            rs.batch = m_maxBatch;
+            rs.steps = out.height;
+            rs.features = in.width;
+            rs.units = out.width;
+            const std::size_t gw = rs.gateWidth();
+            layer.info.kind = LayerKind::Recurrent;
+            layer.weightCount = gw * (rs.features + rs.units);
+            layer.biasCount = 2 * gw;
+            layer.info.flops = 2.0 * rs.steps * gw * (rs.features + rs.units);
+            layer.initBound = 1.0f / std::sqrt(float(rs.units));
+            layer.recurrentShape = rs;
+            layer.recurrent.reset(new RecurrentKernel());
+            scratchCount = std::max(scratchCount, RecurrentKernel::workspaceSize(rs));
+        } else {
+            // Dropout 推理时为恒等，Flatten 只改变视图
+            layer.info.kind = LayerKind::Identity;
+            layer.info.activation = Activation::None;
+        }
+
+        layer.info.parameters = static_cast<long long>(layer.weightCount + layer.biasCount);
+        layer.weightOffset = paramCount;
+        paramCount += alignUp(layer.weightCount);
+        layer.biasOffset = paramCount;
+        paramCount += alignUp(layer.biasCount);
+        if (layer.info.kind != LayerKind::Identity) {
+            layer.outOffset = arenaCount;
+            arenaCount += alignUp(static_cast<std::size_t>(out.size()) * m_maxBatch);
+        }
+        m_layers.push_back(std::move(layer));
+        in = out;
+    }
+
+    m_params.resize(paramCount);
+    m_arena.resize(arenaCount);
+    m_scratch.resize(static_cast<std::size_t>(scratchCount));
+    m_layerTimesMs.fill(0.0, layerCount());
+    m_totalTimeMs = 0.0;
+    initializeWeights();
+    m_ready = true;
+    return true;
+}
+
+LayerShape InferenceEngine::outputShape() const {
+    return m_layers.empty() ? m_input : m_layers.back().info.out;
+}
+
+float* InferenceEngine::weightData(int layer) {
+    m_packDirty = true;
+    Layer& l = m_layers[layer];
+    if (l.sparse) {
+        l.sparse.reset();
+        l.info.algorithm.clear();
+    }
+    return m_params.data() + l.weightOffset;
+}
+
+long long InferenceEngine::weightSize(int layer) const {
+    return static_cast<long long>(m_layers[layer].weightCount);
+}
+
+float* InferenceEngine::biasData(int layer) {
+    m_packDirty = true;
+    return m_params.data() + m_layers[layer].biasOffset;
+}
+
+long long InferenceEngine::biasSize(int layer) const {
+    return static_cast<long long>(m_layers[layer].biasCount);
+}
+
+bool InferenceEngine::setSparseWeights(int layer, CsrMatrix csr) {
+    if (layer < 0 || layer >= layerCount()) return false;
+    Layer& l = m_layers[layer];
+    if (l.info.kind != LayerKind::Dense || csr.rows != l.info.out.width
+        || qint64(csr.rows) * csr.cols != static_cast<qint64>(l.weightCount)) {
+        return false;
+    }
+    csr.toDense(m_params.data() + l.weightOffset);
+    l.info.algorithm = QString("CSR 稀疏度 %1%").arg(csr.sparsity() * 100.0, 0, 'f', 1);
+    l.sparse.reset(new CsrMatrix(std::move(csr)));
+    return true;
+}
+
+const CsrMatrix* InferenceEngine::sparseWeights(int layer) const {
+    return layer >= 0 && layer < layerCount() ? m_layers[layer].sparse.get() : nullptr;
+}
+
+void InferenceEngine::initializeWeights(unsigned int seed) {
+    std::mt19937 rng(seed);
+    for (Layer& layer : m_layers) {
+        if (layer.weightCount == 0) continue;
+        if (layer.sparse) {
+            layer.sparse.reset();
+            layer.info.algorithm.clear();
+        }
+        std::uniform_real_distribution<float> dist(-layer.initBound, layer.initBound);
+        float* w = m_params.data() + layer.weightOffset;
+        for (std::size_t i = 0; i < layer.weightCount; ++i) w[i] = dist(rng);
+        float* b = m_params.data() + layer.biasOffset;
+        for (std::size_t i = 0; i < layer.biasCount; ++i) b[i] = dist(rng);
+    }
+    m_packDirty = true;
+}
+
+void InferenceEngine::repackWeights() {
+    for (Layer& layer : m_layers) {
+        if (layer.info.kind == LayerKind::Conv2d) {
+            convTransformWeights(layer.conv, layer.convAlgorithm, m_params.data() + layer.weightOffset, layer.convWeights.data());
+            continue;
+        }
+        if (!layer.recurrent) continue;
+        const RecurrentShape& rs = layer.recurrentShape;
+        const std::size_t gw = rs.gateWidth();
+        const float* w = m_params.data() + layer.weightOffset;
+        const float* b = m_params.data() + layer.biasOffset;
+        layer.recurrent->pack(rs, w, w + gw * rs.features, b, b + gw);
+    }
+    m_packDirty = false;
+}
+
+void InferenceEngine::runLayer(Layer& layer, const float* x, float* y, int batch) {
+    const LayerInfo& info = layer.info;
+    const float* w = m_params.data() + layer.weightOffset;
+    const float* b = m_params.data() + layer.biasOffset;
+
+    switch (info.kind) {
+    case LayerKind::Dense: {
+        // 整个批次（以及序列的每个时间步）合成一次 GEMM，剪枝后的层只乘非零元
+        const int inFeatures = denseInputFeatures(info.in);
+        const int rows = batch * info.out.height;
+        if (layer.sparse)
+            csrMatMul(*layer.sparse, x, rows, y, m_pool);
+        else
+            sgemm(rows, info.out.width, inFeatures, x, inFeatures, w, inFeatures, true, y, info.out.width, false, m_pool);
+        biasActivation(y, rows, info.out.width, b, info.activation, m_pool);
+        break;
+    }
+    case LayerKind::Conv2d: {
+        const int spatial = info.out.height * info.out.width;
+        for (int n = 0; n < batch; ++n) {
+            float* yn = y + static_cast<std::size_t>(n) * info.out.size();
+            conv2d(layer.conv, layer.convAlgorithm, x + static_cast<std::size_t>(n) * info.in.size(), w,
+                   layer.convWeights.data(), yn, m_scratch.data(), m_pool);
+            channelBiasActivation(yn, info.out.channels, spatial, b, info.activation, m_pool);
+        }
+        break;
+    }
+    case LayerKind::MaxPool:
+    case LayerKind::AvgPool: {
+        // 批次与通道合并成 batch*C 个独立平面
+        const int planes = batch * info.in.channels;
+        if (info.kind == LayerKind::MaxPool)
+            maxPool2d(x, y, planes, info.in.height, info.in.width, layer.spec.poolingSize, 2, m_pool);
+        else
+            avgPool2d(x, y, planes, info.in.height, info.in.width, layer.spec.poolingSize, 2, m_pool);
+        break;
+    }
+    case LayerKind::Recurrent: {
+        layer.recurrent->forward(x, y, batch, m_scratch.data(), m_pool);
+        if (info.activation == Activation::ReLU || info.activation == Activation::Tanh)
+            biasActivation(y, batch * info.out.height, info.out.width, nullptr, info.activation, m_pool);
+        break;
+    }
+    case LayerKind::Identity:
+        break;
+    }
+}
+
+const float* InferenceEngine::forward(const float* input, int batch) {
+    if (!m_ready || !input) return nullptr;
+    batch = std::clamp(batch, 1, m_maxBatch);
+    if (m_packDirty) repackWeights();
+
+    const auto start = std::chrono::steady_clock::now();
+    const float* x = input;
+    for (int i = 0; i < layerCount(); ++i) {
+        Layer& layer = m_layers[i];
+        const auto t0 = std::chrono::steady_clock::now();
+        if (layer.info.kind == LayerKind::Identity) {
+            layer.output = x;
+        } else {
+            float* y = m_arena.data() + layer.outOffset;
+            runLayer(layer, x, y, batch);
+            layer.output = y;
+        }
+        const auto t1 = std::chrono::steady_clock::now();
+        m_layerTimesMs[i] = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        x = layer.output;
+    }
+    m_totalTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return x;
+}
+
+const float* InferenceEngine::layerOutput(int index) const {
+    if (index < 0 || index >= layerCount()) return nullptr;
+    return m_layers[index].output;
+}
+
+QString InferenceEngine::summary() const {
+    auto shapeText = [](const LayerShape& s) {
+        return QString("%1x%2x%3").arg(s.channels).arg(s.height).arg(s.width);
+    };
+    QString text = QString("# 原生推理引擎：输入 %1，批大小上限 %2，线程数 %3\n")
+                       .arg(shapeText(m_input)).arg(m_maxBatch).arg(m_pool->threadCount());
+    long long totalParams = 0;
+    double totalFlops = 0.0;
+    for (int i = 0; i < layerCount(); ++i) {
+        const LayerInfo& info = m_layers[i].info;
+        text += QString("%1. %2  %3 -> %4  参数 %5  MFLOPs %6  耗时 %7 ms%8\n")
+                    .arg(i + 1)
+                    .arg(info.layerType, -14)
+                    .arg(shapeText(info.in), shapeText(info.out))
+                    .arg(info.parameters)
+                    .arg(info.flops / 1.0e6, 0, 'f', 3)
+                    .arg(i < m_layerTimesMs.size() ? m_layerTimesMs[i] : 0.0, 0, 'f', 3)
+                    .arg(info.algorithm.isEmpty() ? QString() : "  [" + info.algorithm + "]");
+        totalParams += info.parameters;
+        totalFlops += info.flops;
+    }
+    text += QString("总参数 %1，单样本 MFLOPs %2，最近一次前向 %3 ms\n")
+                .arg(totalParams).arg(totalFlops / 1.0e6, 0, 'f', 3).arg(m_totalTimeMs, 0, 'f', 3);
+    return text;
+}
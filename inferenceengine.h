@@ -0,0 +1,114 @@
+#ifndef INFERENCEENGINE_H
+#define INFERENCEENGINE_H
+
+#include <QList>
+#include <QString>
+#include <QVector>
+#include <vector>
+#include "backend.h"
+#include "activations.h"
+#include "convkernels.h"
+#include "pruning.h"
+#include "recurrentkernels.h"
+#include "simdutils.h"
+#include <memory>
+
+class ThreadPool;
+
+// 在 CPU 上执行有序 NeuralLayer 列表的前向推理
+// build() 时推断形状、分配参数并一次性规划激活缓冲区（arena），forward() 不再分配内存
+class InferenceEngine
+{
+public:
+    enum class LayerKind { Dense, Conv2d, MaxPool, AvgPool, Recurrent, Identity };
+
+    // 每层的形状、参数量与计算量，供界面展示
+    struct LayerInfo {
+        QString layerType;
+        LayerKind kind = LayerKind::Identity;
+        Activation activation = Activation::None;
+        LayerShape in;
+        LayerShape out;
+        long long parameters = 0;
+        double flops = 0.0;  // 单个样本
+        QString algorithm;   // 卷积层由 ConvAutotuner 选出的算法
+    };
+
+    explicit InferenceEngine(ThreadPool* pool = nullptr);
+
+    // 使用 defaultInputShape 推断输入形状
+    bool build(const QList<NeuralLayer>& layers, int maxBatch = 1, QString* error = nullptr);
+    bool build(const QList<NeuralLayer>& layers, const LayerShape& input, int maxBatch, QString* error = nullptr);
+
+    bool isReady() const { return m_ready; }
+    int layerCount() const { return static_cast<int>(m_layers.size()); }
+    int maxBatch() const { return m_maxBatch; }
+    const LayerInfo& layerInfo(int index) const { return m_layers[index].info; }
+    LayerShape inputShape() const { return m_input; }
+    LayerShape outputShape() const;
+
+    // 参数按 PyTorch 布局存放：Dense [out][in]，Conv2d [F][C][K][K]
+    // 循环层的权重为 weight_ih [G*U][F] 后接 weight_hh [G*U][U]，偏置为 bias_ih 后接 bias_hh
+    // 通过非 const 指针修改参数后，下一次 forward 会重新打包循环层权重、重新做卷积的 Winograd 变换
+    float* weightData(int layer);
+    long long weightSize(int layer) const;
+    float* biasData(int layer);
+    long long biasSize(int layer) const;
+
+    // Dense 层改用 CSR 权重前向（尺寸须为 [out][in]），稠密参数同时改写为对应的剪枝后矩阵；
+    // 之后通过 weightData 取该层的可写指针会丢弃 CSR，恢复稠密 GEMM
+    bool setSparseWeights(int layer, CsrMatrix csr);
+    const CsrMatrix* sparseWeights(int layer) const;
+
+    // PyTorch 默认的 U(-1/sqrt(fan_in), 1/sqrt(fan_in)) 初始化，seed 固定时结果可复现
+    void initializeWeights(unsigned int seed = 42);
+
+    // input 为 batch 个连续样本，返回末层输出（指向内部 arena，下次 forward 前有效）
+    const float* forward(const float* input, int batch);
+    // 最近一次 forward 的第 index 层输出（Dropout/Flatten 与上一层共享缓冲区）
+    const float* layerOutput(int index) const;
+
+    // 最近一次 forward 的耗时
+    const QVector<double>& layerTimesMs() const { return m_layerTimesMs; }
+    double totalTimeMs() const { return m_totalTimeMs; }
+
+    // 形状、参数量与耗时报告
+    QString summary() const;
+
+private:
+    struct Layer {
+        LayerInfo info;
+        NeuralLayer spec;
+        std::size_t weightOffset = 0;
+        std::size_t weightCount = 0;
+        std::size_t biasOffset = 0;
+        std::size_t biasCount = 0;
+        std::size_t outOffset = 0;     // 在 arena 中的偏移（Identity 层不占空间）
+        const float* output = nullptr;  // 最近一次 forward 的输出位置
+        float initBound = 0.0f;         // 初始化范围 1/sqrt(fan_in)，循环层为 1/sqrt(units)
+        ConvShape conv;
+        ConvAlgorithm convAlgorithm = ConvAlgorithm::Im2colGemm;
+        simd::AlignedBuffer convWeights;  // 按算法预变换的卷积权重（Winograd）
+        RecurrentShape recurrentShape;
+        std::unique_ptr<RecurrentKernel> recurrent;  // 打包后的门权重，forward 前按需重新打包
+        std::unique_ptr<CsrMatrix> sparse;           // Dense 层剪枝后的 CSR 权重，为空时走稠密 GEMM
+    };
+
+    void repackWeights();
+
+    void runLayer(Layer& layer, const float* x, float* y, int batch);
+
+    ThreadPool* m_pool;
+    bool m_ready = false;
+    int m_maxBatch = 1;
+    LayerShape m_input;
+    std::vector<Layer> m_layers;
+    simd::AlignedBuffer m_params;   // 全部权重与偏置
+    simd::AlignedBuffer m_arena;    // 各层输出
+    simd::AlignedBuffer m_scratch;  // 卷积 / 循环层工作区
+    bool m_packDirty = true;
+    QVector<double> m_layerTimesMs;
+    double m_totalTimeMs = 0.0;
+};
+
+#endif // INFERENCEENGINE_H
@@ -1,6 +1,13 @@
 #include "json_utils.h"
+#include "jsonstream.h"
 #include <QJsonDocument>
 #include <QDebug>
+#include <QIODevice>
+#include <QLocale>
+#include <QPair>
+#include <QVector>
+#include <cstring>
+#include <limits>
 
 QJsonArray parseNetworkStructure(const QString& jsonStr) {//将JSON字符串解析为QJsonArray对象
     QJsonDocument doc = QJsonDocument::fromJson(jsonStr.toUtf8());
@@ -20,3 +27,292 @@ QString generateNetworkStructureJson(const QJsonArray& layersArray) {//将QJsonA
     QJsonDocument doc(rootObj);
     return QString::fromUtf8(doc.toJson());
 }
+
+namespace {
+
+// 层类型、激活函数只有少数几种取值：相同内容共用一个 QString（隐式共享），不必每层分配一次
+class StringPool
+{
+public:
+    QString get(const QByteArray& utf8)
+    {
+        for (const auto& entry : m_entries) {
+            if (entry.first == utf8)
+                return entry.second;
+        }
+        const QString text = QString::fromUtf8(utf8);
+        if (m_entries.size() < 32)
+            m_entries.append({QByteArray(utf8.constData(), utf8.size()), text});  // 深拷贝，读取器的缓冲区继续复用
+        return text;
+    }
+
+private:
+    QVector<QPair<QByteArray, QString>> m_entries;
+};
+
+// 与 QJsonValue::toInt() 相同：只有整数值且在 int 范围内才取值，否则为 0
+int jsonInt(double value)
+{
+    return value >= std::numeric_limits<int>::min() && value <= std::numeric_limits<int>::max() &&
+                   value == double(int(value))
+               ? int(value)
+               : 0;
+}
+
+// 读取 "layers" 的一个对象元素（BeginObject 已读入）。同名字段以最后一个为准，与 QJsonObject 相同
+bool readLayer(JsonStreamReader& reader, StringPool& pool, NeuralLayer* layer, bool* complete)
+{
+    bool hasType = false, hasNeurons = false, hasActivation = false;
+    QString type, activation;
+    int neurons = 0;
+    for (;;) {
+        const JsonStreamReader::Token token = reader.next();
+        if (token == JsonStreamReader::EndObject)
+            break;
+        if (token != JsonStreamReader::Key)
+            return false;
+        const bool isType = reader.textEquals("layerType");
+        const bool isNeurons = !isType && reader.textEquals("neurons");
+        const bool isActivation = !isType && !isNeurons && reader.textEquals("activationFunction");
+        if (!isType && !isNeurons && !isActivation) {
+            if (!reader.skipValue())
+                return false;
+            continue;
+        }
+        const JsonStreamReader::Token value = reader.next();
+        if (value == JsonStreamReader::Invalid)
+            return false;
+        if ((value == JsonStreamReader::BeginObject || value == JsonStreamReader::BeginArray) && !reader.skipContainer())
+            return false;
+        // 类型不符时取默认值，与 toString() / toInt() 相同
+        if (isType) {
+            hasType = true;
+            type = value == JsonStreamReader::String ? pool.get(reader.utf8()) : QString();
+        } else if (isNeurons) {
+            hasNeurons = true;
+            neurons = value == JsonStreamReader::Number ? jsonInt(reader.number()) : 0;
+        } else {
+            hasActivation = true;
+            activation = value == JsonStreamReader::String ? pool.get(reader.utf8()) : QString();
+        }
+    }
+    *complete = hasType && hasNeurons && hasActivation;
+    if (*complete) {
+        layer->layerType = type;
+        layer->neurons = neurons;
+        layer->activationFunction = activation;
+    }
+    return true;
+}
+
+bool readLayers(JsonStreamReader& reader, QList<NeuralLayer>* layers, QString* error)
+{
+    layers->clear();
+    auto fail = [&](const QString& message) {
+        layers->clear();
+        if (error)
+            *error = reader.hasError() ? reader.errorString() : QString("第 %1 字节：%2").arg(reader.offset()).arg(message);
+        return false;
+    };
+
+    if (reader.next() != JsonStreamReader::BeginObject)
+        return fail("顶层不是对象");
+    StringPool pool;
+    int incomplete = 0;
+    for (;;) {
+        const JsonStreamReader::Token token = reader.next();
+        if (token == JsonStreamReader::EndObject)
+            break;
+        if (token != JsonStreamReader::Key)
+            return fail("对象格式错误");
+        if (!reader.textEquals("layers")) {
+            if (!reader.skipValue())
+                return fail("对象格式错误");
+            continue;
+        }
+        layers->clear();  // 重复的 "layers" 以最后一个为准
+        incomplete = 0;
+        const JsonStreamReader::Token value = reader.next();
+        if (value == JsonStreamReader::Invalid)
+            return fail("layers 格式错误");
+        if (value == JsonStreamReader::BeginObject && !reader.skipContainer())
+            return fail("layers 格式错误");
+        if (value != JsonStreamReader::BeginArray)
+            continue;  // 不是数组：与 toArray() 相同，当作空
+        for (;;) {
+            const JsonStreamReader::Token element = reader.next();
+            if (element == JsonStreamReader::EndArray)
+                break;
+            NeuralLayer layer;
+            bool complete = false;
+            if (element == JsonStreamReader::BeginObject) {
+                if (!readLayer(reader, pool, &layer, &complete))
+                    return fail("层对象格式错误");
+            } else if (element == JsonStreamReader::BeginArray) {
+                if (!reader.skipContainer())
+                    return fail("layers 格式错误");
+            } else if (element == JsonStreamReader::Invalid) {
+                return fail("layers 格式错误");
+            }
+            incomplete += !complete;
+            layers->append(layer);
+        }
+    }
+    if (reader.next() != JsonStreamReader::EndOfDocument)
+        return fail("文档结束后还有内容");
+    if (incomplete > 0)
+        qDebug() << "readNetworkStructure:" << incomplete << "layers miss layerType / neurons / activationFunction, using defaults";
+    return true;
+}
+
+void appendInt(QByteArray& out, int value)
+{
+    char digits[12];
+    char* end = digits + sizeof digits;
+    char* p = end;
+    unsigned int v = value < 0 ? 0u - unsigned(value) : unsigned(value);
+    do {
+        *--p = char('0' + v % 10);
+        v /= 10;
+    } while (v);
+    if (value < 0)
+        *--p = '-';
+    out.append(p, int(end - p));
+}
+
+// 带引号的 JSON 字符串，转义规则与 QJsonDocument::toJson 相同；取值很少，转义结果按内容缓存
+class EscapeCache
+{
+public:
+    const QByteArray& get(const QString& text)
+    {
+        for (const auto& entry : m_entries) {
+            if (entry.first == text)
+                return entry.second;
+        }
+        if (m_entries.size() == 32)
+            m_entries.removeLast();
+        m_entries.prepend({text, escape(text)});
+        return m_entries.first().second;
+    }
+
+private:
+    static QByteArray escape(const QString& text)
+    {
+        static const char hex[] = "0123456789abcdef";
+        const QByteArray utf8 = text.toUtf8();
+        QByteArray out;
+        out.reserve(utf8.size() + 2);
+        out.append('"');
+        for (const char c : utf8) {
+            switch (c) {
+            case '"': out.append("\\\""); break;
+            case '\\': out.append("\\\\"); break;
+            case '\b': out.append("\\b"); break;
+            case '\f': out.append("\\f"); break;
+            case '\n': out.append("\\n"); break;
+            case '\r': out.append("\\r"); break;
+            case '\t': out.append("\\t"); break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    out.append("\\u00");
+                    out.append(hex[(c >> 4) & 0xF]);
+                    out.append(hex[c & 0xF]);
+                } else {
+                    out.append(c);
+                }
+            }
+        }
+        out.append('"');
+        return out;
+    }
+
+    QVector<QPair<QString, QByteArray>> m_entries;
+};
+
+// dropoutRate 的取值同样很少；最短往返格式与 QJsonDocument 写 double 时相同
+class RateCache
+{
+public:
+    const QByteArray& get(float rate)
+    {
+        for (const auto& entry : m_entries) {
+            if (std::memcmp(&entry.first, &rate, sizeof rate) == 0)
+                return entry.second;
+        }
+        if (m_entries.size() == 16)
+            m_entries.removeLast();
+        const double value = rate;
+        m_entries.prepend({rate, qIsFinite(value) ? QByteArray::number(value, 'g', QLocale::FloatingPointShortest)
+                                                  : QByteArray("null")});
+        return m_entries.first().second;
+    }
+
+private:
+    QVector<QPair<float, QByteArray>> m_entries;
+};
+
+// toJsonObject() 的字段按键名排序（QJsonObject 的顺序），缩进与 QJsonDocument::Indented 相同
+void appendLayer(QByteArray& out, const NeuralLayer& layer, EscapeCache& strings, RateCache& numbers)
+{
+    out.append("        {\n            \"activationFunction\": ");
+    out.append(strings.get(layer.activationFunction));
+    out.append(",\n            \"dropoutRate\": ");
+    out.append(numbers.get(layer.dropoutRate));
+    out.append(",\n            \"layerType\": ");
+    out.append(strings.get(layer.layerType));
+    out.append(",\n            \"neurons\": ");
+    appendInt(out, layer.neurons);
+    out.append(",\n            \"poolingSize\": ");
+    appendInt(out, layer.poolingSize);
+    out.append("\n        }");
+}
+
+template <typename Flush>
+bool writeLayers(const QList<NeuralLayer>& layers, QByteArray& out, Flush flush)
+{
+    EscapeCache strings;
+    RateCache numbers;
+    out.append("{\n    \"layers\": [\n");
+    for (int i = 0; i < layers.size(); ++i) {
+        appendLayer(out, layers[i], strings, numbers);
+        out.append(i + 1 < layers.size() ? ",\n" : "\n");
+        if (out.size() >= (1 << 20) && !flush())
+            return false;
+    }
+    out.append("    ]\n}\n");
+    return flush();
+}
+
+} // namespace
+
+bool readNetworkStructure(QIODevice* device, QList<NeuralLayer>* layers, QString* error)
+{
+    JsonStreamReader reader(device);
+    return readLayers(reader, layers, error);
+}
+
+bool readNetworkStructure(const QByteArray& json, QList<NeuralLayer>* layers, QString* error)
+{
+    JsonStreamReader reader(json);
+    return readLayers(reader, layers, error);
+}
+
+bool writeNetworkStructure(QIODevice* device, const QList<NeuralLayer>& layers)
+{
+    QByteArray chunk;
+    chunk.reserve((1 << 20) + 4096);
+    return writeLayers(layers, chunk, [&] {
+        const bool ok = device->write(chunk) == chunk.size();
+        chunk.resize(0);
+        return ok;
+    });
+}
+
+QByteArray networkStructureJson(const QList<NeuralLayer>& layers)
+{
+    QByteArray json;
+    json.reserve(32 + layers.size() * 200);  // 每层约 190 字节
+    writeLayers(layers, json, [] { return true; });
+    return json;
+}
@@ -1,8 +1,14 @@
 #ifndef JSON_UTILS_H
 #define JSON_UTILS_H
 
+#include "backend.h"
+
+#include <QByteArray>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QList>
+
+class QIODevice;
 
 
 QJsonArray parseNetworkStructure(const QString& jsonStr);// JSON解析接口声明，根据JSON数据类型解析为QJsonArray对象
@@ -10,6 +16,17 @@ QJsonArray parseNetworkStructure(const QString& jsonStr);// JSON解析接口声
 
 QString generateNetworkStructureJson(const QJsonArray& layersArray);// JSON生成接口声明，将网络结构相关数据转换为JSON格式
 
+// 流式读写：直接在字节与 NeuralLayer 之间转换，不建立 QJsonDocument / QJsonArray / QJsonObject。
+// 接受的格式与 parseNetworkStructure + NeuralLayer::fromJsonObject 相同：顶层对象的 "layers" 数组，
+// 缺少 layerType / neurons / activationFunction 任一字段的元素得到默认层，其余字段忽略；
+// 文档有语法错误或顶层不是对象时返回 false（原路径得到空数组）
+bool readNetworkStructure(QIODevice* device, QList<NeuralLayer>* layers, QString* error = nullptr);
+bool readNetworkStructure(const QByteArray& json, QList<NeuralLayer>* layers, QString* error = nullptr);
+
+// 与 generateNetworkStructureJson(各层 toJsonObject()) 相同的缩进格式，按 1 MB 分块写出
+bool writeNetworkStructure(QIODevice* device, const QList<NeuralLayer>& layers);
+QByteArray networkStructureJson(const QList<NeuralLayer>& layers);
+
 // 其他与JSON数据结构相关的声明
 // 比如表示完整网络结构的类等
 
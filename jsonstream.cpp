@@ -0,0 +1,365 @@
+#include "jsonstream.h"
+
+#include <QIODevice>
+
+#include <cstring>
+
+JsonStreamReader::JsonStreamReader(QIODevice* device, int bufferSize)
+    : m_device(device), m_bufferSize(qMax(bufferSize, 4096))
+{
+    m_buffer.resize(m_bufferSize);
+    m_text.reserve(256);
+    m_begin = m_pos = m_end = m_buffer.constData();
+}
+
+JsonStreamReader::JsonStreamReader(const QByteArray& data)
+    : m_buffer(data), m_eof(true)
+{
+    m_text.reserve(256);
+    m_begin = m_pos = m_buffer.constData();
+    m_end = m_begin + m_buffer.size();
+}
+
+// 把未读完的尾部移到缓冲区开头再接着读。词法单元跨缓冲区边界时由调用方先保存已读部分
+bool JsonStreamReader::fill()
+{
+    if (m_eof)
+        return false;
+    const qint64 rest = m_end - m_pos;
+    m_consumed += m_pos - m_begin;
+    char* data = m_buffer.data();
+    if (rest > 0)
+        std::memmove(data, m_pos, rest);
+    const qint64 got = m_device->read(data + rest, m_bufferSize - rest);
+    if (got <= 0)
+        m_eof = true;
+    m_begin = m_pos = data;
+    m_end = data + rest + qMax<qint64>(got, 0);
+    return got > 0;
+}
+
+bool JsonStreamReader::skipSpace()
+{
+    for (;;) {
+        while (m_pos < m_end) {
+            const char c = *m_pos;
+            if (c != ' ' && c != '\n' && c != '\r' && c != '\t')
+                return true;
+            ++m_pos;
+        }
+        if (!fill())
+            return false;
+    }
+}
+
+JsonStreamReader::Token JsonStreamReader::fail(const QString& message)
+{
+    if (m_error.isEmpty())
+        m_error = QString("第 %1 字节：%2").arg(offset()).arg(message);
+    m_expect = ExpectDone;
+    m_stack.clear();
+    return Invalid;
+}
+
+JsonStreamReader::Token JsonStreamReader::afterValue(Token token)
+{
+    m_expect = m_stack.isEmpty() ? ExpectDone : ExpectCommaOrEnd;
+    return token;
+}
+
+// m_pos 指向开头的引号。转义之外的字节整段拷贝
+bool JsonStreamReader::readString()
+{
+    m_text.resize(0);  // 保留容量，不必每个字符串都重新分配
+    ++m_pos;
+    for (;;) {
+        const char* start = m_pos;
+        while (m_pos < m_end && *m_pos != '"' && *m_pos != '\\' && static_cast<unsigned char>(*m_pos) >= 0x20)
+            ++m_pos;
+        m_text.append(start, int(m_pos - start));
+        if (m_pos == m_end) {
+            if (!fill())
+                return fail("字符串没有结束"), false;
+            continue;
+        }
+        const char c = *m_pos++;
+        if (c == '"')
+            return true;
+        if (c != '\\')
+            return fail("字符串中含有控制字符"), false;
+
+        if (m_pos == m_end && !fill())
+            return fail("字符串没有结束"), false;
+        const char e = *m_pos++;
+        switch (e) {
+        case '"': m_text.append('"'); break;
+        case '\\': m_text.append('\\'); break;
+        case '/': m_text.append('/'); break;
+        case 'b': m_text.append('\b'); break;
+        case 'f': m_text.append('\f'); break;
+        case 'n': m_text.append('\n'); break;
+        case 'r': m_text.append('\r'); break;
+        case 't': m_text.append('\t'); break;
+        case 'u': {
+            auto hex4 = [this](uint* out) {
+                if (m_end - m_pos < 4)
+                    fill();
+                if (m_end - m_pos < 4)
+                    return false;
+                uint v = 0;
+                for (int i = 0; i < 4; ++i) {
+                    const char h = *m_pos++;
+                    v <<= 4;
+                    if (h >= '0' && h <= '9') v |= uint(h - '0');
+                    else if (h >= 'a' && h <= 'f') v |= uint(h - 'a' + 10);
+                    else if (h >= 'A' && h <= 'F') v |= uint(h - 'A' + 10);
+                    else return false;
+                }
+                *out = v;
+                return true;
+            };
+            uint code = 0;
+            if (!hex4(&code))
+                return fail("\\u 转义格式错误"), false;
+            if (code >= 0xD800 && code < 0xDC00) {
+                // 代理对：后面必须紧跟 \uDC00–\uDFFF
+                if (m_end - m_pos < 2)
+                    fill();
+                uint low = 0;
+                if (m_end - m_pos < 2 || m_pos[0] != '\\' || m_pos[1] != 'u')
+                    return fail("\\u 代理对不完整"), false;
+                m_pos += 2;
+                if (!hex4(&low) || low < 0xDC00 || low > 0xDFFF)
+                    return fail("\\u 代理对不完整"), false;
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            } else if (code >= 0xDC00 && code <= 0xDFFF) {
+                return fail("\\u 代理对不完整"), false;
+            }
+            if (code < 0x80) {
+                m_text.append(char(code));
+            } else if (code < 0x800) {
+                m_text.append(char(0xC0 | (code >> 6)));
+                m_text.append(char(0x80 | (code & 0x3F)));
+            } else if (code < 0x10000) {
+                m_text.append(char(0xE0 | (code >> 12)));
+                m_text.append(char(0x80 | ((code >> 6) & 0x3F)));
+                m_text.append(char(0x80 | (code & 0x3F)));
+            } else {
+                m_text.append(char(0xF0 | (code >> 18)));
+                m_text.append(char(0x80 | ((code >> 12) & 0x3F)));
+                m_text.append(char(0x80 | ((code >> 6) & 0x3F)));
+                m_text.append(char(0x80 | (code & 0x3F)));
+            }
+            break;
+        }
+        default:
+            return fail(QString("未知的转义 \\%1").arg(QChar(e))), false;
+        }
+    }
+}
+
+// 按 JSON 语法检查数字格式，再交给 QByteArray::toDouble（与区域设置无关）
+bool JsonStreamReader::readNumber()
+{
+    char digits[64];
+    int n = 0;
+    for (;;) {
+        while (m_pos < m_end) {
+            const char c = *m_pos;
+            if (!((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E'))
+                goto done;
+            if (n == int(sizeof digits) - 1)
+                return fail("数字过长"), false;
+            digits[n++] = c;
+            ++m_pos;
+        }
+        if (!fill())
+            break;
+    }
+done:
+    int i = 0;
+    if (i < n && digits[i] == '-')
+        ++i;
+    if (i == n || !(digits[i] >= '0' && digits[i] <= '9'))
+        return fail("数字格式错误"), false;
+    if (digits[i] == '0')
+        ++i;
+    else
+        while (i < n && digits[i] >= '0' && digits[i] <= '9') ++i;
+    if (i < n && digits[i] == '.') {
+        const int start = ++i;
+        while (i < n && digits[i] >= '0' && digits[i] <= '9') ++i;
+        if (i == start)
+            return fail("数字格式错误"), false;
+    }
+    if (i < n && (digits[i] == 'e' || digits[i] == 'E')) {
+        ++i;
+        if (i < n && (digits[i] == '+' || digits[i] == '-'))
+            ++i;
+        const int start = i;
+        while (i < n && digits[i] >= '0' && digits[i] <= '9') ++i;
+        if (i == start)
+            return fail("数字格式错误"), false;
+    }
+    if (i != n)
+        return fail("数字格式错误"), false;
+    if (m_skipping)
+        return true;  // skipValue() 不需要数值
+
+    // 绝大多数是不带小数、指数的整数，直接累加
+    bool plain = n < 19;
+    for (int k = digits[0] == '-' ? 1 : 0; plain && k < n; ++k)
+        plain = digits[k] >= '0' && digits[k] <= '9';
+    if (plain) {
+        qint64 v = 0;
+        for (int k = digits[0] == '-' ? 1 : 0; k < n; ++k)
+            v = v * 10 + (digits[k] - '0');
+        m_number = double(digits[0] == '-' ? -v : v);
+        return true;
+    }
+    m_number = QByteArray::fromRawData(digits, n).toDouble();
+    return true;
+}
+
+bool JsonStreamReader::readLiteral(const char* literal)
+{
+    const int n = int(std::strlen(literal));
+    if (m_end - m_pos < n)
+        fill();
+    if (m_end - m_pos < n || std::memcmp(m_pos, literal, n) != 0)
+        return fail("无法识别的值"), false;
+    m_pos += n;
+    return true;
+}
+
+// 已读入开头的 '{' 或 '['（并已压栈）：只数括号、跳过字符串，直到与之配对的右括号
+bool JsonStreamReader::skipContainer()
+{
+    const int base = m_stack.size() - 1;
+    int depth = 1;
+    for (;;) {
+        while (m_pos < m_end) {
+            const char c = *m_pos++;
+            if (c == '"') {
+                for (;;) {
+                    while (m_pos < m_end && *m_pos != '"' && *m_pos != '\\')
+                        ++m_pos;
+                    if (m_pos == m_end) {
+                        if (!fill())
+                            return fail("字符串没有结束"), false;
+                        continue;
+                    }
+                    if (*m_pos == '"') {
+                        ++m_pos;
+                        break;
+                    }
+                    // 反斜杠：连同后面一个字符一起跳过
+                    if (m_end - m_pos < 2)
+                        fill();
+                    if (m_end - m_pos < 2)
+                        return fail("字符串没有结束"), false;
+                    m_pos += 2;
+                }
+            } else if (c == '{' || c == '[') {
+                ++depth;
+            } else if (c == '}' || c == ']') {
+                if (--depth == 0) {
+                    if ((c == '}') != (m_stack.last() == '{'))
+                        return fail("括号不配对"), false;
+                    m_stack.resize(base);
+                    afterValue(Null);
+                    return true;
+                }
+            }
+        }
+        if (!fill())
+            return fail("文件在对象或数组中间结束"), false;
+    }
+}
+
+bool JsonStreamReader::skipValue()
+{
+    m_skipping = true;
+    const Token token = next();
+    m_skipping = false;
+    if (token == BeginObject || token == BeginArray)
+        return skipContainer();
+    return token != Invalid && token != EndObject && token != EndArray && token != Key && token != EndOfDocument;
+}
+
+JsonStreamReader::Token JsonStreamReader::next()
+{
+    for (;;) {
+        if (!skipSpace()) {
+            if (m_expect == ExpectDone && m_error.isEmpty())
+                return EndOfDocument;
+            return fail("文件意外结束");
+        }
+        const char c = *m_pos;
+        const bool wantValue = m_expect == ExpectValue || m_expect == ExpectValueOrEnd;
+
+        switch (c) {
+        case '{':
+        case '[':
+            if (!wantValue)
+                return fail(QString("此处不应出现 '%1'").arg(QChar(c)));
+            ++m_pos;
+            m_stack.append(c);
+            m_expect = c == '{' ? ExpectKeyOrEnd : ExpectValueOrEnd;
+            return c == '{' ? BeginObject : BeginArray;
+        case '}':
+        case ']': {
+            const char open = c == '}' ? '{' : '[';
+            const bool canClose = c == '}' ? (m_expect == ExpectKeyOrEnd || m_expect == ExpectCommaOrEnd)
+                                           : (m_expect == ExpectValueOrEnd || m_expect == ExpectCommaOrEnd);
+            if (!canClose || m_stack.isEmpty() || m_stack.last() != open)
+                return fail(QString("此处不应出现 '%1'").arg(QChar(c)));
+            ++m_pos;
+            m_stack.removeLast();
+            return afterValue(c == '}' ? EndObject : EndArray);
+        }
+        case ',':
+            if (m_expect != ExpectCommaOrEnd)
+                return fail("此处不应出现 ','");
+            ++m_pos;
+            m_expect = m_stack.last() == '{' ? ExpectKey : ExpectValue;
+            continue;
+        case ':':
+            if (m_expect != ExpectColon)
+                return fail("此处不应出现 ':'");
+            ++m_pos;
+            m_expect = ExpectValue;
+            continue;
+        case '"':
+            if (m_expect == ExpectKeyOrEnd || m_expect == ExpectKey) {
+                if (!readString())
+                    return Invalid;
+                m_expect = ExpectColon;
+                return Key;
+            }
+            if (!wantValue)
+                return fail("此处不应出现字符串");
+            if (!readString())
+                return Invalid;
+            return afterValue(String);
+        case 't':
+        case 'f':
+        case 'n':
+            if (!wantValue)
+                return fail("此处不应出现值");
+            if (!readLiteral(c == 't' ? "true" : c == 'f' ? "false" : "null"))
+                return Invalid;
+            m_bool = c == 't';
+            return afterValue(c == 'n' ? Null : Bool);
+        default:
+            if (c == '-' || (c >= '0' && c <= '9')) {
+                if (!wantValue)
+                    return fail("此处不应出现数字");
+                if (!readNumber())
+                    return Invalid;
+                return afterValue(Number);
+            }
+            return fail(QString("无法识别的字符 '%1'").arg(QChar(c)));
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef JSONSTREAM_H
+#define JSONSTREAM_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+class QIODevice;
+
+// 拉取式（逐个词法单元）JSON 读取器：从 QIODevice 按固定大小的缓冲区读入，不建立 QJsonDocument，
+// 内存与文件大小无关。字符串只在取值时解码；skipValue() 跳过整个对象 / 数组时只数括号、不解码内容。
+// 结构错误（括号不配对、缺少逗号或冒号……）时 next() 返回 Invalid，errorString() 给出字节位置
+class JsonStreamReader
+{
+public:
+    enum Token { Invalid, BeginObject, EndObject, BeginArray, EndArray, Key, String, Number, Bool, Null, EndOfDocument };
+
+    explicit JsonStreamReader(QIODevice* device, int bufferSize = 1 << 20);
+    explicit JsonStreamReader(const QByteArray& data);
+
+    Token next();
+    // 跳过下一个值（在 Key 之后、或数组中下一个元素之前调用）；值为对象 / 数组时整个跳过
+    bool skipValue();
+    // 已由 next() 读入 BeginObject / BeginArray 之后，跳过其余部分直到配对的右括号
+    bool skipContainer();
+
+    // 当前 Key / String 的 UTF-8 内容（已处理转义）
+    const QByteArray& utf8() const { return m_text; }
+    QString string() const { return QString::fromUtf8(m_text); }
+    bool textEquals(const char* literal) const { return m_text == literal; }
+    double number() const { return m_number; }
+    bool boolean() const { return m_bool; }
+
+    int depth() const { return m_stack.size(); }
+    qint64 offset() const { return m_consumed + (m_pos - m_begin); }
+    bool hasError() const { return !m_error.isEmpty(); }
+    QString errorString() const { return m_error; }
+
+private:
+    enum Expect : quint8 { ExpectValue, ExpectKeyOrEnd, ExpectKey, ExpectColon, ExpectCommaOrEnd, ExpectValueOrEnd, ExpectDone };
+
+    bool fill();
+    bool skipSpace();
+    Token fail(const QString& message);
+    Token afterValue(Token token);
+    bool readString();
+    bool readNumber();
+    bool readLiteral(const char* literal);
+
+    QIODevice* m_device = nullptr;
+    QByteArray m_buffer;
+    const char* m_begin = nullptr;
+    const char* m_pos = nullptr;
+    const char* m_end = nullptr;
+    qint64 m_consumed = 0;  // 已移出缓冲区的字节数
+    int m_bufferSize = 0;
+    bool m_eof = false;
+
+    QVector<char> m_stack;  // '{' 或 '['
+    Expect m_expect = ExpectValue;
+    QByteArray m_text;
+    double m_number = 0.0;
+    bool m_bool = false;
+    bool m_skipping = false;  // skipValue() 中：数字只检查格式，不转换
+    QString m_error;
+};
+
+#endif // JSONSTREAM_H
@@ -0,0 +1,356 @@
+#include "latencypredictor.h"
+#include "activations.h"
+#include "convautotuner.h"
+#include "gemm.h"
+#include "recurrentkernels.h"
+#include "simdutils.h"
+#include "threadpool.h"
+#include <QDateTime>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace {
+
+constexpr int kProfileVersion = 1;
+// 工作集不超过该大小时按缓存带宽估算访存时间
+constexpr double kCacheResidentBytes = 1024.0 * 1024.0;
+
+// 预热一次后重复执行，取中位数（毫秒）；累计约 30 ms 或 21 次后停止
+// 用中位数而不是最小值，使预测贴近界面中实际看到的典型耗时
+template <typename Fn>
+double medianMs(Fn&& fn) {
+    fn();
+    std::vector<double> times;
+    double total = 0.0;
+    while (times.size() < 21 && (times.size() < 5 || total < 30.0)) {
+        const auto t0 = std::chrono::steady_clock::now();
+        fn();
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+        total += times.back();
+    }
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    return times[times.size() / 2];
+}
+
+std::vector<float> randomVector(std::size_t n, float scale = 1.0f) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> dist(-scale, scale);
+    std::vector<float> v(n);
+    for (float& x : v) x = dist(rng);
+    return v;
+}
+
+double streamGBs(std::size_t floats, ThreadPool* pool) {
+    std::vector<float> data = randomVector(floats);
+    // ReLU 原地读写一遍：每个元素读 4 字节、写 4 字节
+    const double ms = medianMs([&] { biasActivation(data.data(), 1, static_cast<int>(floats), nullptr, Activation::ReLU, pool); });
+    return 8.0 * floats / ms / 1.0e6;
+}
+
+} // namespace
+
+LatencyPredictor& LatencyPredictor::instance() {
+    static LatencyPredictor predictor;
+    return predictor;
+}
+
+LatencyPredictor::LatencyPredictor() {
+    // 先构造校准线程会用到的全局对象，保证它们在本对象之后析构
+    ThreadPool::global();
+    ConvAutotuner::instance();
+}
+
+LatencyPredictor::~LatencyPredictor() {
+    if (m_calibration.joinable()) m_calibration.join();
+}
+
+void LatencyPredictor::calibrateInBackground() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_ready || m_calibrating || m_calibration.joinable()) return;
+    m_calibration = std::thread([this] { profile(); });
+}
+
+QString LatencyPredictor::cpuModelName() {
+    QString model;
+#if defined(__x86_64__) || defined(__i386__) || (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+    // CPUID 0x80000002..0x80000004 返回 48 字节的品牌字符串
+    unsigned int regs[12] = {};
+    bool ok = true;
+    for (unsigned int i = 0; i < 3 && ok; ++i) {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int r[4];
+        __cpuid(r, static_cast<int>(0x80000002u + i));
+        std::memcpy(regs + 4 * i, r, sizeof(r));
+#else
+        ok = __get_cpuid(0x80000002u + i, &regs[4 * i], &regs[4 * i + 1], &regs[4 * i + 2], &regs[4 * i + 3]) != 0;
+#endif
+    }
+    if (ok) {
+        char brand[49] = {};
+        std::memcpy(brand, regs, 48);
+        model = QString::fromLatin1(brand).simplified();
+    }
+#endif
+    if (model.isEmpty()) model = QSysInfo::currentCpuArchitecture();
+    return model;
+}
+
+QString LatencyPredictor::cacheKey() const {
+    return QString("%1|t%2|%3").arg(cpuModelName()).arg(ThreadPool::global().threadCount())
+        .arg(simd::hasAvx2() ? "avx2" : "scalar");
+}
+
+MachineProfile LatencyPredictor::profile() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_ready) return m_profile;
+    }
+    return calibrate(true);
+}
+
+bool LatencyPredictor::tryProfile(MachineProfile* profile) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_ready && profile) *profile = m_profile;
+    return m_ready;
+}
+
+bool LatencyPredictor::isReady() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_ready;
+}
+
+MachineProfile LatencyPredictor::recalibrate() {
+    return calibrate(false);
+}
+
+MachineProfile LatencyPredictor::calibrate(bool useCache) {
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_calibrationDone.wait(lock, [this] { return !m_calibrating; });
+        // 等待期间别的线程已经校准完成
+        if (useCache && m_ready) return m_profile;
+        m_calibrating = true;
+    }
+
+    // 读缓存和跑微基准都不持锁，tryProfile / isReady 随时可以返回
+    const QString key = cacheKey();
+    MachineProfile measured;
+    if (!useCache || !loadCached(key, &measured)) {
+        measured = measure();
+        saveCached(key, measured);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_profile = measured;
+        m_ready = true;
+        m_calibrating = false;
+    }
+    m_calibrationDone.notify_all();
+    emit calibrated();
+    return measured;
+}
+
+MachineProfile LatencyPredictor::measure() {
+    ThreadPool* pool = &ThreadPool::global();
+    MachineProfile p;
+    p.cpuModel = cpuModelName();
+    p.threads = pool->threadCount();
+
+    {
+        // 与推理引擎的全连接层相同：权重按 [out][in] 存放，transB = true
+        const int M = 64, N = 512, K = 512;
+        std::vector<float> A = randomVector(std::size_t(M) * K);
+        std::vector<float> B = randomVector(std::size_t(N) * K);
+        std::vector<float> C(std::size_t(M) * N);
+        const double ms = medianMs([&] { sgemm(M, N, K, A.data(), K, B.data(), K, true, C.data(), N, false, pool); });
+        p.gemmGflops = 2.0 * M * N * K / ms / 1.0e6;
+    }
+    {
+        const int N = 512, K = 784;
+        std::vector<float> A = randomVector(K);
+        std::vector<float> B = randomVector(std::size_t(N) * K);
+        std::vector<float> C(N);
+        const double ms = medianMs([&] { sgemm(1, N, K, A.data(), K, B.data(), K, true, C.data(), N, false, pool); });
+        p.weightStreamGBs = sizeof(float) * double(N) * K / ms / 1.0e6;
+    }
+    {
+        const ConvShape shape{32, 32, 32, 32, 3, 1};
+        // 在校准线程上等实测结果，而不是用尚未计时时的启发式选择
+        const ConvAlgorithm algorithm = ConvAutotuner::instance().result(shape, pool).algorithm;
+        std::vector<float> x = randomVector(std::size_t(shape.channels) * shape.height * shape.width);
+        std::vector<float> w = randomVector(std::size_t(shape.filters) * shape.patchSize());
+        std::vector<float> y(std::size_t(shape.filters) * shape.outHeight() * shape.outWidth());
+        simd::AlignedBuffer scratch;
+        simd::AlignedBuffer transformed;
+        scratch.resize(static_cast<std::size_t>(convScratchSize(shape, algorithm)));
+        transformed.resize(static_cast<std::size_t>(convTransformedWeightSize(shape, algorithm)));
+        convTransformWeights(shape, algorithm, w.data(), transformed.data());
+        const double ms = medianMs([&] {
+            conv2d(shape, algorithm, x.data(), w.data(), transformed.data(), y.data(), scratch.data(), pool);
+        });
+        p.convGflops = 2.0 * shape.filters * shape.patchSize() * shape.outHeight() * shape.outWidth() / ms / 1.0e6;
+    }
+    {
+        const RecurrentShape shape{RecurrentCell::LSTM, 8, 16, 128, 128};
+        const std::size_t gw = shape.gateWidth();
+        std::vector<float> x = randomVector(std::size_t(shape.batch) * shape.steps * shape.features);
+        std::vector<float> wIH = randomVector(gw * shape.features, 0.1f);
+        std::vector<float> wHH = randomVector(gw * shape.units, 0.1f);
+        std::vector<float> bias = randomVector(gw, 0.1f);
+        std::vector<float> y(std::size_t(shape.batch) * shape.steps * shape.units);
+        simd::AlignedBuffer workspace;
+        workspace.resize(static_cast<std::size_t>(RecurrentKernel::workspaceSize(shape)));
+        RecurrentKernel kernel;
+        kernel.pack(shape, wIH.data(), wHH.data(), bias.data(), bias.data());
+        const double ms = medianMs([&] { kernel.forward(x.data(), y.data(), shape.batch, workspace.data(), pool); });
+        p.recurrentGflops = 2.0 * shape.batch * shape.steps * gw * (shape.features + shape.units) / ms / 1.0e6;
+    }
+    p.bandwidthGBs = streamGBs(std::size_t(16) << 20, pool);    // 64 MB，远超末级缓存
+    p.cacheBandwidthGBs = streamGBs(std::size_t(64) << 10, pool);  // 256 KB，留在 L2 中
+    {
+        const double ms = medianMs([&] {
+            for (int i = 0; i < 100; ++i) pool->parallelFor(0, pool->threadCount(), 1, [](int, int) {});
+        });
+        p.overheadUs = ms * 1000.0 / 100.0;
+    }
+    return p;
+}
+
+bool LatencyPredictor::loadCached(const QString& key, MachineProfile* profile) const {
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+    file.close();
+    const QJsonObject root = doc.object();
+    if (root["version"].toInt() != kProfileVersion) return false;
+    const QJsonObject entry = root["profiles"].toObject().value(key).toObject();
+    if (entry.isEmpty()) return false;
+
+    profile->cpuModel = entry["cpuModel"].toString();
+    profile->threads = entry["threads"].toInt(1);
+    profile->gemmGflops = entry["gemmGflops"].toDouble();
+    profile->weightStreamGBs = entry["weightStreamGBs"].toDouble();
+    profile->convGflops = entry["convGflops"].toDouble();
+    profile->recurrentGflops = entry["recurrentGflops"].toDouble();
+    profile->bandwidthGBs = entry["bandwidthGBs"].toDouble();
+    profile->cacheBandwidthGBs = entry["cacheBandwidthGBs"].toDouble();
+    profile->overheadUs = entry["overheadUs"].toDouble();
+    return profile->gemmGflops > 0.0 && profile->weightStreamGBs > 0.0 && profile->convGflops > 0.0 && profile->recurrentGflops > 0.0
+           && profile->bandwidthGBs > 0.0 && profile->cacheBandwidthGBs > 0.0;
+}
+
+void LatencyPredictor::saveCached(const QString& key, const MachineProfile& profile) const {
+    QFile file(m_path);
+    QJsonObject root;
+    if (file.open(QIODevice::ReadOnly)) {
+        root = QJsonDocument::fromJson(file.readAll()).object();
+        file.close();
+    }
+    if (root.value("version").toInt() != kProfileVersion) root = QJsonObject();
+
+    QJsonObject entry;
+    entry["cpuModel"] = profile.cpuModel;
+    entry["threads"] = profile.threads;
+    entry["gemmGflops"] = profile.gemmGflops;
+    entry["weightStreamGBs"] = profile.weightStreamGBs;
+    entry["convGflops"] = profile.convGflops;
+    entry["recurrentGflops"] = profile.recurrentGflops;
+    entry["bandwidthGBs"] = profile.bandwidthGBs;
+    entry["cacheBandwidthGBs"] = profile.cacheBandwidthGBs;
+    entry["overheadUs"] = profile.overheadUs;
+    entry["measuredAt"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+
+    QJsonObject profiles = root.value("profiles").toObject();
+    profiles[key] = entry;
+    root["version"] = kProfileVersion;
+    root["profiles"] = profiles;
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        file.write(QJsonDocument(root).toJson());
+        file.close();
+    }
+}
+
+LatencyReport LatencyPredictor::predict(const QList<NeuralLayer>& layers, int batch) {
+    return predict(layers, profile(), batch);
+}
+
+LatencyReport LatencyPredictor::predict(const QList<NeuralLayer>& layers, const MachineProfile& p, int batch) {
+    LatencyReport report;
+    report.batch = std::max(1, batch);
+    QList<const NeuralLayer*> ordered;
+    for (const NeuralLayer& layer : layers) ordered.append(&layer);
+    QVector<LayerShape> shapes;
+    if (ordered.isEmpty()) {
+        report.error = "网络为空";
+        return report;
+    }
+    if (!inferLayerShapes(ordered, defaultInputShape(ordered), shapes, &report.error)) return report;
+
+    const double n = report.batch;
+    LayerShape in = defaultInputShape(ordered);
+    for (int i = 0; i < layers.size(); ++i) {
+        const NeuralLayer& layer = layers[i];
+        const LayerShape& out = shapes[i];
+        LayerLatency l;
+        l.layerType = layer.layerType;
+        double weights = 0.0;
+        double peakGflops = 0.0;  // 0 表示纯访存层
+        double packedWeights = 0.0;  // 每次前向都要打包的权重（全连接层）
+        int sequentialSteps = 1;  // 循环层每个时间步都有一次派发开销
+        bool identity = false;
+
+        if (layer.isDense()) {
+            const double inFeatures = in.spatial ? in.size() : in.width;
+            packedWeights = inFeatures * out.width;
+            weights = out.width;
+            l.flops = 2.0 * n * out.height * inFeatures * out.width;
+            peakGflops = p.gemmGflops;
+        } else if (layer.isConvolutional()) {
+            const double patch = double(in.channels) * layer.kernelSize * layer.kernelSize;
+            weights = out.channels * patch + out.channels;
+            l.flops = 2.0 * n * out.channels * patch * out.height * out.width;
+            peakGflops = p.convGflops;
+        } else if (layer.isPooling()) {
+            l.flops = n * out.size() * layer.poolingSize * layer.poolingSize;
+        } else if (layer.isRecurrent()) {
+            const int gates = layer.layerType == "LSTM" ? 4 : (layer.layerType == "GRU" ? 3 : 1);
+            const double gw = double(gates) * out.width;
+            weights = gw * (in.width + out.width) + 2.0 * gw;
+            l.flops = 2.0 * n * out.height * gw * (in.width + out.width);
+            peakGflops = p.recurrentGflops;
+            sequentialSteps = out.height;
+        } else {
+            identity = true;  // Dropout / Flatten 推理时不做计算
+        }
+
+        if (!identity) {
+            const double streamed = sizeof(float) * (weights + n * (in.size() + out.size()));
+            const double packed = sizeof(float) * packedWeights;
+            l.bytes = streamed + packed;
+            const double bandwidth = streamed <= kCacheResidentBytes ? p.cacheBandwidthGBs : p.bandwidthGBs;
+            l.memoryMs = streamed / bandwidth / 1.0e6 + packed / p.weightStreamGBs / 1.0e6;
+            l.computeMs = peakGflops > 0.0 ? l.flops / peakGflops / 1.0e6 : 0.0;
+            l.memoryBound = l.memoryMs >= l.computeMs;
+            l.predictedMs = std::max(l.computeMs, l.memoryMs) + sequentialSteps * p.overheadUs / 1000.0;
+        }
+        report.totalMs += l.predictedMs;
+        report.layers.append(l);
+        in = out;
+    }
+    report.valid = true;
+    return report;
+}
@@ -0,0 +1,93 @@
+#ifndef LATENCYPREDICTOR_H
+#define LATENCYPREDICTOR_H
+
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "backend.h"
+
+// 本机的实测性能参数，由启动时的微基准得到，按 CPU 型号缓存到 latency_profile.json
+struct MachineProfile
+{
+    QString cpuModel;
+    int threads = 1;
+    double gemmGflops = 0.0;         // 64×512×512 分块 GEMM（全连接层）
+    double weightStreamGBs = 0.0;    // 1×512×784 GEMM 的有效权重带宽：小批次全连接层的瓶颈是每次前向打包权重
+    double convGflops = 0.0;         // 32×32×32 -> 32, 3×3，按自动选择的算法
+    double recurrentGflops = 0.0;    // LSTM batch 8，128 units（逐时间步的小 GEMM）
+    double bandwidthGBs = 0.0;       // 超出缓存的逐元素读写带宽（主存）
+    double cacheBandwidthGBs = 0.0;  // 工作集留在 L2 时的读写带宽
+    double overheadUs = 0.0;         // 单层固定开销（线程池派发等）
+};
+
+// 一层的 roofline 预测：耗时 = max(计算量 / 该类内核峰值, 访存量 / 带宽) + 固定开销
+struct LayerLatency
+{
+    QString layerType;
+    double flops = 0.0;  // 整个批次
+    double bytes = 0.0;  // 权重 + 输入 + 输出
+    double computeMs = 0.0;
+    double memoryMs = 0.0;
+    double predictedMs = 0.0;
+    bool memoryBound = false;
+};
+
+struct LatencyReport
+{
+    bool valid = false;
+    QString error;
+    int batch = 1;
+    QVector<LayerLatency> layers;
+    double totalMs = 0.0;
+};
+
+class LatencyPredictor : public QObject
+{
+    Q_OBJECT
+
+public:
+    static LatencyPredictor& instance();
+    ~LatencyPredictor() override;
+
+    // 启动时调用：在后台线程读取缓存或跑微基准，不阻塞界面
+    void calibrateInBackground();
+
+    // 尚未校准时同步校准（约几百毫秒），其他线程正在校准时等它完成；界面线程应改用 tryProfile
+    MachineProfile profile();
+    // 不阻塞：已校准时取出参数并返回 true
+    bool tryProfile(MachineProfile* profile);
+    bool isReady();
+    // 忽略缓存重新测量，并写回缓存文件
+    MachineProfile recalibrate();
+
+    LatencyReport predict(const QList<NeuralLayer>& layers, int batch = 1);
+    LatencyReport predict(const QList<NeuralLayer>& layers, const MachineProfile& profile, int batch = 1);
+
+    static QString cpuModelName();
+
+signals:
+    // 每次校准完成（包括从缓存读入）时在校准所在的线程发出，界面应以排队连接接收
+    void calibrated();
+
+private:
+    LatencyPredictor();
+    MachineProfile calibrate(bool useCache);
+    static MachineProfile measure();
+    bool loadCached(const QString& key, MachineProfile* profile) const;
+    void saveCached(const QString& key, const MachineProfile& profile) const;
+    QString cacheKey() const;
+
+    QString m_path = "latency_profile.json";
+    std::mutex m_mutex;
+    std::condition_variable m_calibrationDone;
+    bool m_ready = false;
+    bool m_calibrating = false;  // 测量期间不持锁，只用该标志让其他校准请求等待
+    MachineProfile m_profile;
+    std::thread m_calibration;
+};
+
+#endif // LATENCYPREDICTOR_H
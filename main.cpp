@@ -5,11 +5,24 @@
 #include <QMetaType>
 #include <QTranslator>
 #include "networkvisualizer.h"
+#include "benchmarks.h"
+#include "latencypredictor.h"
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
     qRegisterMetaType<NeuralLayer>("NeuralLayer");
+    qRegisterMetaType<QVector<QVector<float>>>("QVector<QVector<float>>");  // 训练线程发送的权重快照
+
+    // 命令行基准测试模式：--benchmark [名称...]
+    const QStringList args = a.arguments();
+    const int benchIndex = args.indexOf("--benchmark");
+    if (benchIndex >= 0) {
+        return runBenchmarks(args.mid(benchIndex + 1));
+    }
+
+    // 后台读取/测量本机性能参数，供块视图的延迟预测使用
+    LatencyPredictor::instance().calibrateInBackground();
     QTranslator translator;
     const QStringList uiLanguages = QLocale::system().uiLanguages();
     for (const QString &locale : uiLanguages) {
@@ -5,6 +5,13 @@
 #include "propertypanel.h"
 #include "networkvisualizer.h"
 #include "matrial.h"
+#include "weightcheckpoint.h"
+#include "bulkimport.h"
+#include "historyloader.h"
+#include "json_utils.h"
+#include "modulerepr.h"
+#include "onnxmodel.h"
+#include "traceprofile.h"
 #include <QIcon>
 #include <QPushButton>
 #include <QJsonDocument>
@@ -16,6 +23,7 @@
 #include <QGraphicsRectItem>
 #include <QJsonArray>
 #include <QFile>
+#include <QSaveFile>
 #include <QProgressBar>
 #include <QDialog>
 #include <QListWidget>
@@ -24,6 +32,10 @@
 #include <QApplication>
 #include <QPixmap>
 #include <QPalette>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QInputDialog>
+#include <QElapsedTimer>
 
 PropertyPanel* propertyPanel;
 
@@ -149,6 +161,52 @@ MainWindow::MainWindow(QWidget *parent)
         showFloatingMessage("NeuronitemGenerate");
     });
 
+    // 检查点只映射文件、解析头部，权重在图像中用到时才读取
+    modeMenu->addSeparator();
+    QAction* loadCheckpointAction = modeMenu->addAction("加载权重检查点…");
+    QAction* unloadCheckpointAction = modeMenu->addAction("卸载权重检查点");
+    connect(loadCheckpointAction, &QAction::triggered, this, &MainWindow::loadCheckpoint);
+    connect(unloadCheckpointAction, &QAction::triggered, this, [=]() {
+        WeightCheckpoint::setActive(nullptr);
+        if (auto* view = qobject_cast<NetworkVisualizer*>(ui->scrollAreavisualizer->widget())) view->applyCheckpoint(nullptr);
+        showFloatingMessage("已卸载权重检查点，重新生成图像后恢复随机连线");
+    });
+
+    // 样本输入在当前图像对应的网络上前向，按激活幅值着色
+    modeMenu->addSeparator();
+    QAction* loadSamplesAction = modeMenu->addAction("加载样本输入…");
+    QAction* clearSamplesAction = modeMenu->addAction("清除激活热度");
+    connect(loadSamplesAction, &QAction::triggered, this, &MainWindow::loadSamples);
+    connect(clearSamplesAction, &QAction::triggered, this, [=]() {
+        if (auto* view = qobject_cast<NetworkVisualizer*>(ui->scrollAreavisualizer->widget())) view->clearActivations();
+    });
+    // 线上采集的 torch.profiler 追踪按模块作用域汇总，显示在块视图的各层上
+    QAction* loadTraceAction = modeMenu->addAction("加载 PyTorch profiler 追踪…");
+    connect(loadTraceAction, &QAction::triggered, this, &MainWindow::loadProfilerTrace);
+
+    // 批量导入目录下的 PyTorch 模型源码，每个模型一条历史记录；解析结果按内容缓存，重复导入只解析改动过的文件
+    modeMenu->addSeparator();
+    QAction* importModelsAction = modeMenu->addAction("批量导入 PyTorch 模型目录…");
+    connect(importModelsAction, &QAction::triggered, this, &MainWindow::importModelFolder);
+    // ONNX 模型只映射文件、扫描节点，initializer 数据不读入内存
+    QAction* importOnnxAction = modeMenu->addAction("导入 ONNX 模型…");
+    connect(importOnnxAction, &QAction::triggered, this, &MainWindow::importOnnxModel);
+    // 粘贴 print(model) 的输出，嵌套的子模块在块视图中显示为可折叠的分组
+    QAction* importReprAction = modeMenu->addAction("粘贴 print(model) 输出…");
+    connect(importReprAction, &QAction::triggered, this, &MainWindow::importModelRepr);
+    // 监视编辑器中的模型文件，保存后只把变化的层与连线改到当前图上
+    QAction* watchAction = modeMenu->addAction("监视模型文件…");
+    QAction* stopWatchAction = modeMenu->addAction("停止监视");
+    connect(watchAction, &QAction::triggered, this, &MainWindow::watchModelFile);
+    connect(stopWatchAction, &QAction::triggered, this, [=]() {
+        if (!modelWatcher || modelWatcher->path().isEmpty()) return;
+        showFloatingMessage(QString("已停止监视 %1").arg(QFileInfo(modelWatcher->path()).fileName()));
+        modelWatcher->stop();
+    });
+    // 当前记录导出为 {"layers": [...]}，逐层流式写出；导出的文件可以再用“监视模型文件”打开
+    QAction* exportJsonAction = modeMenu->addAction("导出网络结构 JSON…");
+    connect(exportJsonAction, &QAction::triggered, this, &MainWindow::exportNetworkJson);
+
     scene = new QGraphicsScene(this);
 
     currentNetworkSaved=0;
@@ -156,6 +214,335 @@ MainWindow::MainWindow(QWidget *parent)
     position=-1;
 }
 
+void MainWindow::loadCheckpoint()
+{
+    const QString path = QFileDialog::getOpenFileName(this, "加载权重检查点", QString(),
+                                                      "权重检查点 (*.npy *.npz *.safetensors);;所有文件 (*)");
+    if (path.isEmpty()) return;
+
+    QElapsedTimer timer;
+    timer.start();
+    auto checkpoint = std::make_shared<WeightCheckpoint>();
+    QString error;
+    if (!checkpoint->open(path, &error)) {
+        showWarningMessage(QString("无法打开检查点：%1").arg(error));
+        return;
+    }
+    const double openMs = timer.nsecsElapsed() / 1.0e6;
+    WeightCheckpoint::setActive(checkpoint);
+
+    QString matched;
+    if (auto* view = qobject_cast<NetworkVisualizer*>(ui->scrollAreavisualizer->widget())) {
+        QStringList report;
+        view->applyCheckpoint(checkpoint, &report);
+        for (const QString& line : report) qDebug() << line;
+        int bound = 0;
+        for (const QString& line : report) {
+            if (line.contains("←")) ++bound;
+        }
+        matched = QString("，匹配 %1 层").arg(bound);
+    }
+    showFloatingMessage(QString("✅ 已映射 %1 个张量（%2 MB），打开耗时 %3 ms%4")
+                            .arg(checkpoint->tensors().size())
+                            .arg(checkpoint->fileSize() / (1024.0 * 1024.0), 0, 'f', 1)
+                            .arg(openMs, 0, 'f', 2)
+                            .arg(matched));
+}
+
+void MainWindow::loadSamples()
+{
+    auto* view = qobject_cast<NetworkVisualizer*>(ui->scrollAreavisualizer->widget());
+    if (!view) {
+        showWarningMessage("请先生成网络图像");
+        return;
+    }
+    const QStringList paths = QFileDialog::getOpenFileNames(this, "加载样本输入", QString(),
+                                                            "样本输入 (*.csv *.txt *ubyte *.idx *.bin *.raw *.f32 *.png *.jpg *.jpeg *.bmp);;所有文件 (*)");
+    if (paths.isEmpty()) return;
+
+    QString error;
+    if (!view->loadSampleInputs(paths, &error)) {
+        showWarningMessage(QString("无法加载样本：%1").arg(error));
+        return;
+    }
+    showFloatingMessage("✅ 已加载样本，拖动左下角的滑块切换");
+}
+
+void MainWindow::loadProfilerTrace()
+{
+    auto* view = qobject_cast<NetworkVisualizer*>(ui->scrollAreavisualizer->widget());
+    if (!view) {
+        showWarningMessage("请先生成网络图像");
+        return;
+    }
+    const QString path = QFileDialog::getOpenFileName(this, "加载 PyTorch profiler 追踪", QString(),
+                                                      "Chrome 追踪 (*.json);;所有文件 (*)");
+    if (path.isEmpty()) return;
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    QElapsedTimer timer;
+    timer.start();
+    TraceProfile profile;
+    QString error;
+    const bool ok = loadChromeTrace(path, &profile, &error);
+    const double elapsedMs = timer.nsecsElapsed() / 1.0e6;
+    QApplication::restoreOverrideCursor();
+    if (!ok) {
+        showWarningMessage(QString("无法读取追踪：%1").arg(error));
+        return;
+    }
+
+    // 导入的模型在层 JSON 中带有模块路径，可与 record_function 标注按名称对上
+    QStringList names;
+    if (position >= 0 && position < historyCache.size()) {
+        for (const QJsonValue& val : historyCache[position]) names.append(val.toObject().value("name").toString());
+    }
+    QStringList report;
+    const int matched = view->showTraceProfile(profile, names, &report);
+    for (const QString& line : report) qDebug() << line;
+    if (matched == 0) {
+        showWarningMessage(QString("追踪中的 %1 个作用域都没有对应的层").arg(profile.scopes.size()));
+        return;
+    }
+    showFloatingMessage(QString("✅ 已读取 %1 MB 追踪（%2 个事件），匹配 %3 层，用时 %4 ms")
+                            .arg(profile.fileBytes / (1024.0 * 1024.0), 0, 'f', 0)
+                            .arg(profile.events)
+                            .arg(matched)
+                            .arg(elapsedMs, 0, 'f', 0));
+}
+
+void MainWindow::importModelFolder()
+{
+    const QString directory = QFileDialog::getExistingDirectory(this, "选择 PyTorch 模型目录");
+    if (directory.isEmpty()) return;
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    static const ParseResultCache cache;  // 与 history.json 同放在工作目录
+    const BulkImportReport report = importModelDirectory(directory, &cache);
+    QApplication::restoreOverrideCursor();
+    qDebug() << report.summary();
+    for (const QString& error : report.errors) qDebug() << "无法读取" << error;
+    if (report.models() == 0) {
+        showWarningMessage(QString("目录中没有可解析的 PyTorch 模型（%1 个 .py 文件）").arg(report.files.size()));
+        return;
+    }
+
+    const QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm");
+    QJsonArray entries;
+    for (const ImportedFile& file : report.files) {
+        const QJsonArray layers = file.layers();
+        if (layers.isEmpty()) continue;
+        const QJsonObject graph = nonChainGraph(layers, file.result["graph"].toObject());
+        if (!graph.isEmpty()) historyGraph.insert(historyCache.size(), graph);
+        historyCache.push_back(layers);
+        historySaved.push_back(true);
+        historyLabel.push_back(QString("%1 | %2").arg(timestamp, file.path));
+
+        QJsonObject network{ { "layers", layers } };
+        if (!graph.isEmpty()) network["graph"] = graph;
+        QJsonObject entry;
+        entry["timestamp"] = timestamp;
+        entry["mode"] = currentMode;
+        entry["source"] = file.path;
+        entry["network"] = network;
+        entries.append(entry);
+    }
+
+    if (!appendHistoryFile(entries)) {
+        // 警告已显示；导入的模型仍留在本次的历史列表中，按未保存处理
+        for (int i = historySaved.size() - entries.size(); i < historySaved.size(); ++i) historySaved[i] = false;
+        return;
+    }
+
+    showFloatingMessage(QString("✅ 已导入 %1 个模型到历史记录：%2 个文件，%3 文件/秒，缓存命中 %4%")
+                            .arg(report.models())
+                            .arg(report.files.size())
+                            .arg(report.filesPerSecond(), 0, 'f', 0)
+                            .arg(report.hitRate() * 100.0, 0, 'f', 0));
+}
+
+void MainWindow::importOnnxModel()
+{
+    const QString path = QFileDialog::getOpenFileName(this, "选择 ONNX 模型", QString(), "ONNX 模型 (*.onnx)");
+    if (path.isEmpty()) return;
+
+    QElapsedTimer timer;
+    timer.start();
+    OnnxModel model;
+    QString error;
+    if (!model.open(path, &error)) {
+        showWarningMessage(QString("无法导入 ONNX 模型：%1").arg(error));
+        return;
+    }
+    const QJsonArray layers = model.layers();
+    const double elapsedMs = timer.nsecsElapsed() / 1.0e6;
+    for (const QString& warning : model.warnings()) qDebug() << "ONNX：" << warning;
+    if (layers.isEmpty()) {
+        showWarningMessage(QString("模型中没有可显示的层（%1 个节点）").arg(model.nodes().size()));
+        return;
+    }
+
+    const QString source = QFileInfo(path).fileName();
+    const QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm");
+    const QJsonObject graph = nonChainGraph(layers, model.graph());
+    if (!graph.isEmpty()) historyGraph.insert(historyCache.size(), graph);
+    historyCache.push_back(layers);
+    historySaved.push_back(true);
+    historyLabel.push_back(QString("%1 | %2").arg(timestamp, source));
+
+    QJsonObject network{ { "layers", layers } };
+    if (!graph.isEmpty()) network["graph"] = graph;
+    QJsonObject entry;
+    entry["timestamp"] = timestamp;
+    entry["mode"] = currentMode;
+    entry["source"] = source;
+    entry["network"] = network;
+    if (!appendHistoryFile(QJsonArray{entry})) {
+        historySaved.last() = false;
+        return;
+    }
+
+    showFloatingMessage(QString("✅ 已导入 %1：%2 个节点、%3 层，权重 %4 MB，用时 %5 ms")
+                            .arg(source)
+                            .arg(model.nodes().size())
+                            .arg(layers.size())
+                            .arg(model.initializerBytes() / (1024 * 1024))
+                            .arg(elapsedMs, 0, 'f', 0));
+}
+
+void MainWindow::importModelRepr()
+{
+    bool ok = false;
+    const QString text = QInputDialog::getMultiLineText(this, "粘贴 print(model) 输出", "模型结构：", QString(), &ok);
+    if (!ok || text.trimmed().isEmpty()) return;
+    if (!looksLikeModuleRepr(text)) {
+        showWarningMessage("内容不是 print(model) 的输出");
+        return;
+    }
+
+    const ModuleRepr repr = parseModuleRepr(text);
+    for (const QString& warning : repr.warnings) qDebug() << warning;
+    if (repr.layers.isEmpty()) {
+        showWarningMessage(repr.error.isEmpty() ? QString("模型中没有可显示的层") : repr.error);
+        return;
+    }
+
+    const QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm");
+    historyCache.push_back(repr.layers);
+    historySaved.push_back(false);
+    historyLabel.push_back(QString("%1 | %2").arg(timestamp, repr.rootType));
+    position = historyCache.size() - 1;
+
+    QList<NeuralLayer> layers;
+    for (const QJsonValue& val : repr.layers) layers.append(NeuralLayer::fromJsonObject(val.toObject()));
+    NetworkVisualizer* visualizer = new NetworkVisualizer(this);
+    visualizer->setMinimumSize(600, 400);
+    if (currentMode == "NeuronitemGenerate") {
+        visualizer->createNetwork(layers);
+    } else {
+        visualizer->createblockNetwork(layers);
+        visualizer->setModuleGroups(repr.groups);
+    }
+    ui->scrollAreavisualizer->setWidget(visualizer);
+
+    if (!repr.error.isEmpty()) {
+        showWarningMessage(QString("只导入了出错前的部分：%1").arg(repr.error));
+        return;
+    }
+    showFloatingMessage(QString("✅ 已导入 %1：%2 个模块、%3 层、%4 个分组")
+                            .arg(repr.rootType)
+                            .arg(repr.modules)
+                            .arg(repr.layers.size())
+                            .arg(repr.groups.size()));
+}
+
+void MainWindow::watchModelFile()
+{
+    const QString path = QFileDialog::getOpenFileName(this, "监视模型文件", QString(),
+                                                      "模型文件 (*.py *.json *.onnx *.txt);;所有文件 (*)");
+    if (path.isEmpty()) return;
+
+    if (!modelWatcher) {
+        modelWatcher = new ModelFileWatcher(this);
+        connect(modelWatcher, &ModelFileWatcher::updated, this, &MainWindow::applyWatchUpdate);
+        connect(modelWatcher, &ModelFileWatcher::parseFailed, this, [=](const QString& error) {
+            showWarningMessage(QString("解析失败，图像保持上一次的结构：%1").arg(error));
+        });
+    }
+    watchRecord = -1;
+    QString error;
+    if (!modelWatcher->watch(path, &error)) showWarningMessage(error);
+}
+
+void MainWindow::exportNetworkJson()
+{
+    if (position < 0 || position >= historyCache.size()) {
+        showWarningMessage("请先生成或加载一个网络");
+        return;
+    }
+    const QString path = QFileDialog::getSaveFileName(this, "导出网络结构", "network.json", "网络结构 (*.json)");
+    if (path.isEmpty()) return;
+
+    QList<NeuralLayer> layers;
+    for (const QJsonValue& val : historyCache[position]) {
+        if (val.isObject()) layers.append(NeuralLayer::fromJsonObject(val.toObject()));
+    }
+    // 与 history.json 相同，先写临时文件再改名
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || !writeNetworkStructure(&file, layers) || !file.commit()) {
+        showWarningMessage(QString("无法写入 %1：%2").arg(path, file.errorString()));
+        return;
+    }
+    showFloatingMessage(QString("✅ 已导出 %1 层到 %2").arg(layers.size()).arg(QFileInfo(path).fileName()));
+}
+
+void MainWindow::applyWatchUpdate(const ModelUpdate& update)
+{
+    for (const QString& warning : update.warnings) qDebug() << warning;
+
+    // 监视期间只占一条未保存的历史记录，每次变化原地更新
+    if (watchRecord < 0 || watchRecord >= historyCache.size()) {
+        const QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm");
+        historyCache.push_back(update.layers);
+        historySaved.push_back(false);
+        historyLabel.push_back(QString("%1 | %2（监视）").arg(timestamp, QFileInfo(modelWatcher->path()).fileName()));
+        watchRecord = historyCache.size() - 1;
+    } else {
+        historyCache[watchRecord] = update.layers;
+        historySaved[watchRecord] = false;
+    }
+    if (update.graph.isEmpty()) historyGraph.remove(watchRecord);
+    else historyGraph.insert(watchRecord, update.graph);
+
+    QElapsedTimer timer;
+    timer.start();
+    auto* current = qobject_cast<NetworkVisualizer*>(ui->scrollAreavisualizer->widget());
+    if (update.initial || !watchView || current != watchView) {
+        if (!update.initial && watchView != current) return;  // 用户已切到别的图
+        position = watchRecord;
+        NetworkVisualizer* view = new NetworkVisualizer(this);
+        view->setMinimumSize(600, 400);
+        if (currentMode == "NeuronitemGenerate") view->createNetwork(update.neuralLayers);
+        else view->createblockNetwork(update.neuralLayers, update.edges);
+        ui->scrollAreavisualizer->setWidget(view);
+        watchView = view;
+        showFloatingMessage(QString("👁 正在监视 %1：%2 层，保存后自动更新")
+                                .arg(QFileInfo(modelWatcher->path()).fileName())
+                                .arg(update.layers.size()));
+        return;
+    }
+
+    watchView->patchBlockNetwork(update.neuralLayers, update.diff, update.edges);
+    const double patchMs = timer.nsecsElapsed() / 1.0e6;
+    qDebug() << QString("监视更新：%1；解析 %2 ms，比较 %3 ms，改图 %4 ms，保存到显示共 %5 ms")
+                    .arg(update.diff.summary())
+                    .arg(update.parseMs, 0, 'f', 1)
+                    .arg(update.diffMs, 0, 'f', 1)
+                    .arg(patchMs, 0, 'f', 1)
+                    .arg(update.latencyMs + patchMs, 0, 'f', 1);
+    showFloatingMessage(QString("✅ %1（%2 ms）").arg(update.diff.summary()).arg(update.latencyMs + patchMs, 0, 'f', 0));
+}
+
 void MainWindow::on_userGuide_clicked()
 {
     this->hide();
@@ -285,7 +672,7 @@ void MainWindow::on_checkHistory_clicked()
         ColorThemeManager::setCurrentTheme(theme);
 
         if (currentMode == "BlockGenerate") {
-            visualizer->createblockNetwork(parsedLayers);
+            visualizer->createblockNetwork(parsedLayers, historyEdges(index));
         } else if (currentMode == "NeuronitemGenerate") {
             visualizer->createNetwork(parsedLayers);
         } else {
@@ -322,7 +709,7 @@ void MainWindow::onHistoryRecordClicked(int index){
     ColorThemeManager::setCurrentTheme(theme);
 
     if (currentMode == "BlockGenerate") {
-        visualizer->createblockNetwork(layers);
+        visualizer->createblockNetwork(layers, historyEdges(index));
         ui->scrollAreavisualizer->setWidget(visualizer);
     } else if (currentMode == "NeuronitemGenerate") {
         visualizer->createNetwork(layers);
@@ -415,7 +802,7 @@ void MainWindow::on_lastStep_clicked(){
     ColorThemeManager::setCurrentTheme(theme);
 
     if (currentMode == "BlockGenerate") {
-        visualizer->createblockNetwork(layers);
+        visualizer->createblockNetwork(layers, historyEdges(position));
         ui->scrollAreavisualizer->setWidget(visualizer);
     } else if (currentMode == "NeuronitemGenerate") {
         visualizer->createNetwork(layers);
@@ -445,7 +832,7 @@ void MainWindow::on_nextStep_clicked(){
     QString theme = ColorThemeManager::getCurrentTheme();
     ColorThemeManager::setCurrentTheme(theme);
     if (currentMode == "BlockGenerate") {
-        visualizer->createblockNetwork(layers);
+        visualizer->createblockNetwork(layers, historyEdges(position));
         ui->scrollAreavisualizer->setWidget(visualizer);
     } else if (currentMode == "NeuronitemGenerate") {
         visualizer->createNetwork(layers);
@@ -477,46 +864,66 @@ void MainWindow::on_saveCurrent_clicked(){
         historyLabel.push_back(label);
         position = historyCache.size() - 1;
     }
-    *(historySaved.rbegin())=true;
-
-    showSaveProgressBarMessage();
-
     QJsonArray layersArray = codeWin->getNetworkAsJson();
     QJsonObject entry;
     entry["timestamp"] = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm");
     entry["mode"] = currentMode;
     entry["network"] = QJsonObject{ { "layers", layersArray } };
 
-    QFile file("history.json");
-    QJsonArray history;
+    // 写入失败时已显示警告，网络仍按未保存处理
+    if (!appendHistoryFile(QJsonArray{entry})) return;
 
-    if (file.open(QIODevice::ReadOnly)) {
-        QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-        if (doc.isArray()) history = doc.array();
-        file.close();
-    }
+    *(historySaved.rbegin())=true;
+    showSaveProgressBarMessage();
+    currentNetworkSaved=1;
+}
 
-    history.append(entry);
-    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-        QJsonDocument newDoc(history);
-        file.write(newDoc.toJson());
-        file.close();
-    }
+QVector<LayerEdge> MainWindow::historyEdges(int index) const
+{
+    const auto it = historyGraph.constFind(index);
+    if (it == historyGraph.constEnd() || index < 0 || index >= historyCache.size()) return QVector<LayerEdge>();
+    return layerEdges(historyCache[index], it.value());
+}
 
-    currentNetworkSaved=1;
+bool MainWindow::appendHistoryFile(const QJsonArray& entries)
+{
+    // 已有记录按条目边界分块并行读入；文件损坏时不覆盖，以免丢掉全部历史
+    QJsonArray history;
+    QString error;
+    HistoryLoadStats stats;
+    if (!loadHistoryFile("history.json", &history, &error, &stats)) {
+        showWarningMessage(QString("history.json 无法读取，新记录未写入：%1").arg(error));
+        return false;
+    }
+    if (stats.chunks > 1) {
+        qDebug() << QString("history.json：%1 MB、%2 条记录，%3 线程分 %4 块解析，用时 %5 ms")
+                        .arg(stats.bytes / 1048576.0, 0, 'f', 1)
+                        .arg(stats.entries)
+                        .arg(stats.threads)
+                        .arg(stats.chunks)
+                        .arg(stats.totalMs(), 0, 'f', 0);
+    }
+    for (const QJsonValue& entry : entries) history.append(entry);
+    // 先写临时文件再改名：写到一半失败（磁盘满等）时原有记录不受影响
+    QSaveFile file("history.json");
+    if (!file.open(QIODevice::WriteOnly) || file.write(QJsonDocument(history).toJson()) < 0 || !file.commit()) {
+        showWarningMessage(QString("无法写入 history.json，新记录未写入：%1").arg(file.errorString()));
+        return false;
+    }
+    return true;
 }
 
 void MainWindow::handleJsonData(const QString &jsonStr) {
-    QJsonDocument doc = QJsonDocument::fromJson(jsonStr.toUtf8());
-    if (doc.isObject()) {
-        QJsonObject obj = doc.object();
-        // 假设obj表示网络结构，从中提取层信息
-        QJsonArray layersArray = obj["layers"].toArray();
-        for (const QJsonValue &layerValue : layersArray) {
-            QJsonObject layerObj = layerValue.toObject();
-            NeuralLayer layer = NeuralLayer::fromJsonObject(layerObj);
-            // 后续可对layer进行操作
-        }
+    // 假设jsonStr表示网络结构，直接流式读出各层，不经过 QJsonDocument
+    QList<NeuralLayer> layers;
+    QString error;
+    if (!readNetworkStructure(jsonStr.toUtf8(), &layers, &error)) {
+        qDebug() << "handleJsonData:" << error;
+        return;
+    }
+    for (const NeuralLayer& layer : layers) {
+        // 后续可对layer进行操作
+        Q_UNUSED(layer);
     }
 }
 
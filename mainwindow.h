@@ -8,6 +8,9 @@
 #include "codegeneratorwindow.h"
 #include "networkvisualizer.h"
 #include "matrial.h"
+#include "modelwatcher.h"
+#include <QHash>
+#include <QPointer>
 #include <QVector>
 
 QT_BEGIN_NAMESPACE
@@ -45,6 +48,8 @@ public:
     QVector<QJsonArray> historyCache;
     QVector<bool> historySaved;
     QVector<QString> historyLabel;
+    QHash<int, QJsonObject> historyGraph;  // 导入模型的数据流图（见 nonChainGraph），按历史记录下标；没有时按层顺序连线
+    QVector<LayerEdge> historyEdges(int index) const;
     bool imageGenerate;
     int position;
 
@@ -59,6 +64,11 @@ private:
     QJsonArray m_cachedNetworkJson;
     CodeGeneratorWindow* codeWin = nullptr;
     NetworkVisualizer* visualizer = nullptr;
+    ModelFileWatcher* modelWatcher = nullptr;
+    QPointer<NetworkVisualizer> watchView;  // 监视模式显示的图；切换到别的图后只更新历史记录
+    int watchRecord = -1;                   // 监视的文件对应的历史记录
+    void applyWatchUpdate(const ModelUpdate& update);
+    bool appendHistoryFile(const QJsonArray& entries);  // 追加到工作目录下的 history.json
 
 private slots:
     void on_userGuide_clicked();
@@ -69,6 +79,14 @@ private slots:
     void on_lastStep_clicked();
     void on_nextStep_clicked();
     void on_saveCurrent_clicked();
+    void loadCheckpoint();
+    void loadSamples();
+    void loadProfilerTrace();
+    void importModelFolder();
+    void importOnnxModel();
+    void importModelRepr();
+    void watchModelFile();
+    void exportNetworkJson();
 
 };
 #endif // MAINWINDOW_H
@@ -0,0 +1,292 @@
+#include "modelwatcher.h"
+#include "json_utils.h"
+#include "onnxmodel.h"
+#include "programfragmentprocessor.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonObject>
+#include <QMetaObject>
+
+#include <algorithm>
+
+namespace {
+
+// 有模块路径时按路径对应，否则按层类型
+QString layerKey(const QJsonObject& layer)
+{
+    const QString name = layer.value("name").toString();
+    return name.isEmpty() ? "\x01" + layer.value("layerType").toString() : name;
+}
+
+} // namespace
+
+QString LayerDiff::summary() const
+{
+    QStringList parts;
+    if (inserted) parts << QString("新增 %1").arg(inserted);
+    if (removed) parts << QString("删除 %1").arg(removed);
+    if (updated) parts << QString("修改 %1").arg(updated);
+    if (moved) parts << QString("移动 %1").arg(moved);
+    return parts.isEmpty() ? QString("结构未变") : parts.join("，");
+}
+
+LayerDiff diffLayers(const QJsonArray& before, const QJsonArray& after)
+{
+    const int n = before.size();
+    const int m = after.size();
+    QVector<QJsonObject> oldLayers(n), newLayers(m);
+    QVector<QString> oldKeys(n), newKeys(m);
+    for (int i = 0; i < n; ++i) {
+        oldLayers[i] = before[i].toObject();
+        oldKeys[i] = layerKey(oldLayers[i]);
+    }
+    for (int i = 0; i < m; ++i) {
+        newLayers[i] = after[i].toObject();
+        newKeys[i] = layerKey(newLayers[i]);
+    }
+
+    LayerDiff diff;
+    diff.source.fill(-1, m);
+    diff.changed.fill(false, m);
+
+    // 首尾键相同的部分直接对应；一次保存通常只改动其中一小段
+    int prefix = 0;
+    while (prefix < n && prefix < m && oldKeys[prefix] == newKeys[prefix]) {
+        diff.source[prefix] = prefix;
+        ++prefix;
+    }
+    int suffix = 0;
+    while (suffix < n - prefix && suffix < m - prefix && oldKeys[n - 1 - suffix] == newKeys[m - 1 - suffix]) {
+        diff.source[m - 1 - suffix] = n - 1 - suffix;
+        ++suffix;
+    }
+
+    // 中间部分：同键的旧层按出现顺序排队，新层依次取用
+    QHash<QString, QVector<int>> queues;
+    for (int i = prefix; i < n - suffix; ++i) queues[oldKeys[i]].append(i);
+    QHash<QString, int> taken;
+    for (int i = prefix; i < m - suffix; ++i) {
+        const auto queue = queues.constFind(newKeys[i]);
+        if (queue == queues.constEnd()) continue;
+        int& k = taken[newKeys[i]];
+        if (k < queue.value().size()) diff.source[i] = queue.value()[k++];
+    }
+
+    QVector<bool> kept(n, false);
+    for (int i = 0; i < m; ++i) {
+        const int s = diff.source[i];
+        if (s < 0) {
+            ++diff.inserted;
+            continue;
+        }
+        kept[s] = true;
+        diff.changed[i] = oldLayers[s] != newLayers[i];
+        diff.updated += diff.changed[i];
+        diff.moved += s != i;
+    }
+    diff.removed = static_cast<int>(std::count(kept.begin(), kept.end(), false));
+    return diff;
+}
+
+ParsedModelFile parseModelFile(const QString& path, const QByteArray& previousHash)
+{
+    ParsedModelFile parsed;
+    const QString suffix = QFileInfo(path).suffix().toLower();
+
+    if (suffix == "onnx") {
+        // 只映射文件、扫描节点，大模型也不必整体读入；不计算哈希
+        OnnxModel model;
+        if (!model.open(path, &parsed.error)) return parsed;
+        parsed.layers = model.layers();
+        parsed.graph = nonChainGraph(parsed.layers, model.graph(), &parsed.edges);
+        parsed.warnings = model.warnings();
+        if (parsed.layers.isEmpty()) parsed.error = QString("模型中没有可显示的层（%1 个节点）").arg(model.nodes().size());
+        return parsed;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        parsed.error = QString("无法打开 %1：%2").arg(path, file.errorString());
+        return parsed;
+    }
+    const QByteArray content = file.readAll();
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(content);
+    parsed.hash = hash.result();
+    if (!previousHash.isEmpty() && parsed.hash == previousHash) return parsed;
+
+    if (suffix == "json") {
+        // 直接从字节读出各层，不建 QJsonDocument；layers 只保留 NeuralLayer 认得的字段，供比较与历史记录
+        QString error;
+        if (!readNetworkStructure(content, &parsed.neuralLayers, &error)) {
+            parsed.error = error;
+            return parsed;
+        }
+        for (const NeuralLayer& layer : parsed.neuralLayers) parsed.layers.append(layer.toJsonObject());
+        if (parsed.layers.isEmpty()) parsed.error = "JSON 中没有 layers 或其中没有层";
+        return parsed;
+    }
+
+    QJsonObject fragment;
+    fragment["language"] = "python";
+    fragment["action"] = "extract-structure";
+    fragment["code"] = QString::fromUtf8(content);
+    const QJsonObject result = ProgramFragmentProcessor::processFragment(fragment);
+    parsed.layers = result["networkStructure"].toArray();
+    parsed.graph = nonChainGraph(parsed.layers, result["graph"].toObject(), &parsed.edges);
+    for (const QJsonValue& warning : result["warnings"].toArray()) parsed.warnings << warning.toString();
+    if (!result["error"].toString().isEmpty()) parsed.error = result["error"].toString();
+    else if (parsed.layers.isEmpty()) parsed.error = "文件中没有可显示的层";
+    return parsed;
+}
+
+ModelFileWatcher::ModelFileWatcher(QObject* parent)
+    : QObject(parent)
+{
+    m_debounce.setSingleShot(true);
+    m_debounce.setInterval(15);
+    connect(&m_debounce, &QTimer::timeout, this, &ModelFileWatcher::request);
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, &ModelFileWatcher::onFileChanged);
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &ModelFileWatcher::onDirectoryChanged);
+    m_thread = std::thread(&ModelFileWatcher::workerLoop, this);
+}
+
+ModelFileWatcher::~ModelFileWatcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    ++m_generation;
+    m_wake.notify_one();
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+bool ModelFileWatcher::watch(const QString& path, QString* error)
+{
+    stop();
+    const QFileInfo info(path);
+    if (!info.isFile()) {
+        if (error) *error = QString("文件不存在：%1").arg(path);
+        return false;
+    }
+    m_path = info.absoluteFilePath();
+    m_watcher.addPath(m_path);
+    m_watcher.addPath(info.absolutePath());
+    m_sinceChange.start();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_reset = true;
+    }
+    request();
+    return true;
+}
+
+void ModelFileWatcher::stop()
+{
+    m_debounce.stop();
+    if (!m_watcher.files().isEmpty()) m_watcher.removePaths(m_watcher.files());
+    if (!m_watcher.directories().isEmpty()) m_watcher.removePaths(m_watcher.directories());
+    m_path.clear();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_requested = false;
+    ++m_generation;
+}
+
+void ModelFileWatcher::onFileChanged()
+{
+    if (m_path.isEmpty()) return;
+    if (!m_debounce.isActive()) m_sinceChange.start();
+    // 先删后写的保存方式会让文件从监视列表中掉出，存在时重新挂上
+    if (!m_watcher.files().contains(m_path) && QFileInfo::exists(m_path)) m_watcher.addPath(m_path);
+    m_debounce.start();
+}
+
+void ModelFileWatcher::onDirectoryChanged()
+{
+    if (m_path.isEmpty() || m_watcher.files().contains(m_path) || !QFileInfo::exists(m_path)) return;
+    onFileChanged();
+}
+
+void ModelFileWatcher::request()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_requestedPath = m_path;
+        m_requested = true;
+        ++m_generation;
+    }
+    m_wake.notify_one();
+}
+
+void ModelFileWatcher::workerLoop()
+{
+    for (;;) {
+        QString path;
+        quint64 generation = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stop || m_requested; });
+            if (m_stop)
+                return;
+            path = m_requestedPath;
+            m_requested = false;
+            if (m_reset) {
+                m_currentPath.clear();
+                m_reset = false;
+            }
+            generation = m_generation.load();
+        }
+
+        const bool initial = path != m_currentPath;
+        QElapsedTimer timer;
+        timer.start();
+        const ParsedModelFile parsed = parseModelFile(path, initial ? QByteArray() : m_currentHash);
+        const double parseMs = timer.nsecsElapsed() / 1.0e6;
+        // 解析期间文件又变了：结果作废，等下一次请求
+        if (m_generation.load() != generation)
+            continue;
+        if (!parsed.error.isEmpty()) {
+            const QString error = parsed.error;
+            QMetaObject::invokeMethod(this, [this, generation, error]() {
+                if (m_generation.load() == generation) emit parseFailed(error);
+            }, Qt::QueuedConnection);
+            continue;
+        }
+        if (!initial && parsed.hash == m_currentHash && !parsed.hash.isEmpty())
+            continue;  // 内容没变（只是 touch 或重复保存）
+
+        ModelUpdate update;
+        update.initial = initial;
+        update.layers = parsed.layers;
+        update.graph = parsed.graph;
+        update.edges = parsed.edges;
+        update.warnings = parsed.warnings;
+        update.parseMs = parseMs;
+        timer.restart();
+        if (!initial) update.diff = diffLayers(m_current, parsed.layers);
+        update.diffMs = timer.nsecsElapsed() / 1.0e6;
+        m_currentPath = path;
+        const bool sameEdges = parsed.edges == m_currentEdges;
+        m_current = parsed.layers;
+        m_currentEdges = parsed.edges;
+        m_currentHash = parsed.hash;
+        if (!initial && update.diff.isEmpty() && sameEdges)
+            continue;  // 只改了注释、空行等不影响结构的内容
+
+        update.neuralLayers = parsed.neuralLayers;
+        if (update.neuralLayers.isEmpty()) {
+            for (const QJsonValue& val : parsed.layers) update.neuralLayers.append(NeuralLayer::fromJsonObject(val.toObject()));
+        }
+        // 已成为下一次比较的基准，即使其间文件又变了也要送达，界面上的图才与 m_current 一致
+        QMetaObject::invokeMethod(this, [this, update]() mutable {
+            if (m_path.isEmpty()) return;  // 已停止监视
+            update.latencyMs = m_sinceChange.nsecsElapsed() / 1.0e6;
+            emit updated(update);
+        }, Qt::QueuedConnection);
+    }
+}
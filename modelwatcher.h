@@ -0,0 +1,117 @@
+#ifndef MODELWATCHER_H
+#define MODELWATCHER_H
+
+#include "backend.h"
+#include "pytorchparser.h"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFileSystemWatcher>
+#include <QJsonArray>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// 同一模型前后两次解析结果中各层的对应关系。有 "name"（模块路径）的层按名称对应，否则按类型；
+// 先去掉首尾相同的部分，中间部分同名（同类型）的层按出现顺序依次配对，允许顺序改变
+struct LayerDiff
+{
+    QVector<int> source;    // 新的第 i 层来自旧的第 source[i] 层，-1 为新增
+    QVector<bool> changed;  // 来自旧层但参数不同（需要重画）
+    int inserted = 0;
+    int removed = 0;
+    int updated = 0;
+    int moved = 0;          // 下标改变的保留层
+
+    bool isEmpty() const { return inserted == 0 && removed == 0 && updated == 0 && moved == 0; }
+    QString summary() const;
+};
+
+LayerDiff diffLayers(const QJsonArray& before, const QJsonArray& after);
+
+// 按后缀读取模型文件：.onnx 用 OnnxModel，.json 为 {"layers": [...]}，其余按 Python 源码 / print(model) 输出
+struct ParsedModelFile
+{
+    QJsonArray layers;
+    QList<NeuralLayer> neuralLayers;  // .json 流式读出时直接得到；其余格式为空，由 layers 转换
+    QJsonObject graph;          // 数据流图（见 PyTorchModel::graph），只有分支、跳连等层列表之外的信息时才有
+    QVector<LayerEdge> edges;   // 由 graph 折叠出的层间连线，graph 为空时也为空
+    QStringList warnings;
+    QString error;
+    QByteArray hash;  // 文件内容的哈希，内容未变时跳过解析
+};
+
+ParsedModelFile parseModelFile(const QString& path, const QByteArray& previousHash = QByteArray());
+
+// 监视模式中一次重新解析的结果
+struct ModelUpdate
+{
+    QJsonArray layers;
+    QList<NeuralLayer> neuralLayers;  // 与 layers 一一对应，已在后台线程转换好
+    QJsonObject graph;                // 同 ParsedModelFile
+    QVector<LayerEdge> edges;
+    LayerDiff diff;
+    QStringList warnings;
+    bool initial = false;             // watch() 之后的第一次解析，没有可比较的旧结构
+    double parseMs = 0.0;
+    double diffMs = 0.0;
+    double latencyMs = 0.0;           // 从收到文件变化通知到结果回到界面线程
+};
+
+// 用 QFileSystemWatcher 监视一个模型文件，变化后在后台线程重新解析并与上一次的结构比较，
+// 结构确有变化时在界面线程发出 updated。编辑器保存时常先删除再改名写入，同时监视所在目录以便重新挂上
+class ModelFileWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ModelFileWatcher(QObject* parent = nullptr);
+    ~ModelFileWatcher() override;
+
+    // 开始监视并立即解析一次（结果同样经 updated 发出，initial 为 true）
+    bool watch(const QString& path, QString* error = nullptr);
+    void stop();
+    QString path() const { return m_path; }
+    // 合并编辑器一次保存产生的多个通知
+    void setDebounceInterval(int ms) { m_debounce.setInterval(ms); }
+
+signals:
+    void updated(const ModelUpdate& update);
+    void parseFailed(const QString& error);
+
+private:
+    void onFileChanged();
+    void onDirectoryChanged();
+    void request();
+    void workerLoop();
+
+    QString m_path;
+    QFileSystemWatcher m_watcher;
+    QTimer m_debounce;
+    QElapsedTimer m_sinceChange;  // 本轮第一次变化通知起计时
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    QString m_requestedPath;
+    bool m_requested = false;
+    bool m_reset = false;                  // watch() 之后的第一次解析不与旧结构比较
+    bool m_stop = false;
+    std::atomic<quint64> m_generation{0};  // 每次请求加一，过时的解析结果丢弃
+
+    // 只在后台线程访问
+    QJsonArray m_current;
+    QVector<LayerEdge> m_currentEdges;
+    QByteArray m_currentHash;
+    QString m_currentPath;
+};
+
+#endif // MODELWATCHER_H
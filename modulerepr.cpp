@@ -0,0 +1,426 @@
+#include "modulerepr.h"
+#include <QSet>
+
+namespace {
+
+constexpr int kMaxArgs = 16;
+// 展开重复模块后层、分组与模块的总数上限，防止手误的 "(0-99999999)" 或嵌套的重复耗尽内存
+constexpr qint64 kMaxExpanded = 1 << 20;
+constexpr int kMaxDepth = 256;
+
+// 单行参数列表中一个参数的区间；keyLength 为 0 表示位置参数
+struct ReprArg
+{
+    int key = 0;
+    int keyLength = 0;
+    int value = 0;
+    int valueLength = 0;
+};
+
+const char* const kActivations[][2] = {
+    {"ReLU", "relu"}, {"ReLU6", "relu"}, {"LeakyReLU", "leaky_relu"}, {"Sigmoid", "sigmoid"},
+    {"Tanh", "tanh"}, {"Softmax", "softmax"}, {"LogSoftmax", "softmax"}};
+
+inline bool isNameStart(ushort c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c >= 0x80;
+}
+
+inline bool isNameChar(ushort c) {
+    return isNameStart(c) || (c >= '0' && c <= '9') || c == '.';
+}
+
+// 模块 repr 的递归下降解析：位置 m_pos 直接在原文上移动，参数只记区间，用到时再取值
+class ReprParser
+{
+public:
+    ReprParser(const QString& text, ModuleRepr& out) : m_text(text.constData()), m_end(text.size()), m_out(out) {}
+
+    void run() {
+        while (m_pos < m_end && m_text[m_pos].isSpace()) ++m_pos;
+        if (m_pos >= m_end) {
+            m_out.error = "内容为空";
+            return;
+        }
+        module(QString(), 0);
+        for (QJsonObject& layer : m_layers) m_out.layers.append(layer);
+    }
+
+private:
+    ushort at(int i) const { return i < m_end ? m_text[i].unicode() : 0; }
+
+    void skipSpaces() {
+        while (m_pos < m_end && (at(m_pos) == ' ' || at(m_pos) == '\t' || at(m_pos) == '\r')) ++m_pos;
+    }
+
+    void skipLine() {
+        while (m_pos < m_end && at(m_pos) != '\n') ++m_pos;
+        if (m_pos < m_end) ++m_pos;
+    }
+
+    void fail(int position, const QString& message) {
+        if (!m_out.error.isEmpty()) return;
+        int line = 1;
+        for (int i = 0; i < position && i < m_end; ++i) line += at(i) == '\n';
+        m_out.error = QString("第 %1 行：%2").arg(line).arg(message);
+    }
+
+    bool module(const QString& path, int depth) {
+        const int start = m_pos;
+        while (m_pos < m_end && isNameChar(at(m_pos))) ++m_pos;
+        if (m_pos == start || !isNameStart(at(start)) || at(m_pos) != '(') {
+            fail(start, "应为 \"模块名(\"");
+            return false;
+        }
+        const QString type(m_text + start, m_pos - start);
+        const int open = m_pos++;
+        if (depth > kMaxDepth) {
+            fail(start, "模块嵌套过深");
+            return false;
+        }
+        if (depth == 0) m_out.rootType = type;
+        ++m_out.modules;
+        skipSpaces();
+        if (m_pos >= m_end || at(m_pos) == '\n') return container(type, path, depth, open);
+        return leaf(type, path, open);
+    }
+
+    // "Type(\n  (name): ...\n  extra_repr 行\n)"：子模块逐个递归，其余行是模块自身的参数说明，跳过
+    bool container(const QString& type, const QString& path, int depth, int open) {
+        const int group = depth > 0 ? m_out.groups.size() : -1;
+        const int modules = m_out.modules;
+        if (group >= 0) {
+            ModuleGroup g;
+            g.path = path;
+            g.type = type;
+            g.depth = depth;
+            g.first = m_layers.size();
+            m_out.groups.append(g);
+        }
+        skipLine();
+        for (;;) {
+            skipSpaces();
+            if (m_pos >= m_end) {
+                fail(open, QString("%1( 缺少右括号").arg(type));
+                return false;
+            }
+            const ushort c = at(m_pos);
+            if (c == '\n') {
+                ++m_pos;
+            } else if (c == ')') {
+                skipLine();
+                break;
+            } else if (c == '(') {
+                if (!child(path, depth)) return false;
+            } else {
+                skipLine();
+            }
+        }
+        if (group >= 0) {
+            // 只有参数行、没有子模块时不成组（这时它一定是 groups 的最后一项）
+            if (m_out.modules == modules) m_out.groups.removeLast();
+            else m_out.groups[group].count = m_layers.size() - m_out.groups[group].first;
+        }
+        return true;
+    }
+
+    // "(name): Type(...)" 或 PyTorch 2 折叠重复模块的 "(0-11): 12 x Type(...)"
+    bool child(const QString& parent, int depth) {
+        const int start = ++m_pos;
+        while (m_pos < m_end && at(m_pos) != ')' && at(m_pos) != '\n') ++m_pos;
+        if (at(m_pos) != ')' || at(m_pos + 1) != ':') {
+            fail(start - 1, "应为 \"(子模块名): 模块\"");
+            return false;
+        }
+        const QString key(m_text + start, m_pos - start);
+        m_pos += 2;
+        skipSpaces();
+
+        int first = 0;
+        qint64 repeat = 1;
+        QString name = key;
+        const int dash = key.indexOf('-');
+        if (dash > 0) {
+            bool firstOk = false, lastOk = false;
+            first = key.left(dash).toInt(&firstOk);
+            const int last = key.mid(dash + 1).toInt(&lastOk);
+            if (firstOk && lastOk && last >= first) {
+                name = QString::number(first);
+                repeat = qint64(last) - first + 1;
+            }
+        }
+        // 次数超过上限后不再累加，长串数字也不会溢出
+        int p = m_pos;
+        qint64 count = 0;
+        while (at(p) >= '0' && at(p) <= '9') {
+            if (count <= kMaxExpanded) count = count * 10 + (at(p) - '0');
+            ++p;
+        }
+        if (p > m_pos && at(p) == ' ' && at(p + 1) == 'x' && at(p + 2) == ' ') {
+            repeat = count;
+            m_pos = p + 3;
+        }
+        if (repeat > kMaxExpanded) {
+            fail(start - 1, QString("重复次数超过 %1").arg(kMaxExpanded));
+            return false;
+        }
+
+        const QString path = parent.isEmpty() ? name : parent + '.' + name;
+        const int layerBegin = m_layers.size(), groupBegin = m_out.groups.size(), modulesBegin = m_out.modules;
+        if (!module(path, depth + 1)) return false;
+        const int layerEnd = m_layers.size(), groupEnd = m_out.groups.size(), modules = m_out.modules - modulesBegin;
+        // 按展开后的累计总数（已有的层、分组与模块加上其余 repeat - 1 份）检查：嵌套的重复逐层相乘，
+        // 只看单个模块的大小挡不住；模块也计入，没有层的 "1000000 x Identity()" 同样受限
+        const qint64 block = layerEnd - layerBegin + groupEnd - groupBegin + modules;
+        const qint64 total = qint64(m_layers.size()) + m_out.groups.size() + m_out.modules;
+        if (repeat > 1 && total + (repeat - 1) * block > kMaxExpanded) {
+            fail(start - 1, QString("%1 个重复模块展开后过大").arg(repeat));
+            return false;
+        }
+        const QString parentPrefix = parent.isEmpty() ? QString() : parent + '.';
+        for (int k = 1; k < int(repeat); ++k) {
+            const QString copy = parentPrefix + QString::number(first + k);
+            for (int l = layerBegin; l < layerEnd; ++l) {
+                QJsonObject layer = m_layers[l];
+                layer["name"] = copy + layer["name"].toString().mid(path.size());
+                m_layers.append(layer);
+            }
+            for (int g = groupBegin; g < groupEnd; ++g) {
+                ModuleGroup group = m_out.groups[g];
+                group.path = copy + group.path.mid(path.size());
+                group.first += k * (layerEnd - layerBegin);
+                m_out.groups.append(group);
+            }
+            m_out.modules += modules;
+        }
+        return true;
+    }
+
+    // 单行的 "Type(args)"：按顶层逗号切分参数，括号与引号内的逗号不算
+    bool leaf(const QString& type, const QString& path, int open) {
+        m_argCount = 0;
+        int nesting = 0, begin = m_pos, equals = -1;
+        ushort quote = 0;
+        for (; m_pos < m_end; ++m_pos) {
+            const ushort c = at(m_pos);
+            if (quote) {
+                if (c == quote) quote = 0;
+            } else if (c == '\'' || c == '"') {
+                quote = c;
+            } else if (c == '\n') {
+                break;
+            } else if (c == '(' || c == '[' || c == '{') {
+                ++nesting;
+            } else if (c == ')' || c == ']' || c == '}') {
+                if (nesting == 0 && c == ')') {
+                    addArg(begin, equals, m_pos);
+                    skipLine();
+                    layer(type, path);
+                    return true;
+                }
+                --nesting;
+            } else if (c == ',' && nesting == 0) {
+                addArg(begin, equals, m_pos);
+                begin = m_pos + 1;
+                equals = -1;
+            } else if (c == '=' && nesting == 0 && equals < 0) {
+                equals = m_pos;
+            }
+        }
+        fail(open, QString("%1( 缺少右括号").arg(type));
+        return false;
+    }
+
+    void addArg(int begin, int equals, int end) {
+        auto trim = [&](int& from, int& to) {
+            while (from < to && m_text[from].isSpace()) ++from;
+            while (to > from && m_text[to - 1].isSpace()) --to;
+        };
+        if (m_argCount == kMaxArgs) return;
+        ReprArg arg;
+        int valueBegin = equals >= 0 ? equals + 1 : begin;
+        int valueEnd = end;
+        trim(valueBegin, valueEnd);
+        if (equals >= 0) {
+            int keyBegin = begin, keyEnd = equals;
+            trim(keyBegin, keyEnd);
+            arg.key = keyBegin;
+            arg.keyLength = keyEnd - keyBegin;
+        } else if (valueBegin == valueEnd) {
+            return;
+        }
+        arg.value = valueBegin;
+        arg.valueLength = valueEnd - valueBegin;
+        m_args[m_argCount++] = arg;
+    }
+
+    // 关键字参数优先，其次第 position 个位置参数
+    const ReprArg* argument(int position, const char* keyword) const {
+        const int keywordLength = static_cast<int>(qstrlen(keyword));
+        int positional = 0;
+        const ReprArg* byPosition = nullptr;
+        for (int i = 0; i < m_argCount; ++i) {
+            const ReprArg& arg = m_args[i];
+            if (arg.keyLength == 0) {
+                if (positional++ == position) byPosition = &arg;
+            } else if (arg.keyLength == keywordLength) {
+                bool same = true;
+                for (int k = 0; same && k < keywordLength; ++k) same = at(arg.key + k) == uchar(keyword[k]);
+                if (same) return &arg;
+            }
+        }
+        return byPosition;
+    }
+
+    // 整数参数；kernel_size=(3, 3) 这类元组取第一个元素
+    int intArg(int position, const char* keyword, int fallback) const {
+        const ReprArg* arg = argument(position, keyword);
+        if (!arg) return fallback;
+        int p = arg->value;
+        const int end = arg->value + arg->valueLength;
+        while (p < end && (at(p) == '(' || at(p) == '[' || at(p) == ' ')) ++p;
+        const bool negative = p < end && at(p) == '-';
+        if (negative) ++p;
+        if (p >= end || at(p) < '0' || at(p) > '9') return fallback;
+        int value = 0;
+        while (p < end && at(p) >= '0' && at(p) <= '9') value = value * 10 + (at(p++) - '0');
+        return negative ? -value : value;
+    }
+
+    double doubleArg(int position, const char* keyword, double fallback) const {
+        const ReprArg* arg = argument(position, keyword);
+        if (!arg) return fallback;
+        bool ok = false;
+        const double value = QString::fromRawData(m_text + arg->value, arg->valueLength).toDouble(&ok);
+        return ok ? value : fallback;
+    }
+
+    QString textArg(int position, const char* keyword) const {
+        const ReprArg* arg = argument(position, keyword);
+        if (!arg) return QString();
+        QString text(m_text + arg->value, arg->valueLength);
+        if (text.size() >= 2 && (text[0] == '\'' || text[0] == '"')) text = text.mid(1, text.size() - 2);
+        return text;
+    }
+
+    // 与 PyTorch 源码导入（makeLeafModule）相同的映射；repr 中各模块都按 extra_repr 的格式打印参数
+    void layer(const QString& type, const QString& path) {
+        auto make = [&](const char* layerType, int neurons) {
+            QJsonObject object;
+            object["layerType"] = QString::fromLatin1(layerType);
+            object["neurons"] = neurons;
+            object["activationFunction"] = QString();
+            object["name"] = path.isEmpty() ? type : path;
+            return object;
+        };
+
+        if (type == "Linear" || type == "LazyLinear") {
+            QJsonObject object = make("Dense", intArg(1, "out_features", 0));
+            object["inputSize"] = intArg(0, "in_features", 0);
+            m_layers.append(object);
+        } else if (type == "Conv2d" || type == "LazyConv2d") {
+            const int filters = intArg(1, "out_channels", 0);
+            QJsonObject object = make("Conv2d", filters);
+            object["inputSize"] = intArg(0, "in_channels", 0);
+            object["filters"] = filters;
+            object["kernelSize"] = intArg(2, "kernel_size", 0);
+            m_layers.append(object);
+        } else if (type == "MaxPool2d" || type == "AvgPool2d") {
+            QJsonObject object = make(type == "MaxPool2d" ? "MaxPooling" : "AvgPooling", 0);
+            object["poolingSize"] = intArg(0, "kernel_size", 2);
+            m_layers.append(object);
+        } else if (type == "LSTM" || type == "GRU" || type == "RNN") {
+            const int hidden = intArg(1, "hidden_size", 0);
+            QJsonObject object = make(type.toLatin1().constData(), hidden);
+            object["inputSize"] = intArg(0, "input_size", 0);
+            object["units"] = hidden;
+            // RNN 只在不是 tanh 时打印 nonlinearity=relu
+            if (type == "RNN") object["activationFunction"] = textArg(-1, "nonlinearity");
+            m_layers.append(object);
+        } else if (type == "Dropout" || type == "Dropout1d" || type == "Dropout2d" || type == "AlphaDropout") {
+            QJsonObject object = make("Dropout", 0);
+            object["dropoutRate"] = doubleArg(0, "p", 0.5);
+            m_layers.append(object);
+        } else if (type == "Flatten") {
+            m_layers.append(make("Flatten", 0));
+        } else {
+            for (const auto& activation : kActivations) {
+                if (type != QLatin1String(activation[0])) continue;
+                if (!m_layers.isEmpty() && m_layers.last()["activationFunction"].toString().isEmpty())
+                    m_layers.last()["activationFunction"] = QString::fromLatin1(activation[1]);
+                return;
+            }
+            if (type != "Identity" && !m_skipped.contains(type)) {
+                // 其余模块（BatchNorm2d、LayerNorm、Embedding ……）不生成层
+                m_skipped.insert(type);
+                m_out.warnings << QString("不支持的模块 %1 已跳过").arg(type);
+            }
+        }
+    }
+
+    const QChar* m_text;
+    const int m_end;
+    int m_pos = 0;
+    ModuleRepr& m_out;
+    QVector<QJsonObject> m_layers;
+    ReprArg m_args[kMaxArgs];
+    int m_argCount = 0;
+    QSet<QString> m_skipped;
+};
+
+} // namespace
+
+QJsonObject ModuleGroup::toJson() const {
+    QJsonObject object;
+    object["path"] = path;
+    object["type"] = type;
+    object["depth"] = depth;
+    object["first"] = first;
+    object["count"] = count;
+    return object;
+}
+
+ModuleGroup ModuleGroup::fromJson(const QJsonObject& object) {
+    ModuleGroup group;
+    group.path = object["path"].toString();
+    group.type = object["type"].toString();
+    group.depth = object["depth"].toInt(1);
+    group.first = object["first"].toInt();
+    group.count = object["count"].toInt();
+    return group;
+}
+
+QJsonArray ModuleRepr::groupsJson() const {
+    QJsonArray result;
+    for (const ModuleGroup& group : groups) result.append(group.toJson());
+    return result;
+}
+
+bool looksLikeModuleRepr(const QString& text) {
+    const QChar* data = text.constData();
+    const int size = text.size();
+    int i = 0;
+    while (i < size && data[i].isSpace()) ++i;
+    const int start = i;
+    if (i >= size || !isNameStart(data[i].unicode())) return false;
+    while (i < size && isNameChar(data[i].unicode())) ++i;
+    if (i >= size || data[i] != '(') return false;
+    const bool capitalized = data[start].isUpper();
+    ++i;
+    while (i < size && (data[i] == ' ' || data[i] == '\t' || data[i] == '\r')) ++i;
+    if (i < size && data[i] != '\n') {
+        // 单个模块：整段只有一行且以右括号结尾
+        const QString rest = text.mid(i).trimmed();
+        return capitalized && !rest.contains('\n') && rest.endsWith(')');
+    }
+    while (i < size && data[i].isSpace()) ++i;
+    if (i >= size || data[i] != '(') return false;
+    const int close = text.indexOf(')', i);
+    const int newline = text.indexOf('\n', i);
+    return close > i && (newline < 0 || close < newline) && close + 1 < size && data[close + 1] == ':';
+}
+
+ModuleRepr parseModuleRepr(const QString& text) {
+    ModuleRepr result;
+    ReprParser(text, result).run();
+    return result;
+}
@@ -0,0 +1,44 @@
+#ifndef MODULEREPR_H
+#define MODULEREPR_H
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// print(model) 中含子模块的一个模块（Sequential、Bottleneck……），对应块视图中可折叠的一组层
+struct ModuleGroup
+{
+    QString path;    // "layer1"、"layer1.0.downsample"……
+    QString type;
+    int depth = 1;   // 根模块的子模块为 1
+    int first = 0;   // 组内第一层在 ModuleRepr::layers 中的下标
+    int count = 0;   // 组内（含各级子组）的层数，可以为 0
+
+    QJsonObject toJson() const;
+    static ModuleGroup fromJson(const QJsonObject& object);
+};
+
+struct ModuleRepr
+{
+    QString rootType;
+    // 按打印顺序展开的层（NeuralLayer::fromJsonObject 可读，另带 "name" 路径），
+    // 映射规则与 PyTorch 源码导入相同；激活模块并入前一层
+    QJsonArray layers;
+    QVector<ModuleGroup> groups;  // 前序：父组在子组之前
+    int modules = 0;              // 展开 "(0-11): 12 x Block(...)" 之后的模块数
+    QStringList warnings;         // 跳过的模块类型
+    QString error;                // 格式错误，出错前已解析的部分仍然保留
+
+    QJsonArray groupsJson() const;
+};
+
+// 文本是否像 print(model) 的输出：首个非空行为 "Name(" 且下一行以 "(子模块名):" 开头，或整段只有 "Name(...)" 一行
+bool looksLikeModuleRepr(const QString& text);
+
+// 解析 print(model) / repr(module) 的输出。单遍扫描，不切分行也不生成词法单元；
+// "(0-47): 48 x Block(...)" 这种折叠的重复模块只解析一次，再按下标复制出其余各份
+ModuleRepr parseModuleRepr(const QString& text);
+
+#endif // MODULEREPR_H
@@ -7,16 +7,108 @@
 #include <QMouseEvent>
 #include <QDragEnterEvent>
 #include <QDropEvent>
+#include <QResizeEvent>
+#include <QContextMenuEvent>
+#include <QActionGroup>
+#include <QMenu>
+#include <QHBoxLayout>
 #include <QGraphicsRectItem>
+#include <QGraphicsPathItem>
+#include <QGraphicsSceneMouseEvent>
+#include <QGraphicsSimpleTextItem>
+#include <QPainterPath>
+#include <QHash>
+#include <QSet>
+#include <QSignalBlocker>
+#include <QStringList>
+#include <algorithm>
+#include <cmath>
+#include <functional>
 #include "colorthememanager.h"
+#include "latencypredictor.h"
 #include "movablelayergroup.h"
 
+namespace {
+
+// 超过这么多层时模块分组初始折叠
+constexpr int kCollapseGroupsAbove = 60;
+
+// 模块分组的组名，点击时折叠或展开
+class GroupToggleItem : public QGraphicsSimpleTextItem
+{
+public:
+    GroupToggleItem(const QString& text, std::function<void()> onClick)
+        : QGraphicsSimpleTextItem(text), m_onClick(std::move(onClick)) {
+        setCursor(Qt::PointingHandCursor);
+        setAcceptedMouseButtons(Qt::LeftButton);
+    }
+
+protected:
+    void mousePressEvent(QGraphicsSceneMouseEvent* event) override {
+        event->accept();
+        m_onClick();
+    }
+
+private:
+    std::function<void()> m_onClick;
+};
+
+} // namespace
+
 NetworkVisualizer::NetworkVisualizer(QWidget* parent)
     : QGraphicsView(parent), m_scene(new QGraphicsScene(this)) {
     setScene(m_scene);
     setRenderHint(QPainter::Antialiasing);
     setDragMode(QGraphicsView::RubberBandDrag);
     setAcceptDrops(true); // 启用拖拽功能
+
+    // 连线筛选滑块：0.1% ~ 100%，只在神经元视图显示
+    m_edgePanel = new QWidget(this);
+    m_edgePanel->setAutoFillBackground(true);
+    m_edgeSlider = new QSlider(Qt::Horizontal, m_edgePanel);
+    m_edgeSlider->setRange(1, 1000);
+    m_edgeSlider->setValue(1000);
+    m_edgeSlider->setFixedWidth(160);
+    m_edgeLabel = new QLabel(m_edgePanel);
+    QHBoxLayout* edgeLayout = new QHBoxLayout(m_edgePanel);
+    edgeLayout->setContentsMargins(6, 2, 6, 2);
+    edgeLayout->addWidget(new QLabel("|w| Top", m_edgePanel));
+    edgeLayout->addWidget(m_edgeSlider);
+    edgeLayout->addWidget(m_edgeLabel);
+    m_edgePanel->hide();
+    m_edgeTimer = new QTimer(this);
+    m_edgeTimer->setSingleShot(true);
+    m_edgeTimer->setInterval(16);
+    connect(m_edgeSlider, &QSlider::valueChanged, this, [this] {
+        if (!m_edgeTimer->isActive()) m_edgeTimer->start();
+    });
+    connect(m_edgeTimer, &QTimer::timeout, this, [this] { setEdgeFraction(m_edgeSlider->value() / 1000.0); });
+    updateEdgeLabel();
+
+    // 样本滑块：加载样本输入后显示在左下角
+    m_samplePanel = new QWidget(this);
+    m_samplePanel->setAutoFillBackground(true);
+    m_sampleSlider = new QSlider(Qt::Horizontal, m_samplePanel);
+    m_sampleSlider->setFixedWidth(200);
+    m_sampleLabel = new QLabel(m_samplePanel);
+    QHBoxLayout* sampleLayout = new QHBoxLayout(m_samplePanel);
+    sampleLayout->setContentsMargins(6, 2, 6, 2);
+    sampleLayout->addWidget(new QLabel("样本", m_samplePanel));
+    sampleLayout->addWidget(m_sampleSlider);
+    sampleLayout->addWidget(m_sampleLabel);
+    m_samplePanel->hide();
+    m_sampleTimer = new QTimer(this);
+    m_sampleTimer->setSingleShot(true);
+    m_sampleTimer->setInterval(16);
+    connect(m_sampleSlider, &QSlider::valueChanged, this, [this] {
+        if (!m_sampleTimer->isActive()) m_sampleTimer->start();
+    });
+    connect(m_sampleTimer, &QTimer::timeout, this, [this] { showSample(m_sampleSlider->value()); });
+
+    // 校准在后台线程完成，排队回到界面线程后补上等待中的延迟预测；只连接一次
+    connect(&LatencyPredictor::instance(), &LatencyPredictor::calibrated, this, [this] {
+        if (m_latencyPending && LatencyPredictor::instance().isReady()) showLatencyPrediction(m_displayedLayers);
+    }, Qt::QueuedConnection);
 }
 void NetworkVisualizer::updateConnections() {
     qDebug() << "Updating connections";
@@ -34,6 +126,23 @@ void NetworkVisualizer::updateConnections() {
 
         conn.line->setLine(QLineF(p1, p2));
     }
+    for (const DataflowArc& arc : m_dataflowArcs) layoutDataflowArc(arc);
+}
+
+void NetworkVisualizer::layoutDataflowArc(const DataflowArc& arc) {
+    // 从前一层块左下出发、绕到左侧，再进入后一层块左上；拖动层块时随之更新
+    const QRectF from = arc.fromGroup->sceneBoundingRect();
+    const QRectF to = arc.toGroup->sceneBoundingRect();
+    const QPointF p1(from.left(), from.bottom() - 15);
+    const QPointF p2(to.left(), to.top() + 15);
+    const double x = std::min(from.left(), to.left()) - 30 - 16 * arc.lane;
+    QPainterPath path(p1);
+    path.cubicTo(QPointF(x, p1.y()), QPointF(x, p2.y()), p2);
+    arc.path->setPath(path);
+    if (arc.label) {
+        const QRectF box = arc.label->boundingRect();
+        arc.label->setPos(path.pointAtPercent(0.5) - QPointF(box.width() + 2, box.height() / 2));
+    }
 }
 void NetworkVisualizer::createConnection(MovableLayerGroup* from, MovableLayerGroup* to) {
     QPointF p1 = from->sceneBoundingRect().center();
@@ -242,7 +351,21 @@ MovableLayerGroup* NetworkVisualizer::createDetailedLayer(
 }
 
 void NetworkVisualizer::createNetwork(const QList<NeuralLayer>& layers) {
+    clearActivations();  // 在 m_scene->clear() 之前，热度条与神经元还未删除
     m_scene->clear();
+    m_dataflowArcs.clear();
+    m_dataflow.clear();
+    m_heatItems.clear();
+    m_latencyPending = false;
+    m_checkpointItems.clear();
+    m_moduleGroups.clear();
+    m_groupCollapsed.clear();
+    m_groupItems.clear();
+    m_displayedLayers = layers;
+    m_layerGroups.clear();
+    m_connectionGrid.clear();
+    m_pairWeights.clear();
+    m_heatmapItems.clear();
     m_allNeurons.clear();
     QVector<QVector<NeuronItem*>> allNeurons;
 
@@ -280,24 +403,286 @@ void NetworkVisualizer::createNetwork(const QList<NeuralLayer>& layers) {
     }
 
     // 连接线
+    m_edgeSelections.clear();
     for (int i = 0; i < allNeurons.size() - 1; ++i) {
-        for (NeuronItem* from : allNeurons[i]) {
-            for (NeuronItem* to : allNeurons[i + 1]) {
+        const int fromCount = allNeurons[i].size();
+        QVector<ConnectionItem*> grid(fromCount * allNeurons[i + 1].size());
+        std::vector<float> magnitude(static_cast<std::size_t>(grid.size()));
+        std::vector<float> signedWeights(static_cast<std::size_t>(grid.size()));
+        for (int f = 0; f < fromCount; ++f) {
+            NeuronItem* from = allNeurons[i][f];
+            for (int t = 0; t < allNeurons[i + 1].size(); ++t) {
+                NeuronItem* to = allNeurons[i + 1][t];
                 double weight = QRandomGenerator::global()->bounded(1.0);
                 ConnectionItem* conn = new ConnectionItem(from->scenePos(), to->scenePos(), weight);
                 m_scene->addItem(conn);
+                grid[t * fromCount + f] = conn;
+                magnitude[t * fromCount + f] = static_cast<float>(weight);
+                // 随机权重的颜色按 0~1 从低到高，热力图里对应 -1~1
+                signedWeights[t * fromCount + f] = static_cast<float>(weight * 2.0 - 1.0);
 
                 from->addOutgoingConnection(conn);
                 to->addIncomingConnection(conn);
             }
         }
+        m_connectionGrid.append(grid);
+        m_pairWeights.append(std::move(signedWeights));
+        m_edgeSelections.append(TopKEdgeSelection());
+        resetEdgeSelection(i, std::move(magnitude));
+    }
+    if (m_heatmapView) setHeatmapView(true);
+    m_edgePanel->setVisible(!m_connectionGrid.isEmpty() && !m_heatmapView);
+    layoutEdgePanel();
+    updateEdgeLabel();
+
+    applyCheckpoint(WeightCheckpoint::active());
+}
+
+void NetworkVisualizer::setConnectionWeights(int layerPair, const float* weights, int outputs, int inputs) {
+    if (layerPair < 0 || layerPair >= m_connectionGrid.size() || !weights) return;
+    const QVector<ConnectionItem*>& grid = m_connectionGrid[layerPair];
+    if (grid.size() != outputs * inputs) return;
+    float maxAbs = 0.0f;
+    for (int i = 0; i < grid.size(); ++i) maxAbs = std::max(maxAbs, std::fabs(weights[i]));
+    std::vector<float> magnitude(static_cast<std::size_t>(grid.size()));
+    for (int i = 0; i < grid.size(); ++i) {
+        grid[i]->setSignedWeight(weights[i], maxAbs);
+        magnitude[i] = std::fabs(weights[i]);
+    }
+    m_pairWeights[layerPair].assign(weights, weights + grid.size());
+    updateHeatmap(layerPair);
+    resetEdgeSelection(layerPair, std::move(magnitude));
+}
+
+void NetworkVisualizer::setSparseConnectionWeights(int layerPair, const CsrMatrix& weights) {
+    if (layerPair < 0 || layerPair >= m_connectionGrid.size()) return;
+    const QVector<ConnectionItem*>& grid = m_connectionGrid[layerPair];
+    if (grid.size() != weights.rows * weights.cols) return;
+    float maxAbs = 0.0f;
+    for (float v : weights.values) maxAbs = std::max(maxAbs, std::fabs(v));
+    // 剪掉的连线幅值记为 -1，筛选时永不显示
+    std::vector<float> magnitude(static_cast<std::size_t>(grid.size()), -1.0f);
+    for (int r = 0; r < weights.rows; ++r) {
+        for (int k = weights.rowPtr[r]; k < weights.rowPtr[r + 1]; ++k) {
+            const int index = r * weights.cols + weights.colIndex[k];
+            grid[index]->setSignedWeight(weights.values[k], maxAbs);
+            magnitude[index] = std::fabs(weights.values[k]);
+        }
+    }
+    m_pairWeights[layerPair].resize(static_cast<std::size_t>(grid.size()));
+    weights.toDense(m_pairWeights[layerPair].data());
+    updateHeatmap(layerPair);
+    resetEdgeSelection(layerPair, std::move(magnitude));
+}
+
+void NetworkVisualizer::resetEdgeSelection(int layerPair, std::vector<float> magnitude) {
+    if (layerPair < 0 || layerPair >= m_edgeSelections.size()) return;
+    TopKEdgeSelection& selection = m_edgeSelections[layerPair];
+    selection.reset(std::move(magnitude));
+    selection.select(static_cast<qint64>(std::ceil(m_edgeFraction * selection.size())), nullptr, nullptr);
+    // 权重整体换了，逐条同步一次（可见性未变的条目 setVisible 不做任何事）；热力图视图下连线全部隐藏，退出时再同步
+    if (m_heatmapView) return;
+    const QVector<ConnectionItem*>& grid = m_connectionGrid[layerPair];
+    for (int i = 0; i < grid.size(); ++i) grid[i]->setVisible(selection.isVisible(i));
+}
+
+void NetworkVisualizer::applyEdgeFraction(int layerPair) {
+    TopKEdgeSelection& selection = m_edgeSelections[layerPair];
+    std::vector<int> hidden, shown;
+    selection.select(static_cast<qint64>(std::ceil(m_edgeFraction * selection.size())), &hidden, &shown);
+    if (m_heatmapView) return;
+    // 只切换进出前 k 的那部分连线
+    const QVector<ConnectionItem*>& grid = m_connectionGrid[layerPair];
+    for (int i : hidden) grid[i]->setVisible(false);
+    for (int i : shown) grid[i]->setVisible(true);
+}
+
+void NetworkVisualizer::setEdgeFraction(double fraction) {
+    m_edgeFraction = std::clamp(fraction, 0.0, 1.0);
+    for (int p = 0; p < m_edgeSelections.size() && p < m_connectionGrid.size(); ++p) applyEdgeFraction(p);
+    updateEdgeLabel();
+}
+
+void NetworkVisualizer::updateEdgeLabel() {
+    qint64 shown = 0, total = 0;
+    for (const TopKEdgeSelection& selection : m_edgeSelections) {
+        shown += selection.selected();
+        total += selection.size();
+    }
+    m_edgeLabel->setText(QString("%1%  %2 / %3").arg(m_edgeSlider->value() / 10.0, 0, 'f', 1).arg(shown).arg(total));
+    layoutEdgePanel();
+}
+
+void NetworkVisualizer::layoutEdgePanel() {
+    m_edgePanel->adjustSize();
+    const QRect area = viewport()->geometry();
+    m_edgePanel->move(area.right() - m_edgePanel->width() - 8, area.top() + 8);
+}
+
+void NetworkVisualizer::setHeatmapView(bool enabled) {
+    m_heatmapView = enabled;
+    for (WeightHeatmapItem* item : m_heatmapItems) delete item;
+    m_heatmapItems.clear();
+    for (int p = 0; p < m_connectionGrid.size(); ++p) {
+        const QVector<ConnectionItem*>& grid = m_connectionGrid[p];
+        const TopKEdgeSelection& selection = m_edgeSelections[p];
+        for (int i = 0; i < grid.size(); ++i) grid[i]->setVisible(!enabled && selection.isVisible(i));
+    }
+    m_edgePanel->setVisible(!m_connectionGrid.isEmpty() && !enabled);
+    if (!enabled) return;
+
+    // 热力图放在相邻两列神经元之间，纵向覆盖两列中较高的一列
+    for (int p = 0; p < m_connectionGrid.size() && p + 1 < m_allNeurons.size(); ++p) {
+        const QVector<NeuronItem*>& from = m_allNeurons[p];
+        const QVector<NeuronItem*>& to = m_allNeurons[p + 1];
+        if (from.isEmpty() || to.isEmpty()) {
+            m_heatmapItems.append(nullptr);
+            continue;
+        }
+        const qreal top = std::min(from.first()->scenePos().y(), to.first()->scenePos().y()) - 10;
+        const qreal bottom = std::max(from.last()->scenePos().y(), to.last()->scenePos().y()) + 10;
+        const qreal left = from.first()->scenePos().x() + 20;
+        const qreal right = to.first()->scenePos().x() - 20;
+        WeightHeatmapItem* item = new WeightHeatmapItem(QRectF(left, top, right - left, bottom - top));
+        m_scene->addItem(item);
+        m_heatmapItems.append(item);
+        updateHeatmap(p);
     }
+}
 
+void NetworkVisualizer::updateHeatmap(int layerPair) {
+    if (layerPair < 0 || layerPair >= m_heatmapItems.size() || !m_heatmapItems[layerPair]) return;
+    m_heatmapItems[layerPair]->setWeights(m_pairWeights[layerPair].data(), m_allNeurons[layerPair + 1].size(),
+                                          m_allNeurons[layerPair].size());
+}
+
+bool NetworkVisualizer::loadSampleInputs(const QStringList& paths, QString* error) {
+    if (m_displayedLayers.isEmpty()) {
+        if (error) *error = "请先生成网络图像";
+        return false;
+    }
+    auto recorder = std::make_unique<ActivationRecorder>();
+    if (!recorder->build(m_displayedLayers, m_checkpoint, 512, 32, error)) return false;
+    SampleInputs samples;
+    samples.shape = recorder->inputShape();
+    if (!::loadSampleInputs(paths, samples, error)) return false;
+
+    m_recorder = std::move(recorder);
+    m_samples = std::move(samples);
+    m_sampleIndex = -1;
+    m_sampleSlider->blockSignals(true);
+    m_sampleSlider->setRange(0, m_samples.count - 1);
+    m_sampleSlider->setValue(0);
+    m_sampleSlider->blockSignals(false);
+    m_samplePanel->show();
+    showSample(0);
+    return true;
 }
 
-void NetworkVisualizer::createblockNetwork(const QList<NeuralLayer>& layers) {
+void NetworkVisualizer::showSample(int index) {
+    if (!m_recorder || index < 0 || index >= m_samples.count) return;
+    const float* activations = m_recorder->activations(index);
+    if (!activations) {
+        // 没算过：沿拖动方向整批前向，接下来的若干个样本直接命中环形缓冲区
+        const int batch = m_recorder->batch();
+        const int first = index < m_sampleIndex ? std::max(0, index - batch + 1) : index;
+        const int count = std::min(batch, m_samples.count - first);
+        m_recorder->capture(m_samples.sample(first), first, count);
+        activations = m_recorder->activations(index);
+        if (!activations) return;
+    }
+    m_sampleIndex = index;
+
+    const HeatmapColormap colormap = HeatmapColormap::fromTheme(ColorThemeManager::currentTheme());
+    const int layers = m_recorder->layerCount();
+    m_activationStrips.resize(m_layerGroups.size());
+    m_stripImages.resize(m_layerGroups.size());
+    for (int i = 0; i < layers; ++i) {
+        const float* a = activations + m_recorder->layerOffset(i);
+        const int units = m_recorder->unitCount(i);
+        float peak = 0.0f;
+        for (int u = 0; u < units; ++u) {
+            if (std::isfinite(a[u])) peak = std::max(peak, a[u]);
+        }
+
+        // 神经元视图：每层按本层最大值归一化
+        if (i < m_allNeurons.size()) {
+            const QVector<NeuronItem*>& neurons = m_allNeurons[i];
+            for (int j = 0; j < neurons.size(); ++j) {
+                if (j < units && peak > 0.0f) {
+                    neurons[j]->setActivation(a[j] / peak, QString("平均 |激活| = %1（本层最大 %2）").arg(a[j], 0, 'g', 4).arg(peak, 0, 'g', 4));
+                } else {
+                    neurons[j]->setActivation(-1.0);
+                }
+            }
+        }
+
+        // 块视图：层块右侧 96×10 的热度条，每个单元一列，颜色从层背景过渡到高权重色
+        if (i < m_layerGroups.size()) {
+            renderWeightImage(a, 1, units, peak, colormap, m_stripImages[i]);
+            QGraphicsPixmapItem*& strip = m_activationStrips[i];
+            if (!strip) {
+                strip = new QGraphicsPixmapItem();
+                strip->setPos(174, 112);
+                strip->setZValue(3);
+                m_layerGroups[i]->addToGroup(strip);
+            }
+            strip->setPixmap(QPixmap::fromImage(m_stripImages[i]));
+            strip->setTransform(QTransform::fromScale(96.0 / units, 10.0));
+            strip->setToolTip(QString("%1：%2 个%3，平均 |激活| 最大 %4")
+                                  .arg(m_recorder->layerInfo(i).layerType)
+                                  .arg(units)
+                                  .arg(m_recorder->layerInfo(i).out.spatial ? "通道" : "神经元")
+                                  .arg(peak, 0, 'g', 4));
+        }
+    }
+    m_sampleLabel->setText(QString("%1 / %2  %3  %4 ms/样本")
+                               .arg(index + 1)
+                               .arg(m_samples.count)
+                               .arg(m_samples.names.value(index))
+                               .arg(m_recorder->lastSampleMs(), 0, 'f', 3));
+    layoutSamplePanel();
+}
+
+void NetworkVisualizer::clearActivations() {
+    m_recorder.reset();
+    m_samples = SampleInputs();
+    m_sampleIndex = -1;
+    m_samplePanel->hide();
+    for (const QVector<NeuronItem*>& layer : m_allNeurons) {
+        for (NeuronItem* neuron : layer) neuron->setActivation(-1.0);
+    }
+    for (QGraphicsPixmapItem* strip : m_activationStrips) delete strip;
+    m_activationStrips.clear();
+    m_stripImages.clear();
+}
+
+void NetworkVisualizer::layoutSamplePanel() {
+    m_samplePanel->adjustSize();
+    const QRect area = viewport()->geometry();
+    m_samplePanel->move(area.left() + 8, area.bottom() - m_samplePanel->height() - 8);
+}
+
+void NetworkVisualizer::createblockNetwork(const QList<NeuralLayer>& layers, const QVector<LayerEdge>& edges) {
+    clearActivations();
     m_scene->clear();
     m_layerGroups.clear();
+    m_connections.clear();
+    m_dataflowArcs.clear();
+    m_dataflow = edges;
+    m_moduleGroups.clear();
+    m_groupCollapsed.clear();
+    m_groupItems.clear();
+    m_heatItems.clear();
+    m_latencyPending = false;
+    m_checkpointItems.clear();
+    m_connectionGrid.clear();
+    m_pairWeights.clear();
+    m_heatmapItems.clear();
+    m_edgeSelections.clear();
+    m_edgePanel->hide();
+    m_allNeurons.clear();
+    m_displayedLayers = layers;
 
     const int layerSpacing = 150;
     //QList<QGraphicsItemGroup*> layerGroups;
@@ -313,8 +698,40 @@ void NetworkVisualizer::createblockNetwork(const QList<NeuralLayer>& layers) {
         m_layerGroups.append(group);
     }
 
-    // 连接线
+    // 有数据流时相邻两层只在直接相连、或其中一层不在数据流中（forward() 没有用到）时画直线，其余连线画成弧线
+    QSet<int> direct;  // 与下一层直接相连的层
+    QVector<bool> inFlow(layers.size(), false);
+    for (const LayerEdge& edge : edges) {
+        if (edge.from < 0 || edge.to < 0 || edge.from >= layers.size() || edge.to >= layers.size()) continue;
+        inFlow[edge.from] = inFlow[edge.to] = true;
+        if (edge.to == edge.from + 1 && edge.via.isEmpty()) direct.insert(edge.from);
+    }
+    const ColorTheme& theme = ColorThemeManager::currentTheme();
+    for (const LayerEdge& edge : edges) {
+        if (edge.from < 0 || edge.to < 0 || edge.from >= layers.size() || edge.to >= layers.size()) continue;
+        if (edge.to == edge.from + 1 && edge.via.isEmpty()) continue;
+        DataflowArc arc;
+        arc.fromGroup = layerGroups[edge.from];
+        arc.toGroup = layerGroups[edge.to];
+        arc.lane = std::min(std::abs(edge.to - edge.from), 8) - 1;
+        arc.path = m_scene->addPath(QPainterPath(), QPen(theme.text, 1.5, Qt::DashLine));
+        arc.path->setToolTip(QString("第 %1 层 %2 → 第 %3 层 %4%5")
+                                 .arg(edge.from + 1)
+                                 .arg(layers[edge.from].layerType)
+                                 .arg(edge.to + 1)
+                                 .arg(layers[edge.to].layerType)
+                                 .arg(edge.via.isEmpty() ? QString() : QString("（经 %1 合并）").arg(edge.via)));
+        arc.label = nullptr;
+        if (!edge.via.isEmpty()) {
+            arc.label = m_scene->addSimpleText(edge.via);
+            arc.label->setBrush(theme.text);
+        }
+        layoutDataflowArc(arc);
+        m_dataflowArcs.append(arc);
+    }
+
     for (int i = 0; i < layerGroups.size() - 1; ++i) {
+        if (!edges.isEmpty() && inFlow[i] && inFlow[i + 1] && !direct.contains(i)) continue;
         auto from = layerGroups[i];
         auto to = layerGroups[i + 1];
 
@@ -333,6 +750,627 @@ void NetworkVisualizer::createblockNetwork(const QList<NeuralLayer>& layers) {
         connect(to, &MovableLayerGroup::positionChanged,
                 this, &NetworkVisualizer::updateConnections);
     }
+
+    showLatencyPrediction(layers);
+    applyCheckpoint(WeightCheckpoint::active());
+}
+
+void NetworkVisualizer::patchBlockNetwork(const QList<NeuralLayer>& layers, const LayerDiff& diff,
+                                          const QVector<LayerEdge>& edges) {
+    if (m_layerGroups.isEmpty() && !m_allNeurons.isEmpty()) {
+        createNetwork(layers);
+        return;
+    }
+    if (!m_moduleGroups.isEmpty() || !m_dataflow.isEmpty() || !edges.isEmpty() ||
+        m_layerGroups.size() != m_displayedLayers.size() || diff.source.size() != layers.size()) {
+        createblockNetwork(layers, edges);
+        return;
+    }
+
+    // 挂在层块上的叠加项先摘掉：要删除的层块上也有，且延迟预测、检查点匹配都随结构变化
+    const std::shared_ptr<WeightCheckpoint> checkpoint = m_checkpoint;
+    clearActivations();
+    clearLayerHeat();
+    applyCheckpoint(nullptr);
+
+    const int layerSpacing = 150;
+    QVector<bool> kept(m_layerGroups.size(), false);
+    QList<MovableLayerGroup*> groups;
+    QSet<QGraphicsItemGroup*> moved;  // 位置变了或新建的层块，连线端点需要重算
+    for (int i = 0; i < layers.size(); ++i) {
+        const int s = diff.source[i];
+        if (s >= 0 && !diff.changed[i]) {
+            MovableLayerGroup* group = m_layerGroups[s];
+            kept[s] = true;
+            if (s != i) {
+                const QSignalBlocker blocker(group);  // 逐个移动时不必每次都刷新全部连线
+                group->moveBy(0, (i - s) * layerSpacing);
+                moved.insert(group);
+            }
+            groups.append(group);
+            continue;
+        }
+        // 修改的层在原位置重建；新增的层接在前一层下方
+        QPointF pos(100, 20);
+        if (s >= 0) pos = m_layerGroups[s]->pos() + QPointF(0, (i - s) * layerSpacing);
+        else if (i > 0) pos = groups[i - 1]->pos() + QPointF(0, layerSpacing);
+        MovableLayerGroup* group = createDetailedLayer(layers[i], pos.y());
+        {
+            const QSignalBlocker blocker(group);
+            group->setPos(pos);
+        }
+        groups.append(group);
+        moved.insert(group);
+    }
+
+    // 连线：前后相邻关系未变的保留，端点移动的只更新几何，其余删掉重画
+    QHash<QGraphicsItemGroup*, int> byFrom;
+    for (int c = 0; c < m_connections.size(); ++c) byFrom.insert(m_connections[c].fromGroup, c);
+    QVector<bool> reused(m_connections.size(), false);
+    QList<ConnectionLine> connections;
+    for (int i = 0; i + 1 < groups.size(); ++i) {
+        MovableLayerGroup* from = groups[i];
+        MovableLayerGroup* to = groups[i + 1];
+        const int c = byFrom.value(from, -1);
+        if (c >= 0 && m_connections[c].toGroup == to) {
+            reused[c] = true;
+            connections.append(m_connections[c]);
+            if (!moved.contains(from) && !moved.contains(to)) continue;
+            QPointF p1 = from->sceneBoundingRect().center();
+            p1.setY(from->sceneBoundingRect().bottom());
+            QPointF p2 = to->sceneBoundingRect().center();
+            p2.setY(to->sceneBoundingRect().top());
+            m_connections[c].line->setLine(QLineF(p1, p2));
+            continue;
+        }
+        QPointF p1 = from->sceneBoundingRect().center();
+        p1.setY(from->sceneBoundingRect().bottom());
+        QPointF p2 = to->sceneBoundingRect().center();
+        p2.setY(to->sceneBoundingRect().top());
+        connections.append({m_scene->addLine(QLineF(p1, p2), QPen(Qt::black)), from, to});
+    }
+    for (int c = 0; c < m_connections.size(); ++c) {
+        if (!reused[c]) delete m_connections[c].line;
+    }
+    m_connections = connections;
+
+    for (int s = 0; s < m_layerGroups.size(); ++s) {
+        if (!kept[s]) delete m_layerGroups[s];
+    }
+    m_layerGroups = groups;
+    m_displayedLayers = layers;
+    for (int i = 0; i < m_layerGroups.size(); ++i)
+        m_layerGroups[i]->setData(0, QVariant::fromValue(&m_displayedLayers[i]));
+
+    showLatencyPrediction(m_displayedLayers);
+    applyCheckpoint(checkpoint);
+}
+
+void NetworkVisualizer::setModuleGroups(const QVector<ModuleGroup>& groups) {
+    m_moduleGroups.clear();
+    for (const ModuleGroup& group : groups) {
+        if (group.count > 0 && group.first >= 0 && group.first + group.count <= m_layerGroups.size())
+            m_moduleGroups.append(group);
+    }
+    m_groupCollapsed.fill(m_layerGroups.size() > kCollapseGroupsAbove, m_moduleGroups.size());
+    layoutModuleGroups();
+}
+
+void NetworkVisualizer::layoutModuleGroups() {
+    for (QGraphicsItem* item : m_groupItems) delete item;
+    m_groupItems.clear();
+    for (const ConnectionLine& connection : m_connections) delete connection.line;
+    m_connections.clear();
+
+    // 每层被哪个最外层的折叠组收起；分组按前序排列，祖先先于子孙处理，被收起的组不再画括线
+    const int n = m_layerGroups.size();
+    QVector<int> hiddenBy(n, -1);
+    QVector<bool> shown(m_moduleGroups.size(), true);
+    for (int g = 0; g < m_moduleGroups.size(); ++g) {
+        const ModuleGroup& group = m_moduleGroups[g];
+        if (hiddenBy[group.first] >= 0) {
+            shown[g] = false;
+        } else if (m_groupCollapsed[g]) {
+            for (int i = group.first; i < group.first + group.count; ++i) hiddenBy[i] = g;
+        }
+    }
+
+    // 与 createblockNetwork 相同的纵向排列，折叠的组占一个块的位置
+    const ColorTheme& theme = ColorThemeManager::currentTheme();
+    const int layerSpacing = 150;
+    QVector<int> rowY(n, 0);
+    QList<QGraphicsItemGroup*> chain;
+    int y = 20;
+    for (int i = 0; i < n; y += layerSpacing) {
+        const int g = hiddenBy[i];
+        if (g < 0) {
+            m_layerGroups[i]->show();
+            m_layerGroups[i]->setPos(100, y);
+            chain.append(m_layerGroups[i]);
+            rowY[i++] = y;
+            continue;
+        }
+        const ModuleGroup& group = m_moduleGroups[g];
+        MovableLayerGroup* summary = new MovableLayerGroup();
+        connect(summary, &MovableLayerGroup::positionChanged, this, &NetworkVisualizer::updateConnections);
+        QGraphicsRectItem* bg = new QGraphicsRectItem(0, 0, 160, 130);
+        bg->setBrush(theme.activationBoxFill);
+        bg->setPen(QPen(theme.text, 1, Qt::DashLine));
+        summary->addToGroup(bg);
+        QGraphicsTextItem* title = new QGraphicsTextItem(QString("%1\n%2\n%3 层（已折叠）").arg(group.type, group.path).arg(group.count));
+        title->setDefaultTextColor(theme.text);
+        title->setTextWidth(150);
+        title->setPos(5, 20);
+        summary->addToGroup(title);
+        m_scene->addItem(summary);
+        summary->setPos(100, y);
+        m_groupItems.append(summary);
+        chain.append(summary);
+        for (; i < group.first + group.count; ++i) {
+            m_layerGroups[i]->hide();
+            rowY[i] = y;
+        }
+    }
+
+    for (int i = 0; i + 1 < chain.size(); ++i) {
+        QGraphicsItemGroup* from = chain[i];
+        QGraphicsItemGroup* to = chain[i + 1];
+        QPointF p1 = from->sceneBoundingRect().center();
+        p1.setY(from->sceneBoundingRect().bottom());
+        QPointF p2 = to->sceneBoundingRect().center();
+        p2.setY(to->sceneBoundingRect().top());
+        QGraphicsLineItem* line = m_scene->addLine(QLineF(p1, p2), QPen(Qt::black));
+        m_connections.append({line, from, to});
+    }
+
+    // 括线按深度向左缩进；组名在所有括线左侧右对齐，同一行开始的嵌套组按深度错开
+    int maxDepth = 1;
+    for (const ModuleGroup& group : m_moduleGroups) maxDepth = std::max(maxDepth, group.depth);
+    for (int g = 0; g < m_moduleGroups.size(); ++g) {
+        if (!shown[g]) continue;
+        const ModuleGroup& group = m_moduleGroups[g];
+        const double top = rowY[group.first];
+        const double bottom = rowY[group.first + group.count - 1] + 130;
+        const double x = 92 - 10 * group.depth;
+        QPainterPath path(QPointF(x + 6, top));
+        path.lineTo(x, top);
+        path.lineTo(x, bottom);
+        path.lineTo(x + 6, bottom);
+        QGraphicsPathItem* bracket = new QGraphicsPathItem(path);
+        bracket->setPen(QPen(theme.text, 1.5));
+        m_scene->addItem(bracket);
+        m_groupItems.append(bracket);
+
+        const bool collapsed = m_groupCollapsed[g];
+        GroupToggleItem* label = new GroupToggleItem(
+            QString("%1 %2 · %3").arg(QString(collapsed ? "▸" : "▾"), group.path.section('.', -1), group.type), [this, g]() {
+                // 重新布局会删除组名本身，留到事件处理结束后再做
+                QTimer::singleShot(0, this, [this, g]() {
+                    if (g >= m_groupCollapsed.size()) return;
+                    m_groupCollapsed[g] = !m_groupCollapsed[g];
+                    layoutModuleGroups();
+                });
+            });
+        label->setBrush(theme.text);
+        label->setToolTip(QString("%1（%2）：%3 层，点击%4").arg(group.path, group.type).arg(group.count).arg(collapsed ? "展开" : "折叠"));
+        label->setPos(82 - 10 * maxDepth - label->boundingRect().width(), top + 18 * (group.depth - 1));
+        m_scene->addItem(label);
+        m_groupItems.append(label);
+    }
+}
+
+void NetworkVisualizer::applyCheckpoint(const std::shared_ptr<WeightCheckpoint>& checkpoint, QStringList* report) {
+    for (QGraphicsItem* item : m_checkpointItems) delete item;
+    m_checkpointItems.clear();
+    m_sparklines.fill(nullptr, m_layerGroups.size());
+    m_bindings.clear();
+    m_pairLoaded.fill(false, m_connectionGrid.size());
+    m_checkpoint = checkpoint;
+    // 已加载样本时换用新权重重新前向当前样本
+    if (m_recorder) {
+        if (m_recorder->build(m_displayedLayers, m_checkpoint)) {
+            const int index = m_sampleIndex;
+            m_sampleIndex = -1;
+            showSample(index);
+        } else {
+            clearActivations();
+        }
+    }
+    // 剪枝预览隐藏的连线在换用或卸载检查点时先全部恢复为候选
+    if (m_prunePreview) {
+        for (int p = 0; p < m_edgeSelections.size(); ++p) {
+            std::vector<float> magnitude = m_edgeSelections[p].magnitude();
+            for (float& v : magnitude) v = std::max(v, 0.0f);
+            resetEdgeSelection(p, std::move(magnitude));
+        }
+    }
+    if (!m_checkpoint || !m_checkpoint->isOpen() || m_displayedLayers.isEmpty()) return;
+
+    // 只解析名称与形状，不读数据
+    m_bindings = bindCheckpoint(*m_checkpoint, m_displayedLayers, report);
+
+    const ColorTheme& theme = ColorThemeManager::currentTheme();
+    const QVector<CheckpointTensor>& tensors = m_checkpoint->tensors();
+    for (int i = 0; i < m_layerGroups.size() && i < m_bindings.size(); ++i) {
+        const LayerWeightBinding& binding = m_bindings[i];
+        if (binding.weight < 0) continue;
+        const CheckpointTensor& tensor = tensors[binding.weight];
+        QString text = QString("%1 %2 %3").arg(tensor.name, tensor.shapeString(), tensor.dtypeName);
+        QString tip = QString("%1：%2\n形状 %3，类型 %4，%5 个参数\n%6")
+                          .arg(binding.byName ? "按名称匹配" : "按顺序匹配", tensor.name, tensor.shapeString(), tensor.dtypeName)
+                          .arg(tensor.elementCount())
+                          .arg(m_checkpoint->path());
+        if (binding.bias >= 0) tip += QString("\n偏置 %1").arg(tensors[binding.bias].name);
+        if (binding.recurrentWeight >= 0) tip += QString("\n循环权重 %1").arg(tensors[binding.recurrentWeight].name);
+
+        QGraphicsTextItem* label = new QGraphicsTextItem(text);
+        QFont font = label->font();
+        font.setPointSizeF(font.pointSizeF() * 0.8);
+        label->setFont(font);
+        label->setDefaultTextColor(theme.text);
+        label->setToolTip(tip);
+        label->setPos(0, 128);
+        m_layerGroups[i]->addToGroup(label);
+        m_checkpointItems.append(label);
+    }
+
+    // 权重统计在后台线程计算（按检查点版本缓存），算完后逐层画出
+    QVector<int> statTensors;
+    for (int i = 0; i < m_layerGroups.size() && i < m_bindings.size(); ++i) {
+        if (m_bindings[i].weight >= 0) statTensors.append(m_bindings[i].weight);
+    }
+    const quint64 generation = m_checkpoint->generation();
+    requestCheckpointStats(m_checkpoint, statTensors, this, [this, generation](int tensor, const WeightStats& stats) {
+        if (m_checkpoint && m_checkpoint->generation() == generation) showWeightSparkline(tensor, stats);
+    });
+
+    refreshVisibleWeights();
+}
+
+void NetworkVisualizer::showWeightSparkline(int tensor, const WeightStats& stats) {
+    const int count = std::min({static_cast<int>(m_layerGroups.size()), static_cast<int>(m_bindings.size()),
+                                static_cast<int>(m_sparklines.size())});
+    int layer = -1;
+    for (int i = 0; i < count; ++i) {
+        if (m_bindings[i].weight == tensor) layer = i;
+    }
+    if (layer < 0 || m_sparklines[layer]) return;
+    const qint64 peak = *std::max_element(stats.histogram.begin(), stats.histogram.end());
+    if (peak <= 0) return;
+
+    // 放在热度标签下方：96×28，纵轴取平方根
+    const QRectF area(174, 80, 96, 28);
+    QPainterPath path(QPointF(area.left(), area.bottom()));
+    for (int b = 0; b < WeightStats::kBins; ++b) {
+        const double x = area.left() + area.width() * (b + 0.5) / WeightStats::kBins;
+        path.lineTo(x, area.bottom() - std::sqrt(double(stats.histogram[b]) / double(peak)) * area.height());
+    }
+    path.lineTo(area.right(), area.bottom());
+    path.closeSubpath();
+
+    const ColorTheme& theme = ColorThemeManager::currentTheme();
+    QGraphicsPathItem* sparkline = new QGraphicsPathItem(path);
+    QColor fill = theme.connectionHighWeight;
+    fill.setAlpha(90);
+    sparkline->setBrush(fill);
+    sparkline->setPen(QPen(theme.connectionHighWeight, 1));
+    sparkline->setZValue(3);
+    sparkline->setToolTip(m_checkpoint->tensors()[tensor].name + "\n" + stats.summary());
+    if (stats.min < 0.0f && stats.max > 0.0f) {
+        const double x = area.left() + area.width() * (-stats.min) / (double(stats.max) - stats.min);
+        QGraphicsLineItem* zero = new QGraphicsLineItem(x, area.top(), x, area.bottom(), sparkline);
+        zero->setPen(QPen(theme.text, 1, Qt::DotLine));
+    }
+    m_layerGroups[layer]->addToGroup(sparkline);
+    m_checkpointItems.append(sparkline);
+    m_sparklines[layer] = sparkline;
+}
+
+void NetworkVisualizer::refreshVisibleWeights() {
+    if (!m_checkpoint || m_bindings.isEmpty() || m_connectionGrid.isEmpty()) return;
+    const QRectF visible = mapToScene(viewport()->rect()).boundingRect();
+    for (int p = 0; p < m_connectionGrid.size() && p < m_pairLoaded.size(); ++p) {
+        if (m_pairLoaded[p]) continue;
+        const int layer = p + 1;
+        if (layer >= m_bindings.size() || layer >= m_allNeurons.size() || !m_displayedLayers[layer].isDense()
+            || m_bindings[layer].weight < 0 || m_allNeurons[p].isEmpty() || m_allNeurons[layer].isEmpty()) {
+            m_pairLoaded[p] = true;  // 没有可用权重，保持原样
+            continue;
+        }
+        const qreal left = m_allNeurons[p].first()->scenePos().x();
+        const qreal right = m_allNeurons[layer].first()->scenePos().x();
+        if (right < visible.left() || left > visible.right()) continue;
+
+        // 数据页此时才由映射调入
+        std::vector<float> weights;
+        QString error;
+        const LayerWeightBinding& binding = m_bindings[layer];
+        if (readDenseWeights(*m_checkpoint, binding, weights, &error)) {
+            const qint64 count = static_cast<qint64>(weights.size());
+            if (m_prunePreview && m_pruneConfig.method == PruneMethod::NM) {
+                pruneNM(weights.data(), binding.outputs, binding.inputs, m_pruneConfig.n, m_pruneConfig.m);
+            } else if (m_prunePreview) {
+                const float threshold = m_pruneConfig.method == PruneMethod::Global
+                                            ? m_globalPruneThreshold
+                                            : magnitudeThreshold(weights.data(), count, m_pruneConfig.sparsity);
+                pruneBelow(weights.data(), count, threshold);
+            }
+            if (m_quantPreview) {
+                fakeQuantize(weights.data(), binding.outputs, binding.inputs, m_quantConfig, weights.data());
+            }
+            if (m_prunePreview) {
+                setSparseConnectionWeights(p, toCsr(weights.data(), binding.outputs, binding.inputs));
+            } else {
+                setConnectionWeights(p, weights.data(), binding.outputs, binding.inputs);
+            }
+        } else {
+            qDebug() << "读取检查点权重失败：" << error;
+        }
+        m_pairLoaded[p] = true;
+    }
+}
+
+void NetworkVisualizer::setQuantizationPreview(bool enabled, const QuantConfig& config) {
+    m_quantPreview = enabled;
+    m_quantConfig = config;
+    // 已着色的连线组按新设置重读，视口外的仍等滚到时再读
+    m_pairLoaded.fill(false, m_connectionGrid.size());
+    refreshVisibleWeights();
+}
+
+void NetworkVisualizer::setPruningPreview(bool enabled, const PruneConfig& config) {
+    m_prunePreview = enabled;
+    m_pruneConfig = config;
+    m_globalPruneThreshold = 0.0f;
+    if (enabled && config.method == PruneMethod::Global && m_checkpoint) {
+        // 全局阈值需要所有连线组的权重，只在切换时读一次
+        std::vector<std::vector<float>> all;
+        QVector<QPair<const float*, qint64>> tensors;
+        for (int p = 0; p < m_connectionGrid.size(); ++p) {
+            const int layer = p + 1;
+            if (layer >= m_bindings.size() || !m_displayedLayers[layer].isDense() || m_bindings[layer].weight < 0) continue;
+            std::vector<float> weights;
+            if (!readDenseWeights(*m_checkpoint, m_bindings[layer], weights)) continue;
+            all.push_back(std::move(weights));
+            tensors.append(qMakePair(static_cast<const float*>(all.back().data()), qint64(all.back().size())));
+        }
+        m_globalPruneThreshold = globalMagnitudeThreshold(tensors, config.sparsity);
+    }
+    m_pairLoaded.fill(false, m_connectionGrid.size());
+    refreshVisibleWeights();
+}
+
+void NetworkVisualizer::contextMenuEvent(QContextMenuEvent* event) {
+    // 只有神经元视图的连线有权重颜色
+    if (m_connectionGrid.isEmpty()) {
+        QGraphicsView::contextMenuEvent(event);
+        return;
+    }
+    QMenu menu(this);
+    QMenu* quantMenu = menu.addMenu("量化预览");
+    const bool hasWeights = m_checkpoint && !m_bindings.isEmpty();
+    quantMenu->setEnabled(hasWeights);
+    if (!hasWeights) quantMenu->setTitle("量化预览（需先加载权重检查点）");
+
+    QActionGroup* group = new QActionGroup(quantMenu);
+    QAction* original = quantMenu->addAction("原始权重（fp32）");
+    original->setCheckable(true);
+    original->setChecked(!m_quantPreview);
+    group->addAction(original);
+    quantMenu->addSeparator();
+    const QuantConfig configs[] = {{QuantScheme::Int8Symmetric, QuantGranularity::PerChannel},
+                                   {QuantScheme::Int8Symmetric, QuantGranularity::PerTensor},
+                                   {QuantScheme::Int8Asymmetric, QuantGranularity::PerChannel},
+                                   {QuantScheme::Int8Asymmetric, QuantGranularity::PerTensor},
+                                   {QuantScheme::Float16, QuantGranularity::PerTensor},
+                                   {QuantScheme::BFloat16, QuantGranularity::PerTensor}};
+    for (const QuantConfig& config : configs) {
+        QAction* action = quantMenu->addAction(config.name());
+        action->setCheckable(true);
+        action->setChecked(m_quantPreview && m_quantConfig.scheme == config.scheme
+                           && m_quantConfig.granularity == config.granularity);
+        group->addAction(action);
+        connect(action, &QAction::triggered, this, [this, config] { setQuantizationPreview(true, config); });
+    }
+    connect(original, &QAction::triggered, this, [this] { setQuantizationPreview(false); });
+
+    QMenu* pruneMenu = menu.addMenu("剪枝预览");
+    pruneMenu->setEnabled(hasWeights);
+    if (!hasWeights) pruneMenu->setTitle("剪枝预览（需先加载权重检查点）");
+    QActionGroup* pruneGroup = new QActionGroup(pruneMenu);
+    QAction* unpruned = pruneMenu->addAction("不剪枝（显示全部连线）");
+    unpruned->setCheckable(true);
+    unpruned->setChecked(!m_prunePreview);
+    pruneGroup->addAction(unpruned);
+    connect(unpruned, &QAction::triggered, this, [this] { setPruningPreview(false); });
+    pruneMenu->addSeparator();
+    const struct { PruneMethod method; double sparsity; } pruneOptions[] = {
+        {PruneMethod::PerLayer, 0.5}, {PruneMethod::PerLayer, 0.9}, {PruneMethod::PerLayer, 0.99},
+        {PruneMethod::Global, 0.9}, {PruneMethod::Global, 0.99}, {PruneMethod::NM, 0.5}};
+    for (const auto& option : pruneOptions) {
+        PruneConfig config;
+        config.method = option.method;
+        config.sparsity = option.sparsity;
+        QAction* action = pruneMenu->addAction(config.name());
+        action->setCheckable(true);
+        action->setChecked(m_prunePreview && m_pruneConfig.method == config.method
+                           && (config.method == PruneMethod::NM || m_pruneConfig.sparsity == config.sparsity));
+        pruneGroup->addAction(action);
+        connect(action, &QAction::triggered, this, [this, config] { setPruningPreview(true, config); });
+    }
+
+    menu.addSeparator();
+    QAction* heatmap = menu.addAction("权重热力图视图");
+    heatmap->setCheckable(true);
+    heatmap->setChecked(m_heatmapView);
+    connect(heatmap, &QAction::toggled, this, &NetworkVisualizer::setHeatmapView);
+    menu.exec(event->globalPos());
+}
+
+void NetworkVisualizer::scrollContentsBy(int dx, int dy) {
+    QGraphicsView::scrollContentsBy(dx, dy);
+    refreshVisibleWeights();
+}
+
+void NetworkVisualizer::resizeEvent(QResizeEvent* event) {
+    QGraphicsView::resizeEvent(event);
+    layoutEdgePanel();
+    layoutSamplePanel();
+    refreshVisibleWeights();
+}
+
+void NetworkVisualizer::clearLayerHeat() {
+    for (QGraphicsItem* item : m_heatItems) delete item;
+    m_heatItems.clear();
+    m_latencyPending = false;
+}
+
+void NetworkVisualizer::setLayerHeat(const QVector<double>& heat, const QStringList& labels, const QStringList& tooltips) {
+    clearLayerHeat();
+    const ColorTheme& theme = ColorThemeManager::currentTheme();
+    const int count = std::min(static_cast<int>(heat.size()), static_cast<int>(m_layerGroups.size()));
+    for (int i = 0; i < count; ++i) {
+        MovableLayerGroup* group = m_layerGroups[i];
+        const double h = std::clamp(heat[i], 0.0, 1.0);
+        // 色相从绿色（120°）过渡到红色（0°）
+        const QColor color = QColor::fromHsvF((1.0 - h) * 120.0 / 360.0, 0.85, 0.95);
+        QColor fill = color;
+        fill.setAlpha(40 + static_cast<int>(h * 80));
+
+        // 比层背景大一圈，避免被 applyColorTheme 按 160×130 识别成背景框
+        QGraphicsRectItem* overlay = new QGraphicsRectItem(-4, -4, 168, 138);
+        overlay->setBrush(fill);
+        overlay->setPen(QPen(color, 3));
+        overlay->setZValue(2);
+        group->addToGroup(overlay);
+        m_heatItems.append(overlay);
+
+        if (i < labels.size()) {
+            QGraphicsTextItem* label = new QGraphicsTextItem(labels[i]);
+            label->setDefaultTextColor(theme.text);
+            label->setPos(174, 50);
+            group->addToGroup(label);
+            m_heatItems.append(label);
+            if (i < tooltips.size()) label->setToolTip(tooltips[i]);
+        }
+        if (i < tooltips.size()) {
+            overlay->setToolTip(tooltips[i]);
+            group->setToolTip(tooltips[i]);
+        }
+    }
+}
+
+void NetworkVisualizer::showLatencyPrediction(const QList<NeuralLayer>& layers) {
+    // 不在界面线程上跑微基准：未校准时启动后台校准，先放一条提示
+    MachineProfile profile;
+    if (!LatencyPredictor::instance().tryProfile(&profile)) {
+        clearLayerHeat();
+        LatencyPredictor::instance().calibrateInBackground();
+        QGraphicsTextItem* note = m_scene->addText("正在校准本机性能参数…");
+        note->setDefaultTextColor(ColorThemeManager::currentTheme().text);
+        note->setPos(100, -10);
+        m_heatItems.append(note);
+        m_latencyPending = true;
+        return;
+    }
+
+    const LatencyReport report = LatencyPredictor::instance().predict(layers, profile, m_predictionBatch);
+    if (!report.valid || report.totalMs <= 0.0) {
+        clearLayerHeat();
+        return;
+    }
+
+    double maxMs = 0.0;
+    for (const LayerLatency& l : report.layers) maxMs = std::max(maxMs, l.predictedMs);
+
+    QVector<double> heat;
+    QStringList labels;
+    QStringList tooltips;
+    for (const LayerLatency& l : report.layers) {
+        const double share = l.predictedMs / report.totalMs;
+        heat.append(maxMs > 0.0 ? l.predictedMs / maxMs : 0.0);
+        labels.append(QString("≈%1 ms · %2%").arg(l.predictedMs, 0, 'f', l.predictedMs < 0.1 ? 3 : 2)
+                          .arg(share * 100.0, 0, 'f', 0));
+        tooltips.append(QString("%1：预测 %2 ms（占总延迟 %3%）\n计算量 %4 MFLOPs，访存 %5 KB\n%6\n基于 %7，%8 线程，batch %9")
+                            .arg(l.layerType)
+                            .arg(l.predictedMs, 0, 'f', 3)
+                            .arg(share * 100.0, 0, 'f', 1)
+                            .arg(l.flops / 1.0e6, 0, 'f', 2)
+                            .arg(l.bytes / 1024.0, 0, 'f', 1)
+                            .arg(l.predictedMs == 0.0 ? "推理时不计算" : (l.memoryBound ? "访存受限" : "计算受限"))
+                            .arg(profile.cpuModel)
+                            .arg(profile.threads)
+                            .arg(report.batch));
+    }
+    setLayerHeat(heat, labels, tooltips);
+
+    QGraphicsTextItem* total = m_scene->addText(QString("预测总延迟 %1 ms（batch %2，%3）")
+                                                    .arg(report.totalMs, 0, 'f', 3)
+                                                    .arg(report.batch)
+                                                    .arg(profile.cpuModel));
+    total->setDefaultTextColor(ColorThemeManager::currentTheme().text);
+    total->setPos(100, -10);
+    m_heatItems.append(total);
+}
+
+int NetworkVisualizer::showTraceProfile(const TraceProfile& profile, const QStringList& names, QStringList* report) {
+    const QVector<int> match = matchTraceScopes(profile, m_displayedLayers, names);
+
+    double maxSelf = 0.0;
+    double matchedSelf = 0.0;
+    int matched = 0;
+    for (int scope : match) {
+        if (scope < 0) continue;
+        maxSelf = std::max(maxSelf, profile.scopes[scope].selfUs);
+        matchedSelf += profile.scopes[scope].selfUs;
+        ++matched;
+    }
+    if (matched == 0) {
+        clearLayerHeat();
+        if (report) report->append("追踪中没有能与当前各层对应的模块作用域");
+        return 0;
+    }
+
+    auto mb = [](qint64 bytes) { return bytes / (1024.0 * 1024.0); };
+    QVector<double> heat;
+    QStringList labels;
+    QStringList tooltips;
+    for (int i = 0; i < match.size(); ++i) {
+        const NeuralLayer& layer = m_displayedLayers[i];
+        if (match[i] < 0) {
+            heat.append(0.0);
+            labels.append("—");
+            tooltips.append(QString("%1：追踪中没有对应的模块").arg(layer.layerType));
+            if (report) report->append(QString("第 %1 层 %2：未匹配").arg(i + 1).arg(layer.layerType));
+            continue;
+        }
+        const TraceScope& s = profile.scopes[match[i]];
+        const double selfMs = s.selfUs / 1000.0;
+        heat.append(maxSelf > 0.0 ? s.selfUs / maxSelf : 0.0);
+        labels.append(QString("%1 ms · %2%").arg(selfMs, 0, 'f', selfMs < 0.1 ? 3 : 2)
+                          .arg(matchedSelf > 0.0 ? s.selfUs / matchedSelf * 100.0 : 0.0, 0, 'f', 0));
+        tooltips.append(QString("%1 ← %2\n调用 %3 次，自身 %4 ms，总计 %5 ms（平均每次 %6 ms）\n分配内存：自身 %7 MB，含子作用域 %8 MB")
+                            .arg(layer.layerType, s.name)
+                            .arg(s.calls)
+                            .arg(selfMs, 0, 'f', 3)
+                            .arg(s.totalUs / 1000.0, 0, 'f', 3)
+                            .arg(s.calls > 0 ? s.totalUs / 1000.0 / s.calls : 0.0, 0, 'f', 3)
+                            .arg(mb(s.selfAllocatedBytes), 0, 'f', 2)
+                            .arg(mb(s.totalAllocatedBytes), 0, 'f', 2));
+        if (report) report->append(QString("第 %1 层 %2 ← %3").arg(i + 1).arg(layer.layerType, s.name));
+    }
+    setLayerHeat(heat, labels, tooltips);
+
+    QGraphicsTextItem* total = m_scene->addText(QString("profiler 追踪：%1 个事件，%2 个作用域，跨度 %3 ms，匹配 %4/%5 层")
+                                                    .arg(profile.events)
+                                                    .arg(profile.scopes.size())
+                                                    .arg(profile.spanUs / 1000.0, 0, 'f', 1)
+                                                    .arg(matched)
+                                                    .arg(match.size()));
+    total->setDefaultTextColor(ColorThemeManager::currentTheme().text);
+    total->setPos(100, -10);
+    m_heatItems.append(total);
+    return matched;
 }
 
 
@@ -381,6 +1419,10 @@ void NetworkVisualizer::applyColorTheme(const QString& themeName) {
                 conn->updateColor();
             }
         }
+        for (WeightHeatmapItem* heatmap : m_heatmapItems) {
+            if (heatmap) heatmap->updateColors();
+        }
+        if (m_recorder) showSample(m_sampleIndex);
     }
 
 void NetworkVisualizer::refreshLayerItem(NeuralLayer* layer) {
@@ -389,9 +1431,13 @@ void NetworkVisualizer::refreshLayerItem(NeuralLayer* layer) {
         if (group->data(0).value<NeuralLayer*>() == layer) {
             QPointF oldPos = group->pos();
 
-            // 删除旧连接线
+            // 删除旧连接线，记下与前后两层是否相连（有数据流时不一定相连）
+            bool linkedPrevious = false;
+            bool linkedNext = false;
             for (auto it = m_connections.begin(); it != m_connections.end(); ) {
                 if (it->fromGroup == group || it->toGroup == group) {
+                    linkedPrevious |= it->toGroup == group;
+                    linkedNext |= it->fromGroup == group;
                     m_scene->removeItem(it->line);
                     delete it->line;
                     it = m_connections.erase(it);
@@ -401,6 +1447,11 @@ void NetworkVisualizer::refreshLayerItem(NeuralLayer* layer) {
             }
 
             //重建图层
+            QVector<int> arcsFrom, arcsTo;
+            for (int a = 0; a < m_dataflowArcs.size(); ++a) {
+                if (m_dataflowArcs[a].fromGroup == group) arcsFrom.append(a);
+                if (m_dataflowArcs[a].toGroup == group) arcsTo.append(a);
+            }
             m_scene->removeItem(group);
             delete group;
 
@@ -409,13 +1460,16 @@ void NetworkVisualizer::refreshLayerItem(NeuralLayer* layer) {
             newGroup->setData(0, QVariant::fromValue(layer));
             m_layerGroups[i] = newGroup;
 
-            //重建连接线
-            if (i > 0) {
+            //重建连接线，数据流弧线改接到新的层块上
+            if (i > 0 && linkedPrevious) {
                 createConnection(m_layerGroups[i-1], newGroup);
             }
-            if (i < m_layerGroups.size()-1) {
+            if (i < m_layerGroups.size()-1 && linkedNext) {
                 createConnection(newGroup, m_layerGroups[i+1]);
             }
+            for (int a : arcsFrom) m_dataflowArcs[a].fromGroup = newGroup;
+            for (int a : arcsTo) m_dataflowArcs[a].toGroup = newGroup;
+            for (int a : arcsFrom + arcsTo) layoutDataflowArc(m_dataflowArcs[a]);
 
             update();
             break;
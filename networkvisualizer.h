@@ -5,13 +5,30 @@
 #include "movablelayergroup.h"
 #include "connectionitem.h"
 #include "backend.h"
+#include "activationcapture.h"
+#include "edgeselection.h"
+#include "modelwatcher.h"
+#include "modulerepr.h"
+#include "pruning.h"
+#include "quantization.h"
+#include "traceprofile.h"
+#include "weightcheckpoint.h"
+#include "weightheatmap.h"
+#include "weightstats.h"
 #include <QGraphicsScene>
 #include <QGraphicsItemGroup>
 #include <QGraphicsRectItem>
 #include <QGraphicsEllipseItem>
+#include <QGraphicsPathItem>
+#include <QGraphicsSimpleTextItem>
 #include <QGraphicsTextItem>
+#include <QGraphicsPixmapItem>
+#include <QLabel>
 #include <QPen>
+#include <QSlider>
+#include <QTimer>
 #include <QBrush>
+#include <memory>
 
 
 
@@ -21,18 +38,64 @@ public:
     NetworkVisualizer(QWidget* parent = nullptr);
     void createNetwork(const QList<NeuralLayer>& layers);
     //void createNetwork(const QJsonArray& layersJson);
-    void createblockNetwork(const QList<NeuralLayer>& layers);
+    // edges 为导入模型的数据流（见 layerEdges）：相邻两层直接相连时画直线，跳连、分支与合并在层块左侧画成弧线，
+    // 经过合并的标出 add / concat；数据流中互不相连的相邻两层之间不画线。为空时按层顺序依次连线
+    void createblockNetwork(const QList<NeuralLayer>& layers, const QVector<LayerEdge>& edges = QVector<LayerEdge>());
     void applyColorTheme(const QString& themeName);
     //QGraphicsItemGroup* createDetailedLayer(const NeuralLayer& layer , int yPos);
     MovableLayerGroup* createDetailedLayer(const NeuralLayer& layer , int yPos);
     void createConnection(MovableLayerGroup* from, MovableLayerGroup* to);
+    // 监视模式：按 diff 把新结构就地改到当前块视图上，只重建新增、修改的层块及变化的连线，
+    // 保留下来的层块连同用户拖动后的位置不动（下标改变的整体平移）；神经元视图或带模块分组时整体重建
+    // 有数据流连线（新的或当前的）时整体重建
+    void patchBlockNetwork(const QList<NeuralLayer>& layers, const LayerDiff& diff,
+                           const QVector<LayerEdge>& edges = QVector<LayerEdge>());
     void refreshLayerItem(NeuralLayer* layer);
 
+    // 在 createblockNetwork 生成的层块上叠加热度（0~1，绿->红），labels 显示在块右侧，tooltips 为悬停说明
+    void setLayerHeat(const QVector<double>& heat, const QStringList& labels, const QStringList& tooltips);
+    void clearLayerHeat();
+    // print(model) 导入的模块分组（见 ModuleRepr::groups）：在 createblockNetwork 生成的层块左侧画出嵌套的括线，
+    // 点击组名折叠或展开，折叠的组收成一个摘要块；层数较多时初始全部折叠
+    void setModuleGroups(const QVector<ModuleGroup>& groups);
+    // 按本机校准的延迟模型预测每层耗时并以热度显示，createblockNetwork 结束时自动调用；
+    // 尚未校准时先显示“正在校准”，校准完成后自动补上
+    void showLatencyPrediction(const QList<NeuralLayer>& layers);
+    // torch.profiler 追踪：按 matchTraceScopes 把模块作用域对到层块上，按自身 CPU 时间显示热度，
+    // 悬停显示自身 / 总计时间与内存分配；names 为各层的模块路径（导入时 JSON 中的 "name"），可以为空。返回匹配的层数
+    int showTraceProfile(const TraceProfile& profile, const QStringList& names, QStringList* report = nullptr);
+    void setPredictionBatch(int batch) { m_predictionBatch = batch > 0 ? batch : 1; }
+    // 用真实权重刷新 createNetwork 生成的第 layerPair 组连线（第 layerPair 列到下一列）
+    // weights 为 PyTorch Linear 布局 [outputs][inputs]，尺寸与两列神经元数不一致时忽略
+    void setConnectionWeights(int layerPair, const float* weights, int outputs, int inputs);
+    // 剪枝后的权重：只显示 CSR 中的连线，其余隐藏（不参与绘制）
+    void setSparseConnectionWeights(int layerPair, const CsrMatrix& weights);
+    // 套用检查点：按名称/顺序把张量匹配到当前显示的层，块视图在层下方标注张量、在右侧画权重直方图缩略线，
+    // 神经元视图只读取滚动进视口的连线组，其余的等滚到时再读；传空指针则撤销
+    void applyCheckpoint(const std::shared_ptr<WeightCheckpoint>& checkpoint, QStringList* report = nullptr);
+    // 神经元视图的量化预览：开启后检查点权重先按 config 量化再反量化，连线颜色反映量化后的取值
+    void setQuantizationPreview(bool enabled, const QuantConfig& config = QuantConfig());
+    // 神经元视图的剪枝预览：检查点权重按 config 剪枝后转成 CSR，只画保留下来的连线；可与量化预览叠加（先剪枝后量化）
+    void setPruningPreview(bool enabled, const PruneConfig& config = PruneConfig());
+    // 神经元视图每组连线只显示 |w| 最大的 fraction（0~1）部分，由视图右上角的滑块控制
+    void setEdgeFraction(double fraction);
+    // 神经元视图的另一种显示：每组连线换成一张权重矩阵热力图（行 = 后一层神经元，列 = 前一层神经元），
+    // 缩小时按 |w| 最大值逐级降采样，悬停显示 (i, j, w)
+    void setHeatmapView(bool enabled);
+    // 读入样本输入（CSV 行、float32 原始文件或图像）在原生推理引擎上前向，按各层平均 |激活| 着色：
+    // 神经元视图给神经元填色，块视图在层块右侧画逐单元的热度条；视图左下角的滑块切换样本
+    bool loadSampleInputs(const QStringList& paths, QString* error = nullptr);
+    void showSample(int index);
+    void clearActivations();
+
 protected:
     //void mousePressEvent(QMouseEvent* event) override;
     //void mouseMoveEvent(QMouseEvent* event) override;
     void dragMoveEvent(QDragMoveEvent* event) override;
     void dropEvent(QDropEvent* event) override;
+    void scrollContentsBy(int dx, int dy) override;
+    void resizeEvent(QResizeEvent* event) override;
+    void contextMenuEvent(QContextMenuEvent* event) override;
 
 
 
@@ -43,6 +106,51 @@ private:
     QPointF m_dragStartPos;
     QVector<QVector<NeuronItem*>> m_allNeurons; // 存储神经元指针以便更新
     QList<MovableLayerGroup*> m_layerGroups;
+    QVector<QVector<ConnectionItem*>> m_connectionGrid;  // 每组连线按 [to][from] 存放，与权重矩阵同序
+    QList<QGraphicsItem*> m_heatItems;  // 热度叠加层，随 m_scene->clear() 一起删除
+    QVector<ModuleGroup> m_moduleGroups;
+    QVector<bool> m_groupCollapsed;
+    QList<QGraphicsItem*> m_groupItems;  // 分组的括线、组名与摘要块，每次重新布局时删除重建
+    void layoutModuleGroups();
+    int m_predictionBatch = 1;
+    bool m_latencyPending = false;  // 块视图在等待延迟校准，完成后重新显示预测
+    QList<NeuralLayer> m_displayedLayers;  // 最近一次 createNetwork / createblockNetwork 的层
+    std::shared_ptr<WeightCheckpoint> m_checkpoint;
+    QVector<LayerWeightBinding> m_bindings;
+    QVector<bool> m_pairLoaded;            // 神经元视图中每组连线是否已读入真实权重
+    QList<QGraphicsItem*> m_checkpointItems;
+    QVector<QGraphicsItem*> m_sparklines;  // 每个层块的权重直方图缩略线，属于 m_checkpointItems
+    bool m_quantPreview = false;
+    QuantConfig m_quantConfig;
+    bool m_prunePreview = false;
+    PruneConfig m_pruneConfig;
+    float m_globalPruneThreshold = 0.0f;  // 全局剪枝时在开启预览时对全部连线组求一次
+    QVector<TopKEdgeSelection> m_edgeSelections;  // 与 m_connectionGrid 一一对应
+    double m_edgeFraction = 1.0;
+    QWidget* m_edgePanel;
+    QSlider* m_edgeSlider;
+    QLabel* m_edgeLabel;
+    QTimer* m_edgeTimer;  // 合并拖动中连续的滑块事件，每帧最多重新筛选一次
+    QVector<std::vector<float>> m_pairWeights;  // 每组连线当前显示的有符号权重，[to][from]
+    bool m_heatmapView = false;
+    QVector<WeightHeatmapItem*> m_heatmapItems;  // 与 m_connectionGrid 一一对应，随 m_scene->clear() 一起删除
+    void updateHeatmap(int layerPair);
+    std::unique_ptr<ActivationRecorder> m_recorder;
+    SampleInputs m_samples;
+    int m_sampleIndex = -1;
+    QWidget* m_samplePanel;
+    QSlider* m_sampleSlider;
+    QLabel* m_sampleLabel;
+    QTimer* m_sampleTimer;  // 同 m_edgeTimer，拖动时每帧最多切换一次样本
+    QVector<QGraphicsPixmapItem*> m_activationStrips;  // 块视图每层的热度条，随 m_scene->clear() 一起删除
+    QVector<QImage> m_stripImages;                      // 热度条的着色缓冲区，逐样本复用
+    void layoutSamplePanel();
+    void resetEdgeSelection(int layerPair, std::vector<float> magnitude);
+    void applyEdgeFraction(int layerPair);
+    void updateEdgeLabel();
+    void layoutEdgePanel();
+    void refreshVisibleWeights();
+    void showWeightSparkline(int tensor, const WeightStats& stats);
     struct ConnectionLine {
          QGraphicsLineItem* line;
          QGraphicsItemGroup* fromGroup;
@@ -50,6 +158,17 @@ private:
     };
 
     QList<ConnectionLine> m_connections;
+    // 数据流中不是相邻两层直连的连线，画在层块左侧，跨度越大越靠外
+    struct DataflowArc {
+         QGraphicsPathItem* path;
+         QGraphicsSimpleTextItem* label;  // 合并方式，没有经过合并时为空
+         QGraphicsItemGroup* fromGroup;
+         QGraphicsItemGroup* toGroup;
+         int lane;
+    };
+    QList<DataflowArc> m_dataflowArcs;  // 随 m_scene->clear() 一起删除
+    QVector<LayerEdge> m_dataflow;      // 最近一次 createblockNetwork 的数据流
+    void layoutDataflowArc(const DataflowArc& arc);
 private slots:
     void updateConnections();
 
@@ -3,6 +3,7 @@
 #include "connectionitem.h"
 #include <QBrush>
 #include <QPen>
+#include <algorithm>
 
 
 NeuronItem::NeuronItem(const QString& label, QGraphicsItem* parent)
@@ -43,11 +44,24 @@ void NeuronItem::updateColors() {
     const ColorTheme& theme = ColorThemeManager::currentTheme();
 
     // 设置神经元颜色
-    setBrush(QBrush(theme.neuronFill));
+    if (m_activation < 0.0) {
+        setBrush(QBrush(theme.neuronFill));
+    } else {
+        const QColor& low = theme.neuronFill;
+        const QColor& high = theme.connectionHighWeight;
+        const double t = m_activation;
+        setBrush(QBrush(QColor(qRound(low.red() + (high.red() - low.red()) * t),
+                               qRound(low.green() + (high.green() - low.green()) * t),
+                               qRound(low.blue() + (high.blue() - low.blue()) * t))));
+    }
     setPen(QPen(theme.neuronBorder, 1));  // 边框宽度设为1
 
     // 设置文本颜色
     m_label->setDefaultTextColor(theme.text);
 }
 
-
+void NeuronItem::setActivation(double level, const QString& tooltip) {
+    m_activation = level >= 0.0 ? std::min(level, 1.0) : -1.0;  // NaN 也视为无激活
+    setToolTip(tooltip);
+    updateColors();
+}
@@ -8,6 +8,8 @@ class NeuronItem : public QGraphicsEllipseItem {
 public:
     NeuronItem(const QString& label, QGraphicsItem* parent = nullptr);
     void updateColors();  // 根据当前主题更新颜色
+    // 激活热度：level 为 0~1 时填充色从主题的 neuronFill 过渡到 connectionHighWeight，负数恢复为 neuronFill
+    void setActivation(double level, const QString& tooltip = QString());
     void addOutgoingConnection(ConnectionItem* conn);
     void addIncomingConnection(ConnectionItem* conn);
 
@@ -16,6 +18,7 @@ protected:
 
 private:
     QGraphicsTextItem* m_label;
+    double m_activation = -1.0;
     QList<ConnectionItem*> m_outgoingConnections;
     QList<ConnectionItem*> m_incomingConnections;
 };
@@ -0,0 +1,598 @@
+#include "onnxmodel.h"
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+enum WireType { Varint = 0, Fixed64 = 1, LengthDelimited = 2, Fixed32 = 5 };
+
+// protobuf 线格式的顺序读取器。越界或遇到不支持的线类型时 ok 置为 false，之后的读取都返回空值；
+// length-delimited 字段只返回在映射内存中的区间，不复制
+struct ProtoReader
+{
+    const uchar* p;
+    const uchar* end;
+    bool ok = true;
+
+    bool next(int* field, int* wire) {
+        if (!ok || p >= end) return false;
+        const quint64 key = varint();
+        *field = static_cast<int>(key >> 3);
+        *wire = static_cast<int>(key & 7);
+        if (*field <= 0) ok = false;
+        return ok;
+    }
+
+    quint64 varint() {
+        quint64 value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (p >= end) break;
+            const uchar byte = *p++;
+            value |= quint64(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        ok = false;
+        return 0;
+    }
+
+    bool advance(quint64 n) {
+        if (!ok || n > quint64(end - p)) {
+            ok = false;
+            return false;
+        }
+        p += n;
+        return true;
+    }
+
+    bool bytes(const uchar** begin, qint64* length) {
+        const quint64 n = varint();
+        *begin = p;
+        *length = static_cast<qint64>(n);
+        return advance(n);
+    }
+
+    ProtoReader sub() {
+        const uchar* begin;
+        qint64 length;
+        if (!bytes(&begin, &length)) return ProtoReader{end, end, false};
+        return ProtoReader{begin, begin + length};
+    }
+
+    QString string() {
+        const uchar* begin;
+        qint64 length;
+        if (!bytes(&begin, &length)) return QString();
+        return QString::fromUtf8(reinterpret_cast<const char*>(begin), static_cast<int>(length));
+    }
+
+    float fixed32() {
+        float value = 0.0f;
+        if (advance(4)) std::memcpy(&value, p - 4, 4);
+        return value;
+    }
+
+    // 重复的整数字段：打包（一个 length-delimited）或逐个出现
+    void int64s(int wire, QVector<qint64>& out) {
+        if (wire == Varint) {
+            out.append(static_cast<qint64>(varint()));
+        } else if (wire == LengthDelimited) {
+            ProtoReader packed = sub();
+            while (packed.ok && packed.p < packed.end) out.append(static_cast<qint64>(packed.varint()));
+            ok = ok && packed.ok;
+        } else {
+            skip(wire);
+        }
+    }
+
+    void skip(int wire) {
+        switch (wire) {
+        case Varint: varint(); break;
+        case Fixed64: advance(8); break;
+        case LengthDelimited: {
+            const uchar* begin;
+            qint64 length;
+            bytes(&begin, &length);
+            break;
+        }
+        case Fixed32: advance(4); break;
+        default: ok = false; break;  // 分组（3/4）在 proto3 中已废弃，ONNX 不使用
+        }
+    }
+};
+
+const char* const kActivations[][2] = {
+    {"Relu", "relu"}, {"LeakyRelu", "leaky_relu"}, {"Sigmoid", "sigmoid"}, {"Tanh", "tanh"},
+    {"Softmax", "softmax"}, {"LogSoftmax", "softmax"}};
+
+QString activationName(const QString& opType) {
+    for (const auto& activation : kActivations) {
+        if (opType == QLatin1String(activation[0])) return QString::fromLatin1(activation[1]);
+    }
+    return QString();
+}
+
+QString mergeOp(const QString& opType) {
+    if (opType == "Add") return "add";
+    if (opType == "Sub") return "sub";
+    if (opType == "Mul") return "mul";
+    if (opType == "Div") return "div";
+    if (opType == "MatMul") return "matmul";
+    if (opType == "Concat") return "concat";
+    return QString();
+}
+
+} // namespace
+
+qint64 OnnxInitializer::elementCount() const {
+    qint64 n = 1;
+    for (qint64 d : dims) n *= d;
+    return n;
+}
+
+OnnxModel::~OnnxModel() {
+    close();
+}
+
+void OnnxModel::close() {
+    if (m_data) m_file.unmap(const_cast<uchar*>(m_data));
+    m_file.close();
+    m_data = nullptr;
+    m_size = 0;
+    m_irVersion = 0;
+    m_opset = 0;
+    m_producer.clear();
+    m_graphName.clear();
+    m_nodes.clear();
+    m_initializers.clear();
+    m_initializerIndex.clear();
+    m_values.clear();
+    m_valueIndex.clear();
+    m_inputs.clear();
+    m_outputs.clear();
+    m_warnings.clear();
+}
+
+bool OnnxModel::open(const QString& path, QString* error) {
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        if (error) *error = "无法打开文件：" + m_file.errorString();
+        return false;
+    }
+    m_size = m_file.size();
+    // 整个文件只建立映射；扫描时只访问各字段头部所在的页，权重数据所在的页不会被调入
+    m_data = m_size > 0 ? m_file.map(0, m_size) : nullptr;
+    if (!m_data) {
+        if (error) *error = m_size > 0 ? "内存映射失败：" + m_file.errorString() : QString("文件为空");
+        close();
+        return false;
+    }
+    if (!parseModel(error)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+qint64 OnnxModel::initializerBytes() const {
+    qint64 total = 0;
+    for (const OnnxInitializer& initializer : m_initializers) total += initializer.byteSize;
+    return total;
+}
+
+int OnnxModel::internValue(const uchar* text, int length) {
+    if (length == 0) return -1;  // 缺省的可选输入
+    const QString name = QString::fromUtf8(reinterpret_cast<const char*>(text), length);
+    auto it = m_valueIndex.constFind(name);
+    if (it != m_valueIndex.constEnd()) return it.value();
+    m_valueIndex.insert(name, m_values.size());
+    m_values.append(name);
+    return m_values.size() - 1;
+}
+
+bool OnnxModel::parseModel(QString* error) {
+    // ModelProto：1 ir_version、2 producer_name、7 graph、8 opset_import
+    ProtoReader reader{m_data, m_data + m_size};
+    const uchar* graphBegin = nullptr;
+    qint64 graphLength = 0;
+    int field, wire;
+    while (reader.next(&field, &wire)) {
+        if (field == 1 && wire == Varint) {
+            m_irVersion = static_cast<qint64>(reader.varint());
+        } else if (field == 2 && wire == LengthDelimited) {
+            m_producer = reader.string();
+        } else if (field == 7 && wire == LengthDelimited) {
+            reader.bytes(&graphBegin, &graphLength);
+        } else if (field == 8 && wire == LengthDelimited) {
+            ProtoReader opset = reader.sub();
+            QString domain;
+            qint64 version = 0;
+            while (opset.next(&field, &wire)) {
+                if (field == 1 && wire == LengthDelimited) domain = opset.string();
+                else if (field == 2 && wire == Varint) version = static_cast<qint64>(opset.varint());
+                else opset.skip(wire);
+            }
+            if (domain.isEmpty() || domain == "ai.onnx") m_opset = version;
+        } else {
+            reader.skip(wire);
+        }
+    }
+    if (!reader.ok || m_irVersion <= 0) {
+        if (error) *error = QString("不是有效的 ONNX 模型或文件不完整（protobuf 解析在第 %1 字节处失败）").arg(static_cast<qint64>(reader.p - m_data));
+        return false;
+    }
+    if (!graphBegin) {
+        if (error) *error = "ONNX 模型中没有计算图";
+        return false;
+    }
+    return parseGraph(graphBegin, graphBegin + graphLength, error);
+}
+
+bool OnnxModel::parseGraph(const uchar* begin, const uchar* end, QString* error) {
+    // GraphProto：1 node、2 name、5 initializer、11 input、12 output，其余字段跳过。
+    // 各字段的先后不固定（导出工具通常先写节点），输入中的 initializer 在扫描结束后再剔除
+    ProtoReader graph{begin, end};
+    QVector<int> declaredInputs;
+    int field, wire;
+    while (graph.next(&field, &wire)) {
+        if (wire != LengthDelimited) {
+            graph.skip(wire);
+            continue;
+        }
+        if (field == 1) {
+            // NodeProto：1 input、2 output、3 name、4 op_type、5 attribute、7 domain
+            ProtoReader reader = graph.sub();
+            OnnxNode node;
+            while (reader.next(&field, &wire)) {
+                if (wire != LengthDelimited) {
+                    reader.skip(wire);
+                    continue;
+                }
+                if (field == 1 || field == 2) {
+                    const uchar* text;
+                    qint64 length;
+                    if (!reader.bytes(&text, &length)) break;
+                    (field == 1 ? node.inputs : node.outputs).append(internValue(text, static_cast<int>(length)));
+                } else if (field == 3) {
+                    node.name = reader.string();
+                } else if (field == 4) {
+                    node.opType = reader.string();
+                } else if (field == 7) {
+                    node.domain = reader.string();
+                } else if (field == 5) {
+                    // AttributeProto：1 name、2 f、3 i、4 s、5 t、6 g、7 floats、8 ints；张量与子图只记名称
+                    ProtoReader attribute = reader.sub();
+                    QString name;
+                    QJsonValue value;
+                    QJsonArray list;
+                    bool isList = false;
+                    while (attribute.next(&field, &wire)) {
+                        if (field == 1 && wire == LengthDelimited) {
+                            name = attribute.string();
+                        } else if (field == 2 && wire == Fixed32) {
+                            value = double(attribute.fixed32());
+                        } else if (field == 3 && wire == Varint) {
+                            value = double(static_cast<qint64>(attribute.varint()));
+                        } else if (field == 4 && wire == LengthDelimited) {
+                            value = attribute.string();
+                        } else if ((field == 5 || field == 6) && wire == LengthDelimited) {
+                            attribute.skip(wire);
+                            value = QString(field == 5 ? "<tensor>" : "<graph>");
+                        } else if (field == 7) {
+                            isList = true;
+                            if (wire == Fixed32) {
+                                list.append(double(attribute.fixed32()));
+                            } else if (wire == LengthDelimited) {
+                                ProtoReader packed = attribute.sub();
+                                while (packed.ok && packed.end - packed.p >= 4) list.append(double(packed.fixed32()));
+                            } else {
+                                attribute.skip(wire);
+                            }
+                        } else if (field == 8) {
+                            isList = true;
+                            QVector<qint64> ints;
+                            attribute.int64s(wire, ints);
+                            for (qint64 v : ints) list.append(double(v));
+                        } else if (field == 9 && wire == LengthDelimited) {
+                            isList = true;
+                            list.append(attribute.string());
+                        } else {
+                            attribute.skip(wire);
+                        }
+                    }
+                    if (!attribute.ok) reader.ok = false;
+                    if (!name.isEmpty()) node.attributes[name] = isList ? QJsonValue(list) : value;
+                } else {
+                    reader.skip(wire);
+                }
+            }
+            if (!reader.ok) {
+                graph.ok = false;
+                break;
+            }
+            m_nodes.append(std::move(node));
+        } else if (field == 5) {
+            // TensorProto：1 dims、2 data_type、8 name、9 raw_data、13 external_data、14 data_location；
+            // 数据字段只记录区间，不读取
+            ProtoReader reader = graph.sub();
+            OnnxInitializer tensor;
+            bool external = false;
+            qint64 externalOffset = 0, externalLength = -1;
+            while (reader.next(&field, &wire)) {
+                if (field == 1) {
+                    reader.int64s(wire, tensor.dims);
+                } else if (field == 2 && wire == Varint) {
+                    tensor.dataType = static_cast<int>(reader.varint());
+                } else if (field == 8 && wire == LengthDelimited) {
+                    tensor.name = reader.string();
+                } else if (field == 14 && wire == Varint) {
+                    external = reader.varint() == 1;
+                } else if (field == 13 && wire == LengthDelimited) {
+                    ProtoReader entry = reader.sub();
+                    QString key, value;
+                    while (entry.next(&field, &wire)) {
+                        if (field == 1 && wire == LengthDelimited) key = entry.string();
+                        else if (field == 2 && wire == LengthDelimited) value = entry.string();
+                        else entry.skip(wire);
+                    }
+                    if (key == "location") tensor.externalLocation = value;
+                    else if (key == "offset") externalOffset = value.toLongLong();
+                    else if (key == "length") externalLength = value.toLongLong();
+                } else if (wire == LengthDelimited && (field == 9 || (field >= 4 && field <= 7) || field == 10 || field == 11)) {
+                    const uchar* data;
+                    qint64 length;
+                    if (!reader.bytes(&data, &length)) break;
+                    tensor.offset = data - m_data;
+                    tensor.byteSize = length;
+                } else {
+                    reader.skip(wire);
+                }
+            }
+            if (!reader.ok) {
+                graph.ok = false;
+                break;
+            }
+            if (external) {
+                tensor.offset = externalOffset;
+                tensor.byteSize = externalLength;
+            }
+            m_initializerIndex.insert(tensor.name, m_initializers.size());
+            m_initializers.append(std::move(tensor));
+        } else if (field == 11 || field == 12) {
+            // ValueInfoProto 只取 1 name
+            ProtoReader reader = graph.sub();
+            int value = -1;
+            int valueField, valueWire;
+            while (reader.next(&valueField, &valueWire)) {
+                if (valueField == 1 && valueWire == LengthDelimited) {
+                    const uchar* text;
+                    qint64 length;
+                    if (reader.bytes(&text, &length)) value = internValue(text, static_cast<int>(length));
+                } else {
+                    reader.skip(valueWire);
+                }
+            }
+            if (value >= 0) (field == 11 ? declaredInputs : m_outputs).append(value);
+        } else if (field == 2) {
+            m_graphName = graph.string();
+        } else {
+            if (field == 15) m_warnings << "稀疏 initializer 未解析";
+            graph.skip(wire);
+        }
+    }
+    if (!graph.ok) {
+        if (error) *error = QString("计算图解析失败：第 %1 字节处的 protobuf 数据不完整（已读 %2 个节点）")
+                                .arg(static_cast<qint64>(graph.p - m_data))
+                                .arg(m_nodes.size());
+        return false;
+    }
+    for (int value : declaredInputs) {
+        if (!m_initializerIndex.contains(m_values[value])) m_inputs.append(value);
+    }
+    for (const OnnxNode& node : m_nodes) {
+        if (!node.domain.isEmpty() && node.domain != "ai.onnx") {
+            m_warnings << QString("含自定义算子域 %1 的节点按一般算子显示").arg(node.domain);
+            break;
+        }
+    }
+    return true;
+}
+
+QJsonObject OnnxModel::layerFor(int index) const {
+    const OnnxNode& node = m_nodes[index];
+    auto weightDims = [&](int input) {
+        if (input >= node.inputs.size() || node.inputs[input] < 0) return QVector<qint64>();
+        const int tensor = initializerIndex(m_values[node.inputs[input]]);
+        return tensor >= 0 ? m_initializers[tensor].dims : QVector<qint64>();
+    };
+    auto intAttribute = [&](const char* name, int fallback) {
+        const QJsonValue v = node.attributes.value(name);
+        return v.isDouble() ? v.toInt() : fallback;
+    };
+    auto firstInt = [&](const char* name, int fallback) {
+        const QJsonArray list = node.attributes.value(name).toArray();
+        return list.isEmpty() ? fallback : list[0].toInt();
+    };
+    auto layer = [&](const char* layerType, qint64 neurons) {
+        QJsonObject object;
+        object["layerType"] = QString::fromLatin1(layerType);
+        object["neurons"] = static_cast<int>(neurons);
+        object["activationFunction"] = QString();
+        object["name"] = node.name.isEmpty() ? node.opType + QString::number(index) : node.name;
+        return object;
+    };
+
+    const QString& op = node.opType;
+    if (op == "Gemm" || op == "MatMul") {
+        // 第二个输入是二维权重时才是全连接层；两个激活相乘（注意力中的 QKᵀ）按一般算子处理
+        const QVector<qint64> w = weightDims(1);
+        if (w.size() != 2) return QJsonObject();
+        const bool transposed = op == "Gemm" && intAttribute("transB", 0) != 0;
+        QJsonObject object = layer("Dense", transposed ? w[0] : w[1]);
+        object["inputSize"] = static_cast<int>(transposed ? w[1] : w[0]);
+        return object;
+    }
+    if (op == "Conv") {
+        const QVector<qint64> w = weightDims(1);  // [M, C / group, kH, kW]
+        if (w.size() < 3) return QJsonObject();
+        QJsonObject object = layer("Conv2d", w[0]);
+        object["filters"] = static_cast<int>(w[0]);
+        object["inputSize"] = static_cast<int>(w[1] * intAttribute("group", 1));
+        object["kernelSize"] = firstInt("kernel_shape", static_cast<int>(w[2]));
+        return object;
+    }
+    if (op == "MaxPool" || op == "AveragePool") {
+        QJsonObject object = layer(op == "MaxPool" ? "MaxPooling" : "AvgPooling", 0);
+        object["poolingSize"] = firstInt("kernel_shape", 2);
+        return object;
+    }
+    if (op == "LSTM" || op == "GRU" || op == "RNN") {
+        const int hidden = intAttribute("hidden_size", 0);
+        const QVector<qint64> w = weightDims(1);  // [directions, gates × hidden, input]
+        QJsonObject object = layer(op.toLatin1().constData(), hidden);
+        object["units"] = hidden;
+        object["inputSize"] = w.size() == 3 ? static_cast<int>(w[2]) : 0;
+        const QJsonArray activations = node.attributes.value("activations").toArray();
+        if (op == "RNN" && !activations.isEmpty()) object["activationFunction"] = activationName(activations[0].toString());
+        return object;
+    }
+    if (op == "Dropout") {
+        QJsonObject object = layer("Dropout", 0);
+        // opset 12 起比例是第二个输入（通常是单个 float 的 initializer），只读这 4 个字节；都取不到时用默认值
+        const QJsonValue ratio = node.attributes.value("ratio");
+        double rate = ratio.isDouble() ? ratio.toDouble() : 0.5;
+        const int tensor = node.inputs.size() > 1 && node.inputs[1] >= 0 ? initializerIndex(m_values[node.inputs[1]]) : -1;
+        if (tensor >= 0) {
+            const OnnxInitializer& scalar = m_initializers[tensor];
+            if (scalar.dataType == 1 && scalar.byteSize == 4 && scalar.externalLocation.isEmpty() &&
+                scalar.offset >= 0 && scalar.offset + 4 <= m_size) {
+                float value;
+                std::memcpy(&value, m_data + scalar.offset, 4);
+                rate = std::round(value * 1.0e6) / 1.0e6;  // float 的 0.3 显示为 0.3 而不是 0.30000001
+            }
+        }
+        object["dropoutRate"] = rate;
+        return object;
+    }
+    if (op == "Flatten") return layer("Flatten", 0);
+    return QJsonObject();
+}
+
+QVector<OnnxModel::FlowNode> OnnxModel::dataflow(QVector<int>* outputs) const {
+    // 编号：先是图输入，再是各算子；值由产生它的节点提供，initializer 与常量不连边
+    QVector<FlowNode> flow;
+    flow.reserve(m_inputs.size() + m_nodes.size());
+    QVector<int> producer(m_values.size(), -1);
+    for (int value : m_inputs) {
+        FlowNode input;
+        input.op = "input";
+        input.object["name"] = m_values[value];
+        producer[value] = flow.size();
+        flow.append(input);
+    }
+    const int first = flow.size();
+    for (int i = 0; i < m_nodes.size(); ++i) {
+        for (int value : m_nodes[i].outputs) {
+            if (value >= 0) producer[value] = first + i;
+        }
+    }
+    for (int i = 0; i < m_nodes.size(); ++i) {
+        const OnnxNode& node = m_nodes[i];
+        FlowNode entry;
+        entry.object = layerFor(i);
+        const QString activation = activationName(node.opType);
+        if (!entry.object.isEmpty()) {
+            entry.op = "layer";
+        } else if (!activation.isEmpty()) {
+            entry.op = "activation";
+            entry.object["activationFunction"] = activation;
+        } else {
+            entry.op = mergeOp(node.opType);
+            if (entry.op.isEmpty()) entry.op = "op";
+        }
+        if (!entry.object.contains("name")) entry.object["name"] = node.name.isEmpty() ? node.opType : node.name;
+        entry.object["opType"] = node.opType;
+        for (int value : node.inputs) {
+            const int from = value >= 0 ? producer[value] : -1;
+            if (from >= 0 && from != first + i) entry.inputs.append(from);
+        }
+        flow.append(std::move(entry));
+    }
+    QVector<int> graphOutputs;
+    for (int value : m_outputs) {
+        if (producer[value] >= 0) graphOutputs.append(producer[value]);
+    }
+
+    // 激活的唯一数据输入是层、该层只有这一个使用者且还没有激活函数时并入该层（与 PyTorch 导入相同）
+    QVector<int> uses(flow.size(), 0);
+    for (const FlowNode& node : flow) {
+        for (int from : node.inputs) ++uses[from];
+    }
+    for (int output : graphOutputs) ++uses[output];
+    QVector<int> target(flow.size(), -1);
+    for (int i = 0; i < flow.size(); ++i) {
+        const FlowNode& node = flow[i];
+        const int from = node.inputs.size() == 1 ? node.inputs[0] : -1;
+        if (node.op == "activation" && from >= 0 && uses[from] == 1 && flow[from].op == "layer" &&
+            flow[from].object["activationFunction"].toString().isEmpty()) {
+            flow[from].object["activationFunction"] = node.object["activationFunction"];
+            target[i] = from;
+        }
+    }
+    QVector<int> remap(flow.size(), -1);
+    QVector<FlowNode> kept;
+    kept.reserve(flow.size());
+    for (int i = 0; i < flow.size(); ++i) {
+        if (target[i] >= 0) continue;
+        remap[i] = kept.size();
+        kept.append(std::move(flow[i]));
+    }
+    for (int i = 0; i < flow.size(); ++i) {
+        if (target[i] >= 0) remap[i] = remap[target[i]];
+    }
+    for (FlowNode& node : kept) {
+        for (int& input : node.inputs) input = remap[input];
+    }
+    if (outputs) {
+        outputs->clear();
+        for (int output : graphOutputs) outputs->append(remap[output]);
+    }
+    return kept;
+}
+
+QJsonArray OnnxModel::layers() const {
+    QJsonArray result;
+    for (const FlowNode& node : dataflow(nullptr)) {
+        if (node.op != "layer") continue;
+        QJsonObject layer = node.object;
+        layer.remove("opType");
+        result.append(layer);
+    }
+    return result;
+}
+
+QJsonObject OnnxModel::graph() const {
+    QVector<int> outputs;
+    const QVector<FlowNode> flow = dataflow(&outputs);
+    QJsonArray nodeArray;
+    QJsonArray edgeArray;
+    for (int i = 0; i < flow.size(); ++i) {
+        QJsonObject object = flow[i].object;
+        object["id"] = i;
+        object["op"] = flow[i].op;
+        nodeArray.append(object);
+        for (int from : flow[i].inputs) {
+            QJsonObject edge;
+            edge["from"] = from;
+            edge["to"] = i;
+            edgeArray.append(edge);
+        }
+    }
+    QJsonArray outputArray;
+    for (int output : outputs) outputArray.append(output);
+    QJsonObject result;
+    result["nodes"] = nodeArray;
+    result["edges"] = edgeArray;
+    result["outputs"] = outputArray;
+    return result;
+}
@@ -0,0 +1,110 @@
+#ifndef ONNXMODEL_H
+#define ONNXMODEL_H
+
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// ONNX 权重（initializer）：只记录形状与数据在文件中的位置，数据本身不读取
+struct OnnxInitializer
+{
+    QString name;
+    int dataType = 0;          // TensorProto.DataType：1 为 float，10 为 float16，16 为 bfloat16……
+    QVector<qint64> dims;
+    qint64 offset = -1;        // raw_data 相对文件起点的偏移；数据在外部文件时为外部文件中的偏移
+    qint64 byteSize = 0;
+    QString externalLocation;  // data_location = EXTERNAL 时的外部文件名（相对模型文件）
+
+    qint64 elementCount() const;
+};
+
+// 图中的一个算子
+struct OnnxNode
+{
+    QString opType;
+    QString name;
+    QString domain;
+    QVector<int> inputs;   // 值编号（见 OnnxModel::valueName），可选输入缺省时为 -1
+    QVector<int> outputs;
+    QJsonObject attributes;  // 标量与整数列表属性；张量与子图属性只记名称
+};
+
+// 以内存映射方式打开 .onnx 模型，自带 protobuf 线格式解析，不依赖 onnx / protobuf 库。
+// 只顺序扫描一遍：节点逐个解码，initializer 只读头部字段，raw_data 跳过并记下偏移，
+// 因此数 GB 的模型也能在毫秒到秒级打开，额外内存只与节点数有关
+class OnnxModel
+{
+public:
+    OnnxModel() = default;
+    ~OnnxModel();
+    OnnxModel(const OnnxModel&) = delete;
+    OnnxModel& operator=(const OnnxModel&) = delete;
+
+    bool open(const QString& path, QString* error = nullptr);
+    void close();
+
+    bool isOpen() const { return m_data != nullptr; }
+    qint64 fileSize() const { return m_size; }
+    qint64 irVersion() const { return m_irVersion; }
+    qint64 opsetVersion() const { return m_opset; }
+    QString producer() const { return m_producer; }
+    QString graphName() const { return m_graphName; }
+
+    const QVector<OnnxNode>& nodes() const { return m_nodes; }
+    const QVector<OnnxInitializer>& initializers() const { return m_initializers; }
+    int initializerIndex(const QString& name) const { return m_initializerIndex.value(name, -1); }
+    qint64 initializerBytes() const;
+    QString valueName(int value) const { return m_values.value(value); }
+    QVector<int> graphInputs() const { return m_inputs; }    // 不含同名的 initializer
+    QVector<int> graphOutputs() const { return m_outputs; }
+    QStringList warnings() const { return m_warnings; }
+
+    // 第 index 个节点对应的层参数（NeuralLayer::fromJsonObject 可读，另带 "name"）：
+    // Gemm / 带权重的 MatMul 为 Dense，Conv 为 Conv2d，池化、LSTM / GRU / RNN、Dropout、Flatten 各对应一种层；
+    // 其余算子返回空对象
+    QJsonObject layerFor(int index) const;
+
+    // 层节点按图中顺序展开为层列表；紧跟在层之后、且是其唯一使用者的激活并入该层
+    QJsonArray layers() const;
+
+    // 与 PyTorchModel::graph() 相同的结构：
+    // {"nodes": [{"id", "op", "opType", "name", 层参数……}], "edges": [{"from", "to"}], "outputs": [id……]}，
+    // op 为 input / layer / activation / add / concat……，其余算子为 "op"；激活同样并入前一层
+    QJsonObject graph() const;
+
+private:
+    // 图中的数据流节点：先是各图输入，再是各算子；激活并入前一层后重新编号
+    struct FlowNode
+    {
+        QString op;
+        QJsonObject object;
+        QVector<int> inputs;
+    };
+    QVector<FlowNode> dataflow(QVector<int>* outputs) const;
+
+    bool parseModel(QString* error);
+    bool parseGraph(const uchar* begin, const uchar* end, QString* error);
+    int internValue(const uchar* text, int length);
+
+    QFile m_file;
+    const uchar* m_data = nullptr;
+    qint64 m_size = 0;
+    qint64 m_irVersion = 0;
+    qint64 m_opset = 0;
+    QString m_producer;
+    QString m_graphName;
+    QVector<OnnxNode> m_nodes;
+    QVector<OnnxInitializer> m_initializers;
+    QHash<QString, int> m_initializerIndex;
+    QStringList m_values;            // 值编号 → 名称
+    QHash<QString, int> m_valueIndex;
+    QVector<int> m_inputs;
+    QVector<int> m_outputs;
+    QStringList m_warnings;
+};
+
+#endif // ONNXMODEL_H
@@ -1,4 +1,9 @@
 #include "programfragmentprocessor.h"
+#include "codevalidator.h"
+#include "modulerepr.h"
+#include "pytorchparser.h"
+#include <QDateTime>
+#include <QStringList>
 
 
 ProgramFragmentProcessor::ProgramFragmentProcessor() {}
@@ -16,8 +21,21 @@ QJsonObject ProgramFragmentProcessor::processFragment(const QJsonObject& fragmen
         result["validationResult"] = validateCode(code);
     }
     else if (action == "extract-structure") {
-        if (language == "python" && code.contains("torch.nn")) {
-            result["networkStructure"] = extractPyTorchStructure(code);
+        if (language == "python" && looksLikeModuleRepr(code)) {
+            // print(model) 的输出：层参数来自各模块的 repr，嵌套的容器模块作为可折叠的分组
+            const ModuleRepr repr = parseModuleRepr(code);
+            QStringList warnings = repr.warnings;
+            if (!repr.error.isEmpty()) warnings.prepend(repr.error);
+            result["format"] = "module-repr";
+            result["networkStructure"] = repr.layers;
+            result["groups"] = repr.groupsJson();
+            if (!warnings.isEmpty()) result["warnings"] = QJsonArray::fromStringList(warnings);
+        } else if (language == "python" && code.contains("torch")) {
+            QStringList warnings;
+            QJsonObject graph;
+            result["networkStructure"] = extractPyTorchStructure(code, &warnings, &graph);
+            if (!graph.isEmpty()) result["graph"] = graph;
+            if (!warnings.isEmpty()) result["warnings"] = QJsonArray::fromStringList(warnings);
         } else {
             result["error"] = "仅支持解析 PyTorch 代码";
         }
@@ -30,76 +48,25 @@ QJsonObject ProgramFragmentProcessor::processFragment(const QJsonObject& fragmen
 }
 
 
-// 从 PyTorch 代码中提取网络结构
-QJsonArray ProgramFragmentProcessor::extractPyTorchStructure(const QString& code) {
-    QJsonArray layersArray;
-
-    // 提取 nn.Linear 层
-    QRegularExpression linearPattern("nn\\.Linear\\s*\\(\\s*(\\d+)\\s*,\\s*(\\d+)\\s*\\)");
-    QRegularExpressionMatchIterator linearMatches = linearPattern.globalMatch(code);
-
-    while (linearMatches.hasNext()) {
-        QRegularExpressionMatch match = linearMatches.next();
-        int inputSize = match.captured(1).toInt();
-        int outputSize = match.captured(2).toInt();
-
-        QJsonObject layerObj;
-        layerObj["layerType"] = "Dense";
-        layerObj["inputSize"] = inputSize;
-        layerObj["neurons"] = outputSize;
-
-        // 提取激活函数
-        QString activation = extractActivationFunction(code, match.capturedStart());
-        layerObj["activationFunction"] = activation;
-
-        layersArray.append(layerObj);
+// 从 PyTorch 代码中提取网络结构：单遍词法分析后解释 __init__ 中的模块注册，
+// 层按 PyTorch 的注册顺序输出，不再按类型分别匹配；激活函数与分支、跳连来自 forward() 的数据流
+QJsonArray ProgramFragmentProcessor::extractPyTorchStructure(const QString& code, QStringList* warnings,
+                                                             QJsonObject* graph) {
+    const PyTorchModel model = parsePyTorchModel(code);
+    if (warnings) {
+        *warnings = model.warnings;
+        if (!model.error.isEmpty()) warnings->prepend(model.error);
     }
-
-    // 提取 Conv2d 层
-    QRegularExpression convPattern("nn\\.Conv2d\\s*\\(\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*kernel_size\\s*=\\s*(\\d+)");
-    QRegularExpressionMatchIterator convMatches = convPattern.globalMatch(code);
-
-    while (convMatches.hasNext()) {
-        QRegularExpressionMatch match = convMatches.next();
-        int inChannels = match.captured(1).toInt();
-        int outChannels = match.captured(2).toInt();
-        int kernelSize = match.captured(3).toInt();
-
-        QJsonObject layerObj;
-        layerObj["layerType"] = "Conv2d";
-        layerObj["inputSize"] = inChannels;  // 简化处理
-        layerObj["neurons"] = outChannels;  // 简化处理
-        layerObj["kernelSize"] = kernelSize;
-
-        // 提取激活函数
-        QString activation = extractActivationFunction(code, match.capturedStart());
-        layerObj["activationFunction"] = activation;
-
-        layersArray.append(layerObj);
-    }
-
-    return layersArray;
+    if (graph) *graph = model.nodes.isEmpty() ? QJsonObject() : model.graph();
+    return model.layers();
 }
 
-// 从代码中提取激活函数
-QString ProgramFragmentProcessor::extractActivationFunction(const QString& code, int startPos) {
-    QString snippet = code.mid(startPos, 200);
-
-    if (snippet.contains("nn.ReLU") || snippet.contains("F.relu")) return "relu";
-    if (snippet.contains("nn.Sigmoid") || snippet.contains("F.sigmoid")) return "sigmoid";
-    if (snippet.contains("nn.Softmax") || snippet.contains("F.softmax")) return "softmax";
-    if (snippet.contains("nn.Tanh") || snippet.contains("F.tanh")) return "tanh";
-
-    return "";
-}
-
-// 简单的代码验证
+// 代码验证：与编辑器中的增量校验（AsyncCodeValidator）共用同一套规则，这里一次检查全文
 QJsonObject ProgramFragmentProcessor::validateCode(const QString& code) {
     QJsonObject validationResult;
     validationResult["valid"] = true;
     QJsonArray errors;
 
-    // 1. 基本语法检查
     if (code.trimmed().isEmpty()) {
         errors.append("代码不能为空");
         validationResult["valid"] = false;
@@ -107,61 +74,14 @@ QJsonObject ProgramFragmentProcessor::validateCode(const QString& code) {
         return validationResult;
     }
 
-    // 2. 检查Python缩进错误 (简单检查：每行缩进必须是4的倍数)
-    QStringList lines = code.split('\n');
-    QRegularExpression indentRegex("^(\\s*)");
-
-    for (int i = 0; i < lines.size(); i++) {
-        QString line = lines[i].trimmed();
-        if (line.isEmpty() || line.startsWith("#")) continue; // 跳过空行和注释
-
-        // 获取当前行的缩进空格数
-        QRegularExpressionMatch match = indentRegex.match(lines[i]);
-        int indent = match.captured(1).length();
-
-        // 检查缩进是否是4的倍数
-        if (indent % 4 != 0) {
-            errors.append(QString("第 %1 行：缩进必须是4个空格的倍数").arg(i + 1));
-            validationResult["valid"] = false;
-        }
-
-        // 简单的缩进层次检查
-        if (line.endsWith(":")) {
-            // 冒号行后应该增加缩进
-            if (i + 1 < lines.size()) {
-                QRegularExpressionMatch nextMatch = indentRegex.match(lines[i + 1]);
-                int nextIndent = nextMatch.captured(1).length();
-                if (nextIndent <= indent) {
-                    errors.append(QString("第 %1 行：冒号后需要增加缩进").arg(i + 1));
-                    validationResult["valid"] = false;
-                }
-            }
-        }
-    }
-
-    // 3. 检查常见的PyTorch相关错误
-    if (code.contains("nn.") || code.contains("torch.")) {
-        // 检查常见的PyTorch模块引用错误
-        if (!code.contains("import torch") && !code.contains("import torch.nn")) {
-            errors.append("使用PyTorch模块但未导入torch或torch.nn");
-            validationResult["valid"] = false;
-        }
-
-        // 检查常见的层定义错误
-        QRegularExpression layerRegex("self\\.(conv|fc|pool|lstm|gru|rnn)\\d+\\s*=\\s*nn\\.");
-        QRegularExpressionMatchIterator it = layerRegex.globalMatch(code);
-        while (it.hasNext()) {
-            QRegularExpressionMatch match = it.next();
-            QString layerDef = match.captured(0);
-
-            // 检查是否缺少括号
-            if (!layerDef.contains("(") || !layerDef.contains(")")) {
-                errors.append("层定义语法错误：缺少括号");
-                validationResult["valid"] = false;
-            }
-        }
-    }
+    // 缩进与冒号后的代码块、字符串与括号是否闭合、使用 PyTorch 时是否导入
+    IncrementalValidator validator;
+    validator.setText(code);
+    validator.revalidate();
+    for (const CodeDiagnostic& diagnostic : validator.diagnostics())
+        errors.append(diagnostic.text());
 
+    validationResult["valid"] = errors.isEmpty();
     validationResult["errors"] = errors;
     return validationResult;
 }
@@ -3,6 +3,7 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QString>
+#include <QStringList>
 
 
 // 程序片段处理器 - 专注于 PyTorch 解析
@@ -11,17 +12,16 @@ public:
 
     ProgramFragmentProcessor();
 
-    // 从 PyTorch 代码中提取网络结构
+    // 从 PyTorch 代码中提取网络结构；也接受 print(model) 的输出（见 parseModuleRepr），这时另带 "groups"
     static QJsonObject processFragment(const QJsonObject& fragmentObj);
 
-    // 简单的代码验证
+    // 一次检查全文的代码验证（规则见 IncrementalValidator；编辑器中边输入边检查用 AsyncCodeValidator）
     static QJsonObject validateCode(const QString& code) ;
 
-    // 从代码中提取激活函数
-    static QString extractActivationFunction(const QString& code, int startPos);
-
-    // 从 PyTorch 代码中提取网络结构
-    static QJsonArray extractPyTorchStructure(const QString& code) ;
+    // 从 PyTorch 代码中提取网络结构（见 parsePyTorchModel），warnings 返回跳过的模块与无法解析的语句，
+    // graph 返回 forward() 的数据流图（见 PyTorchModel::graph），没有可追踪的 forward() 时为空
+    static QJsonArray extractPyTorchStructure(const QString& code, QStringList* warnings = nullptr,
+                                              QJsonObject* graph = nullptr);
 };
 
 
@@ -0,0 +1,611 @@
+#include "projection.h"
+#include "dataset.h"
+#include "gemm.h"
+#include "inferenceengine.h"
+#include "simdutils.h"
+#include "threadpool.h"
+#include "weightcheckpoint.h"
+#include <QGraphicsSceneHoverEvent>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+
+namespace {
+
+// 平移、转置时每个并行块负责的列数
+constexpr int kColumnBlock = 64;
+// 光栅化的行带高度：一个点最多落在相邻两个行带里
+constexpr int kBandRows = 16;
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+#if NNV_HAVE_AVX2
+// shiftChunk 行主序分支的 AVX2 部分：处理 [j, j1) 中 8 的倍数列，返回下一列
+NNV_AVX2 int shiftRowAvx2(const float* src, const float* shift, float* dst, int j, int j1, double* sum,
+                          double* sumSquares) {
+    for (; j + 8 <= j1; j += 8) {
+        const __m256 v = _mm256_sub_ps(_mm256_loadu_ps(src + j), _mm256_loadu_ps(shift + j));
+        _mm256_storeu_ps(dst + j, v);
+        if (!sum) continue;
+        const __m256d lo = _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+        const __m256d hi = _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+        _mm256_storeu_pd(sum + j, _mm256_add_pd(_mm256_loadu_pd(sum + j), lo));
+        _mm256_storeu_pd(sum + j + 4, _mm256_add_pd(_mm256_loadu_pd(sum + j + 4), hi));
+        _mm256_storeu_pd(sumSquares + j, _mm256_fmadd_pd(lo, lo, _mm256_loadu_pd(sumSquares + j)));
+        _mm256_storeu_pd(sumSquares + j + 4, _mm256_fmadd_pd(hi, hi, _mm256_loadu_pd(sumSquares + j + 4)));
+    }
+    return j;
+}
+#endif
+
+// out[r][j] = y[r][j] − shift[j]（row-major）或 outT[j][r]（转置，供 YᵀY 使用），
+// sum / sumSquares 非空时按列累加平移后的和与平方和；按列块并行，各线程只写自己的列
+void shiftChunk(const float* y, int rows, int dim, const float* shift, float* out, float* outT, double* sum,
+                double* sumSquares, ThreadPool& pool) {
+    const int blocks = (dim + kColumnBlock - 1) / kColumnBlock;
+    pool.parallelFor(0, blocks, 1, [&](int first, int last) {
+        for (int b = first; b < last; ++b) {
+            const int j0 = b * kColumnBlock;
+            const int j1 = std::min(dim, j0 + kColumnBlock);
+            if (outT) {
+                for (int j = j0; j < j1; ++j) {
+                    const float s = shift[j];
+                    float* dst = outT + qint64(j) * rows;
+                    double total = 0.0;
+                    double squares = 0.0;
+                    for (int r = 0; r < rows; ++r) {
+                        const float v = y[qint64(r) * dim + j] - s;
+                        dst[r] = v;
+                        total += v;
+                        squares += double(v) * v;
+                    }
+                    if (sum) {
+                        sum[j] += total;
+                        sumSquares[j] += squares;
+                    }
+                }
+                continue;
+            }
+            for (int r = 0; r < rows; ++r) {
+                const float* src = y + qint64(r) * dim;
+                float* dst = out + qint64(r) * dim;
+                int j = j0;
+#if NNV_HAVE_AVX2
+                if (simd::hasAvx2()) j = shiftRowAvx2(src, shift, dst, j, j1, sum, sumSquares);
+#endif
+                for (; j < j1; ++j) {
+                    const float v = src[j] - shift[j];
+                    dst[j] = v;
+                    if (sum) {
+                        sum[j] += v;
+                        sumSquares[j] += double(v) * v;
+                    }
+                }
+            }
+        }
+    });
+}
+
+double dot(const float* a, const float* b, int n) {
+    double total = 0.0;
+    for (int i = 0; i < n; ++i) total += double(a[i]) * b[i];
+    return total;
+}
+
+void fillGaussian(float* v, int n, std::mt19937& rng) {
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    for (int i = 0; i < n; ++i) v[i] = normal(rng);
+}
+
+// 对 l 行 dim 维向量做两遍修正 Gram-Schmidt；某行与前面线性相关（范数塌缩）时换成随机向量重新正交化
+void orthonormalizeRows(std::vector<float>& q, int l, int dim, std::mt19937& rng) {
+    for (int i = 0; i < l; ++i) {
+        float* v = q.data() + qint64(i) * dim;
+        for (int attempt = 0; attempt < 4; ++attempt) {
+            const double before = std::sqrt(dot(v, v, dim));
+            for (int pass = 0; pass < 2; ++pass) {
+                for (int j = 0; j < i; ++j) {
+                    const float* u = q.data() + qint64(j) * dim;
+                    const float c = static_cast<float>(dot(u, v, dim));
+                    for (int t = 0; t < dim; ++t) v[t] -= c * u[t];
+                }
+            }
+            const double norm = std::sqrt(dot(v, v, dim));
+            if (norm > 1e-6 * before && norm > 0.0) {
+                const float inv = static_cast<float>(1.0 / norm);
+                for (int t = 0; t < dim; ++t) v[t] *= inv;
+                break;
+            }
+            fillGaussian(v, dim, rng);
+        }
+    }
+}
+
+// 对称矩阵 a（n×n，会被破坏）的循环 Jacobi 特征分解，特征值从大到小，vectors 的第 i 列对应 values[i]
+void symmetricEigen(std::vector<double>& a, int n, std::vector<double>& values, std::vector<double>& vectors) {
+    std::vector<double> v(static_cast<std::size_t>(n) * n, 0.0);
+    for (int i = 0; i < n; ++i) v[qint64(i) * n + i] = 1.0;
+    for (int sweep = 0; sweep < 64; ++sweep) {
+        double off = 0.0;
+        double diag = 0.0;
+        for (int i = 0; i < n; ++i) {
+            diag += a[qint64(i) * n + i] * a[qint64(i) * n + i];
+            for (int j = i + 1; j < n; ++j) off += a[qint64(i) * n + j] * a[qint64(i) * n + j];
+        }
+        if (off <= 1e-30 * diag || off == 0.0) break;
+        for (int p = 0; p < n; ++p) {
+            for (int q = p + 1; q < n; ++q) {
+                const double apq = a[qint64(p) * n + q];
+                if (apq == 0.0) continue;
+                const double theta = (a[qint64(q) * n + q] - a[qint64(p) * n + p]) / (2.0 * apq);
+                const double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+                const double c = 1.0 / std::sqrt(t * t + 1.0);
+                const double s = t * c;
+                for (int k = 0; k < n; ++k) {
+                    const double akp = a[qint64(k) * n + p];
+                    const double akq = a[qint64(k) * n + q];
+                    a[qint64(k) * n + p] = c * akp - s * akq;
+                    a[qint64(k) * n + q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < n; ++k) {
+                    const double apk = a[qint64(p) * n + k];
+                    const double aqk = a[qint64(q) * n + k];
+                    a[qint64(p) * n + k] = c * apk - s * aqk;
+                    a[qint64(q) * n + k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < n; ++k) {
+                    const double vkp = v[qint64(k) * n + p];
+                    const double vkq = v[qint64(k) * n + q];
+                    v[qint64(k) * n + p] = c * vkp - s * vkq;
+                    v[qint64(k) * n + q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+    std::vector<int> order(n);
+    for (int i = 0; i < n; ++i) order[i] = i;
+    std::sort(order.begin(), order.end(),
+              [&](int x, int y) { return a[qint64(x) * n + x] > a[qint64(y) * n + y]; });
+    values.resize(n);
+    vectors.assign(static_cast<std::size_t>(n) * n, 0.0);
+    for (int i = 0; i < n; ++i) {
+        values[i] = a[qint64(order[i]) * n + order[i]];
+        for (int k = 0; k < n; ++k) vectors[qint64(k) * n + i] = v[qint64(k) * n + order[i]];
+    }
+}
+
+} // namespace
+
+PcaResult computePca(const PcaSource& source, const PcaConfig& config, ThreadPool* pool) {
+    PcaResult result;
+    ThreadPool& threads = pool ? *pool : ThreadPool::global();
+    const qint64 n = source.count;
+    const int dim = source.dim;
+    if (!source.fetch || n < 2 || dim < 1) {
+        result.error = "至少需要 2 个样本";
+        return result;
+    }
+    const int k = std::clamp(config.components, 1, dim);
+    const int l = std::min(dim, k + std::max(0, config.oversample));
+    const int chunk = std::max(1, source.chunk);
+    PcaMethod method = config.method;
+    if (method == PcaMethod::Auto) method = dim <= config.covarianceLimit ? PcaMethod::Covariance : PcaMethod::Randomized;
+    const bool covariance = method == PcaMethod::Covariance;
+
+    std::vector<float> shift(dim, 0.0f);
+    std::vector<double> sum(dim, 0.0);
+    std::vector<double> sumSquares(dim, 0.0);
+    std::vector<float> shifted(covariance ? 0 : static_cast<std::size_t>(chunk) * dim);
+    std::vector<float> transposed(covariance ? static_cast<std::size_t>(chunk) * dim : 0);
+    std::vector<float> gram(covariance ? static_cast<std::size_t>(dim) * dim : 0);
+    std::vector<float> t(static_cast<std::size_t>(chunk) * l);
+    std::vector<float> tT(static_cast<std::size_t>(chunk) * l);
+    std::vector<float> q(static_cast<std::size_t>(l) * dim);
+    std::vector<float> z(static_cast<std::size_t>(l) * dim);
+    std::mt19937 rng(config.seed);
+    fillGaussian(q.data(), static_cast<int>(q.size()), rng);
+    orthonormalizeRows(q, l, dim, rng);
+
+    // 平移后的均值 μ'，之后的协方差 C = (Σ y'y'ᵀ − n μ'μ'ᵀ) / (n − 1)
+    std::vector<double> meanShifted(dim, 0.0);
+
+    // 读一遍数据：第一遍同时统计均值（Covariance 累加 Y'ᵀY'），之后每遍得到 Z = Q·C（Randomized）
+    auto streamPass = [&](bool first) {
+        for (qint64 row = 0; row < n; row += chunk) {
+            const int rows = static_cast<int>(std::min<qint64>(chunk, n - row));
+            const float* y = source.fetch(row, rows);
+            if (first && row == 0) {
+                // 平移量取第一块的均值
+                for (int j = 0; j < dim; ++j) {
+                    double total = 0.0;
+                    for (int r = 0; r < rows; ++r) total += y[qint64(r) * dim + j];
+                    shift[j] = static_cast<float>(total / rows);
+                }
+            }
+            double* s = first ? sum.data() : nullptr;
+            double* s2 = first ? sumSquares.data() : nullptr;
+            if (covariance) {
+                // Y'ᵀY' = Yt · Ytᵀ，Yt 为 dim×rows
+                shiftChunk(y, rows, dim, shift.data(), nullptr, transposed.data(), s, s2, threads);
+                sgemm(dim, dim, rows, transposed.data(), rows, transposed.data(), rows, true, gram.data(), dim, row > 0,
+                      &threads);
+                continue;
+            }
+            // T = Y'·Qᵀ（rows×l），Z += Tᵀ·Y'（l×dim）
+            shiftChunk(y, rows, dim, shift.data(), shifted.data(), nullptr, s, s2, threads);
+            sgemm(rows, l, dim, shifted.data(), dim, q.data(), dim, true, t.data(), l, false, &threads);
+            for (int r = 0; r < rows; ++r) {
+                for (int c = 0; c < l; ++c) tT[qint64(c) * rows + r] = t[qint64(r) * l + c];
+            }
+            sgemm(l, dim, rows, tT.data(), rows, shifted.data(), dim, false, z.data(), dim, row > 0, &threads);
+        }
+        ++result.passes;
+        if (first) {
+            result.totalVariance = 0.0;
+            for (int j = 0; j < dim; ++j) {
+                meanShifted[j] = sum[j] / n;
+                result.totalVariance += std::max(0.0, sumSquares[j] - n * meanShifted[j] * meanShifted[j]) / (n - 1);
+            }
+        }
+        if (covariance) return;
+        // 减去均值项：Z −= n (Qμ') μ'ᵀ，再除以 n − 1
+        for (int c = 0; c < l; ++c) {
+            const float* qc = q.data() + qint64(c) * dim;
+            double projected = 0.0;
+            for (int j = 0; j < dim; ++j) projected += qc[j] * meanShifted[j];
+            float* zc = z.data() + qint64(c) * dim;
+            for (int j = 0; j < dim; ++j) zc[j] = static_cast<float>((zc[j] - n * projected * meanShifted[j]) / (n - 1));
+        }
+    };
+
+    streamPass(true);
+    if (covariance) {
+        threads.parallelFor(0, dim, std::max(1, 65536 / dim), [&](int first, int last) {
+            for (int i = first; i < last; ++i) {
+                float* g = gram.data() + qint64(i) * dim;
+                for (int j = 0; j < dim; ++j) g[j] = static_cast<float>((g[j] - n * meanShifted[i] * meanShifted[j]) / (n - 1));
+            }
+        });
+    }
+
+    // Rayleigh-Ritz：B = Q·Zᵀ = Q C Qᵀ 的特征向量 U 把 Q 旋转成 Ritz 向量；前 k 个的残差 ‖Cv − λv‖ 都不超过
+    // tolerance·λ₁ 时收敛（Z 的第 c 行就是 C q_c，残差不需要再乘一次 C）
+    std::vector<double> b(static_cast<std::size_t>(l) * l);
+    std::vector<double> values;
+    std::vector<double> vectors;
+    std::vector<double> residual(dim);
+    auto rayleighRitz = [&]() {
+        for (int i = 0; i < l; ++i) {
+            for (int j = i; j < l; ++j) {
+                const double v = 0.5 * (dot(q.data() + qint64(i) * dim, z.data() + qint64(j) * dim, dim) +
+                                        dot(q.data() + qint64(j) * dim, z.data() + qint64(i) * dim, dim));
+                b[qint64(i) * l + j] = v;
+                b[qint64(j) * l + i] = v;
+            }
+        }
+        symmetricEigen(b, l, values, vectors);
+        double worst = 0.0;
+        for (int i = 0; i < k; ++i) {
+            std::fill(residual.begin(), residual.end(), 0.0);
+            for (int c = 0; c < l; ++c) {
+                const double u = vectors[qint64(c) * l + i];
+                const float* zc = z.data() + qint64(c) * dim;
+                const float* qc = q.data() + qint64(c) * dim;
+                for (int j = 0; j < dim; ++j) residual[j] += u * (zc[j] - values[i] * qc[j]);
+            }
+            double norm = 0.0;
+            for (int j = 0; j < dim; ++j) norm += residual[j] * residual[j];
+            worst = std::max(worst, std::sqrt(norm));
+        }
+        return worst <= config.tolerance * std::max(0.0, values[0]);
+    };
+
+    if (covariance) {
+        for (int it = 0; it < std::max(1, config.maxIterations); ++it) {
+            // C 对称，Q·C 的每一行即 C q_c；最后一次不再旋转，使 Ritz 向量与 Q 对应
+            sgemm(l, dim, dim, q.data(), dim, gram.data(), dim, false, z.data(), dim, false, &threads);
+            ++result.iterations;
+            if (rayleighRitz() || it + 1 >= config.maxIterations) break;
+            q.swap(z);
+            orthonormalizeRows(q, l, dim, rng);
+        }
+    } else {
+        ++result.iterations;
+        for (int it = 0; !rayleighRitz() && it < config.powerIterations; ++it) {
+            q.swap(z);
+            orthonormalizeRows(q, l, dim, rng);
+            streamPass(false);
+            ++result.iterations;
+        }
+    }
+
+    result.method = method;
+    result.count = n;
+    result.dim = dim;
+    result.components = k;
+    result.mean.resize(dim);
+    for (int j = 0; j < dim; ++j) result.mean[j] = static_cast<float>(shift[j] + meanShifted[j]);
+    result.axes.assign(static_cast<std::size_t>(k) * dim, 0.0f);
+    result.variance.resize(k);
+    for (int i = 0; i < k; ++i) {
+        float* axis = result.axes.data() + qint64(i) * dim;
+        std::vector<double> v(dim, 0.0);
+        for (int c = 0; c < l; ++c) {
+            const double u = vectors[qint64(c) * l + i];
+            const float* qc = q.data() + qint64(c) * dim;
+            for (int j = 0; j < dim; ++j) v[j] += u * qc[j];
+        }
+        // 符号约定：绝对值最大的分量为正，同一数据多次计算得到同样朝向的散点图
+        int largest = 0;
+        for (int j = 1; j < dim; ++j) {
+            if (std::fabs(v[j]) > std::fabs(v[largest])) largest = j;
+        }
+        const double sign = v[largest] < 0.0 ? -1.0 : 1.0;
+        for (int j = 0; j < dim; ++j) axis[j] = static_cast<float>(sign * v[j]);
+        result.variance[i] = std::max(0.0, values[i]);
+    }
+    result.valid = true;
+    return result;
+}
+
+void projectPca(const PcaResult& pca, const float* x, int n, float* out, ThreadPool* pool) {
+    if (!pca.valid || n <= 0) return;
+    const int k = pca.components;
+    sgemm(n, k, pca.dim, x, pca.dim, pca.axes.data(), pca.dim, true, out, k, false, pool);
+    std::vector<float> offset(k);
+    for (int c = 0; c < k; ++c) offset[c] = static_cast<float>(dot(pca.mean.data(), pca.axes.data() + qint64(c) * pca.dim, pca.dim));
+    for (int r = 0; r < n; ++r) {
+        for (int c = 0; c < k; ++c) out[qint64(r) * k + c] -= offset[c];
+    }
+}
+
+QString ProjectionResult::summary() const {
+    if (!valid) return "投影失败：" + error;
+    QString text = QString("第 %1 层 %2（%3 维，%4）：%5 个样本，%6，PCA 读数据 %7 遍")
+                       .arg(layer + 1)
+                       .arg(layerType)
+                       .arg(pca.dim)
+                       .arg(source.isEmpty() ? QString("随机初始化") : source)
+                       .arg(count())
+                       .arg(pca.method == PcaMethod::Covariance ? QString("协方差 + 子空间迭代 %1 次").arg(pca.iterations)
+                                                                : QString("随机化 SVD"))
+                       .arg(pca.passes);
+    for (int c = 0; c < pca.components; ++c) {
+        text += QString("\nPC%1：方差 %2，解释 %3%").arg(c + 1).arg(pca.variance[c], 0, 'g', 5)
+                    .arg(pca.explainedRatio(c) * 100.0, 0, 'f', 2);
+    }
+    text += QString("\n前向 %1 ms，总耗时 %2 ms").arg(forwardMs, 0, 'f', 1).arg(totalMs, 0, 'f', 1);
+    return text;
+}
+
+ProjectionResult projectLayerActivations(const QList<NeuralLayer>& layers, int layer, const Dataset& dataset,
+                                         qint64 maxSamples, const PcaConfig& config,
+                                         const std::shared_ptr<WeightCheckpoint>& checkpoint, int chunk) {
+    const auto start = std::chrono::steady_clock::now();
+    ProjectionResult result;
+    result.layer = layer;
+    chunk = std::max(1, chunk);
+    if (!dataset.isOpen()) {
+        result.error = "未打开数据集";
+        return result;
+    }
+    InferenceEngine engine;
+    if (!engine.build(layers, chunk, &result.error)) return result;
+    engine.initializeWeights();
+    QStringList sources;
+    if (checkpoint && checkpoint->isOpen()) {
+        loadCheckpointWeights(*checkpoint, bindCheckpoint(*checkpoint, layers), engine, &sources);
+    }
+    if (layer < 0 || layer >= engine.layerCount()) {
+        result.error = QString("层号 %1 超出范围").arg(layer + 1);
+        return result;
+    }
+    const int inputSize = engine.inputShape().size();
+    if (dataset.sampleSize() != inputSize) {
+        result.error = QString("数据集每个样本 %1 维，网络输入为 %2 维").arg(dataset.sampleSize()).arg(inputSize);
+        return result;
+    }
+    const qint64 n = maxSamples > 0 ? std::min(dataset.count(), maxSamples) : dataset.count();
+    result.layerType = engine.layerInfo(layer).layerType;
+    result.source = layer < sources.size() ? sources[layer] : QString();
+
+    std::vector<qint64> indices(chunk);
+    std::vector<float> inputs;
+    PcaSource source;
+    source.count = n;
+    source.dim = engine.layerInfo(layer).out.size();
+    source.chunk = chunk;
+    source.fetch = [&](qint64 first, int rows) {
+        const float* x = dataset.contiguous(first, rows);
+        if (!x) {
+            inputs.resize(static_cast<std::size_t>(chunk) * inputSize);
+            for (int i = 0; i < rows; ++i) indices[i] = first + i;
+            dataset.gather(indices.data(), rows, inputs.data());
+            x = inputs.data();
+        }
+        const auto forwardStart = std::chrono::steady_clock::now();
+        engine.forward(x, rows);
+        result.forwardMs += elapsedMs(forwardStart);
+        return engine.layerOutput(layer);
+    };
+
+    PcaConfig pcaConfig = config;
+    pcaConfig.components = std::max(2, config.components);
+    result.pca = computePca(source, pcaConfig, nullptr);
+    if (!result.pca.valid) {
+        result.error = result.pca.error;
+        return result;
+    }
+
+    // 再前向一遍，投影到前两个主轴（只有 1 维时纵轴为 0）
+    const int k = result.pca.components;
+    std::vector<float> projected(static_cast<std::size_t>(chunk) * k);
+    result.points.assign(static_cast<std::size_t>(n) * 2, 0.0f);
+    result.labels.assign(static_cast<std::size_t>(n), -1);
+    for (qint64 row = 0; row < n; row += chunk) {
+        const int rows = static_cast<int>(std::min<qint64>(chunk, n - row));
+        projectPca(result.pca, source.fetch(row, rows), rows, projected.data());
+        for (int r = 0; r < rows; ++r) {
+            result.points[(row + r) * 2] = projected[qint64(r) * k];
+            if (k > 1) result.points[(row + r) * 2 + 1] = projected[qint64(r) * k + 1];
+            if (dataset.hasLabels()) result.labels[row + r] = dataset.label(row + r);
+        }
+    }
+    result.totalMs = elapsedMs(start);
+    result.valid = true;
+    return result;
+}
+
+QRgb scatterColor(int label) {
+    static const QRgb kPalette[] = {qRgb(31, 119, 180), qRgb(255, 127, 14), qRgb(44, 160, 44),  qRgb(214, 39, 40),
+                                    qRgb(148, 103, 189), qRgb(140, 86, 75), qRgb(227, 119, 194), qRgb(127, 127, 127),
+                                    qRgb(188, 189, 34), qRgb(23, 190, 207)};
+    if (label < 0) return qRgb(150, 150, 150);
+    return kPalette[label % 10];
+}
+
+void renderScatterImage(const float* points, const int* labels, qint64 n, const QRectF& bounds, int radius,
+                        QRgb background, QImage& image, ThreadPool* pool) {
+    if (image.isNull()) return;
+    ThreadPool& threads = pool ? *pool : ThreadPool::global();
+    const int width = image.width();
+    const int height = image.height();
+    const int bands = (height + kBandRows - 1) / kBandRows;
+    radius = std::clamp(radius, 0, kBandRows / 2 - 1);
+    const double sx = bounds.width() > 0.0 ? (width - 1) / bounds.width() : 0.0;
+    const double sy = bounds.height() > 0.0 ? (height - 1) / bounds.height() : 0.0;
+
+    // 像素坐标（纵轴朝上），不在图像内的点记为 -1
+    std::vector<int> pixel(static_cast<std::size_t>(n) * 2);
+    std::vector<int> bandOf(static_cast<std::size_t>(n), -1);
+    const int pointChunks = static_cast<int>((n + 8191) / 8192);
+    threads.parallelFor(0, pointChunks, 1, [&](int first, int last) {
+        for (qint64 i = qint64(first) * 8192; i < std::min(n, qint64(last) * 8192); ++i) {
+            const double x = (points[i * 2] - bounds.left()) * sx;
+            const double y = (bounds.bottom() - points[i * 2 + 1]) * sy;
+            if (!(x > -radius - 1.0 && x < width + radius && y > -radius - 1.0 && y < height + radius)) continue;
+            pixel[i * 2] = static_cast<int>(std::lround(x));
+            pixel[i * 2 + 1] = static_cast<int>(std::lround(y));
+            bandOf[i] = std::clamp(pixel[i * 2 + 1] - radius, 0, height - 1) / kBandRows;
+        }
+    });
+
+    // 计数排序：每个点登记到它覆盖的第一个行带，跨到下一个行带的再登记一次；同一行带内保持原顺序
+    std::vector<int> start(static_cast<std::size_t>(bands) + 1, 0);
+    auto spillsOver = [&](qint64 i) {
+        const int lastRow = std::min(pixel[i * 2 + 1] + radius, height - 1);
+        return bandOf[i] + 1 < bands && lastRow >= (bandOf[i] + 1) * kBandRows;
+    };
+    for (qint64 i = 0; i < n; ++i) {
+        if (bandOf[i] < 0) continue;
+        ++start[bandOf[i] + 1];
+        if (spillsOver(i)) ++start[bandOf[i] + 2];
+    }
+    for (int b = 0; b < bands; ++b) start[b + 1] += start[b];
+    std::vector<int> fill(start.begin(), start.end() - 1);
+    std::vector<qint64> order(static_cast<std::size_t>(start[bands]));
+    for (qint64 i = 0; i < n; ++i) {
+        if (bandOf[i] < 0) continue;
+        order[fill[bandOf[i]]++] = i;
+        if (spillsOver(i)) order[fill[bandOf[i] + 1]++] = i;
+    }
+
+    const int stride = image.bytesPerLine() / 4;
+    QRgb* bits = reinterpret_cast<QRgb*>(image.bits());
+    threads.parallelFor(0, bands, 1, [&](int first, int last) {
+        for (int b = first; b < last; ++b) {
+            const int top = b * kBandRows;
+            const int bottom = std::min(height, top + kBandRows);
+            for (int row = top; row < bottom; ++row) std::fill(bits + qint64(row) * stride, bits + qint64(row) * stride + width, background);
+            for (int e = start[b]; e < start[b + 1]; ++e) {
+                const qint64 i = order[e];
+                const QRgb color = scatterColor(labels ? labels[i] : -1);
+                const int x0 = std::max(0, pixel[i * 2] - radius);
+                const int x1 = std::min(width - 1, pixel[i * 2] + radius);
+                const int y0 = std::max(top, pixel[i * 2 + 1] - radius);
+                const int y1 = std::min(bottom - 1, pixel[i * 2 + 1] + radius);
+                for (int y = y0; y <= y1; ++y) std::fill(bits + qint64(y) * stride + x0, bits + qint64(y) * stride + x1 + 1, color);
+            }
+        }
+    });
+}
+
+ScatterPlotItem::ScatterPlotItem(const QRectF& rect, QGraphicsItem* parent)
+    : QGraphicsItem(parent), m_rect(rect), m_bounds(-1.0, -1.0, 2.0, 2.0), m_background(qRgb(255, 255, 255)) {
+    setAcceptHoverEvents(true);
+}
+
+void ScatterPlotItem::setPoints(std::vector<float> points, std::vector<int> labels) {
+    m_points = std::move(points);
+    m_labels = std::move(labels);
+    m_labels.resize(m_points.size() / 2, -1);
+    float xMin = std::numeric_limits<float>::infinity();
+    float yMin = xMin;
+    float xMax = -xMin;
+    float yMax = -xMin;
+    for (std::size_t i = 0; i + 1 < m_points.size(); i += 2) {
+        if (!std::isfinite(m_points[i]) || !std::isfinite(m_points[i + 1])) continue;
+        xMin = std::min(xMin, m_points[i]);
+        xMax = std::max(xMax, m_points[i]);
+        yMin = std::min(yMin, m_points[i + 1]);
+        yMax = std::max(yMax, m_points[i + 1]);
+    }
+    if (xMin > xMax) xMin = xMax = yMin = yMax = 0.0f;
+    const double w = std::max(1e-6, double(xMax) - xMin);
+    const double h = std::max(1e-6, double(yMax) - yMin);
+    m_bounds = QRectF(xMin - 0.03 * w, yMin - 0.03 * h, w * 1.06, h * 1.06);
+    m_dirty = true;
+    update();
+}
+
+void ScatterPlotItem::setBackground(QRgb color) {
+    m_background = color;
+    m_dirty = true;
+    update();
+}
+
+void ScatterPlotItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) {
+    Q_UNUSED(widget);
+    // 按屏幕上的实际像素数光栅化，缩放后尺寸变化才重画
+    const double detail = option->levelOfDetailFromTransform(painter->worldTransform());
+    const int width = std::clamp(static_cast<int>(std::ceil(m_rect.width() * detail)), 1, 8192);
+    const int height = std::clamp(static_cast<int>(std::ceil(m_rect.height() * detail)), 1, 8192);
+    if (m_dirty || m_image.width() != width || m_image.height() != height) {
+        if (m_image.width() != width || m_image.height() != height) m_image = QImage(width, height, QImage::Format_ARGB32);
+        renderScatterImage(m_points.data(), m_labels.data(), count(), m_bounds, 1, m_background, m_image);
+        m_dirty = false;
+    }
+    painter->drawImage(m_rect, m_image);
+}
+
+void ScatterPlotItem::hoverMoveEvent(QGraphicsSceneHoverEvent* event) {
+    if (m_points.empty()) return;
+    // 在条目坐标下找最近的点，超过 6 个单位视为没有指向任何点
+    const QPointF p = event->pos();
+    const double sx = m_rect.width() / m_bounds.width();
+    const double sy = m_rect.height() / m_bounds.height();
+    double best = 36.0;
+    qint64 nearest = -1;
+    for (qint64 i = 0; i < count(); ++i) {
+        const double dx = m_rect.left() + (m_points[i * 2] - m_bounds.left()) * sx - p.x();
+        const double dy = m_rect.top() + (m_bounds.bottom() - m_points[i * 2 + 1]) * sy - p.y();
+        const double d = dx * dx + dy * dy;
+        if (d < best) {
+            best = d;
+            nearest = i;
+        }
+    }
+    if (nearest < 0) {
+        setToolTip(QString());
+        return;
+    }
+    QString text = QString("样本 %1").arg(nearest);
+    if (m_labels[nearest] >= 0) text += QString("  类别 %1").arg(m_labels[nearest]);
+    setToolTip(text + QString("\n(%1, %2)").arg(m_points[nearest * 2], 0, 'g', 5).arg(m_points[nearest * 2 + 1], 0, 'g', 5));
+}
@@ -0,0 +1,134 @@
+#ifndef PROJECTION_H
+#define PROJECTION_H
+
+#include <QGraphicsItem>
+#include <QImage>
+#include <QList>
+#include <QRectF>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "backend.h"
+
+class Dataset;
+class ThreadPool;
+class WeightCheckpoint;
+
+// 按块读取的样本矩阵（count 行 dim 列）：fetch(first, n) 返回 [first, first + n) 行的连续数据，
+// 指针在下一次 fetch 前有效；PCA 按块顺序多遍读取，不保存整个矩阵
+struct PcaSource
+{
+    qint64 count = 0;
+    int dim = 0;
+    int chunk = 256;  // 每次 fetch 的行数上限
+    std::function<const float*(qint64 first, int n)> fetch;
+};
+
+// Covariance：一遍读入累加 dim×dim 协方差，之后在内存中做子空间迭代，再读一遍也不需要；
+// Randomized：每遍流式计算 C·Q（Q 为 components + oversample 个正交向量），只保存 dim×(k + p)，适合维数很大的层；
+// Auto：dim <= covarianceLimit 时用 Covariance
+enum class PcaMethod { Auto, Covariance, Randomized };
+
+struct PcaConfig
+{
+    PcaMethod method = PcaMethod::Auto;
+    int components = 2;
+    int oversample = 8;
+    int powerIterations = 3;     // Randomized 在第一遍之后最多再读几遍
+    int maxIterations = 200;     // Covariance 子空间迭代上限
+    double tolerance = 1e-6;     // 前 components 个 Ritz 值的相对变化低于它时停止
+    int covarianceLimit = 512;
+    quint32 seed = 1;
+};
+
+struct PcaResult
+{
+    bool valid = false;
+    QString error;
+    PcaMethod method = PcaMethod::Auto;  // 实际使用的方法
+    qint64 count = 0;
+    int dim = 0;
+    int components = 0;
+    std::vector<float> mean;      // dim
+    std::vector<float> axes;      // components × dim，每行一个单位主轴，按方差从大到小
+    QVector<double> variance;     // 各主轴上的样本方差（协方差矩阵的特征值）
+    double totalVariance = 0.0;   // 协方差矩阵的迹
+    int passes = 0;               // 读了几遍数据
+    int iterations = 0;
+
+    double explainedRatio(int component) const {
+        return totalVariance > 0.0 ? variance[component] / totalVariance : 0.0;
+    }
+};
+
+// 减去均值后的样本协方差前 config.components 个主轴。每块先减去第一块的均值（平移后再累加平方和，
+// 激活整体偏离 0 时不会因相减而丢失精度），Gram 矩阵与 C·Q 都用分块多线程的 sgemm 计算；
+// 内存只与 chunk × dim 和 dim × (k + p)（Covariance 另有 dim × dim）有关，与样本数无关
+PcaResult computePca(const PcaSource& source, const PcaConfig& config, ThreadPool* pool = nullptr);
+
+// out[n × components] = (x − mean) · axesᵀ
+void projectPca(const PcaResult& pca, const float* x, int n, float* out, ThreadPool* pool = nullptr);
+
+struct ProjectionResult
+{
+    bool valid = false;
+    QString error;
+    int layer = -1;
+    QString layerType;
+    QString source;               // 该层权重来源
+    PcaResult pca;
+    std::vector<float> points;    // count × 2
+    std::vector<int> labels;      // count 个，无标签时为 -1
+    double forwardMs = 0.0;       // 全部前向的耗时（PCA 每遍与最后的投影各前向一次）
+    double totalMs = 0.0;
+
+    qint64 count() const { return static_cast<qint64>(points.size() / 2); }
+    QString summary() const;
+};
+
+// 在原生推理引擎上按块前向 dataset 的前 maxSamples 个样本，取第 layer 层输出（卷积层为整个 CHW 特征图）
+// 做 PCA，再前向一遍把每个样本投影到前两个主轴；权重来源同 simulateQuantization
+ProjectionResult projectLayerActivations(const QList<NeuralLayer>& layers, int layer, const Dataset& dataset,
+                                         qint64 maxSamples, const PcaConfig& config,
+                                         const std::shared_ptr<WeightCheckpoint>& checkpoint = nullptr,
+                                         int chunk = 256);
+
+// 类别配色（Tableau 10），标签 < 0 为灰色
+QRgb scatterColor(int label);
+
+// 把 n 个点（x, y 交替）按 bounds 映射到 image 上，每个点画成 radius 像素半径的方块，颜色由标签决定，
+// 后画的点覆盖先画的点；先按行带做计数排序，再逐行带并行光栅化，各线程只写自己的行带
+void renderScatterImage(const float* points, const int* labels, qint64 n, const QRectF& bounds, int radius,
+                        QRgb background, QImage& image, ThreadPool* pool = nullptr);
+
+// 投影散点图：按当前缩放下的像素尺寸整体光栅化成一张图像（尺寸变化时才重画），悬停显示最近的样本
+class ScatterPlotItem : public QGraphicsItem
+{
+public:
+    explicit ScatterPlotItem(const QRectF& rect, QGraphicsItem* parent = nullptr);
+
+    void setPoints(std::vector<float> points, std::vector<int> labels);
+    void setBackground(QRgb color);
+    qint64 count() const { return static_cast<qint64>(m_points.size() / 2); }
+    const QRectF& dataBounds() const { return m_bounds; }
+
+    QRectF boundingRect() const override { return m_rect; }
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget = nullptr) override;
+
+protected:
+    void hoverMoveEvent(QGraphicsSceneHoverEvent* event) override;
+
+private:
+    QRectF m_rect;
+    QRectF m_bounds;  // 数据坐标范围（四周留 3% 空白）
+    std::vector<float> m_points;
+    std::vector<int> m_labels;
+    QRgb m_background;
+    QImage m_image;
+    bool m_dirty = true;
+};
+
+#endif // PROJECTION_H
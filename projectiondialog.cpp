@@ -0,0 +1,121 @@
+#include "projectiondialog.h"
+#include "colorthememanager.h"
+#include "inferenceengine.h"
+#include "weightcheckpoint.h"
+#include <QApplication>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <algorithm>
+
+ProjectionDialog::ProjectionDialog(const QList<NeuralLayer>& layers, QWidget* parent)
+    : QDialog(parent), m_layers(layers) {
+    setWindowTitle("Activation Projection (PCA)");
+    resize(760, 860);
+
+    m_pathEdit = new QLineEdit(this);
+    m_pathEdit->setReadOnly(true);
+    m_pathEdit->setPlaceholderText("CSV / IDX 样本集");
+    QPushButton* browseButton = new QPushButton("选择…", this);
+    connect(browseButton, &QPushButton::clicked, this, &ProjectionDialog::chooseDataset);
+    QHBoxLayout* pathRow = new QHBoxLayout();
+    pathRow->addWidget(m_pathEdit, 1);
+    pathRow->addWidget(browseButton);
+
+    // 层列表按引擎推断的输出形状列出，默认选最后一个隐藏层
+    m_layerBox = new QComboBox(this);
+    InferenceEngine engine;
+    if (engine.build(m_layers, 1)) {
+        for (int i = 0; i < engine.layerCount(); ++i) {
+            const InferenceEngine::LayerInfo& info = engine.layerInfo(i);
+            m_layerBox->addItem(QString("第 %1 层 %2（%3 维）").arg(i + 1).arg(info.layerType).arg(info.out.size()));
+        }
+        m_layerBox->setCurrentIndex(std::max(0, engine.layerCount() - 2));
+    }
+    m_methodBox = new QComboBox(this);
+    m_methodBox->addItem("自动");
+    m_methodBox->addItem("协方差 + 子空间迭代");
+    m_methodBox->addItem("随机化 SVD（流式）");
+    m_samplesBox = new QSpinBox(this);
+    m_samplesBox->setRange(2, 10000000);
+    m_samplesBox->setSingleStep(10000);
+    m_samplesBox->setValue(100000);
+
+    m_runButton = new QPushButton("计算投影", this);
+    m_runButton->setEnabled(false);
+    connect(m_runButton, &QPushButton::clicked, this, &ProjectionDialog::runProjection);
+
+    QFormLayout* form = new QFormLayout();
+    form->addRow("样本集", pathRow);
+    form->addRow("层", m_layerBox);
+    form->addRow("方法", m_methodBox);
+    form->addRow("最多样本数", m_samplesBox);
+    QHBoxLayout* controls = new QHBoxLayout();
+    controls->addLayout(form, 1);
+    controls->addWidget(m_runButton, 0, Qt::AlignBottom);
+
+    m_summaryLabel = new QLabel(this);
+    m_summaryLabel->setWordWrap(true);
+    m_summaryLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+
+    m_scene = new QGraphicsScene(this);
+    m_plot = new ScatterPlotItem(QRectF(0, 0, 640, 640));
+    m_plot->setBackground(ColorThemeManager::currentTheme().layerBackground.rgb());
+    m_scene->addItem(m_plot);
+    m_view = new QGraphicsView(m_scene, this);
+    m_view->setDragMode(QGraphicsView::ScrollHandDrag);
+    m_view->setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
+
+    QVBoxLayout* mainLayout = new QVBoxLayout(this);
+    mainLayout->addLayout(controls);
+    mainLayout->addWidget(m_summaryLabel);
+    mainLayout->addWidget(m_view, 1);
+}
+
+void ProjectionDialog::chooseDataset() {
+    const QString path = QFileDialog::getOpenFileName(this, "选择样本集", QString(),
+                                                      "样本集 (*.csv *.txt *ubyte *.idx);;所有文件 (*)");
+    if (path.isEmpty()) return;
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    auto dataset = std::make_unique<Dataset>();
+    QString error;
+    bool opened = false;
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    InferenceEngine engine;
+    if ((suffix == "csv" || suffix == "txt") && engine.build(m_layers, 1)) {
+        // CSV 按网络输入维数解析，多出的首列视为标签
+        opened = dataset->openCsv(path, engine.inputShape().size(), &error);
+    } else {
+        opened = dataset->open(path, &error);
+    }
+    QApplication::restoreOverrideCursor();
+    if (!opened) {
+        m_summaryLabel->setText("无法打开样本集：" + error);
+        return;
+    }
+    m_dataset = std::move(dataset);
+    m_pathEdit->setText(path);
+    m_runButton->setEnabled(true);
+    m_summaryLabel->setText(QString("%1 个样本，每个 %2 维%3")
+                                .arg(m_dataset->count())
+                                .arg(m_dataset->sampleSize())
+                                .arg(m_dataset->hasLabels() ? "，带标签" : ""));
+}
+
+void ProjectionDialog::runProjection() {
+    if (!m_dataset) return;
+    PcaConfig config;
+    config.method = m_methodBox->currentIndex() == 1   ? PcaMethod::Covariance
+                    : m_methodBox->currentIndex() == 2 ? PcaMethod::Randomized
+                                                       : PcaMethod::Auto;
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    ProjectionResult result = projectLayerActivations(m_layers, m_layerBox->currentIndex(), *m_dataset,
+                                                      m_samplesBox->value(), config, WeightCheckpoint::active());
+    QApplication::restoreOverrideCursor();
+    m_summaryLabel->setText(result.summary());
+    if (!result.valid) return;
+    m_plot->setPoints(std::move(result.points), std::move(result.labels));
+    m_view->fitInView(m_plot, Qt::KeepAspectRatio);
+}
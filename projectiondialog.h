@@ -0,0 +1,43 @@
+#ifndef PROJECTIONDIALOG_H
+#define PROJECTIONDIALOG_H
+
+#include <QComboBox>
+#include <QDialog>
+#include <QGraphicsScene>
+#include <QGraphicsView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QSpinBox>
+#include <memory>
+#include "backend.h"
+#include "dataset.h"
+#include "projection.h"
+
+// CodeGeneratorWindow 中“Project”打开的窗口：选择样本集与层，把该层在样本集上的激活做 PCA，
+// 以前两个主成分画散点图（按标签着色）；已加载权重检查点时使用检查点权重
+class ProjectionDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit ProjectionDialog(const QList<NeuralLayer>& layers, QWidget* parent = nullptr);
+
+private slots:
+    void chooseDataset();
+    void runProjection();
+
+private:
+    QList<NeuralLayer> m_layers;
+    std::unique_ptr<Dataset> m_dataset;
+    QLineEdit* m_pathEdit;
+    QComboBox* m_layerBox;
+    QComboBox* m_methodBox;
+    QSpinBox* m_samplesBox;
+    QPushButton* m_runButton;
+    QLabel* m_summaryLabel;
+    QGraphicsScene* m_scene;
+    QGraphicsView* m_view;
+    ScatterPlotItem* m_plot;
+};
+
+#endif // PROJECTIONDIALOG_H
@@ -1,14 +1,32 @@
 #include "propertypanel.h"
 #include <QFormLayout>
 #include <QLabel>
+#include <QPainter>
+#include <QVBoxLayout>
+#include <algorithm>
+#include <cmath>
 
 PropertyPanel::PropertyPanel(QWidget *parent) : QWidget(parent)
 {
-    layout = new QFormLayout(this);
+    // 参数表单在上，权重统计在下；setParameters 只重建表单部分
+    QVBoxLayout* panelLayout = new QVBoxLayout(this);
+    layout = new QFormLayout();
+    panelLayout->addLayout(layout);
     updateBtn = new QPushButton("update parameters", this);
     layout->addWidget(updateBtn);
     layout->setSpacing(15);
 
+    statsBox = new QGroupBox("权重统计", this);
+    QVBoxLayout* statsLayout = new QVBoxLayout(statsBox);
+    statsLabel = new QLabel(statsBox);
+    statsLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    histogram = new WeightHistogramWidget(statsBox);
+    statsLayout->addWidget(statsLabel);
+    statsLayout->addWidget(histogram);
+    panelLayout->addWidget(statsBox);
+    panelLayout->addStretch(1);
+    statsBox->hide();
+
     connect(updateBtn, &QPushButton::clicked, this, &PropertyPanel::onUpdateButtonClicked);
 }
 
@@ -72,3 +90,52 @@ void PropertyPanel::clearParameters() {
     }
     fieldMap.clear();
 }
+
+void PropertyPanel::setWeightStats(const QString& title, const WeightStats& stats) {
+    statsLabel->setText(title + "\n" + stats.summary());
+    histogram->setStats(stats);
+    statsBox->show();
+}
+
+void PropertyPanel::clearWeightStats() {
+    statsBox->hide();
+}
+
+WeightHistogramWidget::WeightHistogramWidget(QWidget* parent) : QWidget(parent)
+{
+    setMinimumSize(200, 80);
+}
+
+void WeightHistogramWidget::setStats(const WeightStats& stats) {
+    m_stats = stats;
+    setToolTip(QString("[%1, %2] 等分 %3 箱").arg(stats.min, 0, 'g', 4).arg(stats.max, 0, 'g', 4).arg(WeightStats::kBins));
+    update();
+}
+
+void WeightHistogramWidget::paintEvent(QPaintEvent*) {
+    QPainter painter(this);
+    const QRectF area = rect().adjusted(2, 2, -2, -14);
+    painter.fillRect(rect(), palette().base());
+    const qint64 peak = *std::max_element(m_stats.histogram.begin(), m_stats.histogram.end());
+    if (peak <= 0) return;
+
+    const double binWidth = area.width() / WeightStats::kBins;
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(QColor(0, 122, 204));
+    for (int b = 0; b < WeightStats::kBins; ++b) {
+        if (m_stats.histogram[b] == 0) continue;
+        const double h = std::sqrt(double(m_stats.histogram[b]) / double(peak)) * area.height();
+        painter.drawRect(QRectF(area.left() + b * binWidth, area.bottom() - h, std::max(binWidth, 1.0), h));
+    }
+
+    // 零点位置
+    if (m_stats.min < 0.0f && m_stats.max > 0.0f) {
+        const double x = area.left() + area.width() * (-m_stats.min) / (double(m_stats.max) - m_stats.min);
+        painter.setPen(QPen(Qt::red, 1, Qt::DashLine));
+        painter.drawLine(QPointF(x, area.top()), QPointF(x, area.bottom()));
+    }
+    painter.setPen(palette().text().color());
+    const QRectF labels(area.left(), area.bottom() + 1, area.width(), 12);
+    painter.drawText(labels, Qt::AlignLeft | Qt::AlignVCenter, QString::number(m_stats.min, 'g', 3));
+    painter.drawText(labels, Qt::AlignRight | Qt::AlignVCenter, QString::number(m_stats.max, 'g', 3));
+}
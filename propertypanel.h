@@ -6,6 +6,24 @@
 #include <QLineEdit>
 #include <QPushButton>
 #include <QMap>
+#include <QLabel>
+#include <QGroupBox>
+#include "weightstats.h"
+
+// 256 箱权重直方图（纵轴取平方根，长尾也看得见）
+class WeightHistogramWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit WeightHistogramWidget(QWidget* parent = nullptr);
+    void setStats(const WeightStats& stats);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+
+private:
+    WeightStats m_stats;
+};
 
 class PropertyPanel : public QWidget
 {
@@ -16,6 +34,9 @@ public:
     void setLayerType(const QString& type);
     void setParameters(const QMap<QString, QString>& params); // 设置参数字段和当前值
     void clearParameters();
+    // 选中层在当前检查点中的权重统计；title 为张量名等说明
+    void setWeightStats(const QString& title, const WeightStats& stats);
+    void clearWeightStats();
 
 signals:
     void parametersUpdated(const QMap<QString, QString>& newParams); // 参数修改后发出信号
@@ -28,6 +49,9 @@ private:
     QPushButton* updateBtn;
     QMap<QString, QLineEdit*> fieldMap;
     QString currentLayerType;
+    QGroupBox* statsBox;
+    QLabel* statsLabel;
+    WeightHistogramWidget* histogram;
 };
 
 
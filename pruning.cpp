@@ -0,0 +1,365 @@
+#include "pruning.h"
+#include "inferenceengine.h"
+#include "simdutils.h"
+#include "threadpool.h"
+#include "weightcheckpoint.h"
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QtAlgorithms>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+// 每个并行块大致处理的元素/非零元数
+constexpr qint64 kChunkElements = 1 << 15;
+// 实测耗时时每个引擎至少运行的时长
+constexpr double kTimingMs = 60.0;
+
+int rowGrain(qint64 rows, qint64 work) {
+    if (rows <= 0) return 1;
+    return static_cast<int>(std::max<qint64>(1, kChunkElements * rows / std::max<qint64>(1, work)));
+}
+
+#if NNV_HAVE_AVX2
+NNV_AVX2 qint64 countNonZerosAvx2(const float* w, int n) {
+    int i = 0;
+    qint64 count = 0;
+    const __m256 zero = _mm256_setzero_ps();
+    for (; i + 8 <= n; i += 8) {
+        const __m256 nonZero = _mm256_cmp_ps(_mm256_loadu_ps(w + i), zero, _CMP_NEQ_UQ);
+        count += qPopulationCount(static_cast<quint32>(_mm256_movemask_ps(nonZero)));
+    }
+    for (; i < n; ++i) count += w[i] != 0.0f;
+    return count;
+}
+#endif
+
+qint64 countNonZeros(const float* w, int n) {
+#if NNV_HAVE_AVX2
+    if (simd::hasAvx2()) return countNonZerosAvx2(w, n);
+#endif
+    int i = 0;
+    qint64 count = 0;
+    for (; i < n; ++i) count += w[i] != 0.0f;
+    return count;
+}
+
+#if NNV_HAVE_AVX2
+NNV_AVX2 float sparseDotAvx2(const float* values, const int* columns, int n, const float* x) {
+    int k = 0;
+    float sum = 0.0f;
+    // 两个累加器错开 gather 的延迟
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    for (; k + 16 <= n; k += 16) {
+        const __m256i i0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(columns + k));
+        const __m256i i1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(columns + k + 8));
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(values + k), _mm256_i32gather_ps(x, i0, 4), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(values + k + 8), _mm256_i32gather_ps(x, i1, 4), acc1);
+    }
+    if (k + 8 <= n) {
+        const __m256i i0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(columns + k));
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(values + k), _mm256_i32gather_ps(x, i0, 4), acc0);
+        k += 8;
+    }
+    const __m256 acc = _mm256_add_ps(acc0, acc1);
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_add_ss(half, _mm_movehdup_ps(half));
+    sum = _mm_cvtss_f32(half);
+    for (; k < n; ++k) sum += values[k] * x[columns[k]];
+    return sum;
+}
+#endif
+
+float sparseDot(const float* values, const int* columns, int n, const float* x) {
+#if NNV_HAVE_AVX2
+    if (simd::hasAvx2()) return sparseDotAvx2(values, columns, n, x);
+#endif
+    int k = 0;
+    float sum = 0.0f;
+    for (; k < n; ++k) sum += values[k] * x[columns[k]];
+    return sum;
+}
+
+// |w|，NaN 视为 +Inf（永不剪掉），保证 nth_element 的比较是严格弱序
+void absValues(const float* w, qint64 count, float* out) {
+    for (qint64 i = 0; i < count; ++i) {
+        out[i] = std::isnan(w[i]) ? std::numeric_limits<float>::infinity() : std::fabs(w[i]);
+    }
+}
+
+float thresholdOf(std::vector<float>& magnitudes, double sparsity) {
+    const qint64 count = static_cast<qint64>(magnitudes.size());
+    const qint64 k = std::llround(std::clamp(sparsity, 0.0, 1.0) * double(count));
+    if (k <= 0) return 0.0f;
+    if (k >= count) return std::numeric_limits<float>::infinity();
+    std::nth_element(magnitudes.begin(), magnitudes.begin() + k, magnitudes.end());
+    return magnitudes[static_cast<std::size_t>(k)];
+}
+
+// 单样本前向的逐层耗时（多次运行取平均）
+QVector<double> averageLayerTimes(InferenceEngine& engine, const float* input) {
+    QVector<double> total(engine.layerCount(), 0.0);
+    for (int i = 0; i < 3; ++i) engine.forward(input, 1);
+    QElapsedTimer timer;
+    timer.start();
+    int runs = 0;
+    do {
+        engine.forward(input, 1);
+        const QVector<double>& times = engine.layerTimesMs();
+        for (int l = 0; l < total.size(); ++l) total[l] += times[l];
+        ++runs;
+    } while (runs < 5 || timer.nsecsElapsed() < kTimingMs * 1.0e6);
+    for (double& t : total) t /= runs;
+    return total;
+}
+
+#if NNV_HAVE_AVX2
+NNV_AVX2 qint64 pruneBelowAvx2(float* w, qint64 count, float threshold) {
+    qint64 i = 0, pruned = 0;
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 limit = _mm256_set1_ps(threshold);
+    for (; i + 8 <= count; i += 8) {
+        const __m256 v = _mm256_loadu_ps(w + i);
+        // NaN 比较结果为假，保留
+        const __m256 below = _mm256_cmp_ps(_mm256_and_ps(v, absMask), limit, _CMP_LT_OQ);
+        _mm256_storeu_ps(w + i, _mm256_andnot_ps(below, v));
+        pruned += qPopulationCount(static_cast<quint32>(_mm256_movemask_ps(below)));
+    }
+    for (; i < count; ++i) {
+        if (std::fabs(w[i]) < threshold) {
+            w[i] = 0.0f;
+            ++pruned;
+        }
+    }
+    return pruned;
+}
+#endif
+
+} // namespace
+
+void CsrMatrix::toDense(float* w) const {
+    std::fill(w, w + qint64(rows) * cols, 0.0f);
+    for (int r = 0; r < rows; ++r) {
+        float* row = w + qint64(r) * cols;
+        for (int k = rowPtr[r]; k < rowPtr[r + 1]; ++k) row[colIndex[k]] = values[k];
+    }
+}
+
+CsrMatrix toCsr(const float* w, int rows, int cols, ThreadPool* pool) {
+    CsrMatrix csr;
+    csr.rows = rows;
+    csr.cols = cols;
+    csr.rowPtr.assign(static_cast<std::size_t>(std::max(rows, 0)) + 1, 0);
+    if (rows <= 0 || cols <= 0) return csr;
+    if (!pool) pool = &ThreadPool::global();
+    const int grain = rowGrain(rows, qint64(rows) * cols);
+
+    std::vector<int> counts(static_cast<std::size_t>(rows));
+    pool->parallelFor(0, rows, grain, [&](int first, int last) {
+        for (int r = first; r < last; ++r) counts[r] = static_cast<int>(countNonZeros(w + qint64(r) * cols, cols));
+    });
+    for (int r = 0; r < rows; ++r) csr.rowPtr[r + 1] = csr.rowPtr[r] + counts[r];
+
+    csr.colIndex.resize(static_cast<std::size_t>(csr.rowPtr[rows]));
+    csr.values.resize(csr.colIndex.size());
+    pool->parallelFor(0, rows, grain, [&](int first, int last) {
+        for (int r = first; r < last; ++r) {
+            const float* row = w + qint64(r) * cols;
+            int k = csr.rowPtr[r];
+            for (int c = 0; c < cols; ++c) {
+                if (row[c] == 0.0f) continue;
+                csr.colIndex[k] = c;
+                csr.values[k++] = row[c];
+            }
+        }
+    });
+    return csr;
+}
+
+void csrMatMul(const CsrMatrix& a, const float* x, int batch, float* y, ThreadPool* pool) {
+    if (a.rows <= 0 || batch <= 0) return;
+    if (!pool) pool = &ThreadPool::global();
+    const int grain = rowGrain(a.rows, (a.nonZeros() + a.rows) * batch);
+    pool->parallelFor(0, a.rows, grain, [&](int first, int last) {
+        for (int r = first; r < last; ++r) {
+            const int begin = a.rowPtr[r];
+            const int n = a.rowPtr[r + 1] - begin;
+            for (int b = 0; b < batch; ++b) {
+                y[qint64(b) * a.rows + r] =
+                    sparseDot(a.values.data() + begin, a.colIndex.data() + begin, n, x + qint64(b) * a.cols);
+            }
+        }
+    });
+}
+
+float magnitudeThreshold(const float* w, qint64 count, double sparsity) {
+    if (count <= 0) return 0.0f;
+    std::vector<float> magnitudes(static_cast<std::size_t>(count));
+    absValues(w, count, magnitudes.data());
+    return thresholdOf(magnitudes, sparsity);
+}
+
+float globalMagnitudeThreshold(const QVector<QPair<const float*, qint64>>& tensors, double sparsity) {
+    qint64 total = 0;
+    for (const auto& tensor : tensors) total += tensor.second;
+    if (total <= 0) return 0.0f;
+    std::vector<float> magnitudes(static_cast<std::size_t>(total));
+    qint64 offset = 0;
+    for (const auto& tensor : tensors) {
+        absValues(tensor.first, tensor.second, magnitudes.data() + offset);
+        offset += tensor.second;
+    }
+    return thresholdOf(magnitudes, sparsity);
+}
+
+qint64 pruneBelow(float* w, qint64 count, float threshold) {
+#if NNV_HAVE_AVX2
+    if (simd::hasAvx2()) return pruneBelowAvx2(w, count, threshold);
+#endif
+    qint64 i = 0, pruned = 0;
+    for (; i < count; ++i) {
+        if (std::fabs(w[i]) < threshold) {
+            w[i] = 0.0f;
+            ++pruned;
+        }
+    }
+    return pruned;
+}
+
+qint64 pruneNM(float* w, int rows, int cols, int n, int m) {
+    if (rows <= 0 || cols <= 0 || m <= 0 || n >= m) return 0;
+    n = std::max(n, 0);
+    std::atomic<qint64> pruned{0};
+    ThreadPool::global().parallelFor(0, rows, rowGrain(rows, qint64(rows) * cols), [&](int first, int last) {
+        std::vector<int> order(static_cast<std::size_t>(m));
+        qint64 local = 0;
+        for (int r = first; r < last; ++r) {
+            float* row = w + qint64(r) * cols;
+            for (int g = 0; g < cols; g += m) {
+                const int len = std::min(m, cols - g);
+                if (n >= len) continue;
+                float* group = row + g;
+                std::iota(order.begin(), order.begin() + len, 0);
+                std::nth_element(order.begin(), order.begin() + n, order.begin() + len, [group](int a, int b) {
+                    return std::fabs(group[a]) > std::fabs(group[b]);
+                });
+                for (int k = n; k < len; ++k) {
+                    local += group[order[k]] != 0.0f;
+                    group[order[k]] = 0.0f;
+                }
+            }
+        }
+        pruned += local;
+    });
+    return pruned.load();
+}
+
+QString PruneConfig::name() const {
+    switch (method) {
+    case PruneMethod::PerLayer: return QString("逐层 %1%").arg(sparsity * 100.0, 0, 'f', 1);
+    case PruneMethod::Global: return QString("全局 %1%").arg(sparsity * 100.0, 0, 'f', 1);
+    case PruneMethod::NM: return QString("%1:%2 结构化").arg(n).arg(m);
+    }
+    return QString();
+}
+
+QString PruneReport::summary() const {
+    if (!valid) return "剪枝模拟失败：" + error;
+    return QString("%1：Dense 权重 %2 -> %3 个（稀疏度 %4%），存储 %5 KB -> %6 KB（CSR），"
+                   "单样本前向 %7 ms -> %8 ms（%9×），输出相对误差 %10%")
+        .arg(config.name())
+        .arg(parameters)
+        .arg(kept)
+        .arg(parameters > 0 ? 100.0 * (parameters - kept) / parameters : 0.0, 0, 'f', 1)
+        .arg(denseBytes / 1024.0, 0, 'f', 1)
+        .arg(csrBytes / 1024.0, 0, 'f', 1)
+        .arg(denseMs, 0, 'f', 3)
+        .arg(sparseMs, 0, 'f', 3)
+        .arg(sparseMs > 0.0 ? denseMs / sparseMs : 1.0, 0, 'f', 2)
+        .arg(outputRelativeError * 100.0, 0, 'f', 3);
+}
+
+PruneReport simulatePruning(const QList<NeuralLayer>& layers, const PruneConfig& config,
+                            const std::shared_ptr<WeightCheckpoint>& checkpoint) {
+    PruneReport report;
+    report.config = config;
+    const int batch = 4;
+    InferenceEngine engine;
+    if (!engine.build(layers, batch, &report.error)) return report;
+
+    QStringList sources;
+    if (checkpoint && checkpoint->isOpen()) {
+        loadCheckpointWeights(*checkpoint, bindCheckpoint(*checkpoint, layers), engine, &sources);
+    }
+
+    std::vector<float> input(static_cast<std::size_t>(engine.inputShape().size()) * batch);
+    for (std::size_t i = 0; i < input.size(); ++i) input[i] = std::sin(0.013f * float(i) + 0.5f);
+    const qint64 outputSize = qint64(engine.outputShape().size()) * batch;
+    const float* y = engine.forward(input.data(), batch);
+    std::vector<float> reference(y, y + outputSize);
+    const QVector<double> denseTimes = averageLayerTimes(engine, input.data());
+
+    QVector<int> dense;
+    for (int i = 0; i < engine.layerCount(); ++i) {
+        if (engine.layerInfo(i).kind == InferenceEngine::LayerKind::Dense && engine.weightSize(i) > 0) dense.append(i);
+    }
+    float globalThreshold = 0.0f;
+    if (config.method == PruneMethod::Global) {
+        QVector<QPair<const float*, qint64>> tensors;
+        for (int i : dense) tensors.append(qMakePair(static_cast<const float*>(engine.weightData(i)), qint64(engine.weightSize(i))));
+        globalThreshold = globalMagnitudeThreshold(tensors, config.sparsity);
+    }
+
+    for (int i : dense) {
+        PruneLayerReport layer;
+        layer.layer = i;
+        layer.layerType = engine.layerInfo(i).layerType;
+        layer.source = i < sources.size() && !sources[i].isEmpty() ? sources[i] : QString("随机初始化");
+        layer.parameters = engine.weightSize(i);
+        const int rows = engine.layerInfo(i).out.width;
+        const int cols = static_cast<int>(layer.parameters / rows);
+        float* w = engine.weightData(i);
+        if (config.method == PruneMethod::NM) {
+            pruneNM(w, rows, cols, config.n, config.m);
+        } else {
+            layer.threshold = config.method == PruneMethod::Global ? globalThreshold
+                                                                   : magnitudeThreshold(w, layer.parameters, config.sparsity);
+            pruneBelow(w, layer.parameters, layer.threshold);
+        }
+        CsrMatrix csr = toCsr(w, rows, cols);
+        layer.kept = csr.nonZeros();
+        layer.denseBytes = layer.parameters * 4;
+        layer.csrBytes = csr.bytes();
+        engine.setSparseWeights(i, std::move(csr));
+        report.layers.append(layer);
+    }
+
+    const QVector<double> sparseTimes = averageLayerTimes(engine, input.data());
+    for (PruneLayerReport& layer : report.layers) {
+        layer.denseMs = denseTimes[layer.layer];
+        layer.sparseMs = sparseTimes[layer.layer];
+        report.parameters += layer.parameters;
+        report.kept += layer.kept;
+        report.denseBytes += layer.denseBytes;
+        report.csrBytes += layer.csrBytes;
+    }
+    report.denseMs = std::accumulate(denseTimes.begin(), denseTimes.end(), 0.0);
+    report.sparseMs = std::accumulate(sparseTimes.begin(), sparseTimes.end(), 0.0);
+
+    const float* pruned = engine.forward(input.data(), batch);
+    double diff = 0.0, norm = 0.0;
+    for (qint64 i = 0; i < outputSize; ++i) {
+        const double d = double(pruned[i]) - reference[i];
+        diff += d * d;
+        norm += double(reference[i]) * reference[i];
+    }
+    report.outputRelativeError = norm > 0.0 ? std::sqrt(diff / norm) : 0.0;
+    report.valid = true;
+    return report;
+}
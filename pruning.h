@@ -0,0 +1,98 @@
+#ifndef PRUNING_H
+#define PRUNING_H
+
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include <memory>
+#include <vector>
+#include "backend.h"
+
+class ThreadPool;
+class WeightCheckpoint;
+
+// 压缩稀疏行（CSR）权重：行 = 输出通道，与 PyTorch Linear 的 [out][in] 布局一致
+struct CsrMatrix
+{
+    int rows = 0;
+    int cols = 0;
+    std::vector<int> rowPtr;    // rows + 1 个，第 r 行的非零元为 [rowPtr[r], rowPtr[r + 1])
+    std::vector<int> colIndex;  // 每行内按列号递增
+    std::vector<float> values;
+
+    qint64 nonZeros() const { return static_cast<qint64>(values.size()); }
+    double sparsity() const { return rows > 0 && cols > 0 ? 1.0 - double(nonZeros()) / (double(rows) * cols) : 0.0; }
+    qint64 bytes() const { return qint64(rowPtr.size()) * 4 + nonZeros() * 8; }
+    void toDense(float* w) const;  // 写出 rows×cols 的稠密矩阵
+};
+
+// 收集稠密矩阵中的非零元（按行分块并行：先数每行非零元，再各自写入）
+CsrMatrix toCsr(const float* w, int rows, int cols, ThreadPool* pool = nullptr);
+
+// y[b][rows] = x[b][cols] · Aᵀ，即对 batch 个样本做稀疏矩阵-向量乘；AVX2 下按 8 个非零元一组 gather 输入，
+// 按行分块并行，每行依次处理全部样本，使该行的列号与权重在各样本间留在 L1 中
+void csrMatMul(const CsrMatrix& a, const float* x, int batch, float* y, ThreadPool* pool = nullptr);
+
+// 幅值剪枝的阈值：用 nth_element 找到第 round(sparsity·count) 小的 |w|，剪掉严格小于它的权重
+// （与阈值相等的并列值全部保留，实际稀疏度可能略低于目标）；sparsity >= 1 时返回 +Inf
+float magnitudeThreshold(const float* w, qint64 count, double sparsity);
+// 全局阈值：所有张量的 |w| 放在一起取同一个分位数，小层、大层按各自的幅值分布被剪掉不同比例
+float globalMagnitudeThreshold(const QVector<QPair<const float*, qint64>>& tensors, double sparsity);
+// 把 |w| < threshold 的权重置零，返回置零的个数
+qint64 pruneBelow(float* w, qint64 count, float threshold);
+// N:M 结构化稀疏：每行沿输入维每 m 个连续权重只保留 |w| 最大的 n 个（行尾不足 m 个的组同样最多保留 n 个）
+qint64 pruneNM(float* w, int rows, int cols, int n, int m);
+
+enum class PruneMethod { PerLayer, Global, NM };
+
+struct PruneConfig
+{
+    PruneMethod method = PruneMethod::PerLayer;
+    double sparsity = 0.9;  // PerLayer / Global 的目标稀疏度
+    int n = 2;              // NM：每 m 个保留 n 个
+    int m = 4;
+
+    QString name() const;  // "逐层 90%"、"全局 90%"、"2:4 结构化"
+};
+
+struct PruneLayerReport
+{
+    int layer = -1;
+    QString layerType;
+    QString source;          // 权重来源：检查点张量名或“随机初始化”
+    qint64 parameters = 0;   // 仅权重
+    qint64 kept = 0;
+    float threshold = 0.0f;  // N:M 时为 0
+    qint64 denseBytes = 0;
+    qint64 csrBytes = 0;
+    double denseMs = 0.0;    // batch 1 实测
+    double sparseMs = 0.0;
+
+    double sparsity() const { return parameters > 0 ? 1.0 - double(kept) / double(parameters) : 0.0; }
+};
+
+struct PruneReport
+{
+    bool valid = false;
+    QString error;
+    PruneConfig config;
+    QVector<PruneLayerReport> layers;
+    qint64 parameters = 0;
+    qint64 kept = 0;
+    qint64 denseBytes = 0;
+    qint64 csrBytes = 0;
+    double denseMs = 0.0;
+    double sparseMs = 0.0;
+    double outputRelativeError = 0.0;  // 同一批输入下，剪枝前后网络输出的相对 L2 误差
+
+    QString summary() const;
+};
+
+// 对 Dense 层权重按 config 剪枝（卷积与循环层保持稠密），在原生推理引擎上改用 CSR 前向，
+// 报告逐层阈值、稀疏度、CSR 存储与剪枝前后实测的单样本耗时；权重来源同 simulateQuantization
+PruneReport simulatePruning(const QList<NeuralLayer>& layers, const PruneConfig& config,
+                            const std::shared_ptr<WeightCheckpoint>& checkpoint = nullptr);
+
+#endif // PRUNING_H
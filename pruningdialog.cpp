@@ -0,0 +1,129 @@
+#include "pruningdialog.h"
+#include "weightcheckpoint.h"
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QVBoxLayout>
+
+namespace {
+
+QTableWidgetItem* numberItem(const QString& text) {
+    QTableWidgetItem* item = new QTableWidgetItem(text);
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    return item;
+}
+
+} // namespace
+
+PruningDialog::PruningDialog(const QList<NeuralLayer>& layers, QWidget* parent)
+    : QDialog(parent), m_layers(layers) {
+    setWindowTitle("Magnitude Pruning");
+    resize(1100, 520);
+
+    m_methodBox = new QComboBox(this);
+    m_methodBox->addItem("逐层幅值");
+    m_methodBox->addItem("全局幅值");
+    m_methodBox->addItem("N:M 结构化");
+    connect(m_methodBox, &QComboBox::currentTextChanged, this, &PruningDialog::updateControls);
+    m_sparsityBox = new QDoubleSpinBox(this);
+    m_sparsityBox->setRange(0.0, 99.9);
+    m_sparsityBox->setDecimals(1);
+    m_sparsityBox->setSingleStep(5.0);
+    m_sparsityBox->setSuffix(" %");
+    m_sparsityBox->setValue(90.0);
+    m_nBox = new QSpinBox(this);
+    m_nBox->setRange(1, 63);
+    m_nBox->setValue(2);
+    m_mBox = new QSpinBox(this);
+    m_mBox->setRange(2, 64);
+    m_mBox->setValue(4);
+
+    m_runButton = new QPushButton("运行剪枝", this);
+    connect(m_runButton, &QPushButton::clicked, this, &PruningDialog::runSimulation);
+
+    QFormLayout* form = new QFormLayout();
+    form->addRow("Method", m_methodBox);
+    form->addRow("Sparsity", m_sparsityBox);
+    form->addRow("N", m_nBox);
+    form->addRow("M", m_mBox);
+    QHBoxLayout* controls = new QHBoxLayout();
+    controls->addLayout(form);
+    controls->addWidget(m_runButton, 0, Qt::AlignBottom);
+    controls->addStretch(1);
+
+    m_summaryLabel = new QLabel(this);
+    m_summaryLabel->setWordWrap(true);
+    m_summaryLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+
+    m_table = new QTableWidget(0, 11, this);
+    m_table->setHorizontalHeaderLabels({"层", "类型", "权重来源", "参数", "保留", "稀疏度", "阈值", "稠密 KB", "CSR KB",
+                                        "稠密 ms", "CSR ms"});
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->verticalHeader()->setVisible(false);
+    m_table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+
+    QVBoxLayout* mainLayout = new QVBoxLayout(this);
+    mainLayout->addLayout(controls);
+    mainLayout->addWidget(m_summaryLabel);
+    mainLayout->addWidget(m_table, 1);
+
+    updateControls();
+    runSimulation();
+}
+
+PruneConfig PruningDialog::currentConfig() const {
+    PruneConfig config;
+    const int method = m_methodBox->currentIndex();
+    config.method = method == 1 ? PruneMethod::Global : (method == 2 ? PruneMethod::NM : PruneMethod::PerLayer);
+    config.sparsity = m_sparsityBox->value() / 100.0;
+    config.n = m_nBox->value();
+    config.m = m_mBox->value();
+    return config;
+}
+
+void PruningDialog::updateControls() {
+    const bool nm = currentConfig().method == PruneMethod::NM;
+    m_sparsityBox->setEnabled(!nm);
+    m_nBox->setEnabled(nm);
+    m_mBox->setEnabled(nm);
+}
+
+void PruningDialog::runSimulation() {
+    PruneConfig config = currentConfig();
+    if (config.method == PruneMethod::NM && config.n >= config.m) {
+        m_summaryLabel->setText("N 必须小于 M");
+        return;
+    }
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    QElapsedTimer timer;
+    timer.start();
+    const PruneReport report = simulatePruning(m_layers, config, WeightCheckpoint::active());
+    const qint64 elapsed = timer.elapsed();
+    QApplication::restoreOverrideCursor();
+    showReport(report);
+    if (report.valid) m_summaryLabel->setText(m_summaryLabel->text() + QString("\n模拟耗时 %1 ms").arg(elapsed));
+}
+
+void PruningDialog::showReport(const PruneReport& report) {
+    m_summaryLabel->setText(report.summary());
+    m_table->setRowCount(0);
+    if (!report.valid) return;
+    m_table->setRowCount(report.layers.size());
+    for (int row = 0; row < report.layers.size(); ++row) {
+        const PruneLayerReport& layer = report.layers[row];
+        m_table->setItem(row, 0, numberItem(QString::number(layer.layer + 1)));
+        m_table->setItem(row, 1, new QTableWidgetItem(layer.layerType));
+        m_table->setItem(row, 2, new QTableWidgetItem(layer.source));
+        m_table->setItem(row, 3, numberItem(QString::number(layer.parameters)));
+        m_table->setItem(row, 4, numberItem(QString::number(layer.kept)));
+        m_table->setItem(row, 5, numberItem(QString::number(layer.sparsity() * 100.0, 'f', 2) + "%"));
+        m_table->setItem(row, 6, numberItem(report.config.method == PruneMethod::NM ? QString("-")
+                                                                                   : QString::number(layer.threshold, 'e', 3)));
+        m_table->setItem(row, 7, numberItem(QString::number(layer.denseBytes / 1024.0, 'f', 1)));
+        m_table->setItem(row, 8, numberItem(QString::number(layer.csrBytes / 1024.0, 'f', 1)));
+        m_table->setItem(row, 9, numberItem(QString::number(layer.denseMs, 'f', 4)));
+        m_table->setItem(row, 10, numberItem(QString::number(layer.sparseMs, 'f', 4)));
+    }
+}
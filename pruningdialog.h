@@ -0,0 +1,40 @@
+#ifndef PRUNINGDIALOG_H
+#define PRUNINGDIALOG_H
+
+#include <QComboBox>
+#include <QDialog>
+#include <QDoubleSpinBox>
+#include <QLabel>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTableWidget>
+#include "backend.h"
+#include "pruning.h"
+
+// CodeGeneratorWindow 中“Prune”打开的窗口：选择剪枝方式与稀疏度，逐层列出阈值、CSR 存储与剪枝前后实测耗时
+// 已加载权重检查点时剪枝检查点权重，否则剪枝随机初始化的权重
+class PruningDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit PruningDialog(const QList<NeuralLayer>& layers, QWidget* parent = nullptr);
+
+private slots:
+    void runSimulation();
+    void updateControls();
+
+private:
+    PruneConfig currentConfig() const;
+    void showReport(const PruneReport& report);
+
+    QList<NeuralLayer> m_layers;
+    QComboBox* m_methodBox;
+    QDoubleSpinBox* m_sparsityBox;
+    QSpinBox* m_nBox;
+    QSpinBox* m_mBox;
+    QPushButton* m_runButton;
+    QLabel* m_summaryLabel;
+    QTableWidget* m_table;
+};
+
+#endif // PRUNINGDIALOG_H
@@ -0,0 +1,3159 @@
+#include "pytorchparser.h"
+#include <QHash>
+#include <QSet>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+const char* const kKeywords[PyNameTable::KeywordCount] = {
+    "False", "None", "True", "and", "as", "assert", "async", "await", "break", "class", "continue", "def",
+    "del", "elif", "else", "except", "finally", "for", "from", "global", "if", "import", "in", "is",
+    "lambda", "nonlocal", "not", "or", "pass", "raise", "return", "try", "while", "with", "yield"};
+
+// ASCII 字符类别，非 ASCII 字符一律按标识符字符处理
+enum CharClass : uchar { Invalid, Blank, LineBreak, NameStart, Digit, Quote, Comment, Backslash, Punct };
+
+struct CharTable
+{
+    uchar classes[128];
+    bool opStart[128];  // 可能是多字符运算符的首字符
+
+    CharTable() {
+        std::memset(classes, Invalid, sizeof classes);
+        classes[uchar(' ')] = classes[uchar('\t')] = classes[uchar('\f')] = Blank;
+        classes[uchar('\n')] = classes[uchar('\r')] = LineBreak;
+        for (int c = 'a'; c <= 'z'; ++c) classes[c] = NameStart;
+        for (int c = 'A'; c <= 'Z'; ++c) classes[c] = NameStart;
+        classes[uchar('_')] = NameStart;
+        for (int c = '0'; c <= '9'; ++c) classes[c] = Digit;
+        classes[uchar('\'')] = classes[uchar('"')] = Quote;
+        classes[uchar('#')] = Comment;
+        classes[uchar('\\')] = Backslash;
+        for (const char* p = "()[]{}:;,.=+-*/%<>!&|^~@"; *p; ++p) classes[uchar(*p)] = Punct;
+        std::memset(opStart, 0, sizeof opStart);
+        for (const char* p = ".=+-*/%<>!&|^:@"; *p; ++p) opStart[uchar(*p)] = true;
+    }
+};
+
+const CharTable kChars;
+
+inline uchar charClass(ushort c) {
+    return c < 128 ? kChars.classes[c] : uchar(NameStart);
+}
+
+inline bool isNameChar(ushort c) {
+    const uchar k = charClass(c);
+    return k == NameStart || k == Digit;
+}
+
+bool isStringPrefix(const QChar* text, int length) {
+    if (length > 2) return false;
+    for (int i = 0; i < length; ++i) {
+        const ushort c = text[i].unicode() | 0x20;  // 转小写
+        if (c != 'r' && c != 'b' && c != 'u' && c != 'f') return false;
+    }
+    return true;
+}
+
+// 三字符与双字符运算符，其余标点按单字符处理
+const int kThreeCharOps[] = {pyOp('*', '*', '='), pyOp('/', '/', '='), pyOp('>', '>', '='), pyOp('<', '<', '='),
+                             pyOp('.', '.', '.')};
+const int kTwoCharOps[] = {pyOp('*', '*'), pyOp('/', '/'), pyOp('=', '='), pyOp('!', '='), pyOp('<', '='),
+                           pyOp('>', '='), pyOp('-', '>'), pyOp('+', '='), pyOp('-', '='), pyOp('*', '='),
+                           pyOp('/', '='), pyOp('%', '='), pyOp('&', '='), pyOp('|', '='), pyOp('^', '='),
+                           pyOp('<', '<'), pyOp('>', '>'), pyOp(':', '='), pyOp('@', '=')};
+
+} // namespace
+
+PyNameTable::PyNameTable() : m_slots(256, -1) {
+    for (const char* keyword : kKeywords) intern(QString::fromLatin1(keyword));
+}
+
+int PyNameTable::intern(const QChar* text, int length, uint hash) {
+    const std::size_t mask = m_slots.size() - 1;
+    for (std::size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+        const int id = m_slots[slot];
+        if (id < 0) {
+            m_slots[slot] = size();
+            m_names.emplace_back(text, length);
+            m_hashes.push_back(hash);
+            if (m_names.size() * 2 > m_slots.size()) grow();
+            return size() - 1;
+        }
+        if (m_hashes[id] == hash && m_names[id].size() == length &&
+            std::memcmp(m_names[id].constData(), text, sizeof(QChar) * std::size_t(length)) == 0) {
+            return id;
+        }
+    }
+}
+
+void PyNameTable::grow() {
+    m_slots.assign(m_slots.size() * 2, -1);
+    const std::size_t mask = m_slots.size() - 1;
+    for (int id = 0; id < size(); ++id) {
+        std::size_t slot = m_hashes[id] & mask;
+        while (m_slots[slot] >= 0) slot = (slot + 1) & mask;
+        m_slots[slot] = id;
+    }
+}
+
+bool tokenizePython(const QString& source, PyNameTable& names, std::vector<PyToken>& tokens, QString* error) {
+    const QChar* text = source.constData();
+    const int n = source.size();
+    tokens.clear();
+    tokens.reserve(static_cast<std::size_t>(n / 3) + 16);
+    std::vector<int> indents(1, 0);
+    int depth = 0;  // 括号深度，括号内换行不产生 NEWLINE、不检查缩进
+    int line = 1;
+    bool lineStart = true;
+    QString message;
+    auto fail = [&](const char* what) {
+        if (message.isEmpty()) message = QString("第 %1 行：%2").arg(line).arg(QString::fromUtf8(what));
+    };
+    auto push = [&](PyToken::Kind kind, int start, int length, int value) {
+        PyToken token;
+        token.kind = kind;
+        token.start = start;
+        token.length = length;
+        token.line = line;
+        token.value = value;
+        tokens.push_back(token);
+    };
+    auto endLogicalLine = [&]() {
+        if (!tokens.empty() && tokens.back().kind != PyToken::Newline && tokens.back().kind != PyToken::Indent &&
+            tokens.back().kind != PyToken::Dedent) {
+            push(PyToken::Newline, 0, 0, 0);
+        }
+    };
+
+    int i = 0;
+    while (i < n) {
+        if (lineStart && depth == 0) {
+            lineStart = false;
+            int column = 0;
+            int j = i;
+            for (; j < n; ++j) {
+                const ushort c = text[j].unicode();
+                if (c == ' ') ++column;
+                else if (c == '\t') column = (column / 8 + 1) * 8;
+                else if (c == '\f') column = 0;
+                else break;
+            }
+            i = j;
+            if (j >= n) break;
+            // 空行与纯注释行不影响缩进
+            const uchar k = charClass(text[j].unicode());
+            if (k != LineBreak && k != Comment) {
+                if (column > indents.back()) {
+                    indents.push_back(column);
+                    push(PyToken::Indent, j, 0, 0);
+                } else if (column < indents.back()) {
+                    while (column < indents.back()) {
+                        indents.pop_back();
+                        push(PyToken::Dedent, j, 0, 0);
+                    }
+                    if (column != indents.back()) {
+                        fail("缩进与外层代码块不一致");
+                        indents.push_back(column);
+                        push(PyToken::Indent, j, 0, 0);
+                    }
+                }
+            }
+        }
+        const ushort c = text[i].unicode();
+        switch (charClass(c)) {
+        case Blank:
+            do ++i;
+            while (i < n && charClass(text[i].unicode()) == Blank);
+            break;
+        case LineBreak:
+            if (c == '\r' && i + 1 < n && text[i + 1].unicode() == '\n') ++i;
+            ++i;
+            ++line;
+            if (depth == 0) {
+                endLogicalLine();
+                lineStart = true;
+            }
+            break;
+        case Comment:
+            while (i < n && charClass(text[i].unicode()) != LineBreak) ++i;
+            break;
+        case Backslash:
+            // 反斜杠续行
+            ++i;
+            if (i < n && text[i].unicode() == '\r') ++i;
+            if (i < n && text[i].unicode() == '\n') ++i;
+            else if (i < n && text[i - 1].unicode() != '\r') fail("反斜杠后必须紧跟换行");
+            ++line;
+            break;
+        case NameStart: {
+            const int start = i;
+            uint hash = PyNameTable::kHashSeed;
+            for (ushort d; i < n && isNameChar(d = text[i].unicode()); ++i) hash = PyNameTable::hashStep(hash, d);
+            if (i < n && charClass(text[i].unicode()) == Quote && isStringPrefix(text + start, i - start)) {
+                i = start;  // 带前缀的字符串，交给下面的 Quote 分支从前缀处开始
+                goto quote;
+            }
+            push(PyToken::Name, start, i - start, names.intern(text + start, i - start, hash));
+            break;
+        }
+        case Digit:
+        number: {
+            const int start = i;
+            const bool radix = c == '0' && i + 1 < n && (text[i + 1].unicode() | 0x20) != 'e' && isNameChar(text[i + 1].unicode());
+            while (i < n) {
+                const ushort d = text[i].unicode();
+                if (isNameChar(d) || d == '.') {
+                    ++i;
+                } else if ((d == '+' || d == '-') && !radix && (text[i - 1].unicode() | 0x20) == 'e') {
+                    ++i;
+                } else {
+                    break;
+                }
+            }
+            push(PyToken::Number, start, i - start, 0);
+            break;
+        }
+        case Quote:
+        quote: {
+            const int start = i;
+            while (charClass(text[i].unicode()) != Quote) ++i;  // 跳过前缀
+            const ushort q = text[i].unicode();
+            const bool triple = i + 2 < n && text[i + 1].unicode() == q && text[i + 2].unicode() == q;
+            i += triple ? 3 : 1;
+            const int startLine = line;
+            bool closed = false;
+            while (i < n) {
+                const ushort d = text[i].unicode();
+                if (d == '\\') {
+                    if (i + 1 < n && text[i + 1].unicode() == '\n') ++line;
+                    i += 2;
+                    continue;
+                }
+                if (d == q) {
+                    if (!triple) {
+                        ++i;
+                        closed = true;
+                        break;
+                    }
+                    if (i + 2 < n && text[i + 1].unicode() == q && text[i + 2].unicode() == q) {
+                        i += 3;
+                        closed = true;
+                        break;
+                    }
+                } else if (d == '\n') {
+                    if (!triple) break;
+                    ++line;
+                }
+                ++i;
+            }
+            i = std::min(i, n);
+            if (!closed) {
+                const int endLine = line;
+                line = startLine;
+                fail("字符串没有结束");
+                line = endLine;
+            }
+            PyToken token;
+            token.kind = PyToken::String;
+            token.start = start;
+            token.length = i - start;
+            token.line = startLine;
+            tokens.push_back(token);
+            break;
+        }
+        case Punct: {
+            if (c == '.' && i + 1 < n && charClass(text[i + 1].unicode()) == Digit) goto number;
+            const ushort c2 = i + 1 < n ? text[i + 1].unicode() : 0;
+            const ushort c3 = i + 2 < n ? text[i + 2].unicode() : 0;
+            int op = 0;
+            int length = 1;
+            if (kChars.opStart[c] && c2 < 128 && charClass(c2) == Punct && c3 < 128) {
+                const int three = pyOp(char(c), char(c2), char(c3));
+                if (std::find(std::begin(kThreeCharOps), std::end(kThreeCharOps), three) != std::end(kThreeCharOps)) {
+                    op = three;
+                    length = 3;
+                }
+            }
+            if (!op && kChars.opStart[c] && c2 < 128 && charClass(c2) == Punct) {
+                const int two = pyOp(char(c), char(c2));
+                if (std::find(std::begin(kTwoCharOps), std::end(kTwoCharOps), two) != std::end(kTwoCharOps)) {
+                    op = two;
+                    length = 2;
+                }
+            }
+            if (!op) {
+                op = pyOp(char(c));
+                if (c == '(' || c == '[' || c == '{') ++depth;
+                else if ((c == ')' || c == ']' || c == '}') && depth > 0) --depth;
+            }
+            push(PyToken::Op, i, length, op);
+            i += length;
+            break;
+        }
+        default:
+            fail("无法识别的字符");
+            ++i;
+            break;
+        }
+    }
+    if (depth > 0) fail("括号没有闭合");
+    endLogicalLine();
+    while (indents.size() > 1) {
+        indents.pop_back();
+        push(PyToken::Dedent, n, 0, 0);
+    }
+    push(PyToken::End, n, 0, 0);
+    if (error) *error = message;
+    return message.isEmpty();
+}
+
+namespace {
+
+struct NamedModule
+{
+    const PyModule* module;
+    QString path;
+};
+
+// 按注册顺序深度优先展开，同一个模块实例只展开一次（与 named_modules 一致）。
+// 只有一个根时路径不带根的变量名
+std::vector<NamedModule> namedModules(const QVector<QPair<QString, PyModulePtr>>& roots) {
+    std::vector<NamedModule> stack;
+    for (int r = roots.size() - 1; r >= 0; --r) {
+        const PyModule* root = roots[r].second.get();
+        stack.push_back({root, roots.size() > 1 || (root && root->isLayer) ? roots[r].first : QString()});
+    }
+    std::unordered_set<const PyModule*> visited;
+    std::vector<NamedModule> result;
+    while (!stack.empty()) {
+        NamedModule item = stack.back();
+        stack.pop_back();
+        const PyModule* module = item.module;
+        if (!module || !visited.insert(module).second) continue;
+        for (int c = module->children.size() - 1; c >= 0; --c) {
+            const QString& name = module->children[c].first;
+            stack.push_back({module->children[c].second.get(), item.path.isEmpty() ? name : item.path + "." + name});
+        }
+        result.push_back(std::move(item));
+    }
+    return result;
+}
+
+} // namespace
+
+void PyLayer::writeJson(QJsonObject& object) const {
+    if (layerType.isEmpty()) {
+        if (!activationFunction.isEmpty()) object["activationFunction"] = activationFunction;
+        return;
+    }
+    object["layerType"] = layerType;
+    object["neurons"] = neurons;
+    object["activationFunction"] = activationFunction;
+    if (inputSize >= 0) object["inputSize"] = inputSize;
+    if (filters >= 0) object["filters"] = filters;
+    if (kernelSize >= 0) object["kernelSize"] = kernelSize;
+    if (poolingSize >= 0) object["poolingSize"] = poolingSize;
+    if (units >= 0) object["units"] = units;
+    if (dropoutRate >= 0.0) object["dropoutRate"] = dropoutRate;
+}
+
+QJsonArray PyTorchModel::layers() const {
+    // 激活函数已由 forward() 的数据流写进层时不再按注册顺序猜测
+    const bool traced = !nodes.isEmpty();
+    QJsonArray result;
+    const PyModule* previous = nullptr;
+    QString previousPath;
+    QString activation;  // 没有数据流时并入前一层的激活模块
+    auto flush = [&]() {
+        if (!previous) return;
+        QJsonObject object;
+        previous->layer.writeJson(object);
+        if (!activation.isEmpty()) object["activationFunction"] = activation;
+        object["name"] = previousPath;
+        result.append(object);
+    };
+    for (NamedModule& item : namedModules(roots)) {
+        const PyModule* module = item.module;
+        if (module->isLayer) {
+            flush();
+            previous = module;
+            previousPath = std::move(item.path);
+            activation.clear();
+        } else if (!traced && !module->activation.isEmpty() && previous &&
+                   previous->layer.activationFunction.isEmpty() && activation.isEmpty()) {
+            activation = module->activation;
+        }
+    }
+    flush();
+    return result;
+}
+
+QJsonObject PyTorchModel::graph() const {
+    std::vector<NamedModule> named = namedModules(roots);
+    std::unordered_map<const PyModule*, QString> paths;
+    paths.reserve(named.size());
+    for (NamedModule& item : named) paths.emplace(item.module, std::move(item.path));
+    QJsonArray nodeArray;
+    QJsonArray edgeArray;
+    for (int i = 0; i < nodes.size(); ++i) {
+        const PyGraphNode& node = nodes[i];
+        QJsonObject object;
+        node.layer.writeJson(object);
+        if (node.hasDim) object["dim"] = node.dim;
+        object["id"] = i;
+        object["op"] = node.op;
+        if (node.module) {
+            const auto it = paths.find(node.module.get());
+            object["name"] = it != paths.end() ? it->second : node.module->type;
+        } else {
+            object["name"] = node.name;
+        }
+        object["line"] = node.line;
+        nodeArray.append(object);
+        for (int from : node.inputs) {
+            QJsonObject edge;
+            edge["from"] = from;
+            edge["to"] = i;
+            edgeArray.append(edge);
+        }
+    }
+    QJsonArray outputArray;
+    for (int output : outputs) outputArray.append(output);
+    QJsonObject result;
+    result["nodes"] = nodeArray;
+    result["edges"] = edgeArray;
+    result["outputs"] = outputArray;
+    return result;
+}
+
+QVector<LayerEdge> layerEdges(const QJsonArray& layers, const QJsonObject& graph) {
+    QHash<QString, int> layerByName;
+    for (int i = 0; i < layers.size(); ++i) {
+        const QString name = layers[i].toObject()["name"].toString();
+        if (!name.isEmpty()) layerByName.insert(name, i);
+    }
+    const QJsonArray nodeArray = graph["nodes"].toArray();
+    const int n = nodeArray.size();
+    QVector<int> layerOf(n, -1);
+    QVector<QString> ops(n);
+    for (int i = 0; i < n; ++i) {
+        const QJsonObject node = nodeArray[i].toObject();
+        ops[i] = node["op"].toString();
+        if (ops[i] == "layer") layerOf[i] = layerByName.value(node["name"].toString(), -1);
+    }
+    QVector<QVector<int>> inputs(n);
+    for (const QJsonValue& value : graph["edges"].toArray()) {
+        const int from = value.toObject()["from"].toInt(-1);
+        const int to = value.toObject()["to"].toInt(-1);
+        if (from >= 0 && from < to && to < n) inputs[to].append(from);  // 节点按拓扑序排列，逆向的边忽略
+    }
+
+    // 每个节点能追溯到的最近的层（途中只经过非层节点），以及途中最后一个合并节点。
+    // 再次合并时，已经合并过的输入只取其中最后执行的层：残差网络里每个块的跳连只从上一块连出，
+    // 而不是连回前面所有的块；每个节点最多记 kMaxReach 个，宽的 concat 之后接长串非层节点时也保持线性
+    constexpr int kMaxReach = 64;
+    struct Reach
+    {
+        int layer;
+        int node;  // 该层在图中的节点
+        int via;   // 合并节点，-1 为没有经过合并
+    };
+    QVector<QVector<Reach>> reach(n);
+    QVector<LayerEdge> edges;
+    QSet<qint64> seen;
+    for (int i = 0; i < n; ++i) {
+        if (layerOf[i] >= 0) {
+            for (int from : inputs[i]) {
+                for (const Reach& r : reach[from]) {
+                    const qint64 key = qint64(r.layer) << 32 | uint(layerOf[i]);
+                    if (r.layer == layerOf[i] || seen.contains(key)) continue;
+                    seen.insert(key);
+                    edges.append({r.layer, layerOf[i], r.via >= 0 ? ops[r.via] : QString()});
+                }
+            }
+            reach[i] = {{layerOf[i], i, -1}};
+            continue;
+        }
+        const bool merge = inputs[i].size() > 1;
+        auto add = [&](const Reach& r) {
+            if (reach[i].size() >= kMaxReach) return;
+            for (const Reach& k : reach[i]) {
+                if (k.layer == r.layer) return;
+            }
+            reach[i].append({r.layer, r.node, merge ? i : r.via});
+        };
+        for (int from : inputs[i]) {
+            const QVector<Reach>& sources = reach[from];
+            if (merge && !sources.isEmpty() && sources[0].via >= 0) {
+                add(*std::max_element(sources.begin(), sources.end(),
+                                      [](const Reach& a, const Reach& b) { return a.node < b.node; }));
+                continue;
+            }
+            for (const Reach& r : sources) add(r);
+        }
+    }
+    std::sort(edges.begin(), edges.end(), [](const LayerEdge& a, const LayerEdge& b) {
+        return a.to != b.to ? a.to < b.to : a.from < b.from;
+    });
+    return edges;
+}
+
+QJsonObject nonChainGraph(const QJsonArray& layers, const QJsonObject& graph, QVector<LayerEdge>* edges) {
+    QVector<LayerEdge> result = graph.isEmpty() ? QVector<LayerEdge>() : layerEdges(layers, graph);
+    bool chain = result.size() == std::max(static_cast<int>(layers.size()) - 1, 0);
+    for (int i = 0; chain && i < result.size(); ++i)
+        chain = result[i].from == i && result[i].to == i + 1 && result[i].via.isEmpty();
+    if (chain) result.clear();
+    if (edges) *edges = result;
+    return chain ? QJsonObject() : graph;
+}
+
+namespace {
+
+struct Value;
+using ValueList = QVector<Value>;
+
+// 解释执行时的值：常量、列表/元组/字典、未解析的全局名（点分名，见 GlobalName）、模块实例、类与函数引用，
+// 以及执行 forward() 时的符号张量（只记录它来自数据流图的哪个节点）
+struct Value
+{
+    enum Kind : quint8 {
+        Unknown, NoneValue, Bool, Int, Float, Str, List, Tuple, Dict, Global, Module, Method, Class, Function, Super,
+        Tensor, TensorMethod
+    };
+    Kind kind = Unknown;
+    qint64 i = 0;                     // Bool / Int；Class / Function / Method 的下标（内置方法为 -1）；Super 的类下标；
+                                      // Global 的点分名下标；Tensor / TensorMethod 的图节点
+    double f = 0.0;
+    QString text;                     // Str
+    std::shared_ptr<ValueList> items; // List / Tuple / Dict（按 k0, v0, k1, v1 排放）；Method 的列表接收者
+    int module = -1;                  // Module；Method / Super 的模块接收者（解释器中的模块编号）
+    int name = -1;                    // Method / TensorMethod 的方法名（标识符编号）
+
+    static Value integer(qint64 v) {
+        Value r;
+        r.kind = Int;
+        r.i = v;
+        return r;
+    }
+    static Value boolean(bool v) {
+        Value r;
+        r.kind = Bool;
+        r.i = v;
+        return r;
+    }
+    static Value real(double v) {
+        Value r;
+        r.kind = Float;
+        r.f = v;
+        return r;
+    }
+    static Value string(const QString& s) {
+        Value r;
+        r.kind = Str;
+        r.text = s;
+        return r;
+    }
+    static Value global(int dotted) {
+        Value r;
+        r.kind = Global;
+        r.i = dotted;
+        return r;
+    }
+    static Value sequence(Kind kind, ValueList list = ValueList()) {
+        Value r;
+        r.kind = kind;
+        r.items = std::make_shared<ValueList>(std::move(list));
+        return r;
+    }
+    static Value fromModule(int m) {
+        Value r;
+        r.kind = Module;
+        r.module = m;
+        return r;
+    }
+    static Value tensor(int node) {
+        Value r;
+        r.kind = Tensor;
+        r.i = node;
+        return r;
+    }
+
+    bool isNumber() const { return kind == Int || kind == Bool || kind == Float; }
+    double number() const { return kind == Float ? f : double(i); }
+    bool isSequence() const { return kind == List || kind == Tuple; }
+};
+
+enum class Truth { False, True, Unknown };
+
+Truth truth(const Value& v) {
+    switch (v.kind) {
+    case Value::NoneValue: return Truth::False;
+    case Value::Bool:
+    case Value::Int: return v.i ? Truth::True : Truth::False;
+    case Value::Float: return v.f != 0.0 ? Truth::True : Truth::False;
+    case Value::Str: return v.text.isEmpty() ? Truth::False : Truth::True;
+    case Value::List:
+    case Value::Tuple:
+    case Value::Dict: return v.items->isEmpty() ? Truth::False : Truth::True;
+    case Value::Module:
+    case Value::Class:
+    case Value::Function: return Truth::True;
+    default: return Truth::Unknown;
+    }
+}
+
+// 整数参数；kernel_size=(3, 3) 这类元组取第一个元素
+int toInt(const Value& v, int fallback) {
+    if (v.kind == Value::Int || v.kind == Value::Bool) return static_cast<int>(v.i);
+    if (v.kind == Value::Float) return static_cast<int>(v.f);
+    if (v.isSequence() && !v.items->isEmpty()) return toInt(v.items->first(), fallback);
+    return fallback;
+}
+
+double toDouble(const Value& v, double fallback) {
+    return v.isNumber() ? v.number() : fallback;
+}
+
+// 函数式激活（F.relu、torch.sigmoid、x.tanh_() ……）对应的激活函数名，不是激活时为空
+QString functionalActivation(const QString& name) {
+    static const char* const kFunctional[][2] = {
+        {"relu", "relu"}, {"relu6", "relu"}, {"leaky_relu", "leaky_relu"}, {"sigmoid", "sigmoid"},
+        {"tanh", "tanh"}, {"softmax", "softmax"}, {"log_softmax", "softmax"}};
+    const QString base = name.endsWith('_') ? name.left(name.size() - 1) : name;
+    for (const auto& activation : kFunctional) {
+        if (base == QLatin1String(activation[0])) return QString::fromLatin1(activation[1]);
+    }
+    return QString();
+}
+
+bool isPythonBuiltin(const QString& name) {
+    static const char* const kBuiltins[] = {"len", "isinstance", "print", "range", "int", "float", "bool", "str", "type",
+                                            "hasattr", "getattr", "enumerate", "zip", "list", "tuple", "dict", "sum",
+                                            "max", "min", "reversed", "sorted", "any", "all", "id"};
+    for (const char* builtin : kBuiltins) {
+        if (name == QLatin1String(builtin)) return true;
+    }
+    return false;
+}
+
+// 两个张量逐元素或矩阵运算的合并节点名（torch.add / x.mul_ ……），不是时为空
+QString mergeOp(const QString& name) {
+    const QString base = name.endsWith('_') ? name.left(name.size() - 1) : name;
+    if (base == "add") return "add";
+    if (base == "sub" || base == "subtract") return "sub";
+    if (base == "mul" || base == "multiply") return "mul";
+    if (base == "div" || base == "divide") return "div";
+    if (base == "matmul" || base == "mm" || base == "bmm") return "matmul";
+    return QString();
+}
+
+struct CallArgs
+{
+    ValueList positional;
+    QVector<QPair<int, Value>> keywords;
+};
+
+struct FunctionInfo
+{
+    struct Param {
+        int name = -1;
+        Value defaultValue;
+        bool hasDefault = false;
+        int star = 0;  // 1：*args，2：**kwargs
+    };
+    int name = -1;
+    int ownerClass = -1;  // 定义在类体中时为该类
+    QVector<Param> params;
+    int body = 0;         // 冒号后第一个词法单元
+};
+
+struct ClassInfo
+{
+    int name = -1;
+    int line = 0;
+    int begin = 0;  // 类体的词法单元范围
+    int end = 0;
+    QVector<Value> bases;
+    QHash<int, Value> scope;  // 类体中的方法与类属性
+    bool isModule = false;
+};
+
+struct ModuleState
+{
+    int classIndex = -1;
+    QVector<int> children;       // 与 PyModule::children 一一对应的模块编号
+    bool isModule = true;        // 文件中的普通类实例为 false，赋给 self 时不注册为子模块
+    QHash<int, Value> attributes;
+    QHash<QString, int> childIndex;
+};
+
+struct Frame
+{
+    QHash<int, Value> vars;
+    bool transparent = false;  // 推导式作用域：查不到时继续查外层
+};
+
+// 关键字参数名、常用方法名、nn 模块名与内置函数名，构造时一次性驻留，执行时按编号比较
+enum NameId {
+    IdSelf, IdInit, IdInFeatures, IdOutFeatures, IdInChannels, IdOutChannels, IdKernelSize, IdInputSize,
+    IdHiddenSize, IdNonlinearity, IdP, IdAppend, IdExtend, IdInsert, IdAddModule, IdRegisterModule, IdItems,
+    IdKeys, IdValues, IdTo, IdCuda, IdCpu, IdFloat, IdDouble, IdHalf, IdTrain, IdEval, IdRequiresGrad, IdApply,
+    IdForward, IdDim,
+    IdNn, IdCollections, IdModule, IdParameter, IdLinear, IdLazyLinear, IdConv2d, IdLazyConv2d, IdMaxPool2d,
+    IdAvgPool2d, IdLstm, IdGru, IdRnn, IdDropout, IdDropout1d, IdDropout2d, IdAlphaDropout, IdFlatten, IdReLU,
+    IdReLU6, IdLeakyReLU, IdSigmoid, IdTanh, IdSoftmax, IdLogSoftmax, IdSequential, IdModuleList, IdModuleDict,
+    IdIdentity,
+    IdRange, IdLen, IdInt, IdList, IdTuple, IdMax, IdMin, IdEnumerate, IdZip, IdReversed, IdOrderedDict, IdDict,
+    IdSuper, IdCount
+};
+const char* const kNameIds[IdCount] = {
+    "self", "__init__", "in_features", "out_features", "in_channels", "out_channels", "kernel_size", "input_size",
+    "hidden_size", "nonlinearity", "p", "append", "extend", "insert", "add_module", "register_module", "items",
+    "keys", "values", "to", "cuda", "cpu", "float", "double", "half", "train", "eval", "requires_grad_", "apply",
+    "forward", "dim",
+    "nn", "collections", "Module", "Parameter", "Linear", "LazyLinear", "Conv2d", "LazyConv2d", "MaxPool2d",
+    "AvgPool2d", "LSTM", "GRU", "RNN", "Dropout", "Dropout1d", "Dropout2d", "AlphaDropout", "Flatten", "ReLU",
+    "ReLU6", "LeakyReLU", "Sigmoid", "Tanh", "Softmax", "LogSoftmax", "Sequential", "ModuleList", "ModuleDict",
+    "Identity",
+    "range", "len", "int", "list", "tuple", "max", "min", "enumerate", "zip", "reversed", "OrderedDict", "dict",
+    "super"};
+
+// 点分的全局名（torch.nn.Conv2d）：parent 为前一段的下标，第一段为 -1
+struct GlobalName
+{
+    int parent = -1;
+    int name = -1;
+};
+
+const int kMaxCallDepth = 64;
+const int kMaxLoopIterations = 1 << 16;
+// 表达式与代码块的递归层数：test()、unary()、not 与缩进块各算一层，一对括号约两层。
+// 每层约 3 KB 栈，100 层在 1 MB 的线程栈（Windows 默认）上也留有余量；CPython 的缩进上限同为 100
+const int kMaxNesting = 100;
+// 单个列表 / 元组拼接或重复、字符串拼接结果的元素（字符）上限，同时按元素数计入执行预算
+const qint64 kMaxSequenceElements = 1 << 20;
+
+class Interpreter
+{
+public:
+    explicit Interpreter(const QString& source) : m_source(source) {
+        for (int i = 0; i < IdCount; ++i) m_ids[i] = m_names.intern(QString::fromLatin1(kNameIds[i]));
+    }
+
+    PyTorchModel run();
+
+private:
+    using K = PyNameTable;
+
+    // ---- 词法单元 ----
+    const PyToken& tok() const { return m_tokens[m_pos]; }
+    const PyToken& peek(int ahead = 1) const {
+        return m_tokens[std::min<std::size_t>(m_pos + ahead, m_tokens.size() - 1)];
+    }
+    bool isOp(int op) const { return tok().kind == PyToken::Op && tok().value == op; }
+    bool isKeyword(int keyword) const { return tok().kind == PyToken::Name && tok().value == keyword; }
+    bool isKind(PyToken::Kind kind) const { return tok().kind == kind; }
+    bool acceptOp(int op) {
+        if (!isOp(op)) return false;
+        ++m_pos;
+        return true;
+    }
+    bool acceptKeyword(int keyword) {
+        if (!isKeyword(keyword)) return false;
+        ++m_pos;
+        return true;
+    }
+    void expectOp(int op) {
+        if (!acceptOp(op)) fail();
+    }
+    void fail() {
+        if (!m_syntaxError) {
+            m_syntaxError = true;
+            m_errorLine = tok().line;
+        }
+    }
+    bool evaluating() const { return m_skip == 0 && !m_syntaxError; }
+    QString tokenText(const PyToken& t) const { return m_source.mid(t.start, t.length); }
+
+    void skipBalanced();
+    void skipToNewline();
+    void skipSuite();
+    void skipStatement();
+
+    // ---- 语句 ----
+    void execSuite(bool run);
+    void execStatement();
+    void execSimpleStatements();
+    void execSmallStatement();
+    void execIf();
+    void execFor();
+    void execTry();
+    void execDef();
+    void execClass();
+    void execImport();
+    void execFrom();
+    void recover();
+    bool spend(qint64 cost = 1);
+    bool affordable(qint64 elements);
+
+    // 递归进入一层表达式或代码块；超过 kMaxNesting 时 ok 为 false，调用方不再向下解析
+    struct Nesting
+    {
+        explicit Nesting(Interpreter* in) : in(in), ok(++in->m_nesting <= kMaxNesting) {
+            if (!ok) in->warnOnce(QString("第 %1 行：括号、运算符或代码块嵌套超过 %2 层，其中的代码未解析").arg(in->tok().line).arg(kMaxNesting));
+        }
+        ~Nesting() { --in->m_nesting; }
+        Interpreter* in;
+        const bool ok;
+    };
+
+    // ---- 表达式 ----
+    Value testList();
+    Value test();
+    Value orTest();
+    Value andTest();
+    Value notTest();
+    Value comparison();
+    Value binary(int level);
+    Value unary();
+    Value power();
+    Value primary(int stop = -1);
+    Value atom();
+    static bool endsExpression(const PyToken& t);
+    bool comprehensionAhead() const;
+    Value comprehensionAt(int closeOp);
+    void element(ValueList& list);
+    Value parenthesized();
+    Value bracketed();
+    Value braced();
+    Value numberValue(const PyToken& t) const;
+    Value stringValue();
+    Value comprehension(int elementBegin, int closeOp);
+    CallArgs callArguments();
+    Value subscript(const Value& object);
+    Value attribute(const Value& object, int name);
+    Value lookup(int name);
+    int globalName(int parent, int name);
+    Value applyBinary(int op, const Value& a, const Value& b);
+    Value compare(int op, const Value& a, const Value& b) const;
+
+    // ---- 赋值与调用 ----
+    void assignTarget(int begin, int end, const Value& value);
+    void bind(int name, const Value& value);
+    void setAttribute(const Value& object, int name, const Value& value);
+    void setItem(const Value& object, const Value& key, const Value& value);
+    bool iterate(const Value& v, ValueList& out) const;
+    Value call(const Value& callee, const CallArgs& args, int line);
+    Value callFunction(int function, const Value* self, const CallArgs& args);
+    Value callMethod(const Value& method, const CallArgs& args, int line);
+    Value callGlobal(int dotted, const CallArgs& args, int line);
+    Value instantiate(int classIndex, const CallArgs& args, int line);
+    Value makeLeafModule(int type, const CallArgs& args, int line, bool* known);
+    int findMethod(int classIndex, int name, int depth = 0) const;
+    const Value* argument(const CallArgs& args, int position, NameId keyword) const;
+    PyModule& moduleAt(int id) { return *m_modules[id]; }
+    ModuleState& state(int id) { return m_moduleStates[id]; }
+    const ModuleState& state(int id) const { return m_moduleStates[id]; }
+    int newModule(const QString& type, int line);
+    void registerChild(int parent, const QString& name, int child);
+    void warnOnce(const QString& text);
+
+    // ---- forward() 数据流 ----
+    void traceForward(int m);
+    Value callModule(int m, const CallArgs& args, int line);
+    Value callTensorMethod(const Value& method, const CallArgs& args, int line);
+    Value callTensorFunction(const QString& name, const CallArgs& args, int line);
+    Value tensorBinary(int op, const Value& a, const Value& b);
+    int addNode(const QString& op, const QString& name, const QVector<int>& inputs, int line);
+    int addLayerNode(const char* layerType, const QString& name, int input, int line);
+    void collectTensors(const Value& v, QVector<int>& out, int depth = 0) const;
+    QVector<int> tensorArguments(const CallArgs& args) const;
+    void foldActivations();
+    void breakModuleCycles();
+
+    const QString& m_source;
+    PyNameTable m_names;
+    int m_ids[IdCount];
+    std::vector<PyToken> m_tokens;
+    std::size_t m_pos = 0;
+    int m_skip = 0;
+    bool m_syntaxError = false;
+    int m_errorLine = 0;
+    bool m_aborted = false;
+    qint64 m_budget = 0;
+
+    enum class Flow { Normal, Break, Continue, Return };
+    Flow m_flow = Flow::Normal;
+    Value m_returnValue;
+    int m_depth = 0;
+    int m_nesting = 0;
+    QVector<int> m_functionStack;  // 正在执行的函数
+    int m_classBody = -1;          // 正在执行类体时为该类
+
+    std::vector<Frame> m_frames;   // [0] 为模块作用域
+    std::vector<GlobalName> m_globalNames;
+    QHash<qint64, int> m_globalIndex;  // (parent + 1) << 32 | name -> m_globalNames 下标
+    std::vector<FunctionInfo> m_functions;
+    std::vector<ClassInfo> m_classes;
+    std::vector<PyModulePtr> m_modules;     // 按编号保存全部模块实例
+    std::vector<ModuleState> m_moduleStates;
+    QVector<QPair<int, int>> m_moduleLevelRoots;  // 变量名、模块编号
+    QStringList m_warnings;
+    QHash<QString, bool> m_warned;
+
+    QVector<PyGraphNode> m_nodes;  // forward() 数据流图；为空时还没有符号张量
+    QVector<int> m_outputs;
+};
+
+// ---------------------------------------------------------------- 跳过
+
+void Interpreter::skipBalanced() {
+    // 当前为左括号，跳到与之匹配的右括号之后
+    int depth = 0;
+    while (!isKind(PyToken::End)) {
+        const PyToken& t = tok();
+        ++m_pos;
+        if (t.kind != PyToken::Op) continue;
+        if (t.value == pyOp('(') || t.value == pyOp('[') || t.value == pyOp('{')) ++depth;
+        else if (t.value == pyOp(')') || t.value == pyOp(']') || t.value == pyOp('}')) {
+            if (--depth <= 0) return;
+        }
+    }
+}
+
+void Interpreter::skipToNewline() {
+    while (!isKind(PyToken::Newline) && !isKind(PyToken::End) && !isKind(PyToken::Dedent)) ++m_pos;
+    if (isKind(PyToken::Newline)) ++m_pos;
+}
+
+void Interpreter::skipSuite() {
+    // 冒号之后：同一行的简单语句，或换行 + 缩进块
+    if (!isKind(PyToken::Newline)) {
+        skipToNewline();
+        return;
+    }
+    ++m_pos;
+    if (!isKind(PyToken::Indent)) return;
+    int depth = 0;
+    while (!isKind(PyToken::End)) {
+        if (isKind(PyToken::Indent)) ++depth;
+        else if (isKind(PyToken::Dedent) && --depth == 0) {
+            ++m_pos;
+            return;
+        }
+        ++m_pos;
+    }
+}
+
+void Interpreter::skipStatement() {
+    // 一条逻辑行，若以冒号结尾的复合语句头后跟缩进块，则连同块一起跳过
+    skipToNewline();
+    if (isKind(PyToken::Indent)) {
+        --m_pos;
+        skipSuite();
+    }
+}
+
+// ---------------------------------------------------------------- 语句
+
+bool Interpreter::spend(qint64 cost) {
+    if (m_aborted) return false;
+    if ((m_budget -= cost) >= 0) return true;
+    m_aborted = true;
+    m_warnings << QString("第 %1 行：执行量超过上限（循环、递归过深或序列过大），之后的代码未解析").arg(tok().line);
+    return false;
+}
+
+bool Interpreter::affordable(qint64 elements) {
+    // 拼接 / 重复的结果先与上限比较再按元素数扣预算，x = x + x 之类的倍增很快耗尽预算而不是内存
+    if (elements > kMaxSequenceElements) {
+        warnOnce(QString("第 %1 行：序列或字符串超过 %2 个元素，结果按未知处理").arg(tok().line).arg(kMaxSequenceElements));
+        return false;
+    }
+    return spend(elements);
+}
+
+void Interpreter::recover() {
+    if (!m_syntaxError) return;
+    m_syntaxError = false;
+    warnOnce(QString("第 %1 行：无法解析的语句已跳过").arg(m_errorLine));
+    skipToNewline();
+    if (isKind(PyToken::Indent)) {
+        --m_pos;
+        skipSuite();
+    }
+}
+
+void Interpreter::execSuite(bool run) {
+    if (!run || m_aborted) {
+        skipSuite();
+        return;
+    }
+    const Nesting nesting(this);
+    if (!nesting.ok) {
+        skipSuite();
+        return;
+    }
+    if (!isKind(PyToken::Newline)) {
+        execSimpleStatements();
+        return;
+    }
+    ++m_pos;
+    if (!isKind(PyToken::Indent)) {
+        fail();
+        recover();
+        return;
+    }
+    ++m_pos;
+    while (!isKind(PyToken::Dedent) && !isKind(PyToken::End)) {
+        const std::size_t before = m_pos;
+        if (m_flow != Flow::Normal || m_aborted) skipStatement();
+        else execStatement();
+        if (m_pos == before) ++m_pos;  // 保证前进
+    }
+    if (isKind(PyToken::Dedent)) ++m_pos;
+}
+
+void Interpreter::execStatement() {
+    if (!spend()) {
+        skipStatement();
+        return;
+    }
+    const PyToken& t = tok();
+    if (t.kind == PyToken::Indent) {
+        // 多余的缩进：按普通代码块执行
+        ++m_pos;
+        while (!isKind(PyToken::Dedent) && !isKind(PyToken::End)) {
+            const std::size_t before = m_pos;
+            execStatement();
+            if (m_pos == before) ++m_pos;
+        }
+        if (isKind(PyToken::Dedent)) ++m_pos;
+        return;
+    }
+    if (t.kind == PyToken::Name && t.value < K::KeywordCount) {
+        switch (t.value) {
+        case K::If: execIf(); break;
+        case K::For: execFor(); break;
+        case K::Try: execTry(); break;
+        case K::Def: execDef(); break;
+        case K::Class: execClass(); break;
+        case K::While:
+            // 条件一般依赖运行时数据，整个循环跳过
+            skipStatement();
+            if (isKeyword(K::Else)) skipStatement();
+            break;
+        case K::With:
+            ++m_pos;
+            while (!isOp(pyOp(':')) && !isKind(PyToken::Newline) && !isKind(PyToken::End)) {
+                if (isOp(pyOp('(')) || isOp(pyOp('[')) || isOp(pyOp('{'))) skipBalanced();
+                else ++m_pos;
+            }
+            expectOp(pyOp(':'));
+            if (m_syntaxError) break;
+            execSuite(true);
+            break;
+        case K::Async:
+            ++m_pos;
+            execStatement();
+            break;
+        case K::Elif:
+        case K::Else:
+        case K::Except:
+        case K::Finally:
+            // 所属的复合语句已整体处理，这里只会出现在被跳过的分支之后
+            skipStatement();
+            break;
+        default: execSimpleStatements(); break;
+        }
+    } else if (t.kind == PyToken::Op && t.value == pyOp('@')) {
+        skipToNewline();  // 装饰器
+    } else {
+        execSimpleStatements();
+    }
+    recover();
+}
+
+void Interpreter::execSimpleStatements() {
+    while (true) {
+        execSmallStatement();
+        if (m_syntaxError) return;
+        if (acceptOp(pyOp(';')) && !isKind(PyToken::Newline) && !isKind(PyToken::End)) continue;
+        break;
+    }
+    if (isKind(PyToken::Newline)) ++m_pos;
+    else if (!isKind(PyToken::End) && !isKind(PyToken::Dedent)) fail();
+}
+
+void Interpreter::execSmallStatement() {
+    const PyToken& t = tok();
+    if (t.kind == PyToken::Name && t.value < K::KeywordCount) {
+        switch (t.value) {
+        case K::Pass: ++m_pos; return;
+        case K::Break: ++m_pos; m_flow = Flow::Break; return;
+        case K::Continue: ++m_pos; m_flow = Flow::Continue; return;
+        case K::Return:
+            ++m_pos;
+            m_returnValue = (isKind(PyToken::Newline) || isOp(pyOp(';')) || isKind(PyToken::End)) ? Value() : testList();
+            m_flow = Flow::Return;
+            return;
+        case K::Import: execImport(); return;
+        case K::From: execFrom(); return;
+        case K::Global:
+        case K::Nonlocal:
+        case K::Del:
+        case K::Assert:
+        case K::Raise:
+        case K::Yield:
+            while (!isKind(PyToken::Newline) && !isOp(pyOp(';')) && !isKind(PyToken::End)) {
+                if (isOp(pyOp('(')) || isOp(pyOp('[')) || isOp(pyOp('{'))) skipBalanced();
+                else ++m_pos;
+            }
+            return;
+        default: break;
+        }
+    }
+
+    // 表达式语句或赋值：先按表达式求值（赋值目标求值没有副作用），遇到 '=' 再把这一段当作目标。
+    // 最常见的 self.conv = ... / x, _ = ... 这类只由名字、点与逗号组成的目标不必求值
+    const int begin = static_cast<int>(m_pos);
+    std::size_t plain = m_pos;
+    while (m_tokens[plain].kind == PyToken::Name ? m_tokens[plain].value >= K::KeywordCount
+                                                 : m_tokens[plain].kind == PyToken::Op &&
+                                                       (m_tokens[plain].value == pyOp('.') || m_tokens[plain].value == pyOp(','))) {
+        ++plain;
+    }
+    Value value;
+    if (plain > m_pos && m_tokens[plain].kind == PyToken::Op && m_tokens[plain].value == pyOp('=')) m_pos = plain;
+    else value = testList();
+    if (m_syntaxError) return;
+    if (isOp(pyOp(':'))) {
+        // 类型标注：x: int = 1
+        const int end = static_cast<int>(m_pos);
+        ++m_pos;
+        ++m_skip;
+        test();
+        --m_skip;
+        if (!acceptOp(pyOp('='))) return;
+        const Value rhs = testList();
+        if (!m_syntaxError) assignTarget(begin, end, rhs);
+        return;
+    }
+    if (isOp(pyOp('='))) {
+        QVector<QPair<int, int>> targets;
+        targets.append({begin, static_cast<int>(m_pos)});
+        while (acceptOp(pyOp('='))) {
+            const int next = static_cast<int>(m_pos);
+            value = testList();
+            if (m_syntaxError) return;
+            if (isOp(pyOp('='))) targets.append({next, static_cast<int>(m_pos)});
+        }
+        const std::size_t end = m_pos;
+        for (const auto& target : targets) assignTarget(target.first, target.second, value);
+        m_pos = end;
+        return;
+    }
+    if (tok().kind == PyToken::Op && tok().length >= 2 && (tok().value >> 8 & 0xff) == '=' &&
+        tok().value != pyOp('=', '=')) {
+        // 增量赋值：a += b
+        const int op = tok().value & 0xff;
+        const int opTwo = tok().value & 0xffff;
+        const int end = static_cast<int>(m_pos);
+        ++m_pos;
+        const Value rhs = testList();
+        if (m_syntaxError) return;
+        const int binaryOp = (opTwo >> 8) == '=' ? op : opTwo;
+        Value result;
+        if (binaryOp == pyOp('+') && value.kind == Value::List && rhs.isSequence()) {
+            if (affordable(qint64(value.items->size()) + rhs.items->size())) {
+                *value.items += *rhs.items;  // 列表原地扩展
+                result = value;
+            }
+        } else {
+            result = applyBinary(binaryOp, value, rhs);
+        }
+        const std::size_t after = m_pos;
+        assignTarget(begin, end, result);
+        m_pos = after;
+        return;
+    }
+    if (tok().kind == PyToken::Op && tok().length == 3 && (tok().value >> 16) == '=') {
+        // **= //= >>= <<=
+        const int end = static_cast<int>(m_pos);
+        const int binaryOp = tok().value & 0xffff;
+        ++m_pos;
+        const Value rhs = testList();
+        if (m_syntaxError) return;
+        const Value result = applyBinary(binaryOp, value, rhs);
+        const std::size_t after = m_pos;
+        assignTarget(begin, end, result);
+        m_pos = after;
+    }
+}
+
+void Interpreter::execIf() {
+    ++m_pos;
+    Value condition = test();
+    expectOp(pyOp(':'));
+    if (m_syntaxError) return;
+    // 条件无法确定时执行 if 分支（多数模型的开关默认开启），其余分支跳过
+    bool taken = truth(condition) != Truth::False;
+    execSuite(taken);
+    while (isKeyword(K::Elif)) {
+        ++m_pos;
+        if (taken) ++m_skip;
+        condition = test();
+        if (taken) --m_skip;
+        expectOp(pyOp(':'));
+        if (m_syntaxError) return;
+        const bool run = !taken && truth(condition) != Truth::False;
+        execSuite(run);
+        taken = taken || run;
+    }
+    if (isKeyword(K::Else)) {
+        ++m_pos;
+        expectOp(pyOp(':'));
+        if (m_syntaxError) return;
+        execSuite(!taken);
+    }
+}
+
+void Interpreter::execFor() {
+    ++m_pos;
+    const int targetBegin = static_cast<int>(m_pos);
+    int depth = 0;
+    while (!isKind(PyToken::End) && !isKind(PyToken::Newline) && !(depth == 0 && isKeyword(K::In))) {
+        if (isOp(pyOp('(')) || isOp(pyOp('['))) ++depth;
+        else if (isOp(pyOp(')')) || isOp(pyOp(']'))) --depth;
+        ++m_pos;
+    }
+    const int targetEnd = static_cast<int>(m_pos);
+    if (!acceptKeyword(K::In)) {
+        fail();
+        return;
+    }
+    const Value iterable = testList();
+    expectOp(pyOp(':'));
+    if (m_syntaxError) return;
+    const std::size_t body = m_pos;
+    ValueList items;
+    const bool known = evaluating() && iterate(iterable, items);
+    bool broke = false;
+    int iterations = 0;
+    for (const Value& item : items) {
+        if (m_aborted || ++iterations > kMaxLoopIterations) break;
+        assignTarget(targetBegin, targetEnd, item);
+        m_pos = body;
+        execSuite(true);
+        if (m_flow == Flow::Break) {
+            m_flow = Flow::Normal;
+            broke = true;
+            break;
+        }
+        if (m_flow == Flow::Continue) m_flow = Flow::Normal;
+        if (m_flow == Flow::Return) break;
+    }
+    if (iterations == 0) {
+        m_pos = body;
+        skipSuite();
+    }
+    if (isKeyword(K::Else)) {
+        ++m_pos;
+        expectOp(pyOp(':'));
+        if (m_syntaxError) return;
+        execSuite(known && !broke && m_flow == Flow::Normal);
+    }
+}
+
+void Interpreter::execTry() {
+    ++m_pos;
+    expectOp(pyOp(':'));
+    if (m_syntaxError) return;
+    execSuite(true);
+    while (isKeyword(K::Except)) {
+        skipStatement();
+    }
+    if (isKeyword(K::Else)) {
+        ++m_pos;
+        expectOp(pyOp(':'));
+        if (m_syntaxError) return;
+        execSuite(true);
+    }
+    if (isKeyword(K::Finally)) {
+        ++m_pos;
+        expectOp(pyOp(':'));
+        if (m_syntaxError) return;
+        execSuite(true);
+    }
+}
+
+void Interpreter::execDef() {
+    ++m_pos;
+    if (!isKind(PyToken::Name)) {
+        fail();
+        return;
+    }
+    FunctionInfo function;
+    function.name = tok().value;
+    function.ownerClass = m_classBody;
+    ++m_pos;
+    expectOp(pyOp('('));
+    while (!m_syntaxError && !isOp(pyOp(')'))) {
+        FunctionInfo::Param param;
+        if (acceptOp(pyOp('*'))) param.star = 1;
+        else if (acceptOp(pyOp('*', '*'))) param.star = 2;
+        else if (acceptOp(pyOp('/'))) {
+            // 仅限位置参数的分隔符
+            if (!acceptOp(pyOp(','))) break;
+            continue;
+        }
+        if (isKind(PyToken::Name)) {
+            param.name = tok().value;
+            ++m_pos;
+            if (acceptOp(pyOp(':'))) {
+                ++m_skip;
+                test();
+                --m_skip;
+            }
+            if (acceptOp(pyOp('='))) {
+                param.defaultValue = test();
+                param.hasDefault = true;
+            }
+        }
+        if (param.name >= 0) function.params.append(param);
+        if (!acceptOp(pyOp(','))) break;
+    }
+    expectOp(pyOp(')'));
+    if (acceptOp(pyOp('-', '>'))) {
+        ++m_skip;
+        test();
+        --m_skip;
+    }
+    expectOp(pyOp(':'));
+    if (m_syntaxError) return;
+    function.body = static_cast<int>(m_pos);
+    skipSuite();
+    m_functions.push_back(function);
+    Value ref;
+    ref.kind = Value::Function;
+    ref.i = static_cast<qint64>(m_functions.size()) - 1;
+    bind(function.name, ref);
+}
+
+void Interpreter::execClass() {
+    ++m_pos;
+    if (!isKind(PyToken::Name)) {
+        fail();
+        return;
+    }
+    ClassInfo info;
+    info.name = tok().value;
+    info.line = tok().line;
+    ++m_pos;
+    if (acceptOp(pyOp('('))) {
+        if (!isOp(pyOp(')'))) {
+            const CallArgs bases = callArguments();
+            info.bases = bases.positional;
+        }
+        expectOp(pyOp(')'));
+    }
+    expectOp(pyOp(':'));
+    if (m_syntaxError) return;
+    for (const Value& base : info.bases) {
+        if (base.kind == Value::Global && m_names.name(m_globalNames[base.i].name).endsWith("Module")) info.isModule = true;
+        if (base.kind == Value::Class && m_classes[base.i].isModule) info.isModule = true;
+    }
+    info.begin = static_cast<int>(m_pos);
+    const int index = static_cast<int>(m_classes.size());
+    m_classes.push_back(info);
+
+    // 在类自己的作用域中执行类体，收集方法与类属性
+    Value ref;
+    ref.kind = Value::Class;
+    ref.i = index;
+    bind(info.name, ref);
+    const int outerClass = m_classBody;
+    m_classBody = index;
+    m_frames.emplace_back();
+    execSuite(true);
+    m_classes[index].scope = std::move(m_frames.back().vars);
+    m_frames.pop_back();
+    m_classBody = outerClass;
+    m_classes[index].end = static_cast<int>(m_pos);
+}
+
+void Interpreter::execImport() {
+    ++m_pos;
+    while (isKind(PyToken::Name)) {
+        const int first = globalName(-1, tok().value);
+        int dotted = first;
+        ++m_pos;
+        while (acceptOp(pyOp('.')) && isKind(PyToken::Name)) {
+            dotted = globalName(dotted, tok().value);
+            ++m_pos;
+        }
+        if (acceptKeyword(K::As) && isKind(PyToken::Name)) {
+            bind(tok().value, Value::global(dotted));
+            ++m_pos;
+        } else {
+            bind(m_globalNames[first].name, Value::global(first));
+        }
+        if (!acceptOp(pyOp(','))) break;
+    }
+}
+
+void Interpreter::execFrom() {
+    ++m_pos;
+    int module = -1;
+    while (isOp(pyOp('.')) || isOp(pyOp('.', '.', '.'))) ++m_pos;  // 相对导入
+    while (isKind(PyToken::Name) && !isKeyword(K::Import)) {
+        module = globalName(module, tok().value);
+        ++m_pos;
+        acceptOp(pyOp('.'));
+    }
+    if (!acceptKeyword(K::Import)) {
+        fail();
+        return;
+    }
+    const bool parenthesized = acceptOp(pyOp('('));
+    while (isKind(PyToken::Name) || isOp(pyOp('*'))) {
+        if (acceptOp(pyOp('*'))) break;
+        const int name = tok().value;
+        ++m_pos;
+        const Value imported = Value::global(globalName(module, name));
+        if (acceptKeyword(K::As) && isKind(PyToken::Name)) {
+            bind(tok().value, imported);
+            ++m_pos;
+        } else {
+            bind(name, imported);
+        }
+        if (!acceptOp(pyOp(','))) break;
+    }
+    if (parenthesized) expectOp(pyOp(')'));
+}
+
+// ---------------------------------------------------------------- 表达式
+
+Value Interpreter::testList() {
+    const bool starred = isOp(pyOp('*'));
+    ValueList list;
+    element(list);
+    if (!isOp(pyOp(',')) && !starred) return list.first();
+    while (!m_syntaxError && acceptOp(pyOp(','))) {
+        // 末尾逗号：后面已是赋值号、右括号或行尾
+        const PyToken& t = tok();
+        if (t.kind == PyToken::Newline || t.kind == PyToken::End ||
+            (t.kind == PyToken::Op && t.value != pyOp('(') && t.value != pyOp('[') && t.value != pyOp('{') &&
+             t.value != pyOp('*') && t.value != pyOp('-') && t.value != pyOp('+') && t.value != pyOp('~') &&
+             t.value != pyOp('.', '.', '.'))) {
+            break;
+        }
+        element(list);
+    }
+    return Value::sequence(Value::Tuple, std::move(list));
+}
+
+Value Interpreter::test() {
+    // 单个名字或数字后紧跟分隔符（实参、元素、下标、行尾）时直接取值，不必逐层下降
+    const PyToken& first = tok();
+    if ((first.kind == PyToken::Number || (first.kind == PyToken::Name && first.value >= K::KeywordCount)) &&
+        endsExpression(peek())) {
+        return atom();
+    }
+    const Nesting nesting(this);
+    if (!nesting.ok) {
+        fail();
+        return Value();
+    }
+    if (isKeyword(K::Lambda)) {
+        // lambda 参数: 表达式 —— 整体视为未知
+        ++m_pos;
+        while (!isOp(pyOp(':')) && !isKind(PyToken::Newline) && !isKind(PyToken::End)) ++m_pos;
+        expectOp(pyOp(':'));
+        ++m_skip;
+        test();
+        --m_skip;
+        return Value();
+    }
+    if (isKind(PyToken::Name) && peek().kind == PyToken::Op && peek().value == pyOp(':', '=')) {
+        // 海象运算符
+        const int name = tok().value;
+        m_pos += 2;
+        const Value v = test();
+        if (evaluating()) bind(name, v);
+        return v;
+    }
+    const Value v = orTest();
+    if (!isKeyword(K::If)) return v;
+    ++m_pos;
+    const Value condition = orTest();
+    if (!acceptKeyword(K::Else)) {
+        fail();
+        return Value();
+    }
+    const Value other = test();
+    const Truth t = truth(condition);
+    return t == Truth::True ? v : (t == Truth::False ? other : Value());
+}
+
+Value Interpreter::orTest() {
+    Value v = andTest();
+    while (acceptKeyword(K::Or)) {
+        const Value rhs = andTest();
+        const Truth t = truth(v);
+        v = t == Truth::True ? v : (t == Truth::False ? rhs : Value());
+    }
+    return v;
+}
+
+Value Interpreter::andTest() {
+    Value v = notTest();
+    while (acceptKeyword(K::And)) {
+        const Value rhs = notTest();
+        const Truth t = truth(v);
+        v = t == Truth::False ? v : (t == Truth::True ? rhs : Value());
+    }
+    return v;
+}
+
+Value Interpreter::notTest() {
+    if (acceptKeyword(K::Not)) {
+        const Nesting nesting(this);
+        if (!nesting.ok) {
+            fail();
+            return Value();
+        }
+        const Truth t = truth(notTest());
+        return t == Truth::Unknown ? Value() : Value::boolean(t == Truth::False);
+    }
+    return comparison();
+}
+
+Value Interpreter::comparison() {
+    Value v = binary(0);
+    while (true) {
+        int op = 0;
+        if (tok().kind == PyToken::Op) {
+            const int o = tok().value;
+            if (o == pyOp('<') || o == pyOp('>') || o == pyOp('=', '=') || o == pyOp('!', '=') || o == pyOp('<', '=') ||
+                o == pyOp('>', '=')) {
+                op = o;
+                ++m_pos;
+            }
+        } else if (isKeyword(K::In)) {
+            op = pyOp('i', 'n');
+            ++m_pos;
+        } else if (isKeyword(K::Is)) {
+            ++m_pos;
+            op = acceptKeyword(K::Not) ? pyOp('!', '=') : pyOp('=', '=');
+        } else if (isKeyword(K::Not) && peek().kind == PyToken::Name && peek().value == K::In) {
+            m_pos += 2;
+            op = pyOp('n', 'i');
+        }
+        if (!op) return v;
+        const Value rhs = binary(0);
+        v = evaluating() ? compare(op, v, rhs) : Value();
+    }
+}
+
+// 二元运算的优先级：| ^ & 移位 加减 乘除，不是二元运算符时为 -1
+int binaryLevel(const PyToken& t) {
+    if (t.kind != PyToken::Op) return -1;
+    switch (t.value) {
+    case pyOp('|'): return 0;
+    case pyOp('^'): return 1;
+    case pyOp('&'): return 2;
+    case pyOp('<', '<'):
+    case pyOp('>', '>'): return 3;
+    case pyOp('+'):
+    case pyOp('-'): return 4;
+    case pyOp('*'):
+    case pyOp('/'):
+    case pyOp('/', '/'):
+    case pyOp('%'):
+    case pyOp('@'): return 5;
+    default: return -1;
+    }
+}
+
+// 按优先级爬升：只处理优先级不低于 level 的运算符，同级左结合
+Value Interpreter::binary(int level) {
+    Value v = unary();
+    while (true) {
+        const int opLevel = binaryLevel(tok());
+        if (opLevel < level) break;
+        const int o = tok().value;
+        ++m_pos;
+        const Value rhs = binary(opLevel + 1);
+        v = evaluating() ? applyBinary(o, v, rhs) : Value();
+    }
+    return v;
+}
+
+Value Interpreter::unary() {
+    const Nesting nesting(this);
+    if (!nesting.ok) {
+        fail();
+        return Value();
+    }
+    if (isOp(pyOp('-')) || isOp(pyOp('+')) || isOp(pyOp('~'))) {
+        const int o = tok().value;
+        ++m_pos;
+        const Value v = unary();
+        if (!evaluating()) return Value();
+        if (v.kind == Value::Tensor) return v;
+        if (o == pyOp('+')) return v.isNumber() ? v : Value();
+        if (o == pyOp('-')) {
+            if (v.kind == Value::Float) return Value::real(-v.f);
+            if (v.kind == Value::Int || v.kind == Value::Bool) return Value::integer(-v.i);
+            return Value();
+        }
+        return v.kind == Value::Int ? Value::integer(~v.i) : Value();
+    }
+    return power();
+}
+
+Value Interpreter::power() {
+    if (acceptKeyword(K::Await)) return power();
+    const Value v = primary();
+    if (!acceptOp(pyOp('*', '*'))) return v;
+    const Value exponent = unary();
+    return evaluating() ? applyBinary(pyOp('*', '*'), v, exponent) : Value();
+}
+
+Value Interpreter::primary(int stop) {
+    Value v = atom();
+    while (!m_syntaxError && (stop < 0 || static_cast<int>(m_pos) < stop)) {
+        if (isOp(pyOp('.'))) {
+            ++m_pos;
+            if (!isKind(PyToken::Name)) {
+                fail();
+                return Value();
+            }
+            const int name = tok().value;
+            ++m_pos;
+            v = evaluating() ? attribute(v, name) : Value();
+        } else if (isOp(pyOp('('))) {
+            const int line = tok().line;
+            ++m_pos;
+            const CallArgs args = callArguments();
+            expectOp(pyOp(')'));
+            v = evaluating() ? call(v, args, line) : Value();
+        } else if (isOp(pyOp('['))) {
+            ++m_pos;
+            v = subscript(v);
+            expectOp(pyOp(']'));
+        } else {
+            break;
+        }
+    }
+    return v;
+}
+
+Value Interpreter::atom() {
+    const PyToken& t = tok();
+    switch (t.kind) {
+    case PyToken::Name:
+        if (t.value < K::KeywordCount) {
+            if (t.value == K::True || t.value == K::False) {
+                ++m_pos;
+                return Value::boolean(t.value == K::True);
+            }
+            if (t.value == K::None) {
+                ++m_pos;
+                Value none;
+                none.kind = Value::NoneValue;
+                return none;
+            }
+            if (t.value == K::Yield) {
+                ++m_pos;
+                if (!isOp(pyOp(')')) && !isKind(PyToken::Newline)) {
+                    ++m_skip;
+                    testList();
+                    --m_skip;
+                }
+                return Value();
+            }
+            fail();
+            return Value();
+        }
+        ++m_pos;
+        return evaluating() ? lookup(t.value) : Value();
+    case PyToken::Number:
+        ++m_pos;
+        return evaluating() ? numberValue(t) : Value();
+    case PyToken::String:
+        return stringValue();
+    case PyToken::Op:
+        if (t.value == pyOp('(')) return parenthesized();
+        if (t.value == pyOp('[')) return bracketed();
+        if (t.value == pyOp('{')) return braced();
+        if (t.value == pyOp('.', '.', '.')) {
+            ++m_pos;
+            return Value();
+        }
+        fail();
+        return Value();
+    default:
+        fail();
+        return Value();
+    }
+}
+
+bool Interpreter::endsExpression(const PyToken& t) {
+    if (t.kind == PyToken::Newline || t.kind == PyToken::End) return true;
+    return t.kind == PyToken::Op && (t.value == pyOp(',') || t.value == pyOp(')') || t.value == pyOp(']') ||
+                                     t.value == pyOp('}') || t.value == pyOp(':') || t.value == pyOp('='));
+}
+
+bool Interpreter::comprehensionAhead() const {
+    // 从当前位置向后看第一个元素：顶层出现 for 即为推导式
+    int depth = 0;
+    for (std::size_t p = m_pos; p < m_tokens.size(); ++p) {
+        const PyToken& t = m_tokens[p];
+        if (t.kind == PyToken::End) return false;
+        if (t.kind == PyToken::Name) {
+            if (depth == 0 && t.value == K::For) return true;
+            continue;
+        }
+        if (t.kind != PyToken::Op) continue;
+        if (t.value == pyOp('(') || t.value == pyOp('[') || t.value == pyOp('{')) {
+            ++depth;
+        } else if (t.value == pyOp(')') || t.value == pyOp(']') || t.value == pyOp('}')) {
+            if (--depth < 0) return false;
+        } else if (depth == 0 && t.value == pyOp(',')) {
+            return false;
+        }
+    }
+    return false;
+}
+
+Value Interpreter::comprehensionAt(int closeOp) {
+    // 推导式的元素先整体跳过一遍，找到 for 后再按元素逐个求值
+    const int elementBegin = static_cast<int>(m_pos);
+    ++m_skip;
+    test();
+    --m_skip;
+    if (!isKeyword(K::For) && !isKeyword(K::Async)) {
+        fail();
+        return Value();
+    }
+    return comprehension(elementBegin, closeOp);
+}
+
+void Interpreter::element(ValueList& list) {
+    // 一个元素，*x 展开为多个
+    if (acceptOp(pyOp('*'))) {
+        const Value v = binary(0);
+        ValueList items;
+        if (iterate(v, items)) list += items;
+        else list.append(Value());
+    } else {
+        list.append(test());
+    }
+}
+
+Value Interpreter::parenthesized() {
+    ++m_pos;
+    if (acceptOp(pyOp(')'))) return Value::sequence(Value::Tuple);
+    if (isKeyword(K::Yield)) {
+        const Value v = atom();
+        expectOp(pyOp(')'));
+        return v;
+    }
+    if (comprehensionAhead()) {
+        const Value v = comprehensionAt(pyOp(')'));
+        expectOp(pyOp(')'));
+        return v;
+    }
+    ValueList list;
+    bool tuple = isOp(pyOp('*'));
+    element(list);
+    while (!m_syntaxError && acceptOp(pyOp(','))) {
+        tuple = true;
+        if (isOp(pyOp(')'))) break;
+        element(list);
+    }
+    expectOp(pyOp(')'));
+    return tuple ? Value::sequence(Value::Tuple, std::move(list)) : list.first();
+}
+
+Value Interpreter::bracketed() {
+    ++m_pos;
+    if (acceptOp(pyOp(']'))) return Value::sequence(Value::List);
+    if (comprehensionAhead()) {
+        const Value v = comprehensionAt(pyOp(']'));
+        expectOp(pyOp(']'));
+        return v;
+    }
+    ValueList list;
+    element(list);
+    while (!m_syntaxError && acceptOp(pyOp(',')) && !isOp(pyOp(']'))) element(list);
+    expectOp(pyOp(']'));
+    return evaluating() ? Value::sequence(Value::List, std::move(list)) : Value();
+}
+
+Value Interpreter::braced() {
+    const std::size_t open = m_pos;
+    ++m_pos;
+    Value dict = Value::sequence(Value::Dict);
+    if (acceptOp(pyOp('}'))) return dict;
+    if (comprehensionAhead()) {
+        // 集合与字典推导不展开
+        m_pos = open;
+        skipBalanced();
+        return Value();
+    }
+    bool set = false;
+    while (!m_syntaxError) {
+        if (acceptOp(pyOp('*', '*'))) {
+            const Value other = binary(0);
+            if (other.kind == Value::Dict) *dict.items += *other.items;
+        } else {
+            const Value key = test();
+            if (acceptOp(pyOp(':'))) {
+                const Value value = test();
+                dict.items->append(key);
+                dict.items->append(value);
+            } else {
+                set = true;  // 集合：按列表保存
+                dict.items->append(key);
+            }
+        }
+        if (!acceptOp(pyOp(',')) || isOp(pyOp('}'))) break;
+    }
+    expectOp(pyOp('}'));
+    if (set) dict.kind = Value::List;
+    return dict;
+}
+
+Value Interpreter::numberValue(const PyToken& t) const {
+    const QChar* text = m_source.constData() + t.start;
+    qint64 v = 0;
+    int digits = 0;
+    for (int i = 0; i < t.length; ++i) {
+        const ushort c = text[i].unicode();
+        if (c >= '0' && c <= '9') {
+            v = v * 10 + (c - '0');
+            ++digits;
+        } else if (c != '_') {
+            digits = -1;
+            break;
+        }
+    }
+    if (digits > 0 && digits <= 18) return Value::integer(v);
+    QString s = tokenText(t).remove('_').toLower();
+    if (s.endsWith('j')) return Value();
+    bool ok = false;
+    if (s.startsWith("0x") || s.startsWith("0o") || s.startsWith("0b")) {
+        const int base = s[1] == 'x' ? 16 : (s[1] == 'o' ? 8 : 2);
+        const qint64 r = s.mid(2).toLongLong(&ok, base);
+        return ok ? Value::integer(r) : Value();
+    }
+    const double d = s.toDouble(&ok);
+    return ok ? Value::real(d) : Value();
+}
+
+Value Interpreter::stringValue() {
+    // 相邻的字符串字面量拼接；只去掉前缀与引号，不处理转义
+    QString text;
+    while (isKind(PyToken::String)) {
+        const PyToken& t = tok();
+        ++m_pos;
+        if (!evaluating()) continue;
+        const QChar* p = m_source.constData() + t.start;
+        int prefix = 0;
+        while (prefix < t.length && p[prefix].unicode() != '\'' && p[prefix].unicode() != '"') ++prefix;
+        const int quote = prefix + 2 < t.length && p[prefix + 1] == p[prefix] && p[prefix + 2] == p[prefix] ? 3 : 1;
+        const int length = t.length - prefix - 2 * quote;
+        if (length > 0) text += m_source.mid(t.start + prefix + quote, length);
+    }
+    return evaluating() ? Value::string(text) : Value();
+}
+
+Value Interpreter::comprehension(int elementBegin, int closeOp) {
+    // 当前为 for；只展开单层 for（可带 if 过滤），嵌套 for 返回未知
+    const std::size_t open = static_cast<std::size_t>(elementBegin) - 1;
+    acceptKeyword(K::Async);
+    ++m_pos;
+    const int targetBegin = static_cast<int>(m_pos);
+    int depth = 0;
+    while (!isKind(PyToken::End) && !(depth == 0 && isKeyword(K::In))) {
+        if (isOp(pyOp('(')) || isOp(pyOp('['))) ++depth;
+        else if (isOp(pyOp(')')) || isOp(pyOp(']'))) --depth;
+        ++m_pos;
+    }
+    const int targetEnd = static_cast<int>(m_pos);
+    if (!acceptKeyword(K::In)) {
+        fail();
+        return Value();
+    }
+    const Value iterable = orTest();
+    QVector<int> conditions;
+    while (isKeyword(K::If)) {
+        ++m_pos;
+        conditions.append(static_cast<int>(m_pos));
+        ++m_skip;
+        orTest();
+        --m_skip;
+    }
+    if (!isOp(closeOp)) {
+        m_pos = open;
+        skipBalanced();
+        --m_pos;  // 留给调用方 expectOp
+        return Value();
+    }
+    const std::size_t end = m_pos;
+    ValueList items;
+    if (!evaluating() || !iterate(iterable, items)) return Value();
+
+    Frame frame;
+    frame.transparent = true;
+    m_frames.push_back(frame);
+    ValueList result;
+    int iterations = 0;
+    for (const Value& item : items) {
+        if (++iterations > kMaxLoopIterations || !spend()) break;
+        assignTarget(targetBegin, targetEnd, item);
+        bool keep = true;
+        for (int condition : conditions) {
+            m_pos = condition;
+            if (truth(orTest()) == Truth::False) keep = false;
+        }
+        if (!keep) continue;
+        m_pos = elementBegin;
+        result.append(test());
+        if (m_syntaxError) break;
+    }
+    m_frames.pop_back();
+    m_pos = end;
+    return Value::sequence(Value::List, std::move(result));
+}
+
+CallArgs Interpreter::callArguments() {
+    CallArgs args;
+    while (!m_syntaxError && !isOp(pyOp(')')) && !isKind(PyToken::End)) {
+        if (acceptOp(pyOp('*'))) {
+            const Value v = test();
+            ValueList items;
+            if (iterate(v, items)) args.positional += items;
+            else args.positional.append(Value());
+        } else if (acceptOp(pyOp('*', '*'))) {
+            const Value v = test();
+            if (v.kind == Value::Dict) {
+                for (int i = 0; i + 1 < v.items->size(); i += 2) {
+                    const Value& key = v.items->at(i);
+                    if (key.kind == Value::Str) args.keywords.append({m_names.intern(key.text), v.items->at(i + 1)});
+                }
+            }
+        } else if (isKind(PyToken::Name) && peek().kind == PyToken::Op && peek().value == pyOp('=')) {
+            const int name = tok().value;
+            m_pos += 2;
+            args.keywords.append({name, test()});
+        } else if (args.positional.isEmpty() && args.keywords.isEmpty() && comprehensionAhead()) {
+            // 生成器表达式只能是唯一的实参
+            args.positional.append(comprehensionAt(pyOp(')')));
+        } else {
+            args.positional.append(test());
+        }
+        if (!acceptOp(pyOp(','))) break;
+    }
+    return args;
+}
+
+Value Interpreter::subscript(const Value& object) {
+    // 下标或切片；只对常量下标求值，省略的切片边界记为 None
+    auto part = [&]() -> Value {
+        if (isOp(pyOp(':')) || isOp(pyOp(']')) || isOp(pyOp(','))) {
+            Value none;
+            none.kind = Value::NoneValue;
+            return none;
+        }
+        return test();
+    };
+    Value index = part();
+    Value bounds[3] = {index};
+    int slice = 0;
+    while (acceptOp(pyOp(':'))) {
+        const Value bound = part();
+        if (++slice < 3) bounds[slice] = bound;
+    }
+    bool tuple = false;
+    while (acceptOp(pyOp(','))) {
+        tuple = true;
+        if (isOp(pyOp(']'))) break;
+        part();
+        while (acceptOp(pyOp(':'))) part();
+    }
+    if (!evaluating()) return Value();
+    if (object.kind == Value::Tensor) return object;  // 索引与切片不改变数据来源
+    if (tuple) return Value();
+    if (slice) {
+        if (!object.isSequence() || slice > 2) return Value();
+        if (slice == 1) bounds[2].kind = Value::NoneValue;
+        for (const Value& bound : bounds) {
+            if (bound.kind != Value::Int && bound.kind != Value::NoneValue) return Value();
+        }
+        const qint64 size = object.items->size();
+        const qint64 step = bounds[2].kind == Value::Int ? bounds[2].i : 1;
+        if (step == 0) return Value();
+        auto clampIndex = [&](const Value& bound, qint64 fallback) {
+            if (bound.kind != Value::Int) return fallback;
+            const qint64 i = bound.i < 0 ? bound.i + size : bound.i;
+            return step > 0 ? std::clamp<qint64>(i, 0, size) : std::clamp<qint64>(i, -1, size - 1);
+        };
+        const qint64 start = clampIndex(bounds[0], step > 0 ? 0 : size - 1);
+        const qint64 stop = clampIndex(bounds[1], step > 0 ? size : -1);
+        ValueList items;
+        for (qint64 i = start; step > 0 ? i < stop : i > stop; i += step) items.append(object.items->at(int(i)));
+        return Value::sequence(object.kind, std::move(items));
+    }
+    if (object.kind == Value::Dict) {
+        for (int i = 0; i + 1 < object.items->size(); i += 2) {
+            const Value& key = object.items->at(i);
+            if (compare(pyOp('=', '='), key, index).i) return object.items->at(i + 1);
+        }
+        return Value();
+    }
+    if (index.kind != Value::Int) {
+        if (object.kind == Value::Module && index.kind == Value::Str) {
+            const ModuleState& s = state(object.module);
+            const auto it = s.childIndex.find(index.text);
+            if (it != s.childIndex.end()) return Value::fromModule(s.children[it.value()]);
+        }
+        return Value();
+    }
+    if (object.isSequence()) {
+        qint64 i = index.i < 0 ? index.i + object.items->size() : index.i;
+        return i >= 0 && i < object.items->size() ? object.items->at(static_cast<int>(i)) : Value();
+    }
+    if (object.kind == Value::Module) {
+        const QVector<int>& children = state(object.module).children;
+        qint64 i = index.i < 0 ? index.i + children.size() : index.i;
+        return i >= 0 && i < children.size() ? Value::fromModule(children[static_cast<int>(i)]) : Value();
+    }
+    return Value();
+}
+
+Value Interpreter::attribute(const Value& object, int name) {
+    switch (object.kind) {
+    case Value::Global:
+        return Value::global(globalName(static_cast<int>(object.i), name));
+    case Value::Module: {
+        const ModuleState& s = state(object.module);
+        const auto it = s.attributes.find(name);
+        if (it != s.attributes.end()) return it.value();
+        const int method = s.classIndex >= 0 ? findMethod(s.classIndex, name) : -1;
+        Value bound;
+        bound.kind = Value::Method;
+        bound.module = object.module;
+        bound.i = method;
+        if (method >= 0) return bound;
+        if (name == m_ids[IdAppend] || name == m_ids[IdExtend] || name == m_ids[IdInsert] || name == m_ids[IdAddModule] ||
+            name == m_ids[IdRegisterModule] || name == m_ids[IdTo] || name == m_ids[IdCuda] || name == m_ids[IdCpu] ||
+            name == m_ids[IdFloat] || name == m_ids[IdDouble] || name == m_ids[IdHalf] || name == m_ids[IdTrain] ||
+            name == m_ids[IdEval] || name == m_ids[IdRequiresGrad] || name == m_ids[IdApply]) {
+            bound.name = name;
+            return bound;
+        }
+        return Value();
+    }
+    case Value::Super: {
+        // super().method：从当前类的基类开始找
+        const ClassInfo& info = m_classes[object.i];
+        for (const Value& base : info.bases) {
+            if (base.kind != Value::Class) continue;
+            const int method = findMethod(static_cast<int>(base.i), name);
+            if (method < 0) continue;
+            Value bound;
+            bound.kind = Value::Method;
+            bound.module = object.module;
+            bound.i = method;
+            return bound;
+        }
+        return Value();
+    }
+    case Value::List:
+    case Value::Dict:
+        if (name == m_ids[IdAppend] || name == m_ids[IdExtend] || name == m_ids[IdInsert] || name == m_ids[IdItems] ||
+            name == m_ids[IdKeys] || name == m_ids[IdValues]) {
+            Value bound;
+            bound.kind = Value::Method;
+            bound.items = object.items;
+            bound.i = -1;
+            bound.name = name;
+            return bound;
+        }
+        return Value();
+    case Value::Class: {
+        const auto& scope = m_classes[object.i].scope;
+        const auto it = scope.find(name);
+        return it != scope.end() ? it.value() : Value();
+    }
+    case Value::Tensor: {
+        // 转置等视图原样传出，shape 不是张量，其余记为方法，调用时再区分
+        const QString& text = m_names.name(name);
+        if (text == "T" || text == "mT" || text == "data") return object;
+        if (text == "shape") return Value();
+        Value bound;
+        bound.kind = Value::TensorMethod;
+        bound.i = object.i;
+        bound.name = name;
+        return bound;
+    }
+    default:
+        return Value();
+    }
+}
+
+Value Interpreter::lookup(int name) {
+    for (auto frame = m_frames.rbegin(); frame != m_frames.rend(); ++frame) {
+        const auto it = frame->vars.find(name);
+        if (it != frame->vars.end()) return it.value();
+        if (!frame->transparent) break;
+    }
+    if (m_frames.size() > 1) {
+        const auto it = m_frames.front().vars.find(name);
+        if (it != m_frames.front().vars.end()) return it.value();
+    }
+    return Value::global(globalName(-1, name));
+}
+
+int Interpreter::globalName(int parent, int name) {
+    const qint64 key = qint64(parent + 1) << 32 | quint32(name);
+    const auto it = m_globalIndex.find(key);
+    if (it != m_globalIndex.end()) return it.value();
+    GlobalName dotted;
+    dotted.parent = parent;
+    dotted.name = name;
+    m_globalNames.push_back(dotted);
+    m_globalIndex.insert(key, static_cast<int>(m_globalNames.size()) - 1);
+    return static_cast<int>(m_globalNames.size()) - 1;
+}
+
+Value Interpreter::applyBinary(int op, const Value& a, const Value& b) {
+    if (a.kind == Value::Tensor || b.kind == Value::Tensor) return tensorBinary(op, a, b);
+    if (a.isNumber() && b.isNumber()) {
+        const bool integral = a.kind != Value::Float && b.kind != Value::Float;
+        if (integral) {
+            const qint64 x = a.i;
+            const qint64 y = b.i;
+            switch (op) {
+            case pyOp('+'): return Value::integer(x + y);
+            case pyOp('-'): return Value::integer(x - y);
+            case pyOp('*'): return Value::integer(x * y);
+            case pyOp('/'): return y != 0 ? Value::real(double(x) / double(y)) : Value();
+            case pyOp('/', '/'): {
+                if (y == 0) return Value();
+                qint64 q = x / y;
+                if ((x % y != 0) && ((x < 0) != (y < 0))) --q;
+                return Value::integer(q);
+            }
+            case pyOp('%'): {
+                if (y == 0) return Value();
+                qint64 r = x % y;
+                if (r != 0 && ((r < 0) != (y < 0))) r += y;
+                return Value::integer(r);
+            }
+            case pyOp('*', '*'):
+                if (y >= 0 && y < 63) {
+                    qint64 r = 1;
+                    for (qint64 k = 0; k < y; ++k) r *= x;
+                    return Value::integer(r);
+                }
+                return Value::real(std::pow(double(x), double(y)));
+            case pyOp('<', '<'): return y >= 0 && y < 63 ? Value::integer(x << y) : Value();
+            case pyOp('>', '>'): return y >= 0 && y < 63 ? Value::integer(x >> y) : Value();
+            case pyOp('|'): return Value::integer(x | y);
+            case pyOp('&'): return Value::integer(x & y);
+            case pyOp('^'): return Value::integer(x ^ y);
+            default: return Value();
+            }
+        }
+        const double x = a.number();
+        const double y = b.number();
+        switch (op) {
+        case pyOp('+'): return Value::real(x + y);
+        case pyOp('-'): return Value::real(x - y);
+        case pyOp('*'): return Value::real(x * y);
+        case pyOp('/'): return y != 0.0 ? Value::real(x / y) : Value();
+        case pyOp('/', '/'): return y != 0.0 ? Value::real(std::floor(x / y)) : Value();
+        case pyOp('*', '*'): return Value::real(std::pow(x, y));
+        default: return Value();
+        }
+    }
+    if (op == pyOp('+') && a.kind == Value::Str && b.kind == Value::Str) {
+        if (!affordable(qint64(a.text.size()) + b.text.size())) return Value();
+        return Value::string(a.text + b.text);
+    }
+    if (op == pyOp('+') && a.isSequence() && b.isSequence()) {
+        if (!affordable(qint64(a.items->size()) + b.items->size())) return Value();
+        return Value::sequence(a.kind, *a.items + *b.items);
+    }
+    if (op == pyOp('*') && a.isSequence() && b.kind == Value::Int) {
+        const qint64 count = std::max<qint64>(0, std::min<qint64>(b.i, kMaxSequenceElements + 1));
+        if (!affordable(a.items->size() * count)) return Value();
+        ValueList repeated;
+        repeated.reserve(static_cast<int>(a.items->size() * count));
+        for (qint64 k = 0; k < count; ++k) repeated += *a.items;
+        return Value::sequence(a.kind, std::move(repeated));
+    }
+    return Value();
+}
+
+Value Interpreter::compare(int op, const Value& a, const Value& b) const {
+    if (op == pyOp('i', 'n') || op == pyOp('n', 'i')) {
+        if (!b.isSequence() && b.kind != Value::Dict) return Value();
+        const int step = b.kind == Value::Dict ? 2 : 1;
+        bool found = false;
+        for (int i = 0; i < b.items->size(); i += step) {
+            const Value eq = compare(pyOp('=', '='), a, b.items->at(i));
+            if (eq.kind != Value::Bool) return Value();
+            if (eq.i) found = true;
+        }
+        return Value::boolean(op == pyOp('i', 'n') ? found : !found);
+    }
+    int order = 0;
+    bool known = true;
+    if (a.isNumber() && b.isNumber()) {
+        order = a.number() < b.number() ? -1 : (a.number() > b.number() ? 1 : 0);
+    } else if (a.kind == Value::Str && b.kind == Value::Str) {
+        order = a.text < b.text ? -1 : (b.text < a.text ? 1 : 0);
+    } else if (a.kind == Value::NoneValue || b.kind == Value::NoneValue) {
+        if (a.kind == Value::Unknown || b.kind == Value::Unknown) return Value();
+        order = a.kind == b.kind ? 0 : 1;
+        if (op != pyOp('=', '=') && op != pyOp('!', '=')) known = false;
+    } else {
+        known = false;
+    }
+    if (!known) return Value();
+    switch (op) {
+    case pyOp('<'): return Value::boolean(order < 0);
+    case pyOp('>'): return Value::boolean(order > 0);
+    case pyOp('=', '='): return Value::boolean(order == 0);
+    case pyOp('!', '='): return Value::boolean(order != 0);
+    case pyOp('<', '='): return Value::boolean(order <= 0);
+    case pyOp('>', '='): return Value::boolean(order >= 0);
+    default: return Value();
+    }
+}
+
+// ---------------------------------------------------------------- 赋值
+
+void Interpreter::assignTarget(int begin, int end, const Value& value) {
+    if (begin >= end) return;
+    const std::size_t saved = m_pos;
+    // 整段被一对括号包住时去掉括号
+    if (m_tokens[begin].kind == PyToken::Op &&
+        (m_tokens[begin].value == pyOp('(') || m_tokens[begin].value == pyOp('['))) {
+        m_pos = begin;
+        skipBalanced();
+        if (static_cast<int>(m_pos) == end) {
+            m_pos = saved;
+            assignTarget(begin + 1, end - 1, value.kind == Value::Unknown || value.isSequence()
+                                                 ? value
+                                                 : Value::sequence(Value::Tuple, ValueList{value}));
+            return;
+        }
+    }
+    // 顶层逗号拆分为多个目标，按元素解包
+    QVector<QPair<int, int>> parts;
+    int depth = 0;
+    int partBegin = begin;
+    int lastDot = -1;
+    int lastBracket = -1;
+    for (int i = begin; i < end; ++i) {
+        const PyToken& t = m_tokens[i];
+        if (t.kind != PyToken::Op) continue;
+        if (t.value == pyOp('(') || t.value == pyOp('[') || t.value == pyOp('{')) {
+            if (depth == 0 && t.value == pyOp('[')) lastBracket = i;
+            ++depth;
+        } else if (t.value == pyOp(')') || t.value == pyOp(']') || t.value == pyOp('}')) {
+            --depth;
+        } else if (depth == 0 && t.value == pyOp(',')) {
+            parts.append({partBegin, i});
+            partBegin = i + 1;
+        } else if (depth == 0 && t.value == pyOp('.')) {
+            lastDot = i;
+        }
+    }
+    if (!parts.isEmpty()) {
+        if (partBegin < end) parts.append({partBegin, end});
+        ValueList items;
+        const bool known = iterate(value, items);
+        int starred = -1;  // a, *rest, b = ...：星号目标之后的元素从末尾对齐
+        for (int k = 0; k < parts.size(); ++k) {
+            const PyToken& first = m_tokens[parts[k].first];
+            if (first.kind == PyToken::Op && first.value == pyOp('*')) starred = k;
+        }
+        for (int k = 0; k < parts.size(); ++k) {
+            if (k == starred) {
+                ValueList rest;
+                for (int j = k; known && j < items.size() - (parts.size() - k - 1); ++j) rest.append(items[j]);
+                assignTarget(parts[k].first + 1, parts[k].second, known ? Value::sequence(Value::List, rest) : Value());
+                continue;
+            }
+            const int index = starred >= 0 && k > starred ? items.size() - (parts.size() - k) : k;
+            assignTarget(parts[k].first, parts[k].second,
+                         known && index >= 0 && index < items.size() ? items[index] : Value());
+        }
+        m_pos = saved;
+        return;
+    }
+    const PyToken& last = m_tokens[end - 1];
+    if (end - begin == 1 && last.kind == PyToken::Name) {
+        bind(last.value, value);
+    } else if (lastDot > lastBracket && lastDot == end - 2 && last.kind == PyToken::Name) {
+        m_pos = begin;
+        const Value object = primary(lastDot);
+        if (!m_syntaxError) setAttribute(object, last.value, value);
+    } else if (lastBracket > lastDot && last.kind == PyToken::Op && last.value == pyOp(']')) {
+        m_pos = begin;
+        const Value object = primary(lastBracket);
+        m_pos = lastBracket + 1;
+        const Value key = test();
+        if (!m_syntaxError) setItem(object, key, value);
+    }
+    m_syntaxError = false;
+    m_pos = saved;
+}
+
+void Interpreter::bind(int name, const Value& value) {
+    m_frames.back().vars.insert(name, value);
+    if (m_frames.size() == 1 && value.kind == Value::Module && state(value.module).isModule) {
+        // 模块级变量：记为根模块，同名重新赋值时替换
+        for (auto& root : m_moduleLevelRoots) {
+            if (root.first == name) {
+                root.second = value.module;
+                return;
+            }
+        }
+        m_moduleLevelRoots.append({name, value.module});
+    }
+}
+
+void Interpreter::setAttribute(const Value& object, int name, const Value& value) {
+    if (object.kind != Value::Module) return;
+    ModuleState& s = state(object.module);
+    s.attributes.insert(name, value);
+    if (value.kind == Value::Module && state(value.module).isModule && s.isModule) {
+        registerChild(object.module, m_names.name(name), value.module);
+    } else if (value.kind == Value::List && s.isModule) {
+        for (const Value& item : *value.items) {
+            if (item.kind == Value::Module) {
+                warnOnce(QString("self.%1 是普通 list，其中的模块不会被注册（应使用 nn.ModuleList）").arg(m_names.name(name)));
+                break;
+            }
+        }
+    }
+}
+
+void Interpreter::setItem(const Value& object, const Value& key, const Value& value) {
+    if (object.kind == Value::List && key.kind == Value::Int) {
+        const qint64 i = key.i < 0 ? key.i + object.items->size() : key.i;
+        if (i >= 0 && i < object.items->size()) (*object.items)[static_cast<int>(i)] = value;
+    } else if (object.kind == Value::Dict) {
+        for (int i = 0; i + 1 < object.items->size(); i += 2) {
+            if (compare(pyOp('=', '='), object.items->at(i), key).i) {
+                (*object.items)[i + 1] = value;
+                return;
+            }
+        }
+        object.items->append(key);
+        object.items->append(value);
+    } else if (object.kind == Value::Module && value.kind == Value::Module) {
+        if (key.kind == Value::Str) {
+            registerChild(object.module, key.text, value.module);
+        } else if (key.kind == Value::Int && key.i >= 0 && key.i < state(object.module).children.size()) {
+            state(object.module).children[static_cast<int>(key.i)] = value.module;
+            moduleAt(object.module).children[static_cast<int>(key.i)].second = m_modules[value.module];
+        }
+    }
+}
+
+bool Interpreter::iterate(const Value& v, ValueList& out) const {
+    switch (v.kind) {
+    case Value::List:
+    case Value::Tuple:
+        out = *v.items;
+        return true;
+    case Value::Dict:
+        out.clear();
+        for (int i = 0; i < v.items->size(); i += 2) out.append(v.items->at(i));
+        return true;
+    case Value::Module:
+        out.clear();
+        for (int child : state(v.module).children) out.append(Value::fromModule(child));
+        return true;
+    default:
+        return false;
+    }
+}
+
+// ---------------------------------------------------------------- 调用
+
+const Value* Interpreter::argument(const CallArgs& args, int position, NameId keyword) const {
+    if (position >= 0 && position < args.positional.size()) return &args.positional[position];
+    for (const auto& kw : args.keywords) {
+        if (kw.first == m_ids[keyword]) return &kw.second;
+    }
+    return nullptr;
+}
+
+int Interpreter::newModule(const QString& type, int line) {
+    PyModulePtr m = std::make_shared<PyModule>();
+    m->type = type;
+    m->line = line;
+    m_modules.push_back(std::move(m));
+    m_moduleStates.emplace_back();
+    return static_cast<int>(m_modules.size()) - 1;
+}
+
+void Interpreter::registerChild(int parent, const QString& name, int child) {
+    ModuleState& s = state(parent);
+    const auto it = s.childIndex.find(name);
+    if (it != s.childIndex.end()) {
+        // 重新赋值保留原注册位置（与 PyTorch 的 _modules 一致）
+        s.children[it.value()] = child;
+        moduleAt(parent).children[it.value()].second = m_modules[child];
+        return;
+    }
+    s.childIndex.insert(name, s.children.size());
+    s.children.append(child);
+    moduleAt(parent).children.append({name, m_modules[child]});
+}
+
+void Interpreter::warnOnce(const QString& text) {
+    if (m_warned.contains(text)) return;
+    m_warned.insert(text, true);
+    m_warnings << text;
+}
+
+int Interpreter::findMethod(int classIndex, int name, int depth) const {
+    if (classIndex < 0 || depth > 16) return -1;
+    const ClassInfo& info = m_classes[classIndex];
+    const auto it = info.scope.find(name);
+    if (it != info.scope.end()) return it.value().kind == Value::Function ? static_cast<int>(it.value().i) : -1;
+    for (const Value& base : info.bases) {
+        if (base.kind != Value::Class) continue;
+        const int method = findMethod(static_cast<int>(base.i), name, depth + 1);
+        if (method >= 0) return method;
+    }
+    return -1;
+}
+
+Value Interpreter::call(const Value& callee, const CallArgs& args, int line) {
+    switch (callee.kind) {
+    case Value::Global: return callGlobal(static_cast<int>(callee.i), args, line);
+    case Value::Class: return instantiate(static_cast<int>(callee.i), args, line);
+    case Value::Function: return callFunction(static_cast<int>(callee.i), nullptr, args);
+    case Value::Method: return callMethod(callee, args, line);
+    case Value::Module: return callModule(callee.module, args, line);
+    case Value::TensorMethod: return callTensorMethod(callee, args, line);
+    default: return Value();
+    }
+}
+
+Value Interpreter::callFunction(int function, const Value* self, const CallArgs& args) {
+    if (m_depth >= kMaxCallDepth || m_aborted) return Value();
+    const FunctionInfo& info = m_functions[function];
+    Frame frame;
+    int position = 0;
+    int p = 0;
+    if (self && !info.params.isEmpty() && info.params[0].star == 0) {
+        frame.vars.insert(info.params[0].name, *self);
+        p = 1;
+    }
+    // 先按位置、再按名字绑定；未匹配的关键字参数收进 **kwargs
+    QVector<bool> used(args.keywords.size(), false);
+    int kwargs = -1;
+    for (; p < info.params.size(); ++p) {
+        const FunctionInfo::Param& param = info.params[p];
+        if (param.star == 1) {
+            ValueList rest;
+            while (position < args.positional.size()) rest.append(args.positional[position++]);
+            frame.vars.insert(param.name, Value::sequence(Value::Tuple, rest));
+            continue;
+        }
+        if (param.star == 2) {
+            kwargs = param.name;
+            continue;
+        }
+        Value v = param.hasDefault ? param.defaultValue : Value();
+        if (position < args.positional.size()) {
+            v = args.positional[position++];
+        } else {
+            for (int k = 0; k < args.keywords.size(); ++k) {
+                if (args.keywords[k].first != param.name) continue;
+                v = args.keywords[k].second;
+                used[k] = true;
+            }
+        }
+        frame.vars.insert(param.name, v);
+    }
+    if (kwargs >= 0) {
+        Value rest = Value::sequence(Value::Dict);
+        for (int k = 0; k < args.keywords.size(); ++k) {
+            if (used[k]) continue;
+            rest.items->append(Value::string(m_names.name(args.keywords[k].first)));
+            rest.items->append(args.keywords[k].second);
+        }
+        frame.vars.insert(kwargs, rest);
+    }
+
+    const std::size_t savedPos = m_pos;
+    const Flow savedFlow = m_flow;
+    const Value savedReturn = m_returnValue;
+    const int savedClassBody = m_classBody;
+    ++m_depth;
+    m_frames.push_back(std::move(frame));
+    m_functionStack.append(function);
+    m_classBody = -1;
+    m_flow = Flow::Normal;
+    m_returnValue = Value();
+    m_pos = info.body;
+    execSuite(true);
+    const Value result = m_flow == Flow::Return ? m_returnValue : Value();
+    m_functionStack.removeLast();
+    m_frames.pop_back();
+    --m_depth;
+    m_pos = savedPos;
+    m_flow = savedFlow;
+    m_returnValue = savedReturn;
+    m_classBody = savedClassBody;
+    m_syntaxError = false;
+    return result;
+}
+
+Value Interpreter::instantiate(int classIndex, const CallArgs& args, int line) {
+    const ClassInfo& info = m_classes[classIndex];
+    const int m = newModule(m_names.name(info.name), line);
+    ModuleState& s = state(m);
+    s.classIndex = classIndex;
+    s.isModule = info.isModule;
+    const Value self = Value::fromModule(m);
+    const int init = findMethod(classIndex, m_ids[IdInit]);
+    if (init >= 0) callFunction(init, &self, args);
+    return self;
+}
+
+Value Interpreter::callMethod(const Value& method, const CallArgs& args, int line) {
+    Q_UNUSED(line);
+    if (method.i >= 0) {
+        const Value self = Value::fromModule(method.module);
+        return callFunction(static_cast<int>(method.i), &self, args);
+    }
+    const int name = method.name;
+    if (method.module >= 0) {
+        const int m = method.module;
+        if (name == m_ids[IdAppend] || name == m_ids[IdExtend] || name == m_ids[IdInsert]) {
+            ValueList items;
+            if (name == m_ids[IdAppend] && !args.positional.isEmpty()) items.append(args.positional[0]);
+            if (name == m_ids[IdExtend] && !args.positional.isEmpty()) iterate(args.positional[0], items);
+            if (name == m_ids[IdInsert] && args.positional.size() >= 2) items.append(args.positional[1]);
+            for (const Value& item : items) {
+                if (item.kind == Value::Module) registerChild(m, QString::number(state(m).children.size()), item.module);
+            }
+            return Value::fromModule(m);
+        }
+        if (name == m_ids[IdAddModule] || name == m_ids[IdRegisterModule]) {
+            if (args.positional.size() >= 2 && args.positional[0].kind == Value::Str &&
+                args.positional[1].kind == Value::Module) {
+                registerChild(m, args.positional[0].text, args.positional[1].module);
+                state(m).attributes.insert(m_names.intern(args.positional[0].text), args.positional[1]);
+            }
+            return Value();
+        }
+        // to / cuda / eval / apply …… 返回模块本身
+        return Value::fromModule(m);
+    }
+    if (!method.items) return Value();
+    ValueList& list = *method.items;
+    if (name == m_ids[IdAppend] && !args.positional.isEmpty()) {
+        list.append(args.positional[0]);
+    } else if (name == m_ids[IdExtend] && !args.positional.isEmpty()) {
+        ValueList items;
+        if (iterate(args.positional[0], items) && affordable(qint64(list.size()) + items.size())) list += items;
+    } else if (name == m_ids[IdInsert] && args.positional.size() >= 2 && args.positional[0].kind == Value::Int) {
+        const int at = static_cast<int>(std::clamp<qint64>(args.positional[0].i, 0, list.size()));
+        list.insert(at, args.positional[1]);
+    } else if (name == m_ids[IdItems] || name == m_ids[IdKeys] || name == m_ids[IdValues]) {
+        ValueList result;
+        for (int i = 0; i + 1 < list.size(); i += 2) {
+            if (name == m_ids[IdItems]) result.append(Value::sequence(Value::Tuple, ValueList{list[i], list[i + 1]}));
+            else result.append(name == m_ids[IdKeys] ? list[i] : list[i + 1]);
+        }
+        return Value::sequence(Value::List, std::move(result));
+    }
+    return Value();
+}
+
+Value Interpreter::callGlobal(int dotted, const CallArgs& args, int line) {
+    const int name = m_globalNames[dotted].name;
+    const int prefix = m_globalNames[dotted].parent;
+    const ValueList& a = args.positional;
+
+    if (!m_nodes.isEmpty() && !(prefix < 0 && isPythonBuiltin(m_names.name(name))) && !tensorArguments(args).isEmpty()) {
+        return callTensorFunction(m_names.name(name), args, line);
+    }
+    if (prefix < 0 || m_globalNames[prefix].name == m_ids[IdNn]) {
+        // 未加前缀的名字（from torch.nn import *）只认识已知的层，其余按普通函数处理
+        bool known = prefix >= 0;
+        const Value module = makeLeafModule(name, args, line, &known);
+        if (known) return module;
+    }
+    if (prefix >= 0 && (m_globalNames[prefix].parent >= 0 || m_globalNames[prefix].name != m_ids[IdCollections])) {
+        return Value();
+    }
+
+    if (name == m_ids[IdRange]) {
+        qint64 start = 0, stop = 0, step = 1;
+        if (a.size() == 1 && a[0].kind == Value::Int) stop = a[0].i;
+        else if (a.size() >= 2 && a[0].kind == Value::Int && a[1].kind == Value::Int) {
+            start = a[0].i;
+            stop = a[1].i;
+            if (a.size() >= 3) {
+                if (a[2].kind != Value::Int || a[2].i == 0) return Value();
+                step = a[2].i;
+            }
+        } else {
+            return Value();
+        }
+        ValueList items;
+        for (qint64 v = start; (step > 0 ? v < stop : v > stop) && items.size() < kMaxLoopIterations; v += step) {
+            items.append(Value::integer(v));
+        }
+        return Value::sequence(Value::List, std::move(items));
+    }
+    if (name == m_ids[IdLen] && a.size() == 1) {
+        if (a[0].isSequence()) return Value::integer(a[0].items->size());
+        if (a[0].kind == Value::Dict) return Value::integer(a[0].items->size() / 2);
+        if (a[0].kind == Value::Module) return Value::integer(state(a[0].module).children.size());
+        if (a[0].kind == Value::Str) return Value::integer(a[0].text.size());
+        return Value();
+    }
+    if (name == m_ids[IdInt] && a.size() == 1) {
+        if (a[0].isNumber()) return Value::integer(static_cast<qint64>(a[0].number()));
+        bool ok = false;
+        const qint64 v = a[0].kind == Value::Str ? a[0].text.trimmed().toLongLong(&ok) : 0;
+        return ok ? Value::integer(v) : Value();
+    }
+    if (name == m_ids[IdFloat] && a.size() == 1) return a[0].isNumber() ? Value::real(a[0].number()) : Value();
+    if ((name == m_ids[IdList] || name == m_ids[IdTuple]) && a.size() <= 1) {
+        ValueList items;
+        if (!a.isEmpty() && !iterate(a[0], items)) return Value();
+        return Value::sequence(name == m_ids[IdList] ? Value::List : Value::Tuple, std::move(items));
+    }
+    if ((name == m_ids[IdMax] || name == m_ids[IdMin]) && !a.isEmpty()) {
+        ValueList items = a;
+        if (a.size() == 1 && !iterate(a[0], items)) return Value();
+        Value best;
+        for (const Value& v : items) {
+            if (!v.isNumber()) return Value();
+            if (best.kind == Value::Unknown || (name == m_ids[IdMax] ? v.number() > best.number() : v.number() < best.number())) best = v;
+        }
+        return best;
+    }
+    if (name == m_ids[IdEnumerate] && !a.isEmpty()) {
+        ValueList items;
+        if (!iterate(a[0], items)) return Value();
+        ValueList pairs;
+        for (int i = 0; i < items.size(); ++i) pairs.append(Value::sequence(Value::Tuple, ValueList{Value::integer(i), items[i]}));
+        return Value::sequence(Value::List, std::move(pairs));
+    }
+    if (name == m_ids[IdZip] && !a.isEmpty()) {
+        QVector<ValueList> columns(a.size());
+        int count = kMaxLoopIterations;
+        for (int c = 0; c < a.size(); ++c) {
+            if (!iterate(a[c], columns[c])) return Value();
+            count = std::min(count, static_cast<int>(columns[c].size()));
+        }
+        ValueList rows;
+        for (int r = 0; r < count; ++r) {
+            ValueList row;
+            for (const ValueList& column : columns) row.append(column[r]);
+            rows.append(Value::sequence(Value::Tuple, std::move(row)));
+        }
+        return Value::sequence(Value::List, std::move(rows));
+    }
+    if (name == m_ids[IdReversed] && a.size() == 1) {
+        ValueList items;
+        if (!iterate(a[0], items)) return Value();
+        std::reverse(items.begin(), items.end());
+        return Value::sequence(Value::List, std::move(items));
+    }
+    if ((name == m_ids[IdOrderedDict] || name == m_ids[IdDict]) && a.size() <= 1) {
+        Value dict = Value::sequence(Value::Dict);
+        ValueList pairs;
+        if (!a.isEmpty()) {
+            if (a[0].kind == Value::Dict) return a[0];
+            if (!iterate(a[0], pairs)) return Value();
+        }
+        for (const Value& pair : pairs) {
+            if (pair.isSequence() && pair.items->size() == 2) {
+                dict.items->append(pair.items->at(0));
+                dict.items->append(pair.items->at(1));
+            }
+        }
+        for (const auto& kw : args.keywords) {
+            dict.items->append(Value::string(m_names.name(kw.first)));
+            dict.items->append(kw.second);
+        }
+        return dict;
+    }
+    if (name == m_ids[IdSuper] && !m_functionStack.isEmpty()) {
+        // super()：当前方法所属类与 self
+        const FunctionInfo& function = m_functions[m_functionStack.last()];
+        const auto self = m_frames.back().vars.find(m_ids[IdSelf]);
+        if (function.ownerClass < 0 || self == m_frames.back().vars.end() || self.value().kind != Value::Module) return Value();
+        Value v;
+        v.kind = Value::Super;
+        v.i = function.ownerClass;
+        v.module = self.value().module;
+        return v;
+    }
+    return Value();
+}
+
+Value Interpreter::makeLeafModule(int typeName, const CallArgs& args, int line, bool* known) {
+    const bool allowUnknown = *known;
+    *known = true;
+    const QString& type = m_names.name(typeName);
+    auto is = [&](NameId id) { return typeName == m_ids[id]; };
+    auto intArg = [&](int position, NameId keyword, int fallback) {
+        const Value* v = argument(args, position, keyword);
+        return v ? toInt(*v, fallback) : fallback;
+    };
+    auto leaf = [&](const char* layerType, int neurons) {
+        const int m = newModule(type, line);
+        PyModule& module = moduleAt(m);
+        module.isLayer = true;
+        module.layer.layerType = QString::fromLatin1(layerType);
+        module.layer.neurons = neurons;
+        return m;
+    };
+
+    if (is(IdLinear) || is(IdLazyLinear)) {
+        const bool lazy = is(IdLazyLinear);
+        const int m = leaf("Dense", intArg(lazy ? 0 : 1, IdOutFeatures, 0));
+        moduleAt(m).layer.inputSize = lazy ? 0 : intArg(0, IdInFeatures, 0);
+        return Value::fromModule(m);
+    }
+    if (is(IdConv2d) || is(IdLazyConv2d)) {
+        const bool lazy = is(IdLazyConv2d);
+        const int filters = intArg(lazy ? 0 : 1, IdOutChannels, 0);
+        const int m = leaf("Conv2d", filters);
+        PyLayer& layer = moduleAt(m).layer;
+        layer.inputSize = lazy ? 0 : intArg(0, IdInChannels, 0);
+        layer.filters = filters;
+        layer.kernelSize = intArg(lazy ? 1 : 2, IdKernelSize, 0);
+        return Value::fromModule(m);
+    }
+    if (is(IdMaxPool2d) || is(IdAvgPool2d)) {
+        const int m = leaf(is(IdMaxPool2d) ? "MaxPooling" : "AvgPooling", 0);
+        moduleAt(m).layer.poolingSize = intArg(0, IdKernelSize, 2);
+        return Value::fromModule(m);
+    }
+    if (is(IdLstm) || is(IdGru) || is(IdRnn)) {
+        const int hidden = intArg(1, IdHiddenSize, 0);
+        const int m = leaf(is(IdLstm) ? "LSTM" : (is(IdGru) ? "GRU" : "RNN"), hidden);
+        PyLayer& layer = moduleAt(m).layer;
+        layer.inputSize = intArg(0, IdInputSize, 0);
+        layer.units = hidden;
+        const Value* nonlinearity = is(IdRnn) ? argument(args, 3, IdNonlinearity) : nullptr;
+        if (nonlinearity && nonlinearity->kind == Value::Str) layer.activationFunction = nonlinearity->text;
+        return Value::fromModule(m);
+    }
+    if (is(IdDropout) || is(IdDropout1d) || is(IdDropout2d) || is(IdAlphaDropout)) {
+        const int m = leaf("Dropout", 0);
+        const Value* p = argument(args, 0, IdP);
+        moduleAt(m).layer.dropoutRate = p ? toDouble(*p, 0.5) : 0.5;
+        return Value::fromModule(m);
+    }
+    if (is(IdFlatten)) return Value::fromModule(leaf("Flatten", 0));
+
+    const char* activation = nullptr;
+    if (is(IdReLU) || is(IdReLU6)) activation = "relu";
+    else if (is(IdLeakyReLU)) activation = "leaky_relu";
+    else if (is(IdSigmoid)) activation = "sigmoid";
+    else if (is(IdTanh)) activation = "tanh";
+    else if (is(IdSoftmax) || is(IdLogSoftmax)) activation = "softmax";
+    if (activation) {
+        const int m = newModule(type, line);
+        moduleAt(m).activation = QString::fromLatin1(activation);
+        return Value::fromModule(m);
+    }
+
+    if (is(IdSequential)) {
+        const int m = newModule(type, line);
+        if (args.positional.size() == 1 && args.positional[0].kind == Value::Dict) {
+            const ValueList& items = *args.positional[0].items;
+            for (int i = 0; i + 1 < items.size(); i += 2) {
+                if (items[i].kind == Value::Str && items[i + 1].kind == Value::Module) {
+                    registerChild(m, items[i].text, items[i + 1].module);
+                }
+            }
+        } else {
+            for (int i = 0; i < args.positional.size(); ++i) {
+                if (args.positional[i].kind == Value::Module) registerChild(m, QString::number(i), args.positional[i].module);
+            }
+        }
+        return Value::fromModule(m);
+    }
+    if (is(IdModuleList) || is(IdModuleDict)) {
+        const int m = newModule(type, line);
+        if (!args.positional.isEmpty()) {
+            const Value& v = args.positional[0];
+            if (v.kind == Value::Dict) {
+                for (int i = 0; i + 1 < v.items->size(); i += 2) {
+                    if (v.items->at(i).kind == Value::Str && v.items->at(i + 1).kind == Value::Module) {
+                        registerChild(m, v.items->at(i).text, v.items->at(i + 1).module);
+                    }
+                }
+            } else {
+                ValueList items;
+                iterate(v, items);
+                for (const Value& item : items) {
+                    if (item.kind == Value::Module) registerChild(m, QString::number(state(m).children.size()), item.module);
+                }
+            }
+        }
+        return Value::fromModule(m);
+    }
+    if (is(IdIdentity)) return Value::fromModule(newModule(type, line));
+    if (allowUnknown && !type.isEmpty() && type[0].isUpper() && !is(IdModule) && !is(IdParameter)) {
+        // 其余 nn 模块（BatchNorm2d、Embedding ……）保留在模块树中，不生成层
+        warnOnce(QString("不支持的模块 %1 已跳过").arg(type));
+        return Value::fromModule(newModule(type, line));
+    }
+    *known = false;
+    return Value();
+}
+
+// ---------------------------------------------------------------- forward() 数据流
+
+int Interpreter::addNode(const QString& op, const QString& name, const QVector<int>& inputs, int line) {
+    PyGraphNode node;
+    node.op = op;
+    node.name = name;
+    node.line = line;
+    node.inputs = inputs;
+    m_nodes.append(std::move(node));
+    return m_nodes.size() - 1;
+}
+
+int Interpreter::addLayerNode(const char* layerType, const QString& name, int input, int line) {
+    // F.max_pool2d 这类函数式层：参数写法与模块相同，只是没有注册成子模块
+    const int node = addNode("layer", name, QVector<int>{input}, line);
+    m_nodes[node].layer.layerType = QString::fromLatin1(layerType);
+    return node;
+}
+
+void Interpreter::collectTensors(const Value& v, QVector<int>& out, int depth) const {
+    // torch.cat([a, b]) 的列表参数展开一层；列表可能引用自身，深度受限
+    if (v.kind == Value::Tensor) out.append(static_cast<int>(v.i));
+    else if (v.isSequence() && depth < 2) {
+        for (const Value& item : *v.items) collectTensors(item, out, depth + 1);
+    }
+}
+
+QVector<int> Interpreter::tensorArguments(const CallArgs& args) const {
+    QVector<int> inputs;
+    for (const Value& v : args.positional) collectTensors(v, inputs);
+    for (const auto& kw : args.keywords) collectTensors(kw.second, inputs);
+    return inputs;
+}
+
+void Interpreter::traceForward(int m) {
+    // 必填参数各对应一个输入节点，带默认值的参数用默认值；没有产生任何节点时撤销输入节点
+    const int before = m_nodes.size();
+    const int line = moduleAt(m).line;
+    CallArgs args;
+    const int classIndex = state(m).classIndex;
+    if (classIndex >= 0) {
+        const int forward = findMethod(classIndex, m_ids[IdForward]);
+        if (forward < 0) return;
+        const FunctionInfo& info = m_functions[forward];
+        for (int p = 1; p < info.params.size() && !info.params[p].hasDefault && info.params[p].star == 0; ++p) {
+            args.positional.append(Value::tensor(addNode("input", m_names.name(info.params[p].name), {}, line)));
+        }
+    } else {
+        args.positional.append(Value::tensor(addNode("input", "input", {}, line)));
+    }
+    const int inputs = m_nodes.size();
+    QVector<int> outputs;
+    collectTensors(callModule(m, args, line), outputs);
+    if (m_nodes.size() == inputs && outputs.isEmpty()) {
+        m_nodes.resize(before);
+        return;
+    }
+    m_outputs += outputs;
+}
+
+Value Interpreter::callModule(int m, const CallArgs& args, int line) {
+    if (m_nodes.isEmpty() || m_aborted) return Value();
+    const QVector<int> inputs = tensorArguments(args);
+    if (inputs.isEmpty()) return Value();
+    const ModuleState& s = state(m);
+    if (s.classIndex >= 0) {
+        const int forward = s.isModule ? findMethod(s.classIndex, m_ids[IdForward]) : -1;
+        if (forward < 0) return Value();
+        const Value self = Value::fromModule(m);
+        return callFunction(forward, &self, args);
+    }
+    const PyModulePtr module = m_modules[m];
+    if (module->isLayer) {
+        const int node = addNode("layer", module->type, inputs.mid(0, 1), line);
+        m_nodes[node].module = module;
+        m_nodes[node].layer = module->layer;
+        const Value output = Value::tensor(node);
+        // 循环层返回 (输出, 隐状态)，LSTM 的隐状态是 (h, c)
+        if (module->type == "LSTM") {
+            return Value::sequence(Value::Tuple, ValueList{output, Value::sequence(Value::Tuple, ValueList{output, output})});
+        }
+        if (module->type == "GRU" || module->type == "RNN") return Value::sequence(Value::Tuple, ValueList{output, output});
+        return output;
+    }
+    if (!module->activation.isEmpty()) {
+        const int node = addNode("activation", module->type, inputs.mid(0, 1), line);
+        m_nodes[node].module = module;
+        m_nodes[node].layer.activationFunction = module->activation;
+        return Value::tensor(node);
+    }
+    if (module->type == "Sequential") {
+        if (m_depth >= kMaxCallDepth) return Value();
+        ++m_depth;
+        Value v = args.positional.isEmpty() ? Value::tensor(inputs[0]) : args.positional[0];
+        const QVector<int> children = s.children;  // 子模块的 forward() 可能新建模块
+        for (int child : children) {
+            if (!spend()) break;
+            CallArgs next;
+            next.positional.append(v);
+            v = callModule(child, next, line);
+        }
+        --m_depth;
+        return v;
+    }
+    // 其余模块（BatchNorm2d、Identity……）不改变数据来源；多个输入时记为一个合并节点
+    return Value::tensor(inputs.size() == 1 ? inputs[0] : addNode(module->type, module->type, inputs, line));
+}
+
+Value Interpreter::callTensorFunction(const QString& name, const CallArgs& args, int line) {
+    const QVector<int> inputs = tensorArguments(args);
+    const QString activation = functionalActivation(name);
+    if (!activation.isEmpty()) {
+        const int node = addNode("activation", name, inputs.mid(0, 1), line);
+        m_nodes[node].layer.activationFunction = activation;
+        return Value::tensor(node);
+    }
+    if (name == "cat" || name == "concat" || name == "concatenate" || name == "stack" || name == "hstack" ||
+        name == "vstack") {
+        const int node = addNode(name == "stack" ? "stack" : "concat", name, inputs, line);
+        const Value* dim = argument(args, 1, IdDim);
+        if (dim && dim->kind == Value::Int) {
+            m_nodes[node].dim = static_cast<int>(dim->i);
+            m_nodes[node].hasDim = true;
+        }
+        return Value::tensor(node);
+    }
+    if (name == "max_pool2d" || name == "avg_pool2d") {
+        const int node = addLayerNode(name == "max_pool2d" ? "MaxPooling" : "AvgPooling", name, inputs[0], line);
+        const Value* kernel = argument(args, 1, IdKernelSize);
+        m_nodes[node].layer.poolingSize = kernel ? toInt(*kernel, 2) : 2;
+        return Value::tensor(node);
+    }
+    if (name == "dropout" || name == "dropout2d") {
+        const int node = addLayerNode("Dropout", name, inputs[0], line);
+        const Value* p = argument(args, 1, IdP);
+        m_nodes[node].layer.dropoutRate = p ? toDouble(*p, 0.5) : 0.5;
+        return Value::tensor(node);
+    }
+    // 单个张量输入的函数（torch.flatten、F.pad ……）原样传出，多个输入的记为合并节点
+    if (inputs.size() == 1) return Value::tensor(inputs[0]);
+    const QString merge = mergeOp(name);
+    return Value::tensor(addNode(merge.isEmpty() ? name : merge, name, inputs, line));
+}
+
+Value Interpreter::callTensorMethod(const Value& method, const CallArgs& args, int line) {
+    const QString& name = m_names.name(method.name);
+    const int self = static_cast<int>(method.i);
+    if (name == "size" || name == "dim" || name == "numel" || name == "item" || name == "tolist") return Value();
+    const QString activation = functionalActivation(name);
+    if (!activation.isEmpty()) {
+        const int node = addNode("activation", name, QVector<int>{self}, line);
+        m_nodes[node].layer.activationFunction = activation;
+        return Value::tensor(node);
+    }
+    const QVector<int> others = tensorArguments(args);
+    if (!others.isEmpty()) {
+        const QString merge = mergeOp(name);
+        return Value::tensor(addNode(merge.isEmpty() ? name : merge, name, QVector<int>{self} + others, line));
+    }
+    if (name == "chunk" && !args.positional.isEmpty() && args.positional[0].kind == Value::Int &&
+        args.positional[0].i > 0 && args.positional[0].i <= 64) {
+        return Value::sequence(Value::Tuple, ValueList(static_cast<int>(args.positional[0].i), Value::tensor(self)));
+    }
+    // view / reshape / flatten / permute / contiguous …… 只改变形状
+    return Value::tensor(self);
+}
+
+Value Interpreter::tensorBinary(int op, const Value& a, const Value& b) {
+    // 与常数运算不改变数据来源；两个张量相加、拼接等汇合成一个节点
+    if (a.kind != Value::Tensor) return b;
+    if (b.kind != Value::Tensor) return a;
+    QString name;
+    switch (op) {
+    case pyOp('+'): name = "add"; break;
+    case pyOp('-'): name = "sub"; break;
+    case pyOp('*'): name = "mul"; break;
+    case pyOp('/'): name = "div"; break;
+    case pyOp('@'): name = "matmul"; break;
+    default: name = "op"; break;
+    }
+    return Value::tensor(addNode(name, name, QVector<int>{static_cast<int>(a.i), static_cast<int>(b.i)}, tok().line));
+}
+
+void Interpreter::foldActivations() {
+    // 激活节点的唯一输入是层、该层只有这一个使用者且还没有激活函数时，并入该层（同时写回模块，
+    // 供 layers() 使用）。节点按执行顺序排列，输入总在前面，一遍即可完成重新编号
+    QVector<int> uses(m_nodes.size(), 0);
+    for (const PyGraphNode& node : m_nodes) {
+        for (int from : node.inputs) ++uses[from];
+    }
+    for (int output : m_outputs) ++uses[output];
+    QVector<int> remap(m_nodes.size(), -1);
+    QVector<PyGraphNode> kept;
+    kept.reserve(m_nodes.size());
+    for (int i = 0; i < m_nodes.size(); ++i) {
+        PyGraphNode& node = m_nodes[i];
+        const int from = node.inputs.size() == 1 ? node.inputs[0] : -1;
+        if (node.op == "activation" && from >= 0 && uses[from] == 1 && m_nodes[from].op == "layer" &&
+            kept[remap[from]].layer.activationFunction.isEmpty()) {
+            PyGraphNode& layer = kept[remap[from]];
+            layer.layer.activationFunction = node.layer.activationFunction;
+            if (layer.module && layer.module->layer.activationFunction.isEmpty()) {
+                layer.module->layer.activationFunction = node.layer.activationFunction;
+            }
+            remap[i] = remap[from];
+            continue;
+        }
+        for (int& input : node.inputs) input = remap[input];
+        remap[i] = kept.size();
+        kept.append(std::move(node));
+    }
+    for (int& output : m_outputs) output = remap[output];
+    m_nodes = std::move(kept);
+}
+
+void Interpreter::breakModuleCycles() {
+    // 子模块引用成环（如 self.me = self）时去掉回边：PyModule 之间以 shared_ptr 相连，成环会泄漏。
+    // named_modules() 本就不会重复访问，去掉回边不影响层列表
+    enum : quint8 { White, Gray, Black };
+    std::vector<quint8> color(m_modules.size(), White);
+    std::vector<std::pair<int, int>> stack;  // 模块编号、下一个要访问的子模块序号
+    for (int start = 0; start < static_cast<int>(m_modules.size()); ++start) {
+        if (color[start] != White) continue;
+        color[start] = Gray;
+        stack.push_back({start, 0});
+        while (!stack.empty()) {
+            const int m = stack.back().first;
+            const int next = stack.back().second;
+            QVector<int>& children = state(m).children;
+            if (next == children.size()) {
+                color[m] = Black;
+                stack.pop_back();
+                continue;
+            }
+            const int child = children[next];
+            if (color[child] == Gray) {
+                children.removeAt(next);
+                moduleAt(m).children.removeAt(next);
+                continue;
+            }
+            ++stack.back().second;
+            if (color[child] == White) {
+                color[child] = Gray;
+                stack.push_back({child, 0});
+            }
+        }
+    }
+}
+
+PyTorchModel Interpreter::run() {
+    PyTorchModel model;
+    QString error;
+    tokenizePython(m_source, m_names, m_tokens, &error);
+    model.error = error;
+    m_budget = static_cast<qint64>(m_tokens.size()) * 4 + 100000;
+    m_frames.emplace_back();
+    while (!isKind(PyToken::End)) {
+        const std::size_t before = m_pos;
+        if (isKind(PyToken::Dedent) || isKind(PyToken::Newline)) ++m_pos;
+        else execStatement();
+        m_flow = Flow::Normal;
+        if (m_pos == before) ++m_pos;
+    }
+
+    // 模块级变量中已是其他根的子模块的（先建层再组装成 Sequential）不单独作为根
+    std::vector<bool> nested(m_modules.size(), false);
+    std::vector<int> pending;
+    for (const auto& root : m_moduleLevelRoots) pending.insert(pending.end(), state(root.second).children.begin(), state(root.second).children.end());
+    while (!pending.empty()) {
+        const int m = pending.back();
+        pending.pop_back();
+        if (nested[m]) continue;
+        nested[m] = true;
+        pending.insert(pending.end(), state(m).children.begin(), state(m).children.end());
+    }
+    QVector<int> rootIds;
+    for (const auto& root : m_moduleLevelRoots) {
+        if (nested[root.second]) continue;
+        model.roots.append({m_names.name(root.first), m_modules[root.second]});
+        rootIds.append(root.second);
+    }
+    if (model.roots.isEmpty()) {
+        // 没有模块级实例：取没有被其他 nn.Module 子类引用的类，按默认参数实例化
+        QVector<bool> referenced(static_cast<int>(m_classes.size()), false);
+        std::vector<int> classByName(static_cast<std::size_t>(m_names.size()), -1);  // 按标识符编号
+        for (int c = 0; c < static_cast<int>(m_classes.size()); ++c) classByName[m_classes[c].name] = c;
+        for (int c = 0; c < static_cast<int>(m_classes.size()); ++c) {
+            if (!m_classes[c].isModule) continue;
+            for (int t = m_classes[c].begin; t < m_classes[c].end; ++t) {
+                if (m_tokens[t].kind != PyToken::Name) continue;
+                const int other = classByName[m_tokens[t].value];
+                if (other >= 0 && other != c) referenced[other] = true;
+            }
+        }
+        for (int c = 0; c < static_cast<int>(m_classes.size()); ++c) {
+            if (!m_classes[c].isModule || referenced[c] || m_aborted) continue;
+            const Value instance = instantiate(c, CallArgs(), m_classes[c].line);
+            model.roots.append({m_names.name(m_classes[c].name), m_modules[instance.module]});
+            rootIds.append(instance.module);
+        }
+    }
+
+    // 各根模块以符号输入执行一遍 forward()
+    for (int root : rootIds) {
+        if (m_aborted) break;
+        traceForward(root);
+    }
+    foldActivations();
+    breakModuleCycles();
+    model.nodes = std::move(m_nodes);
+    model.outputs = std::move(m_outputs);
+    model.warnings = m_warnings;
+    return model;
+}
+
+} // namespace
+
+PyTorchModel parsePyTorchModel(const QString& source) {
+    Interpreter interpreter(source);
+    return interpreter.run();
+}
@@ -0,0 +1,156 @@
+#ifndef PYTORCHPARSER_H
+#define PYTORCHPARSER_H
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <memory>
+#include <vector>
+
+// Python 源码的词法单元，start/length 为在源码中的位置（UTF-16 下标）
+struct PyToken
+{
+    enum Kind : quint8 { Name, Number, String, Op, Newline, Indent, Dedent, End };
+    Kind kind = End;
+    int start = 0;
+    int length = 0;
+    int line = 0;   // 从 1 开始
+    int value = 0;  // Name：标识符编号（见 PyNameTable）；Op：运算符编码（见 pyOp）
+};
+
+// 运算符编码：最多三个字符按字节拼成一个整数，如 pyOp('*', '*', '=')
+constexpr int pyOp(char a, char b = 0, char c = 0) {
+    return int(uchar(a)) | int(uchar(b)) << 8 | int(uchar(c)) << 16;
+}
+
+// 标识符驻留表：同名标识符得到同一个编号，关键字占用前 KeywordCount 个编号
+class PyNameTable
+{
+public:
+    enum Keyword {
+        False, None, True, And, As, Assert, Async, Await, Break, Class, Continue, Def, Del, Elif, Else, Except,
+        Finally, For, From, Global, If, Import, In, Is, Lambda, Nonlocal, Not, Or, Pass, Raise, Return, Try, While,
+        With, Yield, KeywordCount
+    };
+
+    PyNameTable();
+
+    int intern(const QChar* text, int length) { return intern(text, length, hash(text, length)); }
+    int intern(const QString& text) { return intern(text.constData(), text.size()); }
+    // 词法分析边扫描边算好哈希时用，hash 必须等于 hash(text, length)
+    int intern(const QChar* text, int length, uint hash);
+    static uint hash(const QChar* text, int length) {
+        uint h = kHashSeed;
+        for (int i = 0; i < length; ++i) h = hashStep(h, text[i].unicode());
+        return h;
+    }
+    static constexpr uint kHashSeed = 2166136261u;  // FNV-1a
+    static uint hashStep(uint h, ushort c) { return (h ^ c) * 16777619u; }
+    const QString& name(int id) const { return m_names[id]; }
+    int size() const { return static_cast<int>(m_names.size()); }
+
+private:
+    void grow();
+
+    std::vector<QString> m_names;
+    std::vector<uint> m_hashes;
+    std::vector<int> m_slots;  // 开放寻址，-1 为空
+};
+
+// 单遍扫描：处理缩进（INDENT/DEDENT）、括号内的隐式续行、反斜杠续行、注释与带前缀的单/三引号字符串；
+// 空行与纯注释行不产生词法单元。出错时 tokens 仍以 End 结尾，error 给出行号
+bool tokenizePython(const QString& source, PyNameTable& names, std::vector<PyToken>& tokens, QString* error = nullptr);
+
+struct PyModule;
+using PyModulePtr = std::shared_ptr<PyModule>;
+
+// 层参数，与 NeuralLayer 的 JSON 字段一一对应；解析时只填结构体，导出时才转成 JSON
+struct PyLayer
+{
+    QString layerType;           // "Dense"、"Conv2d"、"MaxPooling"……；为空时不是层，只可能带激活函数
+    int neurons = 0;
+    QString activationFunction;
+    int inputSize = -1;          // 以下各项为 -1 时该层类型没有这个字段
+    int filters = -1;
+    int kernelSize = -1;
+    int poolingSize = -1;
+    int units = -1;
+    double dropoutRate = -1.0;
+
+    // 写入 object：层写出 layerType、neurons、activationFunction 与已设置的字段，非层只写非空的激活函数
+    void writeJson(QJsonObject& object) const;
+};
+
+// 从 __init__ 中解析出的模块实例
+struct PyModule
+{
+    QString type;          // "Linear"、"Sequential"、文件中定义的类名……
+    int line = 0;          // 构造调用所在的行
+    bool isLayer = false;  // 对应一个 NeuralLayer，参数在 layer 中
+    PyLayer layer;
+    QString activation;    // nn.ReLU 等激活模块对应的激活函数名
+    QVector<QPair<QString, PyModulePtr>> children;  // 子模块，按注册顺序
+};
+
+// forward() 数据流图中的节点：输入、层（模块或 F.max_pool2d 这类函数式层）、激活、合并（+、torch.cat ……）
+struct PyGraphNode
+{
+    QString op;           // "input"、"layer"、"activation"、"add"、"concat"……
+    QString name;         // 输入为参数名，函数式调用为函数名；模块节点由 graph() 换成模块路径
+    PyModulePtr module;   // 模块调用产生的节点
+    PyLayer layer;        // 层参数（同 PyModule::layer），激活节点只有 activationFunction
+    int dim = 0;          // concat / stack 的 dim，hasDim 为 false 时没有给出
+    bool hasDim = false;
+    int line = 0;
+    QVector<int> inputs;  // 数据来源节点，总在本节点之前
+};
+
+struct PyTorchModel
+{
+    // 模块级的实例（如 model = Net()）；没有时取未被其他类引用的 nn.Module 子类，按默认参数实例化
+    QVector<QPair<QString, PyModulePtr>> roots;
+    QStringList warnings;
+    QString error;  // 词法错误等，出错前已解析的部分仍然保留
+
+    // 以符号张量执行各根模块的 forward() 得到的数据流图，节点按执行顺序排列（即拓扑序）。
+    // 紧跟在层之后、且是该层唯一使用者的激活已并入层的 activationFunction
+    QVector<PyGraphNode> nodes;
+    QVector<int> outputs;  // forward() 返回的节点
+
+    // 按注册顺序展开为层列表（NeuralLayer::fromJsonObject 可读，另带 "name" 路径）。
+    // 激活函数取自 forward() 的数据流；没有可追踪的 forward() 时，激活模块并入前一层
+    QJsonArray layers() const;
+
+    // {"nodes": [{"id", "op", "name", "line", 层参数……}], "edges": [{"from", "to"}], "outputs": [id……]}
+    QJsonObject graph() const;
+};
+
+// 两层之间的数据流连线（见 layerEdges）
+struct LayerEdge
+{
+    int from = 0;  // 层下标（层列表中的位置）
+    int to = 0;
+    QString via;   // 途经的合并节点（"add"、"concat"……），直接相连时为空
+
+    bool operator==(const LayerEdge& other) const { return from == other.from && to == other.to && via == other.via; }
+    bool operator!=(const LayerEdge& other) const { return !(*this == other); }
+};
+
+// 把 PyTorchModel::graph() / OnnxModel::graph() 折叠为层与层之间的连线：层节点按 "name" 对到 layers 中的层，
+// 激活、合并、函数式调用等其余节点被穿过。结果去重，按 (to, from) 排序
+QVector<LayerEdge> layerEdges(const QJsonArray& layers, const QJsonObject& graph);
+// 数据流图中有分支、跳连，或层的连接顺序与列表不同时原样返回 graph 并在 edges 中给出 layerEdges；
+// 只是第 i 层连到第 i + 1 层的一条链时没有层列表之外的信息，返回空对象，edges 也为空
+QJsonObject nonChainGraph(const QJsonArray& layers, const QJsonObject& graph, QVector<LayerEdge>* edges = nullptr);
+
+// 解析 Python 子集：import 别名、类与函数定义、赋值/增量赋值、if/for/with/try、列表推导与常量表达式；
+// 按 PyTorch 的注册规则（赋给 self 的属性、nn.Sequential / ModuleList / ModuleDict、add_module、append）
+// 记录模块，文件中自定义的子模块类按实参展开；再以符号张量执行 forward()，记录层调用、
+// 变量重新赋值、+ / torch.cat 合并、函数式激活与 ModuleList 循环构成的数据流。
+// 执行的语句数以词法单元数为上限，解析时间与文件大小成线性
+PyTorchModel parsePyTorchModel(const QString& source);
+
+#endif // PYTORCHPARSER_H
@@ -0,0 +1,536 @@
+#include "quantization.h"
+#include "inferenceengine.h"
+#include "latencypredictor.h"
+#include "simdutils.h"
+#include "threadpool.h"
+#include "weightcheckpoint.h"
+#include <QStringList>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace {
+
+// 按行分块时每块至少包含的元素数，行很短时多行合成一块
+constexpr qint64 kRowChunkElements = 1 << 15;
+
+// 延迟模型中 int8 内核相对 fp32 的计算吞吐倍数（AVX2 vpmaddubsw / AVX-512 VNNI 的 int8 GEMM）；
+// fp16/bf16 在没有原生半精度算术的 CPU 上只省带宽，载入后转回 fp32 计算
+constexpr double kInt8ComputeFactor = 2.0;
+
+bool isInt8(QuantScheme scheme) {
+    return scheme == QuantScheme::Int8Symmetric || scheme == QuantScheme::Int8Asymmetric;
+}
+
+quint16 floatToHalf(float value) {
+    quint32 bits;
+    std::memcpy(&bits, &value, 4);
+    const quint32 sign = (bits >> 16) & 0x8000u;
+    const quint32 absBits = bits & 0x7fffffffu;
+    if (absBits >= 0x7f800000u) {
+        // Inf 保持，NaN 保留为静默 NaN
+        return quint16(sign | 0x7c00u | (absBits > 0x7f800000u ? 0x200u : 0u));
+    }
+    if (absBits >= 0x477ff000u) return quint16(sign | 0x7c00u);  // 舍入后超过 65504
+    if (absBits < 0x38800000u) {
+        // 非规格化数：按 2^-24 的整数倍就近偶数舍入
+        float magnitude;
+        std::memcpy(&magnitude, &absBits, 4);
+        return quint16(sign | quint32(std::nearbyint(magnitude * 16777216.0f)));
+    }
+    const quint32 mantissaOdd = (absBits >> 13) & 1u;
+    const quint32 rounded = absBits + 0xfffu + mantissaOdd;
+    return quint16(sign | ((rounded - 0x38000000u) >> 13));
+}
+
+float halfToFloat(quint16 h) {
+    const quint32 sign = quint32(h & 0x8000u) << 16;
+    const quint32 exponent = (h >> 10) & 0x1fu;
+    const quint32 mantissa = h & 0x3ffu;
+    quint32 bits;
+    if (exponent == 0) {
+        const float magnitude = float(mantissa) / 16777216.0f;  // mantissa × 2^-24
+        std::memcpy(&bits, &magnitude, 4);
+        bits |= sign;
+    } else if (exponent == 31) {
+        bits = sign | 0x7f800000u | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    float f;
+    std::memcpy(&f, &bits, 4);
+    return f;
+}
+
+#if NNV_HAVE_AVX2
+NNV_AVX2 void rangeOfAvx2(const float* x, qint64 n, float& lo, float& hi) {
+    qint64 i = 0;
+    __m256 vlo = _mm256_set1_ps(lo), vhi = _mm256_set1_ps(hi);
+    for (; i + 8 <= n; i += 8) {
+        const __m256 v = _mm256_loadu_ps(x + i);
+        vlo = _mm256_min_ps(vlo, v);
+        vhi = _mm256_max_ps(vhi, v);
+    }
+    alignas(32) float los[8], his[8];
+    _mm256_store_ps(los, vlo);
+    _mm256_store_ps(his, vhi);
+    for (int k = 0; k < 8; ++k) {
+        lo = std::min(lo, los[k]);
+        hi = std::max(hi, his[k]);
+    }
+    for (; i < n; ++i) {
+        lo = std::min(lo, x[i]);
+        hi = std::max(hi, x[i]);
+    }
+}
+#endif
+
+void rangeOf(const float* x, qint64 n, float& lo, float& hi) {
+#if NNV_HAVE_AVX2
+    if (simd::hasAvx2()) {
+        rangeOfAvx2(x, n, lo, hi);
+        return;
+    }
+#endif
+    for (qint64 i = 0; i < n; ++i) {
+        lo = std::min(lo, x[i]);
+        hi = std::max(hi, x[i]);
+    }
+}
+
+#if NNV_HAVE_AVX2
+NNV_AVX2 void accumulateErrorAvx2(const float* reference, const float* approx, qint64 n, QuantError& error,
+                                  double& errorSquares, double& signalSquares) {
+    qint64 i = 0;
+    double maxAbs = error.maxAbs;
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 vmax = _mm256_setzero_ps();
+    __m256d e0 = _mm256_setzero_pd(), e1 = _mm256_setzero_pd();
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    for (; i + 8 <= n; i += 8) {
+        const __m256 r = _mm256_loadu_ps(reference + i);
+        const __m256 d = _mm256_sub_ps(_mm256_loadu_ps(approx + i), r);
+        vmax = _mm256_max_ps(vmax, _mm256_and_ps(d, absMask));
+        const __m256d dLo = _mm256_cvtps_pd(_mm256_castps256_ps128(d));
+        const __m256d dHi = _mm256_cvtps_pd(_mm256_extractf128_ps(d, 1));
+        const __m256d rLo = _mm256_cvtps_pd(_mm256_castps256_ps128(r));
+        const __m256d rHi = _mm256_cvtps_pd(_mm256_extractf128_ps(r, 1));
+        e0 = _mm256_fmadd_pd(dLo, dLo, e0);
+        e1 = _mm256_fmadd_pd(dHi, dHi, e1);
+        s0 = _mm256_fmadd_pd(rLo, rLo, s0);
+        s1 = _mm256_fmadd_pd(rHi, rHi, s1);
+    }
+    alignas(32) float maxs[8];
+    alignas(32) double es[4], ss[4];
+    _mm256_store_ps(maxs, vmax);
+    _mm256_store_pd(es, _mm256_add_pd(e0, e1));
+    _mm256_store_pd(ss, _mm256_add_pd(s0, s1));
+    for (int k = 0; k < 8; ++k) maxAbs = std::max(maxAbs, double(maxs[k]));
+    for (int k = 0; k < 4; ++k) {
+        errorSquares += es[k];
+        signalSquares += ss[k];
+    }
+    for (; i < n; ++i) {
+        const double d = double(approx[i]) - reference[i];
+        maxAbs = std::max(maxAbs, std::fabs(d));
+        errorSquares += d * d;
+        signalSquares += double(reference[i]) * reference[i];
+    }
+    error.maxAbs = maxAbs;
+    error.count += n;
+}
+#endif
+
+// 原值与反量化值之差的最大值与平方和（双精度累加）
+void accumulateError(const float* reference, const float* approx, qint64 n, QuantError& error, double& errorSquares,
+                     double& signalSquares) {
+#if NNV_HAVE_AVX2
+    if (simd::hasAvx2()) {
+        accumulateErrorAvx2(reference, approx, n, error, errorSquares, signalSquares);
+        return;
+    }
+#endif
+    qint64 i = 0;
+    double maxAbs = error.maxAbs;
+    for (; i < n; ++i) {
+        const double d = double(approx[i]) - reference[i];
+        maxAbs = std::max(maxAbs, std::fabs(d));
+        errorSquares += d * d;
+        signalSquares += double(reference[i]) * reference[i];
+    }
+    error.maxAbs = maxAbs;
+    error.count += n;
+}
+
+// int8 的 scale / zero point：对称取 max|x| / 127，非对称把 [min(0, lo), max(0, hi)] 映射到 [-128, 127]
+void int8Params(QuantScheme scheme, float lo, float hi, float& scale, int& zeroPoint, int& qmin, int& qmax) {
+    if (scheme == QuantScheme::Int8Symmetric) {
+        const float bound = std::max(std::fabs(lo), std::fabs(hi));
+        scale = bound > 0.0f ? bound / 127.0f : 1.0f;
+        zeroPoint = 0;
+        qmin = -127;
+        qmax = 127;
+        return;
+    }
+    lo = std::min(lo, 0.0f);
+    hi = std::max(hi, 0.0f);
+    scale = hi > lo ? (hi - lo) / 255.0f : 1.0f;
+    zeroPoint = std::clamp(static_cast<int>(std::nearbyint(-128.0f - lo / scale)), -128, 127);
+    qmin = -128;
+    qmax = 127;
+}
+
+struct LayerSegment
+{
+    qint64 offset = 0;
+    qint64 rows = 0;
+    qint64 cols = 0;
+};
+
+// 引擎参数布局中每层权重按输出通道划分的矩阵：循环层的 weight_ih 与 weight_hh 分别量化
+QVector<LayerSegment> weightSegments(const InferenceEngine& engine, int layer) {
+    const InferenceEngine::LayerInfo& info = engine.layerInfo(layer);
+    const qint64 size = engine.weightSize(layer);
+    const qint64 channels = engine.biasSize(layer);
+    QVector<LayerSegment> segments;
+    if (size <= 0 || channels <= 0) return segments;
+    if (info.kind == InferenceEngine::LayerKind::Recurrent) {
+        const qint64 gateRows = channels / 2;  // 偏置为 bias_ih 后接 bias_hh
+        if (gateRows > 0 && gateRows * (info.in.width + info.out.width) == size) {
+            segments.append({0, gateRows, info.in.width});
+            segments.append({gateRows * info.in.width, gateRows, info.out.width});
+            return segments;
+        }
+    }
+    if (size % channels == 0) {
+        segments.append({0, channels, size / channels});
+    } else {
+        segments.append({0, 1, size});
+    }
+    return segments;
+}
+
+#if NNV_HAVE_AVX2
+NNV_AVX2 void quantizeInt8Avx2(const float* x, qint64 n, float scale, int zeroPoint, int qmin, int qmax, qint8* q) {
+    const float inverse = 1.0f / scale;
+    qint64 i = 0;
+    const __m256 vinverse = _mm256_set1_ps(inverse);
+    const __m256i vzero = _mm256_set1_epi32(zeroPoint);
+    const __m256i vmin = _mm256_set1_epi32(qmin);
+    const __m256i vmax = _mm256_set1_epi32(qmax);
+    for (; i + 16 <= n; i += 16) {
+        // cvtps_epi32 按 MXCSR 默认模式就近偶数舍入，与标量路径的 nearbyint 一致
+        __m256i a = _mm256_add_epi32(_mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(x + i), vinverse)), vzero);
+        __m256i b = _mm256_add_epi32(_mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(x + i + 8), vinverse)), vzero);
+        a = _mm256_min_epi32(_mm256_max_epi32(a, vmin), vmax);
+        b = _mm256_min_epi32(_mm256_max_epi32(b, vmin), vmax);
+        // 两次饱和打包后 128 位通道交错，按 0,2,1,3 的 32 位顺序恢复
+        const __m256i words = _mm256_packs_epi32(a, b);
+        const __m256i bytes = _mm256_packs_epi16(words, words);
+        const __m256i ordered = _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(q + i), _mm256_castsi256_si128(ordered));
+    }
+    for (; i < n; ++i) {
+        const int v = static_cast<int>(std::nearbyint(x[i] * inverse)) + zeroPoint;
+        q[i] = static_cast<qint8>(std::clamp(v, qmin, qmax));
+    }
+}
+
+NNV_AVX2 void dequantizeInt8Avx2(const qint8* q, qint64 n, float scale, int zeroPoint, float* x) {
+    qint64 i = 0;
+    const __m256 vscale = _mm256_set1_ps(scale);
+    const __m256i vzero = _mm256_set1_epi32(zeroPoint);
+    for (; i + 8 <= n; i += 8) {
+        const __m256i v = _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(q + i)));
+        _mm256_storeu_ps(x + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(v, vzero)), vscale));
+    }
+    for (; i < n; ++i) x[i] = float(int(q[i]) - zeroPoint) * scale;
+}
+
+NNV_AVX2 void roundToFloat16Avx2(const float* x, qint64 n, float* y) {
+    qint64 i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(x + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        _mm256_storeu_ps(y + i, _mm256_cvtph_ps(h));
+    }
+    for (; i < n; ++i) y[i] = halfToFloat(floatToHalf(x[i]));
+}
+
+NNV_AVX2 void roundToBFloat16Avx2(const float* x, qint64 n, float* y) {
+    qint64 i = 0;
+    // 加 0x7fff 与保留位的最低位实现就近偶数；NaN 原样保留，避免进位成 Inf
+    const __m256i bias = _mm256_set1_epi32(0x7fff);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i high = _mm256_set1_epi32(static_cast<int>(0xffff0000u));
+    for (; i + 8 <= n; i += 8) {
+        const __m256 v = _mm256_loadu_ps(x + i);
+        const __m256i bits = _mm256_castps_si256(v);
+        const __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(bits, 16), one);
+        const __m256i rounded = _mm256_and_si256(_mm256_add_epi32(bits, _mm256_add_epi32(bias, lsb)), high);
+        const __m256 nan = _mm256_cmp_ps(v, v, _CMP_UNORD_Q);
+        _mm256_storeu_ps(y + i, _mm256_blendv_ps(_mm256_castsi256_ps(rounded), v, nan));
+    }
+    for (; i < n; ++i) {
+        if (std::isnan(x[i])) {
+            y[i] = x[i];
+            continue;
+        }
+        quint32 bits;
+        std::memcpy(&bits, x + i, 4);
+        bits = (bits + 0x7fffu + ((bits >> 16) & 1u)) & 0xffff0000u;
+        std::memcpy(y + i, &bits, 4);
+    }
+}
+#endif
+
+} // namespace
+
+QString quantSchemeName(QuantScheme scheme) {
+    switch (scheme) {
+    case QuantScheme::Int8Symmetric: return "int8 对称";
+    case QuantScheme::Int8Asymmetric: return "int8 非对称";
+    case QuantScheme::Float16: return "fp16";
+    case QuantScheme::BFloat16: return "bf16";
+    }
+    return QString();
+}
+
+QString QuantConfig::name() const {
+    if (!isInt8(scheme)) return quantSchemeName(scheme);
+    return quantSchemeName(scheme) + (granularity == QuantGranularity::PerChannel ? " / 逐通道" : " / 逐张量");
+}
+
+void QuantError::merge(const QuantError& other) {
+    if (other.count == 0) return;
+    const double total = double(count + other.count);
+    rms = std::sqrt((rms * rms * count + other.rms * other.rms * other.count) / total);
+    signalRms = std::sqrt((signalRms * signalRms * count + other.signalRms * other.signalRms * other.count) / total);
+    maxAbs = std::max(maxAbs, other.maxAbs);
+    count += other.count;
+}
+
+void quantizeInt8(const float* x, qint64 n, float scale, int zeroPoint, int qmin, int qmax, qint8* q) {
+#if NNV_HAVE_AVX2
+    if (simd::hasAvx2()) {
+        quantizeInt8Avx2(x, n, scale, zeroPoint, qmin, qmax, q);
+        return;
+    }
+#endif
+    const float inverse = 1.0f / scale;
+    for (qint64 i = 0; i < n; ++i) {
+        const int v = static_cast<int>(std::nearbyint(x[i] * inverse)) + zeroPoint;
+        q[i] = static_cast<qint8>(std::clamp(v, qmin, qmax));
+    }
+}
+
+void dequantizeInt8(const qint8* q, qint64 n, float scale, int zeroPoint, float* x) {
+#if NNV_HAVE_AVX2
+    if (simd::hasAvx2()) {
+        dequantizeInt8Avx2(q, n, scale, zeroPoint, x);
+        return;
+    }
+#endif
+    for (qint64 i = 0; i < n; ++i) x[i] = float(int(q[i]) - zeroPoint) * scale;
+}
+
+void roundToFloat16(const float* x, qint64 n, float* y) {
+#if NNV_HAVE_AVX2
+    if (simd::hasAvx2()) {
+        roundToFloat16Avx2(x, n, y);
+        return;
+    }
+#endif
+    for (qint64 i = 0; i < n; ++i) y[i] = halfToFloat(floatToHalf(x[i]));
+}
+
+void roundToBFloat16(const float* x, qint64 n, float* y) {
+#if NNV_HAVE_AVX2
+    if (simd::hasAvx2()) {
+        roundToBFloat16Avx2(x, n, y);
+        return;
+    }
+#endif
+    for (qint64 i = 0; i < n; ++i) {
+        if (std::isnan(x[i])) {
+            y[i] = x[i];
+            continue;
+        }
+        quint32 bits;
+        std::memcpy(&bits, x + i, 4);
+        bits = (bits + 0x7fffu + ((bits >> 16) & 1u)) & 0xffff0000u;
+        std::memcpy(y + i, &bits, 4);
+    }
+}
+
+QuantError fakeQuantize(const float* w, qint64 rows, qint64 cols, const QuantConfig& config, float* out, qint64* bytes,
+                        ThreadPool* pool) {
+    QuantError error;
+    if (rows <= 0 || cols <= 0) return error;
+    if (!pool) pool = &ThreadPool::global();
+    const bool int8 = isInt8(config.scheme);
+    const bool perChannel = int8 && config.granularity == QuantGranularity::PerChannel;
+    const qint64 rowsPerChunk = std::max<qint64>(1, kRowChunkElements / cols);
+    const int chunks = static_cast<int>((rows + rowsPerChunk - 1) / rowsPerChunk);
+
+    // 逐张量量化先求整体范围
+    float tensorLo = std::numeric_limits<float>::infinity();
+    float tensorHi = -tensorLo;
+    if (int8 && !perChannel) {
+        std::vector<float> los(chunks, tensorLo), his(chunks, tensorHi);
+        pool->parallelFor(0, chunks, 1, [&](int first, int last) {
+            for (int c = first; c < last; ++c) {
+                const qint64 begin = c * rowsPerChunk;
+                const qint64 end = std::min(rows, begin + rowsPerChunk);
+                rangeOf(w + begin * cols, (end - begin) * cols, los[c], his[c]);
+            }
+        });
+        for (int c = 0; c < chunks; ++c) {
+            tensorLo = std::min(tensorLo, los[c]);
+            tensorHi = std::max(tensorHi, his[c]);
+        }
+    }
+
+    struct Partial { QuantError error; double errorSquares = 0.0; double signalSquares = 0.0; };
+    std::vector<Partial> partials(static_cast<std::size_t>(chunks));
+    pool->parallelFor(0, chunks, 1, [&](int first, int last) {
+        std::vector<qint8> codes(int8 ? static_cast<std::size_t>(cols) : 0);
+        std::vector<float> row(static_cast<std::size_t>(cols));
+        for (int c = first; c < last; ++c) {
+            Partial& partial = partials[c];
+            const qint64 end = std::min(rows, (c + 1) * rowsPerChunk);
+            for (qint64 r = c * rowsPerChunk; r < end; ++r) {
+                const float* src = w + r * cols;
+                if (int8) {
+                    float lo = tensorLo, hi = tensorHi;
+                    if (perChannel) {
+                        lo = std::numeric_limits<float>::infinity();
+                        hi = -lo;
+                        rangeOf(src, cols, lo, hi);
+                    }
+                    float scale;
+                    int zeroPoint, qmin, qmax;
+                    int8Params(config.scheme, lo, hi, scale, zeroPoint, qmin, qmax);
+                    quantizeInt8(src, cols, scale, zeroPoint, qmin, qmax, codes.data());
+                    dequantizeInt8(codes.data(), cols, scale, zeroPoint, row.data());
+                } else if (config.scheme == QuantScheme::Float16) {
+                    roundToFloat16(src, cols, row.data());
+                } else {
+                    roundToBFloat16(src, cols, row.data());
+                }
+                // 先算误差再写回，out 与 w 相同时也不会读到已改写的值
+                accumulateError(src, row.data(), cols, partial.error, partial.errorSquares, partial.signalSquares);
+                std::copy(row.begin(), row.end(), out + r * cols);
+            }
+        }
+    });
+
+    double errorSquares = 0.0, signalSquares = 0.0;
+    for (const Partial& partial : partials) {
+        error.maxAbs = std::max(error.maxAbs, partial.error.maxAbs);
+        error.count += partial.error.count;
+        errorSquares += partial.errorSquares;
+        signalSquares += partial.signalSquares;
+    }
+    error.rms = std::sqrt(errorSquares / double(error.count));
+    error.signalRms = std::sqrt(signalSquares / double(error.count));
+
+    if (bytes) {
+        const qint64 elements = rows * cols;
+        if (!int8) {
+            *bytes = elements * 2;
+        } else {
+            // 每组一个 fp32 scale，非对称再加一个 int32 zero point
+            const qint64 groups = perChannel ? rows : 1;
+            *bytes = elements + groups * (config.scheme == QuantScheme::Int8Asymmetric ? 8 : 4);
+        }
+    }
+    return error;
+}
+
+QString QuantReport::summary() const {
+    if (!valid) return "量化模拟失败：" + error;
+    QString text = QString("%1：权重 %2 KB -> %3 KB（节省 %4%），预测延迟 %5 ms -> %6 ms（%7×），输出相对误差 %8%")
+                       .arg(config.name())
+                       .arg(fp32Bytes / 1024.0, 0, 'f', 1)
+                       .arg(quantBytes / 1024.0, 0, 'f', 1)
+                       .arg(fp32Bytes > 0 ? 100.0 * (fp32Bytes - quantBytes) / fp32Bytes : 0.0, 0, 'f', 1)
+                       .arg(fp32Ms, 0, 'f', 3)
+                       .arg(quantMs, 0, 'f', 3)
+                       .arg(speedup(), 0, 'f', 2)
+                       .arg(outputRelativeError * 100.0, 0, 'f', 3);
+    if (isInt8(config.scheme)) text += QString("（int8 计算吞吐按 fp32 的 %1× 估计）").arg(kInt8ComputeFactor, 0, 'f', 0);
+    return text;
+}
+
+QuantReport simulateQuantization(const QList<NeuralLayer>& layers, const QuantConfig& config,
+                                 const std::shared_ptr<WeightCheckpoint>& checkpoint) {
+    QuantReport report;
+    report.config = config;
+    const int batch = 4;
+    InferenceEngine engine;
+    if (!engine.build(layers, batch, &report.error)) return report;
+
+    QStringList sources;
+    if (checkpoint && checkpoint->isOpen()) {
+        loadCheckpointWeights(*checkpoint, bindCheckpoint(*checkpoint, layers), engine, &sources);
+    }
+
+    // 同一批输入下的 fp32 参考输出
+    std::vector<float> input(static_cast<std::size_t>(engine.inputShape().size()) * batch);
+    for (std::size_t i = 0; i < input.size(); ++i) input[i] = std::sin(0.013f * float(i) + 0.5f);
+    const qint64 outputSize = qint64(engine.outputShape().size()) * batch;
+    const float* y = engine.forward(input.data(), batch);
+    std::vector<float> reference(y, y + outputSize);
+
+    const LatencyReport latency = LatencyPredictor::instance().predict(layers, 1);
+    for (int i = 0; i < engine.layerCount(); ++i) {
+        const QVector<LayerSegment> segments = weightSegments(engine, i);
+        if (segments.isEmpty()) continue;
+        QuantLayerReport layer;
+        layer.layer = i;
+        layer.layerType = engine.layerInfo(i).layerType;
+        layer.source = i < sources.size() && !sources[i].isEmpty() ? sources[i] : QString("随机初始化");
+        float* weights = engine.weightData(i);
+        for (const LayerSegment& segment : segments) {
+            qint64 bytes = 0;
+            float* w = weights + segment.offset;
+            layer.error.merge(fakeQuantize(w, segment.rows, segment.cols, config, w, &bytes));
+            layer.parameters += segment.rows * segment.cols;
+            layer.quantBytes += bytes;
+        }
+        layer.fp32Bytes = layer.parameters * 4;
+
+        // 只替换权重部分的访存量；int8 的计算部分按更高的内核吞吐折算，固定开销不变
+        if (latency.valid && i < latency.layers.size()) {
+            const LayerLatency& l = latency.layers[i];
+            layer.fp32Ms = l.predictedMs;
+            const double overhead = l.predictedMs - std::max(l.computeMs, l.memoryMs);
+            const double bytes = std::max(1.0, l.bytes - double(layer.fp32Bytes) + double(layer.quantBytes));
+            const double memoryMs = l.bytes > 0.0 ? l.memoryMs * bytes / l.bytes : 0.0;
+            const double computeMs = isInt8(config.scheme) ? l.computeMs / kInt8ComputeFactor : l.computeMs;
+            layer.quantMs = std::max(computeMs, memoryMs) + overhead;
+        }
+        report.fp32Bytes += layer.fp32Bytes;
+        report.quantBytes += layer.quantBytes;
+        report.layers.append(layer);
+    }
+    if (latency.valid) {
+        // 无权重的层（池化等）两边耗时相同
+        report.fp32Ms = latency.totalMs;
+        report.quantMs = latency.totalMs;
+        for (const QuantLayerReport& layer : report.layers) report.quantMs += layer.quantMs - layer.fp32Ms;
+    }
+
+    const float* quantized = engine.forward(input.data(), batch);
+    double diff = 0.0, norm = 0.0;
+    for (qint64 i = 0; i < outputSize; ++i) {
+        const double d = double(quantized[i]) - reference[i];
+        diff += d * d;
+        norm += double(reference[i]) * reference[i];
+    }
+    report.outputRelativeError = norm > 0.0 ? std::sqrt(diff / norm) : 0.0;
+    report.valid = true;
+    return report;
+}
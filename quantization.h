@@ -0,0 +1,90 @@
+#ifndef QUANTIZATION_H
+#define QUANTIZATION_H
+
+#include <QList>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include <memory>
+#include "backend.h"
+
+class ThreadPool;
+class WeightCheckpoint;
+
+enum class QuantScheme { Int8Symmetric, Int8Asymmetric, Float16, BFloat16 };
+enum class QuantGranularity { PerTensor, PerChannel };  // PerChannel 以输出通道（权重矩阵的行）为单位
+
+QString quantSchemeName(QuantScheme scheme);
+
+struct QuantConfig
+{
+    QuantScheme scheme = QuantScheme::Int8Symmetric;
+    QuantGranularity granularity = QuantGranularity::PerChannel;
+
+    QString name() const;  // "int8 对称 / 逐通道"
+};
+
+// 量化前后的误差，signalRms 为原权重的均方根，用于给出相对误差
+struct QuantError
+{
+    qint64 count = 0;
+    double maxAbs = 0.0;
+    double rms = 0.0;
+    double signalRms = 0.0;
+
+    double relativeRms() const { return signalRms > 0.0 ? rms / signalRms : 0.0; }
+    void merge(const QuantError& other);
+};
+
+// 向量化的量化/反量化内核（AVX2 + F16C，其余走标量实现）
+// q = clamp(round(x / scale) + zeroPoint, qmin, qmax)，舍入为就近偶数
+void quantizeInt8(const float* x, qint64 n, float scale, int zeroPoint, int qmin, int qmax, qint8* q);
+// x = (q - zeroPoint) * scale
+void dequantizeInt8(const qint8* q, qint64 n, float scale, int zeroPoint, float* x);
+// 舍入到 fp16 / bf16 再转回 float（就近偶数，超出 fp16 范围变为 Inf）
+void roundToFloat16(const float* x, qint64 n, float* y);
+void roundToBFloat16(const float* x, qint64 n, float* y);
+
+// 对 rows×cols 的权重矩阵（行 = 输出通道）量化再反量化写入 out（可与 w 相同），
+// bytes 返回量化后的存储大小（含逐张量/逐通道的 scale 与 zero point）
+QuantError fakeQuantize(const float* w, qint64 rows, qint64 cols, const QuantConfig& config, float* out,
+                        qint64* bytes = nullptr, ThreadPool* pool = nullptr);
+
+struct QuantLayerReport
+{
+    int layer = -1;
+    QString layerType;
+    QString source;         // 权重来源：检查点张量名或“随机初始化”
+    qint64 parameters = 0;  // 仅权重，偏置保持 fp32
+    qint64 fp32Bytes = 0;
+    qint64 quantBytes = 0;
+    QuantError error;
+    double fp32Ms = 0.0;    // 延迟模型预测（batch 1）
+    double quantMs = 0.0;
+
+    double speedup() const { return quantMs > 0.0 ? fp32Ms / quantMs : 1.0; }
+};
+
+struct QuantReport
+{
+    bool valid = false;
+    QString error;
+    QuantConfig config;
+    QVector<QuantLayerReport> layers;
+    qint64 fp32Bytes = 0;
+    qint64 quantBytes = 0;
+    double fp32Ms = 0.0;
+    double quantMs = 0.0;
+    double outputRelativeError = 0.0;  // 同一批随机输入下，量化前后网络输出的相对 L2 误差
+
+    double speedup() const { return quantMs > 0.0 ? fp32Ms / quantMs : 1.0; }
+    QString summary() const;
+};
+
+// 用检查点权重（未匹配的层按 PyTorch 默认方式随机初始化）构建原生推理引擎，逐层做模拟量化：
+// 报告存储节省、逐层最大/均方根误差与延迟模型预测的加速比，并比较量化前后的网络输出
+// 会阻塞：构建引擎、两次前向，本机延迟参数尚未校准时还要等校准完成，界面应在后台线程调用
+QuantReport simulateQuantization(const QList<NeuralLayer>& layers, const QuantConfig& config,
+                                 const std::shared_ptr<WeightCheckpoint>& checkpoint = nullptr);
+
+#endif // QUANTIZATION_H
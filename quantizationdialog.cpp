@@ -0,0 +1,125 @@
+#include "quantizationdialog.h"
+#include "weightcheckpoint.h"
+#include <QElapsedTimer>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QVBoxLayout>
+#include <algorithm>
+
+namespace {
+
+const QuantScheme kSchemes[] = {QuantScheme::Int8Symmetric, QuantScheme::Int8Asymmetric, QuantScheme::Float16,
+                                QuantScheme::BFloat16};
+
+QTableWidgetItem* numberItem(const QString& text) {
+    QTableWidgetItem* item = new QTableWidgetItem(text);
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    return item;
+}
+
+} // namespace
+
+QuantizationDialog::QuantizationDialog(const QList<NeuralLayer>& layers, QWidget* parent)
+    : QDialog(parent), m_layers(layers) {
+    setWindowTitle("Quantization Simulator");
+    resize(1100, 520);
+
+    m_schemeBox = new QComboBox(this);
+    for (QuantScheme scheme : kSchemes) m_schemeBox->addItem(quantSchemeName(scheme));
+    m_granularityBox = new QComboBox(this);
+    m_granularityBox->addItem("逐通道");
+    m_granularityBox->addItem("逐张量");
+    connect(m_schemeBox, &QComboBox::currentTextChanged, this, &QuantizationDialog::updateGranularity);
+
+    m_runButton = new QPushButton("运行模拟", this);
+    connect(m_runButton, &QPushButton::clicked, this, &QuantizationDialog::runSimulation);
+
+    QFormLayout* form = new QFormLayout();
+    form->addRow("Scheme", m_schemeBox);
+    form->addRow("Granularity", m_granularityBox);
+    QHBoxLayout* controls = new QHBoxLayout();
+    controls->addLayout(form);
+    controls->addWidget(m_runButton, 0, Qt::AlignBottom);
+    controls->addStretch(1);
+
+    m_summaryLabel = new QLabel(this);
+    m_summaryLabel->setWordWrap(true);
+    m_summaryLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+
+    m_table = new QTableWidget(0, 12, this);
+    m_table->setHorizontalHeaderLabels({"层", "类型", "权重来源", "参数", "fp32 KB", "量化 KB", "最大误差", "RMS 误差",
+                                        "相对 RMS", "fp32 ms", "量化 ms", "加速比"});
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->verticalHeader()->setVisible(false);
+    m_table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+
+    QVBoxLayout* mainLayout = new QVBoxLayout(this);
+    mainLayout->addLayout(controls);
+    mainLayout->addWidget(m_summaryLabel);
+    mainLayout->addWidget(m_table, 1);
+
+    runSimulation();
+}
+
+QuantizationDialog::~QuantizationDialog() {
+    // 排队中的结果随本对象一起丢弃
+    if (m_thread.joinable()) m_thread.join();
+}
+
+QuantConfig QuantizationDialog::currentConfig() const {
+    QuantConfig config;
+    config.scheme = kSchemes[std::max(0, m_schemeBox->currentIndex())];
+    config.granularity = m_granularityBox->currentIndex() == 0 ? QuantGranularity::PerChannel : QuantGranularity::PerTensor;
+    return config;
+}
+
+void QuantizationDialog::updateGranularity() {
+    // fp16 / bf16 逐元素舍入，没有 scale，粒度无意义
+    const QuantScheme scheme = currentConfig().scheme;
+    m_granularityBox->setEnabled(scheme == QuantScheme::Int8Symmetric || scheme == QuantScheme::Int8Asymmetric);
+}
+
+void QuantizationDialog::runSimulation() {
+    // 构建引擎、逐层量化和延迟预测（可能要等本机校准完成）都不在界面线程做
+    if (m_thread.joinable()) m_thread.join();  // 按钮禁用期间不会再进来，这里只回收已结束的线程
+    m_runButton->setEnabled(false);
+    m_summaryLabel->setText("正在模拟量化…");
+    m_table->setRowCount(0);
+    const QList<NeuralLayer> layers = m_layers;
+    const QuantConfig config = currentConfig();
+    const std::shared_ptr<WeightCheckpoint> checkpoint = WeightCheckpoint::active();
+    m_thread = std::thread([this, layers, config, checkpoint]() {
+        QElapsedTimer timer;
+        timer.start();
+        const QuantReport report = simulateQuantization(layers, config, checkpoint);
+        const qint64 elapsed = timer.elapsed();
+        QMetaObject::invokeMethod(this, [this, report, elapsed]() {
+            showReport(report);
+            if (report.valid) m_summaryLabel->setText(m_summaryLabel->text() + QString("\n模拟耗时 %1 ms").arg(elapsed));
+            m_runButton->setEnabled(true);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void QuantizationDialog::showReport(const QuantReport& report) {
+    m_summaryLabel->setText(report.summary());
+    m_table->setRowCount(0);
+    if (!report.valid) return;
+    m_table->setRowCount(report.layers.size());
+    for (int row = 0; row < report.layers.size(); ++row) {
+        const QuantLayerReport& layer = report.layers[row];
+        m_table->setItem(row, 0, numberItem(QString::number(layer.layer + 1)));
+        m_table->setItem(row, 1, new QTableWidgetItem(layer.layerType));
+        m_table->setItem(row, 2, new QTableWidgetItem(layer.source));
+        m_table->setItem(row, 3, numberItem(QString::number(layer.parameters)));
+        m_table->setItem(row, 4, numberItem(QString::number(layer.fp32Bytes / 1024.0, 'f', 1)));
+        m_table->setItem(row, 5, numberItem(QString::number(layer.quantBytes / 1024.0, 'f', 1)));
+        m_table->setItem(row, 6, numberItem(QString::number(layer.error.maxAbs, 'e', 3)));
+        m_table->setItem(row, 7, numberItem(QString::number(layer.error.rms, 'e', 3)));
+        m_table->setItem(row, 8, numberItem(QString::number(layer.error.relativeRms() * 100.0, 'f', 3) + "%"));
+        m_table->setItem(row, 9, numberItem(QString::number(layer.fp32Ms, 'f', 4)));
+        m_table->setItem(row, 10, numberItem(QString::number(layer.quantMs, 'f', 4)));
+        m_table->setItem(row, 11, numberItem(QString::number(layer.speedup(), 'f', 2) + "×"));
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef QUANTIZATIONDIALOG_H
+#define QUANTIZATIONDIALOG_H
+
+#include <QComboBox>
+#include <QDialog>
+#include <QLabel>
+#include <QPushButton>
+#include <QTableWidget>
+#include <thread>
+#include "backend.h"
+#include "quantization.h"
+
+// CodeGeneratorWindow 中“Quantize”打开的窗口：选择量化方案，逐层列出存储、误差与预测加速比
+// 已加载权重检查点时使用检查点权重，否则使用随机初始化的权重；模拟在后台线程运行，完成后再填表
+class QuantizationDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit QuantizationDialog(const QList<NeuralLayer>& layers, QWidget* parent = nullptr);
+    ~QuantizationDialog() override;
+
+private slots:
+    void runSimulation();
+    void updateGranularity();
+
+private:
+    QuantConfig currentConfig() const;
+    void showReport(const QuantReport& report);
+
+    QList<NeuralLayer> m_layers;
+    QComboBox* m_schemeBox;
+    QComboBox* m_granularityBox;
+    QPushButton* m_runButton;
+    QLabel* m_summaryLabel;
+    QTableWidget* m_table;
+    std::thread m_thread;  // 当前（或最近一次）模拟；运行期间“运行模拟”按钮禁用
+};
+
+#endif // QUANTIZATIONDIALOG_H
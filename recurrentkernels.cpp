@@ -0,0 +1,229 @@
+#include "recurrentkernels.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+inline float sigmoidScalar(float v) { return 1.0f / (1.0f + std::exp(-v)); }
+
+#if NNV_HAVE_AVX2
+NNV_AVX2 void lstmGatesAvx2(const float* gx, const float* gh, float* c, const float* hPrev, float* h, int units) {
+    (void)hPrev;
+    int u = 0;
+    for (; u + 8 <= units; u += 8) {
+        const __m256 i = simd::sigmoid256(_mm256_add_ps(_mm256_loadu_ps(gx + u), _mm256_loadu_ps(gh + u)));
+        const __m256 f = simd::sigmoid256(_mm256_add_ps(_mm256_loadu_ps(gx + units + u), _mm256_loadu_ps(gh + units + u)));
+        const __m256 g = simd::tanh256(_mm256_add_ps(_mm256_loadu_ps(gx + 2 * units + u), _mm256_loadu_ps(gh + 2 * units + u)));
+        const __m256 o = simd::sigmoid256(_mm256_add_ps(_mm256_loadu_ps(gx + 3 * units + u), _mm256_loadu_ps(gh + 3 * units + u)));
+        const __m256 cn = _mm256_fmadd_ps(f, _mm256_loadu_ps(c + u), _mm256_mul_ps(i, g));
+        _mm256_storeu_ps(c + u, cn);
+        _mm256_storeu_ps(h + u, _mm256_mul_ps(o, simd::tanh256(cn)));
+    }
+    for (; u < units; ++u) {
+        const float i = sigmoidScalar(gx[u] + gh[u]);
+        const float f = sigmoidScalar(gx[units + u] + gh[units + u]);
+        const float g = std::tanh(gx[2 * units + u] + gh[2 * units + u]);
+        const float o = sigmoidScalar(gx[3 * units + u] + gh[3 * units + u]);
+        c[u] = f * c[u] + i * g;
+        h[u] = o * std::tanh(c[u]);
+    }
+}
+#endif
+
+// 融合门运算：gx、gh 为当前时间步一行（一个序列）的输入/隐状态投影，已含偏置
+// LSTM：c = f*c + i*g，h = o*tanh(c)
+void lstmGates(const float* gx, const float* gh, float* c, const float* hPrev, float* h, int units) {
+    (void)hPrev;
+    for (int u = 0; u < units; ++u) {
+        const float i = sigmoidScalar(gx[u] + gh[u]);
+        const float f = sigmoidScalar(gx[units + u] + gh[units + u]);
+        const float g = std::tanh(gx[2 * units + u] + gh[2 * units + u]);
+        const float o = sigmoidScalar(gx[3 * units + u] + gh[3 * units + u]);
+        c[u] = f * c[u] + i * g;
+        h[u] = o * std::tanh(c[u]);
+    }
+}
+
+#if NNV_HAVE_AVX2
+NNV_AVX2 void gruGatesAvx2(const float* gx, const float* gh, float* c, const float* hPrev, float* h, int units) {
+    (void)c;
+    int u = 0;
+    for (; u + 8 <= units; u += 8) {
+        const __m256 r = simd::sigmoid256(_mm256_add_ps(_mm256_loadu_ps(gx + u), _mm256_loadu_ps(gh + u)));
+        const __m256 z = simd::sigmoid256(_mm256_add_ps(_mm256_loadu_ps(gx + units + u), _mm256_loadu_ps(gh + units + u)));
+        const __m256 n = simd::tanh256(_mm256_fmadd_ps(r, _mm256_loadu_ps(gh + 2 * units + u), _mm256_loadu_ps(gx + 2 * units + u)));
+        const __m256 hp = _mm256_loadu_ps(hPrev + u);
+        // (1 - z) * n + z * hp = n + z * (hp - n)
+        _mm256_storeu_ps(h + u, _mm256_fmadd_ps(z, _mm256_sub_ps(hp, n), n));
+    }
+    for (; u < units; ++u) {
+        const float r = sigmoidScalar(gx[u] + gh[u]);
+        const float z = sigmoidScalar(gx[units + u] + gh[units + u]);
+        const float n = std::tanh(gx[2 * units + u] + r * gh[2 * units + u]);
+        h[u] = (1.0f - z) * n + z * hPrev[u];
+    }
+}
+#endif
+
+// GRU：n = tanh(gx_n + r * gh_n)，h = (1 - z) * n + z * h_prev
+void gruGates(const float* gx, const float* gh, float* c, const float* hPrev, float* h, int units) {
+    (void)c;
+    for (int u = 0; u < units; ++u) {
+        const float r = sigmoidScalar(gx[u] + gh[u]);
+        const float z = sigmoidScalar(gx[units + u] + gh[units + u]);
+        const float n = std::tanh(gx[2 * units + u] + r * gh[2 * units + u]);
+        h[u] = (1.0f - z) * n + z * hPrev[u];
+    }
+}
+
+#if NNV_HAVE_AVX2
+NNV_AVX2 void rnnGatesAvx2(const float* gx, const float* gh, float* c, const float* hPrev, float* h, int units) {
+    (void)c;
+    (void)hPrev;
+    int u = 0;
+    for (; u + 8 <= units; u += 8)
+        _mm256_storeu_ps(h + u, simd::tanh256(_mm256_add_ps(_mm256_loadu_ps(gx + u), _mm256_loadu_ps(gh + u))));
+    for (; u < units; ++u) h[u] = std::tanh(gx[u] + gh[u]);
+}
+#endif
+
+void rnnGates(const float* gx, const float* gh, float* c, const float* hPrev, float* h, int units) {
+    (void)c;
+    (void)hPrev;
+    for (int u = 0; u < units; ++u) h[u] = std::tanh(gx[u] + gh[u]);
+}
+
+using GateFn = void (*)(const float*, const float*, float*, const float*, float*, int);
+
+GateFn gateFunction(RecurrentCell cell) {
+#if NNV_HAVE_AVX2
+    if (simd::hasAvx2()) {
+        switch (cell) {
+        case RecurrentCell::LSTM: return lstmGatesAvx2;
+        case RecurrentCell::GRU: return gruGatesAvx2;
+        case RecurrentCell::RNN: break;
+        }
+        return rnnGatesAvx2;
+    }
+#endif
+    switch (cell) {
+    case RecurrentCell::LSTM: return lstmGates;
+    case RecurrentCell::GRU: return gruGates;
+    case RecurrentCell::RNN: break;
+    }
+    return rnnGates;
+}
+
+void addBiasRows(float* data, int rows, int cols, const float* bias) {
+    for (int r = 0; r < rows; ++r) {
+        float* row = data + static_cast<std::size_t>(r) * cols;
+        for (int j = 0; j < cols; ++j) row[j] += bias[j];
+    }
+}
+
+} // namespace
+
+void RecurrentKernel::pack(const RecurrentShape& shape, const float* wIH, const float* wHH,
+                           const float* bIH, const float* bHH) {
+    m_shape = shape;
+    const int gw = shape.gateWidth();
+    // op(B) = Wᵀ，即 transB 布局的 [G*U][F] / [G*U][U]
+    m_wIH.pack(gw, shape.features, wIH, shape.features, true);
+    m_wHH.pack(gw, shape.units, wHH, shape.units, true);
+    m_bIH.resize(gw);
+    m_bHH.resize(gw);
+    std::memcpy(m_bIH.data(), bIH, sizeof(float) * gw);
+    std::memcpy(m_bHH.data(), bHH, sizeof(float) * gw);
+}
+
+long long RecurrentKernel::workspaceSize(const RecurrentShape& shape) {
+    const long long gw = shape.gateWidth();
+    // 输入投影 [B*T][G*U] + 隐状态投影 [B][G*U] + 细胞状态 [B][U] + 初始隐状态 [B][U]
+    return static_cast<long long>(shape.batch) * shape.steps * gw + shape.batch * gw + 2LL * shape.batch * shape.units;
+}
+
+void RecurrentKernel::forward(const float* x, float* y, int batch, float* workspace, ThreadPool* pool) const {
+    if (!pool) pool = &ThreadPool::global();
+    const int T = m_shape.steps;
+    const int U = m_shape.units;
+    const int gw = m_shape.gateWidth();
+
+    float* xProj = workspace;
+    float* hProj = xProj + static_cast<std::size_t>(batch) * T * gw;
+    float* cell = hProj + static_cast<std::size_t>(batch) * gw;
+    float* h0 = cell + static_cast<std::size_t>(batch) * U;
+    std::fill(cell, cell + static_cast<std::size_t>(batch) * U, 0.0f);
+    std::fill(h0, h0 + static_cast<std::size_t>(batch) * U, 0.0f);
+
+    // 所有序列、所有时间步的输入投影合成一次大 GEMM
+    sgemmPacked(batch * T, x, m_shape.features, m_wIH, xProj, gw, false, pool);
+    addBiasRows(xProj, batch * T, gw, m_bIH.data());
+
+    const GateFn gates = gateFunction(m_shape.cell);
+    const std::size_t seqStride = static_cast<std::size_t>(T) * U;  // y 中相邻序列的间隔
+    for (int t = 0; t < T; ++t) {
+        // 上一时间步的隐状态：t = 0 时为 h0，否则为 y[:, t-1, :]，行间隔 T*U
+        const float* hPrev = t == 0 ? h0 : y + static_cast<std::size_t>(t - 1) * U;
+        const int ldh = t == 0 ? U : static_cast<int>(seqStride);
+        sgemmPacked(batch, hPrev, ldh, m_wHH, hProj, gw, false, pool);
+        addBiasRows(hProj, batch, gw, m_bHH.data());
+
+        pool->parallelFor(0, batch, std::max(1, 4096 / std::max(1, gw)), [&](int first, int last) {
+            for (int b = first; b < last; ++b) {
+                const float* gx = xProj + (static_cast<std::size_t>(b) * T + t) * gw;
+                const float* gh = hProj + static_cast<std::size_t>(b) * gw;
+                const float* hp = hPrev + static_cast<std::size_t>(b) * ldh;
+                float* ht = y + b * seqStride + static_cast<std::size_t>(t) * U;
+                gates(gx, gh, cell + static_cast<std::size_t>(b) * U, hp, ht, U);
+            }
+        });
+    }
+}
+
+void recurrentForwardReference(const RecurrentShape& s, const float* x, const float* wIH, const float* wHH,
+                               const float* bIH, const float* bHH, float* y) {
+    const int G = recurrentGateCount(s.cell);
+    const int U = s.units;
+    const int F = s.features;
+    std::vector<double> gx(G * U), gh(G * U), c(U), h(U);
+    for (int b = 0; b < s.batch; ++b) {
+        std::fill(c.begin(), c.end(), 0.0);
+        std::fill(h.begin(), h.end(), 0.0);
+        for (int t = 0; t < s.steps; ++t) {
+            const float* xt = x + (static_cast<std::size_t>(b) * s.steps + t) * F;
+            for (int g = 0; g < G * U; ++g) {
+                double ax = bIH[g], ah = bHH[g];
+                for (int f = 0; f < F; ++f) ax += double(wIH[static_cast<std::size_t>(g) * F + f]) * xt[f];
+                for (int u = 0; u < U; ++u) ah += double(wHH[static_cast<std::size_t>(g) * U + u]) * h[u];
+                gx[g] = ax;
+                gh[g] = ah;
+            }
+            auto sig = [](double v) { return 1.0 / (1.0 + std::exp(-v)); };
+            for (int u = 0; u < U; ++u) {
+                if (s.cell == RecurrentCell::LSTM) {
+                    const double i = sig(gx[u] + gh[u]);
+                    const double f = sig(gx[U + u] + gh[U + u]);
+                    const double g = std::tanh(gx[2 * U + u] + gh[2 * U + u]);
+                    const double o = sig(gx[3 * U + u] + gh[3 * U + u]);
+                    c[u] = f * c[u] + i * g;
+                    gx[u] = o * std::tanh(c[u]);  // 暂存新隐状态，所有单元算完后再写回 h
+                } else if (s.cell == RecurrentCell::GRU) {
+                    const double r = sig(gx[u] + gh[u]);
+                    const double z = sig(gx[U + u] + gh[U + u]);
+                    const double n = std::tanh(gx[2 * U + u] + r * gh[2 * U + u]);
+                    gx[u] = (1.0 - z) * n + z * h[u];
+                } else {
+                    gx[u] = std::tanh(gx[u] + gh[u]);
+                }
+            }
+            float* yt = y + (static_cast<std::size_t>(b) * s.steps + t) * U;
+            for (int u = 0; u < U; ++u) {
+                h[u] = gx[u];
+                yt[u] = static_cast<float>(h[u]);
+            }
+        }
+    }
+}
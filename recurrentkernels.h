@@ -0,0 +1,58 @@
+#ifndef RECURRENTKERNELS_H
+#define RECURRENTKERNELS_H
+
+#include "gemm.h"
+#include "simdutils.h"
+
+class ThreadPool;
+
+// 循环层类型，门顺序与 PyTorch 一致：LSTM (i, f, g, o)，GRU (r, z, n)，RNN 单门 tanh
+enum class RecurrentCell { RNN, LSTM, GRU };
+
+inline int recurrentGateCount(RecurrentCell cell) {
+    return cell == RecurrentCell::LSTM ? 4 : (cell == RecurrentCell::GRU ? 3 : 1);
+}
+
+// 一组按 batch_first 排列的序列：x [batch][steps][features] -> y [batch][steps][units]
+struct RecurrentShape
+{
+    RecurrentCell cell = RecurrentCell::LSTM;
+    int batch = 1;
+    int steps = 1;
+    int features = 1;
+    int units = 1;
+
+    int gateWidth() const { return recurrentGateCount(cell) * units; }
+};
+
+// 权重采用 PyTorch 布局：wIH [G*U][F]，wHH [G*U][U]，bIH / bHH [G*U]
+// pack() 把全部门的权重各打包成一个矩阵，之后每个时间步只需一次 GEMM：
+//   输入投影对所有时间步一次算完：X[B*T×F] · W_ihᵀ
+//   隐状态投影每步一次：H[B×U] · W_hhᵀ（四个/三个门合在同一个 GEMM 中）
+class RecurrentKernel
+{
+public:
+    void pack(const RecurrentShape& shape, const float* wIH, const float* wHH, const float* bIH, const float* bHH);
+
+    // 工作区大小（float 个数），forward 时由调用方提供
+    static long long workspaceSize(const RecurrentShape& shape);
+
+    // 初始隐状态与细胞状态为 0；batch 可与 shape.batch 不同，workspace 须按实际 batch 计算
+    void forward(const float* x, float* y, int batch, float* workspace, ThreadPool* pool = nullptr) const;
+
+    const RecurrentShape& shape() const { return m_shape; }
+
+private:
+    RecurrentShape m_shape;
+    PackedMatrix m_wIH;
+    PackedMatrix m_wHH;
+    simd::AlignedBuffer m_bIH;
+    simd::AlignedBuffer m_bHH;
+};
+
+// 逐元素、逐门的朴素实现，用于校验
+void recurrentForwardReference(const RecurrentShape& shape, const float* x,
+                               const float* wIH, const float* wHH, const float* bIH, const float* bHH,
+                               float* y);
+
+#endif // RECURRENTKERNELS_H
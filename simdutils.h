@@ -0,0 +1,162 @@
+#ifndef SIMDUTILS_H
+#define SIMDUTILS_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+// SIMD 选择：x86 上编译 AVX2 路径，但整个程序仍按基线指令集编译，只有标了 NNV_AVX2 的内核函数使用
+// AVX2 / FMA / F16C 指令（gcc / clang 的 target 属性；MSVC 不加 /arch 也允许使用这些内建函数）。
+// 调用前用 simd::hasAvx2() 在运行时检查 CPU，不支持时走标量实现，因此同一个二进制可以在任何 x86-64 上运行
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define NNV_HAVE_AVX2 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define NNV_AVX2
+#else
+#define NNV_AVX2 __attribute__((target("avx2,fma,f16c")))
+#endif
+#else
+#define NNV_HAVE_AVX2 0
+#define NNV_AVX2
+#endif
+
+namespace simd {
+
+#if NNV_HAVE_AVX2
+inline bool detectAvx2() {
+    // 环境变量 NNV_DISABLE_AVX2=1 强制走标量路径（对照测试用）
+    const char* disabled = std::getenv("NNV_DISABLE_AVX2");
+    if (disabled && *disabled && *disabled != '0') return false;
+#if defined(_MSC_VER) && !defined(__clang__)
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7) return false;
+    __cpuid(regs, 1);
+    const bool fma = (regs[2] >> 12) & 1, osxsave = (regs[2] >> 27) & 1, f16c = (regs[2] >> 29) & 1;
+    // 操作系统须保存 YMM 寄存器状态
+    if (!fma || !osxsave || !f16c || (_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(regs, 7, 0);
+    return (regs[1] >> 5) & 1;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c");
+#endif
+}
+
+// 本机 CPU 是否支持 AVX2 + FMA + F16C，第一次调用时检测
+inline bool hasAvx2() {
+    static const bool supported = detectAvx2();
+    return supported;
+}
+#else
+inline bool hasAvx2() { return false; }
+#endif
+
+constexpr std::size_t kAlignment = 64;  // 缓存行对齐
+
+inline float* allocFloats(std::size_t count) {
+    if (count == 0) return nullptr;
+    std::size_t bytes = (count * sizeof(float) + kAlignment - 1) / kAlignment * kAlignment;
+#if defined(_WIN32)
+    void* p = _aligned_malloc(bytes, kAlignment);
+#else
+    void* p = std::aligned_alloc(kAlignment, bytes);
+#endif
+    if (!p) throw std::bad_alloc();
+    return static_cast<float*>(p);
+}
+
+inline void freeFloats(float* p) {
+#if defined(_WIN32)
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+#if NNV_HAVE_AVX2
+// 8 路 exp，Cephes 多项式近似，相对误差约 1e-7
+NNV_AVX2 inline __m256 exp256(__m256 x) {
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-87.3f)), _mm256_set1_ps(88.3f));
+    const __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504088896341f)),
+                                     _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    x = _mm256_fnmadd_ps(n, _mm256_set1_ps(0.693359375f), x);
+    x = _mm256_fnmadd_ps(n, _mm256_set1_ps(-2.12194440e-4f), x);
+    __m256 y = _mm256_set1_ps(1.9875691500e-4f);
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.3981999507e-3f));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(8.3334519073e-3f));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(4.1665795894e-2f));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.6666665459e-1f));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(5.0000001201e-1f));
+    y = _mm256_fmadd_ps(y, _mm256_mul_ps(x, x), _mm256_add_ps(x, _mm256_set1_ps(1.0f)));
+    __m256i e = _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127));
+    return _mm256_mul_ps(y, _mm256_castsi256_ps(_mm256_slli_epi32(e, 23)));
+}
+
+NNV_AVX2 inline __m256 sigmoid256(__m256 x) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    return _mm256_div_ps(one, _mm256_add_ps(one, exp256(_mm256_sub_ps(_mm256_setzero_ps(), x))));
+}
+
+// tanh(x) = 1 - 2 / (exp(2x) + 1)
+NNV_AVX2 inline __m256 tanh256(__m256 x) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 e = exp256(_mm256_add_ps(x, x));
+    return _mm256_sub_ps(one, _mm256_div_ps(_mm256_set1_ps(2.0f), _mm256_add_ps(e, one)));
+}
+#endif
+
+// 64 字节对齐的 float 缓冲区，只在 resize 时分配
+class AlignedBuffer
+{
+public:
+    AlignedBuffer() = default;
+    explicit AlignedBuffer(std::size_t count) { resize(count); }
+    ~AlignedBuffer() { freeFloats(m_data); }
+
+    AlignedBuffer(const AlignedBuffer&) = delete;
+    AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+    AlignedBuffer(AlignedBuffer&& other) noexcept : m_data(other.m_data), m_size(other.m_size) {
+        other.m_data = nullptr;
+        other.m_size = 0;
+    }
+    AlignedBuffer& operator=(AlignedBuffer&& other) noexcept {
+        if (this != &other) {
+            freeFloats(m_data);
+            m_data = other.m_data;
+            m_size = other.m_size;
+            other.m_data = nullptr;
+            other.m_size = 0;
+        }
+        return *this;
+    }
+
+    // 内容不保留，新内存清零
+    void resize(std::size_t count) {
+        if (count == m_size) return;
+        freeFloats(m_data);
+        m_data = allocFloats(count);
+        m_size = count;
+        if (m_data) std::memset(m_data, 0, count * sizeof(float));
+    }
+
+    float* data() { return m_data; }
+    const float* data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+    float& operator[](std::size_t i) { return m_data[i]; }
+    const float& operator[](std::size_t i) const { return m_data[i]; }
+
+private:
+    float* m_data = nullptr;
+    std::size_t m_size = 0;
+};
+
+} // namespace simd
+
+#endif // SIMDUTILS_H
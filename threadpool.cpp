@@ -0,0 +1,83 @@
+#include "threadpool.h"
+#include <algorithm>
+
+namespace {
+thread_local bool t_insidePool = false;
+}
+
+ThreadPool::ThreadPool(int threads) {
+    if (threads <= 0) threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    for (int i = 1; i < threads; ++i) {
+        m_workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& worker : m_workers) worker.join();
+}
+
+ThreadPool& ThreadPool::global() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::runChunks() {
+    for (;;) {
+        int chunk = m_next.fetch_add(m_grain, std::memory_order_relaxed);
+        if (chunk >= m_end) break;
+        (*m_fn)(chunk, std::min(chunk + m_grain, m_end));
+    }
+}
+
+void ThreadPool::workerLoop() {
+    t_insidePool = true;
+    unsigned long seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+            if (m_stop) return;
+            seen = m_generation;
+        }
+        runChunks();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_active == 0) m_done.notify_one();
+        }
+    }
+}
+
+void ThreadPool::parallelFor(int begin, int end, int grain, const std::function<void(int, int)>& fn) {
+    if (end <= begin) return;
+    grain = std::max(1, grain);
+    // 任务太少、没有工作线程或嵌套调用时直接在当前线程执行
+    if (m_workers.empty() || end - begin <= grain || t_insidePool) {
+        for (int i = begin; i < end; i += grain) fn(i, std::min(i + grain, end));
+        return;
+    }
+
+    std::lock_guard<std::mutex> submit(m_submitMutex);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_fn = &fn;
+        m_end = end;
+        m_grain = grain;
+        m_next.store(begin, std::memory_order_relaxed);
+        m_active = static_cast<int>(m_workers.size());
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    t_insidePool = true;
+    runChunks();
+    t_insidePool = false;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [&] { return m_active == 0; });
+    m_fn = nullptr;
+}
@@ -0,0 +1,49 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 计算内核使用的固定线程池
+// parallelFor 把 [begin, end) 按 grain 切块，调用线程也参与计算；块通过原子计数器动态领取
+class ThreadPool
+{
+public:
+    explicit ThreadPool(int threads = 0);  // 0 表示使用全部硬件线程
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int threadCount() const { return static_cast<int>(m_workers.size()) + 1; }
+
+    // fn(chunkBegin, chunkEnd)；在池内线程中再次调用时直接串行执行，避免死锁
+    void parallelFor(int begin, int end, int grain, const std::function<void(int, int)>& fn);
+
+    // 全局共享实例
+    static ThreadPool& global();
+
+private:
+    void workerLoop();
+    void runChunks();
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_submitMutex;  // 同一时刻只执行一个 parallelFor
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+
+    const std::function<void(int, int)>* m_fn = nullptr;
+    int m_end = 0;
+    int m_grain = 1;
+    std::atomic<int> m_next{0};
+    int m_active = 0;            // 仍在执行当前任务的工作线程数
+    unsigned long m_generation = 0;
+    bool m_stop = false;
+};
+
+#endif // THREADPOOL_H
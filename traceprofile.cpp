@@ -0,0 +1,373 @@
+#include "traceprofile.h"
+#include "jsonstream.h"
+
+#include <QFile>
+#include <QHash>
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+// 只保留作用域与 [memory] 事件的这几个字段，其余事件读过即丢
+struct ScopeEvent
+{
+    double ts;
+    double dur;
+    int thread;
+    int scope;
+};
+
+struct MemoryEvent
+{
+    double ts;
+    qint64 bytes;
+    int thread;
+};
+
+enum EventCategory { OtherCategory, PythonFunction, UserAnnotation };
+
+// pid / tid 可以是数字，也可以是 "stream 7" 这样的字符串
+qint64 threadPart(JsonStreamReader& reader, JsonStreamReader::Token token)
+{
+    if (token == JsonStreamReader::Number) return static_cast<qint64>(reader.number());
+    if (token == JsonStreamReader::String) return static_cast<qint64>(qHash(reader.utf8())) | (qint64(1) << 40);
+    return 0;
+}
+
+class TraceLoader
+{
+public:
+    explicit TraceLoader(QIODevice* device) : m_reader(device) {
+        m_name.reserve(256);
+    }
+
+    bool load(TraceProfile* profile, QString* error) {
+        JsonStreamReader::Token token = m_reader.next();
+        bool found = false;
+        if (token == JsonStreamReader::BeginArray) {
+            if (!readEvents()) return fail(error, eventError());
+            found = true;
+        } else if (token == JsonStreamReader::BeginObject) {
+            while ((token = m_reader.next()) == JsonStreamReader::Key) {
+                if (m_reader.textEquals("traceEvents")) {
+                    if (m_reader.next() != JsonStreamReader::BeginArray) return fail(error, "traceEvents 不是数组");
+                    if (!readEvents()) return fail(error, eventError());
+                    found = true;
+                } else if (!m_reader.skipValue()) {
+                    break;
+                }
+            }
+        }
+        if (m_reader.hasError()) return fail(error, m_reader.errorString());
+        if (!found) return fail(error, "文件中没有 traceEvents");
+        if (m_reader.next() != JsonStreamReader::EndOfDocument)
+            return fail(error, m_reader.hasError() ? m_reader.errorString() : QString("traceEvents 之后有多余内容"));
+
+        aggregate(profile);
+        return true;
+    }
+
+private:
+    bool fail(QString* error, const QString& message) {
+        if (error) *error = message;
+        return false;
+    }
+
+    QString eventError() const {
+        if (m_reader.hasError()) return m_reader.errorString();
+        return QString("第 %1 字节：第 %2 个事件的格式不对").arg(m_reader.offset()).arg(m_events + 1);
+    }
+
+    // 已读入 traceEvents 的 '['，读到配对的 ']' 为止
+    bool readEvents() {
+        JsonStreamReader::Token token;
+        while ((token = m_reader.next()) == JsonStreamReader::BeginObject) {
+            if (!readEvent()) return false;
+        }
+        return token == JsonStreamReader::EndArray;
+    }
+
+    bool readEvent() {
+        char phase = 0;
+        EventCategory category = OtherCategory;
+        bool hasName = false;
+        double ts = 0.0, dur = 0.0;
+        qint64 pid = 0, tid = 0, bytes = 0;
+        m_name.resize(0);
+
+        JsonStreamReader::Token token;
+        while ((token = m_reader.next()) == JsonStreamReader::Key) {
+            const QByteArray& key = m_reader.utf8();
+            if (key == "ph") {
+                if (m_reader.next() != JsonStreamReader::String) return false;
+                phase = m_reader.utf8().isEmpty() ? 0 : m_reader.utf8().at(0);
+            } else if (key == "cat") {
+                if (m_reader.next() != JsonStreamReader::String) return false;
+                category = m_reader.textEquals("python_function") ? PythonFunction
+                         : m_reader.textEquals("user_annotation") ? UserAnnotation : OtherCategory;
+            } else if (key == "name") {
+                if (m_reader.next() != JsonStreamReader::String) return false;
+                m_name.append(m_reader.utf8());
+                hasName = true;
+            } else if (key == "ts" || key == "dur") {
+                const bool isTs = key.size() == 2;
+                if (m_reader.next() != JsonStreamReader::Number) return false;
+                (isTs ? ts : dur) = m_reader.number();
+            } else if (key == "pid" || key == "tid") {
+                const bool isPid = key.at(0) == 'p';
+                const qint64 part = threadPart(m_reader, m_reader.next());
+                if (m_reader.hasError()) return false;
+                (isPid ? pid : tid) = part;
+            } else if (key == "args" && (!hasName || m_name == "[memory]")) {
+                // 只有 [memory] 事件需要 args.Bytes；其余事件的 args（Input Dims 等）整个跳过
+                if (!readArgs(&bytes)) return false;
+            } else if (!m_reader.skipValue()) {
+                return false;
+            }
+        }
+        if (token != JsonStreamReader::EndObject) return false;
+        ++m_events;
+
+        if (phase == 'X' && dur >= 0.0) {
+            const int scope = scopeIndex(category);
+            if (scope >= 0) {
+                m_scopeEvents.append({ts, dur, threadIndex(pid, tid), scope});
+                TraceScope& s = m_scopes[scope];
+                ++s.calls;
+                s.totalUs += dur;
+                s.selfUs += dur;
+                m_first = std::min(m_first, ts);
+                m_last = std::max(m_last, ts + dur);
+            }
+        } else if ((phase == 'i' || phase == 'I') && m_name == "[memory]" && bytes != 0) {
+            m_memoryEvents.append({ts, bytes, threadIndex(pid, tid)});
+        }
+        return true;
+    }
+
+    bool readArgs(qint64* bytes) {
+        JsonStreamReader::Token token = m_reader.next();
+        if (token == JsonStreamReader::BeginArray) return skipNested();
+        if (token != JsonStreamReader::BeginObject) return token != JsonStreamReader::Invalid;
+        while ((token = m_reader.next()) == JsonStreamReader::Key) {
+            if (m_reader.textEquals("Bytes")) {
+                if (m_reader.next() != JsonStreamReader::Number) return false;
+                *bytes = static_cast<qint64>(m_reader.number());
+            } else if (!m_reader.skipValue()) {
+                return false;
+            }
+        }
+        return token == JsonStreamReader::EndObject;
+    }
+
+    // args 是数组（不是 torch.profiler 的格式）：跳到配对的 ']'
+    bool skipNested() {
+        int depth = 1;
+        while (depth > 0) {
+            const JsonStreamReader::Token token = m_reader.next();
+            if (token == JsonStreamReader::Invalid || token == JsonStreamReader::EndOfDocument) return false;
+            if (token == JsonStreamReader::BeginArray || token == JsonStreamReader::BeginObject) ++depth;
+            else if (token == JsonStreamReader::EndArray || token == JsonStreamReader::EndObject) --depth;
+        }
+        return true;
+    }
+
+    int scopeIndex(EventCategory category) {
+        static const QByteArray modulePrefix("nn.Module: ");
+        if (category == PythonFunction) {
+            if (!m_name.startsWith(modulePrefix)) return -1;
+        } else if (category == UserAnnotation) {
+            // ProfilerStep#12 每一步一个名字，只是外层包装，不当作作用域
+            if (m_name.startsWith("ProfilerStep#")) return -1;
+        } else {
+            return -1;
+        }
+        const auto it = m_scopeIndex.constFind(m_name);
+        if (it != m_scopeIndex.constEnd()) return it.value();
+
+        TraceScope scope;
+        if (category == PythonFunction) {
+            scope.name = QString::fromUtf8(m_name.mid(modulePrefix.size()));
+            const int underscore = scope.name.lastIndexOf('_');
+            bool ok = false;
+            const int instance = underscore > 0 ? scope.name.mid(underscore + 1).toInt(&ok) : 0;
+            scope.moduleType = ok ? scope.name.left(underscore) : scope.name;
+            scope.instance = ok ? instance : 0;
+        } else {
+            scope.name = QString::fromUtf8(m_name);
+        }
+        m_scopes.append(scope);
+        m_scopeIndex.insert(QByteArray(m_name.constData(), m_name.size()), m_scopes.size() - 1);
+        return m_scopes.size() - 1;
+    }
+
+    int threadIndex(qint64 pid, qint64 tid) {
+        const quint64 key = (quint64(pid) << 24) ^ quint64(tid);
+        const auto it = m_threads.constFind(key);
+        if (it != m_threads.constEnd()) return it.value();
+        const int index = m_threads.size();
+        m_threads.insert(key, index);
+        return index;
+    }
+
+    // 每个线程内按开始时间（同时开始的长者在外）排序，用栈还原嵌套：
+    // 子作用域的时间从直接父作用域的 self 中扣掉，[memory] 事件记到当时最内层的作用域及其各级父作用域
+    void aggregate(TraceProfile* profile) {
+        std::sort(m_scopeEvents.begin(), m_scopeEvents.end(), [](const ScopeEvent& a, const ScopeEvent& b) {
+            if (a.thread != b.thread) return a.thread < b.thread;
+            if (a.ts != b.ts) return a.ts < b.ts;
+            return a.dur > b.dur;
+        });
+        std::sort(m_memoryEvents.begin(), m_memoryEvents.end(), [](const MemoryEvent& a, const MemoryEvent& b) {
+            return a.thread != b.thread ? a.thread < b.thread : a.ts < b.ts;
+        });
+
+        QVector<const ScopeEvent*> stack;
+        int m = 0;
+        auto popEnded = [&](double ts) {
+            while (!stack.isEmpty() && stack.last()->ts + stack.last()->dur <= ts) stack.removeLast();
+        };
+        auto attribute = [&](const MemoryEvent& memory) {
+            popEnded(memory.ts);
+            if (stack.isEmpty() || memory.bytes <= 0) return;
+            m_scopes[stack.last()->scope].selfAllocatedBytes += memory.bytes;
+            for (const ScopeEvent* open : stack) m_scopes[open->scope].totalAllocatedBytes += memory.bytes;
+        };
+        for (int i = 0; i < m_scopeEvents.size(); ++i) {
+            const ScopeEvent& event = m_scopeEvents[i];
+            if (i == 0 || m_scopeEvents[i - 1].thread != event.thread) stack.clear();
+            // 先处理本线程中更早的内存事件；别的线程上的内存事件没有作用域可记
+            while (m < m_memoryEvents.size() && (m_memoryEvents[m].thread < event.thread ||
+                                                 (m_memoryEvents[m].thread == event.thread && m_memoryEvents[m].ts < event.ts))) {
+                if (m_memoryEvents[m].thread == event.thread) attribute(m_memoryEvents[m]);
+                ++m;
+            }
+            popEnded(event.ts);
+            if (!stack.isEmpty()) {
+                // 与父作用域只部分重叠的（时钟误差）按重叠部分扣除
+                const ScopeEvent* parent = stack.last();
+                const double overlap = std::min(event.dur, parent->ts + parent->dur - event.ts);
+                m_scopes[parent->scope].selfUs -= overlap;
+            }
+            stack.append(&event);
+
+            // 本线程的最后一个作用域：把剩余的内存事件处理完
+            if (i + 1 == m_scopeEvents.size() || m_scopeEvents[i + 1].thread != event.thread) {
+                while (m < m_memoryEvents.size() && m_memoryEvents[m].thread <= event.thread) {
+                    if (m_memoryEvents[m].thread == event.thread) attribute(m_memoryEvents[m]);
+                    ++m;
+                }
+            }
+        }
+
+        for (TraceScope& scope : m_scopes) scope.selfUs = std::max(scope.selfUs, 0.0);
+        std::sort(m_scopes.begin(), m_scopes.end(), [](const TraceScope& a, const TraceScope& b) {
+            return a.totalUs > b.totalUs;
+        });
+
+        profile->scopes = m_scopes;
+        profile->events = m_events;
+        profile->scopeEvents = m_scopeEvents.size();
+        profile->memoryEvents = m_memoryEvents.size();
+        profile->threads = m_threads.size();
+        profile->spanUs = m_scopeEvents.isEmpty() ? 0.0 : m_last - m_first;
+        profile->retainedBytes = qint64(m_scopeEvents.capacity()) * qint64(sizeof(ScopeEvent)) +
+                                 qint64(m_memoryEvents.capacity()) * qint64(sizeof(MemoryEvent));
+    }
+
+    JsonStreamReader m_reader;
+    QByteArray m_name;
+    QVector<TraceScope> m_scopes;
+    QHash<QByteArray, int> m_scopeIndex;
+    QHash<quint64, int> m_threads;
+    QVector<ScopeEvent> m_scopeEvents;
+    QVector<MemoryEvent> m_memoryEvents;
+    qint64 m_events = 0;
+    double m_first = std::numeric_limits<double>::max();
+    double m_last = std::numeric_limits<double>::lowest();
+};
+
+// 显示层的类型与 PyTorch 模块类型（导入时的映射反过来）
+QString layerKind(const NeuralLayer& layer)
+{
+    if (layer.isDense()) return "Dense";
+    if (layer.isConvolutional()) return "Conv2d";
+    if (layer.layerType == "MaxPooling") return "MaxPooling";
+    if (layer.layerType == "AvgPooling" || layer.layerType == "AveragePooling") return "AvgPooling";
+    return layer.layerType;
+}
+
+QString moduleKind(const QString& type)
+{
+    if (type == "Linear" || type == "LazyLinear") return "Dense";
+    if (type == "Conv2d" || type == "LazyConv2d") return "Conv2d";
+    if (type == "MaxPool2d") return "MaxPooling";
+    if (type == "AvgPool2d") return "AvgPooling";
+    if (type == "Dropout" || type == "Dropout1d" || type == "Dropout2d" || type == "AlphaDropout") return "Dropout";
+    if (type == "LSTM" || type == "GRU" || type == "RNN" || type == "Flatten") return type;
+    return QString();
+}
+
+} // namespace
+
+bool loadChromeTrace(QIODevice* device, TraceProfile* profile, QString* error)
+{
+    *profile = TraceProfile();
+    TraceLoader loader(device);
+    return loader.load(profile, error);
+}
+
+bool loadChromeTrace(const QString& path, TraceProfile* profile, QString* error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = QString("无法打开 %1：%2").arg(path, file.errorString());
+        return false;
+    }
+    const bool ok = loadChromeTrace(&file, profile, error);
+    profile->fileBytes = file.size();
+    return ok;
+}
+
+QVector<int> matchTraceScopes(const TraceProfile& profile, const QList<NeuralLayer>& layers, const QStringList& names)
+{
+    QVector<int> match(layers.size(), -1);
+    QVector<bool> used(profile.scopes.size(), false);
+
+    if (names.size() == layers.size()) {
+        QHash<QString, int> byName;
+        for (int s = 0; s < profile.scopes.size(); ++s) {
+            if (profile.scopes[s].moduleType.isEmpty()) byName.insert(profile.scopes[s].name, s);
+        }
+        for (int i = 0; i < layers.size(); ++i) {
+            const auto it = byName.constFind(names[i]);
+            if (names[i].isEmpty() || it == byName.constEnd()) continue;
+            match[i] = it.value();
+            used[it.value()] = true;
+        }
+    }
+
+    // 同类模块按序号排队，依次分给同类的未匹配层
+    QHash<QString, QVector<int>> queues;
+    for (int s = 0; s < profile.scopes.size(); ++s) {
+        const TraceScope& scope = profile.scopes[s];
+        const QString kind = moduleKind(scope.moduleType);
+        if (!kind.isEmpty() && !used[s]) queues[kind].append(s);
+    }
+    for (auto it = queues.begin(); it != queues.end(); ++it) {
+        std::sort(it.value().begin(), it.value().end(), [&](int a, int b) {
+            return profile.scopes[a].instance < profile.scopes[b].instance;
+        });
+    }
+    QHash<QString, int> next;
+    for (int i = 0; i < layers.size(); ++i) {
+        if (match[i] >= 0) continue;
+        const QString kind = layerKind(layers[i]);
+        const auto queue = queues.constFind(kind);
+        if (queue == queues.constEnd()) continue;
+        int& k = next[kind];
+        if (k < queue.value().size()) match[i] = queue.value()[k++];
+    }
+    return match;
+}
@@ -0,0 +1,49 @@
+#ifndef TRACEPROFILE_H
+#define TRACEPROFILE_H
+
+#include "backend.h"
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class QIODevice;
+
+// torch.profiler 导出的 Chrome 追踪中的一个作用域：with_modules / with_stack 时的 "nn.Module: Conv2d_3"
+// （python_function 事件），或 record_function("layer1.0.conv1") 标注（user_annotation 事件）
+struct TraceScope
+{
+    QString name;         // "Conv2d_3" 或 record_function 的名称
+    QString moduleType;   // "Conv2d"；record_function 标注为空
+    int instance = -1;    // 同类模块的序号（名称中 '_' 之后的数字）
+    int calls = 0;
+    double totalUs = 0.0; // 含子作用域
+    double selfUs = 0.0;  // 去掉直接子作用域之后的部分（本作用域内算子的时间都算在这里）
+    qint64 selfAllocatedBytes = 0;   // [memory] 事件中落在本作用域、不在子作用域内的正向分配
+    qint64 totalAllocatedBytes = 0;
+};
+
+struct TraceProfile
+{
+    QVector<TraceScope> scopes;  // 按 totalUs 从大到小
+    qint64 events = 0;           // traceEvents 中的事件总数
+    qint64 scopeEvents = 0;
+    qint64 memoryEvents = 0;
+    int threads = 0;
+    double spanUs = 0.0;         // 作用域事件覆盖的时间跨度
+    qint64 fileBytes = 0;
+    qint64 retainedBytes = 0;    // 解析过程中保留的事件记录大小（只有作用域与 [memory] 事件，每条 24 字节）
+};
+
+// 流式读取 Chrome 追踪（{"traceEvents": [...]} 或顶层数组），按线程还原作用域嵌套，
+// 汇总每个作用域的自身 / 总计 CPU 时间和内存分配。不建立 QJsonDocument，算子事件读过即丢
+bool loadChromeTrace(QIODevice* device, TraceProfile* profile, QString* error = nullptr);
+bool loadChromeTrace(const QString& path, TraceProfile* profile, QString* error = nullptr);
+
+// 每个显示层对应的作用域下标（-1 为未匹配）。names 与 layers 等长时先按名称匹配 record_function 标注，
+// 其余按类型和顺序：第 k 个 Dense 层对应 Linear 模块中序号第 k 小的一个，卷积、池化、循环层等同理
+QVector<int> matchTraceScopes(const TraceProfile& profile, const QList<NeuralLayer>& layers,
+                              const QStringList& names = QStringList());
+
+#endif // TRACEPROFILE_H
@@ -0,0 +1,389 @@
+#include "trainingdialog.h"
+#include "threadpool.h"
+#include <QCloseEvent>
+#include <QElapsedTimer>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QPainter>
+#include <QPainterPath>
+#include <QVBoxLayout>
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+namespace {
+
+// 损失/吞吐与权重快照的发送间隔，避免信号淹没界面线程
+constexpr qint64 kProgressIntervalMs = 100;
+constexpr qint64 kWeightIntervalMs = 250;
+// 预览网络的连线上限，超过后不绘制连线（每次刷新都要逐条改画笔）
+constexpr long long kMaxPreviewConnections = 20000;
+// 曲线最多保留的点数，超过后相邻两点合并
+constexpr int kMaxChartPoints = 2000;
+
+} // namespace
+
+TrainingWorker::TrainingWorker(const QList<NeuralLayer>& layers, const TrainingConfig& config, int epochs, int samples)
+    : m_layers(layers), m_config(config), m_epochs(epochs), m_samples(samples) {}
+
+QVector<QVector<float>> TrainingWorker::snapshotWeights(const TrainingEngine& engine) const {
+    QVector<QVector<float>> weights;
+    for (int l = 0; l < engine.layerCount(); ++l) {
+        const TrainingEngine::LayerInfo& info = engine.layerInfo(l);
+        if (!info.dense) continue;
+        const float* w = engine.weightData(l);
+        QVector<float> copy(info.inputs * info.outputs);
+        std::copy(w, w + copy.size(), copy.begin());
+        weights.append(copy);
+    }
+    return weights;
+}
+
+void TrainingWorker::run() {
+    TrainingEngine engine;
+    QString error;
+    if (!engine.build(m_layers, m_config, &error)) {
+        emit failed(error);
+        emit finished();
+        return;
+    }
+    emit started(engine.parameterCount(), ThreadPool::global().threadCount(), engine.usesCrossEntropy());
+
+    // 末层为 Softmax 时生成分类数据，否则生成回归数据；最后 10% 作为验证集
+    const TrainingData data = makeSyntheticData(engine.inputSize(), engine.outputSize(), m_samples, engine.usesCrossEntropy());
+    const int validation = std::max(1, m_samples / 10);
+    const int trainCount = m_samples - validation;
+    const int batch = std::max(1, std::min(m_config.batchSize, trainCount));
+    const std::size_t inputs = engine.inputSize();
+    const std::size_t outputs = engine.outputSize();
+
+    std::vector<int> order(trainCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::mt19937 rng(7);
+    std::vector<float> xb(batch * inputs);
+    std::vector<float> yb(batch * outputs);
+
+    QElapsedTimer progressTimer;
+    QElapsedTimer weightTimer;
+    progressTimer.start();
+    weightTimer.start();
+    double lossSum = 0.0;
+    int lossSteps = 0;
+    long long samplesSinceReport = 0;
+    int epoch = 1;
+    for (; epoch <= m_epochs && !m_stop.load(); ++epoch) {
+        std::shuffle(order.begin(), order.end(), rng);
+        for (int s = 0; s + batch <= trainCount && !m_stop.load(); s += batch) {
+            for (int r = 0; r < batch; ++r) {
+                const std::size_t src = order[s + r];
+                std::copy_n(data.x.data() + src * inputs, inputs, xb.data() + r * inputs);
+                std::copy_n(data.y.data() + src * outputs, outputs, yb.data() + r * outputs);
+            }
+            lossSum += engine.trainStep(xb.data(), yb.data(), batch);
+            ++lossSteps;
+            samplesSinceReport += batch;
+
+            const qint64 elapsed = progressTimer.nsecsElapsed();
+            if (elapsed >= kProgressIntervalMs * 1000000) {
+                emit progress(epoch, engine.step(), lossSum / lossSteps, samplesSinceReport * 1.0e9 / elapsed);
+                lossSum = 0.0;
+                lossSteps = 0;
+                samplesSinceReport = 0;
+                progressTimer.restart();
+            }
+            if (weightTimer.elapsed() >= kWeightIntervalMs) {
+                emit weightsUpdated(snapshotWeights(engine));
+                weightTimer.restart();
+            }
+        }
+        if (m_stop.load()) break;
+        double accuracy = 0.0;
+        const double validationLoss = engine.evaluate(data.x.data() + trainCount * inputs, data.y.data() + trainCount * outputs,
+                                                      validation, &accuracy);
+        emit epochFinished(epoch, engine.step(), validationLoss, accuracy);
+    }
+    if (lossSteps > 0) {
+        emit progress(std::min(epoch, m_epochs), engine.step(), lossSum / lossSteps,
+                      samplesSinceReport * 1.0e9 / std::max<qint64>(1, progressTimer.nsecsElapsed()));
+    }
+    emit weightsUpdated(snapshotWeights(engine));
+    emit finished();
+}
+
+LossChartWidget::LossChartWidget(QWidget* parent)
+    : QWidget(parent) {
+    setMinimumSize(420, 220);
+}
+
+void LossChartWidget::append(QVector<QPointF>& series, const QPointF& point) {
+    series.append(point);
+    if (series.size() <= kMaxChartPoints) return;
+    QVector<QPointF> merged;
+    merged.reserve(series.size() / 2 + 1);
+    for (int i = 0; i + 1 < series.size(); i += 2) {
+        merged.append(QPointF(series[i + 1].x(), (series[i].y() + series[i + 1].y()) / 2.0));
+    }
+    if (series.size() % 2) merged.append(series.last());
+    series = merged;
+}
+
+void LossChartWidget::addTrainingPoint(double step, double loss) {
+    append(m_training, QPointF(step, loss));
+    update();
+}
+
+void LossChartWidget::addValidationPoint(double step, double loss) {
+    append(m_validation, QPointF(step, loss));
+    update();
+}
+
+void LossChartWidget::clear() {
+    m_training.clear();
+    m_validation.clear();
+    update();
+}
+
+void LossChartWidget::paintEvent(QPaintEvent*) {
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.fillRect(rect(), Qt::white);
+
+    const QRectF plot(56, 12, width() - 72, height() - 40);
+    double maxX = 1.0;
+    double maxY = 0.0;
+    for (const QVector<QPointF>* series : {&m_training, &m_validation}) {
+        for (const QPointF& p : *series) {
+            maxX = std::max(maxX, p.x());
+            maxY = std::max(maxY, p.y());
+        }
+    }
+    if (maxY <= 0.0) maxY = 1.0;
+    maxY *= 1.05;
+
+    // 坐标轴与网格
+    painter.setPen(QColor(220, 220, 220));
+    for (int i = 0; i <= 4; ++i) {
+        const double y = plot.bottom() - plot.height() * i / 4.0;
+        painter.drawLine(QPointF(plot.left(), y), QPointF(plot.right(), y));
+        painter.setPen(Qt::darkGray);
+        painter.drawText(QRectF(0, y - 8, plot.left() - 6, 16), Qt::AlignRight | Qt::AlignVCenter,
+                         QString::number(maxY * i / 4.0, 'g', 3));
+        painter.setPen(QColor(220, 220, 220));
+    }
+    painter.setPen(Qt::darkGray);
+    painter.drawRect(plot);
+    painter.drawText(QRectF(plot.left(), plot.bottom() + 4, plot.width(), 20), Qt::AlignRight,
+                     QString("step %1").arg(static_cast<long long>(maxX)));
+
+    auto toScreen = [&](const QPointF& p) {
+        return QPointF(plot.left() + plot.width() * p.x() / maxX, plot.bottom() - plot.height() * p.y() / maxY);
+    };
+    const struct { const QVector<QPointF>* series; QColor color; const char* name; } curves[] = {
+        {&m_training, QColor(30, 110, 220), "train"}, {&m_validation, QColor(230, 120, 20), "validation"}};
+    int legendX = static_cast<int>(plot.left()) + 10;
+    for (const auto& curve : curves) {
+        painter.setPen(QPen(curve.color, 1.6));
+        if (!curve.series->isEmpty()) {
+            QPainterPath path(toScreen(curve.series->first()));
+            for (int i = 1; i < curve.series->size(); ++i) path.lineTo(toScreen((*curve.series)[i]));
+            painter.drawPath(path);
+            if (curve.series == &m_validation) {
+                painter.setBrush(curve.color);
+                for (const QPointF& p : *curve.series) painter.drawEllipse(toScreen(p), 2.5, 2.5);
+                painter.setBrush(Qt::NoBrush);
+            }
+        }
+        painter.drawLine(legendX, 24, legendX + 18, 24);
+        painter.drawText(legendX + 22, 28, curve.name);
+        legendX += 100;
+    }
+}
+
+TrainingDialog::TrainingDialog(const QList<NeuralLayer>& layers, QWidget* parent)
+    : QDialog(parent), m_layers(layers) {
+    setWindowTitle("Train Network");
+    resize(1100, 700);
+
+    m_optimizerBox = new QComboBox(this);
+    m_optimizerBox->addItem(optimizerName(OptimizerType::Adam));
+    m_optimizerBox->addItem(optimizerName(OptimizerType::SGD));
+    m_learningRateBox = new QDoubleSpinBox(this);
+    m_learningRateBox->setDecimals(5);
+    m_learningRateBox->setRange(0.00001, 1.0);
+    m_learningRateBox->setSingleStep(0.0005);
+    m_learningRateBox->setValue(0.001);
+    // 切换优化器时给出各自常用的学习率
+    connect(m_optimizerBox, &QComboBox::currentTextChanged, this, [this](const QString& name) {
+        m_learningRateBox->setValue(name == "SGD" ? 0.05 : 0.001);
+    });
+    m_batchBox = new QSpinBox(this);
+    m_batchBox->setRange(1, 4096);
+    m_batchBox->setValue(64);
+    m_epochBox = new QSpinBox(this);
+    m_epochBox->setRange(1, 1000);
+    m_epochBox->setValue(20);
+    m_sampleBox = new QSpinBox(this);
+    m_sampleBox->setRange(256, 1000000);
+    m_sampleBox->setSingleStep(1024);
+    m_sampleBox->setValue(8192);
+
+    QFormLayout* form = new QFormLayout();
+    form->addRow("Optimizer", m_optimizerBox);
+    form->addRow("Learning rate", m_learningRateBox);
+    form->addRow("Batch size", m_batchBox);
+    form->addRow("Epochs", m_epochBox);
+    form->addRow("Synthetic samples", m_sampleBox);
+
+    m_startButton = new QPushButton("开始训练", this);
+    m_stopButton = new QPushButton("停止", this);
+    m_stopButton->setEnabled(false);
+    connect(m_startButton, &QPushButton::clicked, this, &TrainingDialog::startTraining);
+    connect(m_stopButton, &QPushButton::clicked, this, &TrainingDialog::stopTraining);
+    QHBoxLayout* buttons = new QHBoxLayout();
+    buttons->addWidget(m_startButton);
+    buttons->addWidget(m_stopButton);
+
+    m_statusLabel = new QLabel("就绪", this);
+    m_statusLabel->setWordWrap(true);
+    m_epochLabel = new QLabel(this);
+    m_epochLabel->setWordWrap(true);
+
+    QVBoxLayout* controls = new QVBoxLayout();
+    controls->addLayout(form);
+    controls->addLayout(buttons);
+    controls->addWidget(m_statusLabel);
+    controls->addWidget(m_epochLabel);
+    controls->addStretch(1);
+
+    m_chart = new LossChartWidget(this);
+    m_visualizer = new NetworkVisualizer(this);
+
+    QVBoxLayout* right = new QVBoxLayout();
+    right->addWidget(m_chart, 2);
+    right->addWidget(m_visualizer, 3);
+
+    QHBoxLayout* mainLayout = new QHBoxLayout(this);
+    mainLayout->addLayout(controls, 1);
+    mainLayout->addLayout(right, 3);
+
+    buildPreview();
+}
+
+TrainingDialog::~TrainingDialog() {
+    shutdownWorker();
+}
+
+void TrainingDialog::buildPreview() {
+    // 输入列 + 每个 Dense 层一列，第 i 组连线正好对应第 i 个 Dense 层的权重
+    QList<const NeuralLayer*> ordered;
+    for (const NeuralLayer& layer : m_layers) ordered.append(&layer);
+    if (ordered.isEmpty()) return;
+    NeuralLayer input;
+    input.layerType = "Input";
+    input.neurons = defaultInputShape(ordered).size();
+    input.activationFunction = "";
+    QList<NeuralLayer> columns;
+    columns.append(input);
+    for (const NeuralLayer& layer : m_layers) {
+        if (layer.isDense()) columns.append(layer);
+    }
+
+    m_columnSizes.clear();
+    long long connections = 0;
+    for (int i = 0; i < columns.size(); ++i) {
+        m_columnSizes.append(columns[i].neurons);
+        if (i > 0) connections += static_cast<long long>(columns[i - 1].neurons) * columns[i].neurons;
+    }
+    m_edgesVisible = columns.size() > 1 && connections <= kMaxPreviewConnections;
+    if (m_edgesVisible) {
+        m_visualizer->createNetwork(columns);
+    } else {
+        m_epochLabel->setText(QString("网络共有 %1 条连线，超过 %2 条时不绘制权重预览").arg(connections).arg(kMaxPreviewConnections));
+    }
+}
+
+void TrainingDialog::startTraining() {
+    if (m_thread) return;
+
+    TrainingConfig config;
+    config.optimizer = m_optimizerBox->currentText() == "SGD" ? OptimizerType::SGD : OptimizerType::Adam;
+    config.learningRate = static_cast<float>(m_learningRateBox->value());
+    config.batchSize = m_batchBox->value();
+
+    m_chart->clear();
+    m_statusLabel->setText("正在构建训练引擎…");
+    m_thread = new QThread(this);
+    m_worker = new TrainingWorker(m_layers, config, m_epochBox->value(), m_sampleBox->value());
+    m_worker->moveToThread(m_thread);
+    connect(m_thread, &QThread::started, m_worker, &TrainingWorker::run);
+    connect(m_worker, &TrainingWorker::started, this, &TrainingDialog::onStarted);
+    connect(m_worker, &TrainingWorker::progress, this, &TrainingDialog::onProgress);
+    connect(m_worker, &TrainingWorker::epochFinished, this, &TrainingDialog::onEpochFinished);
+    connect(m_worker, &TrainingWorker::weightsUpdated, this, &TrainingDialog::onWeightsUpdated);
+    connect(m_worker, &TrainingWorker::failed, this, &TrainingDialog::onFailed);
+    connect(m_worker, &TrainingWorker::finished, m_thread, &QThread::quit);
+    connect(m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    connect(m_thread, &QThread::finished, this, &TrainingDialog::onFinished);
+
+    m_startButton->setEnabled(false);
+    m_stopButton->setEnabled(true);
+    m_thread->start();
+}
+
+void TrainingDialog::stopTraining() {
+    if (m_worker) m_worker->requestStop();
+}
+
+void TrainingDialog::shutdownWorker() {
+    if (!m_thread) return;
+    m_worker->requestStop();
+    m_thread->quit();
+    m_thread->wait();
+}
+
+void TrainingDialog::closeEvent(QCloseEvent* event) {
+    shutdownWorker();
+    QDialog::closeEvent(event);
+}
+
+void TrainingDialog::onStarted(long long parameters, int threads, bool crossEntropy) {
+    m_statusLabel->setText(QString("参数量 %1，%2 个线程，损失函数：%3")
+                               .arg(parameters)
+                               .arg(threads)
+                               .arg(crossEntropy ? "交叉熵（Softmax 输出）" : "均方误差"));
+}
+
+void TrainingDialog::onProgress(int epoch, long long step, double loss, double samplesPerSecond) {
+    m_chart->addTrainingPoint(double(step), loss);
+    setWindowTitle(QString("Train Network — epoch %1  step %2  loss %3  %4 samples/s")
+                       .arg(epoch)
+                       .arg(step)
+                       .arg(loss, 0, 'f', 4)
+                       .arg(samplesPerSecond, 0, 'f', 0));
+}
+
+void TrainingDialog::onEpochFinished(int epoch, long long step, double validationLoss, double accuracy) {
+    m_chart->addValidationPoint(double(step), validationLoss);
+    QString text = QString("epoch %1：验证损失 %2").arg(epoch).arg(validationLoss, 0, 'f', 4);
+    if (accuracy > 0.0) text += QString("，准确率 %1%").arg(accuracy * 100.0, 0, 'f', 1);
+    m_epochLabel->setText(text);
+}
+
+void TrainingDialog::onWeightsUpdated(const QVector<QVector<float>>& weights) {
+    if (!m_edgesVisible) return;
+    for (int i = 0; i < weights.size() && i + 1 < m_columnSizes.size(); ++i) {
+        m_visualizer->setConnectionWeights(i, weights[i].constData(), m_columnSizes[i + 1], m_columnSizes[i]);
+    }
+}
+
+void TrainingDialog::onFailed(const QString& error) {
+    m_statusLabel->setText("无法训练：" + error);
+}
+
+void TrainingDialog::onFinished() {
+    m_thread->deleteLater();
+    m_thread = nullptr;
+    m_worker = nullptr;
+    m_startButton->setEnabled(true);
+    m_stopButton->setEnabled(false);
+}
@@ -0,0 +1,113 @@
+#ifndef TRAININGDIALOG_H
+#define TRAININGDIALOG_H
+
+#include <QComboBox>
+#include <QDialog>
+#include <QDoubleSpinBox>
+#include <QLabel>
+#include <QPointF>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QThread>
+#include <QVector>
+#include <QWidget>
+#include <atomic>
+#include "backend.h"
+#include "networkvisualizer.h"
+#include "trainingengine.h"
+
+// 在后台线程上运行 TrainingEngine，按节流频率把损失、吞吐与权重快照发回界面线程
+class TrainingWorker : public QObject
+{
+    Q_OBJECT
+public:
+    TrainingWorker(const QList<NeuralLayer>& layers, const TrainingConfig& config, int epochs, int samples);
+    // 可从任意线程调用，当前批次结束后停止
+    void requestStop() { m_stop.store(true); }
+
+public slots:
+    void run();
+
+signals:
+    void started(long long parameters, int threads, bool crossEntropy);
+    void progress(int epoch, long long step, double loss, double samplesPerSecond);
+    void epochFinished(int epoch, long long step, double validationLoss, double accuracy);
+    // 每个 Dense 层的权重，布局 [out][in]
+    void weightsUpdated(const QVector<QVector<float>>& weights);
+    void failed(const QString& error);
+    void finished();
+
+private:
+    QVector<QVector<float>> snapshotWeights(const TrainingEngine& engine) const;
+
+    QList<NeuralLayer> m_layers;
+    TrainingConfig m_config;
+    int m_epochs;
+    int m_samples;
+    std::atomic<bool> m_stop{false};
+};
+
+// 训练/验证损失曲线（自动缩放纵轴，点数过多时两两合并）
+class LossChartWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit LossChartWidget(QWidget* parent = nullptr);
+    void addTrainingPoint(double step, double loss);
+    void addValidationPoint(double step, double loss);
+    void clear();
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+
+private:
+    static void append(QVector<QPointF>& series, const QPointF& point);
+
+    QVector<QPointF> m_training;
+    QVector<QPointF> m_validation;
+};
+
+// CodeGeneratorWindow 中“Train Network”打开的窗口：配置优化器、启动/停止训练并实时显示曲线与连线权重
+class TrainingDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit TrainingDialog(const QList<NeuralLayer>& layers, QWidget* parent = nullptr);
+    ~TrainingDialog() override;
+
+protected:
+    void closeEvent(QCloseEvent* event) override;
+
+private slots:
+    void startTraining();
+    void stopTraining();
+    void onStarted(long long parameters, int threads, bool crossEntropy);
+    void onProgress(int epoch, long long step, double loss, double samplesPerSecond);
+    void onEpochFinished(int epoch, long long step, double validationLoss, double accuracy);
+    void onWeightsUpdated(const QVector<QVector<float>>& weights);
+    void onFailed(const QString& error);
+    void onFinished();
+
+private:
+    void buildPreview();
+    void shutdownWorker();
+
+    QList<NeuralLayer> m_layers;
+    QComboBox* m_optimizerBox;
+    QDoubleSpinBox* m_learningRateBox;
+    QSpinBox* m_batchBox;
+    QSpinBox* m_epochBox;
+    QSpinBox* m_sampleBox;
+    QPushButton* m_startButton;
+    QPushButton* m_stopButton;
+    QLabel* m_statusLabel;
+    QLabel* m_epochLabel;
+    LossChartWidget* m_chart;
+    NetworkVisualizer* m_visualizer;
+    bool m_edgesVisible = false;  // 连线太多时不绘制，也不刷新
+    QVector<int> m_columnSizes;   // 预览中每列神经元数（输入列 + 各 Dense 层）
+    QThread* m_thread = nullptr;
+    TrainingWorker* m_worker = nullptr;
+};
+
+#endif // TRAININGDIALOG_H
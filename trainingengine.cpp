@@ -0,0 +1,457 @@
+#include "trainingengine.h"
+#include "gemm.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 每个分片至少处理的样本数，批次太小时不值得切分
+constexpr int kMinShardRows = 16;
+// evaluate 时每个分片一次处理的样本数
+constexpr int kEvalShardRows = 256;
+// 梯度归约与参数更新按此粒度切块
+constexpr int kReduceChunk = 4096;
+
+std::size_t alignUp(std::size_t n) {
+    const std::size_t floatsPerLine = simd::kAlignment / sizeof(float);
+    return (n + floatsPerLine - 1) / floatsPerLine * floatsPerLine;
+}
+
+// 由激活后的输出求导数，避免额外保存激活前的值
+void multiplyActivationGrad(float* delta, const float* out, std::size_t n, Activation act) {
+    switch (act) {
+    case Activation::ReLU:
+        for (std::size_t i = 0; i < n; ++i) delta[i] = out[i] > 0.0f ? delta[i] : 0.0f;
+        break;
+    case Activation::LeakyReLU:
+        for (std::size_t i = 0; i < n; ++i) delta[i] *= out[i] > 0.0f ? 1.0f : 0.01f;
+        break;
+    case Activation::Sigmoid:
+        for (std::size_t i = 0; i < n; ++i) delta[i] *= out[i] * (1.0f - out[i]);
+        break;
+    case Activation::Tanh:
+        for (std::size_t i = 0; i < n; ++i) delta[i] *= 1.0f - out[i] * out[i];
+        break;
+    default:
+        break;
+    }
+}
+
+int argmax(const float* v, int n) {
+    return static_cast<int>(std::max_element(v, v + n) - v);
+}
+
+} // namespace
+
+QString optimizerName(OptimizerType type) {
+    return type == OptimizerType::Adam ? "Adam" : "SGD";
+}
+
+TrainingData makeSyntheticData(int inputs, int outputs, int samples, bool classification, unsigned int seed) {
+    TrainingData data;
+    data.samples = samples;
+    data.inputs = inputs;
+    data.outputs = outputs;
+    data.classification = classification;
+    data.x.resize(static_cast<std::size_t>(samples) * inputs);
+    data.y.assign(static_cast<std::size_t>(samples) * outputs, 0.0f);
+
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    if (classification) {
+        // 类中心间距约为噪声的两倍，类别之间有一定重叠
+        std::vector<float> centers(static_cast<std::size_t>(outputs) * inputs);
+        const float spread = 2.0f / std::sqrt(std::max(1.0f, inputs / 8.0f));
+        for (float& c : centers) c = normal(rng) * spread;
+        for (int s = 0; s < samples; ++s) {
+            const int label = s % outputs;
+            float* x = data.x.data() + static_cast<std::size_t>(s) * inputs;
+            const float* c = centers.data() + static_cast<std::size_t>(label) * inputs;
+            for (int i = 0; i < inputs; ++i) x[i] = c[i] + normal(rng);
+            data.y[static_cast<std::size_t>(s) * outputs + label] = 1.0f;
+        }
+        return data;
+    }
+
+    const int hidden = 16;
+    std::vector<float> a(static_cast<std::size_t>(inputs) * hidden);
+    std::vector<float> b(static_cast<std::size_t>(hidden) * outputs);
+    for (float& v : a) v = normal(rng) / std::sqrt(float(inputs));
+    for (float& v : b) v = normal(rng) / std::sqrt(float(hidden));
+    std::vector<float> h(hidden);
+    for (int s = 0; s < samples; ++s) {
+        float* x = data.x.data() + static_cast<std::size_t>(s) * inputs;
+        for (int i = 0; i < inputs; ++i) x[i] = normal(rng);
+        for (int j = 0; j < hidden; ++j) {
+            float acc = 0.0f;
+            for (int i = 0; i < inputs; ++i) acc += x[i] * a[static_cast<std::size_t>(i) * hidden + j];
+            h[j] = std::tanh(acc);
+        }
+        float* y = data.y.data() + static_cast<std::size_t>(s) * outputs;
+        for (int o = 0; o < outputs; ++o) {
+            float acc = 0.0f;
+            for (int j = 0; j < hidden; ++j) acc += h[j] * b[static_cast<std::size_t>(j) * outputs + o];
+            y[o] = acc;
+        }
+    }
+    return data;
+}
+
+TrainingEngine::TrainingEngine(ThreadPool* pool)
+    : m_pool(pool ? pool : &ThreadPool::global()) {}
+
+bool TrainingEngine::build(const QList<NeuralLayer>& layers, const TrainingConfig& config, QString* error) {
+    m_ready = false;
+    m_layers.clear();
+    m_shards.clear();
+    m_config = config;
+    m_config.batchSize = std::max(1, m_config.batchSize);
+    m_step = 0;
+
+    QList<const NeuralLayer*> ordered;
+    for (const NeuralLayer& layer : layers) ordered.append(&layer);
+    if (ordered.isEmpty()) {
+        if (error) *error = "网络为空";
+        return false;
+    }
+    for (const NeuralLayer* layer : ordered) {
+        if (!layer->isDense() && layer->layerType != "Dropout" && layer->layerType != "Flatten") {
+            if (error) *error = QString("训练引擎只支持全连接网络（含 Dropout），不支持 %1 层").arg(layer->layerType);
+            return false;
+        }
+    }
+    const LayerShape input = defaultInputShape(ordered);
+    QVector<LayerShape> shapes;
+    if (!inferLayerShapes(ordered, input, shapes, error)) return false;
+
+    std::size_t paramCount = 0;
+    int width = input.size();
+    m_inputSize = width;
+    m_maxWidth = width;
+    int lastDense = -1;
+    for (int i = 0; i < layers.size(); ++i) {
+        const NeuralLayer& spec = layers[i];
+        Layer layer;
+        layer.info.layerType = spec.layerType;
+        layer.info.inputs = width;
+        layer.info.outputs = shapes[i].size();
+        if (spec.isDense()) {
+            layer.info.dense = true;
+            layer.info.activation = activationFromName(spec.activationFunction);
+            layer.weightCount = static_cast<std::size_t>(layer.info.inputs) * layer.info.outputs;
+            layer.initBound = 1.0f / std::sqrt(float(layer.info.inputs));
+            lastDense = i;
+        } else if (spec.layerType == "Dropout") {
+            layer.info.dropoutRate = std::min(0.95f, std::max(0.0f, spec.dropoutRate));
+        }
+        layer.weightOffset = paramCount;
+        paramCount += alignUp(layer.weightCount);
+        layer.biasOffset = paramCount;
+        if (layer.info.dense) paramCount += alignUp(static_cast<std::size_t>(layer.info.outputs));
+        width = layer.info.outputs;
+        m_maxWidth = std::max(m_maxWidth, width);
+        m_layers.push_back(layer);
+    }
+    if (lastDense < 0) {
+        if (error) *error = "网络中没有可训练的全连接层";
+        return false;
+    }
+    for (int i = 0; i < layerCount(); ++i) {
+        if (m_layers[i].info.activation == Activation::Softmax && i != layerCount() - 1) {
+            if (error) *error = "Softmax 只能作为最后一层（与交叉熵损失配合）";
+            return false;
+        }
+    }
+    m_outputSize = width;
+    m_crossEntropy = m_layers.back().info.activation == Activation::Softmax;
+
+    m_params.resize(paramCount);
+    m_moment1.resize(paramCount);
+    m_moment2.resize(paramCount);
+    initializeWeights();
+    m_ready = true;
+    return true;
+}
+
+long long TrainingEngine::parameterCount() const {
+    long long count = 0;
+    for (const Layer& layer : m_layers) {
+        if (layer.info.dense) count += static_cast<long long>(layer.weightCount) + layer.info.outputs;
+    }
+    return count;
+}
+
+void TrainingEngine::initializeWeights(unsigned int seed) {
+    std::mt19937 rng(seed);
+    for (Layer& layer : m_layers) {
+        if (!layer.info.dense) continue;
+        std::uniform_real_distribution<float> dist(-layer.initBound, layer.initBound);
+        float* w = weightData(static_cast<int>(&layer - m_layers.data()));
+        for (std::size_t i = 0; i < layer.weightCount; ++i) w[i] = dist(rng);
+        float* b = m_params.data() + layer.biasOffset;
+        for (int i = 0; i < layer.info.outputs; ++i) b[i] = dist(rng);
+    }
+    std::fill(m_moment1.data(), m_moment1.data() + m_moment1.size(), 0.0f);
+    std::fill(m_moment2.data(), m_moment2.data() + m_moment2.size(), 0.0f);
+    m_step = 0;
+}
+
+int TrainingEngine::shardCountFor(int batch) const {
+    return std::max(1, std::min(m_pool->threadCount(), batch / kMinShardRows));
+}
+
+void TrainingEngine::ensureShards(int count, int rows) {
+    if (static_cast<int>(m_shards.size()) < count) m_shards.resize(count);
+    for (int s = 0; s < count; ++s) {
+        Shard& shard = m_shards[s];
+        if (shard.grads.size() != m_params.size()) {
+            shard.grads.resize(m_params.size());
+            shard.rng.seed(1234u + 7919u * s);
+        }
+        if (shard.capacity >= rows) continue;
+        shard.outputs.clear();
+        shard.masks.clear();
+        shard.outputs.resize(m_layers.size());
+        shard.masks.resize(m_layers.size());
+        shard.outputPtr.assign(m_layers.size(), nullptr);
+        for (std::size_t l = 0; l < m_layers.size(); ++l) {
+            const LayerInfo& info = m_layers[l].info;
+            const std::size_t n = static_cast<std::size_t>(rows) * info.outputs;
+            if (info.dense) {
+                shard.outputs[l].resize(n);
+            } else if (info.dropoutRate > 0.0f) {
+                shard.outputs[l].resize(n);
+                shard.masks[l].resize(n);
+            }
+        }
+        const std::size_t work = static_cast<std::size_t>(rows) * m_maxWidth;
+        shard.delta.resize(work);
+        shard.deltaPrev.resize(work);
+        shard.transposed.resize(work);
+        shard.capacity = rows;
+    }
+}
+
+const float* TrainingEngine::forwardShard(Shard& shard, const float* x, int rows, bool training) {
+    const float* in = x;
+    for (std::size_t l = 0; l < m_layers.size(); ++l) {
+        const Layer& layer = m_layers[l];
+        const LayerInfo& info = layer.info;
+        if (info.dense) {
+            float* out = shard.outputs[l].data();
+            sgemm(rows, info.outputs, info.inputs, in, info.inputs,
+                  m_params.data() + layer.weightOffset, info.inputs, true,
+                  out, info.outputs, false, m_pool);
+            biasActivation(out, rows, info.outputs, m_params.data() + layer.biasOffset, info.activation, m_pool);
+            in = out;
+        } else if (training && info.dropoutRate > 0.0f) {
+            // 反向 Dropout：训练时按 1/(1-p) 放大保留的激活，推理时为恒等
+            float* out = shard.outputs[l].data();
+            float* mask = shard.masks[l].data();
+            const std::size_t n = static_cast<std::size_t>(rows) * info.outputs;
+            const double threshold = double(info.dropoutRate) * 4294967296.0;
+            const float keepScale = 1.0f / (1.0f - info.dropoutRate);
+            for (std::size_t i = 0; i < n; ++i) {
+                mask[i] = double(shard.rng()) >= threshold ? keepScale : 0.0f;
+                out[i] = in[i] * mask[i];
+            }
+            in = out;
+        }
+        shard.outputPtr[l] = in;
+    }
+    return in;
+}
+
+void TrainingEngine::lossShard(Shard& shard, const float* output, const float* y, int rows, float scale, bool withDelta) {
+    const int n = m_outputSize;
+    double loss = 0.0;
+    int correct = 0;
+    float* delta = shard.delta.data();
+    for (int r = 0; r < rows; ++r) {
+        const float* a = output + static_cast<std::size_t>(r) * n;
+        const float* t = y + static_cast<std::size_t>(r) * n;
+        float* d = delta + static_cast<std::size_t>(r) * n;
+        if (m_crossEntropy) {
+            for (int i = 0; i < n; ++i) {
+                if (t[i] != 0.0f) loss -= t[i] * std::log(std::max(a[i], 1e-12f));
+            }
+            // softmax 与交叉熵合并求导：dL/dz = (a - y) / B
+            if (withDelta) {
+                for (int i = 0; i < n; ++i) d[i] = (a[i] - t[i]) * scale;
+            }
+            if (argmax(a, n) == argmax(t, n)) ++correct;
+        } else {
+            double sum = 0.0;
+            const float gradScale = 2.0f * scale / n;
+            for (int i = 0; i < n; ++i) {
+                const float diff = a[i] - t[i];
+                sum += double(diff) * diff;
+                if (withDelta) d[i] = diff * gradScale;
+            }
+            loss += sum / n;
+        }
+    }
+    shard.loss = loss;
+    shard.correct = correct;
+}
+
+void TrainingEngine::backwardShard(Shard& shard, const float* x, int rows) {
+    int firstDense = 0;
+    while (!m_layers[firstDense].info.dense) ++firstDense;
+
+    // delta 为损失对当前层输出的梯度（末层交叉熵时已是对 softmax 输入的梯度）
+    for (int l = layerCount() - 1; l >= firstDense; --l) {
+        const Layer& layer = m_layers[l];
+        const LayerInfo& info = layer.info;
+        float* delta = shard.delta.data();
+        const std::size_t n = static_cast<std::size_t>(rows) * info.outputs;
+        if (!info.dense) {
+            if (info.dropoutRate > 0.0f) {
+                const float* mask = shard.masks[l].data();
+                for (std::size_t i = 0; i < n; ++i) delta[i] *= mask[i];
+            }
+            continue;
+        }
+
+        if (!(m_crossEntropy && l == layerCount() - 1)) {
+            multiplyActivationGrad(delta, shard.outputPtr[l], n, info.activation);
+        }
+        const float* in = l > 0 ? shard.outputPtr[l - 1] : x;
+        float* gw = shard.grads.data() + layer.weightOffset;
+        float* gb = shard.grads.data() + layer.biasOffset;
+
+        // sgemm 不支持转置 A，先把 delta 转成 [out][rows] 再计算 gW = deltaᵀ · in
+        float* deltaT = shard.transposed.data();
+        for (int r = 0; r < rows; ++r) {
+            const float* row = delta + static_cast<std::size_t>(r) * info.outputs;
+            for (int o = 0; o < info.outputs; ++o) deltaT[static_cast<std::size_t>(o) * rows + r] = row[o];
+        }
+        sgemm(info.outputs, info.inputs, rows, deltaT, rows, in, info.inputs, false,
+              gw, info.inputs, false, m_pool);
+        for (int o = 0; o < info.outputs; ++o) {
+            const float* col = deltaT + static_cast<std::size_t>(o) * rows;
+            float sum = 0.0f;
+            for (int r = 0; r < rows; ++r) sum += col[r];
+            gb[o] = sum;
+        }
+
+        if (l == firstDense) break;
+        // dIn = delta · W
+        sgemm(rows, info.inputs, info.outputs, delta, info.outputs,
+              m_params.data() + layer.weightOffset, info.inputs, false,
+              shard.deltaPrev.data(), info.inputs, false, m_pool);
+        std::swap(shard.delta, shard.deltaPrev);
+    }
+}
+
+double TrainingEngine::runShards(const float* x, const float* y, int batch, int shards) {
+    const int rowsPerShard = (batch + shards - 1) / shards;
+    ensureShards(shards, rowsPerShard);
+    const float scale = 1.0f / batch;
+    m_pool->parallelFor(0, shards, 1, [&](int first, int last) {
+        for (int s = first; s < last; ++s) {
+            Shard& shard = m_shards[s];
+            const int r0 = s * rowsPerShard;
+            shard.rows = std::max(0, std::min(rowsPerShard, batch - r0));
+            shard.loss = 0.0;
+            if (shard.rows == 0) continue;
+            const float* xs = x + static_cast<std::size_t>(r0) * m_inputSize;
+            const float* ys = y + static_cast<std::size_t>(r0) * m_outputSize;
+            const float* out = forwardShard(shard, xs, shard.rows, true);
+            lossShard(shard, out, ys, shard.rows, scale, true);
+            backwardShard(shard, xs, shard.rows);
+        }
+    });
+    double loss = 0.0;
+    for (int s = 0; s < shards; ++s) loss += m_shards[s].loss;
+    return loss / batch;
+}
+
+void TrainingEngine::reduceGradients(int shards, bool update) {
+    const int total = static_cast<int>(m_params.size());
+    const int chunks = (total + kReduceChunk - 1) / kReduceChunk;
+    const TrainingConfig& cfg = m_config;
+    const long long t = m_step + 1;
+    const float biasCorrection1 = 1.0f - static_cast<float>(std::pow(double(cfg.beta1), double(t)));
+    const float biasCorrection2 = 1.0f - static_cast<float>(std::pow(double(cfg.beta2), double(t)));
+
+    m_pool->parallelFor(0, chunks, 1, [&](int first, int last) {
+        const int begin = first * kReduceChunk;
+        const int end = std::min(total, last * kReduceChunk);
+        float* g = m_shards[0].grads.data();
+        for (int s = 1; s < shards; ++s) {
+            if (m_shards[s].rows == 0) continue;
+            const float* gs = m_shards[s].grads.data();
+            for (int i = begin; i < end; ++i) g[i] += gs[i];
+        }
+        if (!update) return;
+
+        float* p = m_params.data();
+        float* m = m_moment1.data();
+        float* v = m_moment2.data();
+        if (cfg.optimizer == OptimizerType::SGD) {
+            for (int i = begin; i < end; ++i) {
+                const float grad = g[i] + cfg.weightDecay * p[i];
+                m[i] = cfg.momentum * m[i] + grad;
+                p[i] -= cfg.learningRate * m[i];
+            }
+        } else {
+            const float lr1 = cfg.learningRate / biasCorrection1;
+            const float inv2 = 1.0f / biasCorrection2;
+            for (int i = begin; i < end; ++i) {
+                const float grad = g[i] + cfg.weightDecay * p[i];
+                m[i] = cfg.beta1 * m[i] + (1.0f - cfg.beta1) * grad;
+                v[i] = cfg.beta2 * v[i] + (1.0f - cfg.beta2) * grad * grad;
+                p[i] -= lr1 * m[i] / (std::sqrt(v[i] * inv2) + cfg.epsilon);
+            }
+        }
+    });
+    if (update) ++m_step;
+}
+
+double TrainingEngine::trainStep(const float* x, const float* y, int batch) {
+    if (!m_ready || batch <= 0) return 0.0;
+    const int shards = shardCountFor(batch);
+    const double loss = runShards(x, y, batch, shards);
+    reduceGradients(shards, true);
+    return loss;
+}
+
+double TrainingEngine::computeGradients(const float* x, const float* y, int batch, std::vector<float>& grads) {
+    if (!m_ready || batch <= 0) return 0.0;
+    const int shards = shardCountFor(batch);
+    const double loss = runShards(x, y, batch, shards);
+    reduceGradients(shards, false);
+    const float* g = m_shards[0].grads.data();
+    grads.assign(g, g + m_params.size());
+    return loss;
+}
+
+double TrainingEngine::evaluate(const float* x, const float* y, int count, double* accuracy) {
+    if (!m_ready || count <= 0) return 0.0;
+    const int shards = std::max(1, std::min(m_pool->threadCount(), (count + kEvalShardRows - 1) / kEvalShardRows));
+    ensureShards(shards, kEvalShardRows);
+    double loss = 0.0;
+    long long correct = 0;
+    for (int base = 0; base < count; base += shards * kEvalShardRows) {
+        m_pool->parallelFor(0, shards, 1, [&](int first, int last) {
+            for (int s = first; s < last; ++s) {
+                Shard& shard = m_shards[s];
+                const int r0 = base + s * kEvalShardRows;
+                shard.rows = std::max(0, std::min(kEvalShardRows, count - r0));
+                shard.loss = 0.0;
+                shard.correct = 0;
+                if (shard.rows == 0) continue;
+                const float* out = forwardShard(shard, x + static_cast<std::size_t>(r0) * m_inputSize, shard.rows, false);
+                lossShard(shard, out, y + static_cast<std::size_t>(r0) * m_outputSize, shard.rows, 1.0f, false);
+            }
+        });
+        for (int s = 0; s < shards; ++s) {
+            loss += m_shards[s].loss;
+            correct += m_shards[s].correct;
+        }
+    }
+    if (accuracy) *accuracy = m_crossEntropy ? double(correct) / count : 0.0;
+    return loss / count;
+}
@@ -0,0 +1,143 @@
+#ifndef TRAININGENGINE_H
+#define TRAININGENGINE_H
+
+#include <QList>
+#include <QString>
+#include <random>
+#include <vector>
+#include "backend.h"
+#include "activations.h"
+#include "simdutils.h"
+
+class ThreadPool;
+
+enum class OptimizerType { SGD, Adam };
+
+QString optimizerName(OptimizerType type);
+
+struct TrainingConfig
+{
+    OptimizerType optimizer = OptimizerType::Adam;
+    float learningRate = 1e-3f;
+    float momentum = 0.9f;      // SGD
+    float beta1 = 0.9f;         // Adam
+    float beta2 = 0.999f;
+    float epsilon = 1e-8f;
+    float weightDecay = 0.0f;   // L2，作用于全部参数
+    int batchSize = 64;
+};
+
+// 训练用的样本集合：x 为 samples×inputs，y 为 samples×outputs（分类任务为 one-hot）
+struct TrainingData
+{
+    int samples = 0;
+    int inputs = 0;
+    int outputs = 0;
+    bool classification = false;
+    std::vector<float> x;
+    std::vector<float> y;
+};
+
+// 合成数据集：分类为每类一个高斯团，回归为随机单隐层教师网络 y = tanh(x·A)·B
+TrainingData makeSyntheticData(int inputs, int outputs, int samples, bool classification, unsigned int seed = 1);
+
+// 全连接网络（Dense + Dropout/Flatten）的 CPU 训练引擎
+// 小批量按行切成若干分片并行做前向/反向，每个分片写自己的梯度缓冲区，
+// 随后按参数区间并行地把各分片梯度归约（all-reduce）到分片 0 并立即执行优化器更新
+class TrainingEngine
+{
+public:
+    struct LayerInfo {
+        QString layerType;
+        int inputs = 0;
+        int outputs = 0;
+        Activation activation = Activation::None;
+        bool dense = false;        // 否则为 Dropout / Flatten
+        float dropoutRate = 0.0f;
+    };
+
+    explicit TrainingEngine(ThreadPool* pool = nullptr);
+
+    // 末层为 Softmax 时使用交叉熵损失，否则使用均方误差
+    bool build(const QList<NeuralLayer>& layers, const TrainingConfig& config, QString* error = nullptr);
+
+    bool isReady() const { return m_ready; }
+    int inputSize() const { return m_inputSize; }
+    int outputSize() const { return m_outputSize; }
+    bool usesCrossEntropy() const { return m_crossEntropy; }
+    int layerCount() const { return static_cast<int>(m_layers.size()); }
+    const LayerInfo& layerInfo(int index) const { return m_layers[index].info; }
+    const TrainingConfig& config() const { return m_config; }
+    void setLearningRate(float lr) { m_config.learningRate = lr; }
+    long long step() const { return m_step; }
+
+    // 参数布局与 InferenceEngine 一致：Dense 权重 [out][in]
+    float* weightData(int layer) { return m_params.data() + m_layers[layer].weightOffset; }
+    const float* weightData(int layer) const { return m_params.data() + m_layers[layer].weightOffset; }
+    float* biasData(int layer) { return m_params.data() + m_layers[layer].biasOffset; }
+    const float* biasData(int layer) const { return m_params.data() + m_layers[layer].biasOffset; }
+    long long parameterCount() const;
+
+    // 与 InferenceEngine 相同的 U(-1/sqrt(fan_in), 1/sqrt(fan_in)) 初始化，同时清空优化器状态
+    void initializeWeights(unsigned int seed = 42);
+
+    // 对 batch 个样本做一次前向、反向与参数更新，返回该批次的平均损失
+    double trainStep(const float* x, const float* y, int batch);
+
+    // 只计算梯度（不更新参数），结果写入 grads（与参数同布局），返回平均损失；用于梯度检验
+    double computeGradients(const float* x, const float* y, int batch, std::vector<float>& grads);
+
+    // 推理模式（Dropout 关闭）下的平均损失；分类任务同时给出准确率
+    double evaluate(const float* x, const float* y, int count, double* accuracy = nullptr);
+
+private:
+    struct Layer {
+        LayerInfo info;
+        std::size_t weightOffset = 0;
+        std::size_t biasOffset = 0;
+        std::size_t weightCount = 0;
+        float initBound = 0.0f;
+    };
+
+    // 每个分片独占的激活、梯度与工作区
+    struct Shard {
+        std::vector<simd::AlignedBuffer> outputs;  // 各层输出 rows×outputs
+        std::vector<simd::AlignedBuffer> masks;    // Dropout 掩码（已乘 1/(1-p)）
+        std::vector<const float*> outputPtr;       // 最近一次前向各层输出位置（恒等层与上一层共享）
+        simd::AlignedBuffer grads;
+        simd::AlignedBuffer delta;
+        simd::AlignedBuffer deltaPrev;
+        simd::AlignedBuffer transposed;
+        std::mt19937 rng;
+        int capacity = 0;
+        int rows = 0;
+        double loss = 0.0;
+        int correct = 0;
+    };
+
+    int shardCountFor(int batch) const;
+    void ensureShards(int count, int rows);
+    const float* forwardShard(Shard& shard, const float* x, int rows, bool training);
+    void lossShard(Shard& shard, const float* output, const float* y, int rows, float scale, bool withDelta);
+    void backwardShard(Shard& shard, const float* x, int rows);
+    // 对 [0, shards) 分片做前向与反向；返回平均损失
+    double runShards(const float* x, const float* y, int batch, int shards);
+    // 把分片梯度归约到分片 0；update 为 true 时在同一遍里执行优化器更新
+    void reduceGradients(int shards, bool update);
+
+    ThreadPool* m_pool;
+    TrainingConfig m_config;
+    bool m_ready = false;
+    bool m_crossEntropy = false;
+    int m_inputSize = 0;
+    int m_outputSize = 0;
+    int m_maxWidth = 0;
+    long long m_step = 0;
+    std::vector<Layer> m_layers;
+    simd::AlignedBuffer m_params;
+    simd::AlignedBuffer m_moment1;  // SGD 动量 / Adam 一阶矩
+    simd::AlignedBuffer m_moment2;  // Adam 二阶矩
+    std::vector<Shard> m_shards;
+};
+
+#endif // TRAININGENGINE_H
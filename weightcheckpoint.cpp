@@ -0,0 +1,767 @@
+#include "weightcheckpoint.h"
+#include "inferenceengine.h"
+#include "simdutils.h"
+#include "threadpool.h"
+#include <QByteArray>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace {
+
+// read() 时每块转换的元素数
+constexpr qint64 kConvertChunk = 1 << 16;
+// safetensors 头部上限（规范要求小于 100MB）
+constexpr quint64 kMaxSafeTensorsHeader = 100u * 1024u * 1024u;
+// 单个维度与元素总数的上限：远大于任何真实权重，又保证 元素数 × 8 字节 不会溢出 qint64
+constexpr qint64 kMaxDimension = qint64(1) << 40;
+constexpr qint64 kMaxElements = qint64(1) << 56;
+
+quint16 readU16(const uchar* p) { return quint16(p[0] | (p[1] << 8)); }
+quint32 readU32(const uchar* p) { return quint32(p[0]) | (quint32(p[1]) << 8) | (quint32(p[2]) << 16) | (quint32(p[3]) << 24); }
+quint64 readU64(const uchar* p) { return quint64(readU32(p)) | (quint64(readU32(p + 4)) << 32); }
+
+// [offset, offset + length) 落在 size 字节之内；写成减法，文件里的任意 64 位值都不会回绕
+bool fits(quint64 offset, quint64 length, quint64 size) {
+    return offset <= size && length <= size - offset;
+}
+
+int dtypeBytes(TensorDType dtype) {
+    switch (dtype) {
+    case TensorDType::F32: return 4;
+    case TensorDType::F16:
+    case TensorDType::BF16: return 2;
+    case TensorDType::F64: return 8;
+    default: return 0;
+    }
+}
+
+float halfToFloat(quint16 h) {
+    const quint32 sign = quint32(h & 0x8000u) << 16;
+    quint32 exponent = (h >> 10) & 0x1fu;
+    quint32 mantissa = h & 0x3ffu;
+    quint32 bits;
+    if (exponent == 0) {
+        if (mantissa == 0) {
+            bits = sign;
+        } else {
+            // 非规格化数：左移到隐含位出现为止
+            exponent = 127 - 15 + 1;
+            while (!(mantissa & 0x400u)) {
+                mantissa <<= 1;
+                --exponent;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3ffu) << 13);
+        }
+    } else if (exponent == 31) {
+        bits = sign | 0x7f800000u | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    float f;
+    std::memcpy(&f, &bits, sizeof f);
+    return f;
+}
+
+#if NNV_HAVE_AVX2
+// 小端 fp16 按 8 个一组用 F16C 转换，返回已转换的元素数
+NNV_AVX2 qint64 halfRangeF16c(const uchar* src, float* dst, qint64 count) {
+    qint64 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+    }
+    return i;
+}
+#endif
+
+// 把 count 个元素从原始字节转换为 float（src 不保证对齐）
+void convertRange(const uchar* src, float* dst, qint64 count, TensorDType dtype, bool bigEndian) {
+    const int bytes = dtypeBytes(dtype);
+    if (bigEndian) {
+        uchar element[8];
+        for (qint64 i = 0; i < count; ++i) {
+            for (int b = 0; b < bytes; ++b) element[b] = src[i * bytes + bytes - 1 - b];
+            convertRange(element, dst + i, 1, dtype, false);
+        }
+        return;
+    }
+    switch (dtype) {
+    case TensorDType::F32:
+        std::memcpy(dst, src, static_cast<std::size_t>(count) * 4);
+        break;
+    case TensorDType::F64:
+        for (qint64 i = 0; i < count; ++i) {
+            double d;
+            std::memcpy(&d, src + i * 8, 8);
+            dst[i] = static_cast<float>(d);
+        }
+        break;
+    case TensorDType::BF16:
+        for (qint64 i = 0; i < count; ++i) {
+            const quint32 bits = quint32(readU16(src + i * 2)) << 16;
+            std::memcpy(dst + i, &bits, 4);
+        }
+        break;
+    case TensorDType::F16: {
+        qint64 i = 0;
+#if NNV_HAVE_AVX2
+        if (simd::hasAvx2()) i = halfRangeF16c(src, dst, count);
+#endif
+        for (; i < count; ++i) dst[i] = halfToFloat(readU16(src + i * 2));
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+// Fortran 顺序（列主序）转为 C 顺序
+void fortranToC(const float* src, float* dst, const QVector<qint64>& shape) {
+    const int rank = shape.size();
+    qint64 total = 1;
+    for (qint64 d : shape) total *= d;
+    QVector<qint64> strides(rank);
+    qint64 stride = 1;
+    for (int d = 0; d < rank; ++d) {
+        strides[d] = stride;
+        stride *= shape[d];
+    }
+    QVector<qint64> index(rank, 0);
+    for (qint64 i = 0; i < total; ++i) {
+        qint64 offset = 0;
+        for (int d = 0; d < rank; ++d) offset += index[d] * strides[d];
+        dst[i] = src[offset];
+        for (int d = rank - 1; d >= 0; --d) {
+            if (++index[d] < shape[d]) break;
+            index[d] = 0;
+        }
+    }
+}
+
+TensorDType npyDType(const std::string& descr, bool* bigEndian) {
+    if (descr.size() < 3) return TensorDType::Unsupported;
+    *bigEndian = descr[0] == '>';
+    const std::string kind = descr.substr(1);
+    if (kind == "f4") return TensorDType::F32;
+    if (kind == "f2") return TensorDType::F16;
+    if (kind == "f8") return TensorDType::F64;
+    return TensorDType::Unsupported;
+}
+
+TensorDType safeTensorsDType(const QString& name) {
+    if (name == "F32") return TensorDType::F32;
+    if (name == "F16") return TensorDType::F16;
+    if (name == "BF16") return TensorDType::BF16;
+    if (name == "F64") return TensorDType::F64;
+    return TensorDType::Unsupported;
+}
+
+// 在 npy 头部的 Python 字典字面量里取 key 对应的值文本
+std::string npyField(const std::string& header, const char* key) {
+    const std::string quoted = std::string("'") + key + "'";
+    std::size_t pos = header.find(quoted);
+    if (pos == std::string::npos) return std::string();
+    pos = header.find(':', pos + quoted.size());
+    if (pos == std::string::npos) return std::string();
+    ++pos;
+    while (pos < header.size() && header[pos] == ' ') ++pos;
+    if (pos >= header.size()) return std::string();
+    if (header[pos] == '\'') {
+        const std::size_t end = header.find('\'', pos + 1);
+        return end == std::string::npos ? std::string() : header.substr(pos + 1, end - pos - 1);
+    }
+    if (header[pos] == '(') {
+        const std::size_t end = header.find(')', pos);
+        return end == std::string::npos ? std::string() : header.substr(pos + 1, end - pos - 1);
+    }
+    const std::size_t end = header.find_first_of(",}", pos);
+    return header.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+}
+
+bool parseShape(const std::string& text, QVector<qint64>& shape) {
+    shape.clear();
+    qint64 value = 0;
+    bool digits = false;
+    for (char c : text) {
+        if (c >= '0' && c <= '9') {
+            value = value * 10 + (c - '0');
+            if (value > kMaxDimension) return false;
+            digits = true;
+        } else if (c == ',') {
+            if (!digits) return false;
+            shape.append(value);
+            value = 0;
+            digits = false;
+        } else if (c != ' ' && c != 'L') {
+            return false;
+        }
+    }
+    if (digits) shape.append(value);
+    return true;
+}
+
+// 代码生成器给第 index 个模块起的名字（与 codegenerator.cpp 中 self.fc%1 等一致）
+QString moduleName(const NeuralLayer& layer, int index) {
+    QString prefix;
+    if (layer.isDense()) prefix = "fc";
+    else if (layer.isConvolutional()) prefix = "conv";
+    else if (layer.layerType == "LSTM") prefix = "lstm";
+    else if (layer.layerType == "GRU") prefix = "gru";
+    else if (layer.layerType == "RNN") prefix = "rnn";
+    return prefix.isEmpty() ? QString() : prefix + QString::number(index + 1);
+}
+
+std::atomic<quint64> g_generation{0};
+
+std::shared_ptr<WeightCheckpoint>& activeCheckpoint() {
+    static std::shared_ptr<WeightCheckpoint> checkpoint;
+    return checkpoint;
+}
+
+} // namespace
+
+qint64 CheckpointTensor::elementCount() const {
+    qint64 count = 1;
+    for (qint64 d : shape) {
+        if (d < 0 || (d > 0 && count > kMaxElements / d)) return -1;
+        count *= d;
+    }
+    return count;
+}
+
+QString CheckpointTensor::shapeString() const {
+    QStringList dims;
+    for (qint64 d : shape) dims << QString::number(d);
+    return "[" + dims.join(", ") + "]";
+}
+
+WeightCheckpoint::~WeightCheckpoint() {
+    close();
+}
+
+void WeightCheckpoint::close() {
+    if (m_data) m_file.unmap(const_cast<uchar*>(m_data));
+    m_data = nullptr;
+    m_size = 0;
+    m_file.close();
+    m_tensors.clear();
+    m_index.clear();
+}
+
+bool WeightCheckpoint::open(const QString& path, QString* error) {
+    close();
+    m_path = path;
+    m_generation = ++g_generation;
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        if (error) *error = "无法打开文件：" + m_file.errorString();
+        return false;
+    }
+    m_size = m_file.size();
+    if (m_size < 8) {
+        if (error) *error = "文件太小，不是有效的检查点";
+        close();
+        return false;
+    }
+    // 整个文件只建立映射，不读取；之后只访问头部所在的页
+    m_data = m_file.map(0, m_size);
+    if (!m_data) {
+        if (error) *error = "内存映射失败：" + m_file.errorString();
+        close();
+        return false;
+    }
+
+    bool ok;
+    if (std::memcmp(m_data, "\x93NUMPY", 6) == 0) {
+        m_format = Format::Npy;
+        ok = parseNpy(0, m_size, QFileInfo(path).completeBaseName(), error);
+    } else if (readU32(m_data) == 0x04034b50u) {
+        m_format = Format::Npz;
+        ok = parseNpz(error);
+    } else {
+        m_format = Format::SafeTensors;
+        ok = parseSafeTensors(error);
+    }
+    if (!ok) close();
+    return ok;
+}
+
+void WeightCheckpoint::addTensor(const CheckpointTensor& tensor) {
+    m_index.insert(tensor.name, m_tensors.size());
+    m_tensors.append(tensor);
+}
+
+bool WeightCheckpoint::parseNpy(qint64 base, qint64 size, const QString& name, QString* error) {
+    // 魔数 6 字节 + 版本 2 字节 + 头长度（v1 为 2 字节，v2/v3 为 4 字节）
+    if (size < 10 || std::memcmp(m_data + base, "\x93NUMPY", 6) != 0) {
+        if (error) *error = name + "：不是 npy 数据";
+        return false;
+    }
+    const int major = m_data[base + 6];
+    const qint64 lengthBytes = major >= 2 ? 4 : 2;
+    if (size < 8 + lengthBytes) {
+        if (error) *error = name + "：npy 头部不完整";
+        return false;
+    }
+    const qint64 headerLength = major >= 2 ? readU32(m_data + base + 8) : readU16(m_data + base + 8);
+    const qint64 dataStart = 8 + lengthBytes + headerLength;
+    if (dataStart > size) {
+        if (error) *error = name + "：npy 头部越界";
+        return false;
+    }
+    const std::string header(reinterpret_cast<const char*>(m_data + base + 8 + lengthBytes), std::size_t(headerLength));
+
+    CheckpointTensor tensor;
+    tensor.name = name;
+    const std::string descr = npyField(header, "descr");
+    tensor.dtypeName = QString::fromLatin1(descr.c_str());
+    tensor.dtype = npyDType(descr, &tensor.bigEndian);
+    tensor.fortranOrder = npyField(header, "fortran_order") == "True";
+    if (!parseShape(npyField(header, "shape"), tensor.shape)) {
+        if (error) *error = name + "：无法解析 shape";
+        return false;
+    }
+    tensor.offset = base + dataStart;
+    tensor.byteSize = size - dataStart;
+    if (tensor.elementCount() < 0) {
+        if (error) *error = name + "：shape 过大";
+        return false;
+    }
+    if (tensor.dtype != TensorDType::Unsupported && tensor.byteSize < tensor.elementCount() * dtypeBytes(tensor.dtype)) {
+        if (error) *error = name + "：数据长度与 shape 不符";
+        return false;
+    }
+    addTensor(tensor);
+    return true;
+}
+
+bool WeightCheckpoint::parseNpz(QString* error) {
+    // 从文件尾部向前找中央目录结束记录（EOCD），注释最长 64KB
+    qint64 eocd = -1;
+    for (qint64 pos = m_size - 22; pos >= 0 && pos >= m_size - 22 - 65535; --pos) {
+        if (readU32(m_data + pos) == 0x06054b50u) {
+            eocd = pos;
+            break;
+        }
+    }
+    if (eocd < 0) {
+        if (error) *error = "npz：找不到 zip 中央目录";
+        return false;
+    }
+    quint64 entries = readU16(m_data + eocd + 10);
+    quint64 directoryOffset = readU32(m_data + eocd + 16);
+    // 超过 4GB 或 65535 个成员时使用 zip64 记录
+    if ((entries == 0xffffu || directoryOffset == 0xffffffffu) && eocd >= 20 && readU32(m_data + eocd - 20) == 0x07064b50u) {
+        const quint64 record = readU64(m_data + eocd - 20 + 8);
+        if (!fits(record, 56, quint64(m_size)) || readU32(m_data + record) != 0x06064b50u) {
+            if (error) *error = "npz：zip64 记录损坏";
+            return false;
+        }
+        entries = readU64(m_data + record + 32);
+        directoryOffset = readU64(m_data + record + 48);
+    }
+
+    quint64 pos = directoryOffset;
+    for (quint64 e = 0; e < entries; ++e) {
+        if (!fits(pos, 46, quint64(m_size)) || readU32(m_data + pos) != 0x02014b50u) {
+            if (error) *error = "npz：中央目录损坏";
+            return false;
+        }
+        const uchar* entry = m_data + pos;
+        const int method = readU16(entry + 10);
+        quint64 compressedSize = readU32(entry + 20);
+        quint64 uncompressedSize = readU32(entry + 24);
+        const int nameLength = readU16(entry + 28);
+        const int extraLength = readU16(entry + 30);
+        const int commentLength = readU16(entry + 32);
+        quint64 localOffset = readU32(entry + 42);
+        if (!fits(pos + 46, quint64(nameLength) + extraLength, quint64(m_size))) {
+            if (error) *error = "npz：中央目录越界";
+            return false;
+        }
+        QString name = QString::fromUtf8(reinterpret_cast<const char*>(entry + 46), nameLength);
+
+        // zip64 扩展字段按 未压缩大小 / 压缩大小 / 本地头偏移 的顺序只记录溢出的值
+        const uchar* extra = entry + 46 + nameLength;
+        for (int x = 0; x + 4 <= extraLength;) {
+            const int id = readU16(extra + x);
+            const int length = readU16(extra + x + 2);
+            if (x + 4 + length > extraLength) {
+                if (error) *error = "npz：中央目录扩展字段越界";
+                return false;
+            }
+            if (id == 0x0001) {
+                int field = 0;
+                auto take = [&](quint64& value) {
+                    if (value != 0xffffffffu) return true;
+                    if (field + 8 > length) return false;
+                    value = readU64(extra + x + 4 + field);
+                    field += 8;
+                    return true;
+                };
+                if (!take(uncompressedSize) || !take(compressedSize) || !take(localOffset)) {
+                    if (error) *error = "npz：zip64 扩展字段不完整";
+                    return false;
+                }
+            }
+            x += 4 + length;
+        }
+        pos += 46 + nameLength + extraLength + commentLength;
+
+        if (name.endsWith(".npy")) name.chop(4);
+        if (method != 0) {
+            if (error) *error = QString("npz 成员 %1 是压缩存储的（np.savez_compressed），无法内存映射，请改用 np.savez 保存").arg(name);
+            return false;
+        }
+        if (!fits(localOffset, 30, quint64(m_size)) || readU32(m_data + localOffset) != 0x04034b50u) {
+            if (error) *error = "npz：本地文件头损坏";
+            return false;
+        }
+        const quint64 dataOffset = localOffset + 30 + readU16(m_data + localOffset + 26) + readU16(m_data + localOffset + 28);
+        if (!fits(dataOffset, compressedSize, quint64(m_size))) {
+            if (error) *error = QString("npz 成员 %1 越界").arg(name);
+            return false;
+        }
+        if (!parseNpy(qint64(dataOffset), qint64(compressedSize), name, error)) return false;
+    }
+    return true;
+}
+
+bool WeightCheckpoint::parseSafeTensors(QString* error) {
+    const quint64 headerSize = readU64(m_data);
+    if (headerSize > kMaxSafeTensorsHeader || headerSize + 8 > quint64(m_size)) {
+        if (error) *error = "无法识别的文件格式（支持 .npy / .npz / .safetensors）";
+        return false;
+    }
+    // 只解析头部 JSON，数据区从 8 + headerSize 开始
+    const QByteArray json(reinterpret_cast<const char*>(m_data + 8), int(headerSize));
+    const QJsonDocument doc = QJsonDocument::fromJson(json);
+    if (!doc.isObject()) {
+        if (error) *error = "safetensors 头部不是合法的 JSON";
+        return false;
+    }
+    const qint64 dataStart = qint64(8 + headerSize);
+    const QJsonObject root = doc.object();
+    QVector<CheckpointTensor> tensors;
+    for (auto it = root.constBegin(); it != root.constEnd(); ++it) {
+        if (it.key() == "__metadata__") continue;
+        const QJsonObject entry = it.value().toObject();
+        const QJsonArray offsets = entry.value("data_offsets").toArray();
+        CheckpointTensor tensor;
+        tensor.name = it.key();
+        tensor.dtypeName = entry.value("dtype").toString();
+        tensor.dtype = safeTensorsDType(tensor.dtypeName);
+        for (const QJsonValue& d : entry.value("shape").toArray()) {
+            // 先检查范围再转换：超出 qint64 的 double 转整数是未定义行为
+            const double dim = d.toDouble(-1.0);
+            if (!(dim >= 0.0 && dim <= double(kMaxDimension))) {
+                if (error) *error = tensor.name + "：shape 无效或过大";
+                return false;
+            }
+            tensor.shape.append(qint64(dim));
+        }
+        if (offsets.size() != 2) {
+            if (error) *error = tensor.name + "：缺少 data_offsets";
+            return false;
+        }
+        const double begin = offsets[0].toDouble(-1.0), end = offsets[1].toDouble(-1.0);
+        const double dataSize = double(m_size - dataStart);
+        if (!(begin >= 0.0 && begin <= end && end <= dataSize) || tensor.elementCount() < 0) {
+            if (error) *error = tensor.name + "：data_offsets 与 shape 不符";
+            return false;
+        }
+        tensor.offset = dataStart + qint64(begin);
+        tensor.byteSize = qint64(end) - qint64(begin);
+        if (!fits(quint64(tensor.offset), quint64(tensor.byteSize), quint64(m_size)) ||
+            (tensor.dtype != TensorDType::Unsupported && tensor.byteSize != tensor.elementCount() * dtypeBytes(tensor.dtype))) {
+            if (error) *error = tensor.name + "：data_offsets 与 shape 不符";
+            return false;
+        }
+        tensors.append(tensor);
+    }
+    // QJsonObject 按键名排序，改回数据在文件中的顺序，供按顺序匹配使用
+    std::stable_sort(tensors.begin(), tensors.end(),
+                     [](const CheckpointTensor& a, const CheckpointTensor& b) { return a.offset < b.offset; });
+    for (const CheckpointTensor& tensor : tensors) addTensor(tensor);
+    return true;
+}
+
+bool WeightCheckpoint::read(int index, float* dst, QString* error, ThreadPool* pool) const {
+    if (!m_data || index < 0 || index >= m_tensors.size()) {
+        if (error) *error = "张量不存在";
+        return false;
+    }
+    const CheckpointTensor& tensor = m_tensors[index];
+    if (tensor.dtype == TensorDType::Unsupported) {
+        if (error) *error = QString("%1：不支持的数据类型 %2").arg(tensor.name, tensor.dtypeName);
+        return false;
+    }
+    const qint64 count = tensor.elementCount();
+    const int bytes = dtypeBytes(tensor.dtype);
+    const uchar* src = m_data + tensor.offset;
+
+    std::vector<float> staging;
+    float* out = dst;
+    if (tensor.fortranOrder && tensor.shape.size() > 1) {
+        staging.resize(static_cast<std::size_t>(count));
+        out = staging.data();
+    }
+    if (!pool) pool = &ThreadPool::global();
+    const int chunks = static_cast<int>((count + kConvertChunk - 1) / kConvertChunk);
+    pool->parallelFor(0, chunks, 1, [&](int first, int last) {
+        for (int c = first; c < last; ++c) {
+            const qint64 begin = c * kConvertChunk;
+            const qint64 n = std::min(kConvertChunk, count - begin);
+            convertRange(src + begin * bytes, out + begin, n, tensor.dtype, tensor.bigEndian);
+        }
+    });
+    if (out != dst) fortranToC(out, dst, tensor.shape);
+    return true;
+}
+
+const float* WeightCheckpoint::mappedData(int index) const {
+    if (!m_data || index < 0 || index >= m_tensors.size()) return nullptr;
+    const CheckpointTensor& tensor = m_tensors[index];
+    if (tensor.dtype != TensorDType::F32 || tensor.bigEndian || (tensor.fortranOrder && tensor.shape.size() > 1)) return nullptr;
+    const uchar* p = m_data + tensor.offset;
+    if (reinterpret_cast<quintptr>(p) % alignof(float) != 0) return nullptr;
+    return reinterpret_cast<const float*>(p);
+}
+
+bool WeightCheckpoint::readElements(int index, qint64 first, qint64 count, float* dst) const {
+    if (!m_data || index < 0 || index >= m_tensors.size()) return false;
+    const CheckpointTensor& tensor = m_tensors[index];
+    if (tensor.dtype == TensorDType::Unsupported || first < 0 || count < 0 ||
+        first > tensor.elementCount() || count > tensor.elementCount() - first) return false;
+    const int bytes = dtypeBytes(tensor.dtype);
+    convertRange(m_data + tensor.offset + first * bytes, dst, count, tensor.dtype, tensor.bigEndian);
+    return true;
+}
+
+std::shared_ptr<WeightCheckpoint> WeightCheckpoint::active() {
+    return activeCheckpoint();
+}
+
+void WeightCheckpoint::setActive(const std::shared_ptr<WeightCheckpoint>& checkpoint) {
+    activeCheckpoint() = checkpoint;
+}
+
+QVector<LayerWeightBinding> bindCheckpoint(const WeightCheckpoint& checkpoint, const QList<NeuralLayer>& layers,
+                                           QStringList* report) {
+    QVector<LayerWeightBinding> bindings(layers.size());
+    for (int i = 0; i < layers.size(); ++i) bindings[i].layer = i;
+
+    QList<const NeuralLayer*> ordered;
+    for (const NeuralLayer& layer : layers) ordered.append(&layer);
+    QVector<LayerShape> shapes;
+    QString shapeError;
+    if (ordered.isEmpty() || !inferLayerShapes(ordered, defaultInputShape(ordered), shapes, &shapeError)) {
+        if (report) *report << "无法推断网络形状：" + shapeError;
+        return bindings;
+    }
+
+    // 每层期望的元素数：weight、bias、weight_hh、bias_hh
+    struct Expected { qint64 weight = 0, bias = 0, recurrentWeight = 0, recurrentBias = 0; };
+    QVector<Expected> expected(layers.size());
+    LayerShape in = defaultInputShape(ordered);
+    for (int i = 0; i < layers.size(); ++i) {
+        const NeuralLayer& layer = layers[i];
+        const LayerShape& out = shapes[i];
+        LayerWeightBinding& binding = bindings[i];
+        if (layer.isDense()) {
+            binding.inputs = in.spatial ? in.size() : in.width;
+            binding.outputs = out.width;
+            expected[i].weight = qint64(binding.inputs) * binding.outputs;
+            expected[i].bias = binding.outputs;
+        } else if (layer.isConvolutional()) {
+            expected[i].weight = qint64(out.channels) * in.channels * layer.kernelSize * layer.kernelSize;
+            expected[i].bias = out.channels;
+        } else if (layer.isRecurrent()) {
+            const int gates = layer.layerType == "LSTM" ? 4 : (layer.layerType == "GRU" ? 3 : 1);
+            const qint64 gateWidth = qint64(gates) * out.width;
+            expected[i].weight = gateWidth * in.width;
+            expected[i].bias = gateWidth;
+            expected[i].recurrentWeight = gateWidth * out.width;
+            expected[i].recurrentBias = gateWidth;
+        }
+        in = out;
+    }
+
+    // 名称匹配：把每个张量名的所有 "." 后缀登记下来，"model.fc1.weight" 也能用 "fc1.weight" 查到
+    QHash<QString, int> suffixes;
+    const QVector<CheckpointTensor>& tensors = checkpoint.tensors();
+    for (int t = 0; t < tensors.size(); ++t) {
+        const QString& name = tensors[t].name;
+        if (!suffixes.contains(name)) suffixes.insert(name, t);
+        for (int dot = name.indexOf('.'); dot >= 0; dot = name.indexOf('.', dot + 1)) {
+            const QString suffix = name.mid(dot + 1);
+            if (!suffixes.contains(suffix)) suffixes.insert(suffix, t);
+        }
+    }
+    auto lookup = [&](const QString& name, qint64 count) {
+        const int t = suffixes.value(name, -1);
+        return t >= 0 && tensors[t].elementCount() == count ? t : -1;
+    };
+    // 代码生成器的模块编号对除 Flatten 外的每一层递增
+    QVector<QString> modules(layers.size());
+    for (int i = 0, index = 0; i < layers.size(); ++i) {
+        if (layers[i].layerType == "Flatten") continue;
+        modules[i] = moduleName(layers[i], index++);
+    }
+    QVector<bool> used(tensors.size(), false);
+    for (int i = 0; i < layers.size(); ++i) {
+        if (expected[i].weight == 0) continue;
+        const QString& module = modules[i];
+        LayerWeightBinding& binding = bindings[i];
+        if (layers[i].isRecurrent()) {
+            binding.weight = lookup(module + ".weight_ih_l0", expected[i].weight);
+            binding.recurrentWeight = lookup(module + ".weight_hh_l0", expected[i].recurrentWeight);
+            binding.bias = lookup(module + ".bias_ih_l0", expected[i].bias);
+            binding.recurrentBias = lookup(module + ".bias_hh_l0", expected[i].recurrentBias);
+        } else {
+            binding.weight = lookup(module + ".weight", expected[i].weight);
+            binding.bias = lookup(module + ".bias", expected[i].bias);
+        }
+        binding.byName = binding.weight >= 0;
+        for (int t : {binding.weight, binding.bias, binding.recurrentWeight, binding.recurrentBias}) {
+            if (t >= 0) used[t] = true;
+        }
+    }
+
+    // 名称没对上的层按顺序匹配：取第一个未使用且元素数相符的张量（跳过 BatchNorm 统计量等无法对应的张量），
+    // 紧随其后的一维张量视为偏置
+    {
+        int cursor = 0;
+        auto take = [&](qint64 count, bool vector) {
+            for (int t = 0; t < tensors.size(); ++t) {
+                if (!used[t] && tensors[t].elementCount() == count && (tensors[t].shape.size() == 1) == vector) {
+                    cursor = t + 1;
+                    used[t] = true;
+                    return t;
+                }
+            }
+            return -1;
+        };
+        auto takeNext = [&](qint64 count) {
+            while (cursor < tensors.size() && used[cursor]) ++cursor;
+            if (cursor < tensors.size() && tensors[cursor].shape.size() == 1 && tensors[cursor].elementCount() == count) {
+                used[cursor] = true;
+                return cursor++;
+            }
+            return -1;
+        };
+        for (int i = 0; i < layers.size(); ++i) {
+            LayerWeightBinding& binding = bindings[i];
+            if (expected[i].weight == 0) continue;
+            if (binding.byName) continue;
+            binding.weight = take(expected[i].weight, false);
+            if (binding.weight < 0) continue;
+            if (layers[i].isRecurrent()) {
+                binding.recurrentWeight = take(expected[i].recurrentWeight, false);
+                binding.bias = takeNext(expected[i].bias);
+                binding.recurrentBias = takeNext(expected[i].recurrentBias);
+            } else {
+                binding.bias = takeNext(expected[i].bias);
+            }
+        }
+    }
+
+    for (int i = 0; i < layers.size(); ++i) {
+        LayerWeightBinding& binding = bindings[i];
+        if (expected[i].weight == 0) continue;
+        if (binding.weight < 0) {
+            if (report) *report << QString("%1 (%2)：未找到元素数为 %3 的权重").arg(layers[i].layerType, modules[i]).arg(expected[i].weight);
+            continue;
+        }
+        const CheckpointTensor& w = tensors[binding.weight];
+        // Keras 的 Dense kernel 为 [in][out]
+        if (layers[i].isDense() && w.shape.size() == 2 && w.shape[0] == binding.inputs && w.shape[1] == binding.outputs &&
+            (binding.inputs != binding.outputs || w.name.contains("kernel"))) {
+            binding.transposed = true;
+        }
+        if (report) {
+            QString line = QString("%1 (%2) ← %3 %4 %5").arg(layers[i].layerType, modules[i], w.name, w.shapeString(), w.dtypeName);
+            if (binding.bias >= 0) line += "，bias " + tensors[binding.bias].name;
+            if (binding.transposed) line += "，按 [in][out] 转置";
+            line += binding.byName ? "（按名称）" : "（按顺序）";
+            *report << line;
+        }
+    }
+    return bindings;
+}
+
+bool readDenseWeights(const WeightCheckpoint& checkpoint, const LayerWeightBinding& binding,
+                      std::vector<float>& weights, QString* error) {
+    if (binding.weight < 0) {
+        if (error) *error = "该层没有匹配的权重";
+        return false;
+    }
+    const qint64 count = qint64(binding.outputs) * binding.inputs;
+    if (count <= 0 || count != checkpoint.tensors()[binding.weight].elementCount()) {
+        if (error) *error = "权重元素数与 Dense 层尺寸不一致";
+        return false;
+    }
+    weights.resize(static_cast<std::size_t>(count));
+    if (!binding.transposed) return checkpoint.read(binding.weight, weights.data(), error);
+    std::vector<float> kernel(static_cast<std::size_t>(count));
+    if (!checkpoint.read(binding.weight, kernel.data(), error)) return false;
+    for (int i = 0; i < binding.inputs; ++i) {
+        for (int o = 0; o < binding.outputs; ++o) {
+            weights[std::size_t(o) * binding.inputs + i] = kernel[std::size_t(i) * binding.outputs + o];
+        }
+    }
+    return true;
+}
+
+int loadCheckpointWeights(const WeightCheckpoint& checkpoint, const QVector<LayerWeightBinding>& bindings,
+                          InferenceEngine& engine, QStringList* sources) {
+    if (sources) {
+        sources->clear();
+        for (int i = 0; i < engine.layerCount(); ++i) sources->append(QString());
+    }
+    const QVector<CheckpointTensor>& tensors = checkpoint.tensors();
+    int loaded = 0;
+    for (int i = 0; i < engine.layerCount() && i < bindings.size(); ++i) {
+        const LayerWeightBinding& binding = bindings[i];
+        if (binding.weight < 0) continue;
+        const InferenceEngine::LayerKind kind = engine.layerInfo(i).kind;
+        const qint64 weightSize = engine.weightSize(i);
+        float* weights = engine.weightData(i);
+        bool ok = false;
+        if (kind == InferenceEngine::LayerKind::Dense) {
+            std::vector<float> dense;
+            ok = readDenseWeights(checkpoint, binding, dense) && qint64(dense.size()) == weightSize;
+            if (ok) std::copy(dense.begin(), dense.end(), weights);
+        } else if (kind == InferenceEngine::LayerKind::Conv2d) {
+            ok = tensors[binding.weight].elementCount() == weightSize && checkpoint.read(binding.weight, weights);
+        } else if (kind == InferenceEngine::LayerKind::Recurrent && binding.recurrentWeight >= 0) {
+            // 引擎中循环层权重为 weight_ih 后接 weight_hh
+            const qint64 inputPart = tensors[binding.weight].elementCount();
+            ok = inputPart + tensors[binding.recurrentWeight].elementCount() == weightSize
+                 && checkpoint.read(binding.weight, weights) && checkpoint.read(binding.recurrentWeight, weights + inputPart);
+        }
+        if (!ok) continue;
+
+        float* bias = engine.biasData(i);
+        const qint64 biasSize = engine.biasSize(i);
+        if (kind == InferenceEngine::LayerKind::Recurrent) {
+            if (binding.bias >= 0 && binding.recurrentBias >= 0
+                && tensors[binding.bias].elementCount() + tensors[binding.recurrentBias].elementCount() == biasSize) {
+                checkpoint.read(binding.bias, bias);
+                checkpoint.read(binding.recurrentBias, bias + tensors[binding.bias].elementCount());
+            }
+        } else if (binding.bias >= 0 && tensors[binding.bias].elementCount() == biasSize) {
+            checkpoint.read(binding.bias, bias);
+        }
+        if (sources) (*sources)[i] = tensors[binding.weight].name;
+        ++loaded;
+    }
+    return loaded;
+}
@@ -0,0 +1,116 @@
+#ifndef WEIGHTCHECKPOINT_H
+#define WEIGHTCHECKPOINT_H
+
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <memory>
+#include <vector>
+#include "backend.h"
+
+class InferenceEngine;
+class ThreadPool;
+
+enum class TensorDType { F32, F16, BF16, F64, Unsupported };
+
+// 检查点中的一个张量：只记录头部信息，数据留在映射的文件里，读取时再转换
+struct CheckpointTensor
+{
+    QString name;
+    TensorDType dtype = TensorDType::Unsupported;
+    QString dtypeName;        // 文件里的原始记法（'<f4'、"BF16" 等）
+    QVector<qint64> shape;
+    qint64 offset = 0;        // 数据相对文件起点的偏移
+    qint64 byteSize = 0;
+    bool fortranOrder = false;
+    bool bigEndian = false;
+
+    qint64 elementCount() const;  // 各维乘积；shape 含负数或乘积超过 2^56 时为 -1
+    QString shapeString() const;  // "[256, 784]"
+};
+
+// 以内存映射方式打开 .npy / .npz（未压缩）/ .safetensors 检查点
+// open() 只解析头部（npz 为中央目录与各成员的 npy 头），不触碰张量数据，
+// 因此数 GB 的文件也能在毫秒级打开；数据页在 read() 时才由操作系统按需调入
+class WeightCheckpoint
+{
+public:
+    enum class Format { Npy, Npz, SafeTensors };
+
+    WeightCheckpoint() = default;
+    ~WeightCheckpoint();
+    WeightCheckpoint(const WeightCheckpoint&) = delete;
+    WeightCheckpoint& operator=(const WeightCheckpoint&) = delete;
+
+    bool open(const QString& path, QString* error = nullptr);
+    void close();
+
+    bool isOpen() const { return m_data != nullptr; }
+    QString path() const { return m_path; }
+    Format format() const { return m_format; }
+    qint64 fileSize() const { return m_size; }
+    const QVector<CheckpointTensor>& tensors() const { return m_tensors; }
+    int indexOf(const QString& name) const { return m_index.value(name, -1); }
+
+    // 把第 index 个张量转换为行主序 float 写入 dst（elementCount 个元素），大张量按块并行转换
+    bool read(int index, float* dst, QString* error = nullptr, ThreadPool* pool = nullptr) const;
+    // 小端 F32、C 顺序且按 4 字节对齐时直接返回映射内存（零拷贝），否则返回 nullptr
+    const float* mappedData(int index) const;
+    // 按存储顺序转换 [first, first + count) 个元素（Fortran 顺序不重排），单线程；
+    // 供统计、直方图等与元素顺序无关的逐块扫描使用，避免整块转换出临时副本
+    bool readElements(int index, qint64 first, qint64 count, float* dst) const;
+    // 每次 open() 递增，作为张量内容的版本号（缓存键的一部分）
+    quint64 generation() const { return m_generation; }
+
+    // 当前加载的检查点，新建的 NetworkVisualizer 会自动套用
+    static std::shared_ptr<WeightCheckpoint> active();
+    static void setActive(const std::shared_ptr<WeightCheckpoint>& checkpoint);
+
+private:
+    bool parseNpy(qint64 base, qint64 size, const QString& name, QString* error);
+    bool parseNpz(QString* error);
+    bool parseSafeTensors(QString* error);
+    void addTensor(const CheckpointTensor& tensor);
+
+    QFile m_file;
+    QString m_path;
+    Format m_format = Format::Npy;
+    const uchar* m_data = nullptr;
+    qint64 m_size = 0;
+    quint64 m_generation = 0;
+    QVector<CheckpointTensor> m_tensors;
+    QHash<QString, int> m_index;
+};
+
+// 某个参数层在检查点中对应的张量（下标为 -1 表示缺失）
+struct LayerWeightBinding
+{
+    int layer = -1;
+    int weight = -1;            // Linear/Conv 权重，循环层为 weight_ih
+    int bias = -1;              // 循环层为 bias_ih
+    int recurrentWeight = -1;   // 循环层 weight_hh
+    int recurrentBias = -1;     // 循环层 bias_hh
+    bool transposed = false;    // Keras 风格的 Dense kernel [in][out]
+    bool byName = false;        // 按名称匹配，否则按顺序
+    int outputs = 0;            // Dense 的 out / in，供转置与连线着色使用
+    int inputs = 0;
+};
+
+// 把检查点张量匹配到参数层：先按代码生成器的模块名（fc1 / conv2 / lstm3 ...，允许带 "model." 等前缀）匹配，
+// 名称都对不上时按文件顺序依次取元素数相符的张量；report 写入逐层匹配结果
+QVector<LayerWeightBinding> bindCheckpoint(const WeightCheckpoint& checkpoint, const QList<NeuralLayer>& layers,
+                                           QStringList* report = nullptr);
+
+// 读出 Dense 层权重并统一为 PyTorch 的 [out][in] 布局
+bool readDenseWeights(const WeightCheckpoint& checkpoint, const LayerWeightBinding& binding,
+                      std::vector<float>& weights, QString* error = nullptr);
+
+// 把匹配到的张量写入推理引擎对应层的参数（元素数不符的层保持原值），返回写入的层数；
+// sources 返回每层的权重张量名，未写入的层为空
+int loadCheckpointWeights(const WeightCheckpoint& checkpoint, const QVector<LayerWeightBinding>& bindings,
+                          InferenceEngine& engine, QStringList* sources = nullptr);
+
+#endif // WEIGHTCHECKPOINT_H
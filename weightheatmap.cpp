@@ -0,0 +1,216 @@
+#include "weightheatmap.h"
+#include "simdutils.h"
+#include "threadpool.h"
+#include <QGraphicsSceneHoverEvent>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 每个并行块大致处理的像素数
+constexpr qint64 kChunkPixels = 1 << 16;
+
+int rowGrain(int cols) {
+    return std::max(1, static_cast<int>(kChunkPixels / std::max(1, cols)));
+}
+
+QRgb blend(const QColor& a, const QColor& b, double t) {
+    return qRgb(qRound(a.red() + (b.red() - a.red()) * t), qRound(a.green() + (b.green() - a.green()) * t),
+                qRound(a.blue() + (b.blue() - a.blue()) * t));
+}
+
+// 有符号的较大幅值，NaN 优先保留以便缩小后仍能看到
+inline float maxAbsOf(float a, float b) {
+    if (std::isnan(a)) return a;
+    if (std::isnan(b)) return b;
+    return std::fabs(b) > std::fabs(a) ? b : a;
+}
+
+#if NNV_HAVE_AVX2
+// 与 maxAbsOf 相同的取舍：|b| > |a|（有 NaN 时为假），或 b 为 NaN 而 a 不是
+NNV_AVX2 inline __m256 maxAbsOf(__m256 a, __m256 b) {
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 larger = _mm256_cmp_ps(_mm256_and_ps(b, absMask), _mm256_and_ps(a, absMask), _CMP_GT_OQ);
+    const __m256 nanB = _mm256_andnot_ps(_mm256_cmp_ps(a, a, _CMP_UNORD_Q), _mm256_cmp_ps(b, b, _CMP_UNORD_Q));
+    return _mm256_blendv_ps(a, b, _mm256_or_ps(larger, nanB));
+}
+
+// renderWeightImage 一行的 AVX2 部分，返回处理到的列
+NNV_AVX2 int colorizeRowAvx2(const float* src, int cols, float scale, float offset, const QRgb* lut, QRgb* dst) {
+    int c = 0;
+    const __m256 vscale = _mm256_set1_ps(scale);
+    const __m256 voffset = _mm256_set1_ps(offset);
+    const __m256 lo = _mm256_setzero_ps();
+    const __m256 hi = _mm256_set1_ps(HeatmapColormap::kSize - 1);
+    for (; c + 8 <= cols; c += 8) {
+        // 先在浮点域钳位：max_ps 遇到 NaN 返回第二个操作数，NaN 落到 0，±Inf 落到两端
+        const __m256 position = _mm256_fmadd_ps(_mm256_loadu_ps(src + c), vscale, voffset);
+        const __m256i index = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(position, lo), hi));
+        const __m256i color = _mm256_i32gather_epi32(reinterpret_cast<const int*>(lut), index, 4);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + c), color);
+    }
+    return c;
+}
+
+NNV_AVX2 int downsampleRowAvx2(const float* top, const float* bottom, int cols, float* dst) {
+    int c = 0;
+    // 16 列一组：先上下两行两两归约，再把相邻两列拆成偶/奇两路归约，shuffle 打乱的顺序最后按 64 位换回
+    for (; 2 * c + 16 <= cols; c += 8) {
+        const __m256 low = maxAbsOf(_mm256_loadu_ps(top + 2 * c), _mm256_loadu_ps(bottom + 2 * c));
+        const __m256 high = maxAbsOf(_mm256_loadu_ps(top + 2 * c + 8), _mm256_loadu_ps(bottom + 2 * c + 8));
+        const __m256 even = _mm256_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m256 odd = _mm256_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1));
+        const __m256 result = maxAbsOf(even, odd);
+        _mm256_storeu_ps(dst + c, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(result), _MM_SHUFFLE(3, 1, 2, 0))));
+    }
+    return c;
+}
+#endif
+
+} // namespace
+
+HeatmapColormap HeatmapColormap::fromTheme(const ColorTheme& theme) {
+    HeatmapColormap colormap;
+    const double middle = (kSize - 1) / 2.0;
+    for (int i = 0; i < kSize; ++i) {
+        colormap.colors[i] = i < middle ? blend(theme.layerBackground, theme.connectionLowWeight, (middle - i) / middle)
+                                        : blend(theme.layerBackground, theme.connectionHighWeight, (i - middle) / middle);
+    }
+    return colormap;
+}
+
+void renderWeightImage(const float* w, int rows, int cols, float maxAbs, const HeatmapColormap& colormap, QImage& image,
+                       ThreadPool* pool) {
+    if (rows <= 0 || cols <= 0) {
+        image = QImage();
+        return;
+    }
+    if (image.width() != cols || image.height() != rows || image.format() != QImage::Format_ARGB32) {
+        image = QImage(cols, rows, QImage::Format_ARGB32);
+    }
+    if (!pool) pool = &ThreadPool::global();
+    // 下标 = (w / maxAbs + 1) / 2 · (kSize - 1)，截断前加 0.5 即四舍五入
+    const float half = (HeatmapColormap::kSize - 1) * 0.5f;
+    const float scale = maxAbs > 0.0f ? half / maxAbs : 0.0f;
+    const float offset = half + 0.5f;
+    const QRgb* lut = colormap.colors.data();
+    // scanLine 会在隐式共享时分离，先在当前线程取一次保证各线程拿到同一块数据
+    uchar* bits = image.bits();
+    const int stride = image.bytesPerLine();
+    pool->parallelFor(0, rows, rowGrain(cols), [&](int first, int last) {
+        for (int r = first; r < last; ++r) {
+            const float* src = w + qint64(r) * cols;
+            QRgb* dst = reinterpret_cast<QRgb*>(bits + r * stride);
+            int c = 0;
+#if NNV_HAVE_AVX2
+            if (simd::hasAvx2()) c = colorizeRowAvx2(src, cols, scale, offset, lut, dst);
+#endif
+            for (; c < cols; ++c) {
+                const float position = src[c] * scale + offset;
+                const int index = std::isnan(position) ? 0 : static_cast<int>(std::clamp(position, 0.0f, float(HeatmapColormap::kSize - 1)));
+                dst[c] = lut[index];
+            }
+        }
+    });
+}
+
+void downsampleMaxAbs(const float* w, int rows, int cols, std::vector<float>& out, ThreadPool* pool) {
+    const int outRows = (rows + 1) / 2;
+    const int outCols = (cols + 1) / 2;
+    out.resize(static_cast<std::size_t>(outRows) * outCols);
+    if (outRows <= 0 || outCols <= 0) return;
+    if (!pool) pool = &ThreadPool::global();
+    pool->parallelFor(0, outRows, rowGrain(cols * 2), [&](int first, int last) {
+        for (int r = first; r < last; ++r) {
+            const float* top = w + qint64(2 * r) * cols;
+            const float* bottom = 2 * r + 1 < rows ? top + cols : top;
+            float* dst = out.data() + qint64(r) * outCols;
+            int c = 0;
+#if NNV_HAVE_AVX2
+            if (simd::hasAvx2()) c = downsampleRowAvx2(top, bottom, cols, dst);
+#endif
+            for (; c < outCols; ++c) {
+                const int left = 2 * c;
+                const int right = std::min(left + 1, cols - 1);
+                dst[c] = maxAbsOf(maxAbsOf(top[left], top[right]), maxAbsOf(bottom[left], bottom[right]));
+            }
+        }
+    });
+}
+
+QVector<QImage> buildWeightMipmaps(const float* w, int rows, int cols, float maxAbs, const HeatmapColormap& colormap,
+                                   ThreadPool* pool) {
+    QVector<QImage> levels;
+    if (rows <= 0 || cols <= 0) return levels;
+    QImage image;
+    renderWeightImage(w, rows, cols, maxAbs, colormap, image, pool);
+    levels.append(image);
+    std::vector<float> current, next;
+    const float* source = w;
+    while (rows > 1 || cols > 1) {
+        downsampleMaxAbs(source, rows, cols, next, pool);
+        rows = (rows + 1) / 2;
+        cols = (cols + 1) / 2;
+        current.swap(next);
+        source = current.data();
+        QImage level;
+        renderWeightImage(source, rows, cols, maxAbs, colormap, level, pool);
+        levels.append(level);
+    }
+    return levels;
+}
+
+WeightHeatmapItem::WeightHeatmapItem(const QRectF& rect, QGraphicsItem* parent)
+    : QGraphicsItem(parent), m_rect(rect) {
+    setAcceptHoverEvents(true);
+    setZValue(0);
+}
+
+void WeightHeatmapItem::setWeights(const float* w, int rows, int cols) {
+    if (!w || rows <= 0 || cols <= 0) return;
+    m_weights.assign(w, w + qint64(rows) * cols);
+    m_rows = rows;
+    m_cols = cols;
+    rebuild();
+}
+
+void WeightHeatmapItem::updateColors() {
+    rebuild();
+}
+
+void WeightHeatmapItem::rebuild() {
+    float maxAbs = 0.0f;
+    for (float v : m_weights) {
+        if (std::isfinite(v)) maxAbs = std::max(maxAbs, std::fabs(v));
+    }
+    const QVector<QImage> images = buildWeightMipmaps(m_weights.data(), m_rows, m_cols, maxAbs,
+                                                      HeatmapColormap::fromTheme(ColorThemeManager::currentTheme()));
+    m_levels.clear();
+    for (const QImage& image : images) m_levels.append(QPixmap::fromImage(image));
+    update();
+}
+
+void WeightHeatmapItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) {
+    Q_UNUSED(widget);
+    if (m_levels.isEmpty()) return;
+    // 屏幕上每个矩阵元素占的像素数，不足 1 时每小一半降一级
+    const double detail = option->levelOfDetailFromTransform(painter->worldTransform());
+    const double pixelsPerCell = detail * std::min(m_rect.width() / m_cols, m_rect.height() / m_rows);
+    int level = 0;
+    if (pixelsPerCell < 1.0 && pixelsPerCell > 0.0) level = static_cast<int>(std::floor(std::log2(1.0 / pixelsPerCell)));
+    level = std::clamp(level, 0, static_cast<int>(m_levels.size()) - 1);
+    const QPixmap& pixmap = m_levels[level];
+    // 放大时保持格子边缘清晰
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, pixelsPerCell < 1.0);
+    painter->drawPixmap(m_rect, pixmap, QRectF(pixmap.rect()));
+}
+
+void WeightHeatmapItem::hoverMoveEvent(QGraphicsSceneHoverEvent* event) {
+    if (m_weights.empty()) return;
+    const QPointF p = event->pos() - m_rect.topLeft();
+    const int i = std::clamp(static_cast<int>(p.y() / m_rect.height() * m_rows), 0, m_rows - 1);
+    const int j = std::clamp(static_cast<int>(p.x() / m_rect.width() * m_cols), 0, m_cols - 1);
+    setToolTip(QString("(%1, %2)  w = %3").arg(i).arg(j).arg(m_weights[qint64(i) * m_cols + j], 0, 'g', 6));
+}
@@ -0,0 +1,61 @@
+#ifndef WEIGHTHEATMAP_H
+#define WEIGHTHEATMAP_H
+
+#include <QGraphicsItem>
+#include <QImage>
+#include <QPixmap>
+#include <QVector>
+#include <array>
+#include <vector>
+#include "colorthememanager.h"
+
+class ThreadPool;
+
+// 发散色表：-maxAbs 为 connectionLowWeight，0 为 layerBackground，+maxAbs 为 connectionHighWeight
+struct HeatmapColormap
+{
+    static constexpr int kSize = 256;
+    std::array<QRgb, kSize> colors{};
+
+    static HeatmapColormap fromTheme(const ColorTheme& theme);
+};
+
+// rows×cols 的权重逐元素着色写入 ARGB32 图像（一个元素一个像素，尺寸不符时重新分配）；
+// AVX2 下 8 个一组算出色表下标再 gather，按行分块并行；NaN 着最负端的颜色
+void renderWeightImage(const float* w, int rows, int cols, float maxAbs, const HeatmapColormap& colormap, QImage& image,
+                       ThreadPool* pool = nullptr);
+
+// 2×2 归约为 ((rows + 1) / 2)×((cols + 1) / 2)：每块取 |w| 最大的有符号值，缩小后强连接不会被正负平均掉
+void downsampleMaxAbs(const float* w, int rows, int cols, std::vector<float>& out, ThreadPool* pool = nullptr);
+
+// 第 0 级为原尺寸，之后逐级减半直到 1×1
+QVector<QImage> buildWeightMipmaps(const float* w, int rows, int cols, float maxAbs, const HeatmapColormap& colormap,
+                                   ThreadPool* pool = nullptr);
+
+// 一组连线的权重矩阵热力图（行 = 后一层神经元，列 = 前一层神经元），代替 rows×cols 条连线：
+// 绘制时按当前缩放下每个元素占的像素数选 mipmap 级别，悬停显示 (i, j, w)
+class WeightHeatmapItem : public QGraphicsItem
+{
+public:
+    explicit WeightHeatmapItem(const QRectF& rect, QGraphicsItem* parent = nullptr);
+
+    void setWeights(const float* w, int rows, int cols);
+    void updateColors();  // 主题切换后按新色表重新着色
+
+    QRectF boundingRect() const override { return m_rect; }
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget = nullptr) override;
+
+protected:
+    void hoverMoveEvent(QGraphicsSceneHoverEvent* event) override;
+
+private:
+    void rebuild();
+
+    QRectF m_rect;
+    std::vector<float> m_weights;
+    int m_rows = 0;
+    int m_cols = 0;
+    QVector<QPixmap> m_levels;
+};
+
+#endif // WEIGHTHEATMAP_H
@@ -0,0 +1,393 @@
+#include "weightstats.h"
+#include "simdutils.h"
+#include "threadpool.h"
+#include "weightcheckpoint.h"
+#include <QCoreApplication>
+#include <QMetaObject>
+#include <QPointer>
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 每块元素数：块内计数用 32 位整数，块内平方和在双精度下不会损失精度
+constexpr qint64 kStatsChunk = 1 << 16;
+
+struct ChunkMoments
+{
+    qint64 count = 0;
+    qint64 nonFinite = 0;
+    qint64 zeros = 0;
+    float min = std::numeric_limits<float>::infinity();
+    float max = -std::numeric_limits<float>::infinity();
+    double sum = 0.0;
+    double sumSquares = 0.0;
+};
+
+#if NNV_HAVE_AVX2
+NNV_AVX2 ChunkMoments scanMomentsAvx2(const float* x, qint64 n, float zeroThreshold) {
+    ChunkMoments m;
+    qint64 i = 0;
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 posInf = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+    const __m256 negInf = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+    const __m256 threshold = _mm256_set1_ps(zeroThreshold);
+    __m256 vmin = posInf;
+    __m256 vmax = negInf;
+    __m256d sumLo = _mm256_setzero_pd(), sumHi = _mm256_setzero_pd();
+    __m256d sqLo = _mm256_setzero_pd(), sqHi = _mm256_setzero_pd();
+    __m256i finiteCount = _mm256_setzero_si256();
+    __m256i zeroCount = _mm256_setzero_si256();
+    for (; i + 8 <= n; i += 8) {
+        const __m256 v = _mm256_loadu_ps(x + i);
+        const __m256 a = _mm256_and_ps(v, absMask);
+        const __m256 finite = _mm256_cmp_ps(a, posInf, _CMP_LT_OQ);  // NaN 比较为假
+        const __m256 zero = _mm256_and_ps(finite, _mm256_cmp_ps(a, threshold, _CMP_LE_OQ));
+        const __m256 f = _mm256_and_ps(v, finite);
+        vmin = _mm256_min_ps(vmin, _mm256_blendv_ps(posInf, v, finite));
+        vmax = _mm256_max_ps(vmax, _mm256_blendv_ps(negInf, v, finite));
+        // 和与平方和按双精度累加
+        const __m256d lo = _mm256_cvtps_pd(_mm256_castps256_ps128(f));
+        const __m256d hi = _mm256_cvtps_pd(_mm256_extractf128_ps(f, 1));
+        sumLo = _mm256_add_pd(sumLo, lo);
+        sumHi = _mm256_add_pd(sumHi, hi);
+        sqLo = _mm256_fmadd_pd(lo, lo, sqLo);
+        sqHi = _mm256_fmadd_pd(hi, hi, sqHi);
+        // 比较结果为 -1 的掩码，减去即计数
+        finiteCount = _mm256_sub_epi32(finiteCount, _mm256_castps_si256(finite));
+        zeroCount = _mm256_sub_epi32(zeroCount, _mm256_castps_si256(zero));
+    }
+    alignas(32) float mins[8], maxs[8];
+    alignas(32) double sums[4], squares[4];
+    alignas(32) int finites[8], zeros[8];
+    _mm256_store_ps(mins, vmin);
+    _mm256_store_ps(maxs, vmax);
+    _mm256_store_pd(sums, _mm256_add_pd(sumLo, sumHi));
+    _mm256_store_pd(squares, _mm256_add_pd(sqLo, sqHi));
+    _mm256_store_si256(reinterpret_cast<__m256i*>(finites), finiteCount);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(zeros), zeroCount);
+    for (int k = 0; k < 8; ++k) {
+        m.min = std::min(m.min, mins[k]);
+        m.max = std::max(m.max, maxs[k]);
+        m.count += finites[k];
+        m.zeros += zeros[k];
+    }
+    for (int k = 0; k < 4; ++k) {
+        m.sum += sums[k];
+        m.sumSquares += squares[k];
+    }
+    m.nonFinite = i - m.count;
+    for (; i < n; ++i) {
+        const float v = x[i];
+        if (!std::isfinite(v)) {
+            ++m.nonFinite;
+            continue;
+        }
+        ++m.count;
+        if (std::fabs(v) <= zeroThreshold) ++m.zeros;
+        m.min = std::min(m.min, v);
+        m.max = std::max(m.max, v);
+        m.sum += v;
+        m.sumSquares += double(v) * v;
+    }
+    return m;
+}
+#endif
+
+// 第一遍：一次读入同时得到 min/max/和/平方和/零值数，NaN 与 Inf 单独计数
+ChunkMoments scanMoments(const float* x, qint64 n, float zeroThreshold) {
+#if NNV_HAVE_AVX2
+    if (simd::hasAvx2()) return scanMomentsAvx2(x, n, zeroThreshold);
+#endif
+    ChunkMoments m;
+    for (qint64 i = 0; i < n; ++i) {
+        const float v = x[i];
+        if (!std::isfinite(v)) {
+            ++m.nonFinite;
+            continue;
+        }
+        ++m.count;
+        if (std::fabs(v) <= zeroThreshold) ++m.zeros;
+        m.min = std::min(m.min, v);
+        m.max = std::max(m.max, v);
+        m.sum += v;
+        m.sumSquares += double(v) * v;
+    }
+    return m;
+}
+
+#if NNV_HAVE_AVX2
+NNV_AVX2 void scanHistogramAvx2(const float* x, qint64 n, float min, float scale, quint32* bins) {
+    constexpr int kTrash = WeightStats::kBins;  // 非有限值落入的丢弃箱
+    quint32 sub[4][WeightStats::kBins + 1] = {};
+    qint64 i = 0;
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 posInf = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+    const __m256 vmin = _mm256_set1_ps(min);
+    const __m256 vscale = _mm256_set1_ps(scale);
+    const __m256i last = _mm256_set1_epi32(WeightStats::kBins - 1);
+    const __m256i trash = _mm256_set1_epi32(kTrash);
+    for (; i + 8 <= n; i += 8) {
+        const __m256 v = _mm256_loadu_ps(x + i);
+        const __m256 finite = _mm256_cmp_ps(_mm256_and_ps(v, absMask), posInf, _CMP_LT_OQ);
+        __m256i bin = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_sub_ps(v, vmin), vscale));
+        bin = _mm256_max_epi32(_mm256_min_epi32(bin, last), _mm256_setzero_si256());
+        bin = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(trash), _mm256_castsi256_ps(bin), finite));
+        const __m128i low = _mm256_castsi256_si128(bin);
+        const __m128i high = _mm256_extracti128_si256(bin, 1);
+        const quint64 p0 = quint64(_mm_cvtsi128_si64(low)), p1 = quint64(_mm_extract_epi64(low, 1));
+        const quint64 p2 = quint64(_mm_cvtsi128_si64(high)), p3 = quint64(_mm_extract_epi64(high, 1));
+        ++sub[0][quint32(p0)]; ++sub[1][p0 >> 32];
+        ++sub[2][quint32(p1)]; ++sub[3][p1 >> 32];
+        ++sub[0][quint32(p2)]; ++sub[1][p2 >> 32];
+        ++sub[2][quint32(p3)]; ++sub[3][p3 >> 32];
+    }
+    for (; i < n; ++i) {
+        const float v = x[i];
+        if (!std::isfinite(v)) continue;
+        const int bin = static_cast<int>((v - min) * scale);
+        ++sub[i & 3][std::clamp(bin, 0, WeightStats::kBins - 1)];
+    }
+    for (int b = 0; b < WeightStats::kBins; ++b) bins[b] = sub[0][b] + sub[1][b] + sub[2][b] + sub[3][b];
+}
+#endif
+
+// 第二遍：按全局 [min, max] 分箱；4 份交错的子直方图减少相邻元素落入同一箱时的写后读停顿
+void scanHistogram(const float* x, qint64 n, float min, float scale, quint32* bins) {
+#if NNV_HAVE_AVX2
+    if (simd::hasAvx2()) {
+        scanHistogramAvx2(x, n, min, scale, bins);
+        return;
+    }
+#endif
+    constexpr int kTrash = WeightStats::kBins;  // 非有限值落入的丢弃箱
+    quint32 sub[4][WeightStats::kBins + 1] = {};
+    for (qint64 i = 0; i < n; ++i) {
+        const float v = x[i];
+        if (!std::isfinite(v)) continue;
+        const int bin = static_cast<int>((v - min) * scale);
+        ++sub[i & 3][std::clamp(bin, 0, WeightStats::kBins - 1)];
+    }
+    for (int b = 0; b < WeightStats::kBins; ++b) bins[b] = sub[0][b] + sub[1][b] + sub[2][b] + sub[3][b];
+}
+
+// 块内转换缓冲：每个线程一份，避免每块重新分配
+float* chunkScratch() {
+    thread_local std::vector<float> scratch(static_cast<std::size_t>(kStatsChunk));
+    return scratch.data();
+}
+
+QString cacheKey(const WeightCheckpoint& checkpoint, int tensor) {
+    return checkpoint.path() + "#" + checkpoint.tensors()[tensor].name;
+}
+
+// 唯一的后台统计线程：任务串行执行，每个任务内部再用全局线程池并行
+// 构造时先取一次线程池与缓存，保证它们晚于本对象析构
+class StatsWorker
+{
+public:
+    struct Job
+    {
+        std::shared_ptr<WeightCheckpoint> checkpoint;
+        int tensor = -1;
+        QPointer<QObject> receiver;
+        std::function<void(int, const WeightStats&)> done;
+    };
+
+    static StatsWorker& instance() {
+        static StatsWorker worker;
+        return worker;
+    }
+
+    void post(Job job) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobs.push_back(std::move(job));
+        }
+        m_wake.notify_one();
+    }
+
+    ~StatsWorker() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+            m_jobs.clear();
+        }
+        m_wake.notify_one();
+        if (m_thread.joinable()) m_thread.join();
+    }
+
+private:
+    StatsWorker() {
+        ThreadPool::global();
+        WeightStatsCache::instance();
+        m_thread = std::thread(&StatsWorker::loop, this);
+    }
+
+    void loop() {
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [&] { return m_stop || !m_jobs.empty(); });
+                if (m_stop) return;
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+            }
+
+            const WeightCheckpoint& checkpoint = *job.checkpoint;
+            const QString key = cacheKey(checkpoint, job.tensor);
+            WeightStats stats;
+            if (!WeightStatsCache::instance().find(key, checkpoint.generation(), &stats)) {
+                const qint64 count = checkpoint.tensors()[job.tensor].elementCount();
+                if (const float* mapped = checkpoint.mappedData(job.tensor)) {
+                    stats = computeWeightStats(mapped, count);
+                } else {
+                    const int tensor = job.tensor;
+                    stats = computeWeightStats(count, [&checkpoint, tensor](qint64 first, qint64 n, float* scratch) {
+                        return checkpoint.readElements(tensor, first, n, scratch) ? scratch : nullptr;
+                    });
+                }
+                WeightStatsCache::instance().insert(key, checkpoint.generation(), stats);
+            }
+
+            // 回到界面线程；receiver 在那里再检查一次，已销毁则丢弃
+            if (QCoreApplication* app = QCoreApplication::instance()) {
+                QPointer<QObject> receiver = job.receiver;
+                auto done = job.done;
+                const int tensor = job.tensor;
+                QMetaObject::invokeMethod(app, [receiver, done, tensor, stats]() {
+                    if (receiver) done(tensor, stats);
+                }, Qt::QueuedConnection);
+            }
+        }
+    }
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<Job> m_jobs;
+    bool m_stop = false;
+};
+
+} // namespace
+
+QString WeightStats::summary() const {
+    QString text = QString("参数 %1").arg(count);
+    if (nonFinite > 0) text += QString("（另有 %1 个 NaN/Inf）").arg(nonFinite);
+    text += QString("\nmin %1   max %2\nmean %3   std %4\n稀疏度 %5%")
+                .arg(min, 0, 'g', 4)
+                .arg(max, 0, 'g', 4)
+                .arg(mean, 0, 'g', 4)
+                .arg(stddev, 0, 'g', 4)
+                .arg(sparsity() * 100.0, 0, 'f', 2);
+    return text;
+}
+
+WeightStats computeWeightStats(const float* data, qint64 count, ThreadPool* pool, float zeroThreshold) {
+    return computeWeightStats(count, [data](qint64 first, qint64, float*) { return data + first; }, pool, zeroThreshold);
+}
+
+WeightStats computeWeightStats(qint64 count, const WeightSource& source, ThreadPool* pool, float zeroThreshold) {
+    WeightStats stats;
+    if (count <= 0) return stats;
+    if (!pool) pool = &ThreadPool::global();
+    const int chunks = static_cast<int>((count + kStatsChunk - 1) / kStatsChunk);
+
+    std::vector<ChunkMoments> moments(static_cast<std::size_t>(chunks));
+    pool->parallelFor(0, chunks, 1, [&](int first, int last) {
+        for (int c = first; c < last; ++c) {
+            const qint64 begin = c * kStatsChunk;
+            const qint64 n = std::min(kStatsChunk, count - begin);
+            const float* x = source(begin, n, chunkScratch());
+            if (x) {
+                moments[c] = scanMoments(x, n, zeroThreshold);
+            } else {
+                moments[c].nonFinite = n;  // 读取失败的块按无效值计
+            }
+        }
+    });
+
+    // 按块序合并（Chan 等人的并行方差公式），结果与线程调度无关
+    double mean = 0.0, m2 = 0.0;
+    for (const ChunkMoments& m : moments) {
+        stats.nonFinite += m.nonFinite;
+        stats.zeros += m.zeros;
+        if (m.count == 0) continue;
+        stats.min = stats.count == 0 ? m.min : std::min(stats.min, m.min);
+        stats.max = stats.count == 0 ? m.max : std::max(stats.max, m.max);
+        const double chunkMean = m.sum / double(m.count);
+        const double chunkM2 = std::max(0.0, m.sumSquares - m.sum * chunkMean);
+        const double total = double(stats.count + m.count);
+        const double delta = chunkMean - mean;
+        mean += delta * double(m.count) / total;
+        m2 += chunkM2 + delta * delta * double(stats.count) * double(m.count) / total;
+        stats.count += m.count;
+    }
+    if (stats.count == 0) return stats;
+    stats.mean = mean;
+    stats.stddev = std::sqrt(m2 / double(stats.count));
+
+    float scale = 0.0f;
+    if (stats.max > stats.min) {
+        scale = static_cast<float>(WeightStats::kBins / (double(stats.max) - double(stats.min)));
+        if (!std::isfinite(scale)) scale = 0.0f;
+    }
+    std::vector<quint32> bins(static_cast<std::size_t>(chunks) * WeightStats::kBins);
+    pool->parallelFor(0, chunks, 1, [&](int first, int last) {
+        for (int c = first; c < last; ++c) {
+            const qint64 begin = c * kStatsChunk;
+            const qint64 n = std::min(kStatsChunk, count - begin);
+            if (moments[c].count == 0) continue;
+            const float* x = source(begin, n, chunkScratch());
+            if (x) scanHistogram(x, n, stats.min, scale, bins.data() + std::size_t(c) * WeightStats::kBins);
+        }
+    });
+    for (int c = 0; c < chunks; ++c) {
+        const quint32* chunkBins = bins.data() + std::size_t(c) * WeightStats::kBins;
+        for (int b = 0; b < WeightStats::kBins; ++b) stats.histogram[b] += chunkBins[b];
+    }
+    return stats;
+}
+
+WeightStatsCache& WeightStatsCache::instance() {
+    static WeightStatsCache cache;
+    return cache;
+}
+
+bool WeightStatsCache::find(const QString& key, quint64 version, WeightStats* stats) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.constFind(key);
+    if (it == m_entries.constEnd() || it->version != version) return false;
+    if (stats) *stats = it->stats;
+    return true;
+}
+
+void WeightStatsCache::insert(const QString& key, quint64 version, const WeightStats& stats) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries[key] = Entry{version, stats};
+}
+
+void WeightStatsCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+}
+
+void requestCheckpointStats(const std::shared_ptr<WeightCheckpoint>& checkpoint, const QVector<int>& tensors,
+                            QObject* receiver, const std::function<void(int tensor, const WeightStats& stats)>& done) {
+    if (!checkpoint || !checkpoint->isOpen()) return;
+    for (int tensor : tensors) {
+        if (tensor < 0 || tensor >= checkpoint->tensors().size()) continue;
+        WeightStats stats;
+        if (WeightStatsCache::instance().find(cacheKey(*checkpoint, tensor), checkpoint->generation(), &stats)) {
+            done(tensor, stats);
+            continue;
+        }
+        StatsWorker::instance().post({checkpoint, tensor, QPointer<QObject>(receiver), done});
+    }
+}
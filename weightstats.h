@@ -0,0 +1,70 @@
+#ifndef WEIGHTSTATS_H
+#define WEIGHTSTATS_H
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include <array>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+class ThreadPool;
+class WeightCheckpoint;
+
+// 一个权重张量的统计量与直方图
+struct WeightStats
+{
+    static constexpr int kBins = 256;
+
+    qint64 count = 0;       // 有限元素数
+    qint64 nonFinite = 0;   // NaN / Inf，不计入其余统计
+    qint64 zeros = 0;       // |w| <= zeroThreshold 的元素数
+    float min = 0.0f;
+    float max = 0.0f;
+    double mean = 0.0;
+    double stddev = 0.0;
+    std::array<qint64, kBins> histogram{};  // [min, max] 等宽分箱
+
+    double sparsity() const { return count > 0 ? double(zeros) / double(count) : 0.0; }
+    QString summary() const;  // 多行文本，用于悬停提示与属性面板
+};
+
+// 取出第 first 个起的 count 个元素：可直接返回内部指针（零拷贝），否则写入 scratch 并返回 scratch
+using WeightSource = std::function<const float*(qint64 first, qint64 count, float* scratch)>;
+
+// 按 64K 元素分块并行扫描两遍：第一遍 AVX2 单遍求 min/max/和/平方和/零值数，
+// 第二遍按全局范围分箱（每块私有直方图，最后按块序合并，结果与线程数无关）
+WeightStats computeWeightStats(const float* data, qint64 count, ThreadPool* pool = nullptr, float zeroThreshold = 0.0f);
+WeightStats computeWeightStats(qint64 count, const WeightSource& source, ThreadPool* pool = nullptr,
+                               float zeroThreshold = 0.0f);
+
+// 统计结果缓存：key 标识张量，version 变化（重新打开检查点、训练更新权重）后旧结果失效
+class WeightStatsCache
+{
+public:
+    static WeightStatsCache& instance();
+
+    bool find(const QString& key, quint64 version, WeightStats* stats) const;
+    void insert(const QString& key, quint64 version, const WeightStats& stats);
+    void clear();
+
+private:
+    struct Entry
+    {
+        quint64 version = 0;
+        WeightStats stats;
+    };
+
+    mutable std::mutex m_mutex;
+    QHash<QString, Entry> m_entries;
+};
+
+// 在后台线程统计检查点中的张量，不阻塞界面：命中缓存的立即回调，其余逐个算完后回到界面线程回调；
+// receiver 销毁后结果只进缓存、不再回调
+void requestCheckpointStats(const std::shared_ptr<WeightCheckpoint>& checkpoint, const QVector<int>& tensors,
+                            QObject* receiver, const std::function<void(int tensor, const WeightStats& stats)>& done);
+
+#endif // WEIGHTSTATS_H